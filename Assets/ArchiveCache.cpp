@@ -6,6 +6,7 @@
 
 #include "ArchiveCache.h"
 #include "ChunkFile.h"
+#include "AssetsCore.h"
 #include "../ConsoleRig/Log.h"
 #include "../Utility/Streams/FileUtils.h"
 #include "../Utility/Streams/PathUtils.h"
@@ -20,6 +21,10 @@ namespace Assets
     static const uint64 ChunkType_ArchiveDirectory = ConstHash64<'Arch', 'ive', 'Dir'>::Value;
     static const uint64 ChunkType_ArchiveAttachments = ConstHash64<'Arch', 'ive', 'Attc'>::Value;
 
+        //  Block ids are normally Hash64 values, so caches written with a different
+        //  version of the hash algorithm must be rebuilt
+    static const unsigned ArchiveDirectoryVersion = Hash64Version;
+
     class ArchiveDirectoryBlock 
     {
     public:
@@ -124,7 +129,13 @@ namespace Assets
             return false;
 
         auto chunkTable = LoadChunkTable(directoryFile);
-        auto chunk = FindChunk(filename, chunkTable, ChunkType_ArchiveDirectory, 0);
+        ChunkHeader chunk;
+        TRY {
+            chunk = FindChunk(filename, chunkTable, ChunkType_ArchiveDirectory, ArchiveDirectoryVersion);
+        } CATCH (const ::Assets::Exceptions::FormatError&) {
+                // (old version of the archive. It will be replaced on the next flush)
+            return false;
+        } CATCH_END
 
         DirectoryChunk dirHdr;
         directoryFile.Seek(chunk._fileOffset, SEEK_SET);
@@ -235,7 +246,7 @@ namespace Assets
             if (directoryFile.TryOpen(_directoryFileName.c_str(), "r+b") == BasicFile::Reason::Success) {
                 TRY {
                     auto chunkTable = LoadChunkTable(directoryFile);
-                    auto chunk = FindChunk(_directoryFileName.c_str(), chunkTable, ChunkType_ArchiveDirectory, 0);
+                    auto chunk = FindChunk(_directoryFileName.c_str(), chunkTable, ChunkType_ArchiveDirectory, ArchiveDirectoryVersion);
 
                     directoryFile.Seek(chunk._fileOffset, SEEK_SET);
                     directoryFile.Read(&dirHdr, sizeof(dirHdr), 1);
@@ -343,7 +354,7 @@ namespace Assets
                 auto flattenedHeap = spanningHeap.Flatten();
             
                 ChunkHeader chunkHeader(
-                    ChunkType_ArchiveDirectory, 0, "ArchiveCache", unsigned(sizeof(DirectoryChunk) + blocks.size() * sizeof(ArchiveDirectoryBlock) + flattenedHeap.second));
+                    ChunkType_ArchiveDirectory, ArchiveDirectoryVersion, "ArchiveCache", unsigned(sizeof(DirectoryChunk) + blocks.size() * sizeof(ArchiveDirectoryBlock) + flattenedHeap.second));
                 chunkHeader._fileOffset = sizeof(ChunkFileHeader) + sizeof(ChunkHeader);
 
                 DirectoryChunk chunkData;
@@ -451,7 +462,7 @@ namespace Assets
             BasicFile directoryFile(_directoryFileName.c_str(), "rb");
 
             auto chunkTable = LoadChunkTable(directoryFile);
-            auto chunk = FindChunk(_directoryFileName.c_str(), chunkTable, ChunkType_ArchiveDirectory, 0);
+            auto chunk = FindChunk(_directoryFileName.c_str(), chunkTable, ChunkType_ArchiveDirectory, ArchiveDirectoryVersion);
 
             directoryFile.Seek(chunk._fileOffset, SEEK_SET);
             DirectoryChunk dirHdr;
@@ -32,6 +32,13 @@ namespace Assets
 
     void    DependencyValidation::OnChange()
     { 
+            //  When a batch of file changes is delivered, this object can be reached
+            //  through more than one of the changed files (or through more than one 
+            //  dependency). We only need to invalidate once per batch.
+        auto batchId = Utility::GetFileChangeBatchId();
+        if (batchId && batchId == _lastChangeBatch) return;
+        _lastChangeBatch = batchId;
+
         ++_validationIndex;
         ResourceDependenciesLock.lock();
 
@@ -107,6 +114,7 @@ namespace Assets
     DependencyValidation::DependencyValidation(DependencyValidation&& moveFrom) never_throws
     {
         _validationIndex = moveFrom._validationIndex;
+        _lastChangeBatch = moveFrom._lastChangeBatch;
         for (unsigned c=0; c<dimof(_dependencies); ++c)
             _dependencies[c] = std::move(moveFrom._dependencies[c]);
         _dependenciesOverflow = std::move(moveFrom._dependenciesOverflow);
@@ -115,6 +123,7 @@ namespace Assets
     DependencyValidation& DependencyValidation::operator=(DependencyValidation&& moveFrom) never_throws
     {
         _validationIndex = moveFrom._validationIndex;
+        _lastChangeBatch = moveFrom._lastChangeBatch;
         for (unsigned c=0; c<dimof(_dependencies); ++c)
             _dependencies[c] = std::move(moveFrom._dependencies[c]);
         _dependenciesOverflow = std::move(moveFrom._dependenciesOverflow);
@@ -68,7 +68,7 @@ namespace Assets
 
         void    RegisterDependency(const std::shared_ptr<Utility::OnChangeCallback>& dependency);
 
-        DependencyValidation() : _validationIndex(0)  {}
+        DependencyValidation() : _validationIndex(0), _lastChangeBatch(0)  {}
         DependencyValidation(DependencyValidation&&) never_throws;
         DependencyValidation& operator=(DependencyValidation&&) never_throws;
         ~DependencyValidation();
@@ -77,6 +77,7 @@ namespace Assets
         DependencyValidation& operator=(const DependencyValidation&) = delete;
     private:
         unsigned _validationIndex;
+        unsigned _lastChangeBatch;      // see Utility::GetFileChangeBatchId()
 
             // store a fixed number of dependencies (with room to grow)
             // this is just to avoid extra allocation where possible
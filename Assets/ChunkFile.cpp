@@ -28,20 +28,26 @@ namespace Serialization { namespace ChunkFile
         return header;
     }
 
-    std::vector<ChunkHeader> LoadChunkTable(BasicFile& file)
+    static void CheckFileHeader(const ChunkFileHeader& fileHeader)
     {
-        ChunkFileHeader fileHeader;
-        if (file.Read(&fileHeader, sizeof(ChunkFileHeader), 1) != 1) {
-            throw FormatError("Incomplete file header");
-        }
-
         if (fileHeader._magic != MagicHeader) {
             throw FormatError("Unrecognised format");
         }
 
-        if (fileHeader._fileVersionNumber != ChunkFileVersion) {
+            // (older versions differ only in chunk alignment, so they can still be loaded)
+        if (fileHeader._fileVersionNumber > ChunkFileVersion) {
             throw FormatError("Bad chunk file format");
         }
+    }
+
+    std::vector<ChunkHeader> LoadChunkTable(BasicFile& file)
+    {
+        ChunkFileHeader fileHeader;
+        if (file.Read(&fileHeader, sizeof(ChunkFileHeader), 1) != 1) {
+            throw FormatError("Incomplete file header");
+        }
+
+        CheckFileHeader(fileHeader);
 
         std::vector<ChunkHeader> result;
         result.resize(fileHeader._chunkCount);
@@ -53,6 +59,29 @@ namespace Serialization { namespace ChunkFile
         return result;
     }
 
+    std::vector<ChunkHeader> LoadChunkTable(const void* fileData, size_t fileSize)
+    {
+        if (fileSize < sizeof(ChunkFileHeader)) {
+            throw FormatError("Incomplete file header");
+        }
+
+        const auto& fileHeader = *(const ChunkFileHeader*)fileData;
+        CheckFileHeader(fileHeader);
+
+        if (fileSize < sizeof(ChunkFileHeader) + fileHeader._chunkCount * sizeof(ChunkHeader)) {
+            throw FormatError("Incomplete file header");
+        }
+
+        auto* tableStart = (const ChunkHeader*)PtrAdd(fileData, sizeof(ChunkFileHeader));
+        std::vector<ChunkHeader> result(tableStart, tableStart + fileHeader._chunkCount);
+        for (const auto& c:result)
+            if (uint64(c._fileOffset) + uint64(c._size) > uint64(fileSize)) {
+                throw FormatError("Chunk extends beyond the end of the file");
+            }
+
+        return result;
+    }
+
     Serialization::ChunkFile::ChunkHeader FindChunk(
         const char filename[],
         std::vector<Serialization::ChunkFile::ChunkHeader>& hdrs,
@@ -142,6 +171,16 @@ namespace Serialization { namespace ChunkFile
             _activeChunk._type = type;
             _activeChunk._chunkVersion = version;
             XlCopyString(_activeChunk._name, name);
+
+                // pad so that the chunk payload begins on an aligned offset
+            auto start = TellP();
+            auto paddingSize = AlignChunkOffset(SizeType(start)) - SizeType(start);
+            if (paddingSize) {
+                uint8 padding[ChunkAlignment];
+                XlZeroMemory(padding);
+                Write(padding, 1, paddingSize);
+            }
+
             _activeChunkStart = TellP();
             _activeChunk._fileOffset = (ChunkFile::SizeType)_activeChunkStart;
             _activeChunk._size = 0; // unknown currently
@@ -50,7 +50,19 @@ namespace Serialization { namespace ChunkFile
     };
 
     static const unsigned MagicHeader = uint32('X') | (uint32('L') << 8) | (uint32('E') << 16) | (uint32('~') << 24);
-    static const unsigned ChunkFileVersion = 0;
+    static const unsigned ChunkFileVersion = 1;
+
+        //  From version 1, the payload of every chunk begins on a multiple of
+        //  ChunkAlignment bytes from the start of the file. Since mapped views
+        //  always begin on a page boundary, this means chunks can be used in
+        //  place from a mapped file. Version 0 files are still loaded (but their
+        //  chunks must be copied into aligned memory first)
+    static const unsigned ChunkAlignment = 16;
+
+    inline SizeType AlignChunkOffset(SizeType offset)
+    {
+        return (offset + ChunkAlignment - 1) & ~SizeType(ChunkAlignment - 1);
+    }
 
     class ChunkFileHeader
     {
@@ -64,6 +76,7 @@ namespace Serialization { namespace ChunkFile
 
     ChunkFileHeader MakeChunkFileHeader(unsigned chunkCount, const char buildVersionString[], const char buildDateString[]);
     std::vector<ChunkHeader> LoadChunkTable(Utility::BasicFile& file);
+    std::vector<ChunkHeader> LoadChunkTable(const void* fileData, size_t fileSize);
 
     ChunkHeader FindChunk(
         const char filename[], std::vector<ChunkHeader>& hdrs,
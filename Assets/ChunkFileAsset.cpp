@@ -8,21 +8,22 @@
 #include "BlockSerializer.h"
 #include "IntermediateAssets.h"
 #include "../Utility/StringFormat.h"
+#include "../Utility/PtrUtils.h"
+#include "../Utility/MemoryUtils.h"
 #include "../Core/Exceptions.h"
 #include "../ConsoleRig/Log.h"
 
 namespace Assets
 {
-    static std::vector<AssetChunkResult> LoadRawData(
+    static bool s_mappedLoading = true;
+
+    void SetChunkFileMappedLoading(bool enable) { s_mappedLoading = enable; }
+
+    static void CheckRequests(
         const char filename[],
-        IteratorRange<const AssetChunkRequest*> requests)
+        IteratorRange<const AssetChunkRequest*> requests,
+        const std::vector<Serialization::ChunkFile::ChunkHeader>& chunks)
     {
-        BasicFile file(filename, "rb");
-        auto chunks = Serialization::ChunkFile::LoadChunkTable(file);
-        
-        std::vector<AssetChunkResult> result;
-        result.reserve(requests.size());
-
             // First scan through and check to see if we
             // have all of the chunks we need
         using ChunkHeader = Serialization::ChunkFile::ChunkHeader;
@@ -42,21 +43,46 @@ namespace Assets
                         << r._name << ") expected: " << r._expectedVersion << ", got: " << i->_chunkVersion, 
                         filename));
         }
+    }
+
+    static const Serialization::ChunkFile::ChunkHeader& FindChunk(
+        const std::vector<Serialization::ChunkFile::ChunkHeader>& chunks,
+        const AssetChunkRequest& request)
+    {
+        using ChunkHeader = Serialization::ChunkFile::ChunkHeader;
+        auto i = std::find_if(
+            chunks.begin(), chunks.end(), 
+            [&request](const ChunkHeader& c) { return c._type == request._type; });
+        assert(i != chunks.end());
+        return *i;
+    }
 
+    static std::shared_ptr<uint8> AllocateChunkBuffer(size_t size)
+    {
+        return std::shared_ptr<uint8>(new uint8[size], std::default_delete<uint8[]>());
+    }
+
+    static std::vector<AssetChunkResult> LoadCopiedData(
+        const char filename[],
+        IteratorRange<const AssetChunkRequest*> requests)
+    {
+        BasicFile file(filename, "rb");
+        auto chunks = Serialization::ChunkFile::LoadChunkTable(file);
+        CheckRequests(filename, requests, chunks);
+        
+        std::vector<AssetChunkResult> result;
+        result.reserve(requests.size());
         for (const auto& r:requests) {
-            auto i = std::find_if(
-                chunks.begin(), chunks.end(), 
-                [&r](const ChunkHeader& c) { return c._type == r._type; });
-            assert(i != chunks.end());
+            const auto& c = FindChunk(chunks, r);
 
             AssetChunkResult chunkResult;
-            chunkResult._offset = i->_fileOffset;
-            chunkResult._size = i->_size;
+            chunkResult._offset = c._fileOffset;
+            chunkResult._size = c._size;
 
             if (r._dataType != AssetChunkRequest::DataType::DontLoad) {
-                chunkResult._buffer = std::make_unique<uint8[]>(i->_size);
-                file.Seek(i->_fileOffset, SEEK_SET);
-                file.Read(chunkResult._buffer.get(), 1, i->_size);
+                chunkResult._buffer = AllocateChunkBuffer(c._size);
+                file.Seek(c._fileOffset, SEEK_SET);
+                file.Read(chunkResult._buffer.get(), 1, c._size);
 
                 // initialize with the block serializer (if requested)
                 if (r._dataType == AssetChunkRequest::DataType::BlockSerializer)
@@ -69,6 +95,68 @@ namespace Assets
         return std::move(result);
     }
 
+    static std::vector<AssetChunkResult> LoadMappedData(
+        const char filename[],
+        IteratorRange<const AssetChunkRequest*> requests)
+    {
+            //  The view is copy-on-write, so that Block_Initialize can patch pointers
+            //  in place. Block_Initialize only writes to the pages holding pointers (for
+            //  the block serializer layouts, these are packed at the start of the block)
+            //  so the pages holding sub-block data remain shared with the file cache.
+            //
+            //  The mapping must survive the asset being recompiled under it. We allow
+            //  delete sharing, and BasicFile replaces (rather than truncates) files that
+            //  are still mapped, so a reader keeps seeing the old contents.
+        auto file = std::make_shared<MemoryMappedFile>(
+            filename, 0, MemoryMappedFile::Access::Read|MemoryMappedFile::Access::CopyOnWrite,
+            BasicFile::ShareMode::Read|BasicFile::ShareMode::Delete);
+        if (!file->IsValid())
+            Throw(Utility::Exceptions::IOException(
+                Utility::Exceptions::IOException::Reason::FileNotFound,
+                "Failed to map chunk file (%s)", filename));
+
+        auto chunks = Serialization::ChunkFile::LoadChunkTable(file->GetData(), file->GetSize());
+        CheckRequests(filename, requests, chunks);
+
+        std::vector<AssetChunkResult> result;
+        result.reserve(requests.size());
+        for (const auto& r:requests) {
+            const auto& c = FindChunk(chunks, r);
+
+            AssetChunkResult chunkResult;
+            chunkResult._offset = c._fileOffset;
+            chunkResult._size = c._size;
+
+            if (r._dataType != AssetChunkRequest::DataType::DontLoad) {
+                auto* chunkData = (uint8*)PtrAdd(file->GetData(), c._fileOffset);
+                if ((c._fileOffset % Serialization::ChunkFile::ChunkAlignment) == 0) {
+                        // (aliases the mapped file, so the mapping lives as long as the buffer)
+                    chunkResult._buffer = std::shared_ptr<uint8>(file, chunkData);
+                } else {
+                        // files written before chunk alignment was introduced must still be copied
+                    chunkResult._buffer = AllocateChunkBuffer(c._size);
+                    XlCopyMemory(chunkResult._buffer.get(), chunkData, c._size);
+                }
+
+                if (r._dataType == AssetChunkRequest::DataType::BlockSerializer)
+                    Serialization::Block_Initialize(chunkResult._buffer.get());
+            }
+
+            result.emplace_back(std::move(chunkResult));
+        }
+
+        return std::move(result);
+    }
+
+    std::vector<AssetChunkResult> LoadChunkFileData(
+        const ResChar filename[],
+        IteratorRange<const AssetChunkRequest*> requests)
+    {
+        if (s_mappedLoading)
+            return LoadMappedData(filename, requests);
+        return LoadCopiedData(filename, requests);
+    }
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
     ChunkFileAsset::ChunkFileAsset(const char assetTypeName[])
@@ -103,7 +191,7 @@ namespace Assets
 
         _validationCallback = std::make_shared<::Assets::DependencyValidation>();
         RegisterFileDependency(_validationCallback, filename);
-        auto pendingResult = LoadRawData(filename, op._requests);
+        auto pendingResult = LoadChunkFileData(filename, op._requests);
         ExecuteResolve(op._fn, this, MakeIteratorRange(pendingResult), filename, _assetTypeName);
         _completedState = ::Assets::AssetState::Ready;
     }
@@ -121,7 +209,7 @@ namespace Assets
         if (existing._dependencyValidation && existing._dependencyValidation->GetValidationIndex() == 0) {
             TRY
             {
-                auto pendingResult = LoadRawData(existing._sourceID0, op._requests);
+                auto pendingResult = LoadChunkFileData(existing._sourceID0, op._requests);
                 (*op._fn)(this, MakeIteratorRange(pendingResult));
                 _filename = existing._sourceID0;
                 _validationCallback = existing._dependencyValidation;
@@ -241,7 +329,7 @@ namespace Assets
         _filename = locator._sourceID0;
 
         if (_completedState == Assets::AssetState::Ready) {
-            auto chunks = LoadRawData(locator._sourceID0, _pendingResolveOp._requests);
+            auto chunks = LoadChunkFileData(locator._sourceID0, _pendingResolveOp._requests);
             if (_pendingResolveOp._fn) {
                 ExecuteResolve(_pendingResolveOp._fn, this, MakeIteratorRange(chunks), _filename.c_str(), _assetTypeName);
                 _pendingResolveOp._fn = nullptr;
@@ -30,11 +30,17 @@ namespace Assets
         DataType        _dataType;
     };
 
+    /// <summary>Data loaded from a single chunk</summary>
+    /// The buffer is either a copy of the chunk, or points directly into a mapped
+    /// view of the file (see SetChunkFileMappedLoading). In the latter case, the
+    /// buffer keeps the mapping alive, and rewriting the file replaces it (rather
+    /// than changing the data under the buffer). Either way, the buffer is writable (mapped views are copy-on-write),
+    /// and aligned to Serialization::ChunkFile::ChunkAlignment.
     class AssetChunkResult
     {
     public:
         Serialization::ChunkFile::SizeType  _offset;
-        std::unique_ptr<uint8[]> _buffer;
+        std::shared_ptr<uint8> _buffer;
         size_t _size;
 
         AssetChunkResult() : _offset(0), _size(0) {}
@@ -52,6 +58,20 @@ namespace Assets
         }
     };
 
+    /// <summary>Use chunks directly from a mapped view of the file, rather than copying</summary>
+    /// This avoids copying the chunk data and reduces peak memory use for large
+    /// assets (only the pages that are written to when patching block serializer
+    /// pointers become private to the process). Files stay mapped for as long as
+    /// the asset is alive; recompiling writes a new file in place of the old one,
+    /// and the existing asset keeps reading the old contents until it is reloaded.
+    /// On by default. Disable it to read chunks into heap copies (for example, when
+    /// the files are on storage that can disappear while the asset is alive).
+    void SetChunkFileMappedLoading(bool enable);
+
+    std::vector<AssetChunkResult> LoadChunkFileData(
+        const ResChar filename[],
+        IteratorRange<const AssetChunkRequest*> requests);
+
     /// <summary>Utility for building asset objects that load from chunk files (sometimes asychronously)</summary>
     /// Some simple assets simply want to load some raw data from a chunk in a file, or
     /// perhaps from a few chunks in the same file. This is a base class to take away some
@@ -20,6 +20,7 @@
 #include "../Utility/Streams/Stream.h"
 #include "../Utility/Threading/Mutex.h"
 #include "../Utility/IteratorUtils.h"
+#include "../Utility/MemoryUtils.h"
 #include "../Utility/PtrUtils.h"
 #include "../Utility/ExceptionLogging.h"
 
@@ -176,12 +177,19 @@ namespace Assets { namespace IntermediateAssets
                     return nullptr;
                 }
 
+                    //  A dependency that was already missing when the asset was compiled
+                    //  (recorded with a zero time) is expected -- eg, an optional 
+                    //  ".metadata" file. It doesn't invalidate the asset while it remains
+                    //  missing; creating it later will trigger the validation registered above.
+                auto recordedTime = (uint64(dateHigh) << 32ull) | uint64(dateLow);
                 if (!record->_state._timeMarker) {
-                    LogInfo
-                        << "Asset (" << intermediateFileName 
-                        << ") is invalidated because of missing dependency (" << depName << ")";
-                    return nullptr;
-                } else if (record->_state._timeMarker != ((uint64(dateHigh) << 32ull) | uint64(dateLow))) {
+                    if (recordedTime) {
+                        LogInfo
+                            << "Asset (" << intermediateFileName 
+                            << ") is invalidated because of missing dependency (" << depName << ")";
+                        return nullptr;
+                    }
+                } else if (record->_state._timeMarker != recordedTime) {
                     LogInfo
                         << "Asset (" << intermediateFileName 
                         << ") is invalidated because of file data on dependency (" << depName << ")";
@@ -251,6 +259,10 @@ namespace Assets { namespace IntermediateAssets
 
 		ResChar buffer[MaxPath];
 
+            //  Compiled assets can contain Hash64 values, so stores made with a
+            //  different version of the hash algorithm can't be reused
+        auto hashVersionString = std::to_string(Hash64Version);
+
 		if (!universal) {
 			_snprintf_s(buffer, _TRUNCATE, "%s/%s_*", baseDirectory, configString);
 
@@ -282,7 +294,9 @@ namespace Assets { namespace IntermediateAssets
                                 Document<InputStreamFormatter<utf8>> doc(formatter);
 
 								auto compareVersion = doc.Attribute(u("VersionString")).Value();
-								if (XlEqString(compareVersion, (const utf8*)versionString)) {
+								auto compareHashVersion = doc.Attribute(u("Hash64Version")).Value();
+								if (XlEqString(compareVersion, (const utf8*)versionString)
+                                    && XlEqString(compareHashVersion, (const utf8*)hashVersionString.c_str())) {
 									// this branch is already present, and is good... so use it
 									goodBranchDir = std::string(baseDirectory) + "/" + findData.cFileName;
                                     _markerFile = std::move(markerFile);
@@ -322,6 +336,7 @@ namespace Assets { namespace IntermediateAssets
 					auto stream = OpenFileOutput(_markerFile);
                     OutputStreamFormatter formatter(*stream);
                     formatter.WriteAttribute(u("VersionString"), (const utf8*)versionString);
+                    formatter.WriteAttribute(u("Hash64Version"), (const utf8*)hashVersionString.c_str());
                     formatter.Flush();
 					break;
 				}
@@ -1145,7 +1145,7 @@ namespace BufferUploads
             }
             (*offsetWriteIterator) = offset;
             queuedBytesAdjustment[AsUploadDataType(transaction->_desc)] -= Interlocked::Value(size);
-            offset += MarkerHeap<uint16>::AlignSize(size);
+            offset += MarkerHeap<uint32>::AlignSize(size);
         }
 
         for (unsigned c=0; c<dimof(queuedBytesAdjustment); ++c) {
@@ -1313,7 +1313,7 @@ namespace BufferUploads
             for (;;) {
                 unsigned thisSize = 0;
                 if (batchingI!=batchOperation._batchedSteps.end()) {
-                    thisSize = MarkerHeap<uint16>::AlignSize(PlatformInterface::ByteCount(batchingI->_creationDesc));
+                    thisSize = MarkerHeap<uint32>::AlignSize(PlatformInterface::ByteCount(batchingI->_creationDesc));
                 }
                 if (batchingI == batchOperation._batchedSteps.end() || (currentBatchSize+thisSize) > maxSingleBatch) {
                     if (batchingI == batchingStart) {
@@ -1528,7 +1528,7 @@ namespace BufferUploads
 
                     completed = true;
                     _batchPreparation_Main._batchedSteps.push_back(resourceCreateStep);
-                    _batchPreparation_Main._batchedAllocationSize += MarkerHeap<uint16>::AlignSize(objectSize);
+                    _batchPreparation_Main._batchedAllocationSize += MarkerHeap<uint32>::AlignSize(objectSize);
                 }
 
                 if (completed) {
@@ -12,6 +12,7 @@
 #include "../Utility/Streams/PathUtils.h"
 #include "../Utility/Conversion.h"
 #include "../Utility/StringUtils.h"
+#include "../Utility/TimeUtils.h"
 #include <queue>
 #include <thread>
 
@@ -132,13 +133,14 @@ namespace BufferUploads
 
         virtual std::shared_ptr<Marker>     BeginBackgroundLoad();
 
-        FileDataSource(const void* fileHandle, size_t offset, size_t dataSize, TexturePitches pitches);
+        FileDataSource(const void* fileHandle, size_t offset, size_t dataSize, TexturePitches pitches, FileDataDecoder&& decoder);
         virtual ~FileDataSource();
 
     protected:
         HANDLE      _fileHandle;
         size_t      _dataSize;
         size_t      _offset;
+        FileDataDecoder _decoder;
 
         struct SpecialOverlapped
         {
@@ -162,7 +164,7 @@ namespace BufferUploads
         return _pkt.get();
     }
 
-    size_t FileDataSource::GetDataSize(SubResource subRes) const           { /*assert(subRes == 0);*/ return _dataSize; }
+    size_t FileDataSource::GetDataSize(SubResource subRes) const           { /*assert(subRes == 0);*/ return _decoder ? _pitches._slicePitch : _dataSize; }
     TexturePitches FileDataSource::GetPitches(SubResource subRes) const    { /*assert(subRes == 0);*/ return _pitches; }
 
     void CALLBACK FileDataSource::CompletionRoutine(
@@ -173,10 +175,18 @@ namespace BufferUploads
         assert(o && o->_returnPointer && o->_returnPointer->_marker);
         assert(o->_returnPointer->_marker->GetAssetState() == Assets::AssetState::Pending);
 
-            // We don't have to do any extra processing right now. Just mark the asset as ready
-            // or invalid, based on the result...
-        o->_returnPointer->_marker->SetState(
-            (dwErrorCode == ERROR_SUCCESS) ? Assets::AssetState::Ready : Assets::AssetState::Invalid);
+            //  If there's a decoder, we decode here (in the background thread that began the read).
+            //  Otherwise there's no extra processing. Just mark the asset as ready or invalid, 
+            //  based on the result...
+        auto* pkt = o->_returnPointer.get();
+        bool success = dwErrorCode == ERROR_SUCCESS;
+        if (success && pkt->_decoder) {
+            std::unique_ptr<byte[], PODAlignedDeletor> decoded((byte*)XlMemAlign(pkt->_pitches._slicePitch, 16));
+            success = pkt->_decoder(decoded.get(), pkt->_pitches._slicePitch, pkt->_pkt.get(), dwNumberOfBytesTransfered);
+            pkt->_pkt = std::move(decoded);
+        }
+
+        pkt->_marker->SetState(success ? Assets::AssetState::Ready : Assets::AssetState::Invalid);
 
             // we can reset the "_returnPointer", which will also decrease the reference
             // count on the FileDataSource object
@@ -224,7 +234,8 @@ namespace BufferUploads
         return _marker;
     }
 
-    FileDataSource::FileDataSource(const void* fileHandle, size_t offset, size_t dataSize, TexturePitches pitches)
+    FileDataSource::FileDataSource(const void* fileHandle, size_t offset, size_t dataSize, TexturePitches pitches, FileDataDecoder&& decoder)
+    : _decoder(std::move(decoder))
     {
         assert(dataSize);
         assert(fileHandle != INVALID_HANDLE_VALUE);
@@ -247,9 +258,9 @@ namespace BufferUploads
         }
     }
 
-    intrusive_ptr<DataPacket> CreateFileDataSource(const void* fileHandle, size_t offset, size_t dataSize, TexturePitches pitches)
+    intrusive_ptr<DataPacket> CreateFileDataSource(const void* fileHandle, size_t offset, size_t dataSize, TexturePitches pitches, FileDataDecoder decoder)
     {
-        return make_intrusive<FileDataSource>(fileHandle, offset, dataSize, pitches);
+        return make_intrusive<FileDataSource>(fileHandle, offset, dataSize, pitches, std::move(decoder));
     }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -269,7 +280,7 @@ namespace BufferUploads
         virtual ~StreamingTexture();
 
     protected:
-        wchar_t _filename[MaxPath];
+        wchar_t _filename[MaxPath*2];
         
         DirectX::ScratchImage _image;
         DirectX::TexMetadata _texMetadata;
@@ -391,6 +402,7 @@ namespace BufferUploads
 
                 HRESULT hresult = -1;
 				bool loadedDDSFormat = false;
+                const auto startTime = GetPerformanceCounter();
 				
 					// The filename can actually contain multiple alternatives. We're going
 					// to test each one until we find one that works. Scan forward until we
@@ -439,6 +451,9 @@ namespace BufferUploads
                     }
 
                     if (SUCCEEDED(hresult)) {
+                        LogInfo 
+                            << "Loaded texture (" << filename << ") in " 
+                            << float(double(GetPerformanceCounter() - startTime) * 1000.0 / double(GetPerformanceCounterFrequency())) << "ms";
                         this->_marker->SetState(Assets::AssetState::Ready);
                         return;
                     }
@@ -11,6 +11,7 @@
 #include "../Utility/Threading/ThreadingUtils.h"    // for RefCountedObject
 #include "../Utility/MemoryUtils.h"
 #include "../Utility/StringUtils.h"                 // for StringSection
+#include <functional>
 
 namespace BufferUploads
 {
@@ -83,9 +84,15 @@ namespace BufferUploads
     buffer_upload_dll_export intrusive_ptr<DataPacket> CreateEmptyPacket(
         const BufferDesc& desc);
 
+        //  Decodes file data after it's read in (eg, for compressed data). The function is 
+        //  called from a background thread, and should return false if the data is invalid.
+    using FileDataDecoder = std::function<bool(void* dst, size_t dstSize, const void* src, size_t srcSize)>;
+
+        //  Reads "dataSize" bytes from the file in the background. When there is a decoder, the
+        //  data will be decoded into a buffer of size "pitches._slicePitch" once the read completes.
     buffer_upload_dll_export intrusive_ptr<DataPacket> CreateFileDataSource(
         const void* fileHandle, size_t offset, size_t dataSize,
-        TexturePitches pitches);
+        TexturePitches pitches, FileDataDecoder decoder = nullptr);
 
     namespace TextureLoadFlags { 
         enum Enum { GenerateMipmaps = 1<<0 };
@@ -15,7 +15,7 @@ namespace BufferUploads
 {
             //////   R E F E R E N C E   C O U N T I N G   L A Y E R   //////
 
-    class ReferenceCountingLayer : public MarkerHeap<uint16>
+    class ReferenceCountingLayer : public MarkerHeap<uint32>
     {
     public:
         std::pair<signed,signed> AddRef(unsigned start, unsigned size, const char name[] = NULL);
@@ -36,7 +36,7 @@ namespace BufferUploads
         ReferenceCountingLayer(const ReferenceCountingLayer& cloneFrom);
     protected:
 
-        typedef uint16 Marker;
+        typedef uint32 Marker;
         class Entry
         {
         public:
@@ -87,6 +87,8 @@ namespace BufferUploads
         unsigned _largestFreeBlock;
         unsigned _spaceInReferencedCountedBlocks;
         unsigned _referencedCountedBlockCount;
+        unsigned _freeBlockCount;
+        float _fragmentation;
     };
 
     struct BatchingSystemMetrics
@@ -0,0 +1,139 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../../Core/Prefix.h"
+#include "../../RenderCore/Metal/Metal.h"
+
+#if GFXAPI_ACTIVE == GFXAPI_NULL
+
+    #include "../PlatformInterface.h"
+    #include "../DataPacket.h"
+    #include "../../RenderCore/Metal/Format.h"
+    #include "../../Utility/HeapUtils.h"
+    #include "../../Utility/MemoryUtils.h"
+    #include "../../Utility/PtrUtils.h"
+
+    namespace BufferUploads { namespace PlatformInterface
+    {
+            //  On the null device, a resource is just a block of bookkeeping. We keep the
+            //  BufferDesc it was created with (so ExtractDesc() works), and only allocate
+            //  CPU memory if someone maps it.
+        class NullResource : public Underlying::Resource
+        {
+        public:
+            BufferDesc                  _desc;
+            std::unique_ptr<uint8[]>    _mappedData;
+
+            NullResource(const BufferDesc& desc) : Underlying::Resource(ByteCount(desc)), _desc(desc) {}
+        };
+
+        static NullResource*    ResPtr(const Underlying::Resource& resource) 
+        {
+            return checked_cast<NullResource*>(const_cast<Underlying::Resource*>(&resource));
+        }
+
+        void UnderlyingDeviceContext::PushToResource(   const Underlying::Resource& resource, const BufferDesc& desc, 
+                                                        unsigned resourceOffsetValue, const void* data, size_t dataSize,
+                                                        TexturePitches rowAndSlicePitch, 
+                                                        const Box2D& box, unsigned lodLevel, unsigned arrayIndex)
+        {
+            _devContext->GetCommandLog().Push(CommandLog::Command::Upload, uint32(dataSize));
+        }
+
+        void UnderlyingDeviceContext::PushToStagingResource(    const Underlying::Resource& resource, const BufferDesc&desc, 
+                                                                unsigned resourceOffsetValue, const void* data, size_t dataSize, 
+                                                                TexturePitches rowAndSlicePitch, 
+                                                                const Box2D& box, unsigned lodLevel, unsigned arrayIndex)
+        {
+            assert(box == Box2D());
+            _devContext->GetCommandLog().Push(CommandLog::Command::Upload, uint32(dataSize));
+        }
+
+        void UnderlyingDeviceContext::UpdateFinalResourceFromStaging(const Underlying::Resource& finalResource, const Underlying::Resource& staging, const BufferDesc& destinationDesc, unsigned lodLevelMin, unsigned lodLevelMax, unsigned stagingLODOffset)
+        {
+            RenderCore::Metal::Copy(*_devContext, ResPtr(finalResource), ResPtr(staging));
+        }
+
+        void UnderlyingDeviceContext::ResourceCopy_DefragSteps(const Underlying::Resource& destination, const Underlying::Resource& source, const std::vector<DefragStep>& steps)
+        {
+            for (auto i=steps.cbegin(); i!=steps.cend(); ++i) {
+                assert(i->_sourceEnd > i->_sourceStart);
+                _devContext->GetCommandLog().Push(CommandLog::Command::Upload, i->_sourceEnd - i->_sourceStart);
+            }
+        }
+
+        void UnderlyingDeviceContext::ResourceCopy(const Underlying::Resource& destination, const Underlying::Resource& source)
+        {
+            RenderCore::Metal::Copy(*_devContext, ResPtr(destination), ResPtr(source));
+        }
+
+        intrusive_ptr<RenderCore::Metal::CommandList> UnderlyingDeviceContext::ResolveCommandList()
+        {
+            return _devContext->ResolveCommandList();
+        }
+
+        void                        UnderlyingDeviceContext::BeginCommandList()
+        {
+            _devContext->BeginCommandList();
+        }
+
+        UnderlyingDeviceContext::MappedBuffer UnderlyingDeviceContext::Map(const Underlying::Resource& resource, MapType::Enum mapType, unsigned subResource)
+        {
+                //  Mapping gives access to the whole resource (like a staging resource
+                //  on DX11). The memory is allocated on first use, and stays with the
+                //  resource after that.
+            auto* res = ResPtr(resource);
+            if (!res->_byteCount) return MappedBuffer();
+            if (!res->_mappedData) {
+                res->_mappedData = std::make_unique<uint8[]>(res->_byteCount);
+                XlZeroMemory(res->_mappedData.get(), res->_byteCount);
+            }
+
+            TexturePitches pitches(unsigned(res->_byteCount), unsigned(res->_byteCount));
+            if (res->_desc._type == BufferDesc::Type::Texture)
+                pitches = TexturePitches(res->_desc._textureDesc);
+            return MappedBuffer(*this, resource, subResource, res->_mappedData.get(), pitches);
+        }
+
+        UnderlyingDeviceContext::MappedBuffer UnderlyingDeviceContext::MapPartial(const Underlying::Resource& resource, MapType::Enum mapType, unsigned offset, unsigned size, unsigned subResource)
+        {
+            assert(0);  // CanDoPartialMaps is false for this device
+            return MappedBuffer();
+        }
+
+        void UnderlyingDeviceContext::Unmap(const Underlying::Resource& resource, unsigned subResourceIndex)
+        {
+        }
+
+        UnderlyingDeviceContext::UnderlyingDeviceContext(RenderCore::IThreadContext& renderCoreContext) 
+        : _renderCoreContext(&renderCoreContext)
+        {
+            _devContext = DeviceContext::Get(*_renderCoreContext);
+        }
+
+            ///////////////////////////////////////////////////////////////////////////////////////////////////
+
+        intrusive_ptr<Underlying::Resource> CreateResource(ObjectFactory& device, const BufferDesc& desc, DataPacket* initialisationData)
+        {
+                //  Initialisation data is ignored, but we still create the resource
+                //  (and record its size), so that the upload metrics are realistic
+            return make_intrusive<NullResource>(desc);
+        }
+
+        BufferDesc ExtractDesc(const Underlying::Resource& resource)
+        {
+            if (auto* res = dynamic_cast<const NullResource*>(&resource))
+                return res->_desc;
+
+            BufferDesc desc;
+            XlZeroMemory(desc);
+            desc._type = BufferDesc::Type::Unknown;
+            return desc;
+        }
+
+    }}
+
+#endif
@@ -234,7 +234,7 @@ namespace BufferUploads { namespace PlatformInterface
 
     void  GPUEventStack::TriggerEvent(RenderCore::Metal::DeviceContext* context, EventID event)
     {
-#if GFXAPI_ACTIVE != GFXAPI_OPENGLES
+#if (GFXAPI_ACTIVE != GFXAPI_OPENGLES) && (GFXAPI_ACTIVE != GFXAPI_NULL)
             //
             //      Look for a query in the query stack that isn't being used...
             //      this will become our.
@@ -269,12 +269,15 @@ namespace BufferUploads { namespace PlatformInterface
         }
         LogWarning << "Ran out of free query objects in GPUEventStack";
         _lastCompletedID = std::max(_lastCompletedID, event);       // consider it immediately completed
+#elif GFXAPI_ACTIVE == GFXAPI_NULL
+            // the null device executes nothing, so every event is complete as soon as it's triggered
+        _lastCompletedID = std::max(_lastCompletedID, event);
 #endif
     }
 
     void        GPUEventStack::Update(RenderCore::Metal::DeviceContext* context)
     {
-#if GFXAPI_ACTIVE != GFXAPI_OPENGLES
+#if (GFXAPI_ACTIVE != GFXAPI_OPENGLES) && (GFXAPI_ACTIVE != GFXAPI_NULL)
             //
             //      Look for completed queries, and update our current ID as they complete (also return the 
             //      query to the pool)
@@ -293,7 +296,7 @@ namespace BufferUploads { namespace PlatformInterface
 
     void        GPUEventStack::OnLostDevice()
     {
-#if GFXAPI_ACTIVE != GFXAPI_OPENGLES
+#if (GFXAPI_ACTIVE != GFXAPI_OPENGLES) && (GFXAPI_ACTIVE != GFXAPI_NULL)
             // On device lost, we must consider all queries triggered, and then un-allocate them
         for (std::vector<Query>::iterator i=_queries.begin(); i!=_queries.end(); ++i) {
             i->_query.reset();
@@ -335,7 +338,7 @@ namespace BufferUploads { namespace PlatformInterface
 
     GPUEventStack::Query::Query()
     {
-#if GFXAPI_ACTIVE != GFXAPI_OPENGLES
+#if (GFXAPI_ACTIVE != GFXAPI_OPENGLES) && (GFXAPI_ACTIVE != GFXAPI_NULL)
         _query = nullptr;
 #endif
         _assignedID = EventID_Unallocated;
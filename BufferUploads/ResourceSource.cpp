@@ -404,7 +404,7 @@ namespace BufferUploads
                 for (auto i=_heaps.rbegin(); i!=_heaps.rend(); ++i) {
                     if (i->get() != _activeDefragHeap) {
                         assert(!_activeDefrag.get() || _activeDefrag->GetHeap()!=i->get());
-                        unsigned largestBlock = (*i)->_heap.CalculateLargestFreeBlock();
+                        unsigned largestBlock = (*i)->CalculateLargestFreeBlock();
                         if (largestBlock >= size && largestBlock < bestHeapLargestBlock) {
                             bestHeap = i->get();
                             bestHeapLargestBlock = largestBlock;
@@ -602,7 +602,7 @@ namespace BufferUploads
                     float weight = (*i)->CalculateFragmentationWeight();
                     if (weight > bestWeight && (*i)->_heapResource.get()) {
                             //      if the heap hasn't changed since the last time this heap was used as a defrag source, then there's no use in picking it again
-                        if ((*i)->_hashLastDefrag != (*i)->_heap.CalculateHash()) {
+                        if ((*i)->_hashLastDefrag != (*i)->CalculateHash()) {
                             bestHeap = i->get();
                             bestWeight = weight;
                             break;
@@ -621,8 +621,8 @@ namespace BufferUploads
                 }
 
                     // Now that we've set bestHeap->_activeDefrag, bestHeap->_heap is immutable...
-                _activeDefrag->SetSteps(bestHeap->_heap, bestHeap->_heap.CalculateDefragSteps());
-                bestHeap->_hashLastDefrag = bestHeap->_heap.CalculateHash();
+                _activeDefrag->SetSteps(*bestHeap, bestHeap->CalculateDefragSteps());
+                bestHeap->_hashLastDefrag = bestHeap->CalculateHash();
 
                     // Copy the resource into our copy buffer, and set the count down
                 if (PlatformInterface::UseMapBasedDefrag && !PlatformInterface::CanDoNooverwriteMapInBackground) {
@@ -662,7 +662,7 @@ namespace BufferUploads
                 {
                     ScopedModifyLock(_lock);
                     for (auto i=_heaps.begin(); i!=_heaps.end(); ++i) {
-                        if (i->get() != _activeDefragHeap && (*i)->_heap.IsEmpty()) {
+                        if (i->get() != _activeDefragHeap && (*i)->IsEmpty()) {
                             existingActiveDefrag->GetHeap()->_heapResource.swap((*i)->_heapResource);
                             _heaps.erase(i);
                             break;
@@ -757,7 +757,11 @@ namespace BufferUploads
 
     unsigned    BatchedResources::HeapedResource::Allocate(unsigned size, const char name[])
     {
-        unsigned allocation =_heap.Allocate(size);
+        unsigned allocation;
+        {
+            ScopedLock(_heapLock);
+            allocation = _heap.Allocate(size);
+        }
         if (allocation != ~unsigned(0x0)) {
             _heapResource->AddRef();
             _refCounts.AddRef(allocation, size, name);
@@ -786,16 +790,43 @@ namespace BufferUploads
 
     void    BatchedResources::HeapedResource::Allocate(unsigned ptr, unsigned size)
     {
+        ScopedLock(_heapLock);
         _heap.Allocate(ptr, size);
     }
 
     void        BatchedResources::HeapedResource::Deallocate(unsigned ptr, unsigned size)
     {
+        ScopedLock(_heapLock);
         _heap.Deallocate(ptr, size);
     }
 
+    unsigned    BatchedResources::HeapedResource::CalculateLargestFreeBlock() const
+    {
+        ScopedLock(_heapLock);
+        return _heap.CalculateLargestFreeBlock();
+    }
+
+    uint64      BatchedResources::HeapedResource::CalculateHash() const
+    {
+        ScopedLock(_heapLock);
+        return _heap.CalculateHash();
+    }
+
+    std::vector<DefragStep> BatchedResources::HeapedResource::CalculateDefragSteps() const
+    {
+        ScopedLock(_heapLock);
+        return _heap.CalculateDefragSteps();
+    }
+
+    bool        BatchedResources::HeapedResource::IsEmpty() const
+    {
+        ScopedLock(_heapLock);
+        return _heap.IsEmpty();
+    }
+
     BatchedHeapMetrics BatchedResources::HeapedResource::CalculateMetrics() const
     {
+        ScopedLock(_heapLock);
         BatchedHeapMetrics result;
         result._markers          = _heap.CalculateMetrics();
         result._allocatedSpace   = result._unallocatedSpace = 0;
@@ -811,6 +842,10 @@ namespace BufferUploads
             previousStart = end;
         }
 
+        auto heapMetrics = _heap.CalculateFragmentationMetrics();
+        result._fragmentation    = heapMetrics._fragmentation;
+        result._freeBlockCount   = heapMetrics._freeBlockCount;
+
         result._spaceInReferencedCountedBlocks   = _refCounts.CalculatedReferencedSpace();
         result._referencedCountedBlockCount      = _refCounts.GetEntryCount();
         return result;
@@ -818,6 +853,7 @@ namespace BufferUploads
 
     float BatchedResources::HeapedResource::CalculateFragmentationWeight() const
     {
+        ScopedLock(_heapLock);
         unsigned largestBlock    = _heap.CalculateLargestFreeBlock();
         unsigned availableSpace  = _heap.CalculateAvailableSpace();
         if (largestBlock > .5f * availableSpace) {
@@ -834,6 +870,7 @@ namespace BufferUploads
             //      Deallocate. But otherwise they should match up.
             //
         #if defined(_DEBUG)
+            ScopedLock(_heapLock);
             unsigned referencedSpace = _refCounts.CalculatedReferencedSpace();
             unsigned heapAllocatedSpace = _heap.CalculateAllocatedSpace();
             assert(heapAllocatedSpace == referencedSpace);
@@ -899,12 +936,16 @@ namespace BufferUploads
         }
     }
 
-    void BatchedResources::ActiveDefrag::SetSteps(const SimpleSpanningHeap& sourceHeap, const std::vector<DefragStep>& steps)
+    void BatchedResources::ActiveDefrag::SetSteps(const HeapedResource& source, const std::vector<DefragStep>& steps)
     {
         assert(_steps.empty());      // can't change the steps once they're specified!
         _steps = steps;
-        _newHeap->_size = sourceHeap.CalculateHeapSize();
-        _newHeap->_heap = SimpleSpanningHeap(_newHeap->_size);
+        _newHeap->_size = source._size;
+        _newHeap->_heap = TLSFHeap(_newHeap->_size, source._heap.GetGranularity());
+
+            //  The destination ranges must be marked as allocated in the new heap.
+            //  Otherwise new allocations could be placed over the blocks we're moving
+        _newHeap->_heap.PerformDefrag(_steps);
 
         #if defined(_DEBUG)
             for (std::vector<DefragStep>::const_iterator i=_steps.begin(); i!=_steps.end(); ++i) {
@@ -1168,7 +1209,10 @@ namespace BufferUploads
             batchableIndexBuffers._cpuAccess = CPUAccess::Write|CPUAccess::Read|CPUAccess::WriteDynamic;
         }
 
-        batchableIndexBuffers._linearBufferDesc._sizeInBytes = 256 * 1024;
+            //  Batched heaps use TLSFHeap (32 bit offsets, constant time allocate & free), so
+            //  we're no longer restricted to small heaps. Larger heaps mean fewer device
+            //  resources, and fewer heaps to search through on allocation.
+        batchableIndexBuffers._linearBufferDesc._sizeInBytes = 2 * 1024 * 1024;
         XlCopyNString(batchableIndexBuffers._name, "BatchedBuffer", 13);
         batchableIndexBuffers._name[13] = '\0';
 
@@ -136,6 +136,11 @@ namespace BufferUploads
             bool                AddRef(unsigned ptr, unsigned size, const char name[]);
             bool                Deref(unsigned ptr, unsigned size);
             
+            unsigned            CalculateLargestFreeBlock() const;
+            uint64              CalculateHash() const;
+            std::vector<DefragStep> CalculateDefragSteps() const;
+            bool                IsEmpty() const;
+
             BatchedHeapMetrics  CalculateMetrics() const;
             float               CalculateFragmentationWeight() const;
             void                ValidateRefsAndHeap();
@@ -145,7 +150,8 @@ namespace BufferUploads
             ~HeapedResource();
 
             intrusive_ptr<ResourceLocator> _heapResource;
-            SimpleSpanningHeap  _heap;
+            TLSFHeap            _heap;          // (always access through _heapLock)
+            mutable Threading::Mutex _heapLock;
             ReferenceCountingLayer _refCounts;
             unsigned _size;
             unsigned _defragCount;
@@ -162,7 +168,7 @@ namespace BufferUploads
             void                Tick(ThreadContext& context, Underlying::Resource* sourceResource);
             bool                IsCompleted(IManager::EventListID processedEventList, ThreadContext& context);
 
-            void                SetSteps(const SimpleSpanningHeap& sourceHeap, const std::vector<DefragStep>& steps);
+            void                SetSteps(const HeapedResource& source, const std::vector<DefragStep>& steps);
             void                ReleaseSteps();
             const std::vector<DefragStep>&  GetSteps() { return _steps; }
 
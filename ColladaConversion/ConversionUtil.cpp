@@ -24,7 +24,10 @@ namespace RenderCore { namespace ColladaConversion
     bool ImportCameras = true;
 
     ImportConfiguration::ImportConfiguration(const ::Assets::ResChar filename[])
+    : _clusterTriangleCount(0), _weldVertices(false)
     {
+        _quantization._positions = _quantization._normals = _quantization._texCoords = false;
+
         TRY 
         {
             size_t fileSize = 0;
@@ -37,6 +40,39 @@ namespace RenderCore { namespace ColladaConversion
             _constantsBindings = BindingConfig(doc.Element(u("Constants")));
             _vertexSemanticBindings = BindingConfig(doc.Element(u("VertexSemantics")));
 
+            auto geometry = doc.Element(u("Geometry"));
+            if (geometry) {
+                auto clusterTriangles = geometry.Attribute(u("ClusterTriangles")).As<unsigned>();
+                if (clusterTriangles.first) _clusterTriangleCount = clusterTriangles.second;
+
+                auto quantizePositions = geometry.Attribute(u("QuantizePositions")).As<bool>();
+                if (quantizePositions.first) _quantization._positions = quantizePositions.second;
+                auto quantizeNormals = geometry.Attribute(u("QuantizeNormals")).As<bool>();
+                if (quantizeNormals.first) _quantization._normals = quantizeNormals.second;
+                auto quantizeTexCoords = geometry.Attribute(u("QuantizeTexCoords")).As<bool>();
+                if (quantizeTexCoords.first) _quantization._texCoords = quantizeTexCoords.second;
+
+                auto positionTolerance = geometry.Attribute(u("PositionTolerance")).As<float>();
+                if (positionTolerance.first) _quantization._positionTolerance = positionTolerance.second;
+                auto normalTolerance = geometry.Attribute(u("NormalToleranceDegrees")).As<float>();
+                if (normalTolerance.first) _quantization._normalTolerance = Deg2Rad(normalTolerance.second);
+                auto texCoordTolerance = geometry.Attribute(u("TexCoordTolerance")).As<float>();
+                if (texCoordTolerance.first) _quantization._texCoordTolerance = texCoordTolerance.second;
+
+                auto weldVertices = geometry.Attribute(u("WeldVertices")).As<bool>();
+                if (weldVertices.first) _weldVertices = weldVertices.second;
+                auto weldPositionTolerance = geometry.Attribute(u("WeldPositionTolerance")).As<float>();
+                if (weldPositionTolerance.first)
+                    for (auto& t:_welding._semanticThresholds)
+                        if (t.first == "POSITION") t.second = weldPositionTolerance.second;
+                auto weldTolerance = geometry.Attribute(u("WeldTolerance")).As<float>();
+                if (weldTolerance.first) _welding._defaultThreshold = weldTolerance.second;
+                auto weldHardEdge = geometry.Attribute(u("WeldHardEdgeDegrees")).As<float>();
+                if (weldHardEdge.first) _welding._hardEdgeAngle = Deg2Rad(weldHardEdge.second);
+                auto weldMatchPositionIndices = geometry.Attribute(u("WeldMatchPositionIndices")).As<bool>();
+                if (weldMatchPositionIndices.first) _welding._matchPositionIndices = weldMatchPositionIndices.second;
+            }
+
         } CATCH(...) {
             LogWarning << "Problem while loading configuration file (" << filename << "). Using defaults.";
         } CATCH_END
@@ -44,7 +80,10 @@ namespace RenderCore { namespace ColladaConversion
         _depVal = std::make_shared<::Assets::DependencyValidation>();
         RegisterFileDependency(_depVal, filename);
     }
-    ImportConfiguration::ImportConfiguration() {}
+    ImportConfiguration::ImportConfiguration() : _clusterTriangleCount(0), _weldVertices(false)
+    {
+        _quantization._positions = _quantization._normals = _quantization._texCoords = false;
+    }
     ImportConfiguration::~ImportConfiguration()
     {}
 
@@ -128,6 +167,16 @@ namespace RenderCore { namespace ColladaConversion
         return float(unormValue) / 255.f;
     }
 
+    static float UNormAsFloat32(unsigned short unormValue)
+    {
+        return float(unormValue) / 65535.f;
+    }
+
+    static float SNormAsFloat32(short snormValue)
+    {
+        return std::max(float(snormValue) / 32767.f, -1.f);
+    }
+
     static float Float16AsFloat32(unsigned short input)
     {
         return half_float::detail::half2float(input);
@@ -156,6 +205,14 @@ namespace RenderCore { namespace ColladaConversion
         case R16G16_FLOAT:          return Float4(Float16AsFloat32(((const unsigned short*)rawData)[0]), Float16AsFloat32(((const unsigned short*)rawData)[1]), 0.f, 1.f);
         case R16_FLOAT:             return Float4(Float16AsFloat32(((const unsigned short*)rawData)[0]), 0.f, 0.f, 1.f);
 
+        case R16G16B16A16_UNORM:    return Float4(UNormAsFloat32(((const unsigned short*)rawData)[0]), UNormAsFloat32(((const unsigned short*)rawData)[1]), UNormAsFloat32(((const unsigned short*)rawData)[2]), UNormAsFloat32(((const unsigned short*)rawData)[3]));
+        case R16G16_UNORM:          return Float4(UNormAsFloat32(((const unsigned short*)rawData)[0]), UNormAsFloat32(((const unsigned short*)rawData)[1]), 0.f, 1.f);
+        case R16_UNORM:             return Float4(UNormAsFloat32(((const unsigned short*)rawData)[0]), 0.f, 0.f, 1.f);
+
+        case R16G16B16A16_SNORM:    return Float4(SNormAsFloat32(((const short*)rawData)[0]), SNormAsFloat32(((const short*)rawData)[1]), SNormAsFloat32(((const short*)rawData)[2]), SNormAsFloat32(((const short*)rawData)[3]));
+        case R16G16_SNORM:          return Float4(SNormAsFloat32(((const short*)rawData)[0]), SNormAsFloat32(((const short*)rawData)[1]), 0.f, 1.f);
+        case R16_SNORM:             return Float4(SNormAsFloat32(((const short*)rawData)[0]), 0.f, 0.f, 1.f);
+
         case B8G8R8A8_UNORM:
         case R8G8B8A8_UNORM:        return Float4(UNormAsFloat32(((const unsigned char*)rawData)[0]), UNormAsFloat32(((const unsigned char*)rawData)[1]), UNormAsFloat32(((const unsigned char*)rawData)[2]), UNormAsFloat32(((const unsigned char*)rawData)[3]));
         case R8G8_UNORM:            return Float4(UNormAsFloat32(((const unsigned char*)rawData)[0]), UNormAsFloat32(((const unsigned char*)rawData)[1]), 0.f, 1.f);
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../Assets/AssetsCore.h"
+#include "../RenderCore/Assets/MeshDatabase.h"      // for GeoProc::QuantizationSettings
 #include "../Math/Vector.h"
 #include "../Math/Matrix.h"
 #include "../Utility/UTFUtils.h"
@@ -49,6 +50,18 @@ namespace RenderCore { namespace ColladaConversion
         const BindingConfig& GetConstantBindings() const { return _constantsBindings; }
         const BindingConfig& GetVertexSemanticBindings() const { return _vertexSemanticBindings; }
 
+            //  Maximum triangles per draw call cluster (0 when draw calls shouldn't be split into clusters)
+        unsigned GetClusterTriangleCount() const { return _clusterTriangleCount; }
+
+            //  Vertex streams to quantize (and the error tolerances). Quantization is disabled
+            //  unless it is enabled in the configuration file
+        const Assets::GeoProc::QuantizationSettings& GetQuantizationSettings() const { return _quantization; }
+
+            //  Welding of vertices that are equal within some tolerance (see GeoProc::WeldVertices)
+            //  Disabled unless it is enabled in the configuration file
+        bool GetWeldVertices() const { return _weldVertices; }
+        const Assets::GeoProc::WeldingSettings& GetWeldingSettings() const { return _welding; }
+
         const std::shared_ptr<::Assets::DependencyValidation>& GetDependencyValidation() const { return _depVal; }
 
         ImportConfiguration(const ::Assets::ResChar filename[]);
@@ -58,6 +71,10 @@ namespace RenderCore { namespace ColladaConversion
         BindingConfig _resourceBindings;
         BindingConfig _constantsBindings;
         BindingConfig _vertexSemanticBindings;
+        unsigned _clusterTriangleCount;
+        Assets::GeoProc::QuantizationSettings _quantization;
+        bool _weldVertices;
+        Assets::GeoProc::WeldingSettings _welding;
 
         std::shared_ptr<::Assets::DependencyValidation> _depVal;
     };
@@ -39,7 +39,7 @@ namespace RenderCore { namespace ColladaConversion
 {
     using namespace ::ColladaConversion;
 
-    static const unsigned ModelScaffoldVersion = 1;
+    static const unsigned ModelScaffoldVersion = 4;
     static const unsigned ModelScaffoldLargeBlocksVersion = 0;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -62,7 +62,7 @@ namespace RenderCore { namespace ColladaConversion
         std::shared_ptr<ColladaScaffold> result(new ColladaScaffold, &DestroyModel);
 
         result->_cfg = ImportConfiguration("colladaimport.cfg");
-        result->_fileData = MemoryMappedFile(identifier, 0, MemoryMappedFile::Access::Read, BasicFile::ShareMode::Read);
+        result->_fileData = MemoryMappedFile(identifier, 0, MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Sequential, BasicFile::ShareMode::Read);
         if (!result->_fileData.IsValid())
             Throw(::Exceptions::BasicLabel("Error opening file for read (%s)", identifier));
 
@@ -422,6 +422,9 @@ namespace RenderCore { namespace ColladaConversion
                 { unsigned(_indexFormat), unsigned(ibOffset), unsigned(ibSize) });
 
         ::Serialize(outputSerializer, _mainDrawCalls);
+        ::Serialize(outputSerializer, std::vector<RenderCore::Assets::DrawCallCluster>());   // (no clusters for skinned geometry, because the vertices move)
+        ::Serialize(outputSerializer, Identity<Float4x4>());    // (skinned geometry is never quantized)
+        ::Serialize(outputSerializer, Float4(1.f, 1.f, 0.f, 0.f));
 
             // append skinning related information
         ::Serialize(
@@ -29,6 +29,8 @@ namespace RenderCore { namespace ColladaConversion
     ,       _indexFormat(indexFormat)
     ,       _unifiedVertexIndexToPositionIndex(std::forward<DynamicArray<uint32>>(unifiedVertexIndexToPositionIndex))
     ,       _matBindingSymbols(std::forward<std::vector<uint64>>(matBindingSymbols))
+    ,       _geoSpaceToNodeSpace(Identity<Float4x4>())
+    ,       _texCoordScaleOffset(1.f, 1.f, 0.f, 0.f)
     {
     }
 
@@ -38,6 +40,9 @@ namespace RenderCore { namespace ColladaConversion
     ,       _mainDrawInputAssembly(std::move(moveFrom._mainDrawInputAssembly))
     ,       _indexFormat(moveFrom._indexFormat)
     ,       _mainDrawCalls(std::move(moveFrom._mainDrawCalls))
+    ,       _clusters(std::move(moveFrom._clusters))
+    ,       _geoSpaceToNodeSpace(moveFrom._geoSpaceToNodeSpace)
+    ,       _texCoordScaleOffset(moveFrom._texCoordScaleOffset)
     ,       _unifiedVertexIndexToPositionIndex(std::move(moveFrom._unifiedVertexIndexToPositionIndex))
     ,       _matBindingSymbols(std::move(moveFrom._matBindingSymbols))
     {
@@ -50,6 +55,9 @@ namespace RenderCore { namespace ColladaConversion
         _mainDrawInputAssembly = std::move(moveFrom._mainDrawInputAssembly);
         _indexFormat = moveFrom._indexFormat;
         _mainDrawCalls = std::move(moveFrom._mainDrawCalls);
+        _clusters = std::move(moveFrom._clusters);
+        _geoSpaceToNodeSpace = moveFrom._geoSpaceToNodeSpace;
+        _texCoordScaleOffset = moveFrom._texCoordScaleOffset;
         _unifiedVertexIndexToPositionIndex = std::move(moveFrom._unifiedVertexIndexToPositionIndex);
         _matBindingSymbols = std::move(moveFrom._matBindingSymbols);
         return *this;
@@ -59,6 +67,8 @@ namespace RenderCore { namespace ColladaConversion
     : _vertices(nullptr, 0)
     , _indices(nullptr, 0)
     , _unifiedVertexIndexToPositionIndex(nullptr, 0)
+    , _geoSpaceToNodeSpace(Identity<Float4x4>())
+    , _texCoordScaleOffset(1.f, 1.f, 0.f, 0.f)
     {
         _indexFormat = Metal::NativeFormat::Unknown;
     }
@@ -90,6 +100,9 @@ namespace RenderCore { namespace ColladaConversion
                 { unsigned(_indexFormat), unsigned(ibOffset), unsigned(ibSize) });
         
         ::Serialize(outputSerializer, _mainDrawCalls);
+        ::Serialize(outputSerializer, _clusters);
+        ::Serialize(outputSerializer, _geoSpaceToNodeSpace);
+        ::Serialize(outputSerializer, _texCoordScaleOffset);
     }
 
     std::ostream& StreamOperator(std::ostream& stream, const NascentRawGeometry& geo)
@@ -103,6 +116,8 @@ namespace RenderCore { namespace ColladaConversion
         for(const auto& dc:geo._mainDrawCalls) {
             stream << "Draw [" << c++ << "] " << dc << std::endl;
         }
+        if (!geo._clusters.empty())
+            stream << "Clusters: " << geo._clusters.size() << std::endl;
         
         stream << "Material binding: ";
         for (size_t q=0; q<geo._matBindingSymbols.size(); ++q) {
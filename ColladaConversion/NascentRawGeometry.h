@@ -17,6 +17,7 @@ namespace RenderCore { namespace ColladaConversion
 {
     using GeoInputAssembly = RenderCore::Assets::GeoInputAssembly;
     using DrawCallDesc = RenderCore::Assets::DrawCallDesc;
+    using DrawCallCluster = RenderCore::Assets::DrawCallCluster;
     using NativeFormatPlaceholder = RenderCore::Assets::NativeFormatPlaceholder;
 
         ////////////////////////////////////////////////////////
@@ -45,6 +46,9 @@ namespace RenderCore { namespace ColladaConversion
         GeoInputAssembly            _mainDrawInputAssembly;
         NativeFormatPlaceholder     _indexFormat;
         std::vector<DrawCallDesc>   _mainDrawCalls;
+        std::vector<DrawCallCluster> _clusters;         // (optional)
+        Float4x4                    _geoSpaceToNodeSpace;   // dequantization for quantized vertex positions
+        Float4                      _texCoordScaleOffset;   // dequantization for quantized texture coordinates
         std::vector<uint64>         _matBindingSymbols;
 
             //  Only required during processing
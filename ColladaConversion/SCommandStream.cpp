@@ -18,6 +18,7 @@
 #include "ScaffoldParsingUtil.h"    // for AsString
 #include "ConversionUtil.h"
 #include "../RenderCore/Assets/Material.h"  // for MakeMaterialGuid
+#include "../Math/Transformations.h"
 #include "../Utility/MemoryUtils.h"
 #include "../Utility/StringFormat.h"
 #include "ConversionCore.h"
@@ -364,6 +365,18 @@ namespace RenderCore { namespace ColladaConversion
             geo, outputTransformIndex, std::move(materials), levelOfDetail);
     }
 
+    static bool IsQuantized(const NascentRawGeometry& geo)
+    {
+        for (const auto& e:geo._mainDrawInputAssembly._elements) {
+            auto format = Metal::NativeFormat::Enum(e._nativeFormat);
+            auto type = Metal::GetComponentType(format);
+            if (    (type == Metal::FormatComponentType::UNorm || type == Metal::FormatComponentType::SNorm)
+                &&  Metal::GetComponentPrecision(format) == 16)
+                return true;
+        }
+        return false;
+    }
+
     static DynamicArray<uint16> BuildJointArray(
         const GuidReference skeletonRef,
         const UnboundSkinController& unboundController,
@@ -434,18 +447,23 @@ namespace RenderCore { namespace ColladaConversion
             // If the the raw geometry object is already converted, then we should use it. Otherwise
             // we need to do the conversion (but store it only in a temporary -- we don't need to
             // write it to disk)
+            //
+            // Skinning requires full precision vertex data, so if the existing raw geometry
+            // has been quantized, we must also convert it again. Likewise if it may have been
+            // welded across position indices (which would scramble the skin weights).
+        const bool weldedAcrossPositions = cfg.GetWeldVertices() && !cfg.GetWeldingSettings()._matchPositionIndices;
         NascentRawGeometry* source = nullptr;
         NascentRawGeometry tempBuffer;
         {
             auto geo = objects.GetGeo(controller._sourceRef);
-            if (geo == ~unsigned(0x0)) {
+            if (geo == ~unsigned(0x0) || weldedAcrossPositions || IsQuantized(objects._rawGeos[geo].second)) {
                 auto* scaffoldGeo = FindElement(
                     GuidReference(controller._sourceRef._objectId, controller._sourceRef._fileId),
                     resolveContext, &IDocScopeIdResolver::FindMeshGeometry);
                 if (!scaffoldGeo)
                     Throw(::Assets::Exceptions::FormatError("Could not find geometry object to instantiate (%s)",
                         AsString(instGeo._reference).c_str()));
-                tempBuffer = Convert(*scaffoldGeo, Identity<Float4x4>(), resolveContext, cfg);
+                tempBuffer = Convert(*scaffoldGeo, Identity<Float4x4>(), resolveContext, cfg, true);
                 source = &tempBuffer;
             } else {
                 source = &objects._rawGeos[geo].second;
@@ -515,6 +533,7 @@ namespace RenderCore { namespace ColladaConversion
             Float4x4 localToWorld = Identity<Float4x4>();
             if (inst._localToWorldId < transforms.size())
                 localToWorld = transforms[inst._localToWorldId];
+            localToWorld = Combine(geo->_geoSpaceToNodeSpace, localToWorld);    // (dequantize positions)
 
             const void*         vertexBuffer = geo->_vertices.get();
             const unsigned      vertexStride = geo->_mainDrawInputAssembly._vertexStride;
@@ -14,11 +14,15 @@
 #include "GeometryAlgorithm.h"
 #include "ConversionUtil.h"
 #include "../RenderCore/Assets/MeshDatabase.h"
+#include "../RenderCore/Assets/DrawCallClusters.h"
 #include "../RenderCore/Assets/AssetUtils.h"
 #include "../RenderCore/Metal/DeviceContext.h"      // for Topology...!
 #include "../ConsoleRig/Log.h"
+#include "../ConsoleRig/GlobalServices.h"
 #include "../Utility/MemoryUtils.h"
 #include "../Utility/IteratorUtils.h"
+#include "../Utility/TimeUtils.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
 #include <map>
 #include <set>
 
@@ -35,6 +39,9 @@ namespace ColladaConversion
 
     const NativeVBSettings NativeSettings = { true };       // use 16 bit floats
 
+        //  Welding smaller meshes isn't worth the cost of scheduling tasks on the pool
+    static const size_t WeldOnThreadPoolVertexCount = 64*1024;
+
     std::shared_ptr<std::vector<uint8>> GetParseDataSource();
 
     class VertexSourceData : public IVertexSourceData
@@ -547,7 +554,8 @@ namespace ColladaConversion
         const MeshGeometry& mesh, 
         const Float4x4& mergedTransform,
         const URIResolveContext& pubEles, 
-        const ImportConfiguration& cfg)
+        const ImportConfiguration& cfg,
+        bool skinned)
     {
             // some exports can have empty meshes -- ideally, we just want to ignore them
         if (!mesh.GetPrimitivesCount()) {
@@ -832,6 +840,106 @@ namespace ColladaConversion
         if (constant_expression<removeRedundantBitangents>::result())
             RemoveRedundantBitangents(*database);
 
+            //  Optionally weld together vertices that are equal within a small tolerance. Exporters
+            //  often write separate copies of the same vertex (eg, one for each face), and those
+            //  copies aren't caught by the index based unification above. Welding only ever reduces
+            //  the vertex count, so the index format chosen above remains valid.
+            //  Skin weights are bound by position index, so skinned geometry may only weld
+            //  vertices that share a position index.
+        if (cfg.GetWeldVertices()) {
+            const auto startTime = GetPerformanceCounter();
+            const auto originalVertexCount = database->GetUnifiedVertexCount();
+
+            auto settings = cfg.GetWeldingSettings();
+            if (skinned) settings._matchPositionIndices = true;
+
+            CompletionThreadPool* pool = nullptr;
+            if (originalVertexCount >= WeldOnThreadPoolVertexCount)
+                pool = &ConsoleRig::GlobalServices::GetLongTaskThreadPool();
+
+            std::vector<unsigned> weldMapping;
+            WeldVertices(weldMapping, *database, settings, pool);
+
+            if (database->GetUnifiedVertexCount() < originalVertexCount) {
+                if (indexFormat == Metal::NativeFormat::R16_UINT) {
+                    auto* indices = (uint16*)finalIndexBuffer.get();
+                    for (size_t c=0; c<finalIndexCount; ++c) indices[c] = (uint16)weldMapping[indices[c]];
+                } else {
+                    auto* indices = (uint32*)finalIndexBuffer.get();
+                    for (size_t c=0; c<finalIndexCount; ++c) indices[c] = weldMapping[indices[c]];
+                }
+            }
+
+            LogInfo 
+                << "Welded " << originalVertexCount << " vertices into " << database->GetUnifiedVertexCount() 
+                << " in " << float(double(GetPerformanceCounter() - startTime) * 1000.0 / double(GetPerformanceCounterFrequency())) 
+                << "ms (geometry: " << mesh.GetName() << ")";
+        }
+
+            //  Optionally split the draw calls into small clusters of triangles, so they can be
+            //  culled individually at runtime. This reorders the triangles within each draw call,
+            //  so it must happen after all of the other index buffer processing.
+        std::vector<DrawCallCluster> clusters;
+        const auto clusterTriangleCount = cfg.GetClusterTriangleCount();
+        if (clusterTriangleCount && database->HasElement("POSITION")) {
+            const auto startTime = GetPerformanceCounter();
+
+            auto posElement = database->FindElement("POSITION");
+            std::vector<Float3> positions;
+            positions.reserve(database->GetUnifiedVertexCount());
+            for (size_t v=0; v<database->GetUnifiedVertexCount(); ++v)
+                positions.push_back(database->GetUnifiedElement<Float3>(v, posElement));
+
+            clusters = BuildDrawCallClusters(
+                finalIndexBuffer.get(), indexFormat,
+                MakeIteratorRange(finalDrawOperations), MakeIteratorRange(positions),
+                clusterTriangleCount);
+
+            LogInfo 
+                << "Built " << clusters.size() << " draw call clusters in " 
+                << float(double(GetPerformanceCounter() - startTime) * 1000.0 / double(GetPerformanceCounterFrequency())) 
+                << "ms (geometry: " << mesh.GetName() << ")";
+        }
+
+            //  Quantize the vertex streams into compact formats. Each stream is only quantized
+            //  if the measured error is within the tolerance given in the import configuration.
+            //  Quantized positions are relative to the bounding box of the mesh, so we must store
+            //  the transform that takes them back into the original space (and likewise for the
+            //  range of the texture coordinates).
+        auto geoSpaceToNodeSpace = Identity<Float4x4>();
+        Float4 texCoordScaleOffset(1.f, 1.f, 0.f, 0.f);
+        const auto& quantizationSettings = cfg.GetQuantizationSettings();
+        if (    !skinned
+            && (quantizationSettings._positions || quantizationSettings._normals || quantizationSettings._texCoords)) {
+
+            const auto startTime = GetPerformanceCounter();
+            const auto vertexCount = database->GetUnifiedVertexCount();
+            const auto originalStride = BuildDefaultLayout(*database, NativeSettings)._vertexStride;
+
+            auto quantization = QuantizeVertexStreams(*database, quantizationSettings);
+            for (const auto& s:quantization._streams) {
+                if (s._quantized) {
+                    LogInfo 
+                        << "Quantized " << s._semanticName << "[" << s._semanticIndex << "] to " 
+                        << Metal::AsString(s._format) << " (max error: " << s._maxError 
+                        << ") (geometry: " << mesh.GetName() << ")";
+                } else {
+                    LogWarning 
+                        << "Not quantizing " << s._semanticName << "[" << s._semanticIndex << "] because the error (" 
+                        << s._maxError << ") exceeds the tolerance (geometry: " << mesh.GetName() << ")";
+                }
+            }
+            geoSpaceToNodeSpace = quantization._geoSpaceToNodeSpace;
+            texCoordScaleOffset = quantization._texCoordScaleOffset;
+
+            const auto quantizedStride = BuildDefaultLayout(*database, NativeSettings)._vertexStride;
+            LogInfo 
+                << "Quantized vertex buffer from " << originalStride * vertexCount << " bytes to " 
+                << quantizedStride * vertexCount << " bytes (vertex stride " << originalStride << " -> " << quantizedStride << ") in "
+                << float(double(GetPerformanceCounter() - startTime) * 1000.0 / double(GetPerformanceCounterFrequency())) 
+                << "ms (geometry: " << mesh.GetName() << ")";
+        }
+
         NativeVBLayout vbLayout = BuildDefaultLayout(*database, NativeSettings);
         auto nativeVB = database->BuildNativeVertexBuffer(vbLayout);
 
@@ -848,7 +956,7 @@ namespace ColladaConversion
             //      Create the final RawGeometry object with all this stuff
             //
 
-        return NascentRawGeometry(
+        NascentRawGeometry result(
             std::move(nativeVB), 
             DynamicArray<uint8>(std::move(finalIndexBuffer), finalIndexBufferSize),
             RenderCore::Assets::CreateGeoInputAssembly(vbLayout._elements, (unsigned)vbLayout._vertexStride),
@@ -856,6 +964,10 @@ namespace ColladaConversion
             std::move(finalDrawOperations),
             DynamicArray<uint32>(std::move(unifiedVertexIndexToPositionIndex), database->GetUnifiedVertexCount()),
             std::vector<uint64>(matBindingSymbols.cbegin(), matBindingSymbols.cend()));
+        result._clusters = std::move(clusters);
+        result._geoSpaceToNodeSpace = geoSpaceToNodeSpace;
+        result._texCoordScaleOffset = texCoordScaleOffset;
+        return std::move(result);
     }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1264,23 +1376,34 @@ namespace ColladaConversion
             vIterator.GetNextInfluences(influenceCount, jointIndices, weights);
 
             const float minWeightThreshold = 8.f / 255.f;
-            float totalWeightValue = 0.f;
             for (size_t c=0; c<influenceCount;) {
                 if (weights[c] < minWeightThreshold) {
                     std::move(&weights[c+1],        &weights[influenceCount],       &weights[c]);
                     std::move(&jointIndices[c+1],   &jointIndices[influenceCount],  &jointIndices[c]);
                     --influenceCount;
                 } else {
-                    totalWeightValue += weights[c];
                     ++c;
                 }
             }
 
-            uint8 normalizedWeights[AbsoluteMaxJointInfluenceCount];
-            for (size_t c=0; c<influenceCount; ++c) {
-                normalizedWeights[c] = (uint8)(Clamp(weights[c] / totalWeightValue, 0.f, 1.f) * 255.f + .5f);
+                //  Sort by weight, so that if there are too many influences we will
+                //  keep the strongest ones (and renormalize the weights across those)
+            const size_t maxInfluences = 4;
+            size_t originalInfluenceCount = influenceCount;
+            if (influenceCount > maxInfluences) {
+                for (size_t c=0; c<maxInfluences; ++c) {
+                    auto strongest = size_t(std::max_element(&weights[c], &weights[influenceCount]) - weights);
+                    std::swap(weights[c], weights[strongest]);
+                    std::swap(jointIndices[c], jointIndices[strongest]);
+                }
+                influenceCount = maxInfluences;
             }
 
+                //  The quantized weights always sum to exactly 255 (so there's no drift
+                //  in the skinned position caused by rounding)
+            uint8 normalizedWeights[AbsoluteMaxJointInfluenceCount];
+            QuantizeWeights(normalizedWeights, weights, (unsigned)influenceCount);
+
                 //
                 // \todo -- should we sort influcences by the strength of the influence, or by the joint
                 //          index?
@@ -1299,13 +1422,13 @@ namespace ColladaConversion
             #endif
 
             if (influenceCount >= 3) {
-                if (influenceCount > 4) {
+                if (originalInfluenceCount > maxInfluences) {
                     LogAlwaysWarning 
                         << "Warning -- Exceeded maximum number of joints affecting a single vertex in skinning controller " 
                         << controller.GetLocation() 
                         << ". Only 4 joints can affect any given single vertex.";
 
-                        // (When this happens, only use the first 4, and ignore the others)
+                        // (When this happens, only the strongest 4 are used, and the others are ignored)
                     LogAlwaysWarningF("After filtering:\n");
                     for (size_t c=0; c<influenceCount; ++c) {
                         LogAlwaysWarningF("  [%i] Weight: %i Joint: %i", c, normalizedWeights[c], jointIndices[c]);
@@ -21,7 +21,10 @@ namespace ColladaConversion
     class SkinController;
     class URIResolveContext;
 
-    auto Convert(const MeshGeometry& mesh, const Float4x4& mergedTransform, const URIResolveContext& pubEles, const RenderCore::ColladaConversion::ImportConfiguration& cfg)
+        //  "skinned" should be true when the geometry will be skinned. Skinning requires full
+        //  precision vertex data, so quantization is disabled. And skin weights are bound by
+        //  position index, so welding won't combine vertices with different position indices.
+    auto Convert(const MeshGeometry& mesh, const Float4x4& mergedTransform, const URIResolveContext& pubEles, const RenderCore::ColladaConversion::ImportConfiguration& cfg, bool skinned = false)
         -> RenderCore::ColladaConversion::NascentRawGeometry;
 
     auto Convert(const SkinController& controller, const URIResolveContext& pubEles, const RenderCore::ColladaConversion::ImportConfiguration& cfg)
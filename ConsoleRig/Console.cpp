@@ -6,13 +6,13 @@
 
 #include "Console.h"
 #include "../Utility/PtrUtils.h"
-#include "../../Utility/Mixins.h"
-#include "../../Utility/StringFormat.h"
-#include "../../Utility/StringUtils.h"
-#include "../../Utility/MemoryUtils.h"
-#include "../../Utility/IteratorUtils.h"
-#include "../../Core/Exceptions.h"
-#include "../../Math/Vector.h"
+#include "../Utility/Mixins.h"
+#include "../Utility/StringFormat.h"
+#include "../Utility/StringUtils.h"
+#include "../Utility/MemoryUtils.h"
+#include "../Utility/IteratorUtils.h"
+#include "../Core/Exceptions.h"
+#include "../Math/Vector.h"
 #include <iterator>
 #include <algorithm>
 
@@ -21,7 +21,6 @@
 
     #include <lua.hpp>
     #include <LuaBridge.h>
-    #include <RefCountedPtr.h>
 
 #if defined(DEBUG_NEW)
     #define new DEBUG_NEW
@@ -626,7 +625,7 @@ namespace ConsoleRig
                 T*t = (T*)lua_touserdata(L, lua_upvalueindex(1));
 
                 assert (lua_isuserdata (L, lua_upvalueindex (2)));
-                MemFn fp = static_cast<MemFn>(lua_touserdata(L, lua_upvalueindex (2)));
+                MemFn fp = reinterpret_cast<MemFn>(lua_touserdata(L, lua_upvalueindex (2)));
 
                 assert (fp != 0);
                 ArgList<Params> args (L);
@@ -664,7 +663,7 @@ namespace ConsoleRig
         rawgetfield (L, -1, "__propget");
         assert (lua_istable (L, -1));
         lua_pushlightuserdata(L, this);
-        lua_pushlightuserdata(L, get);
+        lua_pushlightuserdata(L, (void*)get);
         lua_pushcclosure(L, &Detail::ConsoleVariable_CallFunction<Type, decltype(get)>::Call, 2);
         rawsetfield(L, -2, name.c_str());
         lua_pop(L, 1);
@@ -673,7 +672,7 @@ namespace ConsoleRig
         rawgetfield(L, -1, "__propset");
         assert(lua_istable(L, -1));
         lua_pushlightuserdata(L, this);
-        lua_pushlightuserdata(L, set);
+        lua_pushlightuserdata(L, (void*)set);
         lua_pushcclosure(L, &Detail::ConsoleVariable_CallFunction<Type, decltype(set)>::Call, 2);
         rawsetfield(L, -2, name.c_str());
         lua_pop(L, 1);
@@ -732,12 +731,12 @@ namespace ConsoleRig
     }
 
 
-    template ConsoleVariable<int>;
-    template ConsoleVariable<float>;
-    template ConsoleVariable<std::string>;
-    template ConsoleVariable<bool>;
-    template ConsoleVariable<Float3>;
-    template ConsoleVariable<Float4>;
+    template class ConsoleVariable<int>;
+    template class ConsoleVariable<float>;
+    template class ConsoleVariable<std::string>;
+    template class ConsoleVariable<bool>;
+    template class ConsoleVariable<Float3>;
+    template class ConsoleVariable<Float4>;
 
 
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../Utility/UTFUtils.h"
+#include "../Utility/Mixins.h"
 #include <string>
 #include <vector>
 #include <memory>
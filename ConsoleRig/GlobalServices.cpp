@@ -36,7 +36,11 @@ namespace ConsoleRig
 
         XlGetProcessPath    (appPath, dimof(appPath));
         XlDirname           (appDir, dimof(appDir), appPath);
-        const auto* fn = a2n("..\\Working");
+        #if PLATFORMOS_ACTIVE == PLATFORMOS_WINDOWS
+            const auto* fn = a2n("..\\Working");
+        #else
+            const auto* fn = (const nchar_t*)a2n("../Working");
+        #endif
         XlConcatPath        (workingDir, (int)workingDirSize, appDir, fn, XlStringEnd(fn));
     }
 
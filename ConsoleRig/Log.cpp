@@ -284,7 +284,7 @@ namespace ConsoleRig
     {
         auto storage = el::Helpers::storage();
         if (storage) {
-            std::string guid = StringMeld<64>() << _guid;
+            std::string guid = (StringMeld<64>() << _guid).get();
             auto* helper = storage->logDispatchCallback<Internal::LogHelper>(guid);
             if (!helper) {
                 storage->installLogDispatchCallback<Internal::LogHelper>(guid);
@@ -414,6 +414,8 @@ namespace LogUtilMethods
 }
 
 
+#if PLATFORMOS_TARGET == PLATFORMOS_WINDOWS
+
 #include "../Core/WinAPI/IncludeWindows.h"
 
 namespace el { namespace base { namespace utils
@@ -446,3 +448,21 @@ namespace el { namespace base { namespace utils
     }
 #endif // _ELPP_OS_WINDOWS
 }}}
+
+#else
+
+#include <sys/time.h>
+
+namespace el { namespace base { namespace utils
+{
+    void DateTime::gettimeofday(struct timeval *tv) {
+        if (tv != nullptr) {
+            ::timeval present;
+            ::gettimeofday(&present, nullptr);
+            tv->tv_sec = static_cast<long>(present.tv_sec);
+            tv->tv_usec = static_cast<long>(present.tv_usec);
+        }
+    }
+}}}
+
+#endif
@@ -6,14 +6,15 @@
 
 #include "OutputStream.h"
 #include "Console.h"
-#include "../../Utility/Streams/Stream.h"
-#include "../../Utility/MemoryUtils.h"
-#include "../../Utility/PtrUtils.h"
-#include "../../Utility/StringUtils.h"
-#include "../../Utility/StringFormat.h"
-#include "../../Utility/Conversion.h"
+#include "../Utility/Streams/Stream.h"
+#include "../Utility/MemoryUtils.h"
+#include "../Utility/PtrUtils.h"
+#include "../Utility/StringUtils.h"
+#include "../Utility/StringFormat.h"
+#include "../Utility/Conversion.h"
 #include <assert.h>
 #include <algorithm>
+#include <stdio.h>
 
 #if PLATFORMOS_ACTIVE == PLATFORMOS_WINDOWS
     extern "C" dll_import void __stdcall OutputDebugStringA(const char lpOutputString[]);
@@ -307,6 +308,30 @@ namespace ConsoleRig
         DebuggerConsoleOutput::DebuggerConsoleOutput()  {}
         DebuggerConsoleOutput::~DebuggerConsoleOutput() {}
 
+    #else
+
+            ////    D E B U G   C O N S O L E   O U T P U T   ////
+
+            //  There's no debugger output window here, so this just goes to stderr
+        class DebuggerConsoleOutput : public Utility::OutputStream
+        {
+        public:
+            virtual size_type   Tell()                          { return ~size_type(0x0); }
+            virtual void        Write(const void* p, size_type len) { fwrite(p, 1, size_t(len), stderr); }
+            virtual void    WriteChar(utf8 ch)                  { fputc(ch, stderr); }
+            virtual void    WriteChar(ucs2 ch)                  { Write(StringSection<ucs2>(&ch, &ch+1)); }
+            virtual void    WriteChar(ucs4 ch)                  { Write(StringSection<ucs4>(&ch, &ch+1)); }
+
+            virtual void    Write(StringSection<utf8> str)      { Write(str.begin(), str.end()-str.begin()); }
+            virtual void    Write(StringSection<ucs2> str)      { Write(MakeStringSection(Conversion::Convert<std::basic_string<utf8>>(str.AsString()))); }
+            virtual void    Write(StringSection<ucs4> str)      { Write(MakeStringSection(Conversion::Convert<std::basic_string<utf8>>(str.AsString()))); }
+
+            virtual void    Flush()                             { fflush(stderr); }
+
+            DebuggerConsoleOutput() {}
+            virtual ~DebuggerConsoleOutput() {}
+        };
+
     #endif
 
 
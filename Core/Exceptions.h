@@ -102,7 +102,7 @@ namespace Utility
             }
 
             template <class E, typename std::enable_if<std::is_base_of<::Exceptions::BasicLabel, E>::value>::type* = nullptr>
-                inline __declspec(noreturn) void Throw(const E& e)
+                inline never_returns void Throw(const E& e)
             {
                 auto* callback = GlobalOnThrowCallback();
                 if (callback) (*callback)(e);
@@ -110,7 +110,7 @@ namespace Utility
             }
 
             template <class E, typename std::enable_if<!std::is_base_of<::Exceptions::BasicLabel, E>::value>::type* = nullptr>
-                inline __declspec(noreturn) void Throw(const E& e)
+                inline never_returns void Throw(const E& e)
             {
                 throw e;
             }
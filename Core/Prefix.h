@@ -11,6 +11,7 @@
 #if COMPILER_ACTIVE == COMPILER_TYPE_MSVC
 
     #define never_throws    throw()
+    #define never_returns   __declspec(noreturn)
     #define force_inline    __forceinline
     #define dll_export      __declspec(dllexport)
     #define dll_import      __declspec(dllimport)
@@ -22,7 +23,8 @@
 #elif COMPILER_ACTIVE == COMPILER_TYPE_GCC
 
     #define never_throws    noexcept
-    #define force_inline    __attribute__(( always_inline ))
+    #define never_returns   __attribute__(( noreturn ))
+    #define force_inline    inline __attribute__(( always_inline ))
 
     #if PLATFORMOS_ACTIVE == PLATFORMOS_ANDROID 
             // no dll export/import on android?
@@ -35,6 +37,23 @@
 
 #endif
 
+#if CLIBRARIES_ACTIVE == CLIBRARIES_GCC
+
+        //  GCC versions of the MSVC "secure" CRT functions used in this tree
+        //  (only the forms with a fixed size array and _TRUNCATE are used)
+    #include <stdio.h>
+    #include <stdarg.h>
+
+    #define _TRUNCATE   ((size_t)-1)
+
+    template<size_t Count>
+        inline int _vsnprintf_s(char (&buffer)[Count], size_t, const char format[], va_list args)
+        {
+            return vsnprintf(buffer, Count, format, args);
+        }
+
+#endif
+
 #pragma warning(disable:4481)   //  warning C4481: nonstandard extension used: override specifier 'override'
 
 #if !defined(dimof)
@@ -5,6 +5,24 @@
 // http://www.opensource.org/licenses/mit-license.php)
 
 #include "Noise.h"
+#include "../Utility/SystemUtils.h"
+#include "../Core/SelectConfiguration.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #define NOISE_SSE2 1
+    #include <emmintrin.h>
+        //  (gcc only accepts AVX2 intrinsics when compiling for AVX2)
+    #if COMPILER_ACTIVE == COMPILER_TYPE_MSVC || defined(__AVX2__)
+        #define NOISE_AVX2 1
+        #include <immintrin.h>
+    #else
+        #define NOISE_AVX2 0
+    #endif
+#else
+    #define NOISE_SSE2 0
+    #define NOISE_AVX2 0
+#endif
 
 // adapted from Stefan Gustavson's java implementation
 //      http://webstaff.itn.liu.se/~stegu/simplexnoise/SimplexNoise.java
@@ -397,5 +415,590 @@ namespace XLEMath
     template float SimplexFBM(Float2, float, float, float, int);
     template float SimplexFBM(Float3, float, float, float, int);
     template float SimplexFBM(Float4, float, float, float, int);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+            //   B A T C H E D   N O I S E
+
+            //
+            //      The batched functions do the same calculations as the single point
+            //      functions above, in the same order, but on several lanes at once. The
+            //      kernels are written once as templates over a "lanes" class, so the SSE2
+            //      and AVX2 versions do exactly the same operations. The only difference
+            //      between them is the number of lanes (and AVX2 uses gathers for the table
+            //      lookups, which doesn't change the results).
+            //
+            //      Positions are processed in chunks, with the coordinates rearranged into
+            //      separate x, y, z, w arrays. The octave loops for the FBM variants run on
+            //      whole chunks, with the same code for every instruction set.
+            //
+
+    class BatchTables
+    {
+    public:
+        int     _perm[512];
+        int     _permMod12[512];
+        float   _grad3[3][12];
+        float   _grad4[4][32];
+
+        BatchTables()
+        {
+            for (int i=0; i<512; i++) {
+                _perm[i] = p[i & 255];
+                _permMod12[i] = _perm[i] % 12;
+            }
+            for (unsigned c=0; c<12; ++c) {
+                _grad3[0][c] = grad3[c].x; _grad3[1][c] = grad3[c].y; _grad3[2][c] = grad3[c].z;
+            }
+            for (unsigned c=0; c<32; ++c) {
+                _grad4[0][c] = grad4[c].x; _grad4[1][c] = grad4[c].y;
+                _grad4[2][c] = grad4[c].z; _grad4[3][c] = grad4[c].w;
+            }
+        }
+    };
+
+    static const BatchTables& GetBatchTables()
+    {
+        static BatchTables tables;
+        return tables;
+    }
+
+    namespace Internal
+    {
+        class NoiseImplementation
+        {
+        public:
+            typedef void (*EvaluateFn)(float dst[], const float* const pos[], size_t count, const BatchTables& tables);
+            EvaluateFn  _evaluate[3];       // for 2, 3 and 4 dimensions. "count" must be a multiple of 8
+        };
+    }
+
+#if NOISE_SSE2
+
+    class Lanes4
+    {
+    public:
+        static const unsigned Count = 4;
+        typedef __m128 F;
+        typedef __m128i I;
+
+        static F    Load(const float* p)            { return _mm_loadu_ps(p); }
+        static void Store(float* p, F v)            { _mm_storeu_ps(p, v); }
+        static F    Set(float v)                    { return _mm_set1_ps(v); }
+        static I    SetI(int v)                     { return _mm_set1_epi32(v); }
+
+        static F    Add(F a, F b)                   { return _mm_add_ps(a, b); }
+        static F    Sub(F a, F b)                   { return _mm_sub_ps(a, b); }
+        static F    Mul(F a, F b)                   { return _mm_mul_ps(a, b); }
+        static I    AddI(I a, I b)                  { return _mm_add_epi32(a, b); }
+        static I    SubI(I a, I b)                  { return _mm_sub_epi32(a, b); }
+        static I    AndI(I a, I b)                  { return _mm_and_si128(a, b); }
+        static I    CmpGTI(I a, I b)                { return _mm_cmpgt_epi32(a, b); }
+
+        static F    CmpLT(F a, F b)                 { return _mm_cmplt_ps(a, b); }
+        static F    CmpGT(F a, F b)                 { return _mm_cmpgt_ps(a, b); }
+        static F    CmpGE(F a, F b)                 { return _mm_cmpge_ps(a, b); }
+        static F    And(F a, F b)                   { return _mm_and_ps(a, b); }
+        static F    Or(F a, F b)                    { return _mm_or_ps(a, b); }
+        static F    Not(F a)                        { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+        static F    ZeroWhere(F mask, F v)          { return _mm_andnot_ps(mask, v); }
+        static I    AsInt(F mask)                   { return _mm_castps_si128(mask); }
+
+        static I    Truncate(F v)                   { return _mm_cvttps_epi32(v); }
+        static F    ToFloat(I v)                    { return _mm_cvtepi32_ps(v); }
+
+        static I    Lookup(const int table[], I index)
+        {
+            int i[4];
+            _mm_storeu_si128((__m128i*)i, index);
+            return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+        }
+
+        static F    Lookup(const float table[], I index)
+        {
+            int i[4];
+            _mm_storeu_si128((__m128i*)i, index);
+            return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+        }
+    };
+
+    #if NOISE_AVX2
+        class Lanes8
+        {
+        public:
+            static const unsigned Count = 8;
+            typedef __m256 F;
+            typedef __m256i I;
+
+            static F    Load(const float* p)            { return _mm256_loadu_ps(p); }
+            static void Store(float* p, F v)            { _mm256_storeu_ps(p, v); }
+            static F    Set(float v)                    { return _mm256_set1_ps(v); }
+            static I    SetI(int v)                     { return _mm256_set1_epi32(v); }
+
+            static F    Add(F a, F b)                   { return _mm256_add_ps(a, b); }
+            static F    Sub(F a, F b)                   { return _mm256_sub_ps(a, b); }
+            static F    Mul(F a, F b)                   { return _mm256_mul_ps(a, b); }
+            static I    AddI(I a, I b)                  { return _mm256_add_epi32(a, b); }
+            static I    SubI(I a, I b)                  { return _mm256_sub_epi32(a, b); }
+            static I    AndI(I a, I b)                  { return _mm256_and_si256(a, b); }
+            static I    CmpGTI(I a, I b)                { return _mm256_cmpgt_epi32(a, b); }
+
+            static F    CmpLT(F a, F b)                 { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+            static F    CmpGT(F a, F b)                 { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+            static F    CmpGE(F a, F b)                 { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+            static F    And(F a, F b)                   { return _mm256_and_ps(a, b); }
+            static F    Or(F a, F b)                    { return _mm256_or_ps(a, b); }
+            static F    Not(F a)                        { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+            static F    ZeroWhere(F mask, F v)          { return _mm256_andnot_ps(mask, v); }
+            static I    AsInt(F mask)                   { return _mm256_castps_si256(mask); }
+
+            static I    Truncate(F v)                   { return _mm256_cvttps_epi32(v); }
+            static F    ToFloat(I v)                    { return _mm256_cvtepi32_ps(v); }
+
+            static I    Lookup(const int table[], I index)      { return _mm256_i32gather_epi32(table, index, 4); }
+            static F    Lookup(const float table[], I index)    { return _mm256_i32gather_ps(table, index, 4); }
+        };
+    #endif
+
+        //  Same as fastfloor() -- truncate, and then step down when that rounded up
+    template<typename L>
+        static typename L::I FastFloor(typename L::F x)
+    {
+        auto xi = L::Truncate(x);
+        return L::SubI(xi, L::AndI(L::AsInt(L::CmpLT(x, L::ToFloat(xi))), L::SetI(1)));
+    }
+
+        //  Converts a comparison mask to 0 or 1
+    template<typename L>
+        static typename L::I MaskToInt(typename L::F mask) { return L::AndI(L::AsInt(mask), L::SetI(1)); }
+
+    template<typename L>
+        static typename L::F MaskToFloat(typename L::F mask) { return L::And(mask, L::Set(1.f)); }
+
+    template<typename L>
+        static typename L::F CornerContribution(
+            const typename L::F pos[], unsigned dims, float radius,
+            const float* const grad[], typename L::I gi)
+    {
+            //  (1) t = radius - x*x - y*y ...
+            //  (2) if t<0, the contribution is zero. Otherwise, t^4 * dot(grad, pos)
+        auto t = L::Sub(L::Set(radius), L::Mul(pos[0], pos[0]));
+        auto dot = L::Mul(L::Lookup(grad[0], gi), pos[0]);
+        for (unsigned c=1; c<dims; ++c) {
+            t = L::Sub(t, L::Mul(pos[c], pos[c]));
+            dot = L::Add(dot, L::Mul(L::Lookup(grad[c], gi), pos[c]));
+        }
+        auto t2 = L::Mul(t, t);
+        return L::ZeroWhere(L::CmpLT(t, L::Set(0.f)), L::Mul(L::Mul(t2, t2), dot));
+    }
+
+    template<typename L>
+        static typename L::F SimplexNoiseLanes(const typename L::F (&input)[2], const BatchTables& tables)
+    {
+        typedef typename L::F F;
+        typedef typename L::I I;
+
+            // Skew the input space to determine which simplex cell we're in
+        auto s = L::Mul(L::Add(input[0], input[1]), L::Set(F2));
+        auto i = FastFloor<L>(L::Add(input[0], s));
+        auto j = FastFloor<L>(L::Add(input[1], s));
+        auto t = L::Mul(L::ToFloat(L::AddI(i, j)), L::Set(G2));
+
+        F p0[2], p1[2], p2[2];
+        p0[0] = L::Sub(input[0], L::Sub(L::ToFloat(i), t));
+        p0[1] = L::Sub(input[1], L::Sub(L::ToFloat(j), t));
+
+            // lower triangle if x0>y0, otherwise upper triangle
+        auto lower = L::CmpGT(p0[0], p0[1]);
+        auto upper = L::Not(lower);
+        p1[0] = L::Add(L::Sub(p0[0], MaskToFloat<L>(lower)), L::Set(G2));
+        p1[1] = L::Add(L::Sub(p0[1], MaskToFloat<L>(upper)), L::Set(G2));
+        p2[0] = L::Add(L::Sub(p0[0], L::Set(1.f)), L::Set(2.f * G2));
+        p2[1] = L::Add(L::Sub(p0[1], L::Set(1.f)), L::Set(2.f * G2));
+
+            // Work out the hashed gradient indices of the three simplex corners
+        auto ii = L::AndI(i, L::SetI(255));
+        auto jj = L::AndI(j, L::SetI(255));
+        auto one = L::SetI(1);
+        I gi0 = L::Lookup(tables._permMod12, L::AddI(ii, L::Lookup(tables._perm, jj)));
+        I gi1 = L::Lookup(tables._permMod12, L::AddI(L::AddI(ii, MaskToInt<L>(lower)), L::Lookup(tables._perm, L::AddI(jj, MaskToInt<L>(upper)))));
+        I gi2 = L::Lookup(tables._permMod12, L::AddI(L::AddI(ii, one), L::Lookup(tables._perm, L::AddI(jj, one))));
+
+        const float* grad[] = { tables._grad3[0], tables._grad3[1] };
+        auto n0 = CornerContribution<L>(p0, 2, 0.5f, grad, gi0);
+        auto n1 = CornerContribution<L>(p1, 2, 0.5f, grad, gi1);
+        auto n2 = CornerContribution<L>(p2, 2, 0.5f, grad, gi2);
+        return L::Mul(L::Set(70.f), L::Add(L::Add(n0, n1), n2));
+    }
+
+    template<typename L>
+        static typename L::F SimplexNoiseLanes(const typename L::F (&input)[3], const BatchTables& tables)
+    {
+        typedef typename L::F F;
+        typedef typename L::I I;
+
+            // Skew the input space to determine which simplex cell we're in
+        auto s = L::Mul(L::Add(L::Add(input[0], input[1]), input[2]), L::Set(F3));
+        auto i = FastFloor<L>(L::Add(input[0], s));
+        auto j = FastFloor<L>(L::Add(input[1], s));
+        auto k = FastFloor<L>(L::Add(input[2], s));
+        auto t = L::Mul(L::ToFloat(L::AddI(L::AddI(i, j), k)), L::Set(G3));
+
+        F p0[3], p1[3], p2[3], p3[3];
+        p0[0] = L::Sub(input[0], L::Sub(L::ToFloat(i), t));
+        p0[1] = L::Sub(input[1], L::Sub(L::ToFloat(j), t));
+        p0[2] = L::Sub(input[2], L::Sub(L::ToFloat(k), t));
+
+            //  Determine which simplex we are in. This gives the same offsets as the
+            //  branches in the single point version:
+            //      i1 = x>=y && (y>=z || x>=z)     i2 = x>=y || (y>=z && x>=z)
+            //      j1 = x<y && y>=z                j2 = x<y || y>=z
+            //      k1 = !(y>=z || (x>=y && x>=z))  k2 = !(y>=z && (x>=y || x>=z))
+        auto xy = L::CmpGE(p0[0], p0[1]);
+        auto yz = L::CmpGE(p0[1], p0[2]);
+        auto xz = L::CmpGE(p0[0], p0[2]);
+        F offset1[3], offset2[3];
+        offset1[0] = L::And(xy, L::Or(yz, xz));
+        offset1[1] = L::And(L::Not(xy), yz);
+        offset1[2] = L::Not(L::Or(yz, L::And(xy, xz)));
+        offset2[0] = L::Or(xy, L::And(yz, xz));
+        offset2[1] = L::Or(L::Not(xy), yz);
+        offset2[2] = L::Not(L::And(yz, L::Or(xy, xz)));
+
+        for (unsigned c=0; c<3; ++c) {
+            p1[c] = L::Add(L::Sub(p0[c], MaskToFloat<L>(offset1[c])), L::Set(G3));
+            p2[c] = L::Add(L::Sub(p0[c], MaskToFloat<L>(offset2[c])), L::Set(2.f*G3));
+            p3[c] = L::Add(L::Sub(p0[c], L::Set(1.f)), L::Set(3.f*G3));
+        }
+
+            // Work out the hashed gradient indices of the four simplex corners
+        I base[3] = { L::AndI(i, L::SetI(255)), L::AndI(j, L::SetI(255)), L::AndI(k, L::SetI(255)) };
+        auto hash = [&tables, &base](I o0, I o1, I o2) -> I
+            {
+                auto h = L::Lookup(tables._perm, L::AddI(base[2], o2));
+                h = L::Lookup(tables._perm, L::AddI(L::AddI(base[1], o1), h));
+                return L::Lookup(tables._permMod12, L::AddI(L::AddI(base[0], o0), h));
+            };
+        auto zero = L::SetI(0), one = L::SetI(1);
+        I gi0 = hash(zero, zero, zero);
+        I gi1 = hash(MaskToInt<L>(offset1[0]), MaskToInt<L>(offset1[1]), MaskToInt<L>(offset1[2]));
+        I gi2 = hash(MaskToInt<L>(offset2[0]), MaskToInt<L>(offset2[1]), MaskToInt<L>(offset2[2]));
+        I gi3 = hash(one, one, one);
+
+        const float* grad[] = { tables._grad3[0], tables._grad3[1], tables._grad3[2] };
+        auto n0 = CornerContribution<L>(p0, 3, 0.6f, grad, gi0);
+        auto n1 = CornerContribution<L>(p1, 3, 0.6f, grad, gi1);
+        auto n2 = CornerContribution<L>(p2, 3, 0.6f, grad, gi2);
+        auto n3 = CornerContribution<L>(p3, 3, 0.6f, grad, gi3);
+        return L::Mul(L::Set(32.f), L::Add(L::Add(L::Add(n0, n1), n2), n3));
+    }
+
+    template<typename L>
+        static typename L::F SimplexNoiseLanes(const typename L::F (&input)[4], const BatchTables& tables)
+    {
+        typedef typename L::F F;
+        typedef typename L::I I;
+
+            // Skew the (x,y,z,w) space to determine which cell of 24 simplices we're in
+        auto s = L::Mul(L::Add(L::Add(L::Add(input[0], input[1]), input[2]), input[3]), L::Set(F4));
+        I cell[4];
+        for (unsigned c=0; c<4; ++c)
+            cell[c] = FastFloor<L>(L::Add(input[c], s));
+        auto t = L::Mul(L::ToFloat(L::AddI(L::AddI(L::AddI(cell[0], cell[1]), cell[2]), cell[3])), L::Set(G4));
+
+        F p0[4];
+        for (unsigned c=0; c<4; ++c)
+            p0[c] = L::Sub(input[c], L::Sub(L::ToFloat(cell[c]), t));
+
+            //  Rank the coordinates by magnitude, with the same pair-wise comparisons
+            //  as the single point version
+        I rank[4] = { L::SetI(0), L::SetI(0), L::SetI(0), L::SetI(0) };
+        for (unsigned a=0; a<4; ++a)
+            for (unsigned b=a+1; b<4; ++b) {
+                auto greater = L::CmpGT(p0[a], p0[b]);
+                rank[a] = L::AddI(rank[a], MaskToInt<L>(greater));
+                rank[b] = L::AddI(rank[b], MaskToInt<L>(L::Not(greater)));
+            }
+
+            //  The corner offsets come from thresholding the ranks (rank 3 denotes the
+            //  largest coordinate). The fifth corner has all coordinate offsets = 1
+        I offsets[3][4];
+        F p[3][4], p4[4];
+        for (unsigned corner=0; corner<3; ++corner)
+            for (unsigned c=0; c<4; ++c) {
+                offsets[corner][c] = L::AndI(L::CmpGTI(rank[c], L::SetI(2-corner)), L::SetI(1));
+                p[corner][c] = L::Add(L::Sub(p0[c], L::ToFloat(offsets[corner][c])), L::Set(float(corner+1)*G4));
+            }
+        for (unsigned c=0; c<4; ++c)
+            p4[c] = L::Add(L::Sub(p0[c], L::Set(1.0f)), L::Set(4.0f*G4));
+
+            // Work out the hashed gradient indices of the five simplex corners
+        I base[4];
+        for (unsigned c=0; c<4; ++c) base[c] = L::AndI(cell[c], L::SetI(255));
+        auto hash = [&tables, &base](const I o[]) -> I
+            {
+                auto h = L::Lookup(tables._perm, L::AddI(base[3], o[3]));
+                h = L::Lookup(tables._perm, L::AddI(L::AddI(base[2], o[2]), h));
+                h = L::Lookup(tables._perm, L::AddI(L::AddI(base[1], o[1]), h));
+                h = L::Lookup(tables._perm, L::AddI(L::AddI(base[0], o[0]), h));
+                return L::AndI(h, L::SetI(31));
+            };
+        const I zero[] = { L::SetI(0), L::SetI(0), L::SetI(0), L::SetI(0) };
+        const I one[] = { L::SetI(1), L::SetI(1), L::SetI(1), L::SetI(1) };
+
+        const float* grad[] = { tables._grad4[0], tables._grad4[1], tables._grad4[2], tables._grad4[3] };
+        auto n0 = CornerContribution<L>(p0, 4, 0.6f, grad, hash(zero));
+        auto n1 = CornerContribution<L>(p[0], 4, 0.6f, grad, hash(offsets[0]));
+        auto n2 = CornerContribution<L>(p[1], 4, 0.6f, grad, hash(offsets[1]));
+        auto n3 = CornerContribution<L>(p[2], 4, 0.6f, grad, hash(offsets[2]));
+        auto n4 = CornerContribution<L>(p4, 4, 0.6f, grad, hash(one));
+        return L::Mul(L::Set(27.f), L::Add(L::Add(L::Add(L::Add(n0, n1), n2), n3), n4));
+    }
+
+    template<typename L, int Dims>
+        static void EvaluateLanes(float dst[], const float* const pos[], size_t count, const BatchTables& tables)
+    {
+        for (size_t c=0; c<count; c+=L::Count) {
+            typename L::F input[Dims];
+            for (int d=0; d<Dims; ++d) input[d] = L::Load(&pos[d][c]);
+            L::Store(&dst[c], SimplexNoiseLanes<L>(input, tables));
+        }
+    }
+
+    #if NOISE_AVX2
+        template<int Dims>
+            static void EvaluateLanes_AVX2(float dst[], const float* const pos[], size_t count, const BatchTables& tables)
+        {
+            EvaluateLanes<Lanes8, Dims>(dst, pos, count, tables);
+            _mm256_zeroupper();
+        }
+    #endif
+
+#else
+
+    template<int Dims>
+        static void EvaluateLanes_Scalar(float dst[], const float* const pos[], size_t count, const BatchTables&)
+    {
+        for (size_t c=0; c<count; ++c) {
+            if (Dims == 2)      dst[c] = SimplexNoise(Float2(pos[0][c], pos[1][c]));
+            else if (Dims == 3) dst[c] = SimplexNoise(Float3(pos[0][c], pos[1][c], pos[2][c]));
+            else                dst[c] = SimplexNoise(Float4(pos[0][c], pos[1][c], pos[2][c], pos[3][c]));
+        }
+    }
+
+#endif
+
+    static bool SelectNoiseImplementation(Internal::NoiseImplementation& result, NoiseInstructionSet instructionSet)
+    {
+        #if NOISE_SSE2
+            const auto& features = Utility::XlGetCPUFeatures();
+            if (instructionSet == NoiseInstructionSet::AVX2 && !(NOISE_AVX2 && features._avx2))
+                return false;
+
+            result._evaluate[0] = &EvaluateLanes<Lanes4, 2>;
+            result._evaluate[1] = &EvaluateLanes<Lanes4, 3>;
+            result._evaluate[2] = &EvaluateLanes<Lanes4, 4>;
+            #if NOISE_AVX2
+                if (instructionSet != NoiseInstructionSet::SSE2 && features._avx2) {
+                    result._evaluate[0] = &EvaluateLanes_AVX2<2>;
+                    result._evaluate[1] = &EvaluateLanes_AVX2<3>;
+                    result._evaluate[2] = &EvaluateLanes_AVX2<4>;
+                }
+            #endif
+            return true;
+        #else
+            if (instructionSet != NoiseInstructionSet::Best)
+                return false;
+            result._evaluate[0] = &EvaluateLanes_Scalar<2>;
+            result._evaluate[1] = &EvaluateLanes_Scalar<3>;
+            result._evaluate[2] = &EvaluateLanes_Scalar<4>;
+            return true;
+        #endif
+    }
+
+    static Internal::NoiseImplementation& GetNoiseImplementation()
+    {
+        static Internal::NoiseImplementation impl;
+        static bool initialised = SelectNoiseImplementation(impl, NoiseInstructionSet::Best);
+        (void)initialised;
+        return impl;
+    }
+
+    bool SetNoiseInstructionSet(NoiseInstructionSet instructionSet)
+    {
+        Internal::NoiseImplementation newImpl;
+        if (!SelectNoiseImplementation(newImpl, instructionSet)) return false;
+        GetNoiseImplementation() = newImpl;
+        return true;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static const unsigned BatchChunkSize = 256;     // (must be a multiple of the widest lane count)
+
+    template<typename Type> class NoiseDimensions;
+    template<> class NoiseDimensions<Float2> { public: static const int Value = 2; };
+    template<> class NoiseDimensions<Float3> { public: static const int Value = 3; };
+    template<> class NoiseDimensions<Float4> { public: static const int Value = 4; };
+
+    template<int Dims>
+        class NoiseChunk
+        {
+        public:
+            float       _pos[Dims][BatchChunkSize];
+            unsigned    _count;         // number of real positions
+            unsigned    _laneCount;     // rounded up to a multiple of 8, with zeroes in the padding
+
+            template<typename Type>
+                NoiseChunk(const Type positions[], size_t count)
+            {
+                _count = unsigned(count);
+                _laneCount = (_count + 7) & ~7u;
+                for (unsigned c=0; c<_count; ++c)
+                    for (int d=0; d<Dims; ++d)
+                        _pos[d][c] = positions[c][d];
+                for (unsigned c=_count; c<_laneCount; ++c)
+                    for (int d=0; d<Dims; ++d)
+                        _pos[d][c] = 0.f;
+            }
+
+            NoiseChunk() : _count(0), _laneCount(0) {}
+        };
+
+    template<int Dims>
+        static void EvaluateNoise(float dst[], const NoiseChunk<Dims>& chunk, float frequency)
+    {
+        NoiseChunk<Dims> scaled;
+        const float* pos[Dims];
+        for (int d=0; d<Dims; ++d) {
+            for (unsigned c=0; c<chunk._laneCount; ++c)
+                scaled._pos[d][c] = chunk._pos[d][c] * frequency;
+            pos[d] = scaled._pos[d];
+        }
+        GetNoiseImplementation()._evaluate[Dims-2](dst, pos, chunk._laneCount, GetBatchTables());
+    }
+
+    template<int Dims>
+        static void EvaluateFBM(
+            float dst[], const NoiseChunk<Dims>& chunk,
+            float hgrid, float gain, float lacunarity, int octaves, bool ridged)
+    {
+        float total[BatchChunkSize], noise[BatchChunkSize];
+        float frequency = 1.0f/(float)hgrid;
+        float amplitude = 1.f;
+        for (unsigned c=0; c<chunk._laneCount; ++c) total[c] = 0.f;
+
+        for (int i = 0; i < octaves; ++i) {
+            EvaluateNoise(noise, chunk, frequency);
+            if (ridged) {
+                for (unsigned c=0; c<chunk._laneCount; ++c) {
+                    float ridge = 1.f - XlAbs(noise[c]);
+                    total[c] += ridge * ridge * amplitude;
+                }
+            } else {
+                for (unsigned c=0; c<chunk._laneCount; ++c)
+                    total[c] += noise[c] * amplitude;
+            }
+            frequency *= lacunarity;
+            amplitude *= gain;
+        }
+
+        std::copy(total, &total[chunk._count], dst);
+    }
+
+        //  Each component of the warp vector is another FBM field, sampled at an offset
+        //  so that the components are independent. (arbitrary numbers)
+    static const float WarpOffsets[4][4] =
+    {
+        { 0.f, 0.f, 0.f, 0.f },
+        { 5.2f, 1.3f, 7.9f, 3.1f },
+        { 9.7f, 4.6f, 2.4f, 8.3f },
+        { 3.8f, 8.1f, 6.5f, 1.7f }
+    };
+
+    template<int Dims>
+        static void EvaluateWarpedFBM(
+            float dst[], const NoiseChunk<Dims>& chunk,
+            float hgrid, float gain, float lacunarity, int octaves, float warpStrength)
+    {
+        float warp[Dims][BatchChunkSize];
+        NoiseChunk<Dims> offsetChunk;
+        offsetChunk._count = offsetChunk._laneCount = chunk._laneCount;
+        for (int w=0; w<Dims; ++w) {
+            for (int d=0; d<Dims; ++d)
+                for (unsigned c=0; c<chunk._laneCount; ++c)
+                    offsetChunk._pos[d][c] = chunk._pos[d][c] + WarpOffsets[w][d];
+            EvaluateFBM(warp[w], offsetChunk, hgrid, gain, lacunarity, octaves, false);
+        }
+
+        for (int d=0; d<Dims; ++d)
+            for (unsigned c=0; c<chunk._laneCount; ++c)
+                offsetChunk._pos[d][c] = chunk._pos[d][c] + warpStrength * warp[d][c];
+        offsetChunk._count = chunk._count;
+        EvaluateFBM(dst, offsetChunk, hgrid, gain, lacunarity, octaves, false);
+    }
+
+    template<typename Type>
+        static void BatchNoise(float dst[], const Type positions[], size_t count)
+    {
+        const int Dims = NoiseDimensions<Type>::Value;
+        float noise[BatchChunkSize];
+        for (size_t c=0; c<count; c+=BatchChunkSize) {
+            NoiseChunk<Dims> chunk(&positions[c], std::min(count-c, size_t(BatchChunkSize)));
+            const float* pos[Dims];
+            for (int d=0; d<Dims; ++d) pos[d] = chunk._pos[d];
+            GetNoiseImplementation()._evaluate[Dims-2](noise, pos, chunk._laneCount, GetBatchTables());
+            std::copy(noise, &noise[chunk._count], &dst[c]);
+        }
+    }
+
+    void SimplexNoise(float dst[], const Float2 positions[], size_t count) { BatchNoise(dst, positions, count); }
+    void SimplexNoise(float dst[], const Float3 positions[], size_t count) { BatchNoise(dst, positions, count); }
+    void SimplexNoise(float dst[], const Float4 positions[], size_t count) { BatchNoise(dst, positions, count); }
+
+    template<typename Type>
+        void SimplexFBM(
+            float dst[], const Type positions[], size_t count,
+            float hgrid, float gain, float lacunarity, int octaves)
+    {
+        const int Dims = NoiseDimensions<Type>::Value;
+        for (size_t c=0; c<count; c+=BatchChunkSize) {
+            NoiseChunk<Dims> chunk(&positions[c], std::min(count-c, size_t(BatchChunkSize)));
+            EvaluateFBM(&dst[c], chunk, hgrid, gain, lacunarity, octaves, false);
+        }
+    }
+
+    template<typename Type>
+        void SimplexRidgedFBM(
+            float dst[], const Type positions[], size_t count,
+            float hgrid, float gain, float lacunarity, int octaves)
+    {
+        const int Dims = NoiseDimensions<Type>::Value;
+        for (size_t c=0; c<count; c+=BatchChunkSize) {
+            NoiseChunk<Dims> chunk(&positions[c], std::min(count-c, size_t(BatchChunkSize)));
+            EvaluateFBM(&dst[c], chunk, hgrid, gain, lacunarity, octaves, true);
+        }
+    }
+
+    template<typename Type>
+        void SimplexWarpedFBM(
+            float dst[], const Type positions[], size_t count,
+            float hgrid, float gain, float lacunarity, int octaves, float warpStrength)
+    {
+        const int Dims = NoiseDimensions<Type>::Value;
+        for (size_t c=0; c<count; c+=BatchChunkSize) {
+            NoiseChunk<Dims> chunk(&positions[c], std::min(count-c, size_t(BatchChunkSize)));
+            EvaluateWarpedFBM(&dst[c], chunk, hgrid, gain, lacunarity, octaves, warpStrength);
+        }
+    }
+
+    template void SimplexFBM(float[], const Float2[], size_t, float, float, float, int);
+    template void SimplexFBM(float[], const Float3[], size_t, float, float, float, int);
+    template void SimplexFBM(float[], const Float4[], size_t, float, float, float, int);
+    template void SimplexRidgedFBM(float[], const Float2[], size_t, float, float, float, int);
+    template void SimplexRidgedFBM(float[], const Float3[], size_t, float, float, float, int);
+    template void SimplexRidgedFBM(float[], const Float4[], size_t, float, float, float, int);
+    template void SimplexWarpedFBM(float[], const Float2[], size_t, float, float, float, int, float);
+    template void SimplexWarpedFBM(float[], const Float3[], size_t, float, float, float, int, float);
+    template void SimplexWarpedFBM(float[], const Float4[], size_t, float, float, float, int, float);
   
 }
\ No newline at end of file
@@ -16,4 +16,37 @@ namespace XLEMath
 
     template<typename Type>
         float SimplexFBM(Type pos, float hgrid, float gain, float lacunarity, int octaves);
+
+        //  Batched versions. These evaluate arrays of positions with SIMD -- 4 at a time with
+        //  SSE2, or 8 at a time with AVX2 (chosen at runtime, depending on the CPU). The
+        //  results are exactly the same with either instruction set. They match the single
+        //  point functions above, except for small differences the compiler might introduce
+        //  in the single point versions (eg, with fast floating point optimisations).
+        //
+        //  SimplexRidgedFBM() sums (1-|noise|)^2 (times the octave amplitude), giving sharp
+        //  ridges where the noise crosses zero. SimplexWarpedFBM() offsets the sample position by 
+        //  another FBM field (scaled by "warpStrength") before evaluating the final FBM.
+    void SimplexNoise(float dst[], const Float2 positions[], size_t count);
+    void SimplexNoise(float dst[], const Float3 positions[], size_t count);
+    void SimplexNoise(float dst[], const Float4 positions[], size_t count);
+
+    template<typename Type>
+        void SimplexFBM(
+            float dst[], const Type positions[], size_t count, 
+            float hgrid, float gain, float lacunarity, int octaves);
+    template<typename Type>
+        void SimplexRidgedFBM(
+            float dst[], const Type positions[], size_t count, 
+            float hgrid, float gain, float lacunarity, int octaves);
+    template<typename Type>
+        void SimplexWarpedFBM(
+            float dst[], const Type positions[], size_t count, 
+            float hgrid, float gain, float lacunarity, int octaves, float warpStrength);
+
+        //  Selects the instruction set used by the batched functions. By default, the best
+        //  one supported by the CPU is used; this is mostly for testing and benchmarking.
+        //  Returns false (and changes nothing) if the CPU doesn't support the given set.
+        //  Don't call this while other threads are evaluating noise.
+    enum class NoiseInstructionSet { Best, SSE2, AVX2 };
+    bool SetNoiseInstructionSet(NoiseInstructionSet instructionSet);
 }
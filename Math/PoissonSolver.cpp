@@ -11,6 +11,7 @@
 #include "Vector.h"
 #include "../ConsoleRig/Log.h"
 #include "../Utility/PtrUtils.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
 #include <vector>
 #include <assert.h>
 
@@ -112,22 +113,83 @@ namespace XLEMath
         else                        CopyBorder3D(dst, src, a._dims);
     }
 
+    class RowBlocks
+    {
+    public:
+            //  The conjugate gradient solvers work through the grid in blocks of whole rows.
+            //  Each pass over the grid does as much work as possible on each block while it's
+            //  in the cache (eg, "q = A * d" and the dot product "d.q" happen together). Dot
+            //  products are calculated as a partial sum for each block, and the partial sums
+            //  are added together in order. So the result doesn't depend on the thread count.
+        unsigned _rowWidth, _rowCount;
+        unsigned _rowsPerBlock, _blockCount;
+        CompletionThreadPool* _workerPool;
+
+        unsigned RowBegin(unsigned block) const     { return block * _rowsPerBlock; }
+        unsigned RowEnd(unsigned block) const       { return std::min((block+1) * _rowsPerBlock, _rowCount); }
+        unsigned ElementBegin(unsigned block) const { return RowBegin(block) * _rowWidth; }
+        unsigned ElementEnd(unsigned block) const   { return RowEnd(block) * _rowWidth; }
+
+        template<typename Fn> void ForEach(Fn&& fn) const;
+
+        RowBlocks(const AMat& A, CompletionThreadPool* workerPool);
+    };
+
+    RowBlocks::RowBlocks(const AMat& A, CompletionThreadPool* workerPool)
+    {
+            // (about 16KB per vector for each block)
+        const unsigned elementsPerBlock = 4096;
+        _rowWidth = GetWidth(A);
+        _rowCount = GetRowCount(A);
+        _rowsPerBlock = std::max(1u, elementsPerBlock / _rowWidth);
+        _blockCount = (_rowCount + _rowsPerBlock - 1) / _rowsPerBlock;
+        _workerPool = workerPool;
+    }
+
+    template<typename Fn>
+        void RowBlocks::ForEach(Fn&& fn) const
+    {
+            // small grids aren't worth the overhead of waking up the worker threads
+        const unsigned blocksPerTask = 2;
+        const unsigned taskCount = (_blockCount + blocksPerTask - 1) / blocksPerTask;
+        if (!_workerPool || taskCount <= 1) {
+            for (unsigned b=0; b<_blockCount; ++b) fn(b);
+            return;
+        }
+
+        auto task = [this, blocksPerTask, &fn](unsigned taskIndex)
+            {
+                auto blockEnd = std::min((taskIndex+1)*blocksPerTask, _blockCount);
+                for (unsigned b=taskIndex*blocksPerTask; b<blockEnd; ++b) fn(b);
+            };
+        if (!ParallelFor(*_workerPool, taskCount, task))
+            Throw(::Exceptions::BasicLabel("Failure in worker thread while solving Poisson equation"));
+    }
+
+    static float SumPartials(const std::vector<float>& partials)
+    {
+        float result = 0.f;
+        for (auto p:partials) result += p;
+        return result;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
     class Solver_PlainCG
     {
     public:
-        template<typename Mat>
-            unsigned Execute(ScalarField1D& x, const Mat& A, const ScalarField1D& b);
+        unsigned Execute(ScalarField1D& x, const AMat& A, const ScalarField1D& b, CompletionThreadPool* workerPool);
 
         Solver_PlainCG(unsigned N);
         ~Solver_PlainCG();
 
     protected:
         VectorX _r, _d, _q;
+        std::vector<float> _partials;
         unsigned _N;
     };
 
-    template<typename Mat>
-        unsigned Solver_PlainCG::Execute(ScalarField1D& x, const Mat& A, const ScalarField1D& b)
+    unsigned Solver_PlainCG::Execute(ScalarField1D& x, const AMat& A, const ScalarField1D& b, CompletionThreadPool* workerPool)
     {
             // This is the basic "conjugate gradient" method; with no special thrills
             // returns the number of iterations
@@ -139,74 +201,81 @@ namespace XLEMath
         const auto rhoThreshold = 1e-10f;
         const auto maxIterations = 13u;
 
-        // const UInt3 bor = GetBorders(A);
-        // const auto& dims = A._dims;
-        // #define FOR_EACH_CELL                                               \
-        //     for (unsigned qz=bor[2]; qz<dims[2]-bor[2]; ++qz)               \
-        //         for (unsigned qy=bor[1]; qy<dims[1]-bor[1]; ++qy)           \
-        //             for (unsigned qx=bor[0]; qx<dims[0]-bor[0]; ++qx) {     \
-        //                 auto i = (qz*dims[1]+qy)*dims[0]+qx;                \
-        //     /**/
         const auto N = GetN(A);
-        assert(N == _N);
-        #define FOR_EACH_CELL                   \
-            for (unsigned i=0; i<N; ++i) {      \
-            /**/
-        #define FOR_EACH_CELL_END }
-
-        auto rAsField = AsScalarField1D(_r);
-        Multiply(rAsField, A, x, _N);
-        for (unsigned c=0; c<b._count; ++c) {
-            _r[c] =  b[c] - _r[c];
-            _d[c] = _r[c];
-        }
-        auto rho = 0.f; // _r.dot(_r);
-        FOR_EACH_CELL
-            rho += _r[i] * _r[i];
-        FOR_EACH_CELL_END
+        assert(N == _N && b._count == N); (void)N;
+
+        RowBlocks blocks(A, workerPool);
+        _partials.resize(blocks._blockCount);
+        float* r = _r.data(), *d = _d.data(), *q = _q.data();
+        float* xv = x._u;
+        const float* bv = b._u;
+
+            // r = b - A * x, d = r and rho = r.r
+        blocks.ForEach(
+            [&](unsigned block)
+            {
+                MultiplyRows(r, A, xv, blocks.RowBegin(block), blocks.RowEnd(block));
+                float partial = 0.f;
+                for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i) {
+                    r[i] = bv[i] - r[i];
+                    d[i] = r[i];
+                    partial += r[i] * r[i];
+                }
+                _partials[block] = partial;
+            });
+        auto rho = SumPartials(_partials);
 
         unsigned k=0;
         if (XlAbs(rho) > rhoThreshold) {
             for (; k<maxIterations; ++k) {
             
-                Multiply(_q, A, _d, _N);
-                auto dDotQ = 0.f; // _d.dot(_q);
-                FOR_EACH_CELL
-                    dDotQ += _d[i] * _q[i];
-                FOR_EACH_CELL_END
+                    // q = A * d and d.q
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        MultiplyRows(q, A, d, blocks.RowBegin(block), blocks.RowEnd(block));
+                        float partial = 0.f;
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i)
+                            partial += d[i] * q[i];
+                        _partials[block] = partial;
+                    });
+                auto dDotQ = SumPartials(_partials);
 
                 auto alpha = rho / dDotQ;
                 assert(isfinite(alpha) && !isnan(alpha));
-                FOR_EACH_CELL
-                     x[i] += alpha * _d[i];
-                        // _r should be an estimate the of the current error
-                        // Every few iterations, we can improve this estimate
-                        // by recalculating _r = b - A * x
-                    _r[i] -= alpha * _q[i]; 
-                FOR_EACH_CELL_END
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        float partial = 0.f;
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i) {
+                            xv[i] += alpha * d[i];
+                                // _r should be an estimate the of the current error
+                                // Every few iterations, we can improve this estimate
+                                // by recalculating _r = b - A * x
+                            r[i] -= alpha * q[i];
+                            partial += r[i] * r[i];
+                        }
+                        _partials[block] = partial;
+                    });
             
                 auto rhoOld = rho;
-                rho = 0.f; // _r.dot(_r);
-                FOR_EACH_CELL
-                    rho += _r[i] * _r[i];
-                FOR_EACH_CELL_END
-
+                rho = SumPartials(_partials);
                 if (XlAbs(rho) < rhoThreshold) break;
                 auto beta = rho / rhoOld;
                 assert(isfinite(beta) && !isnan(beta));
             
                     // we can skip the border for the following...
                     // (but that requires different cases for 2D/3D)
-                FOR_EACH_CELL
-                    _d[i] = _r[i] + beta * _d[i];
-                FOR_EACH_CELL_END
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i)
+                            d[i] = r[i] + beta * d[i];
+                    });
 
             }
         }
 
-        #undef FOR_EACH_CELL
-        #undef FOR_EACH_CELL_END
-
         return k;
     }
 
@@ -214,6 +283,9 @@ namespace XLEMath
     : _r(N), _d(N), _q(N)
     {
         _N = N;
+            // In 3D, Multiply() doesn't write to the border cells. So we must initialize
+            // these vectors, otherwise the dot products will include garbage values.
+        _r.fill(0.f); _d.fill(0.f); _q.fill(0.f);
     }
 
     Solver_PlainCG::~Solver_PlainCG() {}
@@ -223,8 +295,8 @@ namespace XLEMath
     class Solver_PreconCG
     {
     public:
-        template<typename Mat, typename PreCon>
-            unsigned Execute(ScalarField1D& x, const Mat& A, const ScalarField1D& b, const PreCon& precon);
+        template<typename PreCon>
+            unsigned Execute(ScalarField1D& x, const AMat& A, const ScalarField1D& b, const PreCon& precon, CompletionThreadPool* workerPool);
 
         Solver_PreconCG(unsigned N);
         ~Solver_PreconCG();
@@ -232,11 +304,12 @@ namespace XLEMath
     protected:
         VectorX _r, _d, _q;
         VectorX _s;
+        std::vector<float> _partials;
         unsigned _N;
     };
 
-    template<typename Mat, typename PreCon>
-        unsigned Solver_PreconCG::Execute(ScalarField1D& x, const Mat& A, const ScalarField1D& b, const PreCon& precon)
+    template<typename PreCon>
+        unsigned Solver_PreconCG::Execute(ScalarField1D& x, const AMat& A, const ScalarField1D& b, const PreCon& precon, CompletionThreadPool* workerPool)
     {
             // This is the conjugate gradient method with a preconditioner.
             //
@@ -247,13 +320,29 @@ namespace XLEMath
             // for for detailed description of conjugate gradient methods!
             // 
             // see also reference at http://math.nist.gov/iml++/
+            //
+            // Applying the preconditioner is a forward substitution, which must be done
+            // serially. Everything else is split into blocks of rows (see RowBlocks).
         const auto rhoThreshold = 1e-10f;
         const auto maxIterations = 13u;
 
-        auto rAsField = AsScalarField1D(_r);
-        Multiply(rAsField, A, x, _N);    // r = AMat * x
-        for (unsigned c=0; c<b._count; ++c)
-            _r[c] = b[c] - _r[c];
+        const auto N = GetN(A);
+        assert(N == _N && b._count == N); (void)N;
+
+        RowBlocks blocks(A, workerPool);
+        _partials.resize(blocks._blockCount);
+        float* r = _r.data(), *d = _d.data(), *q = _q.data(), *s = _s.data();
+        float* xv = x._u;
+        const float* bv = b._u;
+
+            // r = b - A * x
+        blocks.ForEach(
+            [&](unsigned block)
+            {
+                MultiplyRows(r, A, xv, blocks.RowBegin(block), blocks.RowEnd(block));
+                for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i)
+                    r[i] = bv[i] - r[i];
+            });
             
         SolveLowerTriangular(_d, precon, _r, _N);
             
@@ -269,26 +358,20 @@ namespace XLEMath
         //     }
         // #endif
 
-        // const UInt3 bor = GetBorders(A);
-        // const auto& dims = A._dims;
-        // #define FOR_EACH_CELL                                               \
-        //     for (unsigned qz=bor[2]; qz<dims[2]-bor[2]; ++qz)               \
-        //         for (unsigned qy=bor[1]; qy<dims[1]-bor[1]; ++qy)           \
-        //             for (unsigned qx=bor[0]; qx<dims[0]-bor[0]; ++qx) {     \
-        //                 auto i = (qz*dims[1]+qy)*dims[0]+qx;                \
-        //     /**/
-        const auto N = GetN(A);
-        assert(N == _N);
-        #define FOR_EACH_CELL                           \
-            for (unsigned i=0; i<N; ++i) {              \
-            /**/
-        #define FOR_EACH_CELL_END }
+        auto dotProduct = [&](const float* lhs, const float* rhs) -> float
+            {
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        float partial = 0.f;
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i)
+                            partial += lhs[i] * rhs[i];
+                        _partials[block] = partial;
+                    });
+                return SumPartials(_partials);
+            };
             
-        auto rho = 0.f;
-        FOR_EACH_CELL
-            rho += _r[i] * _d[i];       // calculating: auto rho = _r.dot(_d);
-        FOR_EACH_CELL_END
-        // auto rho0 = rho;
+        auto rho = dotProduct(r, d);
             
         unsigned k=0;
         if (XlAbs(rho) > rhoThreshold) {
@@ -303,40 +386,47 @@ namespace XLEMath
                     // simplified, because the vectors already have only one
                     // element per cell.
             
-                Multiply(_q, A, _d, _N);
-                auto dDotQ = 0.f; // _d.dot(_q);
-                FOR_EACH_CELL
-                    dDotQ += _d[i] * _q[i];
-                FOR_EACH_CELL_END
+                    // q = A * d and d.q
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        MultiplyRows(q, A, d, blocks.RowBegin(block), blocks.RowEnd(block));
+                        float partial = 0.f;
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i)
+                            partial += d[i] * q[i];
+                        _partials[block] = partial;
+                    });
+                auto dDotQ = SumPartials(_partials);
 
                 auto alpha = rho / dDotQ;
                 assert(isfinite(alpha) && !isnan(alpha));
-                FOR_EACH_CELL
-                     x[i] += alpha * _d[i];
-                    _r[i] -= alpha * _q[i];
-                FOR_EACH_CELL_END
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i) {
+                            xv[i] += alpha * d[i];
+                            r[i] -= alpha * q[i];
+                        }
+                    });
             
                 SolveLowerTriangular(_s, precon, _r, _N);
                 auto rhoOld = rho;
-                rho = 0.f; // _r.dot(_s);
-                FOR_EACH_CELL
-                    rho += _r[i] * _s[i];
-                FOR_EACH_CELL_END
+                rho = dotProduct(r, s);
                 if (XlAbs(rho) < rhoThreshold) break;
                 // assert(rho < rhoOld);
 
                 auto beta = rho / rhoOld;
                 assert(isfinite(beta) && !isnan(beta));
             
-                FOR_EACH_CELL
-                    _d[i] = _s[i] + beta * _d[i];
-                FOR_EACH_CELL_END
+                blocks.ForEach(
+                    [&](unsigned block)
+                    {
+                        for (unsigned i=blocks.ElementBegin(block); i<blocks.ElementEnd(block); ++i)
+                            d[i] = s[i] + beta * d[i];
+                    });
             }
         }
 
-        #undef FOR_EACH_CELL
-        #undef FOR_EACH_CELL_END
-
         return k;
     }
 
@@ -344,6 +434,9 @@ namespace XLEMath
     : _r(N), _d(N), _q(N), _s(N)
     {
         _N = N;
+            // As above, and also SolveLowerTriangular() will read from the upper bands of
+            // "_d" and "_s" before they are written.
+        _r.fill(0.f); _d.fill(0.f); _q.fill(0.f); _s.fill(0.f);
     }
 
     Solver_PreconCG::~Solver_PreconCG() {}
@@ -624,6 +717,8 @@ namespace XLEMath
         std::unique_ptr<Solver_PlainCG> _plainCGSolver;
         std::unique_ptr<Solver_PreconCG> _preconCGSolver;
         std::unique_ptr<Solver_Multigrid> _multigridSolver;
+
+        CompletionThreadPool* _workerPool;
     };
 
     class PoissonSolver::PreparedMatrix
@@ -738,18 +833,23 @@ namespace XLEMath
                 // explicit euler. We'll march forward part of
                 // the timestep, and then refine the estimate
                 // from there using the iterative implicit method.
-            if (!(flags & Flags::XContainsEstimate))
-                Multiply(x, EstimateInverse(matA, estimateFactor), workingB, GetN(matA));
+            if (!(flags & Flags::XContainsEstimate)) {
+                const auto estimate = EstimateInverse(matA, estimateFactor);
+                RowBlocks blocks(matA, _pimpl->_workerPool);
+                blocks.ForEach(
+                    [&x, &estimate, &workingB, &blocks](unsigned block)
+                    { MultiplyRows(x, estimate, workingB, blocks.RowBegin(block), blocks.RowEnd(block)); });
+            }
 
             auto iterations = 0u;
             if (solver == Method::PlainCG) {
                 if (!_pimpl->_plainCGSolver)
                     _pimpl->_plainCGSolver = std::make_unique<Solver_PlainCG>(N);
-                iterations = _pimpl->_plainCGSolver->Execute(x, matA, workingB);
+                iterations = _pimpl->_plainCGSolver->Execute(x, matA, workingB, _pimpl->_workerPool);
             } else if (solver == Method::PreconCG) {
                 if (!_pimpl->_preconCGSolver)
                     _pimpl->_preconCGSolver = std::make_unique<Solver_PreconCG>(N);
-                iterations = _pimpl->_preconCGSolver->Execute(x, matA, workingB, A._bandedPrecon);
+                iterations = _pimpl->_preconCGSolver->Execute(x, matA, workingB, A._bandedPrecon, _pimpl->_workerPool);
             } else if (solver == Method::Multigrid) {
                 if (!_pimpl->_multigridSolver)
                     _pimpl->_multigridSolver = std::make_unique<Solver_Multigrid>(_pimpl->_dimensionsWithBorders, _pimpl->_dimensionality, 2);
@@ -1287,11 +1387,12 @@ namespace XLEMath
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-    PoissonSolver::PoissonSolver(unsigned dimensionality, unsigned dimensions[])
+    PoissonSolver::PoissonSolver(unsigned dimensionality, unsigned dimensions[], CompletionThreadPool* workerPool)
     {
         assert(dimensionality==2 || dimensionality == 3);
         dimensionality = std::min(dimensionality, 3u);
         _pimpl = std::make_unique<Pimpl>();
+        _pimpl->_workerPool = workerPool;
         _pimpl->_dimensionsWithBorders = UInt3(1,1,1);
         _pimpl->_dimensionality = dimensionality;
         for (unsigned c=0; c<_pimpl->_dimensionality; ++c)
@@ -9,6 +9,8 @@
 #include <memory>
 #include <assert.h>
 
+namespace Utility { class CompletionThreadPool; }
+
 namespace XLEMath
 {
     struct ScalarField1D
@@ -49,6 +51,10 @@ namespace XLEMath
     ///
     /// This class aims to encapsulate the implementation details and math involved in 
     /// calculating the solution -- and provide a simple reusable interface.
+    ///
+    /// If a worker pool is given, the conjugate gradient methods will split each pass
+    /// over the grid into blocks of rows and distribute them across the pool. The results
+    /// don't depend on the number of threads in the pool.
     class PoissonSolver
     {
     public:
@@ -78,7 +84,7 @@ namespace XLEMath
         std::shared_ptr<PreparedMatrix> PrepareDivergenceMatrix(
             Method method, unsigned wrapEdgesFlags) const;
 
-        PoissonSolver(unsigned dimensionality, unsigned dimensions[]);
+        PoissonSolver(unsigned dimensionality, unsigned dimensions[], Utility::CompletionThreadPool* workerPool = nullptr);
         PoissonSolver(PoissonSolver&& moveFrom);
         PoissonSolver& operator=(PoissonSolver&& moveFrom);
         PoissonSolver();
@@ -49,6 +49,7 @@ namespace XLEMath
         inline unsigned GetHeight(const AMat& A)        { return A._dims[1]; }
         inline unsigned GetDepth(const AMat& A)         { return A._dims[2]; }
         inline unsigned GetMarginFlags(const AMat& a)   { return a._marginFlags; }
+        inline unsigned GetRowCount(const AMat& A)      { return A._dims[1] * A._dims[2]; }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -128,87 +129,96 @@ namespace XLEMath
             }
         }
 
-        template <typename Vec>
-            static void Multiply(Vec& dst, const AMat& A, const Vec& b, unsigned N)
+            //  Calculates "dst = A * b" for a range of rows. In 2D, a row is a single Y value.
+            //  In 3D, rows are numbered "z*height+y". The result for each row depends only
+            //  on "b" so different rows can be calculated on different threads.
+        template <typename DstVec, typename SrcVec>
+            static void MultiplyRows(DstVec& dst, const AMat& A, const SrcVec& b, unsigned rowBegin, unsigned rowEnd)
         {
             const auto width = GetWidth(A), height = GetHeight(A);
 
             if (A._dimensionality==2) {
-                const UInt2 bor(1,1);
-                for (unsigned y=bor[1]; y<height-bor[1]; ++y) {
-                    for (unsigned x=bor[0]; x<width-bor[0]; ++x) {
-                        const unsigned i = y*width + x;
-
-                        auto v = A._a0 * b[i];
-                        v += A._a1 * b[i-1];
-                        v += A._a1 * b[i+1];
-                        v += A._a1 * b[i-width];
-                        v += A._a1 * b[i+width];
-
-                        dst[i] = v;
-                    }
-                }
-
-                    // do the borders, as well --
-                    //      4 edges & 4 corners
                 const auto w = width, h = height;
                 #define XY(x,y) XY_WH(x,y,w)
-                for (unsigned i=1; i<w-1; ++i) {
-                    dst[XY(i, 0)]       = A._a0ey *  b[XY(  i,   0)] 
-                                        + A._a1e  * (b[XY(  i,   1)] + b[XY(i-1, 0)] + b[XY(i+1, 0)])
-                                        + A._a1ry * (b[XY(  i, h-1)]);
-                    dst[XY(i, h-1)]     = A._a0ey *  b[XY(  i, h-1)] 
-                                        + A._a1e  * (b[XY(  i, h-2)] + b[XY(i-1, h-1)] + b[XY(i+1, h-1)])
-                                        + A._a1ry * (b[XY(  i,   0)]);
-                }
-
-                for (unsigned i=1; i<h-1; ++i) {
-                    dst[XY(0, i)]       = A._a0ex *  b[XY(  0,   i)] 
-                                        + A._a1e  * (b[XY(  1,   i)] + b[XY(0, i-1)] + b[XY(0, i+1)])
-                                        + A._a1rx * (b[XY(w-1,   i)]);
-                    dst[XY(w-1, i)]     = A._a0ex *  b[XY(w-1,   i)] 
-                                        + A._a1e  * (b[XY(w-2,   i)] + b[XY(w-1, i-1)] + b[XY(w-1, i+1)])
-                                        + A._a1rx * (b[XY(  0,   i)]);
-                }
-                
-                dst[XY(0, 0)]           = A._a0c *  b[XY(  0,   0)] 
-                                        + A._a1e * (b[XY(  0,   1)] + b[XY(  1,   0)])
-                                        + A._a1rx * b[XY(w-1,   0)] + A._a1ry * b[XY(  0, h-1)];
-                dst[XY(0, h-1)]         = A._a0c *  b[XY(  0, h-1)] 
-                                        + A._a1e * (b[XY(  0, h-2)] + b[XY(  1, h-1)])
-                                        + A._a1rx * b[XY(w-1, h-1)] + A._a1ry * b[XY(  0,   0)];
-
-                dst[XY(w-1, 0)]         = A._a0c *  b[XY(w-1,   0)] 
-                                        + A._a1e * (b[XY(w-1,   1)] + b[XY(w-2,   0)])
-                                        + A._a1rx * b[XY(  0,   0)] + A._a1ry * b[XY(w-1, h-1)];
-                dst[XY(w-1, h-1)]       = A._a0c *  b[XY(w-1, h-1)] 
-                                        + A._a1e * (b[XY(w-1, h-2)] + b[XY(w-2, h-1)])
-                                        + A._a1rx * b[XY(  0, h-1)] + A._a1ry * b[XY(w-1,   0)];
-                #undef XY
-
-            } else {
-                const UInt3 bor(1,1,1);
-                for (unsigned z=bor[2]; z<GetDepth(A)-bor[2]; ++z) {
-                    for (unsigned y=bor[1]; y<height-bor[1]; ++y) {
-                        for (unsigned x=bor[0]; x<width-bor[0]; ++x) {
-                            const unsigned i = (z*height+y)*width + x;
+                for (unsigned y=rowBegin; y<rowEnd; ++y) {
+                    if (y == 0) {
+                        for (unsigned i=1; i<w-1; ++i)
+                            dst[XY(i, 0)]       = A._a0ey *  b[XY(  i,   0)] 
+                                                + A._a1e  * (b[XY(  i,   1)] + b[XY(i-1, 0)] + b[XY(i+1, 0)])
+                                                + A._a1ry * (b[XY(  i, h-1)]);
+
+                        dst[XY(0, 0)]           = A._a0c *  b[XY(  0,   0)] 
+                                                + A._a1e * (b[XY(  0,   1)] + b[XY(  1,   0)])
+                                                + A._a1rx * b[XY(w-1,   0)] + A._a1ry * b[XY(  0, h-1)];
+                        dst[XY(w-1, 0)]         = A._a0c *  b[XY(w-1,   0)] 
+                                                + A._a1e * (b[XY(w-1,   1)] + b[XY(w-2,   0)])
+                                                + A._a1rx * b[XY(  0,   0)] + A._a1ry * b[XY(w-1, h-1)];
+                    } else if (y == h-1) {
+                        for (unsigned i=1; i<w-1; ++i)
+                            dst[XY(i, h-1)]     = A._a0ey *  b[XY(  i, h-1)] 
+                                                + A._a1e  * (b[XY(  i, h-2)] + b[XY(i-1, h-1)] + b[XY(i+1, h-1)])
+                                                + A._a1ry * (b[XY(  i,   0)]);
+
+                        dst[XY(0, h-1)]         = A._a0c *  b[XY(  0, h-1)] 
+                                                + A._a1e * (b[XY(  0, h-2)] + b[XY(  1, h-1)])
+                                                + A._a1rx * b[XY(w-1, h-1)] + A._a1ry * b[XY(  0,   0)];
+                        dst[XY(w-1, h-1)]       = A._a0c *  b[XY(w-1, h-1)] 
+                                                + A._a1e * (b[XY(w-1, h-2)] + b[XY(w-2, h-1)])
+                                                + A._a1rx * b[XY(  0, h-1)] + A._a1ry * b[XY(w-1,   0)];
+                    } else {
+                        for (unsigned x=1; x<w-1; ++x) {
+                            const unsigned i = y*width + x;
 
                             auto v = A._a0 * b[i];
-                            v += A._a1 * b[i-width*height];
-                            v += A._a1 * b[i-width];
                             v += A._a1 * b[i-1];
                             v += A._a1 * b[i+1];
+                            v += A._a1 * b[i-width];
                             v += A._a1 * b[i+width];
-                            v += A._a1 * b[i+width*height];
 
                             dst[i] = v;
                         }
+
+                            // left & right edges
+                        dst[XY(0, y)]           = A._a0ex *  b[XY(  0,   y)] 
+                                                + A._a1e  * (b[XY(  1,   y)] + b[XY(0, y-1)] + b[XY(0, y+1)])
+                                                + A._a1rx * (b[XY(w-1,   y)]);
+                        dst[XY(w-1, y)]         = A._a0ex *  b[XY(w-1,   y)] 
+                                                + A._a1e  * (b[XY(w-2,   y)] + b[XY(w-1, y-1)] + b[XY(w-1, y+1)])
+                                                + A._a1rx * (b[XY(  0,   y)]);
+                    }
+                }
+                #undef XY
+
+            } else {
+                const auto depth = GetDepth(A);
+                for (unsigned r=rowBegin; r<rowEnd; ++r) {
+                    const unsigned z = r / height, y = r % height;
+                    if (z < 1 || z >= depth-1 || y < 1 || y >= height-1) continue;
+
+                    for (unsigned x=1; x<width-1; ++x) {
+                        const unsigned i = (z*height+y)*width + x;
+
+                        auto v = A._a0 * b[i];
+                        v += A._a1 * b[i-width*height];
+                        v += A._a1 * b[i-width];
+                        v += A._a1 * b[i-1];
+                        v += A._a1 * b[i+1];
+                        v += A._a1 * b[i+width];
+                        v += A._a1 * b[i+width*height];
+
+                        dst[i] = v;
                     }
                 }
 
                     // todo -- borders, edges, faces!
             }
         }
+
+        template <typename Vec>
+            static void Multiply(Vec& dst, const AMat& A, const Vec& b, unsigned N)
+        {
+            MultiplyRows(dst, A, b, 0u, GetRowCount(A));
+        }
         
     }
 }
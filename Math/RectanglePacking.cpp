@@ -5,6 +5,7 @@
 // http://www.opensource.org/licenses/mit-license.php)
 
 #include "RectanglePacking.h"
+#include <algorithm>
 
 namespace XLEMath
 {
@@ -321,26 +322,34 @@ namespace XLEMath
             for (auto i=_freeRectangles.begin(); i!=_freeRectangles.end(); ++i) {
                 if (i->second[0] == xRect.first[0]) {
                         // i is on the left of xRect. If the full edge is shared, then expand...
-                    if (i->first[1] <= xRect.first[1] && i->second[1] >= xRect.second[1])
+                    if (i->first[1] <= xRect.first[1] && i->second[1] >= xRect.second[1]) {
                         xRect.first[0] = i->first[0];
+                        xExpand = true;
+                    }
                 }
 
                 if (i->first[0] == xRect.second[0]) {
                         // i is on the right of xRect. If the full edge is shared, then expand...
-                    if (i->first[1] <= xRect.first[1] && i->second[1] >= xRect.second[1])
+                    if (i->first[1] <= xRect.first[1] && i->second[1] >= xRect.second[1]) {
                         xRect.second[0] = i->second[0];
+                        xExpand = true;
+                    }
                 }
 
                 if (i->second[1] == yRect.first[1]) {
                         // i is on the top of yRect. If the full edge is shared, then expand...
-                    if (i->first[0] <= yRect.first[0] && i->second[0] >= yRect.second[0])
-                        xRect.first[1] = i->first[1];
+                    if (i->first[0] <= yRect.first[0] && i->second[0] >= yRect.second[0]) {
+                        yRect.first[1] = i->first[1];
+                        yExpand = true;
+                    }
                 }
 
                 if (i->first[1] == yRect.second[1]) {
                         // i is on the bottom of yRect. If the full edge is shared, then expand...
-                    if (i->first[0] <= yRect.first[0] && i->second[0] >= yRect.second[0])
-                        xRect.second[1] = i->second[1];
+                    if (i->first[0] <= yRect.first[0] && i->second[0] >= yRect.second[0]) {
+                        yRect.second[1] = i->second[1];
+                        yExpand = true;
+                    }
                 }
             }
 
@@ -416,5 +425,331 @@ namespace XLEMath
         return *this;
     }
 
-}
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static uint64 CornerKey(UInt2 corner) { return (uint64(corner[0]) << 32ull) | uint64(corner[1]); }
+    static unsigned Area(const std::pair<UInt2, UInt2>& rect) { return Width(rect) * Height(rect); }
+
+    auto RectanglePacker_Guillotine::MakeFreeKey(unsigned node) const -> FreeKey
+    {
+        const auto& space = _nodes[node]._space;
+        return FreeKey((uint64(Height(space)) << 32ull) | uint64(Width(space)), node);
+    }
+
+    void RectanglePacker_Guillotine::AddFree(unsigned node)
+    {
+        assert(_nodes[node]._type == NodeType::Free);
+        _freeRectangles.insert(MakeFreeKey(node));
+        UpdateWidestAtHeight(Height(_nodes[node]._space));
+    }
+
+    void RectanglePacker_Guillotine::RemoveFree(unsigned node)
+    {
+        _freeRectangles.erase(MakeFreeKey(node));
+        UpdateWidestAtHeight(Height(_nodes[node]._space));
+    }
+
+    void RectanglePacker_Guillotine::UpdateWidestAtHeight(unsigned height)
+    {
+            // The widest free rectangle of this height is the last one in the
+            // sorted set before the next height starts
+        unsigned widest = 0;
+        auto i = _freeRectangles.lower_bound(FreeKey(uint64(height+1) << 32ull, 0));
+        if (i != _freeRectangles.begin()) {
+            --i;
+            if ((i->first >> 32ull) == height)
+                widest = unsigned(i->first & 0xffffffffull);
+        }
+
+        auto leafCount = unsigned(_widestAtHeight.size()/2);
+        auto n = leafCount + height;
+        _widestAtHeight[n] = widest;
+        for (n>>=1; n>0; n>>=1)
+            _widestAtHeight[n] = std::max(_widestAtHeight[n*2], _widestAtHeight[n*2+1]);
+    }
+
+    unsigned RectanglePacker_Guillotine::FindHeight(
+        unsigned minHeight, unsigned minWidth,
+        unsigned treeNode, unsigned rangeStart, unsigned rangeEnd) const
+    {
+            // find the smallest height >= minHeight that has a free rectangle
+            // at least "minWidth" wide
+        if (rangeEnd <= minHeight || _widestAtHeight[treeNode] < minWidth) return ~0u;
+        if ((rangeEnd - rangeStart) == 1) return rangeStart;
+        auto mid = (rangeStart + rangeEnd) / 2;
+        auto result = FindHeight(minHeight, minWidth, treeNode*2, rangeStart, mid);
+        if (result != ~0u) return result;
+        return FindHeight(minHeight, minWidth, treeNode*2+1, mid, rangeEnd);
+    }
+
+    unsigned RectanglePacker_Guillotine::CreateNode(
+        const Rectangle& space, unsigned parent, unsigned siblingAxis, NodeType type)
+    {
+        Node newNode { space, parent, s_invalidNode, s_invalidNode, type, siblingAxis };
+        if (!_unusedNodes.empty()) {
+            auto result = _unusedNodes.back();
+            _unusedNodes.pop_back();
+            _nodes[result] = newNode;
+            return result;
+        }
+        _nodes.push_back(newNode);
+        return unsigned(_nodes.size()-1);
+    }
+
+    void RectanglePacker_Guillotine::ReleaseNode(unsigned node)
+    {
+        _nodes[node]._type = NodeType::Unused;
+        _unusedNodes.push_back(node);
+    }
+
+    void RectanglePacker_Guillotine::InsertAfter(unsigned node, unsigned newSibling)
+    {
+        auto next = _nodes[node]._nextSibling;
+        _nodes[newSibling]._prevSibling = node;
+        _nodes[newSibling]._nextSibling = next;
+        _nodes[node]._nextSibling = newSibling;
+        if (next != s_invalidNode) _nodes[next]._prevSibling = newSibling;
+    }
+
+    void RectanglePacker_Guillotine::Unlink(unsigned node)
+    {
+        auto prev = _nodes[node]._prevSibling, next = _nodes[node]._nextSibling;
+        if (prev != s_invalidNode) _nodes[prev]._nextSibling = next;
+        if (next != s_invalidNode) _nodes[next]._prevSibling = prev;
+        _nodes[node]._prevSibling = _nodes[node]._nextSibling = s_invalidNode;
+    }
+
+    auto RectanglePacker_Guillotine::Allocate(UInt2 dims) -> Rectangle
+    {
+        if (!dims[0] || !dims[1]) return s_emptyRect;
+
+        if (_widestAtHeight.empty()) return s_emptyRect;
+
+            // Find the shortest free rectangle that is wide enough, and then the
+            // narrowest free rectangle of that height that fits.
+        auto height = FindHeight(dims[1], dims[0], 1, 0, unsigned(_widestAtHeight.size()/2));
+        if (height == ~0u)
+            return s_emptyRect; // couldn't fit it in!
+
+        auto i = _freeRectangles.lower_bound(FreeKey((uint64(height) << 32ull) | uint64(dims[0]), 0));
+        assert(i != _freeRectangles.end() && (i->first >> 32ull) == height);
+        auto node = i->second;
+        RemoveFree(node);
+
+            // Space left over along the sibling axis becomes a new free sibling. It
+            // shares the full extent of this node on the other axis.
+        auto a = _nodes[node]._siblingAxis, b = 1-a;
+        auto space = _nodes[node]._space;
+        if ((space.second[a] - space.first[a]) > dims[a]) {
+            auto leftover = space;
+            leftover.first[a] = space.second[a] = space.first[a] + dims[a];
+            _nodes[node]._space = space;
+            auto sibling = CreateNode(leftover, _nodes[node]._parent, a, NodeType::Free);
+            InsertAfter(node, sibling);
+            AddFree(sibling);
+        }
+
+            // Space left over along the other axis means this node becomes a container
+            // for the allocated space and the remainder (stacked along the other axis)
+        auto allocatedNode = node;
+        if ((space.second[b] - space.first[b]) > dims[b]) {
+            auto allocated = space, leftover = space;
+            leftover.first[b] = allocated.second[b] = space.first[b] + dims[b];
+            _nodes[node]._type = NodeType::Container;
+            allocatedNode = CreateNode(allocated, node, b, NodeType::Allocated);
+            auto remainder = CreateNode(leftover, node, b, NodeType::Free);
+            InsertAfter(allocatedNode, remainder);
+            AddFree(remainder);
+        } else {
+            _nodes[node]._type = NodeType::Allocated;
+        }
+
+        auto result = _nodes[allocatedNode]._space;
+        assert(result.second == result.first + dims);
+        _allocatedNodes.insert(std::make_pair(CornerKey(result.first), allocatedNode));
+        _freeArea -= Area(result);
+        return result;
+    }
+
+    void RectanglePacker_Guillotine::Deallocate(const Rectangle& rect)
+    {
+        auto i = _allocatedNodes.find(CornerKey(rect.first));
+        if (i == _allocatedNodes.end()) { assert(0); return; }
+
+        auto node = i->second;
+        _allocatedNodes.erase(i);
+        assert(_nodes[node]._type == NodeType::Allocated && _nodes[node]._space == rect);
+        _nodes[node]._type = NodeType::Free;
+        _freeArea += Area(rect);
+
+            // Merge with free siblings on either side. Free siblings are never adjacent,
+            // so we only need to check once on each side. If the result is an only child, 
+            // it fills the parent, so the parent becomes free (and we repeat for the parent)
+        for (;;) {
+            auto next = _nodes[node]._nextSibling;
+            if (next != s_invalidNode && _nodes[next]._type == NodeType::Free) {
+                RemoveFree(next);
+                _nodes[node]._space.second = _nodes[next]._space.second;
+                Unlink(next);
+                ReleaseNode(next);
+            }
+
+            auto prev = _nodes[node]._prevSibling;
+            if (prev != s_invalidNode && _nodes[prev]._type == NodeType::Free) {
+                RemoveFree(prev);
+                _nodes[node]._space.first = _nodes[prev]._space.first;
+                Unlink(prev);
+                ReleaseNode(prev);
+            }
+
+            auto parent = _nodes[node]._parent;
+            if (    parent == s_invalidNode
+                ||  _nodes[node]._prevSibling != s_invalidNode
+                ||  _nodes[node]._nextSibling != s_invalidNode)
+                break;
+
+            assert(_nodes[parent]._type == NodeType::Container && _nodes[parent]._space == _nodes[node]._space);
+            ReleaseNode(node);
+            _nodes[parent]._type = NodeType::Free;
+            node = parent;
+        }
+
+        AddFree(node);
+    }
+
+    std::pair<UInt2, UInt2> RectanglePacker_Guillotine::LargestFreeBlock() const
+    {
+        UInt2 bestForArea(0, 0);
+        UInt2 bestForSide(0, 0);
+        unsigned bestArea = 0, bestSide = 0;
+        for (const auto& f:_freeRectangles) {
+            const auto& space = _nodes[f.second]._space;
+            auto area = Area(space);
+            if (area > bestArea) {
+                bestForArea = space.second - space.first;
+                bestArea = area;
+            }
+            auto side = std::max(Width(space), Height(space));
+            if (side > bestSide) {
+                bestForSide = space.second - space.first;
+                bestSide = side;
+            }
+        }
+        return std::make_pair(bestForArea, bestForSide);
+    }
+
+    float RectanglePacker_Guillotine::Fragmentation() const
+    {
+        if (!_freeArea) return 0.f;
+        auto largest = LargestFreeBlock().first;
+        return 1.f - float(largest[0] * largest[1]) / float(_freeArea);
+    }
+
+    auto RectanglePacker_Guillotine::PlanCompaction(unsigned maxMoves) -> std::vector<Move>
+    {
+            // Try to move the allocations furthest from the origin (in Y, then X) into
+            // free space closer to the origin. This gathers the free space together in
+            // the far corner, where it will merge into larger rectangles.
+            // Each candidate is allocated before the old space is freed, so the 
+            // destination can never overlap the source.
+        std::vector<Move> result;
+        if (!maxMoves) return result;
+
+        std::vector<Rectangle> candidates;
+        candidates.reserve(_allocatedNodes.size());
+        for (const auto& a:_allocatedNodes)
+            candidates.push_back(_nodes[a.second]._space);
+
+            // we only need to sort the candidates we might try. Limit the attempts,
+            // so a packer that is already compact doesn't cost too much
+        auto maxAttempts = std::min(candidates.size(), size_t(maxMoves) * 4);
+        auto furthest = 
+            [](const Rectangle& lhs, const Rectangle& rhs)
+            {
+                if (lhs.first[1] != rhs.first[1]) return lhs.first[1] > rhs.first[1];
+                return lhs.first[0] > rhs.first[0];
+            };
+        std::partial_sort(candidates.begin(), candidates.begin() + maxAttempts, candidates.end(), furthest);
+
+        for (size_t c=0; c<maxAttempts && result.size() < maxMoves; ++c) {
+            const auto& from = candidates[c];
+            auto to = Allocate(from.second - from.first);
+            if (!IsGood(to)) continue;
+
+            if (furthest(from, to)) {
+                Deallocate(from);
+                result.push_back(Move { from, to });
+            } else {
+                Deallocate(to);     // (this restores the tree exactly as it was)
+            }
+        }
+
+        return result;
+    }
+
+    RectanglePacker_Guillotine::RectanglePacker_Guillotine()
+    : _totalSize(0, 0), _freeArea(0)
+    {}
+
+    RectanglePacker_Guillotine::RectanglePacker_Guillotine(UInt2 dimensions)
+    : _totalSize(dimensions), _freeArea(0)
+    {
+        if (dimensions[0] && dimensions[1]) {
+            unsigned leafCount = 1;
+            while (leafCount <= dimensions[1]) leafCount <<= 1;
+            _widestAtHeight.resize(leafCount*2, 0);
+
+            _nodes.reserve(128);
+            auto root = CreateNode(std::make_pair(UInt2(0,0), dimensions), s_invalidNode, 1, NodeType::Free);
+            AddFree(root);
+            _freeArea = dimensions[0] * dimensions[1];
+        }
+    }
 
+    RectanglePacker_Guillotine::RectanglePacker_Guillotine(RectanglePacker_Guillotine&& moveFrom) never_throws
+    : _nodes(std::move(moveFrom._nodes))
+    , _unusedNodes(std::move(moveFrom._unusedNodes))
+    , _freeRectangles(std::move(moveFrom._freeRectangles))
+    , _widestAtHeight(std::move(moveFrom._widestAtHeight))
+    , _allocatedNodes(std::move(moveFrom._allocatedNodes))
+    , _totalSize(moveFrom._totalSize)
+    , _freeArea(moveFrom._freeArea)
+    {}
+
+    RectanglePacker_Guillotine& RectanglePacker_Guillotine::operator=(RectanglePacker_Guillotine&& moveFrom) never_throws
+    {
+        _nodes = std::move(moveFrom._nodes);
+        _unusedNodes = std::move(moveFrom._unusedNodes);
+        _freeRectangles = std::move(moveFrom._freeRectangles);
+        _widestAtHeight = std::move(moveFrom._widestAtHeight);
+        _allocatedNodes = std::move(moveFrom._allocatedNodes);
+        _totalSize = moveFrom._totalSize;
+        _freeArea = moveFrom._freeArea;
+        return *this;
+    }
+
+    RectanglePacker_Guillotine::~RectanglePacker_Guillotine() {}
+
+    RectanglePacker_Guillotine::RectanglePacker_Guillotine(const RectanglePacker_Guillotine& copyFrom)
+    : _nodes(copyFrom._nodes)
+    , _unusedNodes(copyFrom._unusedNodes)
+    , _freeRectangles(copyFrom._freeRectangles)
+    , _widestAtHeight(copyFrom._widestAtHeight)
+    , _allocatedNodes(copyFrom._allocatedNodes)
+    , _totalSize(copyFrom._totalSize)
+    , _freeArea(copyFrom._freeArea)
+    {}
+
+    RectanglePacker_Guillotine& RectanglePacker_Guillotine::operator=(const RectanglePacker_Guillotine& copyFrom)
+    {
+        _nodes = copyFrom._nodes;
+        _unusedNodes = copyFrom._unusedNodes;
+        _freeRectangles = copyFrom._freeRectangles;
+        _widestAtHeight = copyFrom._widestAtHeight;
+        _allocatedNodes = copyFrom._allocatedNodes;
+        _totalSize = copyFrom._totalSize;
+        _freeArea = copyFrom._freeArea;
+        return *this;
+    }
+
+}
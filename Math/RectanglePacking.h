@@ -4,8 +4,12 @@
 // accompanying file "LICENSE" or the website
 // http://www.opensource.org/licenses/mit-license.php)
 
+#pragma once
+
 #include "Vector.h"
 #include <vector>
+#include <set>
+#include <unordered_map>
 
 namespace XLEMath
 {
@@ -106,5 +110,97 @@ namespace XLEMath
     private:
         std::vector<Rectangle> _freeRectangles;
     };
-}
 
+    /// <summary>Pack rectangles with support for deallocation</summary>
+    /// This is a "guillotine" packer. Each allocation splits a free rectangle
+    /// into the allocated part, a free part beside it and a free part below it (or
+    /// vice versa). The splits form a tree, and siblings in the tree are always
+    /// stacked along a single axis. So when a rectangle is deallocated, it can be
+    /// merged with free siblings on either side; and when a single free node fills 
+    /// its parent, the parent becomes free again. Freeing everything always returns
+    /// the packer to a single free rectangle.
+    ///
+    /// Free rectangles are kept sorted by height, then width, along with a segment
+    /// tree that records the widest free rectangle for each range of heights. Allocate()
+    /// takes the shortest free rectangle that fits, and Deallocate() finds the node with
+    /// a hash lookup. So both are O(log n) in the number of free rectangles. This is
+    /// intended for long running use, where rectangles are added and removed
+    /// frequently (eg, imposters or sprites). In contrast, RectanglePacker_MaxRects
+    /// packs a little more tightly, but allocation is O(n^2) in its free list.
+    ///
+    /// When allocations come and go, the free space will become fragmented over time.
+    /// Fragmentation() measures this. PlanCompaction() will move a few allocations
+    /// into better positions, and returns the moves made, so the client can copy
+    /// the contents of each rectangle. The moves must be executed in order, because
+    /// a later move can be into space vacated by an earlier one. Call it a few times
+    /// (eg, once per frame) to compact incrementally.
+    class RectanglePacker_Guillotine
+    {
+    public:
+        using Rectangle = std::pair<UInt2, UInt2>;
+
+        Rectangle   Allocate(UInt2 dims);
+        void        Deallocate(const Rectangle& rect);
+
+        UInt2       TotalSize() const { return _totalSize; }
+        unsigned    FreeArea() const { return _freeArea; }
+        std::pair<UInt2, UInt2> LargestFreeBlock() const;
+
+            //  0 when the free space is a single rectangle; approaching 1 as the 
+            //  free space is broken up into many small pieces
+        float       Fragmentation() const;
+
+        class Move
+        {
+        public:
+            Rectangle _from, _to;
+        };
+        std::vector<Move> PlanCompaction(unsigned maxMoves);
+
+        RectanglePacker_Guillotine();
+        RectanglePacker_Guillotine(UInt2 dimensions);
+        RectanglePacker_Guillotine(RectanglePacker_Guillotine&& moveFrom) never_throws;
+        RectanglePacker_Guillotine& operator=(RectanglePacker_Guillotine&& moveFrom) never_throws;
+        ~RectanglePacker_Guillotine();
+
+        RectanglePacker_Guillotine(const RectanglePacker_Guillotine&);
+        RectanglePacker_Guillotine& operator=(const RectanglePacker_Guillotine&);
+
+    private:
+        static const unsigned s_invalidNode = ~0u;
+
+        enum class NodeType { Free, Allocated, Container, Unused };
+
+        class Node
+        {
+        public:
+            Rectangle   _space;
+            unsigned    _parent;
+            unsigned    _prevSibling, _nextSibling;
+            NodeType    _type;
+            unsigned    _siblingAxis;   // siblings are stacked along this axis (0 = X, 1 = Y)
+        };
+
+        std::vector<Node>       _nodes;
+        std::vector<unsigned>   _unusedNodes;
+
+        using FreeKey = std::pair<uint64, unsigned>;    // ((height << 32) | width, node)
+        std::set<FreeKey>       _freeRectangles;
+        std::vector<unsigned>   _widestAtHeight;        // segment tree, with a leaf for each height
+
+        std::unordered_map<uint64, unsigned> _allocatedNodes;  // keyed on the top-left corner
+
+        UInt2       _totalSize;
+        unsigned    _freeArea;
+
+        unsigned    CreateNode(const Rectangle& space, unsigned parent, unsigned siblingAxis, NodeType type);
+        void        ReleaseNode(unsigned node);
+        void        InsertAfter(unsigned node, unsigned newSibling);
+        void        Unlink(unsigned node);
+        FreeKey     MakeFreeKey(unsigned node) const;
+        void        AddFree(unsigned node);
+        void        RemoveFree(unsigned node);
+        void        UpdateWidestAtHeight(unsigned height);
+        unsigned    FindHeight(unsigned minHeight, unsigned minWidth, unsigned treeNode, unsigned rangeStart, unsigned rangeEnd) const;
+    };
+}
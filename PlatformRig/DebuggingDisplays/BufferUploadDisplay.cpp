@@ -985,12 +985,16 @@ namespace PlatformRig { namespace Overlays
             unsigned largestFreeBlock = 0;
             unsigned largestHeapSize = 0;
             unsigned totalBlockCount = 0;
+            unsigned freeBlockCount = 0;
+            float worstFragmentation = 0.f;
             for (std::vector<BatchedHeapMetrics>::const_iterator i=metrics._heaps.begin(); i!=metrics._heaps.end(); ++i) {
                 allocatedSpace += i->_allocatedSpace;
                 unallocatedSpace += i->_unallocatedSpace;
                 largestFreeBlock = std::max(largestFreeBlock, i->_largestFreeBlock);
                 largestHeapSize = std::max(largestHeapSize, i->_heapSize);
                 totalBlockCount += i->_referencedCountedBlockCount;
+                freeBlockCount += i->_freeBlockCount;
+                worstFragmentation = std::max(worstFragmentation, i->_fragmentation);
             }
 
             {
@@ -1000,6 +1004,8 @@ namespace PlatformRig { namespace Overlays
                     largestFreeBlock/1024.f, unallocatedSpace/(float(metrics._heaps.size())*1024.f));
                 DrawFormatText(context, layout.AllocateFullWidth(16), nullptr, textColour, "Block count: %i / Ave block size: %7.3fKb",
                     totalBlockCount, allocatedSpace/float(totalBlockCount*1024.f));
+                DrawFormatText(context, layout.AllocateFullWidth(16), nullptr, textColour, "Free block count: %i / Worst fragmentation: %5.1f%%",
+                    freeBlockCount, worstFragmentation*100.f);
             }
 
             unsigned currentFrameId = GetFrameID();
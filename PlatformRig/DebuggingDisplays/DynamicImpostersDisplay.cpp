@@ -71,7 +71,17 @@ namespace PlatformRig { namespace Overlays
             context, 
             statsArea.AllocateFullWidth(lineHeight),
             nullptr, ColorB(0xffffffff),
-            "Evictions: (%i)", metrics._evictionCounter);
+            "Evictions: (%i), Fragmentation: %.1f%%", metrics._evictionCounter, 100.f * metrics._fragmentation);
+        DrawFormatText(
+            context, 
+            statsArea.AllocateFullWidth(lineHeight),
+            nullptr, ColorB(0xffffffff),
+            "Queue: (%i), Oldest: (%i) frames", metrics._queueDepth, metrics._oldestPendingAge);
+        DrawFormatText(
+            context, 
+            statsArea.AllocateFullWidth(lineHeight),
+            nullptr, ColorB(0xffffffff),
+            "Updates: (%i) in %.2fms, Stand-ins: (%i)", metrics._updateCounter, metrics._updateTime, metrics._standInCounter);
         statsArea.AllocateFullWidth(lineHeight);
         DrawFormatText(
             context, 
@@ -25,6 +25,8 @@
 #include "../Utility/IntrusivePtr.h"
 #include "../Utility/StringFormat.h"
 #include "../Utility/Profiling/CPUProfiler.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include "../Utility/Threading/FramePipeline.h"
 
 #include "../ConsoleRig/Log.h"
 #include "../ConsoleRig/Console.h"
@@ -44,6 +46,7 @@ namespace PlatformRig
     public:
         void PushFrameDuration(uint64 duration);
         std::tuple<float, float, float> GetPerformanceStats() const;
+        bool HasSamples() const { return _bufferStart != _bufferEnd; }
 
         FrameRateRecorder();
         ~FrameRateRecorder();
@@ -62,11 +65,13 @@ namespace PlatformRig
 
         FrameRigDisplay(
             std::shared_ptr<DebugScreensSystem> debugSystem,
-            const AccumulatedAllocations::Snapshot& prevFrameAllocationCount, const FrameRateRecorder& frameRate);
+            const AccumulatedAllocations::Snapshot& prevFrameAllocationCount, const FrameRateRecorder& frameRate,
+            const FrameRateRecorder& frameLatency);
         ~FrameRigDisplay();
     protected:
         const AccumulatedAllocations::Snapshot* _prevFrameAllocationCount;
         const FrameRateRecorder* _frameRate;
+        const FrameRateRecorder* _frameLatency;
         unsigned _subMenuOpen;
 
         std::weak_ptr<DebugScreensSystem> _debugSystem;
@@ -77,6 +82,7 @@ namespace PlatformRig
     public:
         AccumulatedAllocations::Snapshot _prevFrameAllocationCount;
         FrameRateRecorder _frameRate;
+        FrameRateRecorder _frameLatency;
         uint64      _prevFrameStartTime;
         float       _timerToSeconds;
         unsigned    _frameRenderCount;
@@ -88,12 +94,30 @@ namespace PlatformRig
         std::shared_ptr<DebugScreensSystem> _debugSystem;
         std::vector<PostPresentCallback> _postPresentCallbacks;
 
+            //  (the pipeline must be destroyed before the thread it uses)
+        std::unique_ptr<CompletionThreadPool> _prepareThread;
+        std::unique_ptr<FramePipeline> _pipeline;
+        bool        _pipelined;
+
+        FramePipeline& GetPipeline()
+        {
+                //  Preparation gets a dedicated thread (rather than the global pools),
+                //  because the prepare function may itself want to distribute work 
+                //  across the global pools and wait for it
+            if (!_pipeline) {
+                _prepareThread = std::make_unique<CompletionThreadPool>(1);
+                _pipeline = std::make_unique<FramePipeline>(*_prepareThread, _pipelined);
+            }
+            return *_pipeline;
+        }
+
         Pimpl()
         : _prevFrameStartTime(0) 
         , _timerFrequency(GetPerformanceCounterFrequency())
         , _frameRenderCount(0)
         , _frameLimiter(0)
         , _updateAsyncMan(false)
+        , _pipelined(false)
         {
             _timerToSeconds = 1.0f / float(_timerFrequency);
         }
@@ -167,6 +191,19 @@ namespace PlatformRig
         RenderCore::Metal::GPUProfiler::Profiler* gpuProfiler,
         HierarchicalCPUProfiler* cpuProfiler,
         const FrameRenderFunction& renderFunction) -> FrameResult
+    {
+        return ExecuteFrame(
+            context, presChain, gpuProfiler, cpuProfiler, FramePrepareFunction(),
+            [&renderFunction](RenderCore::IThreadContext& threadContext, unsigned) { return renderFunction(threadContext); });
+    }
+
+    auto FrameRig::ExecuteFrame(
+        RenderCore::IThreadContext& context,
+        RenderCore::IPresentationChain* presChain,
+        RenderCore::Metal::GPUProfiler::Profiler* gpuProfiler,
+        HierarchicalCPUProfiler* cpuProfiler,
+        const FramePrepareFunction& prepareFunction,
+        const PreparedRenderFunction& renderFunction) -> FrameResult
     {
         CPUProfileEvent_Conditional pEvnt("FrameRig::ExecuteFrame", cpuProfiler);
 
@@ -205,9 +242,21 @@ namespace PlatformRig
             //  during the begin frame or present
         metalContext->InvalidateCachedState();
 
+            //  Completed font glyphs are uploaded here, and the glyph cache
+            //  uses the frame boundary to decide which glyphs can be evicted
+        RenderOverlays::CheckResetFontSystem();
+
         ////////////////////////////////
 
-        auto renderRes = renderFunction(context);
+            //  Wait for the preparation of this frame (and begin preparing the next
+            //  frame, if we're pipelined)
+        unsigned bufferIndex = 0;
+        if (prepareFunction) {
+            CPUProfileEvent_Conditional pEvnt("PrepareFrame", cpuProfiler);
+            bufferIndex = _pimpl->GetPipeline().BeginFrame(prepareFunction, frameElapsedTime);
+        }
+
+        auto renderRes = renderFunction(context, bufferIndex);
 
         ////////////////////////////////
 
@@ -226,6 +275,19 @@ namespace PlatformRig
                 if (_pimpl->_prevFrameAllocationCount._allocationCount) {
                     LogInfo << "(" << _pimpl->_prevFrameAllocationCount._freeCount << ") frees and (" << _pimpl->_prevFrameAllocationCount._allocationCount << ") allocs during frame. Ave alloc: (" << _pimpl->_prevFrameAllocationCount._allocationsSize / _pimpl->_prevFrameAllocationCount._allocationCount << ").";
                 }
+                if (_pimpl->_frameLatency.HasSamples()) {
+                    auto l = _pimpl->_frameLatency.GetPerformanceStats();
+                    LogInfo << "Ave latency: " << std::get<0>(l) << "ms (max " << std::get<2>(l) << "ms). Last prepare: " 
+                        << _pimpl->_pipeline->GetLastPrepareTime() * _pimpl->_timerToSeconds * 1000.f << "ms, waited: " 
+                        << _pimpl->_pipeline->GetLastWaitTime() * _pimpl->_timerToSeconds * 1000.f << "ms";
+                }
+            }
+
+            if (Tweakable("FontCacheStats", false) && (_pimpl->_frameRenderCount % 64) == (64-1)) {
+                auto metrics = RenderOverlays::GetFontCacheMetrics();
+                auto lookups = metrics._hits + metrics._misses;
+                LogInfo << "Font cache: (" << metrics._glyphCount << ") glyphs in (" << metrics._pageCount << ") pages. Hit rate: (" << (lookups ? 100.f * float(metrics._hits) / float(lookups) : 100.f) << "%)";
+                LogInfo << "Font cache: (" << metrics._rasterisedCount << ") glyphs rasterised in (" << metrics._rasterisationTime << "ms). (" << metrics._evictions << ") evictions, (" << metrics._pendingCount << ") pending";
             }
         }
 
@@ -234,6 +296,10 @@ namespace PlatformRig
             presChain->Present();
         }
 
+        if (prepareFunction)
+            _pimpl->_frameLatency.PushFrameDuration(
+                GetPerformanceCounter() - _pimpl->_pipeline->GetPrepareStartTime(bufferIndex));
+
         {
             for (auto i=_pimpl->_postPresentCallbacks.begin(); i!=_pimpl->_postPresentCallbacks.end(); ++i) {
                 (*i)(context);
@@ -270,6 +336,19 @@ namespace PlatformRig
         else { _pimpl->_frameLimiter = 0; }
     }
 
+    void FrameRig::SetPipelined(bool pipelined)
+    {
+        _pimpl->_pipelined = pipelined;
+        if (_pimpl->_pipeline)
+            _pimpl->_pipeline->SetPipelined(pipelined);
+    }
+
+    void FrameRig::SyncPipeline()
+    {
+        if (_pimpl->_pipeline)
+            _pimpl->_pipeline->Sync();
+    }
+
     void FrameRig::AddPostPresentCallback(const PostPresentCallback& postPresentCallback)
     {
         _pimpl->_postPresentCallbacks.push_back(postPresentCallback);
@@ -290,7 +369,7 @@ namespace PlatformRig
             _pimpl->_debugSystem = std::make_shared<DebugScreensSystem>();
             if (isMainFrameRig)
                 _pimpl->_debugSystem->Register(
-                    std::make_shared<FrameRigDisplay>(_pimpl->_debugSystem, _pimpl->_prevFrameAllocationCount, _pimpl->_frameRate),
+                    std::make_shared<FrameRigDisplay>(_pimpl->_debugSystem, _pimpl->_prevFrameAllocationCount, _pimpl->_frameRate, _pimpl->_frameLatency),
                     "FrameRig", DebugScreensSystem::SystemDisplay);
         }
 
@@ -313,6 +392,7 @@ namespace PlatformRig
             getGlobalNamespace(luaState)
                 .beginClass<FrameRig>("FrameRig")
                     .addFunction("SetFrameLimiter", &FrameRig::SetFrameLimiter)
+                    .addFunction("SetPipelined", &FrameRig::SetPipelined)
                 .endClass();
             
             setGlobal(luaState, this, "MainFrameRig");
@@ -405,7 +485,8 @@ namespace PlatformRig
         const auto bigLineHeight = Coord(res._frameRateFont->LineHeight());
         const auto smallLineHeight = Coord(res._smallFrameRateFont->LineHeight());
         const auto tabHeadingLineHeight = Coord(res._tabHeadingFont->LineHeight());
-        const Coord rectHeight = bigLineHeight + 3 * margin + smallLineHeight;
+        const bool showLatency = _frameLatency->HasSamples();
+        const Coord rectHeight = bigLineHeight + 3 * margin + smallLineHeight + (showLatency ? (margin + smallLineHeight) : 0);
         Rect displayRect(
             Coord2(outerRect._bottomRight[0] - rectWidth - padding, outerRect._topLeft[1] + padding),
             Coord2(outerRect._bottomRight[0] - padding, outerRect._topLeft[1] + padding + rectHeight));
@@ -445,6 +526,14 @@ namespace PlatformRig
             &smallStyle, ColorB(0xffffffff), TextAlignment::Center,
             "%.2fM (%i)", heapMetrics._usage / (1024.f*1024.f), frameAllocations);
 
+        if (showLatency) {
+            auto l = _frameLatency->GetPerformanceStats();
+            DrawFormatText(
+                context, innerLayout.AllocateFullWidth(smallLineHeight), 0.f,
+                &smallStyle, ColorB(0xffffffff), TextAlignment::Center,
+                "Latency %.1fms (max %.1f)", std::get<0>(l), std::get<2>(l));
+        }
+
         interactables.Register(Interactables::Widget(displayRect, Id_FrameRigDisplayMain));
 
         TextStyle tabHeader(*res._tabHeadingFont);
@@ -575,9 +664,11 @@ namespace PlatformRig
 
     FrameRigDisplay::FrameRigDisplay(
         std::shared_ptr<DebugScreensSystem> debugSystem,
-        const AccumulatedAllocations::Snapshot& prevFrameAllocationCount, const FrameRateRecorder& frameRate)
+        const AccumulatedAllocations::Snapshot& prevFrameAllocationCount, const FrameRateRecorder& frameRate,
+        const FrameRateRecorder& frameLatency)
     {
         _frameRate = &frameRate;
+        _frameLatency = &frameLatency;
         _prevFrameAllocationCount = &prevFrameAllocationCount;
         _debugSystem = std::move(debugSystem);
         _subMenuOpen = 0;
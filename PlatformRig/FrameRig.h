@@ -8,6 +8,7 @@
 
 #include "../RenderCore/IDevice.h"
 #include "../RenderCore/Metal/GPUProfiler.h"
+#include "../Utility/Threading/FramePipeline.h"
 #include <functional>
 #include <memory>
 
@@ -45,6 +46,45 @@ namespace PlatformRig
             Utility::HierarchicalCPUProfiler* profiler,
             const FrameRenderFunction& renderFunction);
 
+            //  Pipelined frames
+            //  -----------------
+            //  The prepare function performs the CPU side preparation of the scene for a
+            //  frame (simulation, culling, building draw lists, etc) and writes it into
+            //  one of 2 client owned buffers, selected by "bufferIndex". The render function
+            //  then submits the frame from the buffer with the same index.
+            //
+            //  When pipelining is enabled (see SetPipelined), the preparation of the next frame
+            //  runs on a worker thread while the current frame is rendered, presented and the
+            //  post present callbacks are run. See Utility::FramePipeline for the rules
+            //  the prepare and render functions must follow for this to be safe. Use
+            //  SyncPipeline() before modifying any state that is read by the prepare function.
+            //
+            //  Pipelining adds a frame of latency. The latency from the start of preparation
+            //  to present is shown in the FrameRig display.
+            //
+            //  SetPipelined() (also available from the console as "MainFrameRig:SetPipelined")
+            //  only affects frames executed with a prepare function. The HelloWorld sample 
+            //  shows how to split a frame loop this way.
+            //
+            //  Note that this is only the infrastructure for pipelining. SceneEngine still
+            //  does its placement culling and draw call preparation inside the lighting
+            //  parser (ie, in the render function). So today only client simulation work
+            //  (such as the HelloWorld scene time) actually runs in the prepare stage.
+        typedef FramePipeline::PrepareFunction FramePrepareFunction;
+        typedef std::function<RenderResult(RenderCore::IThreadContext&, unsigned bufferIndex)>
+            PreparedRenderFunction;
+
+        FrameResult ExecuteFrame(
+            RenderCore::IThreadContext& context,
+            RenderCore::IPresentationChain* presChain,
+            RenderCore::Metal::GPUProfiler::Profiler* gpuProfiler,
+            Utility::HierarchicalCPUProfiler* profiler,
+            const FramePrepareFunction& prepareFunction,
+            const PreparedRenderFunction& renderFunction);
+
+        void SetPipelined(bool pipelined);
+        void SyncPipeline();
+
         void SetFrameLimiter(unsigned maxFPS);
         void SetUpdateAsyncMan(bool updateAsyncMan);
 
@@ -44,7 +44,8 @@ namespace RenderCore { namespace Assets
 
     Metal::ConstantBufferLayoutElement LocalTransform_Elements[] = {
         { "LocalToWorld",                   Metal::NativeFormat::Matrix3x4,        offsetof(Techniques::LocalTransformConstants, _localToWorld), 0      },
-        { "LocalSpaceView",                 Metal::NativeFormat::R32G32B32_FLOAT,  offsetof(Techniques::LocalTransformConstants, _localSpaceView), 0    }
+        { "LocalSpaceView",                 Metal::NativeFormat::R32G32B32_FLOAT,  offsetof(Techniques::LocalTransformConstants, _localSpaceView), 0    },
+        { "GeoTexCoordScaleOffset",         Metal::NativeFormat::R32G32B32A32_FLOAT, offsetof(Techniques::LocalTransformConstants, _texCoordScaleOffset), 0 }
     };
 
     size_t LocalTransform_ElementsCount = dimof(LocalTransform_Elements);
@@ -109,18 +109,24 @@ namespace RenderCore { namespace Assets
             versionInfo._versionString, versionInfo._buildDateString);
         file.Write(&header, sizeof(header), 1);
 
+            //  Chunk payloads are aligned, so they can be used in place when the
+            //  file is mapped (see ChunkAlignment)
         unsigned trackingOffset = unsigned(file.TellP() + sizeof(ChunkHeader) * chunksForMainFile);
         for (const auto& c:*chunks)
             if (predicate(c)) {
                 auto hdr = c._hdr;
-                hdr._fileOffset = trackingOffset;
+                hdr._fileOffset = AlignChunkOffset(trackingOffset);
                 file.Write(&hdr, sizeof(c._hdr), 1);
-                trackingOffset += hdr._size;
+                trackingOffset = hdr._fileOffset + hdr._size;
             }
 
+        const uint8 padding[ChunkAlignment] = {};
         for (const auto& c:*chunks)
-            if (predicate(c))
+            if (predicate(c)) {
+                auto offset = unsigned(file.TellP());
+                file.Write(padding, 1, AlignChunkOffset(offset) - offset);
                 file.Write(AsPointer(c._data.begin()), c._data.size(), 1);
+            }
     }
 
     static const auto ChunkType_Metrics = ConstHash64<'Metr', 'ics'>::Value;
@@ -6,6 +6,7 @@
 
 #include "DeferredShaderResource.h"
 #include "Services.h"
+#include "TextureCompiler.h"
 #include "../Metal/ShaderResource.h"
 #include "../../Assets/AsyncLoadOperation.h"
 #include "../../BufferUploads/IBufferUploads.h"
@@ -17,7 +18,6 @@
 #include "../../Utility/Streams/PathUtils.h"
 #include "../../Utility/Streams/FileUtils.h"
 #include "../../Utility/Threading/CompletionThreadPool.h"
-#include "../../Foreign/tinyxml2-master/tinyxml2.h"
 
 #include "../../Core/WinAPI/IncludeWindows.h"
 
@@ -25,8 +25,6 @@ namespace RenderCore { namespace Assets
 {
     using ResChar = ::Assets::ResChar;
 
-    enum class SourceColorSpace { SRGB, Linear, Unspecified };
-
     class MetadataLoadMarker : public ::Assets::AsyncLoadOperation
     {
     public:
@@ -36,41 +34,14 @@ namespace RenderCore { namespace Assets
         MetadataLoadMarker() : _colorSpace(SourceColorSpace::Unspecified) {}
     };
 
-    bool LoadColorSpaceFromMetadataFile(SourceColorSpace& result, const void* start, size_t size)
-    {
-        result = SourceColorSpace::Unspecified;
-
-        if (!start || !size) return false;
-
-        // skip over the "byte order mark", if it exists...
-        if (size >= 3 && ((const uint8*)start)[0] == 0xef && ((const uint8*)start)[1] == 0xbb && ((const uint8*)start)[2] == 0xbf) {
-            start = PtrAdd(start, 3);
-            size -= 3;
-        }
-
-        using namespace tinyxml2;
-        XMLDocument doc;
-	    auto e = doc.Parse((const char*)start, size);
-        if (e != XML_SUCCESS) return false;
-
-        const auto* root = doc.RootElement();
-        if (root) {
-            auto colorSpace = root->FindAttribute("colorSpace");
-            if (colorSpace) {
-                if (!XlCompareStringI(colorSpace->Value(), "srgb")) { result = SourceColorSpace::SRGB; }
-                else if (!XlCompareStringI(colorSpace->Value(), "linear")) { result = SourceColorSpace::Linear; }
-            }
-        }
-
-        return true;
-    }
-
     ::Assets::AssetState MetadataLoadMarker::Complete(const void* buffer, size_t bufferSize)
     {
             // Attempt to parse the xml in our data buffer...
-        if (!LoadColorSpaceFromMetadataFile(_colorSpace, buffer, bufferSize))
+        TextureMetadata metadata;
+        if (!LoadTextureMetadata(metadata, buffer, bufferSize))
             return ::Assets::AssetState::Invalid;
 
+        _colorSpace = metadata._colorSpace;
         return ::Assets::AssetState::Ready;
     }
 
@@ -128,15 +99,33 @@ namespace RenderCore { namespace Assets
 	template<int Count>
 		static void BuildRequestString(
 			::Assets::ResChar (&buffer)[Count],
-			const FileNameSplitter<::Assets::ResChar>& splitter)
+			const FileNameSplitter<::Assets::ResChar>& splitter,
+			const ::Assets::ResChar cookedFile[])
 	{
 		auto& store = ::Assets::Services::GetAsyncMan().GetShadowingStore();
 		store.MakeIntermediateName(
 			buffer, Count, MakeStringSection(splitter.DriveAndPath().begin(), splitter.File().end()));
 		XlCatString(buffer, Count, ".dds;");
+		if (cookedFile) {
+			XlCatString(buffer, Count, cookedFile);
+			XlCatString(buffer, Count, ";");
+		}
 		XlCatString(buffer, Count, splitter.AllExceptParameters());
 	}
 
+	static std::shared_ptr<::Assets::ICompileMarker> PrepareCookedTexture(const DecodedInitializer& init)
+	{
+		::Assets::ResChar sourceFile[MaxPath], parameters[MaxPath];
+		XlCopyString(sourceFile, init._splitter.AllExceptParameters());
+		XlCopyString(parameters, init._splitter.Parameters());
+		const ::Assets::ResChar* initializers[] = { sourceFile, parameters };
+
+		auto& asyncMan = ::Assets::Services::GetAsyncMan();
+		return asyncMan.GetIntermediateCompilers().PrepareAsset(
+			TextureCompiler::CompileProcessType, initializers, dimof(initializers), 
+			asyncMan.GetIntermediateStore());
+	}
+
     DeferredShaderResource::DeferredShaderResource(const ResChar initializer[])
     {
         DEBUG_ONLY(XlCopyString(_initializer, dimof(_initializer), initializer);)
@@ -149,7 +138,7 @@ namespace RenderCore { namespace Assets
         _pimpl->_colSpaceRequestString = init._colSpaceRequestString;
         _pimpl->_colSpaceDefault = init._colSpaceDefault;
 
-		::Assets::ResChar filename[MaxPath];
+		::Assets::ResChar filename[MaxPath*2];
         if (_pimpl->_colSpaceRequestString == SourceColorSpace::Unspecified) {
                 // No color space explicitly requested. We need to calculate the default
                 // color space for this texture...
@@ -178,12 +167,26 @@ namespace RenderCore { namespace Assets
         TextureLoadFlags::BitField flags = init._generateMipmaps ? TextureLoadFlags::GenerateMipmaps : 0;
 
 		// We're going to check for the existance of a "shadowing" file first. We'll write onto "filename"
-		// two names -- a possible shadowing file, and the original file as well. But don't do this for
-		// DDS files. We'll assume they do not have a shadowing file.
+		// up to three names -- a possible shadowing file, the cooked version of the texture and the
+		// original file as well. But don't do this for DDS files. We'll assume they do not have a
+		// shadowing file, and they don't need cooking.
+		//
+		// The cooked version is only used if it is up-to-date. Otherwise, we'll start cooking
+		// in the background and load the original file this time. When the cooked file
+		// is written, our dependency validation will trigger a reload.
 		intrusive_ptr<DataPacket> pkt;
 		const bool checkForShadowingFile = CheckShadowingFile(init._splitter);
 		if (checkForShadowingFile) {
-			BuildRequestString(filename, init._splitter);
+			auto cookMarker = PrepareCookedTexture(init);
+			auto cooked = cookMarker->GetExistingAsset();
+			if (cooked._dependencyValidation && cooked._dependencyValidation->GetValidationIndex() == 0) {
+				::Assets::RegisterAssetDependency(_validationCallback, cooked._dependencyValidation);
+				BuildRequestString(filename, init._splitter, cooked._sourceID0);
+			} else {
+				cookMarker->InvokeCompile();
+				RegisterFileDependency(_validationCallback, cooked._sourceID0);
+				BuildRequestString(filename, init._splitter, nullptr);
+			}
 			pkt = CreateStreamingTextureSource(MakeStringSection(filename), flags);
 		} else {
 			pkt = CreateStreamingTextureSource(init._splitter.AllExceptParameters(), flags);
@@ -323,8 +326,9 @@ namespace RenderCore { namespace Assets
 
                 size_t filesize = 0;
                 auto rawFile = LoadFileAsMemoryBlock(metadataFile, &filesize);
-                if (rawFile.get())
-                    LoadColorSpaceFromMetadataFile(finalColSpace, rawFile.get(), filesize);
+                TextureMetadata metadata;
+                if (rawFile.get() && LoadTextureMetadata(metadata, rawFile.get(), filesize))
+                    finalColSpace = metadata._colorSpace;
             
                 if (finalColSpace == SourceColorSpace::Unspecified)
                     finalColSpace = (init._colSpaceDefault != SourceColorSpace::Unspecified) ? init._colSpaceDefault : SourceColorSpace::SRGB;
@@ -344,7 +348,7 @@ namespace RenderCore { namespace Assets
 		const bool checkForShadowingFile = CheckShadowingFile(init._splitter);
 		if (checkForShadowingFile) {
 			::Assets::ResChar filename[MaxPath];
-			BuildRequestString(filename, init._splitter);
+			BuildRequestString(filename, init._splitter, nullptr);
 			result = (Metal::NativeFormat::Enum)BufferUploads::LoadTextureFormat(MakeStringSection(filename))._nativePixelFormat;
 		} else
 			result = (Metal::NativeFormat::Enum)BufferUploads::LoadTextureFormat(init._splitter.AllExceptParameters())._nativePixelFormat;
@@ -362,8 +366,11 @@ namespace RenderCore { namespace Assets
 		intrusive_ptr<DataPacket> pkt;
 		const bool checkForShadowingFile = CheckShadowingFile(init._splitter);
 		if (checkForShadowingFile) {
-			::Assets::ResChar filename[MaxPath];
-			BuildRequestString(filename, init._splitter);
+				// use the cooked texture only if it's already up-to-date
+			auto cooked = PrepareCookedTexture(init)->GetExistingAsset();
+			const bool useCooked = cooked._dependencyValidation && cooked._dependencyValidation->GetValidationIndex() == 0;
+			::Assets::ResChar filename[MaxPath*2];
+			BuildRequestString(filename, init._splitter, useCooked ? cooked._sourceID0 : nullptr);
 			pkt = CreateStreamingTextureSource(MakeStringSection(filename), flags);
 		} else
 			pkt = CreateStreamingTextureSource(init._splitter.AllExceptParameters(), flags);
@@ -40,6 +40,11 @@ namespace RenderCore { namespace Assets
     /// is loaded. Building mipmaps for a lot of textures can end up being a large amount of
     /// work -- so it is recommended to use .dds files with precompiled mip maps (.dds files
     /// also allow compressed texture formats).
+    ///
+    /// To help with this, non-dds textures are cooked by the TextureCompiler. The first
+    /// time a texture is requested it is loaded from the source file (as above), and
+    /// a cook is started in the background. After that, the cooked version (with mipmaps
+    /// and block compression) will be loaded directly.
     class DeferredShaderResource
     {
     public:
@@ -0,0 +1,409 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "DrawCallClusters.h"
+#include "../Metal/DeviceContext.h"     // for Metal::Topology
+#include "../../Math/Math.h"
+#include "../../Core/Exceptions.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+#include <assert.h>
+#include <emmintrin.h>
+
+namespace RenderCore { namespace Assets
+{
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+    //      c u l l i n g       //
+
+        //  Frustum planes in the same space as the clusters, as (a, b, c, d) where
+        //  ax + by + cz + d >= 0 for points inside. Planes are normalized, so
+        //  distances can be compared against sphere radii
+    static void ExtractFrustumPlanes(Float4 planes[6], const Float4x4& localToProjection)
+    {
+        for (unsigned c=0; c<4; ++c) {
+            const auto x = localToProjection(0,c), y = localToProjection(1,c);
+            const auto z = localToProjection(2,c), w = localToProjection(3,c);
+            planes[0][c] = w + x; planes[1][c] = w - x;     // left, right
+            planes[2][c] = w + y; planes[3][c] = w - y;     // bottom, top
+            planes[4][c] = z;     planes[5][c] = w - z;     // near (z >= 0), far
+        }
+        for (unsigned p=0; p<6; ++p) {
+            auto mag = std::sqrt(planes[p][0]*planes[p][0] + planes[p][1]*planes[p][1] + planes[p][2]*planes[p][2]);
+            if (mag > 0.f) planes[p] /= mag;
+        }
+    }
+
+    static bool IsCulled(
+        const DrawCallCluster& cluster, const Float4 planes[6],
+        const Float3& localSpaceView, bool backfaceCulling)
+    {
+        const auto& c = cluster._sphereCentre;
+        for (unsigned p=0; p<6; ++p)
+            if (planes[p][0]*c[0] + planes[p][1]*c[1] + planes[p][2]*c[2] + planes[p][3] < -cluster._sphereRadius)
+                return true;
+
+        if (backfaceCulling) {
+                //  Every triangle is back facing if the view direction is within the cone
+                //  (with some extra allowance for the size of the bounding sphere)
+            auto offset = c - localSpaceView;
+            auto distance = std::sqrt(offset[0]*offset[0] + offset[1]*offset[1] + offset[2]*offset[2]);
+            if (Dot(offset, cluster._coneAxis) > cluster._coneCutoff * distance + cluster._sphereRadius)
+                return true;
+        }
+        return false;
+    }
+
+    static void AppendRange(std::vector<std::pair<unsigned, unsigned>>& ranges, const DrawCallCluster& cluster)
+    {
+        if (!ranges.empty() && (ranges.back().first + ranges.back().second) == cluster._firstIndex) {
+            ranges.back().second += cluster._indexCount;
+        } else
+            ranges.push_back(std::make_pair(cluster._firstIndex, cluster._indexCount));
+    }
+
+    unsigned CullDrawCallClusters(
+        std::vector<std::pair<unsigned, unsigned>>& visibleRanges,
+        IteratorRange<const DrawCallCluster*> clusters,
+        const Float4x4& localToProjection,
+        const Float3& localSpaceView,
+        bool backfaceCulling)
+    {
+        Float4 planes[6];
+        ExtractFrustumPlanes(planes, localToProjection);
+
+            //  Clusters are tested 4 at a time. The bounding spheres and the cones
+            //  are each 16 bytes in the cluster structure, so we can load them directly
+            //  and transpose into SoA form.
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (unsigned p=0; p<6; ++p) {
+            planeX[p] = _mm_set1_ps(planes[p][0]); planeY[p] = _mm_set1_ps(planes[p][1]);
+            planeZ[p] = _mm_set1_ps(planes[p][2]); planeW[p] = _mm_set1_ps(planes[p][3]);
+        }
+        const auto viewX = _mm_set1_ps(localSpaceView[0]);
+        const auto viewY = _mm_set1_ps(localSpaceView[1]);
+        const auto viewZ = _mm_set1_ps(localSpaceView[2]);
+        const auto signMask = _mm_set1_ps(-0.f);
+
+        unsigned visibleCount = 0;
+        const auto* i = clusters.begin();
+        for (; (i+4)<=clusters.end(); i+=4) {
+            auto cx = _mm_loadu_ps(&i[0]._sphereCentre[0]);
+            auto cy = _mm_loadu_ps(&i[1]._sphereCentre[0]);
+            auto cz = _mm_loadu_ps(&i[2]._sphereCentre[0]);
+            auto radius = _mm_loadu_ps(&i[3]._sphereCentre[0]);
+            _MM_TRANSPOSE4_PS(cx, cy, cz, radius);
+            const auto negRadius = _mm_xor_ps(radius, signMask);
+
+            auto culled = _mm_setzero_ps();
+            for (unsigned p=0; p<6; ++p) {
+                auto d = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                    _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+                culled = _mm_or_ps(culled, _mm_cmplt_ps(d, negRadius));
+            }
+
+            if (backfaceCulling) {
+                auto ax = _mm_loadu_ps(&i[0]._coneAxis[0]);
+                auto ay = _mm_loadu_ps(&i[1]._coneAxis[0]);
+                auto az = _mm_loadu_ps(&i[2]._coneAxis[0]);
+                auto cutoff = _mm_loadu_ps(&i[3]._coneAxis[0]);
+                _MM_TRANSPOSE4_PS(ax, ay, az, cutoff);
+
+                auto dx = _mm_sub_ps(cx, viewX), dy = _mm_sub_ps(cy, viewY), dz = _mm_sub_ps(cz, viewZ);
+                auto distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+                auto d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ax), _mm_mul_ps(dy, ay)), _mm_mul_ps(dz, az));
+                culled = _mm_or_ps(culled, _mm_cmpgt_ps(d, _mm_add_ps(_mm_mul_ps(cutoff, distance), radius)));
+            }
+
+            auto culledMask = _mm_movemask_ps(culled);
+            if (culledMask == 0xf) continue;
+            for (unsigned c=0; c<4; ++c)
+                if (!(culledMask & (1<<c))) {
+                    AppendRange(visibleRanges, i[c]);
+                    ++visibleCount;
+                }
+        }
+
+        for (; i<clusters.end(); ++i)
+            if (!IsCulled(*i, planes, localSpaceView, backfaceCulling)) {
+                AppendRange(visibleRanges, *i);
+                ++visibleCount;
+            }
+
+        return visibleCount;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+    //      b u i l d i n g       //
+
+    namespace GeoProc
+    {
+        static uint32 ExpandBits10(uint32 v)
+        {
+            v &= 0x3ff;
+            v = (v | (v << 16)) & 0x030000ff;
+            v = (v | (v <<  8)) & 0x0300f00f;
+            v = (v | (v <<  4)) & 0x030c30c3;
+            v = (v | (v <<  2)) & 0x09249249;
+            return v;
+        }
+
+        static uint32 MortonCode(const Float3& pt, const Float3& mins, const Float3& scale)
+        {
+            uint32 result = 0;
+            for (unsigned c=0; c<3; ++c) {
+                auto q = uint32(Clamp((pt[c] - mins[c]) * scale[c], 0.f, 1023.f));
+                result |= ExpandBits10(q) << c;
+            }
+            return result;
+        }
+
+        class ClusterBuilder
+        {
+        public:
+            IteratorRange<const Float3*> _positions;
+            unsigned _maxTriangles;
+
+                // (working memory, reused for each draw call)
+            std::vector<Float3> _centroids, _normals;
+            std::vector<unsigned> _vertexTriangleStarts, _vertexTriangles;
+            std::vector<unsigned> _seedOrder, _candidates, _candidateStamps, _newOrder;
+            std::vector<uint8> _assigned;
+
+            template<typename Index>
+                void Build(
+                    std::vector<DrawCallCluster>& result,
+                    Index* indices, const DrawCallDesc& drawCall, unsigned drawCallIndex);
+
+        private:
+            template<typename Index>
+                void BuildTriangleInfo(const Index* indices, unsigned triangleCount, unsigned firstVertex);
+            template<typename Index>
+                DrawCallCluster CalculateBounds(
+                    const Index* indices, unsigned firstVertex,
+                    const unsigned* trianglesBegin, const unsigned* trianglesEnd);
+        };
+
+        template<typename Index>
+            void ClusterBuilder::BuildTriangleInfo(const Index* indices, unsigned triangleCount, unsigned firstVertex)
+        {
+            const auto vertexCount = unsigned(_positions.size());
+            _centroids.resize(triangleCount);
+            _normals.resize(triangleCount);
+            _vertexTriangleStarts.clear();
+            _vertexTriangleStarts.resize(vertexCount+1, 0);
+            for (unsigned t=0; t<triangleCount; ++t) {
+                unsigned v[3];
+                for (unsigned c=0; c<3; ++c) {
+                    v[c] = unsigned(indices[t*3+c]) + firstVertex;
+                    if (v[c] >= vertexCount)
+                        Throw(::Exceptions::BasicLabel("Index out of range while building draw call clusters"));
+                    ++_vertexTriangleStarts[v[c]+1];
+                }
+                const auto &a = _positions[v[0]], &b = _positions[v[1]], &c = _positions[v[2]];
+                _centroids[t] = (a + b + c) / 3.f;
+                    // (counter clockwise triangles are front facing)
+                Float3 n = Cross(Float3(b - a), Float3(c - a));
+                if (!Normalize_Checked(&_normals[t], n))
+                    _normals[t] = Zero<Float3>();
+            }
+
+                //  Build the list of triangles that use each vertex (for finding neighbours)
+            for (unsigned v=0; v<vertexCount; ++v)
+                _vertexTriangleStarts[v+1] += _vertexTriangleStarts[v];
+            _vertexTriangles.resize(triangleCount*3);
+            std::vector<unsigned> writeCursor(_vertexTriangleStarts.begin(), _vertexTriangleStarts.end()-1);
+            for (unsigned t=0; t<triangleCount; ++t)
+                for (unsigned c=0; c<3; ++c)
+                    _vertexTriangles[writeCursor[unsigned(indices[t*3+c]) + firstVertex]++] = t;
+        }
+
+        template<typename Index>
+            DrawCallCluster ClusterBuilder::CalculateBounds(
+                const Index* indices, unsigned firstVertex,
+                const unsigned* trianglesBegin, const unsigned* trianglesEnd)
+        {
+            DrawCallCluster result;
+
+                //  Sphere around the center of the bounding box. This isn't the smallest
+                //  sphere, but it's usually close for small, compact clusters
+            Float3 mins( FLT_MAX,  FLT_MAX,  FLT_MAX);
+            Float3 maxs(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (auto t=trianglesBegin; t!=trianglesEnd; ++t)
+                for (unsigned c=0; c<3; ++c) {
+                    const auto& p = _positions[unsigned(indices[(*t)*3+c]) + firstVertex];
+                    for (unsigned q=0; q<3; ++q) {
+                        mins[q] = std::min(mins[q], p[q]);
+                        maxs[q] = std::max(maxs[q], p[q]);
+                    }
+                }
+            result._sphereCentre = .5f * (mins + maxs);
+            float radiusSq = 0.f;
+            for (auto t=trianglesBegin; t!=trianglesEnd; ++t)
+                for (unsigned c=0; c<3; ++c)
+                    radiusSq = std::max(radiusSq, MagnitudeSquared(Float3(_positions[unsigned(indices[(*t)*3+c]) + firstVertex] - result._sphereCentre)));
+                // (a little bit of extra room for floating point creep)
+            result._sphereRadius = std::sqrt(radiusSq) * (1.f + 1e-5f);
+
+                //  Normal cone. The axis is the average facing direction, and the
+                //  cutoff depends on the triangle that is furthest from the axis.
+                //  If some triangles are perpendicular to the axis (or facing away)
+                //  the cone can never cull anything.
+            Float3 axisSum = Zero<Float3>();
+            for (auto t=trianglesBegin; t!=trianglesEnd; ++t)
+                axisSum += _normals[*t];
+            result._coneAxis = Zero<Float3>();
+            result._coneCutoff = 1.f;
+            Float3 axis;
+            if (Normalize_Checked(&axis, axisSum)) {
+                float minDot = 1.f;
+                for (auto t=trianglesBegin; t!=trianglesEnd; ++t)
+                    if (MagnitudeSquared(_normals[*t]) > 0.f)
+                        minDot = std::min(minDot, Dot(_normals[*t], axis));
+                if (minDot > 0.f) {
+                    result._coneAxis = axis;
+                    result._coneCutoff = std::min(std::sqrt(std::max(1.f - minDot*minDot, 0.f)) + 1e-5f, 1.f);
+                }
+            }
+            return result;
+        }
+
+        template<typename Index>
+            void ClusterBuilder::Build(
+                std::vector<DrawCallCluster>& result,
+                Index* indices, const DrawCallDesc& drawCall, unsigned drawCallIndex)
+        {
+            const auto triangleCount = drawCall._indexCount / 3;
+            if (!triangleCount) return;
+            BuildTriangleInfo(indices, triangleCount, drawCall._firstVertex);
+
+                //  New clusters start from the first unassigned triangle in Morton order. So
+                //  when a cluster can't grow through connected triangles, the next cluster
+                //  starts somewhere nearby.
+            Float3 mins( FLT_MAX,  FLT_MAX,  FLT_MAX);
+            Float3 maxs(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const auto& c:_centroids)
+                for (unsigned q=0; q<3; ++q) {
+                    mins[q] = std::min(mins[q], c[q]);
+                    maxs[q] = std::max(maxs[q], c[q]);
+                }
+            Float3 scale;
+            for (unsigned q=0; q<3; ++q)
+                scale[q] = (maxs[q] > mins[q]) ? (1023.f / (maxs[q] - mins[q])) : 0.f;
+
+            std::vector<std::pair<uint32, unsigned>> codes;
+            codes.reserve(triangleCount);
+            for (unsigned t=0; t<triangleCount; ++t)
+                codes.push_back(std::make_pair(MortonCode(_centroids[t], mins, scale), t));
+            std::sort(codes.begin(), codes.end());
+            _seedOrder.clear();
+            for (const auto& c:codes) _seedOrder.push_back(c.second);
+
+            _assigned.clear();
+            _assigned.resize(triangleCount, 0);
+            _candidateStamps.clear();
+            _candidateStamps.resize(triangleCount, ~0u);
+            _newOrder.clear();
+            _newOrder.reserve(triangleCount);
+
+            auto seedCursor = _seedOrder.cbegin();
+            while (_newOrder.size() < triangleCount) {
+                while (_assigned[*seedCursor]) ++seedCursor;
+
+                const auto clusterStart = _newOrder.size();
+                const auto stamp = unsigned(result.size());
+                Float3 centroidSum = Zero<Float3>(), normalSum = Zero<Float3>();
+                _candidates.clear();
+                _candidates.push_back(*seedCursor);
+
+                while ((_newOrder.size() - clusterStart) < _maxTriangles) {
+                        //  Choose the candidate closest to the cluster center, with a
+                        //  penalty for facing a different direction to the cluster
+                    unsigned bestCandidate = ~0u;
+                    float bestScore = FLT_MAX;
+                    const auto triCount = float(_newOrder.size() - clusterStart);
+                    const Float3 centre = triCount ? Float3(centroidSum / triCount) : _centroids[_candidates[0]];
+                    Float3 facing = Zero<Float3>();
+                    Normalize_Checked(&facing, normalSum);
+                    for (size_t c=0; c<_candidates.size();) {
+                        auto t = _candidates[c];
+                        if (_assigned[t]) {
+                            _candidates[c] = _candidates.back();
+                            _candidates.pop_back();
+                            continue;
+                        }
+                        auto score = MagnitudeSquared(Float3(_centroids[t] - centre)) * (2.f - Dot(_normals[t], facing));
+                        if (score < bestScore) { bestScore = score; bestCandidate = t; }
+                        ++c;
+                    }
+                    if (bestCandidate == ~0u) break;   // nothing connected remains
+
+                    _assigned[bestCandidate] = 1;
+                    _newOrder.push_back(bestCandidate);
+                    centroidSum += _centroids[bestCandidate];
+                    normalSum += _normals[bestCandidate];
+
+                    for (unsigned c=0; c<3; ++c) {
+                        auto v = unsigned(indices[bestCandidate*3+c]) + drawCall._firstVertex;
+                        for (auto i=_vertexTriangleStarts[v]; i<_vertexTriangleStarts[v+1]; ++i) {
+                            auto neighbour = _vertexTriangles[i];
+                            if (!_assigned[neighbour] && _candidateStamps[neighbour] != stamp) {
+                                _candidateStamps[neighbour] = stamp;
+                                _candidates.push_back(neighbour);
+                            }
+                        }
+                    }
+                }
+
+                auto cluster = CalculateBounds(
+                    indices, drawCall._firstVertex,
+                    AsPointer(_newOrder.cbegin() + clusterStart), AsPointer(_newOrder.cend()));
+                cluster._firstIndex = drawCall._firstIndex + unsigned(clusterStart * 3);
+                cluster._indexCount = unsigned((_newOrder.size() - clusterStart) * 3);
+                cluster._drawCallIndex = drawCallIndex;
+                result.push_back(cluster);
+            }
+
+                //  Reorder the triangles in the index buffer, so each cluster is contiguous
+            std::vector<Index> reordered(triangleCount*3);
+            for (unsigned t=0; t<triangleCount; ++t)
+                for (unsigned c=0; c<3; ++c)
+                    reordered[t*3+c] = indices[_newOrder[t]*3+c];
+            std::copy(reordered.begin(), reordered.end(), indices);
+        }
+
+        std::vector<DrawCallCluster> BuildDrawCallClusters(
+            void* indexBuffer, Metal::NativeFormat::Enum indexFormat,
+            IteratorRange<const DrawCallDesc*> drawCalls,
+            IteratorRange<const Float3*> positions,
+            unsigned maxTrianglesPerCluster)
+        {
+            if (indexFormat != Metal::NativeFormat::R16_UINT && indexFormat != Metal::NativeFormat::R32_UINT)
+                Throw(::Exceptions::BasicLabel("Unsupported index format while building draw call clusters"));
+
+            std::vector<DrawCallCluster> result;
+            ClusterBuilder builder;
+            builder._positions = positions;
+            builder._maxTriangles = std::max(maxTrianglesPerCluster, 1u);
+
+            for (unsigned d=0; d<unsigned(drawCalls.size()); ++d) {
+                const auto& drawCall = drawCalls[d];
+                if (drawCall._topology != Metal::Topology::TriangleList) continue;
+
+                if (indexFormat == Metal::NativeFormat::R16_UINT) {
+                    builder.Build(result, &((uint16*)indexBuffer)[drawCall._firstIndex], drawCall, d);
+                } else {
+                    builder.Build(result, &((uint32*)indexBuffer)[drawCall._firstIndex], drawCall, d);
+                }
+            }
+            return result;
+        }
+    }
+
+}}
+
@@ -0,0 +1,59 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "ModelScaffoldInternal.h"
+#include "../Metal/Format.h"
+#include "../../Math/Vector.h"
+#include "../../Math/Matrix.h"
+#include "../../Utility/IteratorUtils.h"
+#include <vector>
+#include <utility>
+
+namespace RenderCore { namespace Assets
+{
+    /// <summary>Culls the clusters within a draw call</summary>
+    /// Clusters are culled if their bounding sphere is outside of the frustum, or (when
+    /// "backfaceCulling" is set) if every triangle in the cluster faces away from the view
+    /// position. Triangles are front facing when they are counter clockwise (which matches
+    /// the default rasterizer state). The backface test is only valid for materials that
+    /// are single sided, and for transforms that don't mirror or non-uniformly scale.
+    ///
+    /// "localToProjection" should transform the vertex positions into clip space (with
+    /// clip space z between 0 and w). "localSpaceView" is the view position in the same
+    /// space as the vertex positions.
+    ///
+    /// The index ranges (first index, index count) of visible clusters are appended to
+    /// "visibleRanges". Adjacent visible clusters are combined into a single range, so
+    /// when nothing is culled, the result is just the range of the whole draw call.
+    /// Returns the number of visible clusters.
+    unsigned CullDrawCallClusters(
+        std::vector<std::pair<unsigned, unsigned>>& visibleRanges,
+        IteratorRange<const DrawCallCluster*> clusters,
+        const Float4x4& localToProjection,
+        const Float3& localSpaceView,
+        bool backfaceCulling = true);
+
+    namespace GeoProc
+    {
+        /// <summary>Splits draw calls into small clusters of triangles</summary>
+        /// Triangles within each draw call are grouped into clusters of at most
+        /// "maxTrianglesPerCluster" triangles. Clusters are grown across connected
+        /// triangles, preferring nearby triangles facing the same way (so the bounding
+        /// spheres and normal cones are tight). The triangles in the index buffer are
+        /// reordered within each draw call, so that each cluster is a contiguous range of
+        /// indices. The draw calls themselves are not changed.
+        ///
+        /// Only triangle list draw calls are split. The result is sorted by draw call.
+        std::vector<DrawCallCluster> BuildDrawCallClusters(
+            void* indexBuffer, Metal::NativeFormat::Enum indexFormat,
+            IteratorRange<const DrawCallDesc*> drawCalls,
+            IteratorRange<const Float3*> positions,
+            unsigned maxTrianglesPerCluster = 96);
+    }
+}}
+
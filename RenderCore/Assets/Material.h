@@ -91,7 +91,7 @@ namespace RenderCore { namespace Assets
         MaterialScaffold& operator=(MaterialScaffold&& moveFrom) never_throws;
         ~MaterialScaffold();
     protected:
-        std::unique_ptr<uint8[]> _rawMemoryBlock;
+        std::shared_ptr<uint8> _rawMemoryBlock;
 
         static void Resolver(void*, IteratorRange<::Assets::AssetChunkResult*>);
         const MaterialImmutableData*   TryImmutableData() const;
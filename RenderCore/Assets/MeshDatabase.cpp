@@ -12,6 +12,7 @@
 #include "../../Utility/MemoryUtils.h"
 #include "../../Utility/IteratorUtils.h"
 #include "../../Utility/BitUtils.h"
+#include "../../Utility/Threading/CompletionThreadPool.h"
 #include "../../Foreign/half-1.9.2/include/half.hpp"
 #include <iterator>
 
@@ -19,7 +20,7 @@ namespace RenderCore { namespace Assets { namespace GeoProc
 {
     using ::Assets::Exceptions::FormatError;
 
-    enum class ComponentType { Float32, Float16, UNorm8 };
+    enum class ComponentType { Float32, Float16, UNorm8, UNorm16, SNorm16 };
     static std::pair<ComponentType, unsigned> BreakdownFormat(Metal::NativeFormat::Enum fmt);
     static unsigned short AsFloat16(float input);
     static float AsFloat32(unsigned short f16input);
@@ -52,11 +53,22 @@ namespace RenderCore { namespace Assets { namespace GeoProc
             _streams.erase(_streams.begin() + elementIndex);
     }
 
+    void        MeshDatabase::RemapUnifiedVertices(IteratorRange<const unsigned*> newToOldUnified)
+    {
+        for (auto& s:_streams) {
+            std::vector<unsigned> newVertexMap(newToOldUnified.begin(), newToOldUnified.end());
+            if (!s._vertexMap.empty())
+                for (auto& i:newVertexMap) i = s._vertexMap[i];
+            s._vertexMap = std::move(newVertexMap);
+        }
+        _unifiedVertexCount = newToOldUnified.size();
+    }
+
     template<typename Type> 
         Type MeshDatabase::GetUnifiedElement(size_t vertexIndex, unsigned elementIndex) const
     {
         auto& stream = _streams[elementIndex];
-        auto indexInStream = stream.GetVertexMap()[vertexIndex];
+        auto indexInStream = stream.UnifiedToStream(unsigned(vertexIndex));
         auto& sourceData = stream.GetSourceData();
         return GetVertex<Type>(sourceData, indexInStream);
     }
@@ -242,6 +254,11 @@ namespace RenderCore { namespace Assets { namespace GeoProc
         auto brkdn = BreakdownFormat(source.GetFormat());
         if (!brkdn.second) return Metal::NativeFormat::Unknown;
 
+            //  16 bit normalized formats only come from QuantizeVertexStreams(). That data has
+            //  already been encoded for the vertex buffer, so it must be written unchanged
+        if (brkdn.first == ComponentType::UNorm16 || brkdn.first == ComponentType::SNorm16)
+            return source.GetFormat();
+
         if (source.GetFormatHint() & FormatHint::IsColor) {
             if (brkdn.second == 1)          return Metal::NativeFormat::R8_UNORM;
             else if (brkdn.second == 2)     return Metal::NativeFormat::R8G8_UNORM;
@@ -438,6 +455,18 @@ namespace RenderCore { namespace Assets { namespace GeoProc
         case ComponentType::Float16:
             GetVertDataF16(dst, (const uint16*)src, fmt.second, processingFlags);
             break;
+        case ComponentType::UNorm8:
+            for (unsigned c=0; c<4; ++c)
+                dst[c] = (c < fmt.second) ? (float(((const uint8*)src)[c]) / 255.f) : ((c < 3) ? 0.f : 1.f);
+            break;
+        case ComponentType::UNorm16:
+            for (unsigned c=0; c<4; ++c)
+                dst[c] = (c < fmt.second) ? (float(((const uint16*)src)[c]) / 65535.f) : ((c < 3) ? 0.f : 1.f);
+            break;
+        case ComponentType::SNorm16:
+            for (unsigned c=0; c<4; ++c)
+                dst[c] = (c < fmt.second) ? std::max(float(((const int16*)src)[c]) / 32767.f, -1.f) : ((c < 3) ? 0.f : 1.f);
+            break;
         default:
             assert(0);
             break;
@@ -563,6 +592,17 @@ namespace RenderCore { namespace Assets { namespace GeoProc
                 }
             }
 
+        } else if (srcFmt == dstFmt && (srcFormat.first == ComponentType::UNorm16 || srcFormat.first == ComponentType::SNorm16)) {
+
+                // simple copy of pre-quantized data (see QuantizeVertexStreams)
+            auto elementSize = Metal::BitsPerPixel(srcFmt) / 8;
+            for (unsigned v = 0; v<count; ++v, dst = PtrAdd(dst, dstStride)) {
+                auto srcIndex = (v < mapping.size()) ? mapping[v] : v;
+                assert(srcIndex * srcStride + elementSize <= srcDataSize);
+                assert(elementSize <= dstStride);
+                XlCopyMemory((void*)dst, PtrAdd(src, srcIndex * srcStride), elementSize);
+            }
+
         } else {
             Throw(FormatError("Error while copying vertex data. Format not supported."));
         }
@@ -824,6 +864,657 @@ namespace RenderCore { namespace Assets { namespace GeoProc
             sourceStream.GetFormat());
     }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    enum class WeldCompareType { Position, Direction, Components, SourceIndex };
+
+    class WeldStream
+    {
+    public:
+        const void*         _data;
+        size_t              _stride;
+        std::pair<ComponentType, unsigned> _format;
+        ProcessingFlags::BitField _processingFlags;
+        const unsigned*     _vertexMap;         // (null when the stream has no vertex map)
+        WeldCompareType     _compareType;
+        float               _threshold;         // (cosine of the hard edge angle for directions)
+
+        unsigned StreamIndex(unsigned unifiedIndex) const { return _vertexMap ? _vertexMap[unifiedIndex] : unifiedIndex; }
+        void Get(float dst[4], unsigned streamIndex) const
+        {
+            GetVertData(dst, PtrAdd(_data, streamIndex * _stride), _format, _processingFlags);
+        }
+    };
+
+    static bool WeldCompare(const WeldStream& stream, unsigned a, unsigned b)
+    {
+        auto streamA = stream.StreamIndex(a), streamB = stream.StreamIndex(b);
+        if (streamA == streamB) return true;
+        if (stream._compareType == WeldCompareType::SourceIndex) return false;
+
+        float va[4], vb[4];
+        stream.Get(va, streamA);
+        stream.Get(vb, streamB);
+        switch (stream._compareType) {
+        case WeldCompareType::Position:
+            {
+                float dx = va[0]-vb[0], dy = va[1]-vb[1], dz = va[2]-vb[2];
+                return (dx*dx + dy*dy + dz*dz) <= stream._threshold * stream._threshold;
+            }
+
+        case WeldCompareType::Direction:
+            {
+                    // (the 4th component of a tangent is the handedness)
+                if ((va[3] < 0.f) != (vb[3] < 0.f)) return false;
+                float magSqA = va[0]*va[0] + va[1]*va[1] + va[2]*va[2];
+                float magSqB = vb[0]*vb[0] + vb[1]*vb[1] + vb[2]*vb[2];
+                if ((magSqA == 0.f) != (magSqB == 0.f)) return false;
+                float d = va[0]*vb[0] + va[1]*vb[1] + va[2]*vb[2];
+                return d >= stream._threshold * XlSqrt(magSqA * magSqB);
+            }
+
+        default:
+            for (unsigned c=0; c<4; ++c)
+                if (!(XlAbs(va[c] - vb[c]) <= stream._threshold)) return false;
+            return true;
+        }
+    }
+
+    static bool WeldMatch(const std::vector<WeldStream>& streams, unsigned a, unsigned b)
+    {
+        for (const auto& s:streams)
+            if (!WeldCompare(s, a, b)) return false;
+        return true;
+    }
+
+    static float FindWeldThreshold(const WeldingSettings& settings, const std::string& semantic)
+    {
+        for (const auto& t:settings._semanticThresholds)
+            if (!XlCompareStringI(t.first.c_str(), semantic.c_str())) return t.second;
+        return settings._defaultThreshold;
+    }
+
+    static uint32 WeldCellHash(const Int3& cell)
+    {
+        auto h = (uint32(cell[0]) * 0x8da6b343u) ^ (uint32(cell[1]) * 0xd8163841u) ^ (uint32(cell[2]) * 0xcb1ab31fu);
+        h ^= h >> 16; h *= 0x7feb352du; h ^= h >> 15;
+        return h;
+    }
+
+        //  The grid cells are split into partitions by the top bits of their hash. Each
+        //  partition has its own hash table, so the tables can be built in parallel
+    static const unsigned WeldPartitionBits = 6;
+    static const unsigned WeldPartitionCount = 1u << WeldPartitionBits;
+    static unsigned WeldPartition(uint32 hash) { return hash >> (32 - WeldPartitionBits); }
+
+    class WeldCellTable
+    {
+    public:
+            //  Open addressing table of cell -> first vertex in that cell
+            //  (the rest of the vertices in the cell are linked through "nextInCell")
+        std::vector<std::pair<Int3, unsigned>>  _slots;
+        unsigned                                _mask;
+
+        unsigned Find(const Int3& cell, uint32 hash) const
+        {
+            if (_slots.empty()) return ~0u;
+            for (auto i=hash&_mask;; i=(i+1)&_mask) {
+                const auto& s = _slots[i];
+                if (s.second == ~0u) return ~0u;
+                if (s.first == cell) return s.second;
+            }
+        }
+
+        WeldCellTable() : _mask(0) {}
+    };
+
+    template<typename Fn>
+        static void WeldForEach(CompletionThreadPool* pool, unsigned taskCount, Fn& fn)
+    {
+        if (pool && taskCount > 1) {
+            if (!ParallelFor(*pool, taskCount, fn))
+                Throw(::Exceptions::BasicLabel("Failure while welding vertices"));
+        } else {
+            for (unsigned t=0; t<taskCount; ++t) fn(t);
+        }
+    }
+
+    void WeldVertices(
+        std::vector<unsigned>& outputMapping,
+        MeshDatabase& mesh,
+        const WeldingSettings& settings,
+        CompletionThreadPool* pool)
+    {
+        const auto vertexCount = unsigned(mesh.GetUnifiedVertexCount());
+        outputMapping.resize(vertexCount);
+        for (unsigned c=0; c<vertexCount; ++c) outputMapping[c] = c;
+
+        auto positionElement = mesh.FindElement("POSITION");
+        if (positionElement == ~0u || vertexCount < 2) return;
+
+            //  Prepare the streams for comparisons. Positions go first, because that's
+            //  the comparison most likely to reject a candidate
+        const float cosHardEdge = XlCos(settings._hardEdgeAngle);
+        std::vector<WeldStream> streams;
+        streams.reserve(mesh.GetStreams().size());
+        for (const auto& s:mesh.GetStreams()) {
+            const auto& sourceData = s.GetSourceData();
+            const auto& semantic = s.GetSemanticName();
+            WeldStream w;
+            w._data = sourceData.GetData();
+            w._stride = sourceData.GetStride();
+            w._format = BreakdownFormat(sourceData.GetFormat());
+            w._processingFlags = sourceData.GetProcessingFlags();
+            w._vertexMap = s.GetVertexMap().empty() ? nullptr : AsPointer(s.GetVertexMap().cbegin());
+            if (!XlCompareStringI(semantic.c_str(), "POSITION")) {
+                w._compareType = WeldCompareType::Position;
+                w._threshold = FindWeldThreshold(settings, semantic);
+            } else if (!XlCompareStringI(semantic.c_str(), "NORMAL") 
+                    || !XlCompareStringI(semantic.c_str(), "TEXTANGENT")
+                    || !XlCompareStringI(semantic.c_str(), "TEXBITANGENT")) {
+                w._compareType = WeldCompareType::Direction;
+                w._threshold = cosHardEdge;
+            } else {
+                w._compareType = WeldCompareType::Components;
+                w._threshold = FindWeldThreshold(settings, semantic);
+            }
+            streams.push_back(w);
+        }
+
+        if (settings._matchPositionIndices) {
+            auto w = streams[0];
+            w._compareType = WeldCompareType::SourceIndex;
+            streams.push_back(w);
+        }
+        std::swap(streams[0], streams[positionElement]);
+
+            //  Candidates are found by hashing positions into a grid with cells several times larger
+            //  than the threshold. Any vertex within the threshold must be in the same cell, or in
+            //  a neighbouring cell across a boundary that is within the threshold. Most vertices are
+            //  far from every boundary, so they only need to look in their own cell.
+        const auto& positions = streams[0];
+        const float cellSize = std::max(16.f * positions._threshold, 1e-6f);
+        const float nearBoundary = positions._threshold / cellSize;
+        const float cellLimit = float(1<<30);
+        const auto chunkSize = std::max(settings._chunkSize, 1u);
+        const auto chunkCount = (vertexCount + chunkSize - 1) / chunkSize;
+
+        std::vector<Int3> cells(vertexCount);
+        std::vector<uint32> hashes(vertexCount);
+        std::vector<uint8> nearBoundaries(vertexCount);
+        std::vector<unsigned> partitionOffsets(chunkCount * WeldPartitionCount, 0);
+        auto buildCells = [&](unsigned chunk)
+        {
+            auto* counts = &partitionOffsets[chunk * WeldPartitionCount];
+            auto end = std::min((chunk+1) * chunkSize, vertexCount);
+            for (auto v=chunk*chunkSize; v<end; ++v) {
+                float p[4];
+                positions.Get(p, positions.StreamIndex(v));
+                    //  (bits 0-2 are set when near a boundary on that axis, and bits 3-5 when
+                    //  that boundary is in the positive direction)
+                Int3 cell; uint8 near = 0;
+                for (unsigned c=0; c<3; ++c) {
+                    float f = p[c] / cellSize;
+                    if (!(f > -cellLimit)) f = -cellLimit;      // (also catches nans)
+                    if (!(f < cellLimit)) f = cellLimit;
+                    float fl = XlFloor(f);
+                    cell[c] = int(fl);
+                    if ((f - fl) <= nearBoundary) near |= 1<<c;
+                    else if ((f - fl) >= 1.f - nearBoundary) near |= (1<<c) | (1<<(c+3));
+                }
+                cells[v] = cell;
+                nearBoundaries[v] = near;
+                hashes[v] = WeldCellHash(cell);
+                ++counts[WeldPartition(hashes[v])];
+            }
+        };
+        WeldForEach(pool, chunkCount, buildCells);
+
+            //  Convert the per-chunk counts into offsets, and scatter the vertices into their
+            //  partitions. Within each partition, the vertices remain in ascending order
+        std::vector<unsigned> partitionStart(WeldPartitionCount+1, 0);
+        for (unsigned p=0; p<WeldPartitionCount; ++p) {
+            auto offset = partitionStart[p];
+            for (unsigned chunk=0; chunk<chunkCount; ++chunk) {
+                auto& o = partitionOffsets[chunk * WeldPartitionCount + p];
+                auto count = o;
+                o = offset;
+                offset += count;
+            }
+            partitionStart[p+1] = offset;
+        }
+
+        std::vector<unsigned> partitionedVertices(vertexCount);
+        auto scatter = [&](unsigned chunk)
+        {
+            auto* offsets = &partitionOffsets[chunk * WeldPartitionCount];
+            auto end = std::min((chunk+1) * chunkSize, vertexCount);
+            for (auto v=chunk*chunkSize; v<end; ++v)
+                partitionedVertices[offsets[WeldPartition(hashes[v])]++] = v;
+        };
+        WeldForEach(pool, chunkCount, scatter);
+
+        std::vector<WeldCellTable> tables(WeldPartitionCount);
+        std::vector<unsigned> nextInCell(vertexCount), cellHeads(vertexCount);
+        auto buildTable = [&](unsigned p)
+        {
+            auto begin = partitionStart[p], end = partitionStart[p+1];
+            if (begin == end) return;
+            auto& table = tables[p];
+            unsigned slotCount = 4;
+            while (slotCount < 2 * (end-begin)) slotCount <<= 1;
+            table._slots.resize(slotCount, std::make_pair(Int3(0,0,0), ~0u));
+            table._mask = slotCount-1;
+
+                //  walk backwards, so the list for each cell ends up in ascending order
+            for (auto i=end; i>begin; --i) {
+                auto v = partitionedVertices[i-1];
+                for (auto s=hashes[v]&table._mask;; s=(s+1)&table._mask) {
+                    auto& slot = table._slots[s];
+                    if (slot.second == ~0u) { slot.first = cells[v]; nextInCell[v] = ~0u; slot.second = v; cellHeads[v] = s; break; }
+                    if (slot.first == cells[v]) { nextInCell[v] = slot.second; slot.second = v; cellHeads[v] = s; break; }
+                }
+            }
+
+                //  record the first vertex in the cell for each vertex, so that most vertices
+                //  don't need any table lookups at all in the next step
+            for (auto i=begin; i<end; ++i) {
+                auto v = partitionedVertices[i];
+                cellHeads[v] = table._slots[cellHeads[v]].second;
+            }
+        };
+        WeldForEach(pool, WeldPartitionCount, buildTable);
+
+            //  Link each vertex to the lowest indexed earlier vertex that matches it
+        std::vector<unsigned> links(vertexCount);
+        auto findLinks = [&](unsigned chunk)
+        {
+            auto end = std::min((chunk+1) * chunkSize, vertexCount);
+            for (auto v=chunk*chunkSize; v<end; ++v) {
+                auto best = v;
+                auto near = nearBoundaries[v];
+                for (unsigned n=0; n<8; ++n) {
+                    if ((n & near) != n) continue;
+                    auto cell = cells[v];
+                    for (unsigned c=0; c<3; ++c)
+                        if (n & (1<<c)) cell[c] += (near & (1<<(c+3))) ? 1 : -1;
+                    auto u = cellHeads[v];
+                    if (n) {
+                        auto hash = WeldCellHash(cell);
+                        u = tables[WeldPartition(hash)].Find(cell, hash);
+                    }
+
+                        //  the lists are in ascending order, so we can stop at the best match so far
+                    for (; u<best; u=nextInCell[u])
+                        if (WeldMatch(streams, u, v)) { best = u; break; }
+                }
+                links[v] = best;
+            }
+        };
+        WeldForEach(pool, chunkCount, findLinks);
+
+            //  Follow the links to build groups. A vertex only joins the group of the vertex
+            //  it's linked to if it also matches the first vertex in that group (so groups
+            //  can't creep across hard edges, or further than the threshold)
+        std::vector<unsigned> groups(vertexCount);
+        std::vector<unsigned> newToOld;
+        newToOld.reserve(vertexCount);
+        for (unsigned v=0; v<vertexCount; ++v) {
+            auto group = v;
+            if (links[v] != v) {
+                group = groups[links[v]];
+                if (group != links[v] && !WeldMatch(streams, group, v))
+                    group = v;
+            }
+            groups[v] = group;
+            if (group == v) {
+                outputMapping[v] = unsigned(newToOld.size());
+                newToOld.push_back(v);
+            } else
+                outputMapping[v] = outputMapping[group];
+        }
+
+        if (newToOld.size() < vertexCount)
+            mesh.RemapUnifiedVertices(MakeIteratorRange(newToOld));
+    }
+
+    WeldingSettings::WeldingSettings()
+    {
+        _semanticThresholds.push_back(std::make_pair(std::string("POSITION"), 1e-4f));
+        _defaultThreshold = 1e-5f;
+        _hardEdgeAngle = Deg2Rad(1.f);
+        _matchPositionIndices = false;
+        _chunkSize = 16*1024;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static float SignNotZero(float value) { return (value < 0.f) ? -1.f : 1.f; }
+
+    Float2 EncodeOctahedral(Float3 unitVector)
+    {
+        float l1 = XlAbs(unitVector[0]) + XlAbs(unitVector[1]) + XlAbs(unitVector[2]);
+        if (l1 == 0.f) return Float2(0.f, 0.f);
+
+            //  Project onto the octahedron, and then fold the lower hemisphere out into
+            //  the corners of the square
+        Float2 result(unitVector[0] / l1, unitVector[1] / l1);
+        if (unitVector[2] < 0.f)
+            result = Float2(
+                (1.f - XlAbs(result[1])) * SignNotZero(result[0]),
+                (1.f - XlAbs(result[0])) * SignNotZero(result[1]));
+        return result;
+    }
+
+    Float3 DecodeOctahedral(Float2 encoded)
+    {
+        Float3 result(encoded[0], encoded[1], 1.f - XlAbs(encoded[0]) - XlAbs(encoded[1]));
+        if (result[2] < 0.f)
+            result = Float3(
+                (1.f - XlAbs(encoded[1])) * SignNotZero(encoded[0]),
+                (1.f - XlAbs(encoded[0])) * SignNotZero(encoded[1]),
+                result[2]);
+        return Normalize(result);
+    }
+
+    static float AngleBetween(Float3 lhs, Float3 rhs)
+    {
+            //  (acos loses too much precision for the very small angles we're measuring)
+        return XlATan2(Magnitude(Cross(lhs, rhs)), Dot(lhs, rhs));
+    }
+
+    static float SNorm16AsFloat(int value) { return std::max(float(value) / 32767.f, -1.f); }
+
+        //  For tangents, the handiness is stored in the sign of the second component. The 
+        //  magnitude of that component holds the octahedral y value remapped into [0, 1]
+        //  (and it can never be zero, so the sign is always preserved)
+    static Float3 DecodeOctahedralSNorm16(int x, int y, bool withHandiness)
+    {
+        if (withHandiness)
+            return DecodeOctahedral(Float2(SNorm16AsFloat(x), SNorm16AsFloat(std::abs(y)) * 2.f - 1.f));
+        return DecodeOctahedral(Float2(SNorm16AsFloat(x), SNorm16AsFloat(y)));
+    }
+
+    static void EncodeOctahedralSNorm16(int16 dst[2], Float3 unitVector, float handiness)
+    {
+        const bool withHandiness = handiness != 0.f;
+        auto encoded = EncodeOctahedral(unitVector);
+        if (withHandiness) encoded[1] = encoded[1] * .5f + .5f;
+        const int minY = withHandiness ? 1 : -32767;
+
+            //  Rounding each component independently isn't the most accurate option. So
+            //  we'll try each of the 4 surrounding quantized values and keep the one that
+            //  decodes closest to the input
+        int baseX = (int)XlFloor(Clamp(encoded[0], -1.f, 1.f) * 32767.f);
+        int baseY = (int)XlFloor(Clamp(encoded[1], -1.f, 1.f) * 32767.f);
+        float bestDot = -FLT_MAX;
+        int bestX = 0, bestY = 0;
+        for (int dy=0; dy<2; ++dy)
+            for (int dx=0; dx<2; ++dx) {
+                int x = Clamp(baseX + dx, -32767, 32767);
+                int y = Clamp(baseY + dy, minY, 32767);
+                float d = Dot(DecodeOctahedralSNorm16(x, y, withHandiness), unitVector);
+                if (d > bestDot) { bestDot = d; bestX = x; bestY = y; }
+            }
+
+        dst[0] = int16(bestX);
+        dst[1] = int16((withHandiness && handiness < 0.f) ? -bestY : bestY);
+    }
+
+    static std::vector<uint8> QuantizePositions(
+        float& maxError, Float4x4& geoSpaceToNodeSpace,
+        const IVertexSourceData& source)
+    {
+        auto count = source.GetCount();
+        Float3 mins(FLT_MAX, FLT_MAX, FLT_MAX), maxs(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (size_t v=0; v<count; ++v) {
+            auto p = GetVertex<Float3>(source, v);
+            for (unsigned c=0; c<3; ++c) {
+                mins[c] = std::min(mins[c], p[c]);
+                maxs[c] = std::max(maxs[c], p[c]);
+            }
+        }
+
+            //  We use the same scale on every axis, so the dequantization transform is just an
+            //  offset and a uniform scale. This way the shaders can transform normals through
+            //  the local-to-world transform as normal (they are renormalized anyway). It costs
+            //  some precision on the shorter axes.
+        float extent = std::max(std::max(maxs[0] - mins[0], maxs[1] - mins[1]), maxs[2] - mins[2]);
+        if (extent <= 0.f) extent = 1.f;
+
+        geoSpaceToNodeSpace = MakeFloat4x4(
+            extent, 0.f, 0.f, mins[0],
+            0.f, extent, 0.f, mins[1],
+            0.f, 0.f, extent, mins[2],
+            0.f, 0.f, 0.f, 1.f);
+
+        std::vector<uint8> result(count * 4 * sizeof(uint16));
+        auto* dst = (uint16*)AsPointer(result.begin());
+        maxError = 0.f;
+        for (size_t v=0; v<count; ++v) {
+            auto p = GetVertex<Float3>(source, v);
+            Float3 decoded;
+            for (unsigned c=0; c<3; ++c) {
+                auto q = (uint16)(Clamp((p[c] - mins[c]) / extent, 0.f, 1.f) * 65535.f + .5f);
+                dst[v*4+c] = q;
+                decoded[c] = mins[c] + float(q) / 65535.f * extent;
+            }
+            dst[v*4+3] = 0xffff;
+            maxError = std::max(maxError, Magnitude(Float3(decoded - p)));
+        }
+        return std::move(result);
+    }
+
+    static std::vector<uint8> QuantizeUnitVectors(
+        float& maxError,
+        const IVertexSourceData& source, bool withHandiness)
+    {
+        auto count = source.GetCount();
+        std::vector<uint8> result(count * 2 * sizeof(int16));
+        auto* dst = (int16*)AsPointer(result.begin());
+        maxError = 0.f;
+        for (size_t v=0; v<count; ++v) {
+            auto input = GetVertex<Float4>(source, v);
+            auto n = Truncate(input);
+            float magSq = MagnitudeSquared(n);
+            if (magSq < 1e-10f) {
+                    //  degenerate vector; no direction to preserve
+                EncodeOctahedralSNorm16(&dst[v*2], Float3(0.f, 0.f, 1.f), withHandiness ? SignNotZero(input[3]) : 0.f);
+                continue;
+            }
+            n = n / XlSqrt(magSq);
+            EncodeOctahedralSNorm16(&dst[v*2], n, withHandiness ? SignNotZero(input[3]) : 0.f);
+            auto decoded = DecodeOctahedralSNorm16(dst[v*2], dst[v*2+1], withHandiness);
+            maxError = std::max(maxError, AngleBetween(decoded, n));
+        }
+        return std::move(result);
+    }
+
+    static std::vector<uint8> QuantizeTexCoords(
+        float& maxError, Metal::NativeFormat::Enum& format, Float4* scaleOffset,
+        const IVertexSourceData& source, unsigned componentCount)
+    {
+        auto count = source.GetCount();
+        Float4 mins(FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX), maxs(-FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (size_t v=0; v<count; ++v) {
+            auto t = GetVertex<Float4>(source, v);
+            for (unsigned c=0; c<componentCount; ++c) {
+                mins[c] = std::min(mins[c], t[c]);
+                maxs[c] = std::max(maxs[c], t[c]);
+            }
+        }
+
+            //  When the caller can apply a scale and offset (as shader constants), we remap the
+            //  range of values in this mesh onto [0, 1]. That works for tiling texture coordinates
+            //  and for small ranges (where it gives us more precision). Otherwise we can only use
+            //  the normalized formats when every value is already within range.
+        Float4 scale(1.f, 1.f, 1.f, 1.f), offset(0.f, 0.f, 0.f, 0.f);
+        bool useUNorm;
+        if (scaleOffset) {
+            for (unsigned c=0; c<componentCount; ++c) {
+                offset[c] = mins[c];
+                scale[c] = (maxs[c] > mins[c]) ? (maxs[c] - mins[c]) : 1.f;
+            }
+            useUNorm = true;
+        } else {
+            float minValue = FLT_MAX, maxValue = -FLT_MAX;
+            for (unsigned c=0; c<componentCount; ++c) {
+                minValue = std::min(minValue, mins[c]);
+                maxValue = std::max(maxValue, maxs[c]);
+            }
+            useUNorm = minValue >= 0.f && maxValue <= 1.f;
+            bool useSNorm = minValue >= -1.f && maxValue <= 1.f;
+            if (!useUNorm && !useSNorm) return std::vector<uint8>();
+        }
+
+        auto outputComponents = (componentCount > 2) ? 4u : componentCount;
+        if (useUNorm) {
+            format = (outputComponents == 1) ? Metal::NativeFormat::R16_UNORM : ((outputComponents == 2) ? Metal::NativeFormat::R16G16_UNORM : Metal::NativeFormat::R16G16B16A16_UNORM);
+        } else {
+            format = (outputComponents == 1) ? Metal::NativeFormat::R16_SNORM : ((outputComponents == 2) ? Metal::NativeFormat::R16G16_SNORM : Metal::NativeFormat::R16G16B16A16_SNORM);
+        }
+
+        std::vector<uint8> result(count * outputComponents * sizeof(uint16));
+        maxError = 0.f;
+        for (size_t v=0; v<count; ++v) {
+            auto t = GetVertex<Float4>(source, v);
+            for (unsigned c=0; c<outputComponents; ++c) {
+                float value = (c < componentCount) ? t[c] : 1.f;
+                float decoded;
+                if (useUNorm) {
+                    auto q = (uint16)(Clamp((value - offset[c]) / scale[c], 0.f, 1.f) * 65535.f + .5f);
+                    ((uint16*)AsPointer(result.begin()))[v*outputComponents+c] = q;
+                    decoded = float(q) / 65535.f * scale[c] + offset[c];
+                } else {
+                    auto q = (int16)XlFloor(Clamp(value, -1.f, 1.f) * 32767.f + .5f);
+                    ((int16*)AsPointer(result.begin()))[v*outputComponents+c] = q;
+                    decoded = SNorm16AsFloat(q);
+                }
+                maxError = std::max(maxError, XlAbs(decoded - value));
+            }
+        }
+
+        if (scaleOffset)
+            *scaleOffset = Float4(scale[0], scale[1], offset[0], offset[1]);
+        return std::move(result);
+    }
+
+    QuantizationResult QuantizeVertexStreams(MeshDatabase& mesh, const QuantizationSettings& settings)
+    {
+        QuantizationResult result;
+        result._geoSpaceToNodeSpace = Identity<Float4x4>();
+        result._texCoordScaleOffset = Float4(1.f, 1.f, 0.f, 0.f);
+
+        for (unsigned s=0; s<unsigned(mesh.GetStreams().size()); ++s) {
+            const auto& stream = mesh.GetStreams()[s];
+            const auto& source = stream.GetSourceData();
+            auto brkdn = BreakdownFormat(source.GetFormat());
+
+                //  Only floating point streams are quantized. Anything else is either already
+                //  compact, or is something we don't understand (like colors or bone indices)
+            if (brkdn.first != ComponentType::Float32 && brkdn.first != ComponentType::Float16) continue;
+            if (!brkdn.second || !source.GetCount()) continue;
+
+            const auto& semantic = stream.GetSemanticName();
+            std::vector<uint8> encoded;
+            auto encodedFormat = Metal::NativeFormat::Unknown;
+            float maxError = 0.f, tolerance = 0.f;
+            Float4x4 geoSpaceToNodeSpace = Identity<Float4x4>();
+            Float4 texCoordScaleOffset(1.f, 1.f, 0.f, 0.f);
+
+            if (XlEqStringI(semantic, "POSITION") && stream.GetSemanticIndex() == 0 && brkdn.second >= 3) {
+                if (!settings._positions) continue;
+                encoded = QuantizePositions(maxError, geoSpaceToNodeSpace, source);
+                encodedFormat = Metal::NativeFormat::R16G16B16A16_UNORM;
+                tolerance = settings._positionTolerance;
+            } else if (
+                    (XlEqStringI(semantic, "NORMAL") || XlEqStringI(semantic, "TEXBITANGENT") || XlEqStringI(semantic, "TEXTANGENT"))
+                &&  brkdn.second >= 3) {
+                if (!settings._normals) continue;
+                encoded = QuantizeUnitVectors(maxError, source, XlEqStringI(semantic, "TEXTANGENT"));
+                encodedFormat = Metal::NativeFormat::R16G16_SNORM;
+                tolerance = settings._normalTolerance;
+            } else if (XlEqStringI(semantic, "TEXCOORD")) {
+                if (!settings._texCoords) continue;
+                    //  Only the main 2D texture coordinates get a scale and offset in the shaders
+                const bool remap = stream.GetSemanticIndex() == 0 && brkdn.second == 2;
+                encoded = QuantizeTexCoords(maxError, encodedFormat, remap ? &texCoordScaleOffset : nullptr, source, brkdn.second);
+                tolerance = settings._texCoordTolerance;
+            } else
+                continue;
+
+            if (encoded.empty()) continue;
+
+            QuantizationResult::Stream streamResult;
+            streamResult._semanticName = semantic;
+            streamResult._semanticIndex = stream.GetSemanticIndex();
+            streamResult._format = encodedFormat;
+            streamResult._maxError = maxError;
+            streamResult._quantized = maxError <= tolerance;
+            result._streams.push_back(streamResult);
+            if (!streamResult._quantized) continue;
+
+            if (XlEqStringI(semantic, "POSITION"))
+                result._geoSpaceToNodeSpace = geoSpaceToNodeSpace;
+            if (XlEqStringI(semantic, "TEXCOORD") && stream.GetSemanticIndex() == 0)
+                result._texCoordScaleOffset = texCoordScaleOffset;
+
+            auto vertexMap = stream.GetVertexMap();
+            auto semanticIndex = stream.GetSemanticIndex();
+            auto count = source.GetCount();
+            auto stride = Metal::BitsPerPixel(encodedFormat) / 8;
+            mesh.RemoveStream(s);
+            mesh.InsertStream(
+                s, CreateRawDataSource(std::move(encoded), count, stride, encodedFormat),
+                std::move(vertexMap), streamResult._semanticName.c_str(), semanticIndex);
+        }
+
+        return std::move(result);
+    }
+
+    QuantizationSettings::QuantizationSettings()
+    {
+        _positions = _normals = _texCoords = true;
+        _positionTolerance = 5e-3f;
+        _normalTolerance = Deg2Rad(.5f);
+        _texCoordTolerance = 1.f / 8192.f;
+    }
+
+    void QuantizeWeights(uint8 dst[], const float weights[], unsigned count)
+    {
+        if (!count) return;
+
+        float total = 0.f;
+        for (unsigned c=0; c<count; ++c) total += std::max(weights[c], 0.f);
+        if (total <= 0.f) {
+            for (unsigned c=0; c<count; ++c) dst[c] = 0;
+            dst[0] = 255;
+            return;
+        }
+
+            //  Round everything down, and then give the remaining units to the weights
+            //  that lost the most in rounding (largest remainder method)
+        float remainders[256];
+        assert(count <= dimof(remainders));
+        unsigned sum = 0;
+        for (unsigned c=0; c<count; ++c) {
+            float scaled = std::max(weights[c], 0.f) / total * 255.f;
+            auto q = std::min((unsigned)scaled, 255u);
+            dst[c] = uint8(q);
+            remainders[c] = scaled - float(q);
+            sum += q;
+        }
+
+        while (sum < 255) {
+            unsigned best = 0;
+            for (unsigned c=1; c<count; ++c)
+                if (remainders[c] > remainders[best]) best = c;
+            ++dst[best];
+            remainders[best] -= 1.f;
+            ++sum;
+        }
+    }
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
     size_t CreateTriangleWindingFromPolygon(unsigned buffer[], size_t bufferCount, size_t polygonVertexCount)
@@ -877,8 +1568,12 @@ namespace RenderCore { namespace Assets { namespace GeoProc
         case Metal::FormatComponentType::UNorm:
         case Metal::FormatComponentType::SNorm:
         case Metal::FormatComponentType::UNorm_SRGB:
-            assert(prec==8);
-            componentType = ComponentType::UNorm8;
+            if (prec == 16) {
+                componentType = (type == Metal::FormatComponentType::SNorm) ? ComponentType::SNorm16 : ComponentType::UNorm16;
+            } else {
+                assert(prec==8);
+                componentType = ComponentType::UNorm8;
+            }
             break;
         }
 
@@ -9,11 +9,15 @@
 #include "../Metal/Format.h"
 #include "../Metal/InputLayout.h"
 #include "../../Utility/IteratorUtils.h"
+#include "../../Math/Vector.h"
+#include "../../Math/Matrix.h"
 #include <utility>
 #include <memory>
 #include <vector>
 #include <string>
 
+namespace Utility { class CompletionThreadPool; }
+
 namespace RenderCore { namespace Assets { namespace GeoProc
 {
     namespace ProcessingFlags 
@@ -42,6 +46,7 @@ namespace RenderCore { namespace Assets { namespace GeoProc
         unsigned    HasElement(const char name[]) const;
         unsigned    FindElement(const char name[], unsigned semanticIndex = 0) const;
         void        RemoveStream(unsigned elementIndex);
+        void        RemapUnifiedVertices(IteratorRange<const unsigned*> newToOldUnified);
 
         template<typename OutputType>
             OutputType GetUnifiedElement(size_t vertexIndex, unsigned elementIndex) const;
@@ -94,6 +99,8 @@ namespace RenderCore { namespace Assets { namespace GeoProc
             std::vector<unsigned>   _vertexMap;
             std::string             _semanticName;
             unsigned                _semanticIndex;
+
+            friend class MeshDatabase;
         };
 
     private:
@@ -172,6 +179,52 @@ namespace RenderCore { namespace Assets { namespace GeoProc
             const std::vector<unsigned>& originalMapping,
             float threshold);
 
+    /// <summary>Settings for WeldVertices()</summary>
+    class WeldingSettings
+    {
+    public:
+            //  Tolerances for particular semantics (eg, "POSITION" or "TEXCOORD"). Other semantics
+            //  use _defaultThreshold. For positions this is a distance; for everything else it's
+            //  the largest allowed difference in any component.
+        std::vector<std::pair<std::string, float>> _semanticThresholds;
+        float       _defaultThreshold;
+
+            //  Normals and tangents are compared by angle (in radians) instead, so that hard edges
+            //  are preserved. Tangents with different handedness are never welded.
+        float       _hardEdgeAngle;
+
+            //  Only weld vertices that share the same index in the first stream (normally the
+            //  position). Skin weights are bound through these indices (see
+            //  MeshDatabase::BuildUnifiedVertexIndexToPositionIndex), so this must be set for
+            //  geometry that will be skinned.
+        bool        _matchPositionIndices;
+
+        unsigned    _chunkSize;     // vertices per task, when welding on a thread pool
+
+        WeldingSettings();
+    };
+
+    /// <summary>Combines unified vertices that are equal within some tolerance</summary>
+    /// Two unified vertices are welded when every stream matches within the tolerances given
+    /// in the settings. Candidates are found by hashing positions into a grid, and the work is
+    /// split into chunks that can be run on a thread pool. The result doesn't depend on the
+    /// number of threads: each group of welded vertices takes the values of the lowest indexed
+    /// vertex in the group, and the new vertices keep the original ordering.
+    ///
+    /// Unlike RemoveDuplicates(), a chain of close vertices is only combined while each vertex
+    /// is within tolerance of the first vertex in the chain. So welding never moves a vertex
+    /// further than the threshold, and never welds across a hard edge.
+    ///
+    /// "outputMapping" receives the new index for each of the original unified vertices (for
+    /// remapping index buffers). The streams in the mesh are remapped to refer only to the
+    /// welded vertices; the source data itself is not copied. Meshes without a "POSITION"
+    /// stream are left unchanged.
+    void WeldVertices(
+        std::vector<unsigned>& outputMapping,
+        MeshDatabase& mesh,
+        const WeldingSettings& settings,
+        Utility::CompletionThreadPool* pool = nullptr);
+
     class NativeVBSettings
     {
     public:
@@ -180,6 +233,79 @@ namespace RenderCore { namespace Assets { namespace GeoProc
 
     NativeVBLayout BuildDefaultLayout(MeshDatabase& mesh, const NativeVBSettings& settings);
 
+    /// <summary>Settings for QuantizeVertexStreams()</summary>
+    class QuantizationSettings
+    {
+    public:
+        bool    _positions;     // 16 bit UNORM positions, relative to the bounding box of the mesh
+        bool    _normals;       // octahedral encoded normals, tangents and bitangents (2 x 16 bit SNORM)
+        bool    _texCoords;     // 16 bit UNORM or SNORM texture coordinates (TEXCOORD0 is remapped to fit the normalized range)
+
+            //  Largest error allowed for each kind of stream. Streams with a larger measured error
+            //  are left unquantized. Position errors are distances (in the units of the mesh), normal
+            //  errors are angles (in radians) and texture coordinate errors are the largest difference
+            //  in any component.
+        float   _positionTolerance;
+        float   _normalTolerance;
+        float   _texCoordTolerance;
+
+        QuantizationSettings();
+    };
+
+    /// <summary>Result of QuantizeVertexStreams()</summary>
+    class QuantizationResult
+    {
+    public:
+        class Stream
+        {
+        public:
+            std::string     _semanticName;
+            unsigned        _semanticIndex;
+            Metal::NativeFormat::Enum _format;
+            float           _maxError;
+            bool            _quantized;     // false when the error was larger than the tolerance
+        };
+        std::vector<Stream> _streams;
+
+            //  Quantized positions are relative to the bounding box of the mesh. This transform
+            //  takes them back into the original space (it is identity when positions weren't
+            //  quantized). It is always an offset and a uniform scale.
+        Float4x4            _geoSpaceToNodeSpace;
+
+            //  Quantized 2D TEXCOORD0 values are relative to the range of the texture coordinates
+            //  in the mesh. The original value is "quantized * xy + zw" (it is (1,1,0,0) when
+            //  TEXCOORD0 wasn't remapped).
+        Float4              _texCoordScaleOffset;
+    };
+
+    /// <summary>Replaces vertex streams with smaller, quantized versions</summary>
+    /// Positions become 16 bit UNORM values relative to the bounding box of the mesh. The
+    /// dequantization transform is returned in the result, and must be applied at runtime
+    /// (typically by folding it into the local-to-world transform).
+    ///
+    /// "NORMAL" and "TEXBITANGENT" streams become octahedral encoded R16G16_SNORM values.
+    /// "TEXTANGENT" streams are encoded the same way, with the handiness stored in the sign
+    /// of the second component. A 2D "TEXCOORD0" stream always becomes R16G16_UNORM, relative
+    /// to the range of values in the mesh, and the remapping is returned in the result (to be
+    /// applied in the vertex shader). Other "TEXCOORD" streams become R16G16_UNORM (or R16G16_SNORM)
+    /// only when every value fits in the normalized range.
+    ///
+    /// Every stream is decoded again after encoding, and the largest error is compared against
+    /// the tolerances in the settings. The new streams have no processing flags, and they are
+    /// written to the vertex buffer unchanged by BuildDefaultLayout() and BuildNativeVertexBuffer().
+    QuantizationResult QuantizeVertexStreams(MeshDatabase& mesh, const QuantizationSettings& settings);
+
+    /// <summary>Octahedral encoding for unit vectors</summary>
+    /// The unit sphere is projected onto an octahedron, which is then unfolded onto the [-1, 1]
+    /// square. This gives a fairly even distribution of precision across all directions.
+    Float2 EncodeOctahedral(Float3 unitVector);
+    Float3 DecodeOctahedral(Float2 encoded);
+
+    /// <summary>Quantizes skinning weights to 8 bit UNORM values</summary>
+    /// The weights are normalized, and the rounding errors are distributed so that the
+    /// quantized weights always sum to exactly 255.
+    void QuantizeWeights(uint8 dst[], const float weights[], unsigned count);
+
     /// <summary>Creates a triangle winding order for a convex polygon with the given number of points<summary>
     /// If we have a convex polygon, this can be used to convert it into a list of triangles.
     /// However, note that if the polygon is concave, then some bad triangles will be created.
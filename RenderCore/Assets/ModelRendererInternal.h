@@ -59,6 +59,14 @@ namespace RenderCore { namespace Assets
             SharedParameterBox          _geoParamBox;
             SharedTechniqueInterface    _techniqueInterface;
 
+                // dequantization transform for quantized vertex positions
+                // (applied before the mesh to world transform)
+            Float4x4    _geoSpaceToNodeSpace;
+            bool        _hasGeoSpaceTransform;
+
+                // scale & offset for quantized texture coordinates (written into the local transform constants)
+            Float4      _texCoordScaleOffset;
+
             #if defined(_DEBUG)
                 unsigned _vbSize, _ibSize;  // used for metrics
             #endif
@@ -102,8 +110,19 @@ namespace RenderCore { namespace Assets
         typedef std::pair<unsigned, DrawCallDesc> MeshAndDrawCall;
         std::vector<MeshAndDrawCall>    _drawCalls;
 
+            // clusters for each entry in _drawCalls (pointing into the scaffold). The range
+            // is empty when the draw call wasn't split into clusters during compilation
+        class ClusterSet
+        {
+        public:
+            IteratorRange<const DrawCallCluster*> _clusters;
+            bool _backfaceCulling;      // false for double sided materials
+        };
+        std::vector<ClusterSet>         _drawCallClusters;
+
         const ModelScaffold*    _scaffold;
         unsigned                _levelOfDetail;
+        bool                    _hasPerMeshConstants;       // true if any mesh has a "_geoSpaceToNodeSpace" transform or "_texCoordScaleOffset"
 
         ///////////////////////////////////////////////////////////////////////////////
         std::vector<PendingGeoUpload>  _vbUploads;
@@ -117,7 +136,7 @@ namespace RenderCore { namespace Assets
         #endif
 
         ///////////////////////////////////////////////////////////////////////////////
-        Pimpl() : _scaffold(nullptr), _levelOfDetail(~unsigned(0x0)) {}
+        Pimpl() : _scaffold(nullptr), _levelOfDetail(~unsigned(0x0)), _hasPerMeshConstants(false) {}
         ~Pimpl() {}
 
         Metal::BoundUniforms* BeginVariation(
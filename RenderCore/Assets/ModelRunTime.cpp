@@ -13,6 +13,7 @@
 #include "RawAnimationCurve.h"
 #include "SharedStateSet.h"
 #include "DeferredShaderResource.h"
+#include "DrawCallClusters.h"
 
 #include "../Techniques/Techniques.h"
 #include "../Techniques/ResourceBox.h"
@@ -51,7 +52,7 @@ namespace RenderCore { namespace Assets
 {
     using ::Assets::ResChar;
 
-    static const unsigned ModelScaffoldVersion = 1;
+    static const unsigned ModelScaffoldVersion = 4;
     static const unsigned ModelScaffoldLargeBlocksVersion = 0;
 
     /// <summary>Internal namespace with utilities for constructing models</summary>
@@ -79,6 +80,7 @@ namespace RenderCore { namespace Assets
             unsigned _texturesIndex; 
             SharedRenderStateSet _renderStateSet;
             DelayStep _delayStep;
+            bool _doubleSided;
         };
 
         static const ModelCommandStream::GeoCall& GetGeoCall(const ModelScaffold& scaffold, unsigned geoCallIndex)
@@ -107,6 +109,12 @@ namespace RenderCore { namespace Assets
             return (unsigned)GetGeo(scaffold, geoCallIndex)._drawCalls.size();
         }
 
+        struct CompareClusterDrawCall
+        {
+            bool operator()(const DrawCallCluster& lhs, unsigned rhs) const { return lhs._drawCallIndex < rhs; }
+            bool operator()(unsigned lhs, const DrawCallCluster& rhs) const { return lhs < rhs._drawCallIndex; }
+        };
+
         static MaterialGuid ScaffoldMaterialIndex(const ModelScaffold& scaffold, unsigned geoCallIndex, unsigned drawCallIndex)
         {
             auto& meshData = scaffold.ImmutableData();
@@ -165,6 +173,15 @@ namespace RenderCore { namespace Assets
                 [=](const Metal::InputElementDesc& ele) { return !XlCompareStringI(ele._semanticName.c_str(), name); }) != end;
         }
 
+        static Metal::NativeFormat::Enum FindElementFormat(const Metal::InputLayout& ia, const char name[])
+        {
+            auto end = &ia.first[ia.second];
+            auto i = std::find_if(
+                ia.first, end, 
+                [=](const Metal::InputElementDesc& ele) { return !XlCompareStringI(ele._semanticName.c_str(), name); });
+            return (i != end) ? i->_nativeFormat : Metal::NativeFormat::Unknown;
+        }
+
         #if defined(_DEBUG)
             static std::string MakeDescription(const ParameterBox& paramBox)
             {
@@ -215,6 +232,20 @@ namespace RenderCore { namespace Assets
                 { geoParameters.SetParameter((const utf8*)"GEO_HAS_SKIN_WEIGHTS", 1); }
             if (HasElement(ia, "PER_VERTEX_AO"))
                 { geoParameters.SetParameter((const utf8*)"GEO_HAS_PER_VERTEX_AO", 1); }
+
+                //  Quantized unit vectors are stored with an octahedral encoding, and must be
+                //  decoded in the vertex shader
+            if (FindElementFormat(ia, "NORMAL") == Metal::NativeFormat::R16G16_SNORM)
+                { geoParameters.SetParameter((const utf8*)"GEO_V_NORMAL_OCTAHEDRAL", 1); }
+            if (FindElementFormat(ia, "TEXTANGENT") == Metal::NativeFormat::R16G16_SNORM)
+                { geoParameters.SetParameter((const utf8*)"GEO_V_TANGENT_OCTAHEDRAL", 1); }
+            if (FindElementFormat(ia, "TEXBITANGENT") == Metal::NativeFormat::R16G16_SNORM)
+                { geoParameters.SetParameter((const utf8*)"GEO_V_BITANGENT_OCTAHEDRAL", 1); }
+
+                //  Quantized texture coordinates must be remapped with the scale and offset 
+                //  in the local transform constants
+            if (FindElementFormat(ia, "TEXCOORD") == Metal::NativeFormat::R16G16_UNORM)
+                { geoParameters.SetParameter((const utf8*)"GEO_V_TEXCOORD_SCALEOFFSET", 1); }
             auto result = sharedStateSet.InsertParameterBox(geoParameters);
             paramBoxDesc.Add(result, geoParameters);
             return result;
@@ -320,6 +351,7 @@ namespace RenderCore { namespace Assets
 
                 i->second._matParams = sharedStateSet.InsertParameterBox(materialParamBox);
                 i->second._renderStateSet = sharedStateSet.InsertRenderStateSet(stateSet);
+                i->second._doubleSided = (stateSet._flag & Techniques::RenderStateSet::Flag::DoubleSided) && stateSet._doubleSided;
 
                 if (stateSet._forwardBlendOp == Metal::BlendOp::NoBlending) {
                     i->second._delayStep = DelayStep::OpaqueRender;
@@ -533,8 +565,10 @@ namespace RenderCore { namespace Assets
         std::vector<Pimpl::Mesh> meshes;
         std::vector<Pimpl::MeshAndDrawCall> drawCalls;
         std::vector<Pimpl::DrawCallResources> drawCallRes;
+        std::vector<Pimpl::ClusterSet> drawCallClusters;
         drawCalls.reserve(drawCallCount);
         drawCallRes.reserve(drawCallCount);
+        drawCallClusters.reserve(drawCallCount);
 
         for (unsigned gi=0; gi<geoCallCount; ++gi) {
             auto& geoInst = cmdStream.GetGeoCall(gi);
@@ -584,6 +618,16 @@ namespace RenderCore { namespace Assets
                     matRes._renderStateSet, matRes._delayStep, scaffoldMatIndex);
                 drawCallRes.push_back(res);
                 drawCalls.push_back(std::make_pair(gi, d));
+
+                    //  Find the clusters for this draw call (if the geometry was compiled with them).
+                    //  They are sorted by draw call index
+                auto clusters = std::equal_range(
+                    geo._clusters.cbegin(), geo._clusters.cend(), di,
+                    CompareClusterDrawCall());
+                Pimpl::ClusterSet clusterSet;
+                clusterSet._clusters = MakeIteratorRange(AsPointer(clusters.first), AsPointer(clusters.second));
+                clusterSet._backfaceCulling = !matRes._doubleSided;
+                drawCallClusters.push_back(clusterSet);
             }
         }
 
@@ -695,11 +739,18 @@ namespace RenderCore { namespace Assets
 
         pimpl->_vertexBuffer = std::move(vb);
         pimpl->_indexBuffer = std::move(ib);
+        pimpl->_hasPerMeshConstants = std::find_if(meshes.cbegin(), meshes.cend(), 
+            [](const Pimpl::Mesh& m) 
+            { 
+                return m._hasGeoSpaceTransform 
+                    || !Equivalent(m._texCoordScaleOffset, Float4(1.f, 1.f, 0.f, 0.f), 1e-6f); 
+            }) != meshes.cend();
         pimpl->_meshes = std::move(meshes);
         pimpl->_skinnedMeshes = std::move(skinnedMeshes);
         pimpl->_skinnedBindings = std::move(skinnedBindings);
 
         pimpl->_drawCalls = std::move(drawCalls);
+        pimpl->_drawCallClusters = std::move(drawCallClusters);
         pimpl->_drawCallRes = std::move(drawCallRes);
         pimpl->_skinnedDrawCalls = std::move(skinnedDrawCalls);
 
@@ -762,16 +813,23 @@ namespace RenderCore { namespace Assets
         auto& cmdStream = _scaffold->CommandStream();
         auto& geoCall = cmdStream.GetGeoCall(geoCallIndex);
 
-        if (transforms.IsGood()) {
-            auto meshToWorld = Combine(transforms.GetMeshToModel(geoCall._transformMarker), modelToWorld);
-            auto trans = Techniques::MakeLocalTransform(meshToWorld, ExtractTranslation(context._parserContext->GetProjectionDesc()._cameraToWorld));
-            localTransformBuffer.Update(*context._context, &trans, sizeof(trans));
-        }
-
             // todo -- should be possible to avoid this search
         auto mesh = FindIf(_meshes, [=](const Pimpl::Mesh& mesh) { return mesh._id == geoCall._geoId; });
         assert(mesh != _meshes.end());
 
+            // When any mesh has quantized positions or texture coordinates, the local transform 
+            // must be set for every mesh (because they can't share the single model to world transform)
+        if (transforms.IsGood() || _hasPerMeshConstants) {
+            auto meshToWorld = modelToWorld;
+            if (transforms.IsGood())
+                meshToWorld = Combine(transforms.GetMeshToModel(geoCall._transformMarker), modelToWorld);
+            if (mesh->_hasGeoSpaceTransform)
+                meshToWorld = Combine(mesh->_geoSpaceToNodeSpace, meshToWorld);
+            auto trans = Techniques::MakeLocalTransform(meshToWorld, ExtractTranslation(context._parserContext->GetProjectionDesc()._cameraToWorld));
+            trans._texCoordScaleOffset = mesh->_texCoordScaleOffset;
+            localTransformBuffer.Update(*context._context, &trans, sizeof(trans));
+        }
+
         auto& devContext = *context._context;
         devContext.Bind(_indexBuffer, Metal::NativeFormat::Enum(mesh->_indexFormat), mesh->_ibOffset);
 
@@ -796,8 +854,12 @@ namespace RenderCore { namespace Assets
         auto& cmdStream = _scaffold->CommandStream();
         auto& geoCall = cmdStream.GetSkinCall(geoCallIndex);
 
-        if (transforms.IsGood()) {
-            auto meshToWorld = Combine(transforms.GetMeshToModel(geoCall._transformMarker), modelToWorld);
+            // (skinned meshes are never quantized, but we must reset the constants from
+            // the previous unskinned mesh)
+        if (transforms.IsGood() || _hasPerMeshConstants) {
+            auto meshToWorld = modelToWorld;
+            if (transforms.IsGood())
+                meshToWorld = Combine(transforms.GetMeshToModel(geoCall._transformMarker), modelToWorld);
             auto trans = Techniques::MakeLocalTransform(meshToWorld, ExtractTranslation(context._parserContext->GetProjectionDesc()._cameraToWorld));
             localTransformBuffer.Update(*context._context, &trans, sizeof(trans));
         }
@@ -882,6 +944,10 @@ namespace RenderCore { namespace Assets
             result._ibSize = geo._ib._size;
         #endif
 
+        result._geoSpaceToNodeSpace = geo._geoSpaceToNodeSpace;
+        result._hasGeoSpaceTransform = !Equivalent(geo._geoSpaceToNodeSpace, Identity<Float4x4>(), 1e-6f);
+        result._texCoordScaleOffset = geo._texCoordScaleOffset;
+
             // Also set up vertex data from the supplements
             // (supplemental vertex data gets uploaded into the same vertex buffer)
         unsigned s=0;
@@ -1152,11 +1218,37 @@ namespace RenderCore { namespace Assets
         return lhs._shaderVariationHash < rhs._shaderVariationHash; 
     }
 
+    ClusterCulling::ClusterCulling(const Float4x4& worldToProjection, const Float3& worldSpaceView, bool backfaceCulling)
+    : _worldToProjection(worldToProjection), _worldSpaceView(worldSpaceView), _backfaceCulling(backfaceCulling)
+    , _clustersTested(0), _clustersVisible(0)
+    {}
+
+    static bool CalculateLocalSpaceView(Float3& result, const Float4x4& localToWorld, const Float3& worldSpaceView)
+    {
+            //  The cluster normal cones are only valid for transforms made up of rotation,
+            //  translation and uniform scale. Mirroring transforms flip the winding order, and 
+            //  non-uniform scales change the normals.
+        Float3 axes[3];
+        for (unsigned c=0; c<3; ++c)
+            axes[c] = Float3(localToWorld(0,c), localToWorld(1,c), localToWorld(2,c));
+        auto scaleSq = MagnitudeSquared(axes[0]);
+        const float tolerance = 1e-3f * scaleSq;
+        if (    std::abs(MagnitudeSquared(axes[1]) - scaleSq) > tolerance
+            ||  std::abs(MagnitudeSquared(axes[2]) - scaleSq) > tolerance
+            ||  Dot(Cross(axes[0], axes[1]), axes[2]) <= 0.f)
+            return false;
+
+        auto offset = worldSpaceView - ExtractTranslation(localToWorld);
+        result = Float3(Dot(axes[0], offset), Dot(axes[1], offset), Dot(axes[2], offset)) / scaleSq;
+        return true;
+    }
+
     void    ModelRenderer::Prepare(
         DelayedDrawCallSet& dest, 
         const SharedStateSet& sharedStateSet, 
         const Float4x4& modelToWorld,
-        const MeshToModel& transforms) const
+        const MeshToModel& transforms,
+        ClusterCulling* clusterCulling) const
     {
         unsigned mainTransformIndex = ~unsigned(0x0);
         if (!transforms.IsGood()) {
@@ -1167,6 +1259,8 @@ namespace RenderCore { namespace Assets
             //  After culling; submit all of the draw-calls in this mesh to a list to be sorted
             //  Note -- only unskinned geometry supported currently. In theory, we might be able
             //          to do the same with skinned geometry (at least, when not using the "prepare" step
+            //  Draw calls that were split into clusters can be culled further, and might become
+            //  several smaller draw calls (one for each range of visible clusters)
         unsigned drawCallIndex = 0;
         for (auto md=_pimpl->_drawCalls.cbegin(); md!=_pimpl->_drawCalls.cend(); ++md, ++drawCallIndex) {
             const auto& drawCallRes = _pimpl->_drawCallRes[drawCallIndex];
@@ -1185,26 +1279,52 @@ namespace RenderCore { namespace Assets
 
             auto step = unsigned(drawCallRes._delayStep);
 
+            Float4x4 meshToWorld = modelToWorld;
+            if (transforms.IsGood())
+                meshToWorld = Combine(transforms.GetMeshToModel(geoCall._transformMarker), modelToWorld);
+
+            std::pair<unsigned, unsigned> wholeDrawCall(d._firstIndex, d._indexCount);
+            IteratorRange<const std::pair<unsigned, unsigned>*> visibleRanges(&wholeDrawCall, &wholeDrawCall+1);
+
+            const auto& clusterSet = _pimpl->_drawCallClusters[drawCallIndex];
+            if (clusterCulling && !clusterSet._clusters.empty()) {
+                auto& ranges = clusterCulling->_visibleRanges;
+                ranges.clear();
+                Float3 localSpaceView(0.f, 0.f, 0.f);
+                bool backfaceCulling = 
+                        clusterCulling->_backfaceCulling && clusterSet._backfaceCulling
+                    &&  CalculateLocalSpaceView(localSpaceView, meshToWorld, clusterCulling->_worldSpaceView);
+                auto visibleCount = CullDrawCallClusters(
+                    ranges, clusterSet._clusters,
+                    Combine(meshToWorld, clusterCulling->_worldToProjection),
+                    localSpaceView, backfaceCulling);
+                clusterCulling->_clustersTested += (unsigned)clusterSet._clusters.size();
+                clusterCulling->_clustersVisible += visibleCount;
+                if (ranges.empty()) continue;
+                visibleRanges = MakeIteratorRange(ranges);
+            }
+
             DelayedDrawCall entry;
             entry._drawCallIndex = drawCallIndex;
             entry._renderer = this;
-            if (transforms.IsGood()) {
-                auto trans = Combine(
-                    transforms.GetMeshToModel(geoCall._transformMarker), 
-                    modelToWorld);
+            if (transforms.IsGood() || mesh->_hasGeoSpaceTransform) {
+                    // (note that cluster culling above happens in the space of the unquantized positions)
                 entry._meshToWorld = (unsigned)dest._transforms.size();
-                dest._transforms.push_back(trans);
+                if (mesh->_hasGeoSpaceTransform) dest._transforms.push_back(Combine(mesh->_geoSpaceToNodeSpace, meshToWorld));
+                else dest._transforms.push_back(meshToWorld);
             } else {
                 entry._meshToWorld = mainTransformIndex;
             }
             auto techniqueInterface = mesh->_techniqueInterface;
             entry._shaderVariationHash = techniqueInterface.Value() ^ (geoParamIndex.Value() << 12) ^ (matParamIndex.Value() << 15) ^ (shaderNameIndex.Value() << 24);  // simple hash of these indices. Note that collisions might be possible
-            entry._indexCount = d._indexCount;
-            entry._firstIndex = d._firstIndex;
             entry._firstVertex = d._firstVertex;
             entry._topology = Metal::Topology::Enum(d._topology);
             entry._subMesh = AsPointer(mesh);
-            dest._entries[step].push_back(entry);
+            for (const auto& r:visibleRanges) {
+                entry._firstIndex = r.first;
+                entry._indexCount = r.second;
+                dest._entries[step].push_back(entry);
+            }
         }
 
             //  Also try to render skinned geometry... But we want to render this with skinning disabled 
@@ -1249,13 +1369,14 @@ namespace RenderCore { namespace Assets
         }
     }
 
-    namespace WLTFlags { enum Enum { LocalToWorld = 1<<0, LocalSpaceView = 1<<1, MaterialGuid = 1<<2 }; }
+    namespace WLTFlags { enum Enum { LocalToWorld = 1<<0, LocalSpaceView = 1<<1, MaterialGuid = 1<<2, TexCoordScaleOffset = 1<<3 }; }
 
     template<int Flags>
         void WriteLocalTransform(
             void* dest, 
             const ModelRendererContext& context, 
-            const Float4x4& t, uint64 materialGuid)
+            const Float4x4& t, uint64 materialGuid,
+            const Float4& texCoordScaleOffset)
     {
         auto* dst = (Techniques::LocalTransformConstants*)dest;
 
@@ -1265,13 +1386,17 @@ namespace RenderCore { namespace Assets
             CopyTransform(dst->_localToWorld, t);
         }
         if (constant_expression<!!(Flags&WLTFlags::LocalSpaceView)>::result()) {
+                //  "t" can have a scale (from placements, or from the dequantization of 
+                //  vertex positions), so we need a general inverse here
             auto worldSpaceView = ExtractTranslation(context._parserContext->GetProjectionDesc()._cameraToWorld);
-            TransformPointByOrthonormalInverse(t, worldSpaceView);
-            dst->_localSpaceView = worldSpaceView;
+            dst->_localSpaceView = TransformPoint(Inverse(t), worldSpaceView);
         }
         if (constant_expression<!!(Flags&WLTFlags::MaterialGuid)>::result()) {
             dst->_materialGuid = materialGuid;
         }
+        if (constant_expression<!!(Flags&WLTFlags::TexCoordScaleOffset)>::result()) {
+            dst->_texCoordScaleOffset = texCoordScaleOffset;
+        }
     }
 
     void ModelRenderer::Sort(DelayedDrawCallSet& drawCalls)
@@ -1370,8 +1495,10 @@ namespace RenderCore { namespace Assets
                 HRESULT hresult = context._context->GetUnderlying()->Map(
                     localTransformBuffer.GetUnderlying(), 0, D3D11_MAP_WRITE_DISCARD, 0, &result);
                 assert(SUCCEEDED(hresult) && result.pData); (void)hresult;
-                WriteLocalTransform<WLTFlags::LocalToWorld|WLTFlags::MaterialGuid>(
-                    result.pData, context, drawCalls._transforms[d->_meshToWorld], drawCallRes._materialBindingGuid);
+                    //  (this is a discard map, so every constant the shaders can read must be written)
+                WriteLocalTransform<WLTFlags::LocalToWorld|WLTFlags::LocalSpaceView|WLTFlags::MaterialGuid|WLTFlags::TexCoordScaleOffset>(
+                    result.pData, context, drawCalls._transforms[d->_meshToWorld], drawCallRes._materialBindingGuid,
+                    currentMesh->_texCoordScaleOffset);
                 context._context->GetUnderlying()->Unmap(localTransformBuffer.GetUnderlying(), 0);
             }
             
@@ -1484,6 +1611,9 @@ namespace RenderCore { namespace Assets
     : _vb(std::move(geo._vb))
     , _ib(std::move(geo._ib))
     , _drawCalls(std::move(geo._drawCalls))
+    , _clusters(std::move(geo._clusters))
+    , _geoSpaceToNodeSpace(geo._geoSpaceToNodeSpace)
+    , _texCoordScaleOffset(geo._texCoordScaleOffset)
     {}
 
     RawGeometry& RawGeometry::operator=(RawGeometry&& geo) never_throws
@@ -1491,6 +1621,9 @@ namespace RenderCore { namespace Assets
         _vb = std::move(geo._vb);
         _ib = std::move(geo._ib);
         _drawCalls = std::move(geo._drawCalls);
+        _clusters = std::move(geo._clusters);
+        _geoSpaceToNodeSpace = geo._geoSpaceToNodeSpace;
+        _texCoordScaleOffset = geo._texCoordScaleOffset;
         return *this;
     }
 
@@ -94,7 +94,7 @@ namespace RenderCore { namespace Assets
         ~ModelScaffold();
 
     private:
-        std::unique_ptr<uint8[]>    _rawMemoryBlock;
+        std::shared_ptr<uint8>      _rawMemoryBlock;
         unsigned                    _largeBlocksOffset;
 
         static void Resolver(void*, IteratorRange<::Assets::AssetChunkResult*>);
@@ -117,6 +117,27 @@ namespace RenderCore { namespace Assets
         MeshToModel(const ModelScaffold&);
     };
 
+    /// <summary>Settings and metrics for culling draw call clusters in ModelRenderer::Prepare</summary>
+    /// Models compiled with draw call clusters can cull parts of large draw calls. Each
+    /// cluster is tested against the frustum in "_worldToProjection". When "_backfaceCulling"
+    /// is set, clusters that face entirely away from "_worldSpaceView" are also culled (this
+    /// should only be used when rendering with back face culling and a perspective camera).
+    /// The same object can be passed to many Prepare() calls to accumulate the metrics.
+    class ClusterCulling
+    {
+    public:
+        Float4x4    _worldToProjection;
+        Float3      _worldSpaceView;
+        bool        _backfaceCulling;
+
+        unsigned    _clustersTested;
+        unsigned    _clustersVisible;
+
+        std::vector<std::pair<unsigned, unsigned>> _visibleRanges;     // (working buffer)
+
+        ClusterCulling(const Float4x4& worldToProjection, const Float3& worldSpaceView, bool backfaceCulling = true);
+    };
+
     /// <summary>Creates platform resources and renders a model</summary>
     /// ModelRenderer is used to render a model. Though the two classes work together, it is 
     /// a more heavy-weight object than ModelScaffold. When the ModelRenderer is created, it
@@ -146,7 +167,8 @@ namespace RenderCore { namespace Assets
             DelayedDrawCallSet& dest, 
             const SharedStateSet& sharedStateSet, 
             const Float4x4& modelToWorld,
-            const MeshToModel& transforms = MeshToModel()) const;
+            const MeshToModel& transforms = MeshToModel(),
+            ClusterCulling* clusterCulling = nullptr) const;
 
         static void RenderPrepared(
             const ModelRendererContext& context, const SharedStateSet& sharedStateSet,
@@ -260,7 +282,7 @@ namespace RenderCore { namespace Assets
         ~ModelSupplementScaffold();
 
     private:
-        std::unique_ptr<uint8[]>    _rawMemoryBlock;
+        std::shared_ptr<uint8>      _rawMemoryBlock;
         unsigned                    _largeBlocksOffset;
 
         static void Resolver(void*, IteratorRange<::Assets::AssetChunkResult*>);
@@ -308,7 +330,7 @@ namespace RenderCore { namespace Assets
         SkeletonScaffold& operator=(SkeletonScaffold&& moveFrom) never_throws;
         ~SkeletonScaffold();
     private:
-        std::unique_ptr<uint8[]>    _rawMemoryBlock;
+        std::shared_ptr<uint8>      _rawMemoryBlock;
         static void Resolver(void*, IteratorRange<::Assets::AssetChunkResult*>);
         const TransformationMachine*   TryImmutableData() const;
     };
@@ -333,7 +355,7 @@ namespace RenderCore { namespace Assets
         AnimationSetScaffold& operator=(AnimationSetScaffold&& moveFrom) never_throws;
         ~AnimationSetScaffold();
     private:
-        std::unique_ptr<uint8[]>    _rawMemoryBlock;
+        std::shared_ptr<uint8>      _rawMemoryBlock;
         static void Resolver(void*, IteratorRange<::Assets::AssetChunkResult*>);
         const AnimationImmutableData*   TryImmutableData() const;
     };
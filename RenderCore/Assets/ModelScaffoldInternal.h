@@ -90,6 +90,22 @@ namespace RenderCore { namespace Assets
         , _subMaterialIndex(subMaterialIndex), _topology(topology) {}
     };
 
+    /// <summary>A small group of triangles within a draw call, with culling information</summary>
+    /// Clusters cover contiguous ranges of the index buffer. The clusters for a draw
+    /// call cover all of the triangles in that draw call, and are sorted by draw call.
+    /// The bounding sphere and the normal cone are in the same space as the vertex
+    /// positions. See CullDrawCallClusters() for how they are used.
+    class DrawCallCluster
+    {
+    public:
+        Float3      _sphereCentre;
+        float       _sphereRadius;
+        Float3      _coneAxis;          // average facing direction of the triangles
+        float       _coneCutoff;        // sine of the cone angle; 1 means there's no useful cone
+        unsigned    _firstIndex, _indexCount;
+        unsigned    _drawCallIndex;
+    };
+
     class VertexElement
     {
     public:
@@ -144,6 +160,9 @@ namespace RenderCore { namespace Assets
         VertexData  _vb;
         IndexData   _ib;
         SerializableVector<DrawCallDesc>   _drawCalls;
+        SerializableVector<DrawCallCluster> _clusters;  // (empty when the model was compiled without clusters)
+        Float4x4    _geoSpaceToNodeSpace;   // dequantization for vertex positions (identity when they are not quantized)
+        Float4      _texCoordScaleOffset;   // dequantization for TEXCOORD0 ("xy * quantized + zw")
 
         RawGeometry();
         RawGeometry(RawGeometry&&) never_throws;
@@ -233,3 +252,17 @@ inline void Serialize(
 	outputSerializer.SerializeValue(drawCall._topology);
 }
 
+template<>
+inline void Serialize(
+	Serialization::NascentBlockSerializer& outputSerializer,
+	const RenderCore::Assets::DrawCallCluster& cluster)
+{
+	Serialize(outputSerializer, cluster._sphereCentre);
+	outputSerializer.SerializeValue(cluster._sphereRadius);
+	Serialize(outputSerializer, cluster._coneAxis);
+	outputSerializer.SerializeValue(cluster._coneCutoff);
+	outputSerializer.SerializeValue(cluster._firstIndex);
+	outputSerializer.SerializeValue(cluster._indexCount);
+	outputSerializer.SerializeValue(cluster._drawCallIndex);
+}
+
@@ -7,6 +7,7 @@
 #include "Services.h"
 #include "LocalCompiledShaderSource.h"
 #include "MaterialCompiler.h"
+#include "TextureCompiler.h"
 #include "Material.h"   // just for MaterialScaffold::CompileProcessType
 #include "ColladaCompilerInterface.h"
 #include "../Metal/Shader.h"            // (for Metal::CreateLowLevelShaderCompiler)
@@ -47,10 +48,14 @@ namespace RenderCore { namespace Assets
 
             // Setup required compilers.
             //  * material scaffold compiler
+            //  * texture cooker
         auto& compilers = asyncMan.GetIntermediateCompilers();
         compilers.AddCompiler(
             RenderCore::Assets::MaterialScaffold::CompileProcessType,
             std::make_shared<RenderCore::Assets::MaterialScaffoldCompiler>());
+        compilers.AddCompiler(
+            RenderCore::Assets::TextureCompiler::CompileProcessType,
+            std::make_shared<RenderCore::Assets::TextureCompiler>());
 
         ConsoleRig::GlobalServices::GetCrossModule().Publish(*this);
     }
@@ -0,0 +1,658 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "TextureCompiler.h"
+#include "CompilationThread.h"
+#include "../../Assets/AssetUtils.h"
+#include "../../Assets/IntermediateAssets.h"
+#include "../../Assets/CompilerHelper.h"
+#include "../../ConsoleRig/Log.h"
+#include "../../Utility/IteratorUtils.h"
+#include "../../Utility/Streams/FileUtils.h"
+#include "../../Utility/Streams/PathUtils.h"
+#include "../../Utility/Threading/CompletionThreadPool.h"
+#include "../../Utility/Threading/ThreadingUtils.h"
+#include "../../Utility/Threading/Mutex.h"
+#include "../../Utility/StringFormat.h"
+#include "../../Utility/StringUtils.h"
+#include "../../Utility/Conversion.h"
+#include "../../Utility/TimeUtils.h"
+#include "../../Utility/PtrUtils.h"
+#include "../../Utility/BitUtils.h"
+#include "../../Foreign/tinyxml2-master/tinyxml2.h"
+#include "../../Foreign/ISPCTex/ispc_texcomp.h"
+#include <thread>
+#include <cmath>
+
+#include "../../Core/WinAPI/IncludeWindows.h"
+#include "../../Foreign/DirectXTex/DirectXTex/DirectXTex.h"
+#undef max
+#undef min
+
+namespace RenderCore { namespace Assets
+{
+    bool LoadTextureMetadata(TextureMetadata& result, const void* start, size_t size)
+    {
+        result = TextureMetadata();
+
+        if (!start || !size) return false;
+
+        // skip over the "byte order mark", if it exists...
+        if (size >= 3 && ((const uint8*)start)[0] == 0xef && ((const uint8*)start)[1] == 0xbb && ((const uint8*)start)[2] == 0xbf) {
+            start = PtrAdd(start, 3);
+            size -= 3;
+        }
+
+        using namespace tinyxml2;
+        XMLDocument doc;
+	    auto e = doc.Parse((const char*)start, size);
+        if (e != XML_SUCCESS) return false;
+
+        const auto* root = doc.RootElement();
+        if (root) {
+            auto colorSpace = root->FindAttribute("colorSpace");
+            if (colorSpace) {
+                if (!XlCompareStringI(colorSpace->Value(), "srgb")) { result._colorSpace = SourceColorSpace::SRGB; }
+                else if (!XlCompareStringI(colorSpace->Value(), "linear")) { result._colorSpace = SourceColorSpace::Linear; }
+            }
+
+            auto compression = root->FindAttribute("compression");
+            if (compression) {
+                if (!XlCompareStringI(compression->Value(), "bc1")) { result._compression = CookedTextureCompression::BC1; }
+                else if (!XlCompareStringI(compression->Value(), "bc3")) { result._compression = CookedTextureCompression::BC3; }
+                else if (!XlCompareStringI(compression->Value(), "bc5")) { result._compression = CookedTextureCompression::BC5; }
+                else if (!XlCompareStringI(compression->Value(), "bc7")) { result._compression = CookedTextureCompression::BC7; }
+                else if (!XlCompareStringI(compression->Value(), "none")) { result._compression = CookedTextureCompression::None; }
+            }
+        }
+
+        return true;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    class SRGBTables
+    {
+    public:
+        static const unsigned LinearTableSize = 16384;
+        float   _toLinear[256];
+        uint8   _fromLinear[LinearTableSize];
+
+        float   ToLinear(uint8 value) const     { return _toLinear[value]; }
+        uint8   FromLinear(float value) const
+        {
+            auto index = int(value * float(LinearTableSize-1) + 0.5f);
+            return _fromLinear[std::max(0, std::min(int(LinearTableSize-1), index))];
+        }
+
+        SRGBTables();
+    };
+
+    SRGBTables::SRGBTables()
+    {
+        for (unsigned c=0; c<256; ++c) {
+            float f = c / 255.f;
+            _toLinear[c] = (f <= 0.04045f) ? (f / 12.92f) : std::pow((f + 0.055f) / 1.055f, 2.4f);
+        }
+
+        for (unsigned c=0; c<LinearTableSize; ++c) {
+            float f = c / float(LinearTableSize-1);
+            float s = (f <= 0.0031308f) ? (f * 12.92f) : (1.055f * std::pow(f, 1.f/2.4f) - 0.055f);
+            _fromLinear[c] = (uint8)std::max(0, std::min(255, int(s * 255.f + 0.5f)));
+        }
+    }
+
+    /// <summary>Tightly packed R8G8B8A8 image (row pitch is always width*4)</summary>
+    class MipSurface
+    {
+    public:
+        std::vector<uint8> _data;
+        unsigned _width, _height;
+
+        uint8* Row(unsigned y)              { return &_data[y*_width*4]; }
+        const uint8* Row(unsigned y) const  { return &_data[y*_width*4]; }
+
+        MipSurface(unsigned width, unsigned height) : _data(width*height*4), _width(width), _height(height) {}
+        MipSurface(MipSurface&& moveFrom) never_throws
+            : _data(std::move(moveFrom._data)), _width(moveFrom._width), _height(moveFrom._height) {}
+        MipSurface& operator=(MipSurface&& moveFrom) never_throws
+        {
+            _data = std::move(moveFrom._data); _width = moveFrom._width; _height = moveFrom._height;
+            return *this;
+        }
+    };
+
+    static void DownsampleRows(
+        MipSurface& dst, const MipSurface& src,
+        unsigned rowStart, unsigned rowEnd,
+        bool srgb, const SRGBTables& tables)
+    {
+            // Simple 2x2 box filter. For SRGB sources, the color channels are
+            // averaged in linear space (otherwise the smaller mips become darker
+            // than they should be). Alpha is always linear.
+        for (unsigned y=rowStart; y<rowEnd; ++y) {
+            const auto* r0 = src.Row(std::min(y*2, src._height-1));
+            const auto* r1 = src.Row(std::min(y*2+1, src._height-1));
+            auto* d = dst.Row(y);
+            for (unsigned x=0; x<dst._width; ++x) {
+                auto x0 = std::min(x*2, src._width-1)*4, x1 = std::min(x*2+1, src._width-1)*4;
+                if (srgb) {
+                    for (unsigned c=0; c<3; ++c) {
+                        float l = tables.ToLinear(r0[x0+c]) + tables.ToLinear(r0[x1+c])
+                                + tables.ToLinear(r1[x0+c]) + tables.ToLinear(r1[x1+c]);
+                        d[x*4+c] = tables.FromLinear(.25f * l);
+                    }
+                } else {
+                    for (unsigned c=0; c<3; ++c)
+                        d[x*4+c] = uint8((unsigned(r0[x0+c]) + r0[x1+c] + r1[x0+c] + r1[x1+c] + 2) / 4);
+                }
+                d[x*4+3] = uint8((unsigned(r0[x0+3]) + r0[x1+3] + r1[x0+3] + r1[x1+3] + 2) / 4);
+            }
+        }
+    }
+
+    static MipSurface PadToBlocks(const MipSurface& src)
+    {
+            // Block compressors only work on whole 4x4 blocks. Small mips need to be padded
+            // out (by replicating the edge texels). The padding is never sampled.
+        MipSurface result(CeilToMultiplePow2(src._width, 4), CeilToMultiplePow2(src._height, 4));
+        for (unsigned y=0; y<result._height; ++y) {
+            const auto* s = src.Row(std::min(y, src._height-1));
+            auto* d = result.Row(y);
+            for (unsigned x=0; x<result._width; ++x)
+                std::copy(&s[std::min(x, src._width-1)*4], &s[std::min(x, src._width-1)*4+4], &d[x*4]);
+        }
+        return std::move(result);
+    }
+
+    static void CompressBlockBC4(uint8 dst[8], const uint8* src, unsigned srcRowPitch)
+    {
+            // Encode a single channel block in the 8 value interpolation mode.
+            // Endpoints are just the min and max values; each texel takes the
+            // closest interpolated value.
+        uint8 values[16];
+        uint8 minValue = 0xff, maxValue = 0;
+        for (unsigned y=0; y<4; ++y)
+            for (unsigned x=0; x<4; ++x) {
+                auto v = src[y*srcRowPitch + x*4];
+                values[y*4+x] = v;
+                minValue = std::min(minValue, v);
+                maxValue = std::max(maxValue, v);
+            }
+
+        dst[0] = maxValue;
+        dst[1] = minValue;
+
+        uint64 indices = 0;
+        if (maxValue != minValue) {
+            const unsigned range = maxValue - minValue;
+            for (unsigned c=0; c<16; ++c) {
+                    // position along the line from maxValue (0) to minValue (7)
+                unsigned p = ((maxValue - values[c]) * 14 + range) / (2 * range);
+                uint64 code = (p == 0) ? 0 : ((p == 7) ? 1 : (p + 1));
+                indices |= code << uint64(c*3);
+            }
+        }
+
+        for (unsigned c=0; c<6; ++c)
+            dst[2+c] = uint8(indices >> uint64(c*8));
+    }
+
+    static void CompressBlocksBC5(const rgba_surface* src, uint8* dst)
+    {
+            // ISPC texcomp doesn't include a BC5 compressor, but it's simple enough
+            // to do here. Each block is 2 BC4 blocks; red first, then green.
+        for (int by=0; by<src->height/4; ++by)
+            for (int bx=0; bx<src->width/4; ++bx) {
+                const auto* blockStart = &src->ptr[by*4*src->stride + bx*4*4];
+                CompressBlockBC4(dst, blockStart, src->stride);
+                CompressBlockBC4(dst+8, blockStart+1, src->stride);
+                dst += 16;
+            }
+    }
+
+    static DXGI_FORMAT AsDXGIFormat(CookedTextureCompression compression, bool srgb)
+    {
+        switch (compression) {
+        case CookedTextureCompression::BC1: return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        case CookedTextureCompression::BC3: return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+        case CookedTextureCompression::BC5: return DXGI_FORMAT_BC5_UNORM;
+        case CookedTextureCompression::BC7: return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        default:                            return srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+    }
+
+    static const char* AsString(CookedTextureCompression compression)
+    {
+        switch (compression) {
+        case CookedTextureCompression::BC1: return "BC1";
+        case CookedTextureCompression::BC3: return "BC3";
+        case CookedTextureCompression::BC5: return "BC5";
+        case CookedTextureCompression::BC7: return "BC7";
+        default:                            return "uncompressed";
+        }
+    }
+
+    static bool IsHighDynamicRange(DXGI_FORMAT format)
+    {
+        switch (format) {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R11G11B10_FLOAT:
+        case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    class CookedTexture
+    {
+    public:
+        DirectX::ScratchImage _image;
+        ::Assets::CompilerHelper::CompileResult _compileResult;
+    };
+
+    static void AddDep(
+        std::vector<::Assets::DependentFileState>& deps,
+        const ::Assets::ResChar newDep[])
+    {
+        auto depState = ::Assets::IntermediateAssets::Store::GetDependentFileState(newDep);
+        auto existing = std::find_if(
+            deps.cbegin(), deps.cend(),
+            [&](const ::Assets::DependentFileState& test) { return test._filename == depState._filename; });
+        if (existing == deps.cend())
+            deps.push_back(depState);
+    }
+
+    static CookedTexture CookTexture(
+        const ::Assets::ResChar sourceFile[], const ::Assets::ResChar parameters[],
+        CompletionThreadPool& pool, const SRGBTables& tables)
+    {
+        using namespace DirectX;
+        const auto frequency = GetPerformanceCounterFrequency();
+        const auto startTime = GetPerformanceCounter();
+
+        CookedTexture result;
+        auto& deps = result._compileResult._dependencies;
+
+            //  Decide on the color space and compression type. This follows the same rules
+            //  as DeferredShaderResource -- explicit parameters first, then the metadata
+            //  file and then the "_ddn" naming convention for normal maps.
+        bool generateMipmaps = true;
+        auto colorSpace = SourceColorSpace::Unspecified;
+        for (auto c=parameters; *c; ++c) {
+            if (*c == 'l' || *c == 'L') { colorSpace = SourceColorSpace::Linear; }
+            if (*c == 's' || *c == 'S') { colorSpace = SourceColorSpace::SRGB; }
+            if (*c == 't' || *c == 'T') { generateMipmaps = false; }
+        }
+
+        ::Assets::ResChar metadataFile[MaxPath];
+        XlCopyString(metadataFile, sourceFile);
+        XlCatString(metadataFile, ".metadata");
+        AddDep(deps, sourceFile);
+        AddDep(deps, metadataFile);     // (even if it's missing -- so creating it later will trigger a recook)
+
+        TextureMetadata metadata;
+        {
+            size_t metadataSize = 0;
+            auto metadataBlock = LoadFileAsMemoryBlock(metadataFile, &metadataSize);
+            LoadTextureMetadata(metadata, metadataBlock.get(), metadataSize);
+        }
+
+        const bool isNormalMap = XlFindStringI(sourceFile, "_ddn") != nullptr;
+        if (colorSpace == SourceColorSpace::Unspecified) colorSpace = metadata._colorSpace;
+        if (colorSpace == SourceColorSpace::Unspecified) colorSpace = isNormalMap ? SourceColorSpace::Linear : SourceColorSpace::SRGB;
+        const bool srgb = colorSpace == SourceColorSpace::SRGB;
+
+            //  Load the source image & convert to a simple R8G8B8A8 format.
+            //  Note that the SRGB flag on the format is preserved, so DirectXTex
+            //  doesn't try to perform any color space conversion
+        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        ucs2 wfilename[MaxPath];
+        Conversion::Convert(wfilename, dimof(wfilename), sourceFile, XlStringEnd(sourceFile));
+
+        TexMetadata srcMetadata;
+        ScratchImage srcImage;
+        HRESULT hresult;
+        auto* ext = XlExtension(sourceFile);
+        if (ext && !XlCompareStringI(ext, "dds")) {
+            hresult = LoadFromDDSFile((const wchar_t*)wfilename, DDS_FLAGS_NONE, &srcMetadata, srcImage);
+        } else if (ext && !XlCompareStringI(ext, "tga")) {
+            hresult = LoadFromTGAFile((const wchar_t*)wfilename, &srcMetadata, srcImage);
+        } else {
+            hresult = LoadFromWICFile((const wchar_t*)wfilename, WIC_FLAGS_NONE, &srcMetadata, srcImage);
+        }
+        if (!SUCCEEDED(hresult))
+            Throw(::Exceptions::BasicLabel("Failed while loading source texture (%s)", sourceFile));
+
+        if (srcMetadata.dimension != TEX_DIMENSION_TEXTURE2D || srcMetadata.arraySize > 1 || srcMetadata.depth > 1)
+            Throw(::Exceptions::BasicLabel("Only simple 2D textures can be cooked (%s)", sourceFile));
+        if (IsHighDynamicRange(srcMetadata.format))
+            Throw(::Exceptions::BasicLabel("High dynamic range textures can't be cooked (%s)", sourceFile));
+
+        const Image* topImage = srcImage.GetImage(0, 0, 0);
+        ScratchImage decompressed, converted;
+        if (IsCompressed(srcMetadata.format)) {
+            hresult = Decompress(*topImage, IsSRGB(srcMetadata.format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, decompressed);
+            if (!SUCCEEDED(hresult))
+                Throw(::Exceptions::BasicLabel("Failed while decompressing source texture (%s)", sourceFile));
+            topImage = decompressed.GetImage(0, 0, 0);
+        }
+
+        if (topImage->format != DXGI_FORMAT_R8G8B8A8_UNORM && topImage->format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) {
+            hresult = Convert(
+                *topImage, IsSRGB(topImage->format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM,
+                TEX_FILTER_DEFAULT, 0.5f, converted);
+            if (!SUCCEEDED(hresult))
+                Throw(::Exceptions::BasicLabel("Failed while converting source texture (%s)", sourceFile));
+            topImage = converted.GetImage(0, 0, 0);
+        }
+
+        const auto width = unsigned(topImage->width), height = unsigned(topImage->height);
+        unsigned mipCount = 1;
+        if (generateMipmaps)
+            while ((std::max(width, height) >> mipCount) != 0) ++mipCount;
+
+        std::vector<MipSurface> mips;
+        mips.reserve(mipCount);
+        mips.emplace_back(MipSurface(width, height));
+        for (unsigned y=0; y<height; ++y)
+            XlCopyMemory(mips[0].Row(y), PtrAdd(topImage->pixels, y*topImage->rowPitch), width*4);
+        srcImage.Release();
+        decompressed.Release();
+        converted.Release();
+
+        const auto loadTime = GetPerformanceCounter();
+
+            //  Build the mip chain. Each mip depends on the one before it; but within
+            //  a mip we can split the work into strips of rows.
+        const unsigned rowsPerStrip = 32;
+        for (unsigned m=1; m<mipCount; ++m) {
+            const auto& src = mips[m-1];
+            mips.emplace_back(MipSurface(std::max(1u, width >> m), std::max(1u, height >> m)));
+            auto& dst = mips[m];
+            auto strip = [&](unsigned s)
+                { DownsampleRows(dst, src, s*rowsPerStrip, std::min((s+1)*rowsPerStrip, dst._height), srgb, tables); };
+            ParallelFor(pool, (dst._height + rowsPerStrip - 1) / rowsPerStrip, strip);
+        }
+
+        const auto mipTime = GetPerformanceCounter();
+
+            //  Choose the final compression type. D3D requires the top mip of block compressed
+            //  textures to be a multiple of the block size; so textures with odd dimensions
+            //  are left uncompressed.
+        bool hasAlpha = false;
+        for (size_t c=3; c<mips[0]._data.size() && !hasAlpha; c+=4)
+            hasAlpha = mips[0]._data[c] != 0xff;
+
+        auto compression = metadata._compression;
+        if (compression == CookedTextureCompression::Auto) {
+            if (isNormalMap && !srgb) compression = CookedTextureCompression::BC5;
+            else if (hasAlpha) compression = CookedTextureCompression::BC3;
+            else compression = CookedTextureCompression::BC1;
+        }
+        if (compression != CookedTextureCompression::None && ((width%4) || (height%4))) {
+            LogWarning << "Texture (" << sourceFile << ") dimensions are not a multiple of 4. It will be cooked without compression";
+            compression = CookedTextureCompression::None;
+        }
+
+        const auto dstFormat = AsDXGIFormat(compression, srgb);
+        hresult = result._image.Initialize2D(dstFormat, width, height, 1, mipCount);
+        if (!SUCCEEDED(hresult))
+            Throw(::Exceptions::BasicLabel("Failed while allocating cooked texture (%s)", sourceFile));
+
+        if (compression == CookedTextureCompression::None) {
+            for (unsigned m=0; m<mipCount; ++m) {
+                auto* dstImage = result._image.GetImage(m, 0, 0);
+                for (unsigned y=0; y<mips[m]._height; ++y)
+                    XlCopyMemory(PtrAdd(dstImage->pixels, y*dstImage->rowPitch), mips[m].Row(y), mips[m]._width*4);
+            }
+        } else {
+                //  Compress every mip, splitting each into strips of block rows. All of the
+                //  strips for all of the mips go into the pool together, so even the small
+                //  mips are compressed in parallel with the larger ones.
+            for (auto& m:mips)
+                if ((m._width%4) || (m._height%4))
+                    m = PadToBlocks(m);
+
+            bc7_enc_settings bc7Settings;
+            if (hasAlpha) GetProfile_alpha_basic(&bc7Settings);
+            else GetProfile_basic(&bc7Settings);
+
+            class CompressionTask { public: unsigned _mip, _blockRowStart, _blockRowEnd; };
+            std::vector<CompressionTask> tasks;
+            const unsigned blockRowsPerStrip = 16;
+            for (unsigned m=0; m<mipCount; ++m) {
+                auto blockRows = mips[m]._height / 4;
+                for (unsigned r=0; r<blockRows; r+=blockRowsPerStrip)
+                    tasks.push_back(CompressionTask{m, r, std::min(r+blockRowsPerStrip, blockRows)});
+            }
+
+            auto compress = [&](unsigned t)
+            {
+                const auto& task = tasks[t];
+                const auto& src = mips[task._mip];
+                auto* dstImage = result._image.GetImage(task._mip, 0, 0);
+                rgba_surface surface
+                {
+                    (uint8_t*)src.Row(task._blockRowStart*4),
+                    int(src._width), int((task._blockRowEnd - task._blockRowStart)*4),
+                    int(src._width*4)
+                };
+                auto* dst = (uint8_t*)PtrAdd(dstImage->pixels, task._blockRowStart*dstImage->rowPitch);
+                switch (compression) {
+                case CookedTextureCompression::BC1: CompressBlocksBC1(&surface, dst); break;
+                case CookedTextureCompression::BC3: CompressBlocksBC3(&surface, dst); break;
+                case CookedTextureCompression::BC5: CompressBlocksBC5(&surface, dst); break;
+                case CookedTextureCompression::BC7: CompressBlocksBC7(&surface, dst, &bc7Settings); break;
+                default: assert(0); break;
+                }
+            };
+            if (!ParallelFor(pool, unsigned(tasks.size()), compress))
+                Throw(::Exceptions::BasicLabel("Failed while compressing texture (%s)", sourceFile));
+        }
+
+        const auto endTime = GetPerformanceCounter();
+        const auto toMS = [frequency](uint64 ticks) { return float(double(ticks) * 1000.0 / double(frequency)); };
+        LogInfo
+            << "Cooked texture (" << sourceFile << ") as " << AsString(compression)
+            << " [" << width << "x" << height << ", " << mipCount << " mips] in " << toMS(endTime - startTime) << "ms"
+            << " (load: " << toMS(loadTime - startTime) << "ms, mips: " << toMS(mipTime - loadTime)
+            << "ms, compression: " << toMS(endTime - mipTime) << "ms)";
+
+        return std::move(result);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    class TextureCompiler::Pimpl
+    {
+    public:
+        Threading::Mutex _threadLock;
+        SRGBTables _srgbTables;
+        std::unique_ptr<CompletionThreadPool> _workerPool;
+        std::unique_ptr<CompilationThread> _thread;     // (must be destroyed before the pool & tables)
+
+            // compile operations currently in flight, by hash of the intermediate name
+        std::vector<std::pair<uint64, std::weak_ptr<QueuedCompileOperation>>> _activeOperations;
+    };
+
+    static void DoCookTexture(QueuedCompileOperation& op, CompletionThreadPool& pool, const SRGBTables& tables)
+    {
+        TRY
+        {
+            auto cooked = CookTexture(op._initializer0, op._initializer1, pool, tables);
+
+                //  Write the dependencies before the texture itself. Clients watch the
+                //  cooked file for changes, and they will check the dependencies as soon
+                //  as it appears. If the save fails after this point, they'll just fall
+                //  back to the source file.
+            const auto* destination = op.GetLocator()._sourceID0;
+            op.GetLocator()._dependencyValidation = op._destinationStore->WriteDependencies(
+                destination, MakeStringSection(cooked._compileResult._baseDir),
+                MakeIteratorRange(cooked._compileResult._dependencies));
+            assert(op.GetLocator()._dependencyValidation);
+
+            char dirName[MaxPath];
+            XlDirname(dirName, dimof(dirName), destination);
+            CreateDirectoryRecursive(dirName);
+
+            ucs2 wdestination[MaxPath];
+            Conversion::Convert(wdestination, dimof(wdestination), destination, XlStringEnd(destination));
+            auto hresult = DirectX::SaveToDDSFile(
+                cooked._image.GetImages(), cooked._image.GetImageCount(), cooked._image.GetMetadata(),
+                DirectX::DDS_FLAGS_NONE, (const wchar_t*)wdestination);
+            if (!SUCCEEDED(hresult))
+                Throw(::Exceptions::BasicLabel("Failed while writing cooked texture (%s)", destination));
+
+            op.SetState(::Assets::AssetState::Ready);
+        } CATCH(const std::exception& e) {
+            LogWarning << "Texture cook failed for (" << op._initializer0 << "): " << e.what();
+            op.SetState(::Assets::AssetState::Invalid);
+        } CATCH(...) {
+            op.SetState(::Assets::AssetState::Invalid);
+        } CATCH_END
+    }
+
+    class TextureCompilerMarker : public ::Assets::ICompileMarker
+    {
+    public:
+        ::Assets::IntermediateAssetLocator GetExistingAsset() const;
+        std::shared_ptr<::Assets::PendingCompileMarker> InvokeCompile() const;
+        StringSection<::Assets::ResChar> Initializer() const;
+
+        TextureCompilerMarker(
+            ::Assets::rstring sourceFilename, ::Assets::rstring parameters,
+            const ::Assets::IntermediateAssets::Store& store,
+            std::shared_ptr<TextureCompiler> compiler);
+        ~TextureCompilerMarker();
+    private:
+        std::weak_ptr<TextureCompiler> _compiler;
+        ::Assets::rstring _sourceFilename, _parameters;
+        const ::Assets::IntermediateAssets::Store* _store;
+
+        void GetIntermediateName(::Assets::ResChar destination[], size_t destinationCount) const;
+    };
+
+    void TextureCompilerMarker::GetIntermediateName(::Assets::ResChar destination[], size_t destinationCount) const
+    {
+            // must end in ".dds", so the runtime loader will recognise it
+        _store->MakeIntermediateName(destination, (unsigned)destinationCount, _sourceFilename.c_str());
+        if (!_parameters.empty())
+            StringMeldAppend(destination, &destination[destinationCount]) << "-" << _parameters;
+        StringMeldAppend(destination, &destination[destinationCount]) << "-cooked.dds";
+    }
+
+    ::Assets::IntermediateAssetLocator TextureCompilerMarker::GetExistingAsset() const
+    {
+        ::Assets::IntermediateAssetLocator result;
+        GetIntermediateName(result._sourceID0, dimof(result._sourceID0));
+        result._dependencyValidation = _store->MakeDependencyValidation(result._sourceID0);
+        return result;
+    }
+
+    std::shared_ptr<::Assets::PendingCompileMarker> TextureCompilerMarker::InvokeCompile() const
+    {
+        auto c = _compiler.lock();
+        if (!c) return nullptr;
+
+        using namespace ::Assets;
+        ResChar intermediateName[MaxPath];
+        GetIntermediateName(intermediateName, dimof(intermediateName));
+        auto nameHash = Hash64(intermediateName, XlStringEnd(intermediateName));
+
+        ScopedLock(c->_pimpl->_threadLock);
+
+            // Many objects can request the same texture at the same time. If there's
+            // already a compile in flight for this output, just share it.
+        auto& active = c->_pimpl->_activeOperations;
+        active.erase(
+            std::remove_if(active.begin(), active.end(),
+                [](const std::pair<uint64, std::weak_ptr<QueuedCompileOperation>>& p)
+                {
+                    auto op = p.second.lock();
+                    return !op || op->GetAssetState() != AssetState::Pending;
+                }),
+            active.end());
+
+        auto i = LowerBound(active, nameHash);
+        if (i != active.end() && i->first == nameHash) {
+            auto existing = i->second.lock();
+            if (existing) return std::move(existing);
+        }
+
+        StringMeld<256,ResChar> debugInitializer;
+        debugInitializer << _sourceFilename << "(cooked texture)";
+
+        auto backgroundOp = std::make_shared<QueuedCompileOperation>();
+        backgroundOp->SetInitializer(debugInitializer);
+        XlCopyString(backgroundOp->_initializer0, _sourceFilename);
+        XlCopyString(backgroundOp->_initializer1, _parameters);
+        backgroundOp->_destinationStore = _store;
+        XlCopyString(backgroundOp->GetLocator()._sourceID0, intermediateName);
+
+        if (!c->_pimpl->_thread) {
+            c->_pimpl->_workerPool = std::make_unique<CompletionThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+            auto* pool = c->_pimpl->_workerPool.get();
+            const auto* tables = &c->_pimpl->_srgbTables;
+            c->_pimpl->_thread = std::make_unique<CompilationThread>(
+                [pool, tables](QueuedCompileOperation& op) { DoCookTexture(op, *pool, *tables); });
+        }
+        c->_pimpl->_thread->Push(backgroundOp);
+        active.insert(i, std::make_pair(nameHash, std::weak_ptr<QueuedCompileOperation>(backgroundOp)));
+
+        return std::move(backgroundOp);
+    }
+
+    StringSection<::Assets::ResChar> TextureCompilerMarker::Initializer() const
+    {
+        return MakeStringSection(_sourceFilename);
+    }
+
+    TextureCompilerMarker::TextureCompilerMarker(
+        ::Assets::rstring sourceFilename, ::Assets::rstring parameters,
+        const ::Assets::IntermediateAssets::Store& store,
+        std::shared_ptr<TextureCompiler> compiler)
+    : _sourceFilename(sourceFilename), _parameters(parameters), _compiler(std::move(compiler)), _store(&store) {}
+    TextureCompilerMarker::~TextureCompilerMarker() {}
+
+    std::shared_ptr<::Assets::ICompileMarker> TextureCompiler::PrepareAsset(
+        uint64 typeCode,
+        const ::Assets::ResChar* initializers[], unsigned initializerCount,
+        const ::Assets::IntermediateAssets::Store& store)
+    {
+        if (initializerCount < 1 || initializerCount > 2 || !initializers[0][0])
+            Throw(::Exceptions::BasicLabel("Expecting source filename and optional parameters string in TextureCompiler"));
+
+            // parameters should have been stripped off the source filename
+        assert(MakeFileNameSplitter(initializers[0]).ParametersWithDivider().Empty());
+        const auto* parameters = (initializerCount > 1) ? initializers[1] : "";
+        return std::make_shared<TextureCompilerMarker>(initializers[0], parameters, store, shared_from_this());
+    }
+
+    void TextureCompiler::StallOnPendingOperations(bool cancelAll)
+    {
+        {
+            ScopedLock(_pimpl->_threadLock);
+            if (!_pimpl->_thread) return;
+        }
+        _pimpl->_thread->StallOnPendingOperations(cancelAll);
+    }
+
+    TextureCompiler::TextureCompiler()
+    {
+        _pimpl = std::make_unique<Pimpl>();
+    }
+
+    TextureCompiler::~TextureCompiler()
+    {}
+
+}}
+
@@ -0,0 +1,65 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../../Assets/IntermediateAssets.h"
+#include "../../Utility/MemoryUtils.h"
+#include "../../Core/Types.h"
+#include <memory>
+
+namespace RenderCore { namespace Assets
+{
+    enum class SourceColorSpace { SRGB, Linear, Unspecified };
+    enum class CookedTextureCompression { Auto, BC1, BC3, BC5, BC7, None };
+
+    /// <summary>Settings read from the ".metadata" file attached to a texture</summary>
+    class TextureMetadata
+    {
+    public:
+        SourceColorSpace            _colorSpace;
+        CookedTextureCompression    _compression;
+
+        TextureMetadata() : _colorSpace(SourceColorSpace::Unspecified), _compression(CookedTextureCompression::Auto) {}
+    };
+
+    bool LoadTextureMetadata(TextureMetadata& result, const void* start, size_t size);
+
+    /// <summary>Cooks source textures into a mip-complete, block compressed form</summary>
+    /// Source images (tga, png, tif, etc) are loaded, mipmaps are generated with
+    /// a gamma-correct box filter, and each mip is compressed to BC1, BC3, BC5 or BC7.
+    /// Mip generation and compression are split into strips and run in parallel on a
+    /// worker pool owned by the compiler. The result is written as a .dds file in the
+    /// intermediate store, so loading the cooked texture at runtime is just a file read.
+    ///
+    /// Initializers are the source filename (without parameters) and then the
+    /// DeferredShaderResource parameters string (which may be empty). The compression
+    /// type is taken from the "compression" attribute in the metadata file, if it exists.
+    /// Otherwise normal maps get BC5, textures with alpha get BC3 and everything else BC1.
+    class TextureCompiler : public ::Assets::IntermediateAssets::IAssetCompiler, public std::enable_shared_from_this<TextureCompiler>
+    {
+    public:
+        std::shared_ptr<::Assets::ICompileMarker> PrepareAsset(
+            uint64 typeCode,
+            const ::Assets::ResChar* initializers[], unsigned initializerCount,
+            const ::Assets::IntermediateAssets::Store& destinationStore);
+
+        void StallOnPendingOperations(bool cancelAll);
+
+        static const uint64 CompileProcessType = ConstHash64<'Cook', 'edTe', 'x'>::Value;
+
+        TextureCompiler();
+        ~TextureCompiler();
+
+    protected:
+        class Pimpl;
+        std::unique_ptr<Pimpl> _pimpl;
+
+        friend class TextureCompilerMarker;
+    };
+
+}}
+
@@ -0,0 +1,201 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Device.h"
+#include "Metal/DeviceContext.h"
+#include "Metal/RenderTargetView.h"
+#include "Metal/Resource.h"
+#include "Metal/State.h"
+#include "../../Utility/PtrUtils.h"
+#include "../../Core/Exceptions.h"
+
+namespace RenderCore
+{
+    Device::Device()
+    {
+    }
+
+    Device::~Device()
+    {
+    }
+
+    std::unique_ptr<IPresentationChain>   Device::CreatePresentationChain(const void* platformValue, unsigned width, unsigned height)
+    {
+            //  There's no window to attach to, so the platform value is ignored
+        return std::make_unique<PresentationChain>(width, height);
+    }
+
+    void    Device::BeginFrame(IPresentationChain* presentationChain)
+    {
+        if (!_immediateThreadContext)
+            _immediateThreadContext = std::make_shared<ThreadContext>(true, shared_from_this());
+
+            //  Close off the commands recorded during the previous frame. Clients can
+            //  read the counters for that frame with GetCommandLog().GetLastFrame()
+        auto& metalContext = *_immediateThreadContext->GetUnderlying();
+        metalContext.GetCommandLog().EndFrame();
+
+        if (presentationChain) {
+            PresentationChain* swapChain = checked_cast<PresentationChain*>(presentationChain);
+            swapChain->AttachToContext(metalContext);
+        }
+        _immediateThreadContext->IncrFrameId();
+    }
+
+    std::shared_ptr<IThreadContext> Device::GetImmediateContext()
+    {
+        if (!_immediateThreadContext) {
+            _immediateThreadContext = std::make_shared<ThreadContext>(true, shared_from_this());
+        }
+        return _immediateThreadContext;
+    }
+
+    std::unique_ptr<IThreadContext> Device::CreateDeferredContext()
+    {
+        return std::make_unique<ThreadContext>(false, shared_from_this());
+    }
+
+    extern char VersionString[];
+    extern char BuildDateString[];
+
+    std::pair<const char*, const char*> Device::GetVersionInformation()
+    {
+        return std::make_pair(VersionString, BuildDateString);
+    }
+
+    void*   Device::QueryInterface(const GUID& guid)
+    {
+        return nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////
+
+    #if !FLEX_USE_VTABLE_Device && !DOXYGEN
+        namespace Detail
+        {
+            void* Ignore_Device::QueryInterface(const GUID& guid)
+            {
+                return nullptr;
+            }
+        }
+    #endif
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////
+
+    PresentationChain::PresentationChain(unsigned width, unsigned height)
+    {
+        _viewportContext = std::make_shared<ViewportContext>(UInt2(width, height));
+        _backBuffer = make_intrusive<Metal_Null::Underlying::Resource>(size_t(width) * size_t(height) * 4);
+    }
+
+    PresentationChain::~PresentationChain()
+    {
+    }
+
+    void            PresentationChain::Present()
+    {
+    }
+
+    void            PresentationChain::Resize(unsigned newWidth, unsigned newHeight)
+    {
+        if (newWidth == 0 || newHeight == 0)
+            Throw(::Exceptions::BasicLabel("Cannot resize because this presentation chain isn't attached to a window."));
+
+        _viewportContext->_dimensions = UInt2(newWidth, newHeight);
+        _backBuffer = make_intrusive<Metal_Null::Underlying::Resource>(size_t(newWidth) * size_t(newHeight) * 4);
+        _defaultDepthTarget.reset();
+    }
+
+    std::shared_ptr<ViewportContext> PresentationChain::GetViewportContext() const
+    {
+        return _viewportContext;
+    }
+
+    void PresentationChain::AttachToContext(Metal_Null::DeviceContext& context)
+    {
+            //  Same behaviour as the DX11 device: set the viewport to the full back buffer,
+            //  and bind the back buffer and a default depth buffer as the render targets
+        auto dims = _viewportContext->_dimensions;
+        context.Bind(Metal_Null::ViewportDesc(0.f, 0.f, float(dims[0]), float(dims[1])));
+
+        if (!_defaultDepthTarget)
+            _defaultDepthTarget = make_intrusive<Metal_Null::Underlying::Resource>(size_t(dims[0]) * size_t(dims[1]) * 4);
+
+        Metal_Null::RenderTargetView rtv(_backBuffer.get());
+        Metal_Null::DepthStencilView dsv(_defaultDepthTarget.get());
+        context.Clear(dsv, 1.f, 0);
+        context.Bind(MakeResourceList(rtv), &dsv);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////
+
+    render_dll_export std::shared_ptr<IDevice>    CreateDevice()
+    {
+        return std::make_shared<Device>();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////
+
+	#if !FLEX_USE_VTABLE_ThreadContext && !DOXYGEN
+		namespace Detail
+		{
+			void* Ignore_ThreadContext::QueryInterface(const GUID& guid)
+			{
+				return nullptr;
+			}
+		}
+	#endif
+
+    void*   ThreadContext::QueryInterface(const GUID& guid)
+    {
+        return nullptr;
+    }
+
+    bool    ThreadContext::IsImmediate() const
+    {
+        return _underlying->IsImmediate();
+    }
+
+    auto ThreadContext::GetStateDesc() const -> ThreadContextStateDesc
+    {
+        Metal_Null::ViewportDesc viewport(*_underlying.get());
+
+        ThreadContextStateDesc result;
+        result._viewportDimensions = Int2(int(viewport.Width), int(viewport.Height));
+        result._frameId = _frameId;
+        return result;
+    }
+
+    ThreadContext::ThreadContext(bool isImmediate, std::shared_ptr<Device> device)
+    : _device(std::move(device))
+    {
+        _underlying = std::make_shared<Metal_Null::DeviceContext>(isImmediate);
+        _frameId = 0;
+    }
+
+    ThreadContext::~ThreadContext() {}
+
+    std::shared_ptr<IDevice> ThreadContext::GetDevice() const
+    {
+        return _device.lock();
+    }
+
+    void ThreadContext::ClearAllBoundTargets() const
+    {
+        auto rtv = _underlying->GetBoundRenderTarget();
+        if (rtv)
+            _underlying->Clear(Metal_Null::RenderTargetView(rtv.get()), Float4(0.33f, 0.33f, 0.33f, 0.f));
+        auto dsv = _underlying->GetBoundDepthStencil();
+        if (dsv)
+            _underlying->Clear(Metal_Null::DepthStencilView(dsv.get()), 1.f, 0);
+    }
+
+    void ThreadContext::IncrFrameId()
+    {
+        ++_frameId;
+    }
+
+}
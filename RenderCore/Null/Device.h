@@ -0,0 +1,90 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#define FLEX_CONTEXT_Device				FLEX_CONTEXT_CONCRETE
+#define FLEX_CONTEXT_PresentationChain	FLEX_CONTEXT_CONCRETE
+#define FLEX_CONTEXT_ThreadContext		FLEX_CONTEXT_CONCRETE
+
+#include "../IDevice.h"
+#include "../IThreadContext.h"
+#include "../../Utility/IntrusivePtr.h"
+
+namespace RenderCore
+{
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Metal_Null { class DeviceContext; namespace Underlying { class Resource; } }
+
+    class Device;
+
+        //  The null device has no window and no GPU. The presentation chain is just
+        //  a pair of fake back buffer and depth resources, with the given dimensions.
+    class PresentationChain : public Base_PresentationChain
+    {
+    public:
+        void                Present() /*override*/;
+        void                Resize(unsigned newWidth, unsigned newHeight) /*override*/;
+
+        void                AttachToContext(Metal_Null::DeviceContext& context);
+
+        std::shared_ptr<ViewportContext> GetViewportContext() const;
+
+        PresentationChain(unsigned width, unsigned height);
+        ~PresentationChain();
+    private:
+        intrusive_ptr<Metal_Null::Underlying::Resource>     _backBuffer;
+        intrusive_ptr<Metal_Null::Underlying::Resource>     _defaultDepthTarget;
+        std::shared_ptr<ViewportContext>                    _viewportContext;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+
+    class ThreadContext : public Base_ThreadContext
+    {
+    public:
+        virtual void*               QueryInterface(const GUID& guid);
+        bool                        IsImmediate() const;
+        ThreadContextStateDesc      GetStateDesc() const;
+        std::shared_ptr<IDevice>    GetDevice() const;
+        void                        ClearAllBoundTargets() const;
+        void                        IncrFrameId();
+
+        const std::shared_ptr<Metal_Null::DeviceContext>&  GetUnderlying() const { return _underlying; }
+
+        ThreadContext(bool isImmediate, std::shared_ptr<Device> device);
+        ~ThreadContext();
+    protected:
+        std::shared_ptr<Metal_Null::DeviceContext> _underlying;
+        std::weak_ptr<Device>   _device;  // (must be weak, because Device holds a shared_ptr to the immediate context)
+        unsigned                _frameId;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+
+    class Device : public Base_Device, public std::enable_shared_from_this<Device>
+    {
+    public:
+        std::unique_ptr<IPresentationChain>     CreatePresentationChain(const void* platformValue, unsigned width, unsigned height) /*override*/;
+        void    BeginFrame(IPresentationChain* presentationChain);
+
+        std::pair<const char*, const char*>     GetVersionInformation();
+
+        std::shared_ptr<IThreadContext>         GetImmediateContext();
+        std::unique_ptr<IThreadContext>         CreateDeferredContext();
+
+        virtual void*                           QueryInterface(const GUID& guid);
+
+        Device();
+        ~Device();
+
+    protected:
+        std::shared_ptr<ThreadContext>  _immediateThreadContext;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+}
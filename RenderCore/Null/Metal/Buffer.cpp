@@ -0,0 +1,93 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Buffer.h"
+#include "DeviceContext.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+        //  Buffers on the null device never allocate memory for their contents.
+        //  The initial data is ignored; we only remember the size.
+        
+    VertexBuffer::VertexBuffer(const ObjectFactory& factory, const void* data, size_t byteCount)
+    {
+        if (byteCount!=0)
+            _underlying = make_intrusive<Underlying::Resource>(byteCount);
+    }
+
+    VertexBuffer::VertexBuffer(const void* data, size_t byteCount)
+        : VertexBuffer(ObjectFactory(), data, byteCount)
+    {}
+
+    VertexBuffer::VertexBuffer() {}
+
+    VertexBuffer::~VertexBuffer() {}
+
+    VertexBuffer::VertexBuffer(const VertexBuffer& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    VertexBuffer& VertexBuffer::operator=(const VertexBuffer& cloneFrom)            { _underlying = cloneFrom._underlying; return *this; }
+
+    VertexBuffer::VertexBuffer(VertexBuffer&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    VertexBuffer& VertexBuffer::operator=(VertexBuffer&& moveFrom) never_throws     { _underlying = std::move(moveFrom._underlying); return *this; }
+
+    VertexBuffer::VertexBuffer(intrusive_ptr<Underlying::Resource>&& cloneFrom) : _underlying(std::move(cloneFrom)) {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    IndexBuffer::IndexBuffer() {}
+    
+    IndexBuffer::IndexBuffer(const ObjectFactory& factory, const void* data, size_t byteCount)
+    {
+        if (byteCount!=0)
+            _underlying = make_intrusive<Underlying::Resource>(byteCount);
+    }
+
+    IndexBuffer::IndexBuffer(const void* data, size_t byteCount)
+        : IndexBuffer(ObjectFactory(), data, byteCount)
+    {}
+
+    IndexBuffer::IndexBuffer(DeviceContext& context)
+    : _underlying(context.GetBoundIndexBuffer())
+    {}
+
+    IndexBuffer::~IndexBuffer() {}
+
+    IndexBuffer::IndexBuffer(const IndexBuffer& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    IndexBuffer& IndexBuffer::operator=(const IndexBuffer& cloneFrom)            { _underlying = cloneFrom._underlying; return *this; }
+
+    IndexBuffer::IndexBuffer(IndexBuffer&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    IndexBuffer& IndexBuffer::operator=(IndexBuffer&& moveFrom) never_throws     { _underlying = std::move(moveFrom._underlying); return *this; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ConstantBuffer::ConstantBuffer() {}
+    ConstantBuffer::ConstantBuffer(const void* data, size_t byteCount, bool immutable)
+        : ConstantBuffer(ObjectFactory(), data, byteCount, immutable)
+    {}
+
+    ConstantBuffer::ConstantBuffer(
+        const ObjectFactory& factory,
+        const void* data, size_t byteCount, bool immutable)
+    {
+        if (byteCount!=0)
+            _underlying = make_intrusive<Underlying::Resource>(byteCount);
+    }
+
+    ConstantBuffer::~ConstantBuffer() {}
+
+    ConstantBuffer::ConstantBuffer(const ConstantBuffer& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    ConstantBuffer& ConstantBuffer::operator=(const ConstantBuffer& cloneFrom)            { _underlying = cloneFrom._underlying; return *this; }
+
+    ConstantBuffer::ConstantBuffer(intrusive_ptr<Underlying::Resource> underlyingBuffer) : _underlying(std::move(underlyingBuffer)) {}
+
+    void    ConstantBuffer::Update(DeviceContext& context, const void* data, size_t byteCount)
+    {
+        context.GetCommandLog().Push(CommandLog::Command::Upload, uint32(byteCount));
+    }
+
+    ConstantBuffer::ConstantBuffer(ConstantBuffer&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    ConstantBuffer& ConstantBuffer::operator=(ConstantBuffer&& moveFrom) never_throws     { _underlying = std::move(moveFrom._underlying); return *this; }
+
+}}
@@ -0,0 +1,96 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "CommandLog.h"
+#include "../../../Utility/PtrUtils.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+    void CommandLog::Push(Command command, uint32 arg)
+    {
+        switch (command) {
+        case Command::Draw:
+        case Command::DrawIndexed:
+            ++_currentFrame._drawCalls;
+            _currentFrame._verticesSubmitted += arg;
+            break;
+
+        case Command::DrawAuto:
+            ++_currentFrame._drawCalls;
+            break;
+
+        case Command::Dispatch:
+            ++_currentFrame._dispatchCalls;
+            break;
+
+        case Command::BindShader:
+            ++_currentFrame._shaderChanges;
+            ++_currentFrame._stateChanges;
+            break;
+
+        case Command::Clear:
+            ++_currentFrame._clears;
+            break;
+
+        case Command::Upload:
+            ++_currentFrame._uploadCount;
+            _currentFrame._bytesUploaded += arg;
+            break;
+
+        case Command::CommitCommandList:
+            break;
+
+        default:
+            ++_currentFrame._stateChanges;
+            break;
+        }
+
+        if (_recordEntries) {
+            Entry entry;
+            entry._command = command;
+            entry._arg = arg;
+            _entries.push_back(entry);
+        }
+    }
+
+    void CommandLog::EndFrame()
+    {
+        _lastFrame = _currentFrame;
+        _currentFrame = FrameStats();
+        _entries.clear();       // (clear without deallocating, so we don't reallocate every frame)
+        ++_frameCount;
+    }
+
+    auto CommandLog::GetEntries() const -> IteratorRange<const Entry*>
+    {
+        return MakeIteratorRange(AsPointer(_entries.cbegin()), AsPointer(_entries.cend()));
+    }
+
+    CommandLog::CommandLog(bool recordEntries)
+    : _frameCount(0), _recordEntries(recordEntries)
+    {}
+
+    CommandLog::~CommandLog() {}
+
+    CommandLog::FrameStats::FrameStats()
+    : _drawCalls(0), _dispatchCalls(0), _verticesSubmitted(0)
+    , _shaderChanges(0), _stateChanges(0), _clears(0)
+    , _uploadCount(0), _bytesUploaded(0)
+    {}
+
+    const char* AsString(CommandLog::Command command)
+    {
+        static const char* names[] = {
+            "Draw", "DrawIndexed", "DrawAuto", "Dispatch",
+            "BindShader", "BindState", "BindResources", "BindConstants", "BindSamplers",
+            "BindTargets", "BindGeometry", "Unbind",
+            "Clear", "Upload", "CommitCommandList"
+        };
+        auto index = unsigned(command);
+        return (index < dimof(names)) ? names[index] : "<<unknown>>";
+    }
+}}
+
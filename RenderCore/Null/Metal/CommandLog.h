@@ -0,0 +1,83 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../../../Utility/IteratorUtils.h"
+#include "../../../Core/Types.h"
+#include <vector>
+
+namespace RenderCore { namespace Metal_Null
+{
+    /// <summary>Compact record of the commands submitted to a null DeviceContext</summary>
+    /// The null device accepts every draw, dispatch, clear, state change and upload
+    /// without executing it. Instead, each one is recorded as a small entry, and
+    /// accumulated into per-frame counters.
+    ///
+    /// This is intended for measuring the CPU side cost of a frame, and how much work
+    /// the frame submits, on machines without a GPU.
+    ///
+    /// The null device calls EndFrame() on the immediate context's log in
+    /// IDevice::BeginFrame(). The counters for the previous frame are available
+    /// from GetLastFrame().
+    class CommandLog
+    {
+    public:
+        enum class Command : uint8
+        {
+            Draw, DrawIndexed, DrawAuto, Dispatch,
+            BindShader, BindState, BindResources, BindConstants, BindSamplers,
+            BindTargets, BindGeometry, Unbind,
+            Clear, Upload, CommitCommandList
+        };
+
+        class Entry
+        {
+        public:
+            Command     _command;
+            uint32      _arg;           // vertex/index count for draws, byte count for uploads, slot count for binds
+        };
+
+        class FrameStats
+        {
+        public:
+            unsigned    _drawCalls;
+            unsigned    _dispatchCalls;
+            uint64      _verticesSubmitted;
+            unsigned    _shaderChanges;
+            unsigned    _stateChanges;          // all bind commands, including the shader changes
+            unsigned    _clears;
+            unsigned    _uploadCount;
+            uint64      _bytesUploaded;
+
+            FrameStats();
+        };
+
+        void    Push(Command command, uint32 arg = 0);
+        void    EndFrame();
+
+        const FrameStats&               GetCurrentFrame() const     { return _currentFrame; }
+        const FrameStats&               GetLastFrame() const        { return _lastFrame; }
+        unsigned                        GetFrameCount() const       { return _frameCount; }
+        IteratorRange<const Entry*>     GetEntries() const;
+
+            //  When "recordEntries" is false, only the counters are updated
+        void    SetRecordEntries(bool recordEntries) { _recordEntries = recordEntries; }
+
+        CommandLog(bool recordEntries = true);
+        ~CommandLog();
+
+    protected:
+        std::vector<Entry>  _entries;
+        FrameStats          _currentFrame;
+        FrameStats          _lastFrame;
+        unsigned            _frameCount;
+        bool                _recordEntries;
+    };
+
+    const char* AsString(CommandLog::Command command);
+}}
+
@@ -0,0 +1,274 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "DeviceContext.h"
+#include "DeviceContextImpl.h"
+#include "InputLayout.h"
+#include "Shader.h"
+#include "State.h"
+#include "Buffer.h"
+#include "Resource.h"
+#include "ShaderResource.h"
+#include "../Device.h"
+#include "../../../Utility/PtrUtils.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+    void DeviceContext::Bind(unsigned startSlot, unsigned bufferCount, const VertexBuffer* VBs[], const unsigned strides[], const unsigned offsets[])
+    {
+        _commandLog.Push(CommandLog::Command::BindGeometry, bufferCount);
+    }
+
+    void DeviceContext::Bind(const BoundInputLayout& inputLayout)
+    {
+        _boundInputLayout = inputLayout.GetUnderlying();
+        _commandLog.Push(CommandLog::Command::BindGeometry);
+    }
+
+    void DeviceContext::Bind(Topology::Enum topology)
+    {
+        _commandLog.Push(CommandLog::Command::BindGeometry);
+    }
+
+    void DeviceContext::Bind(const VertexShader& vertexShader)      { _commandLog.Push(CommandLog::Command::BindShader, 1); }
+    void DeviceContext::Bind(const GeometryShader& geometryShader)  { _commandLog.Push(CommandLog::Command::BindShader, 1); }
+    void DeviceContext::Bind(const PixelShader& pixelShader)        { _commandLog.Push(CommandLog::Command::BindShader, 1); }
+    void DeviceContext::Bind(const ComputeShader& computeShader)    { _commandLog.Push(CommandLog::Command::BindShader, 1); }
+    void DeviceContext::Bind(const DomainShader& domainShader)      { _commandLog.Push(CommandLog::Command::BindShader, 1); }
+    void DeviceContext::Bind(const HullShader& hullShader)          { _commandLog.Push(CommandLog::Command::BindShader, 1); }
+
+        //  Binding a shader program counts as one shader change, with the number of
+        //  stages set as the argument (matching the number of XXSetShader calls on DX11)
+    void DeviceContext::Bind(const ShaderProgram& shaderProgram)
+    {
+        _commandLog.Push(CommandLog::Command::BindShader, 3);
+    }
+
+    void DeviceContext::Bind(const ShaderProgram& shaderProgram, const BoundClassInterfaces& dynLinkage)
+    {
+        _commandLog.Push(CommandLog::Command::BindShader, 3);
+    }
+
+    void DeviceContext::Bind(const DeepShaderProgram& shaderProgram)
+    {
+        _commandLog.Push(CommandLog::Command::BindShader, 5);
+    }
+
+    void DeviceContext::Bind(const DeepShaderProgram& shaderProgram, const BoundClassInterfaces& dynLinkage)
+    {
+        _commandLog.Push(CommandLog::Command::BindShader, 5);
+    }
+
+    void DeviceContext::Bind(const RasterizerState& rasterizer)
+    {
+        _boundRasterizer = rasterizer.GetUnderlying();
+        _commandLog.Push(CommandLog::Command::BindState);
+    }
+
+    void DeviceContext::Bind(const BlendState& blender)
+    {
+        _boundBlend = blender.GetUnderlying();
+        _commandLog.Push(CommandLog::Command::BindState);
+    }
+
+    void DeviceContext::Bind(const DepthStencilState& depthStencil, unsigned stencilRef)
+    {
+        _boundDepthStencilState = depthStencil.GetUnderlying();
+        _commandLog.Push(CommandLog::Command::BindState);
+    }
+
+    void DeviceContext::Bind(const IndexBuffer& ib, NativeFormat::Enum indexFormat, unsigned offset)
+    {
+        _boundIndexBuffer = ib.GetUnderlying();
+        _commandLog.Push(CommandLog::Command::BindGeometry, 1);
+    }
+
+    void DeviceContext::Bind(const ViewportDesc& viewport)
+    {
+        _boundViewport = viewport;
+        _commandLog.Push(CommandLog::Command::BindState);
+    }
+
+    void DeviceContext::Draw(unsigned vertexCount, unsigned startVertexLocation)
+    {
+        _commandLog.Push(CommandLog::Command::Draw, vertexCount);
+    }
+
+    void DeviceContext::DrawIndexed(unsigned indexCount, unsigned startIndexLocation, unsigned baseVertexLocation)
+    {
+        _commandLog.Push(CommandLog::Command::DrawIndexed, indexCount);
+    }
+
+    void DeviceContext::DrawAuto()
+    {
+        _commandLog.Push(CommandLog::Command::DrawAuto);
+    }
+
+    void DeviceContext::Dispatch(unsigned countX, unsigned countY, unsigned countZ)
+    {
+        _commandLog.Push(CommandLog::Command::Dispatch, countX*countY*countZ);
+    }
+
+    void DeviceContext::Clear(const RenderTargetView& renderTargets, const Float4& clearColour)
+    {
+        _commandLog.Push(CommandLog::Command::Clear);
+    }
+
+    void DeviceContext::Clear(const DepthStencilView& depthStencil, float depth, unsigned stencil)
+    {
+        _commandLog.Push(CommandLog::Command::Clear);
+    }
+
+    void DeviceContext::Clear(const UnorderedAccessView& unorderedAccess, unsigned values[4])
+    {
+        _commandLog.Push(CommandLog::Command::Clear);
+    }
+
+    void DeviceContext::Clear(const UnorderedAccessView& unorderedAccess, float values[4])
+    {
+        _commandLog.Push(CommandLog::Command::Clear);
+    }
+
+    void DeviceContext::ClearStencil(const DepthStencilView& depthStencil, unsigned stencil)
+    {
+        _commandLog.Push(CommandLog::Command::Clear);
+    }
+
+    template<> void DeviceContext::UnbindVS<ShaderResourceView>(unsigned startSlot, unsigned count)    { _commandLog.Push(CommandLog::Command::Unbind, count); }
+    template<> void DeviceContext::UnbindGS<ShaderResourceView>(unsigned startSlot, unsigned count)    { _commandLog.Push(CommandLog::Command::Unbind, count); }
+    template<> void DeviceContext::UnbindPS<ShaderResourceView>(unsigned startSlot, unsigned count)    { _commandLog.Push(CommandLog::Command::Unbind, count); }
+    template<> void DeviceContext::UnbindCS<ShaderResourceView>(unsigned startSlot, unsigned count)    { _commandLog.Push(CommandLog::Command::Unbind, count); }
+    template<> void DeviceContext::UnbindDS<ShaderResourceView>(unsigned startSlot, unsigned count)    { _commandLog.Push(CommandLog::Command::Unbind, count); }
+    template<> void DeviceContext::UnbindCS<UnorderedAccessView>(unsigned startSlot, unsigned count)   { _commandLog.Push(CommandLog::Command::Unbind, count); }
+
+    template<> void DeviceContext::Unbind<ComputeShader>()   { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+    template<> void DeviceContext::Unbind<HullShader>()      { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+    template<> void DeviceContext::Unbind<DomainShader>()    { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+    template<> void DeviceContext::Unbind<VertexShader>()    { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+    template<> void DeviceContext::Unbind<PixelShader>()     { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+    template<> void DeviceContext::Unbind<GeometryShader>()  { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+    template<> void DeviceContext::Unbind<VertexBuffer>()    { _commandLog.Push(CommandLog::Command::Unbind, 1); }
+
+    template<> void DeviceContext::Unbind<BoundInputLayout>()
+    {
+        _boundInputLayout = 0;
+        _commandLog.Push(CommandLog::Command::Unbind, 1);
+    }
+
+    template<> void DeviceContext::Unbind<RenderTargetView>()
+    {
+        _boundRenderTarget.reset();
+        _boundDepthStencil.reset();
+        _commandLog.Push(CommandLog::Command::Unbind, 1);
+    }
+
+    void DeviceContext::UnbindSO()
+    {
+        _commandLog.Push(CommandLog::Command::Unbind, 1);
+    }
+
+    void        DeviceContext::InvalidateCachedState()
+    {
+    }
+
+    void                        DeviceContext::BeginCommandList()
+    {
+    }
+
+    intrusive_ptr<CommandList>     DeviceContext::ResolveCommandList()
+    {
+        return make_intrusive<CommandList>();
+    }
+
+    bool    DeviceContext::IsImmediate() const
+    {
+        return _isImmediate;
+    }
+
+    void    DeviceContext::CommitCommandList(CommandList& commandList, bool preserveRenderState)
+    {
+        _commandLog.Push(CommandLog::Command::CommitCommandList);
+    }
+
+    std::shared_ptr<DeviceContext>  DeviceContext::Get(IThreadContext& threadContext)
+    {
+        return checked_cast<ThreadContext*>(&threadContext)->GetUnderlying();
+    }
+
+    void DeviceContext::PrepareForDestruction(IDevice* device, IPresentationChain* presentationChain)
+    {
+    }
+
+    DeviceContext::DeviceContext(bool isImmediate)
+    : _isImmediate(isImmediate)
+    , _boundRasterizer(0), _boundBlend(0), _boundDepthStencilState(0), _boundInputLayout(0)
+    , _boundViewport(0.f, 0.f, 0.f, 0.f)
+    {
+    }
+
+    DeviceContext::~DeviceContext()
+    {}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ObjectFactory::ObjectFactory(IDevice* device) {}
+    ObjectFactory::ObjectFactory() {}
+    ObjectFactory::~ObjectFactory() {}
+    ObjectFactory::ObjectFactory(const ObjectFactory& cloneFrom) {}
+    ObjectFactory::ObjectFactory(ObjectFactory&& moveFrom) never_throws {}
+    ObjectFactory& ObjectFactory::operator=(const ObjectFactory& cloneFrom) { return *this; }
+    ObjectFactory& ObjectFactory::operator=(ObjectFactory&& moveFrom) never_throws { return *this; }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    CommandList::CommandList() {}
+
+    template void DeviceContext::Bind<1>(const ResourceList<VertexBuffer, 1>&, unsigned, unsigned);
+    template void DeviceContext::Bind<2>(const ResourceList<VertexBuffer, 2>&, unsigned, unsigned);
+    template void DeviceContext::Bind<3>(const ResourceList<VertexBuffer, 3>&, unsigned, unsigned);
+
+    template void DeviceContext::Bind<0>(const ResourceList<RenderTargetView, 0>&, const DepthStencilView*);
+    template void DeviceContext::Bind<1>(const ResourceList<RenderTargetView, 1>&, const DepthStencilView*);
+    template void DeviceContext::Bind<2>(const ResourceList<RenderTargetView, 2>&, const DepthStencilView*);
+    template void DeviceContext::Bind<3>(const ResourceList<RenderTargetView, 3>&, const DepthStencilView*);
+    template void DeviceContext::Bind<4>(const ResourceList<RenderTargetView, 4>&, const DepthStencilView*);
+    template void DeviceContext::Bind<1,1>(const ResourceList<RenderTargetView, 1>&, const DepthStencilView*, const ResourceList<UnorderedAccessView, 1>&);
+    template void DeviceContext::Bind<1,2>(const ResourceList<RenderTargetView, 1>&, const DepthStencilView*, const ResourceList<UnorderedAccessView, 2>&);
+
+    #define EXPAND(BINDABLE, FN)                                                          \
+        template void DeviceContext::FN<1>(const ResourceList<BINDABLE, 1>&);             \
+        template void DeviceContext::FN<2>(const ResourceList<BINDABLE, 2>&);             \
+        template void DeviceContext::FN<3>(const ResourceList<BINDABLE, 3>&);             \
+        template void DeviceContext::FN<4>(const ResourceList<BINDABLE, 4>&);             \
+        template void DeviceContext::FN<5>(const ResourceList<BINDABLE, 5>&);             \
+        template void DeviceContext::FN<6>(const ResourceList<BINDABLE, 6>&);             \
+        template void DeviceContext::FN<7>(const ResourceList<BINDABLE, 7>&);             \
+        template void DeviceContext::FN<8>(const ResourceList<BINDABLE, 8>&);             \
+        template void DeviceContext::FN<9>(const ResourceList<BINDABLE, 9>&);             \
+        /**/
+
+    #define EXPANDSTAGES(BINDABLE)          \
+        EXPAND(BINDABLE, BindVS)            \
+        EXPAND(BINDABLE, BindPS)            \
+        EXPAND(BINDABLE, BindGS)            \
+        EXPAND(BINDABLE, BindHS)            \
+        EXPAND(BINDABLE, BindDS)            \
+        EXPAND(BINDABLE, BindCS)            \
+        /**/
+
+    EXPANDSTAGES(SamplerState)
+    EXPANDSTAGES(ShaderResourceView)
+    EXPANDSTAGES(ConstantBuffer)
+    EXPAND(UnorderedAccessView, BindCS)
+
+    template void DeviceContext::BindSO<1>(const ResourceList<VertexBuffer, 1>&, unsigned);
+    template void DeviceContext::BindSO<2>(const ResourceList<VertexBuffer, 2>&, unsigned);
+}}
+
+namespace ConsoleRig
+{
+    template class Attachable<RenderCore::Metal_Null::ObjectFactory>;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "DeviceContext.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+    template<int Count> void DeviceContext::Bind(const ResourceList<VertexBuffer, Count>& VBs, unsigned stride, unsigned offset)
+    {
+        _commandLog.Push(CommandLog::Command::BindGeometry, Count);
+    }
+
+    template<int Count> void DeviceContext::BindVS(const ResourceList<ShaderResourceView, Count>& shaderResources)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+    
+    template<int Count> void DeviceContext::BindPS(const ResourceList<ShaderResourceView, Count>& shaderResources)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+
+    template<int Count> void DeviceContext::BindCS(const ResourceList<ShaderResourceView, Count>& shaderResources)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+
+    template<int Count> void DeviceContext::BindGS(const ResourceList<ShaderResourceView, Count>& shaderResources)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+
+    template<int Count> void DeviceContext::BindHS(const ResourceList<ShaderResourceView, Count>& shaderResources)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+
+    template<int Count> void DeviceContext::BindDS(const ResourceList<ShaderResourceView, Count>& shaderResources)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+
+    template<int Count> void DeviceContext::BindVS(const ResourceList<SamplerState, Count>& samplerStates)
+    {
+        _commandLog.Push(CommandLog::Command::BindSamplers, Count);
+    }
+
+    template<int Count> void DeviceContext::BindPS(const ResourceList<SamplerState, Count>& samplerStates)
+    {
+        _commandLog.Push(CommandLog::Command::BindSamplers, Count);
+    }
+
+    template<int Count> void DeviceContext::BindGS(const ResourceList<SamplerState, Count>& samplerStates)
+    {
+        _commandLog.Push(CommandLog::Command::BindSamplers, Count);
+    }
+
+    template<int Count> void DeviceContext::BindCS(const ResourceList<SamplerState, Count>& samplerStates)
+    {
+        _commandLog.Push(CommandLog::Command::BindSamplers, Count);
+    }
+
+    template<int Count> void DeviceContext::BindHS(const ResourceList<SamplerState, Count>& samplerStates)
+    {
+        _commandLog.Push(CommandLog::Command::BindSamplers, Count);
+    }
+
+    template<int Count> void DeviceContext::BindDS(const ResourceList<SamplerState, Count>& samplerStates)
+    {
+        _commandLog.Push(CommandLog::Command::BindSamplers, Count);
+    }
+
+    template<int Count> void DeviceContext::BindVS(const ResourceList<ConstantBuffer, Count>& constantBuffers)
+    {
+        _commandLog.Push(CommandLog::Command::BindConstants, Count);
+    }
+
+    template<int Count> void DeviceContext::BindPS(const ResourceList<ConstantBuffer, Count>& constantBuffers)
+    {
+        _commandLog.Push(CommandLog::Command::BindConstants, Count);
+    }
+
+    template<int Count> void DeviceContext::BindCS(const ResourceList<ConstantBuffer, Count>& constantBuffers)
+    {
+        _commandLog.Push(CommandLog::Command::BindConstants, Count);
+    }
+
+    template<int Count> void DeviceContext::BindGS(const ResourceList<ConstantBuffer, Count>& constantBuffers)
+    {
+        _commandLog.Push(CommandLog::Command::BindConstants, Count);
+    }
+
+    template<int Count> void DeviceContext::BindHS(const ResourceList<ConstantBuffer, Count>& constantBuffers)
+    {
+        _commandLog.Push(CommandLog::Command::BindConstants, Count);
+    }
+
+    template<int Count> void DeviceContext::BindDS(const ResourceList<ConstantBuffer, Count>& constantBuffers)
+    {
+        _commandLog.Push(CommandLog::Command::BindConstants, Count);
+    }
+
+    template<int Count> void DeviceContext::Bind(const ResourceList<RenderTargetView, Count>& renderTargets, const DepthStencilView* depthStencil)
+    {
+        assert(renderTargets._startingPoint == 0);
+        _boundRenderTarget = Count ? renderTargets._buffers[0] : nullptr;
+        _boundDepthStencil = depthStencil ? depthStencil->GetUnderlying() : nullptr;
+        _commandLog.Push(CommandLog::Command::BindTargets, Count);
+    }
+
+    template<int Count> void DeviceContext::BindCS(const ResourceList<UnorderedAccessView, Count>& unorderedAccess)
+    {
+        _commandLog.Push(CommandLog::Command::BindResources, Count);
+    }
+
+    template<int Count1, int Count2> void    DeviceContext::Bind(const ResourceList<RenderTargetView, Count1>& renderTargets, const DepthStencilView* depthStencil, const ResourceList<UnorderedAccessView, Count2>& unorderedAccess)
+    {
+        _boundRenderTarget = Count1 ? renderTargets._buffers[0] : nullptr;
+        _boundDepthStencil = depthStencil ? depthStencil->GetUnderlying() : nullptr;
+        _commandLog.Push(CommandLog::Command::BindTargets, Count1 + Count2);
+    }
+
+    template<int Count> void DeviceContext::BindSO(const ResourceList<VertexBuffer, Count>& buffers, unsigned offset)
+    {
+        assert(buffers._startingPoint==0);
+        _commandLog.Push(CommandLog::Command::BindGeometry, Count);
+    }
+
+
+}}
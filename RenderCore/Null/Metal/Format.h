@@ -0,0 +1,209 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+namespace Utility { namespace ImpliedTyping { class TypeDesc; }}
+
+namespace RenderCore { namespace Metal_Null
+{
+    namespace Detail
+    {
+            //  dxgiformat.h isn't available on every platform the null device
+            //  targets. But we still want the same format numbers as the DX11
+            //  build, so that serialized formats (texture metadata, compiled
+            //  model vertex layouts) mean the same thing with either device.
+        enum DXGIFormatValue
+        {
+            DXGI_FORMAT_R32G32B32A32_TYPELESS = 1,
+            DXGI_FORMAT_R32G32B32A32_FLOAT    = 2,
+            DXGI_FORMAT_R32G32B32A32_UINT     = 3,
+            DXGI_FORMAT_R32G32B32A32_SINT     = 4,
+            DXGI_FORMAT_R32G32B32_TYPELESS    = 5,
+            DXGI_FORMAT_R32G32B32_FLOAT       = 6,
+            DXGI_FORMAT_R32G32B32_UINT        = 7,
+            DXGI_FORMAT_R32G32B32_SINT        = 8,
+            DXGI_FORMAT_R16G16B16A16_TYPELESS = 9,
+            DXGI_FORMAT_R16G16B16A16_FLOAT    = 10,
+            DXGI_FORMAT_R16G16B16A16_UNORM    = 11,
+            DXGI_FORMAT_R16G16B16A16_UINT     = 12,
+            DXGI_FORMAT_R16G16B16A16_SNORM    = 13,
+            DXGI_FORMAT_R16G16B16A16_SINT     = 14,
+            DXGI_FORMAT_R32G32_TYPELESS       = 15,
+            DXGI_FORMAT_R32G32_FLOAT          = 16,
+            DXGI_FORMAT_R32G32_UINT           = 17,
+            DXGI_FORMAT_R32G32_SINT           = 18,
+            DXGI_FORMAT_R10G10B10A2_TYPELESS  = 23,
+            DXGI_FORMAT_R10G10B10A2_UNORM     = 24,
+            DXGI_FORMAT_R10G10B10A2_UINT      = 25,
+            DXGI_FORMAT_R11G11B10_FLOAT       = 26,
+            DXGI_FORMAT_R8G8B8A8_TYPELESS     = 27,
+            DXGI_FORMAT_R8G8B8A8_UNORM        = 28,
+            DXGI_FORMAT_R8G8B8A8_UNORM_SRGB   = 29,
+            DXGI_FORMAT_R8G8B8A8_UINT         = 30,
+            DXGI_FORMAT_R8G8B8A8_SNORM        = 31,
+            DXGI_FORMAT_R8G8B8A8_SINT         = 32,
+            DXGI_FORMAT_R16G16_TYPELESS       = 33,
+            DXGI_FORMAT_R16G16_FLOAT          = 34,
+            DXGI_FORMAT_R16G16_UNORM          = 35,
+            DXGI_FORMAT_R16G16_UINT           = 36,
+            DXGI_FORMAT_R16G16_SNORM          = 37,
+            DXGI_FORMAT_R16G16_SINT           = 38,
+            DXGI_FORMAT_R32_TYPELESS          = 39,
+            DXGI_FORMAT_D32_FLOAT             = 40,
+            DXGI_FORMAT_R32_FLOAT             = 41,
+            DXGI_FORMAT_R32_UINT              = 42,
+            DXGI_FORMAT_R32_SINT              = 43,
+            DXGI_FORMAT_R24G8_TYPELESS        = 44,
+            DXGI_FORMAT_D24_UNORM_S8_UINT     = 45,
+            DXGI_FORMAT_R24_UNORM_X8_TYPELESS = 46,
+            DXGI_FORMAT_X24_TYPELESS_G8_UINT  = 47,
+            DXGI_FORMAT_R8G8_TYPELESS         = 48,
+            DXGI_FORMAT_R8G8_UNORM            = 49,
+            DXGI_FORMAT_R8G8_UINT             = 50,
+            DXGI_FORMAT_R8G8_SNORM            = 51,
+            DXGI_FORMAT_R8G8_SINT             = 52,
+            DXGI_FORMAT_R16_TYPELESS          = 53,
+            DXGI_FORMAT_R16_FLOAT             = 54,
+            DXGI_FORMAT_D16_UNORM             = 55,
+            DXGI_FORMAT_R16_UNORM             = 56,
+            DXGI_FORMAT_R16_UINT              = 57,
+            DXGI_FORMAT_R16_SNORM             = 58,
+            DXGI_FORMAT_R16_SINT              = 59,
+            DXGI_FORMAT_R8_TYPELESS           = 60,
+            DXGI_FORMAT_R8_UNORM              = 61,
+            DXGI_FORMAT_R8_UINT               = 62,
+            DXGI_FORMAT_R8_SNORM              = 63,
+            DXGI_FORMAT_R8_SINT               = 64,
+            DXGI_FORMAT_A8_UNORM              = 65,
+            DXGI_FORMAT_R1_UNORM              = 66,
+            DXGI_FORMAT_R9G9B9E5_SHAREDEXP    = 67,
+            DXGI_FORMAT_R8G8_B8G8_UNORM       = 68,
+            DXGI_FORMAT_G8R8_G8B8_UNORM       = 69,
+            DXGI_FORMAT_BC1_TYPELESS          = 70,
+            DXGI_FORMAT_BC1_UNORM             = 71,
+            DXGI_FORMAT_BC1_UNORM_SRGB        = 72,
+            DXGI_FORMAT_BC2_TYPELESS          = 73,
+            DXGI_FORMAT_BC2_UNORM             = 74,
+            DXGI_FORMAT_BC2_UNORM_SRGB        = 75,
+            DXGI_FORMAT_BC3_TYPELESS          = 76,
+            DXGI_FORMAT_BC3_UNORM             = 77,
+            DXGI_FORMAT_BC3_UNORM_SRGB        = 78,
+            DXGI_FORMAT_BC4_TYPELESS          = 79,
+            DXGI_FORMAT_BC4_UNORM             = 80,
+            DXGI_FORMAT_BC4_SNORM             = 81,
+            DXGI_FORMAT_BC5_TYPELESS          = 82,
+            DXGI_FORMAT_BC5_UNORM             = 83,
+            DXGI_FORMAT_BC5_SNORM             = 84,
+            DXGI_FORMAT_B5G6R5_UNORM          = 85,
+            DXGI_FORMAT_B5G5R5A1_UNORM        = 86,
+            DXGI_FORMAT_B8G8R8A8_UNORM        = 87,
+            DXGI_FORMAT_B8G8R8X8_UNORM        = 88,
+            DXGI_FORMAT_B8G8R8A8_TYPELESS     = 90,
+            DXGI_FORMAT_B8G8R8A8_UNORM_SRGB   = 91,
+            DXGI_FORMAT_B8G8R8X8_TYPELESS     = 92,
+            DXGI_FORMAT_B8G8R8X8_UNORM_SRGB   = 93,
+            DXGI_FORMAT_BC6H_TYPELESS         = 94,
+            DXGI_FORMAT_BC6H_UF16             = 95,
+            DXGI_FORMAT_BC6H_SF16             = 96,
+            DXGI_FORMAT_BC7_TYPELESS          = 97,
+            DXGI_FORMAT_BC7_UNORM             = 98,
+            DXGI_FORMAT_BC7_UNORM_SRGB        = 99,
+        };
+    }
+
+    /// Container for NativeFormat::Enum
+    namespace NativeFormat
+    {
+        enum Enum
+        {
+            Unknown = 0,
+
+            #undef _EXP
+            #define _EXP(X, Y, Z, U)    X##_##Y = Detail::DXGI_FORMAT_##X##_##Y,
+                #include "../../Metal/Detail/DXGICompatibleFormats.h"
+            #undef _EXP
+
+            R24G8_TYPELESS = Detail::DXGI_FORMAT_R24G8_TYPELESS,
+            D24_UNORM_S8_UINT = Detail::DXGI_FORMAT_D24_UNORM_S8_UINT,
+            R24_UNORM_X8_TYPELESS = Detail::DXGI_FORMAT_R24_UNORM_X8_TYPELESS,
+            X24_TYPELESS_G8_UINT = Detail::DXGI_FORMAT_X24_TYPELESS_G8_UINT,
+
+            Matrix4x4 = 150,
+            Matrix3x4 = 151
+        };
+    }
+
+    /// Container for FormatCompressionType::Enum
+    namespace FormatCompressionType
+    {
+        enum Enum
+        {
+            None, BlockCompression
+        };
+    }
+
+    /// Container for FormatComponents::Enum
+    namespace FormatComponents
+    {
+        enum Enum
+        {
+            Unknown,
+            Alpha, 
+            Luminance, LuminanceAlpha,
+            RGB, RGBAlpha,
+            RG, Depth, RGBE
+        };
+    }
+
+    /// Container for FormatComponentType::Enum
+    namespace FormatComponentType
+    {
+        enum Enum
+        {
+            Typeless,
+            Float, UInt, SInt,
+            UNorm, SNorm, UNorm_SRGB,
+            Exponential,
+            UnsignedFloat16, SignedFloat16
+        };
+    }
+
+    auto        GetCompressionType(NativeFormat::Enum format) -> FormatCompressionType::Enum;
+    auto        GetComponents(NativeFormat::Enum format) -> FormatComponents::Enum;
+    auto        GetComponentType(NativeFormat::Enum format) -> FormatComponentType::Enum;
+    unsigned    BitsPerPixel(NativeFormat::Enum format);
+    unsigned    GetComponentPrecision(NativeFormat::Enum format);
+    unsigned    GetDecompressedComponentPrecision(NativeFormat::Enum format);
+    unsigned    GetComponentCount(FormatComponents::Enum components);
+
+    NativeFormat::Enum FindFormat(
+        FormatCompressionType::Enum compression, 
+        FormatComponents::Enum components,
+        FormatComponentType::Enum componentType,
+        unsigned precision);
+
+    NativeFormat::Enum      AsSRGBFormat(NativeFormat::Enum inputFormat);
+    NativeFormat::Enum      AsLinearFormat(NativeFormat::Enum inputFormat);
+    NativeFormat::Enum      AsTypelessFormat(NativeFormat::Enum inputFormat);
+    bool                    HasLinearAndSRGBFormats(NativeFormat::Enum inputFormat);
+
+    namespace ShaderNormalizationMode
+    {
+        enum Enum 
+        {
+            Integer, Normalized, Float
+        };
+    }
+
+    NativeFormat::Enum      AsNativeFormat(
+        const Utility::ImpliedTyping::TypeDesc& type,
+        ShaderNormalizationMode::Enum norm = ShaderNormalizationMode::Integer);
+
+    const char* AsString(NativeFormat::Enum);
+    NativeFormat::Enum AsNativeFormat(const char name[]);
+}}
+
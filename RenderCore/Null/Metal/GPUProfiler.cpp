@@ -0,0 +1,41 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "GPUProfiler.h"
+#include "DeviceContext.h"
+
+namespace RenderCore { namespace Metal_Null { namespace GPUProfiler
+{
+        //  There are no GPU timestamps on the null device. The profiler object
+        //  exists so that clients can create and pass it around as usual, but it
+        //  never generates any events.
+    class Profiler
+    {
+    };
+
+    void ProfilerDestroyer::operator()(const void* ptr)
+    {
+        delete (const Profiler*)ptr;
+    }
+
+    Ptr     CreateProfiler()
+    {
+        return Ptr(new Profiler);
+    }
+
+    void    Frame_Begin(DeviceContext& context, Profiler*profiler, unsigned frameID) {}
+    void    Frame_End(DeviceContext& context, Profiler*profiler) {}
+    void    TriggerEvent(DeviceContext& context, Profiler*profiler, const char name[], EventType type) {}
+
+    std::pair<uint64,uint64> CalculateSynchronisation(DeviceContext& context, Profiler*profiler) 
+    { 
+        return std::pair<uint64,uint64>(0,0);
+    }
+
+    void    AddEventListener(EventListener* callback) {}
+    void    RemoveEventListener(EventListener* callback) {}
+
+}}}
@@ -0,0 +1,453 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "InputLayout.h"
+#include "Shader.h"
+#include "Buffer.h"
+#include "ShaderResource.h"
+#include "DeviceContext.h"
+#include "../../RenderUtils.h"
+#include "../../../Utility/StringUtils.h"
+#include "../../../Utility/MemoryUtils.h"
+#include "../../../Utility/PtrUtils.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+
+    BoundInputLayout::BoundInputLayout(const InputLayout& layout, const ShaderProgram& shader)
+    : BoundInputLayout(layout, shader.GetCompiledVertexShader())
+    {}
+
+    BoundInputLayout::BoundInputLayout(const InputLayout& layout, const CompiledShaderByteCode& shader)
+    {
+            //  The input layout object is just a hash of the elements. The shader
+            //  is only used for validation on the other devices, so we ignore it here.
+        auto hash = DefaultSeed64;
+        for (unsigned c=0; c<layout.second; ++c) {
+            const auto& e = layout.first[c];
+            unsigned values[] = {
+                e._semanticIndex, unsigned(e._nativeFormat), e._inputSlot,
+                e._alignedByteOffset, unsigned(e._inputSlotClass), e._instanceDataStepRate };
+            hash = Hash64(e._semanticName.c_str(), e._semanticName.c_str() + e._semanticName.size(), hash);
+            hash = Hash64(values, ArrayEnd(values), hash);
+        }
+        _underlying = hash;
+    }
+
+    BoundInputLayout::BoundInputLayout(DeviceContext& context) : _underlying(context.GetBoundInputLayout()) {}
+    BoundInputLayout::BoundInputLayout() : _underlying(0) {}
+    BoundInputLayout::~BoundInputLayout() {}
+
+	BoundInputLayout::BoundInputLayout(BoundInputLayout&& moveFrom) never_throws
+	: _underlying(moveFrom._underlying)
+	{
+        moveFrom._underlying = 0;
+	}
+
+	BoundInputLayout& BoundInputLayout::operator=(BoundInputLayout&& moveFrom) never_throws
+	{
+		_underlying = moveFrom._underlying;
+        moveFrom._underlying = 0;
+		return *this;
+	}
+
+    namespace GlobalInputLayouts
+    {
+        namespace Detail
+        {
+            static const unsigned AppendAlignedElement = ~unsigned(0x0);
+            InputElementDesc P2CT_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32_FLOAT   ),
+                InputElementDesc( "COLOR",      0, NativeFormat::R8G8B8A8_UNORM ),
+                InputElementDesc( "TEXCOORD",   0, NativeFormat::R32G32_FLOAT   )
+            };
+
+            InputElementDesc P2C_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32_FLOAT   ),
+                InputElementDesc( "COLOR",      0, NativeFormat::R8G8B8A8_UNORM )
+            };
+
+            InputElementDesc PCT_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT),
+                InputElementDesc( "COLOR",      0, NativeFormat::R8G8B8A8_UNORM ),
+                InputElementDesc( "TEXCOORD",   0, NativeFormat::R32G32_FLOAT   )
+            };
+
+            InputElementDesc P_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT)
+            };
+
+            InputElementDesc PC_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT),
+                InputElementDesc( "COLOR",      0, NativeFormat::R8G8B8A8_UNORM )
+            };
+
+            InputElementDesc PT_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT),
+                InputElementDesc( "TEXCOORD",   0, NativeFormat::R32G32_FLOAT   )
+            };
+
+            InputElementDesc PN_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT),
+                InputElementDesc( "NORMAL",   0, NativeFormat::R32G32B32_FLOAT )
+            };
+
+            InputElementDesc PNT_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT),
+                InputElementDesc( "NORMAL",   0, NativeFormat::R32G32B32_FLOAT ),
+                InputElementDesc( "TEXCOORD",   0, NativeFormat::R32G32_FLOAT )
+            };
+
+            InputElementDesc PNTT_Elements[] = 
+            {
+                InputElementDesc( "POSITION",   0, NativeFormat::R32G32B32_FLOAT),
+                InputElementDesc( "NORMAL",   0, NativeFormat::R32G32B32_FLOAT ),
+                InputElementDesc( "TEXCOORD",   0, NativeFormat::R32G32_FLOAT ),
+                InputElementDesc( "TEXTANGENT",   0, NativeFormat::R32G32B32_FLOAT ),
+                InputElementDesc( "TEXBITANGENT",   0, NativeFormat::R32G32B32_FLOAT )
+            };
+        }
+
+        InputLayout P2CT = std::make_pair(Detail::P2CT_Elements, dimof(Detail::P2CT_Elements));
+        InputLayout P2C = std::make_pair(Detail::P2C_Elements, dimof(Detail::P2C_Elements));
+        InputLayout PCT = std::make_pair(Detail::PCT_Elements, dimof(Detail::PCT_Elements));
+        InputLayout P = std::make_pair(Detail::P_Elements, dimof(Detail::P_Elements));
+        InputLayout PC = std::make_pair(Detail::PC_Elements, dimof(Detail::PC_Elements));
+        InputLayout PT = std::make_pair(Detail::PT_Elements, dimof(Detail::PT_Elements));
+        InputLayout PN = std::make_pair(Detail::PN_Elements, dimof(Detail::PN_Elements));
+        InputLayout PNT = std::make_pair(Detail::PNT_Elements, dimof(Detail::PNT_Elements));
+        InputLayout PNTT = std::make_pair(Detail::PNTT_Elements, dimof(Detail::PNTT_Elements));
+    }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    BoundUniforms::BoundUniforms(const ShaderProgram& shader)
+    {
+            //  In this case, we must bind with every shader stage 
+            //      (since a shader program actually reflects the state of the entire stage pipeline) 
+        _stageBindings[ShaderStage::Vertex]._hasShader      = true;
+        _stageBindings[ShaderStage::Pixel]._hasShader       = true;
+        _stageBindings[ShaderStage::Geometry]._hasShader    = shader.GetCompiledGeometryShader() != nullptr;
+    }
+
+    BoundUniforms::BoundUniforms(const DeepShaderProgram& shader)
+    {
+        _stageBindings[ShaderStage::Vertex]._hasShader      = true;
+        _stageBindings[ShaderStage::Pixel]._hasShader       = true;
+        _stageBindings[ShaderStage::Geometry]._hasShader    = shader.GetCompiledGeometryShader() != nullptr;
+        _stageBindings[ShaderStage::Hull]._hasShader        = true;
+        _stageBindings[ShaderStage::Domain]._hasShader      = true;
+    }
+
+	BoundUniforms::BoundUniforms(const CompiledShaderByteCode& shader)
+    {
+            //  In this case, we're binding with a single shader stage
+        ShaderStage::Enum stage = shader.GetStage();
+        if (stage < dimof(_stageBindings))
+            _stageBindings[stage]._hasShader = true;
+    }
+
+    BoundUniforms::BoundUniforms() {}
+
+    BoundUniforms::~BoundUniforms() {}
+
+    BoundUniforms::BoundUniforms(const BoundUniforms& copyFrom)
+    {
+        for (unsigned s=0; s<dimof(_stageBindings); ++s)
+            _stageBindings[s] = copyFrom._stageBindings[s];
+    }
+
+    BoundUniforms& BoundUniforms::operator=(const BoundUniforms& copyFrom)
+    {
+        for (unsigned s=0; s<dimof(_stageBindings); ++s)
+            _stageBindings[s] = copyFrom._stageBindings[s];
+        return *this;
+    }
+
+    BoundUniforms::BoundUniforms(BoundUniforms&& moveFrom) never_throws
+    {
+        for (unsigned s=0; s<dimof(_stageBindings); ++s)
+            _stageBindings[s] = std::move(moveFrom._stageBindings[s]);
+    }
+
+    BoundUniforms& BoundUniforms::operator=(BoundUniforms&& moveFrom) never_throws
+    {
+        for (unsigned s=0; s<dimof(_stageBindings); ++s)
+            _stageBindings[s] = std::move(moveFrom._stageBindings[s]);
+        return *this;
+    }
+    
+    BoundUniforms::StageBinding::StageBinding() : _hasShader(false) {}
+    BoundUniforms::StageBinding::~StageBinding() {}
+
+    BoundUniforms::StageBinding::StageBinding(StageBinding&& moveFrom)
+    :   _hasShader(moveFrom._hasShader)
+    ,   _shaderConstantBindings(std::move(moveFrom._shaderConstantBindings))
+    ,   _shaderResourceBindings(std::move(moveFrom._shaderResourceBindings))
+    {
+    }
+
+    BoundUniforms::StageBinding& BoundUniforms::StageBinding::operator=(BoundUniforms::StageBinding&& moveFrom)
+    {
+        _hasShader = moveFrom._hasShader;
+        _shaderConstantBindings = std::move(moveFrom._shaderConstantBindings);
+        _shaderResourceBindings = std::move(moveFrom._shaderResourceBindings);
+        return *this;
+    }
+
+	BoundUniforms::StageBinding::StageBinding(const StageBinding& copyFrom)
+	: _hasShader(copyFrom._hasShader)
+	, _shaderConstantBindings(copyFrom._shaderConstantBindings)
+	, _shaderResourceBindings(copyFrom._shaderResourceBindings)
+	{
+	}
+
+	BoundUniforms::StageBinding& BoundUniforms::StageBinding::operator=(const StageBinding& copyFrom)
+	{
+		_hasShader = copyFrom._hasShader;
+		_shaderConstantBindings = copyFrom._shaderConstantBindings;
+		_shaderResourceBindings = copyFrom._shaderResourceBindings;
+		return *this;
+	}
+
+    bool BoundUniforms::BindConstantBuffer( uint64 hashName, unsigned slot, unsigned stream,
+                                            const ConstantBufferLayoutElement elements[], size_t elementCount)
+    {
+        bool functionResult = false;
+        for (unsigned s=0; s<dimof(_stageBindings); ++s) {
+            auto& stage = _stageBindings[s];
+            if (!stage._hasShader) continue;
+
+            StageBinding::Binding newBinding;
+            newBinding._shaderSlot = unsigned(stage._shaderConstantBindings.size());
+            newBinding._inputInterfaceSlot = slot | (stream<<16);
+            stage._shaderConstantBindings.push_back(newBinding);
+            functionResult = true;
+        }
+        return functionResult;
+    }
+
+    bool BoundUniforms::BindShaderResource(uint64 hashName, unsigned slot, unsigned stream)
+    {
+        bool functionResult = false;
+        for (unsigned s=0; s<dimof(_stageBindings); ++s) {
+            auto& stage = _stageBindings[s];
+            if (!stage._hasShader) continue;
+
+            StageBinding::Binding newBinding;
+            newBinding._shaderSlot = unsigned(stage._shaderResourceBindings.size());
+            newBinding._inputInterfaceSlot = slot | (stream<<16);
+            stage._shaderResourceBindings.push_back(newBinding);
+            functionResult = true;
+        }
+        return functionResult;
+    }
+
+    bool BoundUniforms::BindConstantBuffers(unsigned uniformsStream, std::initializer_list<const char*> cbs)
+    {
+            // expecting this method to be called before any other BindConstantBuffers 
+            // operations for this uniformsStream (because we start from a zero index)
+        #if defined(_DEBUG)
+            for (unsigned c=0; c<ShaderStage::Max; ++c)
+                for (const auto& i:_stageBindings[c]._shaderConstantBindings)
+                    assert((i._inputInterfaceSlot>>16) != uniformsStream);
+        #endif
+
+        bool result = true;
+        for (auto c=cbs.begin(); c<cbs.end(); ++c)
+            result &= BindConstantBuffer(Hash64(*c), unsigned(c-cbs.begin()), uniformsStream);
+        return result;
+    }
+
+    bool BoundUniforms::BindConstantBuffers(unsigned uniformsStream, std::initializer_list<uint64> cbs)
+    {
+            // expecting this method to be called before any other BindConstantBuffers 
+            // operations for this uniformsStream (because we start from a zero index)
+        #if defined(_DEBUG)
+            for (unsigned c=0; c<ShaderStage::Max; ++c)
+                for (const auto& i:_stageBindings[c]._shaderConstantBindings)
+                    assert((i._inputInterfaceSlot>>16) != uniformsStream);
+        #endif
+
+        bool result = true;
+        for (auto c=cbs.begin(); c<cbs.end(); ++c)
+            result &= BindConstantBuffer(*c, unsigned(c-cbs.begin()), uniformsStream);
+        return result;
+    }
+
+    bool BoundUniforms::BindShaderResources(unsigned uniformsStream, std::initializer_list<const char*> res)
+    {
+        #if defined(_DEBUG)
+            for (unsigned c=0; c<ShaderStage::Max; ++c)
+                for (const auto& i:_stageBindings[c]._shaderResourceBindings)
+                    assert((i._inputInterfaceSlot>>16) != uniformsStream);
+        #endif
+
+        bool result = true;
+        for (auto c=res.begin(); c<res.end(); ++c)
+            result &= BindShaderResource(Hash64(*c), unsigned(c-res.begin()), uniformsStream);
+        return result;
+    }
+
+    bool BoundUniforms::BindShaderResources(unsigned uniformsStream, std::initializer_list<uint64> res)
+    {
+        #if defined(_DEBUG)
+            for (unsigned c=0; c<ShaderStage::Max; ++c)
+                for (const auto& i:_stageBindings[c]._shaderResourceBindings)
+                    assert((i._inputInterfaceSlot>>16) != uniformsStream);
+        #endif
+
+        bool result = true;
+        for (auto c=res.begin(); c<res.end(); ++c)
+            result &= BindShaderResource(*c, unsigned(c-res.begin()), uniformsStream);
+        return result;
+    }
+
+	void BoundUniforms::CopyReflection(const BoundUniforms& copyFrom)
+	{
+		for (unsigned c=0; c<ShaderStage::Max; ++c) {
+			_stageBindings[c]._shaderConstantBindings.clear();
+			_stageBindings[c]._shaderResourceBindings.clear();
+			_stageBindings[c]._hasShader = copyFrom._stageBindings[c]._hasShader;
+		}
+	}
+
+    unsigned CalculateVertexStride(
+        const InputElementDesc* start, const InputElementDesc* end,
+        unsigned slot)
+    {
+            // note --  Assuming vertex elements are densely packed (which
+            //          they usually are).
+            //          We could also use the "_alignedByteOffset" member
+            //          to find out where the element begins and ends)
+        unsigned result = 0;
+        for (auto i=start; i<end; ++i) {
+            if (i->_inputSlot == slot) {
+                assert(i->_alignedByteOffset == (result/8) || i->_alignedByteOffset == ~unsigned(0x0));
+                result += BitsPerPixel(i->_nativeFormat);
+            }
+        }
+        return result / 8;
+    }
+
+    ConstantBufferLayout::ConstantBufferLayout() { _size = 0; _elementCount = 0; }
+    ConstantBufferLayout::ConstantBufferLayout(ConstantBufferLayout&& moveFrom)
+    :   _elements(std::move(moveFrom._elements))
+    ,   _elementCount(moveFrom._elementCount)
+    ,   _size(moveFrom._size)
+    {}
+    ConstantBufferLayout& ConstantBufferLayout::operator=(ConstantBufferLayout&& moveFrom)
+    {
+        _elements = std::move(moveFrom._elements);
+        _elementCount = moveFrom._elementCount;
+        _size = moveFrom._size;
+        return *this;
+    }
+
+    ConstantBufferLayout BoundUniforms::GetConstantBufferLayout(const char name[])
+    {
+            //  Without reflection we don't know the layout of any constant buffer
+        return ConstantBufferLayout();
+    }
+
+    std::vector<std::pair<ShaderStage::Enum,unsigned>> BoundUniforms::GetConstantBufferBinding(const char name[])
+    {
+        return std::vector<std::pair<ShaderStage::Enum,unsigned>>();
+    }
+
+    void BoundUniforms::Apply(  DeviceContext& context, 
+                                const UniformsStream& stream0, 
+                                const UniformsStream& stream1) const
+    {
+            //  Record the same work the DX11 implementation would do: one upload
+            //  for every packet (each stage has its own constant buffer), and one
+            //  bind command per stage for the constant buffers and for the resources.
+        auto& log = context.GetCommandLog();
+        const UniformsStream* streams[] = { &stream0, &stream1 };
+
+        for (unsigned s=0; s<dimof(_stageBindings); ++s) {
+            const StageBinding& stage = _stageBindings[s];
+
+            unsigned cbCount = 0;
+            for (const auto& i:stage._shaderConstantBindings) {
+                unsigned slot = i._inputInterfaceSlot & 0xff;
+                unsigned streamIndex = i._inputInterfaceSlot >> 16;
+                if (streamIndex < dimof(streams) && slot < streams[streamIndex]->_packetCount) {
+                    auto& stream = *streams[streamIndex];
+                    if (stream._packets && stream._packets[slot]) {
+                        log.Push(CommandLog::Command::Upload, uint32(stream._packets[slot].size()));
+                        ++cbCount;
+                    } else if (stream._prebuiltBuffers && stream._prebuiltBuffers[slot]) {
+                        ++cbCount;
+                    }
+                }
+            }
+            if (cbCount)
+                log.Push(CommandLog::Command::BindConstants, cbCount);
+
+            unsigned srvCount = 0;
+            for (const auto& i:stage._shaderResourceBindings) {
+                unsigned slot = i._inputInterfaceSlot & 0xff;
+                unsigned streamIndex = i._inputInterfaceSlot >> 16;
+                if (streamIndex < dimof(streams) && slot < streams[streamIndex]->_resourceCount && streams[streamIndex]->_resources[slot])
+                    ++srvCount;
+            }
+            if (srvCount)
+                log.Push(CommandLog::Command::BindResources, srvCount);
+        }
+    }
+
+    void BoundUniforms::UnbindShaderResources(DeviceContext& context, unsigned streamIndex) const
+    {
+        for (unsigned s=0; s<dimof(_stageBindings); ++s)
+            for (const auto& b:_stageBindings[s]._shaderResourceBindings)
+                if ((b._inputInterfaceSlot >> 16)==streamIndex)
+                    context.GetCommandLog().Push(CommandLog::Command::Unbind, 1);
+    }
+
+    unsigned HasElement(const InputElementDesc* begin, const InputElementDesc* end, const char elementSemantic[])
+    {
+        unsigned result = 0;
+        for (auto i = begin; i != end; ++i) {
+            if (!XlCompareStringI(i->_semanticName.c_str(), elementSemantic)) {
+                assert((result & (1 << i->_semanticIndex)) == 0);
+                result |= (1 << i->_semanticIndex);
+            }
+        }
+        return result;
+    }
+
+    unsigned FindElement(const InputElementDesc* begin, const InputElementDesc* end, const char elementSemantic[], unsigned semanticIndex)
+    {
+        for (auto i = begin; i != end; ++i)
+            if (i->_semanticIndex == semanticIndex && !XlCompareStringI(i->_semanticName.c_str(), elementSemantic))
+                return unsigned(i - begin);
+        return ~0u;
+    }
+
+    void BoundClassInterfaces::Bind(uint64 hashName, unsigned bindingArrayIndex, const char instance[])
+    {
+            //  Dynamic linking is ignored on the null device; the class instance
+            //  makes no difference to the commands recorded
+    }
+
+    BoundClassInterfaces::BoundClassInterfaces(const ShaderProgram& shader) {}
+    BoundClassInterfaces::BoundClassInterfaces(const DeepShaderProgram& shader) {}
+    BoundClassInterfaces::BoundClassInterfaces() {}
+    BoundClassInterfaces::~BoundClassInterfaces() {}
+
+    BoundClassInterfaces::BoundClassInterfaces(BoundClassInterfaces&& moveFrom) {}
+    BoundClassInterfaces& BoundClassInterfaces::operator=(BoundClassInterfaces&& moveFrom) { return *this; }
+
+}}
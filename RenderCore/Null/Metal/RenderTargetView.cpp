@@ -0,0 +1,76 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "RenderTargetView.h"
+#include "DeviceContext.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+        //  Views on the null device just reference the resource they were
+        //  created from. The format and subresource arguments are ignored.
+
+    RenderTargetView::RenderTargetView(
+        UnderlyingResource resource,
+        NativeFormat::Enum format, const SubResourceSlice& arraySlice)
+    : _underlying(resource)
+    {}
+
+    RenderTargetView::RenderTargetView(DeviceContext& context)
+    : _underlying(context.GetBoundRenderTarget())
+    {}
+
+    RenderTargetView::RenderTargetView() {}
+
+    RenderTargetView::~RenderTargetView() {}
+
+    RenderTargetView::RenderTargetView(const RenderTargetView& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    RenderTargetView& RenderTargetView::operator=(const RenderTargetView& cloneFrom) { _underlying = cloneFrom._underlying; return *this; }
+
+    RenderTargetView::RenderTargetView(RenderTargetView&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    RenderTargetView& RenderTargetView::operator=(RenderTargetView&& moveFrom) never_throws { _underlying = std::move(moveFrom._underlying); return *this; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    DepthStencilView::DepthStencilView(
+        UnderlyingResource resource,
+        NativeFormat::Enum format, const SubResourceSlice& arraySlice)
+    : _underlying(resource)
+    {}
+
+    DepthStencilView::DepthStencilView(DeviceContext& context)
+    : _underlying(context.GetBoundDepthStencil())
+    {}
+
+    DepthStencilView::DepthStencilView() {}
+
+    DepthStencilView::~DepthStencilView() {}
+
+    DepthStencilView::DepthStencilView(const DepthStencilView& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    DepthStencilView& DepthStencilView::operator=(const DepthStencilView& cloneFrom) { _underlying = cloneFrom._underlying; return *this; }
+
+    DepthStencilView::DepthStencilView(DepthStencilView&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    DepthStencilView& DepthStencilView::operator=(DepthStencilView&& moveFrom) never_throws { _underlying = std::move(moveFrom._underlying); return *this; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    UnorderedAccessView::UnorderedAccessView(UnderlyingResource resource, NativeFormat::Enum format, unsigned mipSlice, bool appendBuffer, bool forceArray)
+    : _underlying(resource)
+    {}
+
+    UnorderedAccessView::UnorderedAccessView(UnderlyingResource resource, Flags::BitField field)
+    : _underlying(resource)
+    {}
+
+    UnorderedAccessView::UnorderedAccessView() {}
+    UnorderedAccessView::~UnorderedAccessView() {}
+
+    UnorderedAccessView::UnorderedAccessView(const UnorderedAccessView& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    UnorderedAccessView& UnorderedAccessView::operator=(const UnorderedAccessView& cloneFrom) { _underlying = cloneFrom._underlying; return *this; }
+
+    UnorderedAccessView::UnorderedAccessView(UnorderedAccessView&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    UnorderedAccessView& UnorderedAccessView::operator=(UnorderedAccessView&& moveFrom) never_throws { _underlying = std::move(moveFrom._underlying); return *this; }
+
+}}
@@ -0,0 +1,38 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Resource.h"
+#include "DeviceContext.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+    void Copy(DeviceContext& context, Underlying::Resource* dst, Underlying::Resource* src)
+    {
+        context.GetCommandLog().Push(CommandLog::Command::Upload, uint32(src ? src->_byteCount : 0));
+    }
+
+    void CopyPartial(
+        DeviceContext& context, 
+        const CopyPartial_Dest& dst, const CopyPartial_Src& src)
+    {
+            //  We don't know the pixel size of the resource here, so only
+            //  the number of copies is meaningful (not the byte count)
+        context.GetCommandLog().Push(CommandLog::Command::Upload, 0);
+    }
+
+    intrusive_ptr<Underlying::Resource> Duplicate(DeviceContext& context, Underlying::Resource* inputResource)
+    {
+        context.GetCommandLog().Push(CommandLog::Command::Upload, uint32(inputResource ? inputResource->_byteCount : 0));
+        return make_intrusive<Underlying::Resource>(inputResource ? inputResource->_byteCount : 0);
+    }
+
+    namespace Underlying
+    {
+        Resource::Resource(size_t byteCount) : _byteCount(byteCount) {}
+        Resource::~Resource() {}
+    }
+}}
+
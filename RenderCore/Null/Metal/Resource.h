@@ -0,0 +1,96 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../../../Core/Prefix.h"
+#include "../../../Utility/IntrusivePtr.h"
+#include "../../../Utility/Threading/ThreadingUtils.h"
+#include <type_traits>
+#include <iterator>
+#include <algorithm>
+
+namespace RenderCore { namespace Metal_Null
+{
+    namespace Underlying
+    {
+        /// <summary>Placeholder for a GPU resource on the null device</summary>
+        /// There is no memory behind a null resource. It just remembers how large
+        /// the resource would be, so that copies can be counted as uploads.
+        /// Higher level libraries (eg, BufferUploads) can derive from this to
+        /// attach their own description of the resource.
+        class Resource : public RefCountedObject
+        {
+        public:
+            size_t      _byteCount;
+
+            Resource(size_t byteCount = 0);
+            virtual ~Resource();
+        };
+    }
+
+    class DeviceContext;
+
+    void Copy(DeviceContext&, Underlying::Resource* dst, Underlying::Resource* src);
+
+    namespace Internal { static std::true_type UnsignedTest(unsigned); static std::false_type UnsignedTest(...); }
+
+    class PixelCoord
+    {
+    public:
+        unsigned _x, _y, _z;
+        PixelCoord(unsigned x=0, unsigned y=0, unsigned z=0)    { _x = x; _y = y; _z = z; }
+
+            // We can initialize from anything that looks like a collection of unsigned values
+            // (see the DX11 version of this class)
+		template<
+			typename Source,
+			typename InternalTestType = decltype(Internal::UnsignedTest(std::declval<typename Source::value_type>())),
+			std::enable_if<InternalTestType::value>* = nullptr>
+            PixelCoord(const Source& src)
+            {
+                auto size = std::size(src);
+                unsigned c=0;
+                for (; c<std::min(unsigned(size), 3u); ++c) ((unsigned*)this)[c] = src[c];
+                for (; c<3u; ++c) ((unsigned*)this)[c] = 0u;
+            }
+    };
+
+    class CopyPartial_Dest
+    {
+    public:
+        Underlying::Resource*   _resource;
+        unsigned                _subResource;
+        PixelCoord              _leftTopFront;
+
+        CopyPartial_Dest(
+            Underlying::Resource* dst, unsigned subres = 0u,
+            const PixelCoord leftTopFront = PixelCoord())
+        : _resource(dst), _subResource(subres), _leftTopFront(leftTopFront) {}
+    };
+
+    class CopyPartial_Src
+    {
+    public:
+        Underlying::Resource*   _resource;
+        unsigned                _subResource;
+        PixelCoord              _leftTopFront;
+        PixelCoord              _rightBottomBack;
+
+        CopyPartial_Src(
+            Underlying::Resource* dst, unsigned subres = 0u,
+            const PixelCoord leftTopFront = PixelCoord(~0u,0,0),
+            const PixelCoord rightBottomBack = PixelCoord(~0u,1,1))
+        : _resource(dst), _subResource(subres)
+        , _leftTopFront(leftTopFront)
+        , _rightBottomBack(rightBottomBack) {}
+    };
+
+    void CopyPartial(DeviceContext&, const CopyPartial_Dest& dst, const CopyPartial_Src& src);
+
+    intrusive_ptr<Underlying::Resource> Duplicate(DeviceContext& context, Underlying::Resource* inputResource);
+}}
+
@@ -0,0 +1,483 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Shader.h"
+#include "DeviceContext.h"
+#include "InputLayout.h"
+#include "../../RenderUtils.h"
+#include "../../../Assets/IntermediateAssets.h"
+#include "../../../Utility/StringUtils.h"
+#include "../../../Utility/StringFormat.h"
+#include "../../../Utility/MemoryUtils.h"
+#include "../../../Utility/PtrUtils.h"
+#include "../../../Core/Exceptions.h"
+#include <sstream>
+
+namespace RenderCore { namespace Metal_Null
+{
+    using ::Assets::ResChar;
+
+        //  Shaders on the null device are just a hash of the compiled byte code.
+        //  See NullShaderCompiler, below, for how that byte code is generated.
+
+    static uint64 HashByteCode(const CompiledShaderByteCode& compiledShader)
+    {
+        if (compiledShader.GetStage() == ShaderStage::Null) return 0;
+        auto byteCode = compiledShader.GetByteCode();
+        auto result = Hash64(byteCode.first, PtrAdd(byteCode.first, byteCode.second));
+        return result ? result : 1;
+    }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    VertexShader::VertexShader(const ResChar initializer[])
+    {
+            //
+            //      We have to append the shader model to the resource name
+            //      (if it's not already there)
+            //
+        ResChar temp[MaxPath];
+        if (!XlFindStringI(initializer, "vs_")) {
+            StringMeldInPlace(temp) << initializer << ":" VS_DefShaderModel;
+            initializer = temp;
+        }
+
+		const auto& compiledShader = ::Assets::GetAssetComp<CompiledShaderByteCode>(initializer);
+        assert(compiledShader.GetStage() == ShaderStage::Vertex);
+        _underlying = HashByteCode(compiledShader);
+    }
+
+    VertexShader::VertexShader(const CompiledShaderByteCode& compiledShader)
+    {
+        assert(compiledShader.GetStage() == ShaderStage::Null || compiledShader.GetStage() == ShaderStage::Vertex);
+        _underlying = HashByteCode(compiledShader);
+    }
+
+    VertexShader::VertexShader() : _underlying(0) {}
+    
+    VertexShader::~VertexShader() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    PixelShader::PixelShader(const ResChar initializer[])
+    {
+            //
+            //      We have to append the shader model to the resource name
+            //      (if it's not already there)
+            //
+        ResChar temp[MaxPath];
+        if (!XlFindStringI(initializer, "ps_")) {
+            StringMeldInPlace(temp) << initializer << ":" PS_DefShaderModel;
+            initializer = temp;
+        }
+
+        const auto& compiledShader = ::Assets::GetAssetComp<CompiledShaderByteCode>(initializer);
+        assert(compiledShader.GetStage() == ShaderStage::Pixel);
+        _underlying = HashByteCode(compiledShader);
+    }
+
+    PixelShader::PixelShader(const CompiledShaderByteCode& compiledShader)
+    {
+        assert(compiledShader.GetStage() == ShaderStage::Null || compiledShader.GetStage() == ShaderStage::Pixel);
+        _underlying = HashByteCode(compiledShader);
+    }
+
+    PixelShader::PixelShader() : _underlying(0) {}
+    PixelShader::~PixelShader() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+        //  Stream output declarations have no effect on the null device
+
+    GeometryShader::GeometryShader( const ResChar initializer[],
+                                    const StreamOutputInitializers& soInitializers)
+    {
+            //
+            //      We have to append the shader model to the resource name
+            //      (if it's not already there)
+            //
+        ResChar temp[MaxPath];
+        if (!XlFindStringI(initializer, "gs_")) {
+            StringMeldInPlace(temp) << initializer << ":" GS_DefShaderModel;
+            initializer = temp;
+        }
+
+		const auto& compiledShader = ::Assets::GetAssetComp<CompiledShaderByteCode>(initializer);
+        assert(compiledShader.GetStage() == ShaderStage::Geometry);
+        _underlying = HashByteCode(compiledShader);
+    }
+
+    GeometryShader::GeometryShader(const CompiledShaderByteCode& compiledShader, const StreamOutputInitializers& soInitializers)
+    {
+        assert(compiledShader.GetStage() == ShaderStage::Null || compiledShader.GetStage() == ShaderStage::Geometry);
+        _underlying = HashByteCode(compiledShader);
+    }
+
+    GeometryShader::GeometryShader(GeometryShader&& moveFrom)
+    {
+        _underlying = moveFrom._underlying;
+        moveFrom._underlying = 0;
+    }
+    
+    GeometryShader& GeometryShader::operator=(GeometryShader&& moveFrom)
+    {
+        _underlying = moveFrom._underlying;
+        moveFrom._underlying = 0;
+        return *this;
+    }
+
+    GeometryShader::GeometryShader() : _underlying(0) {}
+    GeometryShader::~GeometryShader() {}
+
+    GeometryShader::StreamOutputInitializers GeometryShader::_hackInitializers;
+
+    void GeometryShader::SetDefaultStreamOutputInitializers(const StreamOutputInitializers& initializers)
+    {
+        _hackInitializers = initializers;
+    }
+
+    auto GeometryShader::GetDefaultStreamOutputInitializers() -> const StreamOutputInitializers&
+    {
+        return _hackInitializers;
+    }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ComputeShader::ComputeShader(const ResChar initializer[], const ResChar definesTable[])
+    {
+        ResChar temp[MaxPath];
+        if (!XlFindStringI(initializer, "cs_")) {
+            StringMeldInPlace(temp) << initializer << ":" CS_DefShaderModel;
+            initializer = temp;
+        }
+
+        const auto& compiledShader = ::Assets::GetAssetComp<CompiledShaderByteCode>(initializer, definesTable?definesTable:"");
+        assert(compiledShader.GetStage() == ShaderStage::Compute);
+        _underlying = HashByteCode(compiledShader);
+
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, compiledShader.GetDependencyValidation());
+    }
+
+    ComputeShader::ComputeShader(const CompiledShaderByteCode& compiledShader)
+    {
+        assert(compiledShader.GetStage() == ShaderStage::Null || compiledShader.GetStage() == ShaderStage::Compute);
+        _underlying = HashByteCode(compiledShader);
+
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, compiledShader.GetDependencyValidation());
+    }
+
+    ComputeShader::~ComputeShader() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    DomainShader::DomainShader(const ResChar initializer[], const ResChar definesTable[])
+    {
+        ResChar temp[MaxPath];
+        if (!XlFindStringI(initializer, "ds_")) {
+            StringMeldInPlace(temp) << initializer << ":" DS_DefShaderModel;
+            initializer = temp;
+        }
+
+		const auto& compiledShader = ::Assets::GetAssetComp<CompiledShaderByteCode>(initializer, definesTable?definesTable:"");
+        assert(compiledShader.GetStage() == ShaderStage::Domain);
+        _underlying = HashByteCode(compiledShader);
+
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, compiledShader.GetDependencyValidation());
+    }
+
+    DomainShader::DomainShader(const CompiledShaderByteCode& compiledShader)
+    {
+        assert(compiledShader.GetStage() == ShaderStage::Null || compiledShader.GetStage() == ShaderStage::Domain);
+        _underlying = HashByteCode(compiledShader);
+
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, compiledShader.GetDependencyValidation());
+    }
+
+    DomainShader::~DomainShader() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    HullShader::HullShader(const ResChar initializer[], const ResChar definesTable[])
+    {
+        ResChar temp[MaxPath];
+        if (!XlFindStringI(initializer, "hs_")) {
+            StringMeldInPlace(temp) << initializer << ":" HS_DefShaderModel;
+            initializer = temp;
+        }
+
+		const auto& compiledShader = ::Assets::GetAssetComp<CompiledShaderByteCode>(initializer, definesTable?definesTable:"");
+        assert(compiledShader.GetStage() == ShaderStage::Hull);
+        _underlying = HashByteCode(compiledShader);
+
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, compiledShader.GetDependencyValidation());
+    }
+
+    HullShader::HullShader(const CompiledShaderByteCode& compiledShader)
+    {
+        assert(compiledShader.GetStage() == ShaderStage::Null || compiledShader.GetStage() == ShaderStage::Hull);
+        _underlying = HashByteCode(compiledShader);
+
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, compiledShader.GetDependencyValidation());
+    }
+
+    HullShader::~HullShader() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ShaderProgram::ShaderProgram(   const ResChar vertexShaderInitializer[], 
+                                    const ResChar fragmentShaderInitializer[])
+    :   _compiledVertexShader(&::Assets::GetAssetComp<CompiledShaderByteCode>(vertexShaderInitializer)) // (odd..?)
+    ,   _compiledPixelShader(&::Assets::GetAssetComp<CompiledShaderByteCode>(fragmentShaderInitializer)) // (odd..?)
+    ,   _vertexShader(*_compiledVertexShader)
+    ,   _pixelShader(*_compiledPixelShader)
+    ,   _compiledGeometryShader(nullptr)
+    {
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, _compiledVertexShader->GetDependencyValidation());
+        Assets::RegisterAssetDependency(_validationCallback, _compiledPixelShader->GetDependencyValidation());
+    }
+    
+    ShaderProgram::ShaderProgram(   const ResChar vertexShaderInitializer[], 
+                                    const ResChar fragmentShaderInitializer[],
+                                    const ResChar definesTable[])
+    :   _compiledVertexShader(&::Assets::GetAssetComp<CompiledShaderByteCode>(vertexShaderInitializer, definesTable)) // (odd..?)
+    ,   _compiledPixelShader(&::Assets::GetAssetComp<CompiledShaderByteCode>(fragmentShaderInitializer, definesTable)) // (odd..?)
+    ,   _vertexShader(*_compiledVertexShader)
+    ,   _pixelShader(*_compiledPixelShader)
+    ,   _compiledGeometryShader(nullptr)
+    {
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, _compiledVertexShader->GetDependencyValidation());
+        Assets::RegisterAssetDependency(_validationCallback, _compiledPixelShader->GetDependencyValidation());
+    }
+
+    ShaderProgram::ShaderProgram(   const ResChar vertexShaderInitializer[], 
+                                    const ResChar geometryShaderInitializer[],
+                                    const ResChar fragmentShaderInitializer[],
+                                    const ResChar definesTable[])
+    :   _compiledVertexShader(&::Assets::GetAssetComp<CompiledShaderByteCode>(vertexShaderInitializer, definesTable)) // (odd..?)
+    ,   _compiledPixelShader(&::Assets::GetAssetComp<CompiledShaderByteCode>(fragmentShaderInitializer, definesTable)) // (odd..?)
+    ,   _vertexShader(*_compiledVertexShader)
+    ,   _pixelShader(*_compiledPixelShader)
+    ,   _compiledGeometryShader(nullptr)
+    {
+        if (geometryShaderInitializer && geometryShaderInitializer[0]) {
+            _compiledGeometryShader = &::Assets::GetAssetComp<CompiledShaderByteCode>(geometryShaderInitializer, definesTable);
+            _geometryShader = GeometryShader(*_compiledGeometryShader);
+        }
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, _compiledVertexShader->GetDependencyValidation());
+        Assets::RegisterAssetDependency(_validationCallback, _compiledPixelShader->GetDependencyValidation());
+        if (_compiledGeometryShader) {
+            Assets::RegisterAssetDependency(_validationCallback, _compiledGeometryShader->GetDependencyValidation());
+        }
+    }
+
+    ShaderProgram::ShaderProgram(   const CompiledShaderByteCode& compiledVertexShader, 
+                                    const CompiledShaderByteCode& compiledFragmentShader)
+    :   _compiledVertexShader(&compiledVertexShader)
+    ,   _compiledPixelShader(&compiledFragmentShader)
+    ,   _compiledGeometryShader(nullptr)
+    {
+            //  make sure both the vertex shader and the pixel shader
+            //  have completed compiling. If one completes early, we don't
+            //  want to create the vertex shader object, and then just delete it.
+        compiledVertexShader.GetByteCode();
+        compiledFragmentShader.GetByteCode();
+
+        auto vertexShader = VertexShader(compiledVertexShader);
+        auto pixelShader = PixelShader(compiledFragmentShader);
+
+        _vertexShader = std::move(vertexShader);
+        _pixelShader = std::move(pixelShader);
+        _validationCallback = std::make_shared<Assets::DependencyValidation>();
+        Assets::RegisterAssetDependency(_validationCallback, _compiledVertexShader->GetDependencyValidation());
+        Assets::RegisterAssetDependency(_validationCallback, _compiledPixelShader->GetDependencyValidation());
+    }
+
+	ShaderProgram::ShaderProgram()
+	{
+		_compiledVertexShader = nullptr;
+		_compiledPixelShader = nullptr;
+		_compiledGeometryShader = nullptr;
+	}
+    ShaderProgram::~ShaderProgram() {}
+
+    bool ShaderProgram::DynamicLinkingEnabled() const
+    {
+        return _compiledVertexShader->DynamicLinkingEnabled() || _compiledPixelShader->DynamicLinkingEnabled();
+    }
+
+	ShaderProgram::ShaderProgram(ShaderProgram&& moveFrom) never_throws
+	: _compiledVertexShader(moveFrom._compiledVertexShader)
+	, _compiledPixelShader(moveFrom._compiledPixelShader)
+	, _compiledGeometryShader(moveFrom._compiledGeometryShader)
+	, _vertexShader(std::move(moveFrom._vertexShader))
+	, _pixelShader(std::move(moveFrom._pixelShader))
+	, _geometryShader(std::move(moveFrom._geometryShader))
+	, _validationCallback(std::move(moveFrom._validationCallback))
+	{
+		moveFrom._compiledVertexShader = nullptr;
+		moveFrom._compiledPixelShader = nullptr;
+		moveFrom._compiledGeometryShader = nullptr;
+	}
+
+    ShaderProgram& ShaderProgram::operator=(ShaderProgram&& moveFrom) never_throws
+	{
+		_compiledVertexShader = moveFrom._compiledVertexShader;
+		_compiledPixelShader = moveFrom._compiledPixelShader;
+		_compiledGeometryShader = moveFrom._compiledGeometryShader;
+		moveFrom._compiledVertexShader = nullptr;
+		moveFrom._compiledPixelShader = nullptr;
+		moveFrom._compiledGeometryShader = nullptr;
+
+		_vertexShader = std::move(moveFrom._vertexShader);
+		_pixelShader = std::move(moveFrom._pixelShader);
+		_geometryShader = std::move(moveFrom._geometryShader);
+		_validationCallback = std::move(moveFrom._validationCallback);
+		return *this;
+	}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    DeepShaderProgram::DeepShaderProgram(  
+        const ResChar vertexShaderInitializer[], 
+        const ResChar geometryShaderInitializer[],
+        const ResChar fragmentShaderInitializer[],
+        const ResChar hullShaderInitializer[],
+        const ResChar domainShaderInitializer[],
+        const ResChar definesTable[])
+    :   ShaderProgram(vertexShaderInitializer, geometryShaderInitializer, fragmentShaderInitializer, definesTable)
+    ,   _compiledHullShader(::Assets::GetAssetComp<CompiledShaderByteCode>(hullShaderInitializer, definesTable))
+    ,   _compiledDomainShader(::Assets::GetAssetComp<CompiledShaderByteCode>(domainShaderInitializer, definesTable))
+    ,   _hullShader(_compiledHullShader)
+    ,   _domainShader(_compiledDomainShader)
+    {
+        Assets::RegisterAssetDependency(_validationCallback, _compiledHullShader.GetDependencyValidation());
+        Assets::RegisterAssetDependency(_validationCallback, _compiledDomainShader.GetDependencyValidation());
+    }
+
+    DeepShaderProgram::~DeepShaderProgram() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /// <summary>Low level shader compiler for the null device</summary>
+    /// This doesn't invoke any real shader compiler. The "byte code" it generates
+    /// is just a hash of the source code, entry point, shader model and defines.
+    /// So it's deterministic, and different shaders get different byte code (and
+    /// therefore different Metal shader objects).
+    ///
+    /// Note that #include directives aren't followed, so only the top level
+    /// shader file is registered as a dependency.
+    class NullShaderCompiler : public ShaderService::ILowLevelCompiler
+    {
+    public:
+        virtual void AdaptShaderModel(
+            ResChar destination[], 
+            const size_t destinationCount,
+            const ResChar source[]) const;
+
+        virtual bool DoLowLevelCompile(
+            /*out*/ Payload& payload,
+            /*out*/ Payload& errors,
+            /*out*/ std::vector<::Assets::DependentFileState>& dependencies,
+            const void* sourceCode, size_t sourceCodeLength,
+            const ShaderService::ResId& shaderPath,
+            const ::Assets::ResChar definesTable[]) const;
+
+        virtual std::string MakeShaderMetricsString(
+            const void* byteCode, size_t byteCodeSize) const;
+
+        NullShaderCompiler();
+        ~NullShaderCompiler();
+
+    protected:
+        static std::weak_ptr<NullShaderCompiler> s_instance;
+        friend std::shared_ptr<ShaderService::ILowLevelCompiler> CreateLowLevelShaderCompiler();
+    };
+
+    void NullShaderCompiler::AdaptShaderModel(
+        ResChar destination[], 
+        const size_t destinationCount,
+        const ResChar inputShaderModel[]) const
+    {
+        assert(inputShaderModel);
+        if (destination != inputShaderModel) 
+            XlCopyString(destination, destinationCount, inputShaderModel);
+
+            //  Use the same shader model as a feature level 11 DX11 device,
+            //  so the shader defines match what the DX11 build would see
+        size_t length = XlStringLen(destination);
+        if (length != 0 && destination[length-1] == '*') {
+            destination[length-1] = '\0';
+            XlCatString(destination, destinationCount, "5_0");
+        }
+    }
+
+    bool NullShaderCompiler::DoLowLevelCompile(
+        /*out*/ Payload& payload,
+        /*out*/ Payload& errors,
+        /*out*/ std::vector<::Assets::DependentFileState>& dependencies,
+        const void* sourceCode, size_t sourceCodeLength,
+        const ShaderService::ResId& shaderPath,
+        const ::Assets::ResChar definesTable[]) const
+    {
+        ResChar shaderModel[64];
+        AdaptShaderModel(shaderModel, dimof(shaderModel), shaderPath._shaderModel);
+
+        auto hash = Hash64(sourceCode, PtrAdd(sourceCode, sourceCodeLength));
+        hash = Hash64(shaderPath._entryPoint, XlStringEnd(shaderPath._entryPoint), hash);
+        hash = Hash64(shaderModel, XlStringEnd(shaderModel), hash);
+        if (definesTable)
+            hash = Hash64(definesTable, XlStringEnd(definesTable), hash);
+
+        payload = std::make_shared<std::vector<uint8>>(sizeof(ShaderService::ShaderHeader) + sizeof(hash));
+        auto* hdr = (ShaderService::ShaderHeader*)AsPointer(payload->begin());
+        hdr->_version = ShaderService::ShaderHeader::Version;
+        hdr->_dynamicLinkageEnabled = shaderPath._dynamicLinkageEnabled;
+        XlCopyMemory(PtrAdd(AsPointer(payload->begin()), sizeof(ShaderService::ShaderHeader)), &hash, sizeof(hash));
+        errors.reset();
+
+        if (shaderPath._filename[0])
+            dependencies.push_back(
+                ::Assets::IntermediateAssets::Store::GetDependentFileState(shaderPath._filename));
+        return true;
+    }
+
+    std::string NullShaderCompiler::MakeShaderMetricsString(const void* data, size_t dataSize) const
+    {
+        auto* hdr = (ShaderService::ShaderHeader*)data;
+		if (dataSize <= sizeof(ShaderService::ShaderHeader)
+			|| hdr->_version != ShaderService::ShaderHeader::Version) 
+			return "<Shader header corrupted, or wrong version>";
+
+        std::stringstream str;
+        str << "Null device shader (" << (dataSize - sizeof(ShaderService::ShaderHeader)) << " bytes)";
+        return str.str();
+    }
+
+    std::weak_ptr<NullShaderCompiler> NullShaderCompiler::s_instance;
+
+    NullShaderCompiler::NullShaderCompiler() {}
+    NullShaderCompiler::~NullShaderCompiler() {}
+
+    std::shared_ptr<ShaderService::ILowLevelCompiler> CreateLowLevelShaderCompiler()
+    {
+        auto result = NullShaderCompiler::s_instance.lock();
+        if (result) return std::move(result);
+
+        result = std::make_shared<NullShaderCompiler>();
+        NullShaderCompiler::s_instance = result;
+        return std::move(result);
+    }
+}}
+
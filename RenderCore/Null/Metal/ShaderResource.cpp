@@ -0,0 +1,42 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "ShaderResource.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+        //  Views on the null device just reference the resource they were
+        //  created from. The format and subresource arguments are ignored.
+
+    ShaderResourceView::ShaderResourceView(UnderlyingResource resource, NativeFormat::Enum format, int arrayCount, bool forceSingleSample)
+    : _underlying(resource)
+    {}
+
+    ShaderResourceView::ShaderResourceView(UnderlyingResource resource, NativeFormat::Enum format, const MipSlice& mipSlice)
+    : _underlying(resource)
+    {}
+
+    ShaderResourceView ShaderResourceView::RawBuffer(UnderlyingResource res, unsigned sizeBytes, unsigned offsetBytes)
+    {
+        return ShaderResourceView(res);
+    }
+
+    auto ShaderResourceView::GetResource() const -> intrusive_ptr<Underlying::Resource>
+    {
+        return _underlying;
+    }
+
+    ShaderResourceView::ShaderResourceView() {}
+
+    ShaderResourceView::~ShaderResourceView() {}
+
+    ShaderResourceView::ShaderResourceView(const ShaderResourceView& cloneFrom) : _underlying(cloneFrom._underlying) {}
+    ShaderResourceView& ShaderResourceView::operator=(const ShaderResourceView& cloneFrom) { _underlying = cloneFrom._underlying; return *this; }
+
+    ShaderResourceView::ShaderResourceView(ShaderResourceView&& moveFrom) never_throws : _underlying(std::move(moveFrom._underlying)) {}
+    ShaderResourceView& ShaderResourceView::operator=(ShaderResourceView&& moveFrom) never_throws { _underlying = std::move(moveFrom._underlying); return *this; }
+
+}}
@@ -0,0 +1,52 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "Resource.h"
+#include "Format.h"
+#include "../../../Utility/IntrusivePtr.h"
+
+namespace RenderCore { namespace Metal_Null
+{
+    class MipSlice
+    {
+    public:
+        unsigned _mostDetailedMip;
+        unsigned _mipLevels;
+        MipSlice(unsigned mostDetailedMip = 0, unsigned mipLevels = 1) : _mostDetailedMip(mostDetailedMip), _mipLevels(mipLevels) {}
+    };
+
+    class ShaderResourceView
+    {
+    public:
+        typedef Underlying::Resource* UnderlyingResource;
+        explicit ShaderResourceView(UnderlyingResource resource, NativeFormat::Enum format = NativeFormat::Unknown, int arrayCount=0, bool forceSingleSample=false);
+        explicit ShaderResourceView(UnderlyingResource resource, NativeFormat::Enum format, const MipSlice& mipSlice);
+        ShaderResourceView();
+        ~ShaderResourceView();
+
+        ShaderResourceView(const ShaderResourceView& cloneFrom);
+        ShaderResourceView(ShaderResourceView&& moveFrom) never_throws;
+        ShaderResourceView& operator=(const ShaderResourceView& cloneFrom);
+        ShaderResourceView& operator=(ShaderResourceView&& moveFrom) never_throws;
+
+        static ShaderResourceView RawBuffer(UnderlyingResource res, unsigned sizeBytes, unsigned offsetBytes = 0);
+
+        intrusive_ptr<Underlying::Resource>     GetResource() const;
+        
+        typedef Underlying::Resource*           UnderlyingType;
+        UnderlyingType                          GetUnderlying() const { return _underlying.get(); }
+        bool                                    IsGood() const { return _underlying.get() != nullptr; }
+    private:
+        intrusive_ptr<Underlying::Resource>     _underlying;
+    };
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    
+}}
+
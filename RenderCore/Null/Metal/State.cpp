@@ -0,0 +1,145 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "State.h"
+#include "DeviceContext.h"
+#include "../../../Utility/MemoryUtils.h"
+#include <initializer_list>
+
+namespace RenderCore { namespace Metal_Null
+{
+        //  State objects on the null device are just a hash of their description.
+        //  So identical descriptions compare equal (like the D3D11 state object
+        //  cache), and creating a state object never allocates.
+        //  Zero is reserved for the "Null()" states.
+
+    namespace StateType { enum Enum { Sampler = 1, Rasterizer, Blend, DepthStencil }; }
+
+    static uint64 HashStateDesc(StateType::Enum type, std::initializer_list<unsigned> values)
+    {
+        auto result = Hash64(values.begin(), values.end(), DefaultSeed64 + type);
+        return result ? result : 1;
+    }
+
+    static unsigned AsBits(float value) { unsigned result; XlCopyMemory(&result, &value, sizeof(result)); return result; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    SamplerState::SamplerState( FilterMode::Enum filter,
+                                AddressMode::Enum addressU, AddressMode::Enum addressV, AddressMode::Enum addressW,
+                                Comparison::Enum comparison)
+    {
+        _underlying = HashStateDesc(StateType::Sampler, {unsigned(filter), unsigned(addressU), unsigned(addressV), unsigned(addressW), unsigned(comparison)});
+    }
+
+    SamplerState::~SamplerState() {}
+
+    SamplerState::SamplerState(SamplerState&& moveFrom) : _underlying(moveFrom._underlying) { moveFrom._underlying = 0; }
+    SamplerState& SamplerState::operator=(SamplerState&& moveFrom) { _underlying = moveFrom._underlying; moveFrom._underlying = 0; return *this; }
+    SamplerState::SamplerState(const SamplerState& copyFrom) : _underlying(copyFrom._underlying) {}
+    SamplerState& SamplerState::operator=(const SamplerState& copyFrom) { _underlying = copyFrom._underlying; return *this; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    RasterizerState::RasterizerState(CullMode::Enum cullmode, bool frontCounterClockwise)
+    : RasterizerState(cullmode, frontCounterClockwise, FillMode::Solid, 0, 0.f, 0.f)
+    {}
+
+    RasterizerState::RasterizerState(
+        CullMode::Enum cullmode, bool frontCounterClockwise,
+        FillMode::Enum fillmode,
+        int depthBias, float depthBiasClamp, float slopeScaledBias)
+    {
+        _underlying = HashStateDesc(StateType::Rasterizer, {
+            unsigned(cullmode), unsigned(frontCounterClockwise), unsigned(fillmode),
+            unsigned(depthBias), AsBits(depthBiasClamp), AsBits(slopeScaledBias)});
+    }
+
+    RasterizerState::RasterizerState(uint64 underlying) : _underlying(underlying) {}
+    RasterizerState::RasterizerState(DeviceContext& context) : _underlying(context.GetBoundRasterizerState()) {}
+    RasterizerState::~RasterizerState() {}
+
+    RasterizerState::RasterizerState(RasterizerState&& moveFrom) : _underlying(moveFrom._underlying) { moveFrom._underlying = 0; }
+    RasterizerState& RasterizerState::operator=(RasterizerState&& moveFrom) { _underlying = moveFrom._underlying; moveFrom._underlying = 0; return *this; }
+    RasterizerState::RasterizerState(const RasterizerState& copyFrom) : _underlying(copyFrom._underlying) {}
+    RasterizerState& RasterizerState::operator=(const RasterizerState& copyFrom) { _underlying = copyFrom._underlying; return *this; }
+
+    RasterizerState RasterizerState::Null() { return RasterizerState(uint64(0)); }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    BlendState::BlendState( BlendOp::Enum blendingOperation, 
+                            Blend::Enum srcBlend,
+                            Blend::Enum dstBlend)
+    : BlendState(blendingOperation, srcBlend, dstBlend, BlendOp::Add, Blend::One, Blend::Zero)
+    {}
+
+    BlendState::BlendState( BlendOp::Enum blendingOperation, 
+                            Blend::Enum srcBlend,
+                            Blend::Enum dstBlend,
+                            BlendOp::Enum alphaBlendingOperation, 
+                            Blend::Enum alphaSrcBlend,
+                            Blend::Enum alphaDstBlend)
+    {
+        _underlying = HashStateDesc(StateType::Blend, {
+            unsigned(blendingOperation), unsigned(srcBlend), unsigned(dstBlend),
+            unsigned(alphaBlendingOperation), unsigned(alphaSrcBlend), unsigned(alphaDstBlend),
+            1u});   // (render target write mask enabled)
+    }
+
+    BlendState BlendState::OutputDisabled()
+    {
+        return BlendState(HashStateDesc(StateType::Blend, {0u, 0u, 0u, 0u, 0u, 0u, 0u}));
+    }
+
+    BlendState BlendState::Null() { return BlendState(uint64(0)); }
+
+    BlendState::BlendState(uint64 underlying) : _underlying(underlying) {}
+    BlendState::BlendState(DeviceContext& context) : _underlying(context.GetBoundBlendState()) {}
+    BlendState::~BlendState() {}
+
+    BlendState::BlendState(BlendState&& moveFrom) : _underlying(moveFrom._underlying) { moveFrom._underlying = 0; }
+    BlendState& BlendState::operator=(BlendState&& moveFrom) { _underlying = moveFrom._underlying; moveFrom._underlying = 0; return *this; }
+    BlendState::BlendState(const BlendState& copyFrom) : _underlying(copyFrom._underlying) {}
+    BlendState& BlendState::operator=(const BlendState& copyFrom) { _underlying = copyFrom._underlying; return *this; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    StencilMode StencilMode::NoEffect(Comparison::Always, StencilOp::DontWrite, StencilOp::DontWrite, StencilOp::DontWrite);
+    StencilMode StencilMode::AlwaysWrite(Comparison::Always, StencilOp::Replace, StencilOp::DontWrite, StencilOp::DontWrite);
+
+    DepthStencilState::DepthStencilState(bool enabled, bool writeEnabled, Comparison::Enum comparison)
+    {
+        _underlying = HashStateDesc(StateType::DepthStencil, {
+            unsigned(enabled), unsigned(enabled&&writeEnabled), unsigned(comparison), 0u});
+    }
+
+    DepthStencilState::DepthStencilState(
+        bool depthTestEnabled, bool writeEnabled,
+        unsigned stencilReadMask, unsigned stencilWriteMask,
+        const StencilMode& frontFaceStencil,
+        const StencilMode& backFaceStencil)
+    {
+        _underlying = HashStateDesc(StateType::DepthStencil, {
+            unsigned(depthTestEnabled), unsigned(depthTestEnabled&&writeEnabled), unsigned(Comparison::LessEqual), 1u,
+            stencilReadMask, stencilWriteMask,
+            unsigned(frontFaceStencil._comparison), unsigned(frontFaceStencil._onPass), unsigned(frontFaceStencil._onDepthFail), unsigned(frontFaceStencil._onStencilFail),
+            unsigned(backFaceStencil._comparison), unsigned(backFaceStencil._onPass), unsigned(backFaceStencil._onDepthFail), unsigned(backFaceStencil._onStencilFail)});
+    }
+
+    DepthStencilState::DepthStencilState(DeviceContext& context) : _underlying(context.GetBoundDepthStencilState()) {}
+    DepthStencilState::DepthStencilState(DepthStencilState&& moveFrom) : _underlying(moveFrom._underlying) { moveFrom._underlying = 0; }
+    DepthStencilState& DepthStencilState::operator=(DepthStencilState&& moveFrom) { _underlying = moveFrom._underlying; moveFrom._underlying = 0; return *this; }
+    DepthStencilState::~DepthStencilState() {}
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    ViewportDesc::ViewportDesc(const DeviceContext& context)
+    {
+        *this = context.GetBoundViewport();
+    }
+
+}}
@@ -0,0 +1,15 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+namespace RenderCore { namespace Metal_Null
+{
+        //  Nothing is ever executed on the null device, so queries are
+        //  just sequence numbers that are considered complete immediately
+    typedef unsigned            UnderlyingQuery;
+}}
+
@@ -38,6 +38,18 @@ namespace RenderCore { namespace Techniques
             ) != end;
     }
 
+    static Metal::NativeFormat::Enum FindElementFormat(const Metal::InputLayout& inputLayout, const char elementSemantic[])
+    {
+        auto end = &inputLayout.first[inputLayout.second];
+        auto i = std::find_if
+            (
+                inputLayout.first, end,
+                [=](const Metal::InputElementDesc& element)
+                    { return !XlCompareStringI(element._semanticName.c_str(), elementSemantic); }
+            );
+        return (i != end) ? i->_nativeFormat : Metal::NativeFormat::Unknown;
+    }
+
     ParameterBox TechParams_SetGeo(const Metal::InputLayout& inputLayout)
     {
         ParameterBox result;
@@ -46,6 +58,12 @@ namespace RenderCore { namespace Techniques
         if (HasElement(inputLayout, "TEXTANGENT"))      result.SetParameter((const utf8*)"GEO_HAS_TANGENT_FRAME", 1);
         if (HasElement(inputLayout, "TEXBITANGENT"))    result.SetParameter((const utf8*)"GEO_HAS_BITANGENT", 1);
         if (HasElement(inputLayout, "COLOR"))           result.SetParameter((const utf8*)"GEO_HAS_COLOUR", 1);
+
+            // octahedral encoded unit vectors & remapped texture coordinates (from vertex quantization)
+        if (FindElementFormat(inputLayout, "NORMAL") == Metal::NativeFormat::R16G16_SNORM)         result.SetParameter((const utf8*)"GEO_V_NORMAL_OCTAHEDRAL", 1);
+        if (FindElementFormat(inputLayout, "TEXTANGENT") == Metal::NativeFormat::R16G16_SNORM)     result.SetParameter((const utf8*)"GEO_V_TANGENT_OCTAHEDRAL", 1);
+        if (FindElementFormat(inputLayout, "TEXBITANGENT") == Metal::NativeFormat::R16G16_SNORM)   result.SetParameter((const utf8*)"GEO_V_BITANGENT_OCTAHEDRAL", 1);
+        if (FindElementFormat(inputLayout, "TEXCOORD") == Metal::NativeFormat::R16G16_UNORM)       result.SetParameter((const utf8*)"GEO_V_TEXCOORD_SCALEOFFSET", 1);
         return std::move(result);
     }
 
@@ -45,7 +45,8 @@ namespace RenderCore { namespace Techniques
     ClipSpaceType::Enum GetDefaultClipSpaceType()
     {
             // (todo -- this condition could be a runtime test)
-        #if (GFXAPI_ACTIVE == GFXAPI_DX11) || (GFXAPI_ACTIVE == GFXAPI_DX9)         
+            //  (the null device matches DX11, so CPU side culling behaves the same)
+        #if (GFXAPI_ACTIVE == GFXAPI_DX11) || (GFXAPI_ACTIVE == GFXAPI_DX9) || (GFXAPI_ACTIVE == GFXAPI_NULL)
             return ClipSpaceType::Positive;
         #else
             return ClipSpaceType::StraddlingZero;
@@ -153,9 +154,12 @@ namespace RenderCore { namespace Techniques
     {
         LocalTransformConstants localTransform;
         CopyTransform(localTransform._localToWorld, localToWorld);
-        auto worldToLocal = InvertOrthonormalTransform(localToWorld);
+            //  We can't use "InvertOrthonormalTransform" here, because there can be scales on
+            //  the matrix (from placements, or from the dequantization of vertex positions)
+        auto worldToLocal = Inverse(localToWorld);
         localTransform._localSpaceView = TransformPoint(worldToLocal, worldSpaceCameraPosition);
         localTransform._materialGuid = ~0x0ull;
+        localTransform._texCoordScaleOffset = Float4(1.f, 1.f, 0.f, 0.f);
         return localTransform;
     }
 
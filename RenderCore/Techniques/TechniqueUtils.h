@@ -66,6 +66,7 @@ namespace RenderCore { namespace Techniques
         unsigned    _dummy0;
         uint64      _materialGuid;
         unsigned    _dummy1[2];
+        Float4      _texCoordScaleOffset;   // (for quantized texture coordinates; "xy * texCoord + zw")
     };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -204,6 +204,10 @@ static std::unique_ptr<FT_FontTextureMgr>       fontTexMgr = NULL;
 static std::unique_ptr<FT_FontTextureMgr>       damageDisplayFontTexMgr = NULL;
 static std::unique_ptr<FontFileBufferManager>   fontFileBufferManager = NULL;
 
+    //  Stamps from texture managers that have been destroyed, so GetFTFontCacheStamp()
+    //  never repeats a value across a shutdown/init cycle
+static uint64 retiredCacheStamp = 0;
+
 static FT_FontTextureMgr::FontFace* GetFontFace(FT_Face face, int size, FontTexKind kind)
 {
     switch (kind) {
@@ -428,7 +432,7 @@ std::pair<const FontChar*, const FontTexture2D*> FTFont::GetChar(ucs4 ch) const
             if (!face) {
                 face = damageDisplayFontTexMgr->CreateFontFace(_face, _size);
             }
-            return std::make_pair(face->GetChar(ch, _texKind), face->GetTexture());
+            return face->GetChar(ch, _texKind);
         }
         break;
 
@@ -439,7 +443,7 @@ std::pair<const FontChar*, const FontTexture2D*> FTFont::GetChar(ucs4 ch) const
             if (!face) {
                 face = fontTexMgr->CreateFontFace(_face, _size);
             }
-            return std::make_pair(face->GetChar(ch, _texKind), face->GetTexture());
+            return face->GetChar(ch, _texKind);
         }
         break;
     }
@@ -964,6 +968,7 @@ void CleanupFTFontSystem()
     assert(damageDisplayFontGroupMap.empty());
     assert(fontMap.empty());
 
+    retiredCacheStamp = GetFTFontCacheStamp() + 1;
     fontTexMgr = nullptr;
     damageDisplayFontTexMgr = nullptr;
     fontFileBufferManager = nullptr;
@@ -992,6 +997,14 @@ void CheckResetFTFontSystem()
 //         }
 //     }
 
+    if (fontTexMgr) {
+        fontTexMgr->OnFrameBarrier();
+    }
+
+    if (damageDisplayFontTexMgr) {
+        damageDisplayFontTexMgr->OnFrameBarrier();
+    }
+
     if (fontTexMgr && fontTexMgr->IsNeedReset()) {
         // for (UiFontGroupMap::iterator it=fontGroupMap.begin(); it!=fontGroupMap.end(); ++it) {
         //     it->second->ResetTable();
@@ -1055,5 +1068,29 @@ int GetFTFontFileCount()
     return fontFileBufferManager->GetCount();
 }
 
+uint64 GetFTFontCacheStamp()
+{
+    uint64 result = retiredCacheStamp;
+    if (fontTexMgr) {
+        result += fontTexMgr->GetChangeStamp();
+    }
+
+    if (damageDisplayFontTexMgr) {
+        result += damageDisplayFontTexMgr->GetChangeStamp();
+    }
+    return result;
+}
+
+void GetFTFontCacheMetrics(FontCacheMetrics& metrics)
+{
+    if (fontTexMgr) {
+        fontTexMgr->GetMetrics(metrics);
+    }
+
+    if (damageDisplayFontTexMgr) {
+        damageDisplayFontTexMgr->GetMetrics(metrics);
+    }
+}
+
 }
 
@@ -128,6 +128,8 @@ void    CleanupFTFontSystem();
 void    CheckResetFTFontSystem();
 int     GetFTFontCount(FontTexKind kind);
 int     GetFTFontFileCount();
+void    GetFTFontCacheMetrics(FontCacheMetrics& metrics);
+uint64  GetFTFontCacheStamp();
 
 intrusive_ptr<FTFont> GetX2FTFont(const char* path, int size, FontTexKind kind = FTK_GENERAL);
 
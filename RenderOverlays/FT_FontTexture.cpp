@@ -8,9 +8,15 @@
 #include "FT_FontTexture.h"
 #include "FontRendering.h"
 #include "../Core/Types.h"
+#include "../Math/RectanglePacking.h"
 #include "../Utility/PtrUtils.h"
 #include "../Utility/StringUtils.h"
 #include "../Utility/MemoryUtils.h"
+#include "../Utility/TimeUtils.h"
+#include "../Utility/Threading/Mutex.h"
+#include "../Utility/Threading/ThreadingUtils.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include "../ConsoleRig/Log.h"
 #include "../RenderCore/Metal/Format.h"
 
 #include "../BufferUploads/IBufferUploads.h"
@@ -20,738 +26,785 @@
 #include <assert.h>
 #include <algorithm>
 #include <functional>
+#include <deque>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_ADVANCES_H
 
 namespace RenderOverlays
 {
 
 #pragma warning(disable:4127)
 
-class CharSlotArray
+static int NextPower2(int n)
 {
-private:
-    int         _height;
-    int         _heightEnd;
-    uint32      _usedCount;
-    std::vector<FontChar> _array;
-
-public:
-    CharSlotArray(int height, int heightEnd, int count);
-    ~CharSlotArray();
-
-public:
-    bool            IsFull() const;
-    inline int      GetSlotHeight() const { return _height; }
-    inline int      GetSlotHeightEnd() const { return _heightEnd; }
+    int result = 1;
+    while (result < n) result <<= 1;
+    return result;
+}
 
-public:
-        //if there is not empty slot, return -1
-    FontCharID      UseEmptySlot(const FontChar& fc);
-    bool            ReleaseSlot(FontCharID id);
-    const FontChar* GetLeastUsedChar() const;
-    const FontChar* GetChar(unsigned index) const;
-    FontChar*       GetChar(unsigned index);
-};
+extern BufferUploads::IManager* gBufferUploads;
 
-CharSlotArray::CharSlotArray(int height, int heightEnd, int count)
+FontTexture2D::FontTexture2D(unsigned width, unsigned height, unsigned pixelFormat)
 {
-    _height = height;
-    _heightEnd = heightEnd;
-    _usedCount = 0;
-
-    _array.resize(count);
+    using namespace BufferUploads;
+    BufferDesc desc;
+    desc._type = BufferDesc::Type::Texture;
+    desc._bindFlags = BindFlag::ShaderResource;
+    desc._cpuAccess = CPUAccess::Write;
+    desc._gpuAccess = GPUAccess::Read;
+    desc._allocationRules = 0;
+    desc._textureDesc = TextureDesc::Plain2D(width, height, pixelFormat, 1);
+    XlCopyString(desc._name, "Font");
+    _transaction = gBufferUploads->Transaction_Begin(
+        desc, (BufferUploads::DataPacket*)nullptr, BufferUploads::TransactionOptions::ForceCreate|BufferUploads::TransactionOptions::LongTerm);
 }
 
-CharSlotArray::~CharSlotArray()
+FontTexture2D::~FontTexture2D()
 {
-
+    if (_transaction != ~BufferUploads::TransactionID(0x0)) {
+        gBufferUploads->Transaction_End(_transaction); 
+        _transaction = ~BufferUploads::TransactionID(0x0);
+    }
 }
 
-bool CharSlotArray::IsFull() const
+void FontTexture2D::UpdateGlyphToTexture(FT_GlyphSlot glyph, int offX, int offY, int width, int height)
 {
-    if (_usedCount >= _array.size()) {
-        return true;
-    }
-
-    return false;
-}
+    auto packet = BufferUploads::CreateBasicPacket(
+        width*height, nullptr, BufferUploads::TexturePitches(width, width*height));
+    uint8* data = (uint8*)packet->GetData();
 
-static bool IsUsed(const FontChar& fc) { return fc.ch != 0; }
+    int widthCursor = 0;
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            if (glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
+                uint8 pixel = 0;
+                if (i < int(glyph->bitmap.width) && j < int(glyph->bitmap.rows))
+                    pixel = glyph->bitmap.buffer[i + glyph->bitmap.width * j];
 
-FontCharID CharSlotArray::UseEmptySlot(const FontChar& fc)
-{
-    uint32 maxCount = (uint32)_array.size();
-    for (uint32 i = 0; i < maxCount; i++) {
-        if (!IsUsed(_array[i])) {
-            _array[i] = fc;
-            _usedCount++;
-            return FontCharID(i);
+                data[i + widthCursor] = pixel;
+            }
         }
+        widthCursor += width;
     }
 
-    //cannot be reached
-    return FontCharID_Invalid;
+    UpdateToTexture(packet.get(), offX, offY, width, height);
 }
 
-bool CharSlotArray::ReleaseSlot(FontCharID id)
+void FontTexture2D::UpdateToTexture(BufferUploads::DataPacket* packet, int offX, int offY, int width, int height)
 {
-    if (id < _array.size()) {
-        _array[id].ch = 0;
-        return true;
+    if (_transaction == ~BufferUploads::TransactionID(0x0)) {
+        _transaction = gBufferUploads->Transaction_Begin(_locator);
     }
-    return false;
+
+    gBufferUploads->UpdateData(_transaction, packet, BufferUploads::Box2D(offX, offY, offX+width, offY+height));
 }
 
-const FontChar* CharSlotArray::GetLeastUsedChar() const
+void* FontTexture2D::GetUnderlying() const
 {
-    const FontChar* fontCh = &_array[0];
-    uint32 maxCount = (uint32)_array.size();
-    for(uint32 i = 1; i < maxCount; i++) {
-        const FontChar& cursor = _array[i];
-        if (IsUsed(*fontCh) && IsUsed(cursor)) {
-            if (fontCh->usedTime > cursor.usedTime) {
-                fontCh = &cursor;
+    if ((!_locator || _locator->IsEmpty()) && _transaction) {
+        if (gBufferUploads->IsCompleted(_transaction)) {
+            _locator = gBufferUploads->GetResource(_transaction);
+            if (_locator && !_locator->IsEmpty()) {
+                gBufferUploads->Transaction_End(_transaction);
+                _transaction = ~BufferUploads::TransactionID(0x0);
             }
-        } else if (!IsUsed(*fontCh)) {       // (DavidJ -- is this correctly? Or was it intended to be 
-            fontCh = &_array[i];
         }
     }
-    return fontCh;
-}
-
-const FontChar* CharSlotArray::GetChar(unsigned index) const
-{
-    if (index < _array.size()) {
-        return &_array[index];
-    }
-    return NULL;
-}
-
-FontChar* CharSlotArray::GetChar(unsigned index)
-{
-    if (index < _array.size()) {
-        return &_array[index];
-    }
-    return NULL;
+    return _locator?_locator->GetUnderlying():nullptr;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-class TextureHeap
-{
-private:
-    enum { CHUNK_MARGIN = 1 };
+static const unsigned s_maxAtlasPages = 4;
+static const unsigned s_glyphPadding = 1;
 
-    struct Chunk
-	{
-		int _start;
-		int _end;
-		Chunk *_prev;
-		Chunk *_next;
-		bool _used;
-
-        Chunk(int start, int end)
-        {
-            _start = start;
-	        _end   = end;
-	        _prev  = NULL;
-	        _next  = NULL;
-	        _used  = false;
-        }
-
-		inline int AllocSize() const { return _end - _start; }
-	};
+    //  A copy of an FT_Face that is only used by the rasterisation thread (FT_Face
+    //  objects can't be used by multiple threads at the same time). It's created from
+    //  the same memory buffer as the main face. When the font is destroyed, _face is
+    //  set to null (under the freetype lock), and any queued requests will be skipped.
+class GlyphRasterFace
+{
+public:
+    FT_Face     _face;
+};
 
-	typedef std::vector<std::unique_ptr<Chunk>> UsedList;
-	UsedList _usedList;
+class GlyphRecord
+{
+public:
+    enum class State { Free, Pending, Ready };
+
+    FontChar                            _fc;
+    FT_FontTextureMgr::FontFace*        _face;
+    State                               _state;
+    unsigned                            _generation;
+    unsigned                            _lastUsedFrame;
+    unsigned                            _page;
+    RectanglePacker_Guillotine::Rectangle _rect;
+    FontCharID                          _lruPrev, _lruNext;     // (only glyphs with space in the atlas are in the LRU list)
+
+    GlyphRecord() : _face(nullptr), _state(State::Free), _generation(0), _lastUsedFrame(0), _page(~0u), _lruPrev(FontCharID_Invalid), _lruNext(FontCharID_Invalid) {}
+};
 
-	typedef std::vector<std::unique_ptr<Chunk>> EmptyList;
-	EmptyList _emptyList;
+class AtlasPage
+{
+public:
+    std::unique_ptr<FontTexture2D>  _texture;
+    RectanglePacker_Guillotine      _packer;
+    std::vector<uint8>              _shadow;        // cpu side copy of the texture contents
+    UInt2                           _dirtyMin, _dirtyMax;
+    unsigned                        _glyphCount;
 
-    int _heapSize;
+    void MarkDirty(UInt2 mins, UInt2 maxs)
+    {
+        _dirtyMin[0] = std::min(_dirtyMin[0], mins[0]); _dirtyMin[1] = std::min(_dirtyMin[1], mins[1]);
+        _dirtyMax[0] = std::max(_dirtyMax[0], maxs[0]); _dirtyMax[1] = std::max(_dirtyMax[1], maxs[1]);
+    }
+};
 
+class RasterRequest
+{
 public:
-    bool IsAllocable(int size);
-    std::unique_ptr<CharSlotArray> CreateCharSlotArray(int size, int maxCount);
-    void DestroyCharSlotArray(CharSlotArray* slot);
-
-private:
-    bool AllocNewChunk(int size, int& startPos, int& endPos);
-    void DeAllocChunk(int startPos);
+    std::shared_ptr<GlyphRasterFace>    _face;
+    ucs4                                _ch;
+    FontCharID                          _glyph;
+    unsigned                            _generation;
+};
 
-    Chunk* FindBestChunk(int size);
-    Chunk* FindUsedChunk(int startPos);
+class RasterResult
+{
+public:
+    FontCharID          _glyph;
+    unsigned            _generation;
+    bool                _success;
+    int                 _left, _top;
+    unsigned            _width, _height;
+    std::vector<uint8>  _bitmap;
+    uint64              _rasterTime;
+};
 
+class FT_FontTextureMgr::Pimpl
+{
 public:
-    TextureHeap(int size);
-    virtual ~TextureHeap();
+    unsigned                    _pageWidth, _pageHeight;
+    std::vector<AtlasPage>      _pages;
+    std::deque<GlyphRecord>     _glyphs;        // (deque so FontChar pointers are not invalidated by new glyphs)
+    std::vector<FontCharID>     _freeGlyphs;
+    unsigned                    _currentFrame;
+
+        //  Glyphs that have space in the atlas, ordered from least recently used
+        //  (head) to most recently used (tail)
+    FontCharID                  _lruHead, _lruTail;
+
+    FT_Library                  _rasterLibrary;
+    Threading::Mutex            _freetypeLock;  // protects _rasterLibrary and all GlyphRasterFace objects
+    std::vector<std::pair<FontFace*, std::shared_ptr<GlyphRasterFace>>> _rasterFaces;
+
+    Threading::Mutex            _queueLock;     // protects _requests, _results & _workerScheduled
+    std::deque<RasterRequest>   _requests;
+    std::vector<RasterResult>   _results;
+    bool                        _workerScheduled;
+    Interlocked::Value          _resultsReady;
+    std::unique_ptr<CompletionThreadPool> _workerPool;
+
+    uint64      _hits, _misses, _evictions;
+    uint64      _rasterisedCount, _rasterTime;
+    unsigned    _pendingCount;
+    uint64      _generation;        // incremented whenever a glyph is updated or released
+
+        //  Glyphs that were rasterised, but didn't fit in the atlas (because every
+        //  glyph in it was in use that frame). We keep the bitmap and retry placing
+        //  it at the next frame barrier, rather than rasterising it again every frame
+    std::vector<RasterResult>   _unplacedGlyphs;
+
+    void RasterThreadFunction();
+    void QueueRasterRequest(RasterRequest&& request);
+    bool AllocateSpace(UInt2 dims, unsigned& page, RectanglePacker_Guillotine::Rectangle& rect, FT_FontTextureMgr& mgr);
+    bool PlaceGlyph(const RasterResult& result, FT_FontTextureMgr& mgr);
+    void RetryUnplacedGlyphs(FT_FontTextureMgr& mgr);
+    void UploadDirtyRegions();
+
+    void LinkLRU(FontCharID glyph);
+    void UnlinkLRU(FontCharID glyph);
+    void TouchLRU(FontCharID glyph);
 };
 
-TextureHeap::TextureHeap(int size)
+static bool RasteriseGlyph(FT_Face face, ucs4 ch, RasterResult& result)
 {
-    _heapSize = size;
-	_emptyList.push_back(std::make_unique<Chunk>(0, _heapSize));
+    FT_Error error = FT_Load_Char(face, ch, FT_LOAD_RENDER | FT_LOAD_NO_AUTOHINT);
+    if (error && ch == ' ')
+        error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
+    if (error) return false;
+
+    FT_GlyphSlot glyph = face->glyph;
+    const auto& bitmap = glyph->bitmap;
+    result._left = glyph->bitmap_left;
+    result._top = glyph->bitmap_top;
+    result._width = bitmap.width;
+    result._height = bitmap.rows;
+    result._bitmap.resize(result._width * result._height, 0);
+
+    for (unsigned j=0; j<result._height; ++j) {
+        const uint8* srcRow = (bitmap.pitch >= 0)
+            ? (bitmap.buffer + j * bitmap.pitch)
+            : (bitmap.buffer + (result._height-1-j) * -bitmap.pitch);
+        uint8* dstRow = &result._bitmap[j * result._width];
+        if (bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
+            XlCopyMemory(dstRow, srcRow, result._width);
+        } else if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+            for (unsigned i=0; i<result._width; ++i)
+                dstRow[i] = (srcRow[i>>3] & (0x80 >> (i&7))) ? 0xff : 0x00;
+        }
+    }
+    return true;
 }
 
-TextureHeap::~TextureHeap()
+void FT_FontTextureMgr::Pimpl::RasterThreadFunction()
 {
-    if( !_usedList.empty() ) {
-		// GameWarning("TextureHeap - %ld chunks not released", _usedList.size());
-		_usedList.clear();
-	}
+        // Process requests until the queue is empty. There is only ever one
+        // instance of this function running at a time (see _workerScheduled)
+    for (;;) {
+        RasterRequest request;
+        {
+            ScopedLock(_queueLock);
+            if (_requests.empty()) {
+                _workerScheduled = false;
+                return;
+            }
+            request = std::move(_requests.front());
+            _requests.pop_front();
+        }
 
-	// if( _emptyList.size() != 1 ) {
-	// 	GameWarning("TextureHeap - too many empty chunks(%ld) remained", _emptyList.size() );
-	// }
-	_emptyList.clear();
+        RasterResult result;
+        result._glyph = request._glyph;
+        result._generation = request._generation;
+        result._success = false;
+
+        auto startTime = GetPerformanceCounter();
+        {
+            ScopedLock(_freetypeLock);
+            if (request._face->_face)
+                result._success = RasteriseGlyph(request._face->_face, request._ch, result);
+        }
+        result._rasterTime = GetPerformanceCounter() - startTime;
+
+        {
+            ScopedLock(_queueLock);
+            _results.push_back(std::move(result));
+        }
+        Interlocked::Exchange(&_resultsReady, 1);
+    }
 }
 
-bool TextureHeap::IsAllocable(int size)
+void FT_FontTextureMgr::Pimpl::QueueRasterRequest(RasterRequest&& request)
 {
-    if( FindBestChunk(size + CHUNK_MARGIN))
-        return true;
+    bool scheduleWorker = false;
+    {
+        ScopedLock(_queueLock);
+        _requests.push_back(std::move(request));
+        scheduleWorker = !_workerScheduled;
+        _workerScheduled = true;
+    }
 
-    return false;
+    if (scheduleWorker) {
+        if (!_workerPool)
+            _workerPool = std::make_unique<CompletionThreadPool>(1);
+        _workerPool->Enqueue([this]() { this->RasterThreadFunction(); });
+    }
 }
 
-std::unique_ptr<CharSlotArray> TextureHeap::CreateCharSlotArray(int size, int maxCount)
+void FT_FontTextureMgr::Pimpl::LinkLRU(FontCharID glyph)
 {
-    int startPos, endPos;
-    AllocNewChunk(size + CHUNK_MARGIN, startPos, endPos);
-    return std::make_unique<CharSlotArray>(startPos, endPos, maxCount);
+    auto& g = _glyphs[glyph];
+    g._lruPrev = _lruTail;
+    g._lruNext = FontCharID_Invalid;
+    if (_lruTail != FontCharID_Invalid) _glyphs[_lruTail]._lruNext = glyph;
+    else _lruHead = glyph;
+    _lruTail = glyph;
 }
 
-void TextureHeap::DestroyCharSlotArray(CharSlotArray* slot)
+void FT_FontTextureMgr::Pimpl::UnlinkLRU(FontCharID glyph)
 {
-    if(slot) {
-        DeAllocChunk(slot->GetSlotHeight());
-        // delete slot;     (delete is called by the owner, now)
+    auto& g = _glyphs[glyph];
+    if (g._lruPrev != FontCharID_Invalid) _glyphs[g._lruPrev]._lruNext = g._lruNext;
+    else if (_lruHead == glyph) _lruHead = g._lruNext;
+    else return;    // (not in the list)
+    if (g._lruNext != FontCharID_Invalid) _glyphs[g._lruNext]._lruPrev = g._lruPrev;
+    else _lruTail = g._lruPrev;
+    g._lruPrev = g._lruNext = FontCharID_Invalid;
+}
+
+void FT_FontTextureMgr::Pimpl::TouchLRU(FontCharID glyph)
+{
+    auto& g = _glyphs[glyph];
+    g._lastUsedFrame = _currentFrame;
+    if (g._page != ~0u && _lruTail != glyph) {
+        UnlinkLRU(glyph);
+        LinkLRU(glyph);
     }
 }
 
-bool TextureHeap::AllocNewChunk(int size, int& startPos, int& endPos)
+bool FT_FontTextureMgr::Pimpl::AllocateSpace(
+    UInt2 dims, unsigned& page, RectanglePacker_Guillotine::Rectangle& rect,
+    FT_FontTextureMgr& mgr)
 {
-    startPos = endPos = 0;
+    if (dims[0] > _pageWidth || dims[1] > _pageHeight) return false;
 
-    Chunk *bestChunk = FindBestChunk(size);
-    if(!bestChunk) {
-        // GameWarning("TextureHeap - overflow");
-        return false;
+    for (unsigned p=0; p<unsigned(_pages.size()); ++p) {
+        rect = _pages[p]._packer.Allocate(dims);
+        if (rect.second[0] > rect.first[0]) { page = p; return true; }
     }
 
-    std::unique_ptr<Chunk> usedChunk;
-    if(bestChunk->AllocSize() == size) {
-        EmptyList::iterator i = std::remove_if(_emptyList.begin(), _emptyList.end(), [=](const std::unique_ptr<Chunk>& i){return i.get() == bestChunk;});
-        std::swap(usedChunk, *i);
-        _emptyList.erase(i);
-    } else {
-        usedChunk = std::make_unique<Chunk>(bestChunk->_start, bestChunk->_start + size);
+    if (_pages.size() < s_maxAtlasPages) {
+        AtlasPage newPage;
+        newPage._texture = std::make_unique<FontTexture2D>(_pageWidth, _pageHeight, RenderCore::Metal::NativeFormat::R8_UNORM);
+        newPage._packer = RectanglePacker_Guillotine(UInt2(_pageWidth, _pageHeight));
+        newPage._shadow.resize(_pageWidth*_pageHeight, 0);
+        newPage._glyphCount = 0;
+            // the first upload will initialise the entire page
+        newPage._dirtyMin = UInt2(0, 0);
+        newPage._dirtyMax = UInt2(_pageWidth, _pageHeight);
+        _pages.push_back(std::move(newPage));
 
-		bestChunk->_start = usedChunk->_end;
-		usedChunk->_prev = bestChunk->_prev;
+        page = unsigned(_pages.size()-1);
+        rect = _pages[page]._packer.Allocate(dims);
+        return rect.second[0] > rect.first[0];
+    }
 
-        if( bestChunk->_prev )
-			bestChunk->_prev->_next = usedChunk.get();
+        //  All pages are full. Evict the glyphs that were used least recently
+        //  until we can fit the new glyph. Glyphs used in the current frame are
+        //  never evicted (they may be referenced by draw calls in flight). Since the
+        //  LRU list is ordered by use, we can stop at the first glyph used this frame
+    while (_lruHead != FontCharID_Invalid && _glyphs[_lruHead]._lastUsedFrame < _currentFrame) {
+        auto evicted = _lruHead;
+        auto evictedPage = _glyphs[evicted]._page;
+        mgr.ReleaseGlyph(evicted);
+        ++_evictions;
 
-		usedChunk->_next = bestChunk;
-		bestChunk->_prev = usedChunk.get();
+        rect = _pages[evictedPage]._packer.Allocate(dims);
+        if (rect.second[0] > rect.first[0]) { page = evictedPage; return true; }
     }
 
-    usedChunk->_used = true;
-	startPos = usedChunk->_start;
-    endPos   = usedChunk->_end;
-    _usedList.push_back(std::move(usedChunk));
-	return true;
+    return false;
 }
 
-void TextureHeap::DeAllocChunk(int startPos)
+bool FT_FontTextureMgr::Pimpl::PlaceGlyph(const RasterResult& r, FT_FontTextureMgr& mgr)
 {
-	Chunk *usedChunk = FindUsedChunk(startPos);
+    unsigned page;
+    RectanglePacker_Guillotine::Rectangle rect;
+    UInt2 dims(r._width + s_glyphPadding, r._height + s_glyphPadding);
+    if (!AllocateSpace(dims, page, rect, mgr))
+        return false;
 
-    Chunk *prev = usedChunk->_prev;
-	if( prev && !prev->_used ) {
-		usedChunk->_start = prev->_start;
-		usedChunk->_prev  = prev->_prev;
+    auto& glyph = _glyphs[r._glyph];
+    auto& atlasPage = _pages[page];
+    ++atlasPage._glyphCount;
+    glyph._page = page;
+    glyph._rect = rect;
+    glyph._lastUsedFrame = _currentFrame;     // (it was requested recently, and is going to the tail of the LRU list)
+    LinkLRU(r._glyph);
+    ++_generation;
+
+        // write into the cpu side copy of the page (including clearing the padding)
+    for (unsigned j=rect.first[1]; j<rect.second[1]; ++j)
+        XlSetMemory(&atlasPage._shadow[j*_pageWidth + rect.first[0]], 0, rect.second[0] - rect.first[0]);
+    for (unsigned j=0; j<r._height; ++j)
+        XlCopyMemory(
+            &atlasPage._shadow[(rect.first[1]+j)*_pageWidth + rect.first[0]],
+            &r._bitmap[j*r._width], r._width);
+    atlasPage.MarkDirty(rect.first, rect.second);
+
+    auto& fc = glyph._fc;
+    fc.left     = (float)r._left;
+    fc.top      = (float)r._top;
+    fc.width    = (float)r._width;
+    fc.height   = (float)r._height;
+    fc.offsetX  = rect.first[0];
+    fc.offsetY  = rect.first[1];
+    fc.u0       = (float)rect.first[0] / _pageWidth;
+    fc.v0       = (float)rect.first[1] / _pageHeight;
+    fc.u1       = (float)(rect.first[0] + r._width) / _pageWidth;
+    fc.v1       = (float)(rect.first[1] + r._height) / _pageHeight;
+    return true;
+}
 
-        if( prev->_prev )
-			prev->_prev->_next = usedChunk;
+void FT_FontTextureMgr::Pimpl::RetryUnplacedGlyphs(FT_FontTextureMgr& mgr)
+{
+        //  Called just after the frame counter advances, so glyphs used in the
+        //  previous frame can now be evicted. Only glyphs that were requested in
+        //  that frame are worth placing; others are released, and will be rasterised
+        //  again if they are requested later.
+    if (_unplacedGlyphs.empty()) return;
 
-        _emptyList.erase(std::remove_if(_emptyList.begin(), _emptyList.end(), [=](const std::unique_ptr<Chunk>& i){return i.get() == prev;}));
-	}
+    std::vector<RasterResult> unplaced;
+    std::swap(unplaced, _unplacedGlyphs);
+    for (auto& r:unplaced) {
+        auto& glyph = _glyphs[r._glyph];
+        if (glyph._generation != r._generation || glyph._state != GlyphRecord::State::Ready)
+            continue;       // glyph was released in the meantime
 
-	Chunk *next = usedChunk->_next;
-	if( next && !next->_used ) {
-		usedChunk->_end  = next->_end;
-		usedChunk->_next = next->_next;
-		
-        if( next->_next )
-			next->_next->_prev = usedChunk;
+        if ((glyph._lastUsedFrame + 1) < _currentFrame) {
+            mgr.ReleaseGlyph(r._glyph);
+            continue;
+        }
 
-		_emptyList.erase(std::remove_if(_emptyList.begin(), _emptyList.end(), [=](const std::unique_ptr<Chunk>& i){return i.get() == next;}));
-	}
+        if (!PlaceGlyph(r, mgr))
+            _unplacedGlyphs.push_back(std::move(r));
+    }
 
-    UsedList::iterator i = std::partition(_usedList.begin(), _usedList.end(), [=](const std::unique_ptr<Chunk>& i){return i.get() != usedChunk;});
-    assert(*i);
-    std::unique_ptr<Chunk> newPtr; std::swap(newPtr, *i);
-    _usedList.erase(i);
-	newPtr->_used = false;
-	_emptyList.push_back(std::move(newPtr));
+    UploadDirtyRegions();
 }
 
-TextureHeap::Chunk* TextureHeap::FindBestChunk(int size)
+void FT_FontTextureMgr::Pimpl::UploadDirtyRegions()
 {
-    EmptyList::iterator iter = _emptyList.begin();
-    for( ; iter != _emptyList.end(); ++iter) {
-        if((*iter)->AllocSize() >= size)
-            return iter->get();
-    }
+    for (auto& page:_pages) {
+        if (page._dirtyMax[0] <= page._dirtyMin[0] || page._dirtyMax[1] <= page._dirtyMin[1])
+            continue;
 
-    return NULL;
-}
+        unsigned width = page._dirtyMax[0] - page._dirtyMin[0];
+        unsigned height = page._dirtyMax[1] - page._dirtyMin[1];
+        auto packet = BufferUploads::CreateBasicPacket(
+            width*height, nullptr, BufferUploads::TexturePitches(width, width*height));
+        uint8* data = (uint8*)packet->GetData();
+        for (unsigned j=0; j<height; ++j)
+            XlCopyMemory(
+                &data[j*width], 
+                &page._shadow[(page._dirtyMin[1]+j)*_pageWidth + page._dirtyMin[0]], 
+                width);
 
-TextureHeap::Chunk* TextureHeap::FindUsedChunk(int startPos)
-{
-    UsedList::iterator iter = _usedList.begin();
-    for( ; iter != _usedList.end(); ++iter) {
-        if((*iter)->_start == startPos)
-            return iter->get();
-    }
+        page._texture->UpdateToTexture(packet.get(), page._dirtyMin[0], page._dirtyMin[1], width, height);
 
-	// GameWarning("TextureHeap - cannot find used chunk(%d)", startPos);
-	return NULL;
+        page._dirtyMin = UInt2(_pageWidth, _pageHeight);
+        page._dirtyMax = UInt2(0, 0);
+    }
 }
 
-//------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
 
 FT_FontTextureMgr::FT_FontTextureMgr()
 {
-    _texWidth = 0;
-    _texHeight = 0;
-
-    // _tex = 0;
-
     _needReset = false;
+
+    _pimpl = std::make_unique<Pimpl>();
+    _pimpl->_pageWidth = _pimpl->_pageHeight = 0;
+    _pimpl->_currentFrame = 1;
+    _pimpl->_lruHead = _pimpl->_lruTail = FontCharID_Invalid;
+    _pimpl->_rasterLibrary = nullptr;
+    _pimpl->_workerScheduled = false;
+    _pimpl->_resultsReady = 0;
+    _pimpl->_hits = _pimpl->_misses = _pimpl->_evictions = 0;
+    _pimpl->_rasterisedCount = _pimpl->_rasterTime = 0;
+    _pimpl->_pendingCount = 0;
+    _pimpl->_generation = 0;
 }
 
 FT_FontTextureMgr::~FT_FontTextureMgr()
 {
-    if(!_faceList.empty()) {
-        FontFaceList::iterator faceIter = _faceList.begin();
-        for( ; faceIter != _faceList.end(); ++faceIter) {
-            std::unique_ptr<FontFace>& face = *faceIter;
-
-            CharSlotArrayList::iterator slotIter = face->_slotList.begin();
-            for( ; slotIter != face->_slotList.end(); ++slotIter) {
-                _texHeap->DestroyCharSlotArray((*slotIter).get());
-            }
+    _faceList.clear();
 
-            face.reset();
-        }
-        _faceList.clear();
+        // destroying the pool will wait for the raster thread to finish
+    _pimpl->_workerPool.reset();
+    if (_pimpl->_rasterLibrary) {
+        FT_Done_FreeType(_pimpl->_rasterLibrary);
+        _pimpl->_rasterLibrary = nullptr;
     }
-
-    _texHeap.reset();
 }
 
-static int NextPower2(int n)
+bool FT_FontTextureMgr::Init(int texWidth, int texHeight)
 {
-    int result = 1;
-    while (result < n) result <<= 1;
-    return result;
+    _pimpl->_pageWidth = NextPower2(texWidth);
+    _pimpl->_pageHeight = NextPower2(texHeight);
+    
+        // the raster thread gets it's own library, because FT_Library objects are not thread safe
+    FT_Error error = FT_Init_FreeType(&_pimpl->_rasterLibrary);
+    return !error;
 }
 
-extern BufferUploads::IManager* gBufferUploads;
-
-FontTexture2D::FontTexture2D(unsigned width, unsigned height, unsigned pixelFormat)
+void FT_FontTextureMgr::CheckTextureValidate(FT_Face /*face*/, int /*size*/, FontChar *fc)
 {
-    using namespace BufferUploads;
-    BufferDesc desc;
-    desc._type = BufferDesc::Type::Texture;
-    desc._bindFlags = BindFlag::ShaderResource;
-    desc._cpuAccess = CPUAccess::Write;
-    desc._gpuAccess = GPUAccess::Read;
-    desc._allocationRules = 0;
-    desc._textureDesc = TextureDesc::Plain2D(width, height, pixelFormat, 1);
-    XlCopyString(desc._name, "Font");
-    _transaction = gBufferUploads->Transaction_Begin(
-        desc, (BufferUploads::DataPacket*)nullptr, BufferUploads::TransactionOptions::ForceCreate|BufferUploads::TransactionOptions::LongTerm);
+        // (glyphs are now updated in the texture as soon as they are rasterised)
+    fc->needTexUpdate = false;
 }
 
-FontTexture2D::~FontTexture2D()
+void FT_FontTextureMgr::RequestReset()
 {
-    if (_transaction != ~BufferUploads::TransactionID(0x0)) {
-        gBufferUploads->Transaction_End(_transaction); 
-        _transaction = ~BufferUploads::TransactionID(0x0);
-    }
+    _needReset = true;
 }
 
-void FontTexture2D::UpdateGlyphToTexture(FT_GlyphSlot glyph, int offX, int offY, int width, int height)
+bool FT_FontTextureMgr::IsNeedReset() const
 {
-    auto packet = BufferUploads::CreateBasicPacket(
-        width*height, nullptr, BufferUploads::TexturePitches(width, width*height));
-    uint8* data = (uint8*)packet->GetData();
-
-    int widthCursor = 0;
-    for (int j = 0; j < height; ++j) {
-        for (int i = 0; i < width; ++i) {
-            if (glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
-                uint8 pixel = 0;
-                if (i < int(glyph->bitmap.width) && j < int(glyph->bitmap.rows))
-                    pixel = glyph->bitmap.buffer[i + glyph->bitmap.width * j];
-
-                data[i + widthCursor] = pixel;
-            }
-        }
-        widthCursor += width;
-    }
-
-    UpdateToTexture(packet.get(), offX, offY, width, height);
+    return _needReset;
 }
 
-void FontTexture2D::UpdateToTexture(BufferUploads::DataPacket* packet, int offX, int offY, int width, int height)
+void FT_FontTextureMgr::Reset()
 {
-    if (_transaction == ~BufferUploads::TransactionID(0x0)) {
-        _transaction = gBufferUploads->Transaction_Begin(_locator);
-    }
+    if(!IsNeedReset())  return;
 
-    gBufferUploads->UpdateData(_transaction, packet, BufferUploads::Box2D(offX, offY, offX+width, offY+height));
+    _faceList.clear();
+    _needReset = false;
 }
 
-void* FontTexture2D::GetUnderlying() const
+void FT_FontTextureMgr::OnFrameBarrier()
 {
-    if ((!_locator || _locator->IsEmpty()) && _transaction) {
-        if (gBufferUploads->IsCompleted(_transaction)) {
-            _locator = gBufferUploads->GetResource(_transaction);
-            if (_locator && !_locator->IsEmpty()) {
-                gBufferUploads->Transaction_End(_transaction);
-                _transaction = ~BufferUploads::TransactionID(0x0);
-            }
-        }
-    }
-    return _locator?_locator->GetUnderlying():nullptr;
+    ProcessCompletedGlyphs();
+    ++_pimpl->_currentFrame;
+    _pimpl->RetryUnplacedGlyphs(*this);
 }
 
-bool FT_FontTextureMgr::Init(int texWidth, int texHeight)
+void FT_FontTextureMgr::GetMetrics(FontCacheMetrics& metrics) const
 {
-    _texWidth = NextPower2(texWidth);
-    _texHeight = NextPower2(texHeight);
-    _texture = std::make_unique<FontTexture2D>(_texWidth, _texHeight, RenderCore::Metal::NativeFormat::R8_UNORM);
-    _texHeap = std::make_unique<TextureHeap>(_texHeight);
-    return true;
+    metrics._hits += _pimpl->_hits;
+    metrics._misses += _pimpl->_misses;
+    metrics._evictions += _pimpl->_evictions;
+    metrics._rasterisedCount += _pimpl->_rasterisedCount;
+    metrics._rasterisationTime += float(_pimpl->_rasterTime) / float(GetPerformanceCounterFrequency()) * 1000.f;
+    metrics._pendingCount += _pimpl->_pendingCount;
+    metrics._pageCount += unsigned(_pimpl->_pages.size());
+    metrics._glyphCount += unsigned(_pimpl->_glyphs.size() - _pimpl->_freeGlyphs.size());
+    metrics._generation += _pimpl->_generation;
 }
 
-void FT_FontTextureMgr::CheckTextureValidate(FT_Face face, int size, FontChar *fc)
+uint64 FT_FontTextureMgr::GetChangeStamp() const
 {
-    if(!fc->needTexUpdate /*|| fc->tex*/) {
-        return;
-    }
-
-    FT_Error error = FT_Load_Char(face, fc->ch, FT_LOAD_RENDER | FT_LOAD_NO_AUTOHINT);
-    if (error)  return;
+        // (both counters only ever increase, so the sum changes when either does)
+    return _pimpl->_generation + _pimpl->_currentFrame;
+}
 
-    FT_GlyphSlot glyph = face->glyph;
+void FT_FontTextureMgr::ReleaseGlyph(FontCharID id)
+{
+    auto& glyph = _pimpl->_glyphs[id];
+    if (glyph._state == GlyphRecord::State::Free) return;
 
-    int updateWidth = 0;
-    int updateHeight = 0;
+    if (glyph._page != ~0u) {
+            // (the guillotine packer merges freed space with its neighbours, so the
+            // page returns to a single free rectangle when it becomes empty)
+        auto& page = _pimpl->_pages[glyph._page];
+        assert(page._glyphCount > 0);
+        --page._glyphCount;
+        page._packer.Deallocate(glyph._rect);
+        _pimpl->UnlinkLRU(id);
+    }
 
-    if(0/*fc->tex == _tex*/) {
-        updateWidth = face->size->metrics.max_advance / 64;
-        updateHeight = size;
-    } else {
-        updateWidth = NextPower2(glyph->bitmap.width);
-        updateHeight = NextPower2(glyph->bitmap.rows);
+    if (glyph._state == GlyphRecord::State::Pending) {
+        assert(_pimpl->_pendingCount > 0);
+        --_pimpl->_pendingCount;
     }
 
-    // UpdateGlyphToTexture(glyph, fc->tex->GetTextureID(), fc->offsetX, fc->offsetY, updateWidth, updateHeight);
+        // remove from the face's table, so the next request will create a new glyph
+    if (glyph._face)
+        glyph._face->_table[glyph._fc.ch] = FontCharID_Invalid;
 
-    fc->needTexUpdate = false;
+    glyph._fc = FontChar();
+    glyph._face = nullptr;
+    glyph._state = GlyphRecord::State::Free;
+    glyph._page = ~0u;
+    ++glyph._generation;    // any in-flight raster requests for this glyph will be ignored
+    ++_pimpl->_generation;
+    _pimpl->_freeGlyphs.push_back(id);
 }
 
-void FT_FontTextureMgr::RequestReset()
+void FT_FontTextureMgr::ProcessCompletedGlyphs()
 {
-    _needReset = true;
-}
+    if (!Interlocked::Load(&_pimpl->_resultsReady)) return;
 
-bool FT_FontTextureMgr::IsNeedReset() const
-{
-    return _needReset;
-}
+    std::vector<RasterResult> results;
+    {
+        ScopedLock(_pimpl->_queueLock);
+        std::swap(results, _pimpl->_results);
+        Interlocked::Exchange(&_pimpl->_resultsReady, 0);
+    }
 
-void FT_FontTextureMgr::Reset()
-{
-    if(!IsNeedReset())  return;
+    for (auto& r:results) {
+        _pimpl->_rasterTime += r._rasterTime;
+        ++_pimpl->_rasterisedCount;
+
+        auto& glyph = _pimpl->_glyphs[r._glyph];
+        if (glyph._generation != r._generation || glyph._state != GlyphRecord::State::Pending)
+            continue;       // glyph was released while it was being rasterised
 
-    FontFaceList::iterator faceIter = _faceList.begin();
-    for( ; faceIter != _faceList.end(); ++faceIter) {
-        std::unique_ptr<FontFace>& face = *faceIter;
+        --_pimpl->_pendingCount;
+        glyph._state = GlyphRecord::State::Ready;
+        ++_pimpl->_generation;
+        if (!r._success || !r._width || !r._height)
+            continue;       // nothing to draw (eg, whitespace)
 
-        CharSlotArrayList::iterator slotIter = face->_slotList.begin();
-        for( ; slotIter != face->_slotList.end(); ++slotIter) {
-            _texHeap->DestroyCharSlotArray((*slotIter).get());
+        if (!_pimpl->PlaceGlyph(r, *this)) {
+            UInt2 dims(r._width + s_glyphPadding, r._height + s_glyphPadding);
+            if (dims[0] > _pimpl->_pageWidth || dims[1] > _pimpl->_pageHeight) {
+                    //  This glyph can never fit. It stays in the table with no atlas
+                    //  space (so it's skipped like whitespace) until the font is reset
+                LogWarning << "Font glyph (" << glyph._fc.ch << ") is larger than a glyph cache page, and will not be drawn";
+            } else {
+                LogWarning << "Font glyph cache is full. Glyph (" << glyph._fc.ch << ") will not be drawn until space is available";
+                _pimpl->_unplacedGlyphs.push_back(std::move(r));
+            }
         }
     }
-    _faceList.clear();
-    _needReset = false;
+
+        // upload all of the changes to each page as a single update
+    _pimpl->UploadDirtyRegions();
 }
 
-FontCharID FT_FontTextureMgr::FontFace::CreateChar(int ch, FontTexKind kind)
+FontCharID FT_FontTextureMgr::FontFace::CreateChar(int ch, FontTexKind /*kind*/)
 {
-    // if (!_tex) {
-    //     // GameWarning("FT_FontTextureMgr::CreateChar - not initialized");
-    //     return 0;
-    // }
-
-    FT_Error error = FT_Load_Char(_face, ch, FT_LOAD_RENDER | FT_LOAD_NO_AUTOHINT);
+        //  Get the metrics required for layout immediately. The bitmap will be
+        //  rendered in the background
+    FT_UInt glyphIndex = FT_Get_Char_Index(_face, ch);
+    FT_Fixed advance = 0;
+    FT_Error error = FT_Get_Advance(_face, glyphIndex, FT_LOAD_NO_AUTOHINT, &advance);
     if (error) {
-        if(ch != ' ') {
-            // GameWarning("Failed to load character \'%d\'", ch);
-
-            // FontChar* fc = CreateEmptyFontChar(ch);
-            // fc->xAdvance = size * 0.5f;
-            // return fc;
-            return FontCharID_Invalid;
-        } else {
-            error = FT_Load_Char(_face, ch, FT_LOAD_RENDER);
-            if (error) {
-                // FontChar* fc = CreateEmptyFontChar(ch);
-                // fc->xAdvance = size * 0.5f;
-                // return fc;
-                return FontCharID_Invalid;
-            }
-        }
+        if (ch != ' ') return FontCharID_Invalid;
+        error = FT_Get_Advance(_face, glyphIndex, FT_LOAD_DEFAULT, &advance);
+        if (error) return FontCharID_Invalid;
     }
 
-    FT_GlyphSlot glyph = _face->glyph;
-
-    FontChar fc(ch);
-    fc.left     = (float)glyph->bitmap_left;
-    fc.top      = (float)glyph->bitmap_top;
-    fc.width    = (float)glyph->bitmap.width;
-    fc.height   = (float)glyph->bitmap.rows;
-    fc.xAdvance = (float)glyph->advance.x / 64.0f;
-
-    // assert((face->size->metrics.max_advance / 64) < glyph->bitmap.width);
-
-    int offsetX, offsetY;
-    FontCharID charID = FindEmptyCharSlot(fc, &offsetX, &offsetY, kind);
-    if (charID != FontCharID_Invalid) {
-        if (_texture) {
-            _texture->UpdateGlyphToTexture( glyph, offsetX, offsetY,
-                                            _face->size->metrics.max_advance / 64, _size);
-        }
-        return charID;
+    auto& pimpl = *_mgr->_pimpl;
+    FontCharID id;
+    if (!pimpl._freeGlyphs.empty()) {
+        id = pimpl._freeGlyphs.back();
+        pimpl._freeGlyphs.pop_back();
     } else {
-        return FontCharID_Invalid;
-        // RequestReset();
-        // 
-        // int texWidth = NextPower2(glyph->bitmap.width);
-        // int texHeight = NextPower2(glyph->bitmap.rows);
-        // // ITexture *newTex = CreateTempTexture(glyph, texWidth, texHeight);
-        // // fc->tex = newTex;
-        // 
-        // fc.u0 = 0.0f;
-        // fc.v0 = 0.0f;
-        // fc.u1 = (float)glyph->bitmap.width / texWidth;
-        // fc.v1 = (float)glyph->bitmap.rows / texHeight;
-        // 
-        // fc.offsetX = 0;
-        // fc.offsetY = 0;
+        id = FontCharID(pimpl._glyphs.size());
+        pimpl._glyphs.push_back(GlyphRecord());
     }
-}
 
-FT_FontTextureMgr::FontFace* FT_FontTextureMgr::FindFontFace(FT_Face face, int size)
-{
-    auto it = _faceList.begin();
-    for( ; it != _faceList.end(); ++it) {
-        if((*it)->_face == face && (*it)->_size == size)
-            return (*it).get();
-    }
+    auto& glyph = pimpl._glyphs[id];
+    glyph._fc = FontChar(ch);
+    glyph._fc.xAdvance = (float)advance / 65536.0f;
+    glyph._fc.width = glyph._fc.height = 0.f;
+    glyph._fc.u1 = glyph._fc.v1 = 0.f;
+    glyph._face = this;
+    glyph._state = GlyphRecord::State::Pending;
+    glyph._page = ~0u;
+    glyph._lastUsedFrame = pimpl._currentFrame;
+    ++pimpl._pendingCount;
 
-    return NULL;
-}
+    auto i = std::find_if(
+        pimpl._rasterFaces.begin(), pimpl._rasterFaces.end(),
+        [this](const std::pair<FontFace*, std::shared_ptr<GlyphRasterFace>>& p) { return p.first == this; });
+    assert(i != pimpl._rasterFaces.end());
 
-auto FT_FontTextureMgr::CreateFontFace(FT_Face face, int size) -> FontFace*
-{
-    if(!_texHeap->IsAllocable(size)) {
-        return nullptr;
-    } else {
-        {
-            std::unique_ptr<FontFace> fontFace = std::make_unique<FontFace>(_texHeap.get(), _texture.get(), _texWidth, _texHeight);
-            fontFace->_face = face;
-            fontFace->_size = size;
-            _faceList.insert(_faceList.begin(), std::move(fontFace));
-        }
+    RasterRequest request;
+    request._face = i->second;
+    request._ch = ch;
+    request._glyph = id;
+    request._generation = glyph._generation;
+    pimpl.QueueRasterRequest(std::move(request));
 
-        int maxCount = _texWidth / (face->size->metrics.max_advance / 64);
-        CharSlotArray* newSlot = (*_faceList.begin())->_slotList.insert(
-            (*_faceList.begin())->_slotList.begin(), 
-            _texHeap->CreateCharSlotArray(size, maxCount))->get();
-
-        ClearFontTextureRegion(newSlot->GetSlotHeight(), newSlot->GetSlotHeightEnd());
-        return _faceList.begin()->get();
-    }
+    return id;
 }
 
-FontCharID FT_FontTextureMgr::FontFace::FindEmptyCharSlot(const FontChar& fc, int *x, int *y, FontTexKind kind)
+std::pair<const FontChar*, const FontTexture2D*> FT_FontTextureMgr::FontFace::GetChar(int ch, FontTexKind kind)
 {
-    CharSlotArray *slot = NULL;
-    unsigned slotIndex = ~unsigned(0x0);
-    CharSlotArrayList::iterator slotIter = _slotList.begin();
-    for( ; slotIter != _slotList.end(); ++slotIter) {
-        CharSlotArray *cursor = (*slotIter).get();
-        if(!cursor->IsFull()) {
-            slot = cursor;
-            slotIndex = (unsigned)std::distance(_slotList.begin(), slotIter);
-            break;
-        }
-    }
+    _mgr->ProcessCompletedGlyphs();
 
-    if(!slot) {
-        if(!_texHeap->IsAllocable(_size)) {
-            // slot = OverwriteLRUChar(*this, kind);
-            // if(!slot) {
-            //     // all character used current frame, will be reset
-            //     return false;
-            // }
-            return FontCharID_Invalid;
-        } else {
-            int maxCount = _texWidth / (_face->size->metrics.max_advance / 64);
-                // DavidJ -- note --    we have to add on to the back here. The _table member of
-                //                      FontFace keeps indices into the _slotList array. So we can't
-                //                      change the position of existing slot arrays
-            _slotList.push_back(_texHeap->CreateCharSlotArray(_size, maxCount));
-            slotIndex = unsigned(_slotList.size()-1);
-            slot = _slotList[slotIndex].get();
-
-            // ClearFontTextureRegion(slot->GetSlotHeight(), slot->GetSlotHeightEnd());
-        }
+    auto& pimpl = *_mgr->_pimpl;
+    FontCharID& id = _table[ch];
+    if (id == FontCharID_Invalid) {
+        id = CreateChar(ch, kind);
+        ++pimpl._misses;
+        if (id == FontCharID_Invalid)
+            return std::pair<const FontChar*, const FontTexture2D*>(nullptr, nullptr);
+    } else {
+        ++pimpl._hits;
     }
 
-    FontCharID result = slot->UseEmptySlot(fc);
-    if (result != FontCharID_Invalid) {
-        FontChar* newChar = slot->GetChar(result);
-        int offsetX = result * (_face->size->metrics.max_advance / 64);
-        int offsetY = slot->GetSlotHeight();
-        newChar->u0 = (float)offsetX / _texWidth;
-        newChar->v0 = (float)offsetY / _texHeight;
-        newChar->u1 = (float)(offsetX + _face->glyph->bitmap.width) / _texWidth;
-        newChar->v1 = (float)(offsetY + _face->glyph->bitmap.rows) / _texHeight;
-        newChar->offsetX = offsetX;
-        newChar->offsetY = offsetY;
-
-        *x = offsetX;
-        *y = offsetY;
-
-        return (result & 0xffff) | (slotIndex << 16);
-    }
+    auto& glyph = pimpl._glyphs[id];
+    assert(glyph._fc.ch == ch && glyph._face == this);
+    pimpl.TouchLRU(id);
 
-    return FontCharID_Invalid;
+    const FontTexture2D* texture = nullptr;
+    if (glyph._page != ~0u)
+        texture = pimpl._pages[glyph._page]._texture.get();
+    return std::make_pair(&glyph._fc, texture);
 }
 
-FT_FontTextureMgr::FontFace::FontFace(TextureHeap* texHeap, FontTexture2D* texture, int texWidth, int texHeight)
-: _texHeap(texHeap), _texture(texture), _texWidth(texWidth), _texHeight(texHeight)
+void FT_FontTextureMgr::FontFace::DeleteChar(FontCharID fc)
 {
+    if (fc < _mgr->_pimpl->_glyphs.size() && _mgr->_pimpl->_glyphs[fc]._face == this)
+        _mgr->ReleaseGlyph(fc);
 }
 
-CharSlotArray* FT_FontTextureMgr::OverwriteLRUChar(FontFace* face, FontTexKind kind)
+FT_FontTextureMgr::FontFace::FontFace(FT_FontTextureMgr& mgr, FT_Face face, int size)
+: _mgr(&mgr), _face(face), _size(size)
 {
-    CharSlotArrayList::iterator it = face->_slotList.begin();
-
-    CharSlotArray* minSlot = (*it).get();
-    const FontChar* minChar = minSlot->GetLeastUsedChar();
+}
 
-    ++it;
+FT_FontTextureMgr::FontFace::~FontFace()
+{
+    auto& pimpl = *_mgr->_pimpl;
+    for (unsigned g=0; g<unsigned(pimpl._glyphs.size()); ++g)
+        if (pimpl._glyphs[g]._face == this) {
+            pimpl._glyphs[g]._face = nullptr;      // (avoid writing back into our _table)
+            _mgr->ReleaseGlyph(FontCharID(g));
+        }
 
-    for( ; it != face->_slotList.end(); ++it) {        
-        CharSlotArray* curSlot = (*it).get();
-        const FontChar* curChar = curSlot->GetLeastUsedChar();
-        if (minChar && curChar) {
-            if (minChar->usedTime > curChar->usedTime) {
-                minSlot = curSlot;
-                minChar = curChar;
+        //  Destroy the raster thread's copy of the face. This must happen before the
+        //  font file buffer is released. If the raster thread is currently using the 
+        //  face, we will stall here until it's finished
+    auto i = std::find_if(
+        pimpl._rasterFaces.begin(), pimpl._rasterFaces.end(),
+        [this](const std::pair<FontFace*, std::shared_ptr<GlyphRasterFace>>& p) { return p.first == this; });
+    if (i != pimpl._rasterFaces.end()) {
+        {
+            ScopedLock(pimpl._freetypeLock);
+            if (i->second->_face) {
+                FT_Done_Face(i->second->_face);
+                i->second->_face = nullptr;
             }
-        } else if (!minChar) {
-            minSlot = curSlot;
-            minChar = curChar;
         }
+        pimpl._rasterFaces.erase(i);
     }
-
-    assert(minChar);
-
-    // float minTime = minChar->usedTime;
-    // if(minTime - 0.001f <= desktop.time && desktop.time <= minTime + 0.001f) {
-    //     // all character is used current time, will be reset
-    //     return NULL;
-    // }
-
-    // if(RequestSacrificeChar(face->_face, minChar->ch, kind)) {
-    //     return minSlot;
-    // }
-
-    //cannot be reached
-    // GameWarning("OverwriteLRUChar - cannot be reached");
-    return NULL;
 }
 
-void FT_FontTextureMgr::ClearFontTextureRegion(int height, int heightEnd)
+FT_FontTextureMgr::FontFace* FT_FontTextureMgr::FindFontFace(FT_Face face, int size)
 {
-    int texHeight = heightEnd - height;
-    if(texHeight <= 0) {
-        return;
-    }
-
-    if(heightEnd > _texHeight) {
-        return;
+    auto it = _faceList.begin();
+    for( ; it != _faceList.end(); ++it) {
+        if((*it)->_face == face && (*it)->_size == size)
+            return (*it).get();
     }
 
-    auto blankBuf = BufferUploads::CreateBasicPacket(_texWidth * texHeight, nullptr, BufferUploads::TexturePitches(_texWidth, _texWidth*texHeight));
-    XlSetMemory(const_cast<void*>(blankBuf->GetData()), 0, _texWidth * texHeight);
-    _texture->UpdateToTexture(blankBuf.get(), 0, height, _texWidth, texHeight);
+    return NULL;
 }
 
-void FT_FontTextureMgr::FontFace::DeleteChar(FontCharID fc)
+auto FT_FontTextureMgr::CreateFontFace(FT_Face face, int size) -> FontFace*
 {
-    unsigned slotIndex = fc >> 16;
-    if (slotIndex < _slotList.size()) {
-        CharSlotArray* slot = _slotList[slotIndex].get();
-        slot->ReleaseSlot(fc & 0xffff);
-    }
-}
+    if (!_pimpl->_rasterLibrary) return nullptr;
 
-const FontChar* FT_FontTextureMgr::FontFace::GetChar(int ch, FontTexKind kind)
-{
-    FontCharID& id = _table[ch];
-    if (id == FontCharID_Invalid) {
-        id = CreateChar(ch, kind);
+        //  The raster thread gets a separate FT_Face, created from the same
+        //  memory buffer (faces created with FT_New_Memory_Face keep a pointer to
+        //  their buffer in the stream)
+    auto rasterFace = std::make_shared<GlyphRasterFace>();
+    rasterFace->_face = nullptr;
+    {
+        ScopedLock(_pimpl->_freetypeLock);
+        FT_Error error = FT_New_Memory_Face(
+            _pimpl->_rasterLibrary, face->stream->base, (FT_Long)face->stream->size, 
+            face->face_index, &rasterFace->_face);
+        if (error) return nullptr;
+        FT_Set_Pixel_Sizes(rasterFace->_face, 0, size);
     }
 
-    unsigned slotIndex = id >> 16;
-    if (slotIndex < _slotList.size()) {
-        auto* result = _slotList[slotIndex]->GetChar(id & 0xffff);
-        assert(result->ch == ch);
-        return result;
-    }
-    return NULL;
+    auto fontFace = std::make_unique<FontFace>(*this, face, size);
+    _pimpl->_rasterFaces.push_back(std::make_pair(fontFace.get(), std::move(rasterFace)));
+    _faceList.insert(_faceList.begin(), std::move(fontFace));
+    return _faceList.begin()->get();
 }
 
 void FT_FontTextureMgr::DeleteFontFace(FTFont* font)
 {
     FontFace *face = FindFontFace(font->GetFace(), font->GetSize());
     if(face) {
-        CharSlotArrayList::iterator it = face->_slotList.begin();
-        for( ; it != face->_slotList.end(); ++it) {
-            _texHeap->DestroyCharSlotArray((*it).get());
-        }
-
             //
             //      operator==( std::unique_ptr<A>, A* ) comparison is not defined
             //      So we need to use a lambda to explicitly do the comparison
             //
         _faceList.erase(
             std::remove_if(_faceList.begin(), _faceList.end(), 
-                [=](FontFaceList::value_type& it) { return it.get() == face; }));
+                [=](FontFaceList::value_type& it) { return it.get() == face; }),
+            _faceList.end());
     }
 }
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "FontPrimitives.h"
+#include "../Utility/UTFUtils.h"
 #include <vector>
 #include <memory>
 
@@ -16,11 +17,23 @@ namespace RenderOverlays
 struct FontChar;
 
 class FTFont;
-class CharSlotArray;
-class TextureHeap;
-
 class FontTexture2D;
-
+class FontCacheMetrics;
+
+/// <summary>Glyph cache for freetype fonts</summary>
+/// Glyphs from all font faces are packed into a shared atlas made up of one or
+/// more texture pages (packed with RectanglePacker_Guillotine). New pages are added 
+/// as required, up to a fixed maximum. After that, glyphs that haven't been used
+/// recently are evicted to make space. Glyphs are kept in an LRU list, so finding
+/// eviction candidates is cheap.
+///
+/// The glyph metrics required for layout (ie, the advance) are calculated immediately
+/// when a glyph is first requested. But the glyph bitmap is rasterised on a background
+/// thread. Until the bitmap is ready, the glyph will draw as an empty quad.
+/// Completed glyphs are written into a CPU side copy of the page, and the dirty
+/// region of each page is uploaded as a single BufferUploads update.
+///
+/// Call OnFrameBarrier() once per frame (see CheckResetFontSystem()).
 class FT_FontTextureMgr
 {
 public:
@@ -31,7 +44,10 @@ public:
     void            RequestReset();
     void            Reset();
 
-    typedef std::vector<std::unique_ptr<CharSlotArray>> CharSlotArrayList;
+    void            OnFrameBarrier();
+    void            GetMetrics(FontCacheMetrics& metrics) const;
+    uint64          GetChangeStamp() const;
+
     struct FontCharTable
     {
         std::vector<std::vector<std::pair<ucs4, FontCharID> > >  _table;
@@ -44,25 +60,21 @@ public:
     class FontFace
     {
     public:
-        const FontChar*     GetChar(int ch, FontTexKind kind);
+        std::pair<const FontChar*, const FontTexture2D*> GetChar(int ch, FontTexKind kind);
         FontCharID          CreateChar(int ch, FontTexKind kind);
         void                DeleteChar(FontCharID fc);
-        const FontTexture2D*    GetTexture() const { return _texture; }
 
-        FontFace(TextureHeap* texHeap, FontTexture2D* texture, int texWidth, int texHeight);
-    
-        CharSlotArrayList   _slotList;
+        FontFace(FT_FontTextureMgr& mgr, FT_Face face, int size);
+        ~FontFace();
+
         FT_Face             _face;
         int                 _size;
 
     private:
         FontCharTable       _table;
+        FT_FontTextureMgr*  _mgr;
 
-        int                 _texWidth, _texHeight;
-        TextureHeap *       _texHeap;
-        FontTexture2D *     _texture;
-
-        FontCharID          FindEmptyCharSlot(const FontChar& fc, int *x, int *y, FontTexKind kind);
+        friend class FT_FontTextureMgr;
     };
 
     FontFace*       FindFontFace(FT_Face face, int size);
@@ -74,15 +86,14 @@ public:
 
 private:
     typedef std::vector<std::unique_ptr<FontFace>> FontFaceList;
+    FontFaceList    _faceList;
+    bool            _needReset;
 
-    CharSlotArray*      OverwriteLRUChar(FontFace* face, FontTexKind kind);
-    void                ClearFontTextureRegion(int height, int heightEnd);
+    class Pimpl;
+    std::unique_ptr<Pimpl> _pimpl;
 
-    int                             _texWidth, _texHeight;
-    FontFaceList                    _faceList;
-    std::unique_ptr<TextureHeap>    _texHeap;
-    std::unique_ptr<FontTexture2D>  _texture;
-    bool                            _needReset;
+    void            ReleaseGlyph(FontCharID glyph);
+    void            ProcessCompletedGlyphs();
 };
 
 }
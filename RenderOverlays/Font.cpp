@@ -7,14 +7,18 @@
 #include "Font.h"
 #include "FT_Font.h"
 #include <assert.h>
+#include <atomic>
 
 namespace RenderOverlays
 {
 
+static std::atomic<uint64> s_nextFontId(1);
+
 Font::Font()
 {
     _path[0] = 0;
     _size = 0;
+    _id = s_nextFontId++;
 }
 
 Font::~Font()
@@ -283,6 +287,26 @@ void CheckResetFontSystem()
     CheckResetFTFontSystem();
 }
 
+FontCacheMetrics GetFontCacheMetrics()
+{
+    FontCacheMetrics result;
+    GetFTFontCacheMetrics(result);
+    return result;
+}
+
+uint64 GetFontCacheStamp()
+{
+    return GetFTFontCacheStamp();
+}
+
+void PrewarmFont(const Font& font, const ucs4 text[], int maxLen)
+{
+        //  Request each glyph in the string, so they will be queued for rasterisation
+        //  before they are first drawn
+    for (int c=0; (maxLen < 0 || c < maxLen) && text[c]; ++c)
+        font.GetChar(text[c]);
+}
+
 int GetFontCount(FontTexKind kind)
 {
     switch (kind) {
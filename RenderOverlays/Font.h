@@ -15,6 +15,8 @@
 #include "../Utility/UTFUtils.h"
 #include "../Core/Prefix.h"
 #include "../Core/Types.h"
+#include <vector>
+#include <memory>
 
 namespace RenderOverlays
 {
@@ -48,6 +50,7 @@ namespace RenderOverlays
 
         int GetSize()           { return _size; }
         const char* GetPath()   { return _path; }
+        uint64 GetId() const    { return _id; }     // unique for the lifetime of the process (never reused)
 
         virtual std::pair<const FontChar*, const FontTexture2D*> GetChar(ucs4 ch) const = 0;
         float StringWidth(      const ucs4* text,
@@ -87,11 +90,33 @@ namespace RenderOverlays
     
         char    _path[MaxPath];
         int     _size;
+
+    private:
+        uint64  _id;
+    };
+
+    /// <summary>Statistics for the glyph cache</summary>
+    /// Counts accumulate from startup. Rasterisation time is in milliseconds.
+    /// _generation changes whenever a glyph in the cache is updated or released
+    /// (so anything holding on to glyph texture coordinates should be rebuilt).
+    class FontCacheMetrics
+    {
+    public:
+        uint64 _hits, _misses, _evictions;
+        uint64 _rasterisedCount;
+        float _rasterisationTime;
+        unsigned _pendingCount, _glyphCount, _pageCount;
+        uint64 _generation;
+
+        FontCacheMetrics() : _hits(0), _misses(0), _evictions(0), _rasterisedCount(0), _rasterisationTime(0.f), _pendingCount(0), _glyphCount(0), _pageCount(0), _generation(0) {}
     };
 
     bool InitFontSystem(RenderCore::IDevice* device, BufferUploads::IManager* bufferUploads);
     void CleanupFontSystem();
     void CheckResetFontSystem();
+    FontCacheMetrics GetFontCacheMetrics();
+    uint64 GetFontCacheStamp();     ///< changes every frame, and whenever a glyph in the cache is updated or released
+    void PrewarmFont(const Font& font, const ucs4 text[], int maxLen = -1);
     int GetFontCount(FontTexKind kind);
     int GetFontFileCount();
 
@@ -140,6 +165,37 @@ namespace RenderOverlays
         UI_TEXT_STATE_INACTIVE_REVERSE, 
     };
 
+    /// <summary>Precalculated glyph quads for a string</summary>
+    /// Positions are relative to the (snapped) origin of the string. Glyphs without a
+    /// texture (whitespace, or glyphs still being rasterised) are included so that
+    /// clipping behaves the same as drawing glyph by glyph.
+    class TextLayout
+    {
+    public:
+        class Glyph
+        {
+        public:
+            Quad                    _position;
+            Quad                    _texCoords;
+            float                   _cursorX;           // cursor position before this glyph
+            unsigned                _colorOverride;     // ARGB from a {Color:} tag, or 0
+            const FontTexture2D*    _texture;
+            ucs4                    _ch;
+            Quad                    _glyphRect;         // FontChar left, top, width, height at build time
+        };
+        std::vector<Glyph>  _glyphs;
+        float               _endX;
+        float               _stringWidth;               // same as Font::StringWidth(text, maxLen)
+    };
+
+    /// <summary>Receives the quads generated by TextStyle::DrawLayout</summary>
+    class ITextQuadSink
+    {
+    public:
+        virtual void PushQuad(const FontTexture2D& texture, const Quad& position, unsigned colorABGR, const Quad& texCoords, float depth) = 0;
+        virtual ~ITextQuadSink();
+    };
+
     class TextStyle
     {
     public:
@@ -154,6 +210,14 @@ namespace RenderOverlays
                             float spaceExtra, float scale, float mx, float depth,
                             unsigned colorARGB, UI_TEXT_STATE textState, bool applyDescender, Quad* q) const;
 
+        std::shared_ptr<const TextLayout> GetLayout(
+                            const ucs4 text[], int maxLen,
+                            float spaceExtra, float scale, bool applyDescender) const;
+        float       DrawLayout(
+                            ITextQuadSink& sink, const TextLayout& layout,
+                            float x, float y, float scale, float mx, float depth,
+                            unsigned colorARGB, Quad* q) const;
+
         Float2     AlignText(const Quad& q, UiAlign align, const ucs4* text, int maxLen = -1);
         Float2     AlignText(const Quad& q, UiAlign align, float width, float indent);
         float       StringWidth(const ucs4* text, int maxlen = -1);
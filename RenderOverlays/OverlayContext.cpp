@@ -6,6 +6,7 @@
 
 #include "OverlayContext.h"
 #include "Font.h"
+#include "FontRendering.h"
 #include "../RenderCore/Metal/DeviceContext.h"
 #include "../RenderCore/Metal/DeviceContextImpl.h"
 #include "../RenderCore/Metal/Buffer.h"
@@ -286,15 +287,52 @@ namespace RenderOverlays
         }
     }
 
+        //
+        //      Text quads are written into the same working buffer as all other
+        //      geometry (instead of drawing immediately with TextStyle::Draw). So
+        //      all of the text for a frame is submitted in one vertex buffer, and
+        //      ordering relative to other primitives is preserved.
+        //
+    class ImmediateOverlayContext::TextQuadSink : public ITextQuadSink
+    {
+    public:
+        void PushQuad(const FontTexture2D& texture, const Quad& position, unsigned colorABGR, const Quad& texCoords, float depth)
+        {
+            typedef Vertex_PCT Vertex;
+            auto& context = *_context;
+            if ((context._writePointer + 6 * sizeof(Vertex)) > context._workingBufferSize) {
+                context.Flush();
+            }
+
+            context.PushDrawCall(DrawCall(
+                unsigned(Metal::Topology::TriangleList), context._writePointer, 6, 
+                context.AsVertexFormat<Vertex>(), ProjectionMode::P2D, 
+                "basic.psh:PCT_Text", std::string(), &texture));
+
+                // (same vertex order as WorkingVertexSetPCT::PushQuad, with pixel snapping)
+            Float3 p0((float)(int)(0.5f + position.min[0]), (float)(int)(0.5f + position.min[1]), depth);
+            Float3 p1((float)(int)(0.5f + position.max[0]), (float)(int)(0.5f + position.min[1]), depth);
+            Float3 p2((float)(int)(0.5f + position.min[0]), (float)(int)(0.5f + position.max[1]), depth);
+            Float3 p3((float)(int)(0.5f + position.max[0]), (float)(int)(0.5f + position.max[1]), depth);
+
+            auto* dst = (Vertex*)&context._workingBuffer.get()[context._writePointer];
+            dst[0] = Vertex(p0, colorABGR, Float2(texCoords.min[0], texCoords.min[1]));
+            dst[1] = Vertex(p2, colorABGR, Float2(texCoords.min[0], texCoords.max[1]));
+            dst[2] = Vertex(p1, colorABGR, Float2(texCoords.max[0], texCoords.min[1]));
+            dst[3] = Vertex(p1, colorABGR, Float2(texCoords.max[0], texCoords.min[1]));
+            dst[4] = Vertex(p2, colorABGR, Float2(texCoords.min[0], texCoords.max[1]));
+            dst[5] = Vertex(p3, colorABGR, Float2(texCoords.max[0], texCoords.max[1]));
+            context._writePointer += 6 * sizeof(Vertex);
+        }
+
+        TextQuadSink(ImmediateOverlayContext& context) : _context(&context) {}
+    private:
+        ImmediateOverlayContext* _context;
+    };
+
     float ImmediateOverlayContext::DrawText      (  const std::tuple<Float3, Float3>& quad, TextStyle* textStyle, ColorB col, 
                                                     TextAlignment::Enum alignment, const char text[], va_list args)
     {
-            //
-            //      Because _textStyle.Draw() will draw immediately, we need to flush out
-            //      any pending draws
-            //
-        Flush();
-
         ucs4 unicharBuffer[4096];
 
         utf8 buffer[dimof(unicharBuffer)];
@@ -315,14 +353,17 @@ namespace RenderOverlays
         Quad q;
         q.min = Float2(std::get<0>(quad)[0], std::get<0>(quad)[1]);
         q.max = Float2(std::get<1>(quad)[0], std::get<1>(quad)[1]);
+
+            //  (AlignText and GetLayout share the same cached layout)
         Float2 alignedPosition = textStyle->AlignText(q, AsUiAlign(alignment), unicharBuffer);
-        return textStyle->Draw(
-            _metalContext.get(), 
-            alignedPosition[0], alignedPosition[1],
-            unicharBuffer, dimof(unicharBuffer),
-            0.f, 1.f, 0.f, 
+        auto layout = textStyle->GetLayout(unicharBuffer, dimof(unicharBuffer), 0.f, 1.f, true);
+
+        TextQuadSink sink(*this);
+        return textStyle->DrawLayout(
+            sink, *layout,
+            alignedPosition[0], alignedPosition[1], 1.f, 0.f, 
             LinearInterpolate(std::get<0>(quad)[2], std::get<1>(quad)[2], 0.5f),
-            col.AsUInt32(), UI_TEXT_STATE_NORMAL, true, nullptr); // &q);
+            col.AsUInt32(), nullptr);
     }
 
     float ImmediateOverlayContext::StringWidth    (float scale, TextStyle* textStyle, const char text[], va_list args)
@@ -392,7 +433,20 @@ namespace RenderOverlays
     {
         if (_writePointer != 0) {
 			Metal::VertexBuffer temporaryBuffer(_workingBuffer.get(), _writePointer);
+            bool depthDisabled = false;
             for (auto i=_drawCalls.cbegin(); i!=_drawCalls.cend(); ++i) {
+                    //  Text is drawn with the depth test disabled (glyph quads overlap
+                    //  their shadows at the same depth)
+                void* fontTexture = nullptr;
+                if (i->_fontTexture) {
+                    fontTexture = i->_fontTexture->GetUnderlying();
+                    if (!fontTexture) continue;     // texture is still pending
+                }
+                if (bool(i->_fontTexture) != depthDisabled) {
+                    depthDisabled = bool(i->_fontTexture);
+                    _metalContext->Bind(depthDisabled ? Techniques::CommonResources()._dssDisable : Techniques::CommonResources()._dssReadWrite);
+                }
+
                 _metalContext->Bind((Metal::Topology::Enum)i->_topology);
 
                     //
@@ -416,9 +470,16 @@ namespace RenderOverlays
                 if (!i->_textureName.empty()) {
                     _metalContext->BindPS(MakeResourceList(
                         ::Assets::GetAssetDep<RenderCore::Assets::DeferredShaderResource>(i->_textureName.c_str()).GetShaderResource()));
+                } else if (fontTexture) {
+                    Metal::ShaderResourceView shadRes((Metal::ShaderResourceView::UnderlyingResource)fontTexture);
+                    _metalContext->BindPS(MakeResourceList(shadRes));
                 }
                 _metalContext->Draw(i->_vertexCount);
             }
+
+            if (depthDisabled) {
+                _metalContext->Bind(Techniques::CommonResources()._dssReadWrite);
+            }
         }
 
         _drawCalls.clear();
@@ -445,6 +506,7 @@ namespace RenderOverlays
                 &&  prevCall._vertexFormat == drawCall._vertexFormat
                 &&  prevCall._pixelShaderName == drawCall._pixelShaderName
                 &&  prevCall._textureName == drawCall._textureName
+                &&  prevCall._fontTexture == drawCall._fontTexture
                 &&  (prevCall._vertexOffset + prevCall._vertexCount * VertexSize(prevCall._vertexFormat)) == drawCall._vertexOffset) {
                 prevCall._vertexCount += drawCall._vertexCount;
                 return;
@@ -633,7 +695,7 @@ namespace RenderOverlays
     , _projDesc(projDesc)
     , _deviceContext(threadContext)
     {
-		_workingBufferSize = 16 * 1024;
+		_workingBufferSize = 128 * 1024;
 		_workingBuffer = std::make_unique<uint8[]>(_workingBufferSize);
         _metalContext = Metal::DeviceContext::Get(*_deviceContext);
 
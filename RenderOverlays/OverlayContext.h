@@ -100,16 +100,20 @@ namespace RenderOverlays
             std::string     _pixelShaderName;
             std::string     _textureName;
             ProjectionMode::Enum  _projMode;
+            const FontTexture2D* _fontTexture;
 
             DrawCall(   unsigned topology, unsigned vertexOffset, 
                         unsigned vertexCount, VertexFormat format, ProjectionMode::Enum projMode, 
                         const std::string& pixelShaderName = std::string(),
-                        const std::string& textureName = std::string()) 
+                        const std::string& textureName = std::string(),
+                        const FontTexture2D* fontTexture = nullptr) 
                 : _topology(topology), _vertexOffset(vertexOffset), _vertexCount(vertexCount)
                 , _vertexFormat(format), _pixelShaderName(pixelShaderName), _projMode(projMode)
-                , _textureName(textureName) {}
+                , _textureName(textureName), _fontTexture(fontTexture) {}
         };
 
+        class TextQuadSink;
+
         std::vector<DrawCall>   _drawCalls;
         void                    Flush();
         void                    SetShader(unsigned topology, VertexFormat format, ProjectionMode::Enum projMode, const std::string& pixelShaderName);
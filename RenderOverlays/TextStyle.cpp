@@ -11,6 +11,9 @@
 #include "../Utility/MemoryUtils.h"
 #include "../Utility/StringUtils.h"
 #include "../Utility/PtrUtils.h"
+#include "../Utility/IteratorUtils.h"
+#include "../Utility/Threading/Mutex.h"
+#include "../ConsoleRig/Console.h"
 #include "../Math/Vector.h"
 #include "../Core/Exceptions.h"
 #include <initializer_list>
@@ -225,6 +228,328 @@ TextStyleResources::TextStyleResources(const Desc& desc)
 TextStyleResources::~TextStyleResources()
 {}
 
+ITextQuadSink::~ITextQuadSink() {}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    //  Cache of TextLayout objects, keyed on the string contents, the font and the layout
+    //  parameters. Most of the strings drawn each frame (particularly by debugging
+    //  displays) are the same as the previous frame, so we can skip the kerning and
+    //  layout calculations for them.
+    //  The first hit on a layout in each frame looks up each glyph in the glyph cache
+    //  again. This marks the glyph as used this frame (so the glyph cache won't evict it
+    //  while quads for it are queued) and lets us detect glyphs that have been rasterised,
+    //  moved or evicted since the layout was built. Only layouts with changed glyphs are
+    //  rebuilt. Later hits in the same frame skip this, unless the glyph cache has changed
+    //  in the meantime (see GetFontCacheStamp()).
+class TextLayoutCache
+{
+public:
+    class Entry
+    {
+    public:
+        std::vector<ucs4>                   _text;
+        std::shared_ptr<const TextLayout>   _layout;
+        unsigned                            _lastUsed;
+        uint64                              _validatedStamp;
+    };
+
+    Threading::Mutex                        _lock;
+    std::vector<std::pair<uint64, Entry>>   _entries;
+    unsigned                                _lookupCounter;
+
+        //  The "TextLayoutCache" tweakable is only read when the font cache stamp
+        //  changes (ie, at most a few times a frame)
+    uint64                                  _stamp;
+    bool                                    _enabled;
+
+    static const unsigned MaxEntries = 2048;
+
+    TextLayoutCache() : _lookupCounter(0), _stamp(~uint64(0)), _enabled(true) {}
+};
+
+static TextLayoutCache s_textLayoutCache;
+
+static void BuildTextLayout(
+    TextLayout& layout, Font& font, const DrawTextOptions& options,
+    const ucs4 text[], unsigned textLength,
+    float spaceExtra, float scale, bool applyDescender)
+{
+    int prevGlyph = 0;
+    float xScale = scale;
+    float yScale = scale;
+    float x = 0.f, y = 0.f;
+
+    float descent = 0.0f;
+    if (applyDescender) {
+        descent = font.Descent();
+    }
+
+    unsigned colorOverride = 0x0;
+    layout._glyphs.clear();
+    layout._glyphs.reserve(textLength);
+    for (unsigned i = 0; i < textLength; ++i) {
+        ucs4 ch = text[i];
+        if (ch == '\n' || ch == '\r') continue;
+
+        float cursorX = x;
+        if (!XlComparePrefixI((ucs4*)"{\0\0\0C\0\0\0o\0\0\0l\0\0\0o\0\0\0r\0\0\0:\0\0\0", &text[i], 7)) {
+            unsigned newColorOverride = 0;
+            unsigned parseLength = ParseColorValue(&text[i+7], &newColorOverride);
+            if (parseLength) {
+                colorOverride = newColorOverride;
+                i += 7 + parseLength;
+                while (i<textLength && text[i] != '}') ++i;
+                continue;
+            }
+        }
+
+        int curGlyph;
+        Float2 v = font.GetKerning(prevGlyph, ch, &curGlyph);
+        x += xScale * v[0];
+        y += yScale * v[1];
+        prevGlyph = curGlyph;
+
+        std::pair<const FontChar*, const FontTexture2D*> charAndTexture = font.GetChar(ch);
+        const FontChar* fc = charAndTexture.first;
+        if (!fc) continue;
+
+            //  Snapping is done relative to the origin of the string. Since the 
+            //  origin is also snapped, this gives the same result as snapping the
+            //  final position
+        float baseX = x + fc->left * xScale;
+        float baseY = y - (fc->top + descent) * yScale;
+        if (options.snap) {
+            baseX = xScale * (int)(0.5f + baseX / xScale);
+            baseY = yScale * (int)(0.5f + baseY / yScale);
+        }
+
+        TextLayout::Glyph glyph;
+        glyph._position = Quad::MinMax(baseX, baseY, baseX + fc->width * xScale, baseY + fc->height * yScale);
+        glyph._texCoords = Quad::MinMax(fc->u0, fc->v0, fc->u1, fc->v1);
+        glyph._cursorX = cursorX;
+        glyph._colorOverride = colorOverride;
+        glyph._texture = charAndTexture.second;
+        glyph._ch = ch;
+        glyph._glyphRect = Quad::MinMax(fc->left, fc->top, fc->left + fc->width, fc->top + fc->height);
+        layout._glyphs.push_back(glyph);
+
+        x += fc->xAdvance * xScale;
+        if (options.outline) {
+            x += 2 * xScale;
+        }
+        if (ch == ' ') {
+            x += spaceExtra;
+        }
+    }
+
+    layout._endX = x;
+    layout._stringWidth = font.StringWidth(text, textLength);
+}
+
+static bool TouchTextLayout(const TextLayout& layout, const Font& font)
+{
+        //  Look up every glyph again (marking it as used in the glyph cache), and check
+        //  that the glyph texture and metrics still match the layout
+    for (const auto& g:layout._glyphs) {
+        auto charAndTexture = font.GetChar(g._ch);
+        const FontChar* fc = charAndTexture.first;
+        if (    !fc || charAndTexture.second != g._texture
+            ||  Quad::MinMax(fc->u0, fc->v0, fc->u1, fc->v1) != g._texCoords
+            ||  Quad::MinMax(fc->left, fc->top, fc->left + fc->width, fc->top + fc->height) != g._glyphRect)
+            return false;
+    }
+    return true;
+}
+
+auto TextStyle::GetLayout(
+    const ucs4 text[], int maxLen,
+    float spaceExtra, float scale, bool applyDescender) const -> std::shared_ptr<const TextLayout>
+{
+    unsigned textLength = 0;
+    if (text)
+        while (textLength < (uint32)maxLen && text[textLength]) ++textLength;
+
+    uint32 params[4];
+    params[0] = uint32(_options.snap) | (uint32(_options.outline) << 1) | (uint32(applyDescender) << 2);
+    XlCopyMemory(&params[1], &spaceExtra, sizeof(float));
+    XlCopyMemory(&params[2], &scale, sizeof(float));
+    params[3] = 0;
+    uint64 hash = Hash64(text, PtrAdd(text, textLength * sizeof(ucs4)));
+    hash = HashCombine(hash, Hash64(params, PtrAdd(params, sizeof(params)), _font->GetId()));
+
+    auto stamp = GetFontCacheStamp();
+    auto& cache = s_textLayoutCache;
+    ScopedLock(cache._lock);
+
+    if (stamp != cache._stamp) {
+        cache._stamp = stamp;
+        cache._enabled = Tweakable("TextLayoutCache", true);
+    }
+
+    if (!cache._enabled) {
+        auto layout = std::make_shared<TextLayout>();
+        BuildTextLayout(*layout, *_font, _options, text, textLength, spaceExtra, scale, applyDescender);
+        return std::move(layout);
+    }
+
+    ++cache._lookupCounter;
+    auto i = LowerBound(cache._entries, hash);
+    if (    i != cache._entries.end() && i->first == hash
+        &&  i->second._text.size() == textLength
+        &&  std::equal(text, text + textLength, i->second._text.begin())) {
+
+            //  Touch the glyphs once per frame (or again if the glyph cache has
+            //  changed since we last checked this layout)
+        if (    i->second._validatedStamp == stamp
+            ||  TouchTextLayout(*i->second._layout, *_font)) {
+            i->second._validatedStamp = stamp;
+            i->second._lastUsed = cache._lookupCounter;
+            return i->second._layout;
+        }
+    }
+
+    auto layout = std::make_shared<TextLayout>();
+    BuildTextLayout(*layout, *_font, _options, text, textLength, spaceExtra, scale, applyDescender);
+
+    if (cache._entries.size() >= TextLayoutCache::MaxEntries) {
+            // remove the least recently used half of the entries (preserving sorted order)
+        auto threshold = cache._lookupCounter - TextLayoutCache::MaxEntries/2;
+        cache._entries.erase(
+            std::remove_if(cache._entries.begin(), cache._entries.end(),
+                [threshold](const std::pair<uint64, TextLayoutCache::Entry>& e) { return e.second._lastUsed < threshold; }),
+            cache._entries.end());
+        i = LowerBound(cache._entries, hash);
+    }
+
+    TextLayoutCache::Entry newEntry;
+    newEntry._text = std::vector<ucs4>(text, text + textLength);
+    newEntry._layout = layout;
+    newEntry._lastUsed = cache._lookupCounter;
+    newEntry._validatedStamp = stamp;
+    if (i != cache._entries.end() && i->first == hash) {
+        i->second = std::move(newEntry);     // (hash collision, replace the old entry)
+    } else {
+        cache._entries.insert(i, std::make_pair(hash, std::move(newEntry)));
+    }
+    return std::move(layout);
+}
+
+float TextStyle::DrawLayout(
+    ITextQuadSink& sink, const TextLayout& layout,
+    float x, float y, float scale, float mx, float depth,
+    unsigned colorARGB, Quad* q) const
+{
+    float xScale = scale;
+    float yScale = scale;
+
+    if (_options.snap) {
+        x = xScale * (int)(0.5f + x / xScale);
+        y = yScale * (int)(0.5f + y / yScale);
+    }
+
+    float opacity = (colorARGB >> 24) / float(0xff);
+    unsigned shadowColor = RGBA8(Color4::Create(0, 0, 0, opacity));
+
+    static const Float2 outlineOffsets[] = 
+    {
+        Float2(-1.f, -1.f), Float2( 0.f, -1.f), Float2( 1.f, -1.f), Float2(-1.f,  0.f),
+        Float2( 1.f,  0.f), Float2(-1.f,  1.f), Float2( 0.f,  1.f), Float2( 1.f,  1.f)
+    };
+
+    bool firstQuad = true;
+    for (const auto& glyph:layout._glyphs) {
+        if (mx > 0.0f && (x + glyph._cursorX) > mx) {
+            return x + glyph._cursorX;
+        }
+
+        if (!glyph._texture) continue;
+
+        Quad pos = Quad::MinMax(
+            glyph._position.min[0] + x, glyph._position.min[1] + y,
+            glyph._position.max[0] + x, glyph._position.max[1] + y);
+
+        if (_options.outline) {
+            for (unsigned c=0; c<dimof(outlineOffsets); ++c) {
+                Quad shadowPos = pos;
+                shadowPos.min[0] += outlineOffsets[c][0] * xScale;
+                shadowPos.max[0] += outlineOffsets[c][0] * xScale;
+                shadowPos.min[1] += outlineOffsets[c][1] * yScale;
+                shadowPos.max[1] += outlineOffsets[c][1] * yScale;
+                sink.PushQuad(*glyph._texture, shadowPos, shadowColor, glyph._texCoords, depth);
+            }
+        }
+
+        if (_options.shadow) {
+            Quad shadowPos = pos;
+            shadowPos.min[0] += xScale;
+            shadowPos.max[0] += xScale;
+            shadowPos.min[1] += yScale;
+            shadowPos.max[1] += yScale;
+            sink.PushQuad(*glyph._texture, shadowPos, shadowColor, glyph._texCoords, depth);
+        }
+
+        sink.PushQuad(
+            *glyph._texture, pos, 
+            RenderCore::ARGBtoABGR(glyph._colorOverride?glyph._colorOverride:colorARGB), 
+            glyph._texCoords, depth);
+
+        if (q) {
+            if (firstQuad) {
+                *q = pos;
+                firstQuad = false;
+            } else {
+                q->min[0] = std::min(q->min[0], pos.min[0]);
+                q->min[1] = std::min(q->min[1], pos.min[1]);
+                q->max[0] = std::max(q->max[0], pos.max[0]);
+                q->max[1] = std::max(q->max[1], pos.max[1]);
+            }
+        }
+    }
+
+    return x + layout._endX;
+}
+
+    //  Draws quads immediately, binding the glyph texture as required
+class ImmediateTextQuadSink : public ITextQuadSink
+{
+public:
+    void PushQuad(const FontTexture2D& texture, const Quad& position, unsigned colorABGR, const Quad& texCoords, float depth)
+    {
+        using namespace RenderCore::Metal;
+
+            // Set the new texture if needed (changing state requires flushing completed work)
+        if (&texture != _currentBoundTexture) {
+            Flush(*_renderer, _workingVertices);
+
+            ShaderResourceView::UnderlyingResource sourceTexture = 
+                (ShaderResourceView::UnderlyingResource)texture.GetUnderlying();
+            if (!sourceTexture) {
+                throw ::Assets::Exceptions::PendingAsset("", "Pending background upload of font texture");
+            }
+
+            ShaderResourceView shadRes(sourceTexture);
+            _renderer->BindPS(RenderCore::MakeResourceList(shadRes));
+            _currentBoundTexture = &texture;
+        }
+
+        if (!_workingVertices.PushQuad(position, colorABGR, texCoords, depth)) {
+            Flush(*_renderer, _workingVertices);
+            _workingVertices.PushQuad(position, colorABGR, texCoords, depth);
+        }
+    }
+
+    void Finish() { Flush(*_renderer, _workingVertices); }
+
+    ImmediateTextQuadSink(RenderCore::Metal::DeviceContext& renderer) 
+        : _renderer(&renderer), _currentBoundTexture(nullptr) {}
+
+private:
+    RenderCore::Metal::DeviceContext*   _renderer;
+    const FontTexture2D*                _currentBoundTexture;
+    WorkingVertexSetPCT                 _workingVertices;
+};
+
 float   TextStyle::Draw(    
     RenderCore::Metal::DeviceContext* renderer, 
     float x, float y, const ucs4 text[], int maxLen,
@@ -239,7 +564,6 @@ float   TextStyle::Draw(
 
         using namespace RenderCore::Metal;
 
-        int prevGlyph = 0;
         float xScale = scale;
         float yScale = scale;
 
@@ -248,12 +572,12 @@ float   TextStyle::Draw(
             y = yScale * (int)(0.5f + y / yScale);
         }
 
-        float width     = _font->StringWidth(text, maxLen, spaceExtra, _options.outline);
-        float height    = _font->LineHeight() * yScale;
-
         if (textState != UI_TEXT_STATE_NORMAL) {
             const float magicGap = 3.0f;
 
+            float width     = _font->StringWidth(text, maxLen, spaceExtra, _options.outline);
+            float height    = _font->LineHeight() * yScale;
+
             Quad reverseBox;
             reverseBox.min[0] = x;
             reverseBox.min[1] = y - height + magicGap * yScale;
@@ -283,6 +607,8 @@ float   TextStyle::Draw(
             // }
         }
 
+        auto layout = GetLayout(text, maxLen, spaceExtra, scale, applyDescender);
+
         // VertexShader& vshader    = GetResource<VertexShader>(vertexShaderSource);
         // PixelShader& pshader     = GetResource<PixelShader>(pixelShaderSource);
 
@@ -308,197 +634,10 @@ float   TextStyle::Draw(
             // renderer->BindVS(boundLayout, constantBuffer);
             // renderer.BindVS(ResourceList<ConstantBuffer, 1>(std::make_tuple()));
         }
-        const FontTexture2D *   currentBoundTexture = nullptr;
-        WorkingVertexSetPCT     workingVertices;
-
-        // bool batchFont = _font->GetTexKind() == FTK_IMAGETEXT ? false : true;
-        float descent = 0.0f;
-        if (applyDescender) {
-            descent = _font->Descent();
-        }
-        float opacity = (colorARGB >> 24) / float(0xff);
-        unsigned colorOverride = 0x0;
-        for (uint32 i = 0; i < (uint32)maxLen; ++i) {
-            ucs4 ch = text[i];
-            if (!ch) break;
-            if (ch == '\n' || ch == '\r' || ch == '\0') continue;
-            if (mx > 0.0f && x > mx) {
-                return x;
-            }
-
-            if (!XlComparePrefixI((ucs4*)"{\0\0\0C\0\0\0o\0\0\0l\0\0\0o\0\0\0r\0\0\0:\0\0\0", &text[i], 7)) {
-                unsigned newColorOverride = 0;
-                unsigned parseLength = ParseColorValue(&text[i+7], &newColorOverride);
-                if (parseLength) {
-                    colorOverride = newColorOverride;
-                    i += 7 + parseLength;
-                    while (i<(uint32)maxLen && text[i] && text[i] != '}') ++i;
-                    continue;
-                }
-            }
-
-            int curGlyph;
-            Float2 v = _font->GetKerning(prevGlyph, ch, &curGlyph);
-            x += xScale * v[0];
-            y += yScale * v[1];
-            prevGlyph = curGlyph;
-
-            std::pair<const FontChar*, const FontTexture2D*> charAndTexture = _font->GetChar(ch);
-            const FontChar* fc       = charAndTexture.first;
-            const FontTexture2D* tex = charAndTexture.second;
-            if(!fc) continue;
-
-                // Set the new texture if needed (changing state requires flushing completed work)
-            if (tex != currentBoundTexture) {
-                Flush(*renderer, workingVertices);
-
-                ShaderResourceView::UnderlyingResource sourceTexture = 
-                    (ShaderResourceView::UnderlyingResource)tex->GetUnderlying();
-                if (!sourceTexture) {
-                    throw ::Assets::Exceptions::PendingAsset("", "Pending background upload of font texture");
-                }
-
-                ShaderResourceView shadRes(sourceTexture);
-                renderer->BindPS(RenderCore::MakeResourceList(shadRes));
-                currentBoundTexture = tex;
-            }
-
-            _font->TouchFontChar(fc);
-
-            float baseX = x + fc->left * xScale;
-            float baseY = y - (fc->top + descent) * yScale;
-            if (_options.snap) {
-                baseX = xScale * (int)(0.5f + baseX / xScale);
-                baseY = yScale * (int)(0.5f + baseY / yScale);
-            }
-
-            Quad pos    = Quad::MinMax(baseX, baseY, baseX + fc->width * xScale, baseY + fc->height * yScale);
-            Quad tc     = Quad::MinMax(fc->u0, fc->v0, fc->u1, fc->v1);
-
-            if (_options.outline) {
-                Quad shadowPos;
-                unsigned shadowColor = RGBA8(Color4::Create(0, 0, 0, opacity));
-
-                shadowPos = pos;
-                shadowPos.min[0] -= xScale;
-                shadowPos.max[0] -= xScale;
-                shadowPos.min[1] -= yScale;
-                shadowPos.max[1] -= yScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[1] -= yScale;
-                shadowPos.max[1] -= yScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[0] += xScale;
-                shadowPos.max[0] += xScale;
-                shadowPos.min[1] -= yScale;
-                shadowPos.max[1] -= yScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[0] -= xScale;
-                shadowPos.max[0] -= xScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[0] += xScale;
-                shadowPos.max[0] += xScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[0] -= xScale;
-                shadowPos.max[0] -= xScale;
-                shadowPos.min[1] += yScale;
-                shadowPos.max[1] += yScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[1] += yScale;
-                shadowPos.max[1] += yScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-
-                shadowPos = pos;
-                shadowPos.min[0] += xScale;
-                shadowPos.max[0] += xScale;
-                shadowPos.min[1] += yScale;
-                shadowPos.max[1] += yScale;
-                if (!workingVertices.PushQuad(shadowPos, shadowColor, tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, shadowColor, tc, depth);
-                }
-            }
-
-            if (_options.shadow) {
-                Quad shadowPos = pos;
-                shadowPos.min[0] += xScale;
-                shadowPos.max[0] += xScale;
-                shadowPos.min[1] += yScale;
-                shadowPos.max[1] += yScale;
-                if (!workingVertices.PushQuad(shadowPos, RGBA8(Color4::Create(0,0,0,opacity)), tc, depth)) {
-                    Flush(*renderer, workingVertices);
-                    workingVertices.PushQuad(shadowPos, RGBA8(Color4::Create(0,0,0,opacity)), tc, depth);
-                }
-            }
-
-            if (!workingVertices.PushQuad(pos, RenderCore::ARGBtoABGR(colorOverride?colorOverride:colorARGB), tc, depth)) {
-                Flush(*renderer, workingVertices);
-                workingVertices.PushQuad(pos, RenderCore::ARGBtoABGR(colorOverride?colorOverride:colorARGB), tc, depth);
-            }
-
-            x += fc->xAdvance * xScale;
-            if (_options.outline) {
-                x += 2 * xScale;
-            }
-            if (ch == ' ') {
-                x += spaceExtra;
-            }
-
-            if (q) {
-                if (i == 0) {
-                    *q = pos;
-                } else {
-                    if (q->min[0] > pos.min[0]) {
-                        q->min[0] = pos.min[0];
-                    }
-                    if (q->min[1] > pos.min[1]) {
-                        q->min[1] = pos.min[1];
-                    }
-
-                    if (q->max[0] < pos.max[0]) {
-                        q->max[0] = pos.max[0];
-                    }
-                    if (q->max[1] < pos.max[1]) {
-                        q->max[1] = pos.max[1];
-                    }
-                }
-            }
-        }
 
-        Flush(*renderer, workingVertices);
+        ImmediateTextQuadSink sink(*renderer);
+        x = DrawLayout(sink, *layout, x, y, scale, mx, depth, colorARGB, q);
+        sink.Finish();
 
     } CATCH(...) {
         // OutputDebugString("Suppressed exception while drawing text");
@@ -577,7 +716,7 @@ static Float2 AlignText(const Quad& q, Font* font, float stringWidth, float inde
 Float2 TextStyle::AlignText(const Quad& q, UiAlign align, const ucs4* text, int maxLen /*= -1*/)
 {
     assert(_font);
-    return RenderOverlays::AlignText(q, _font.get(), _font->StringWidth(text, maxLen), 0, align);
+    return RenderOverlays::AlignText(q, _font.get(), StringWidth(text, maxLen), 0, align);
 }
 
 Float2 TextStyle::AlignText(const Quad& q, UiAlign align, float width, float indent)
@@ -588,7 +727,9 @@ Float2 TextStyle::AlignText(const Quad& q, UiAlign align, float width, float ind
 
 float TextStyle::StringWidth(const ucs4* text, int maxlen)
 {
-    return _font->StringWidth(text, maxlen);
+        //  Use the same layout parameters as ImmediateOverlayContext::DrawText, so
+        //  aligning and then drawing a string only requires a single layout
+    return GetLayout(text, maxlen, 0.f, 1.f, true)->_stringWidth;
 }
 
 int TextStyle::CharCountFromWidth(const ucs4* text, float width)
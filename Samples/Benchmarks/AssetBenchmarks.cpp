@@ -0,0 +1,296 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Benchmark.h"
+#include "../../RenderCore/Assets/TransformationCommands.h"
+#include "../../RenderCore/Assets/RawAnimationCurve.h"
+#include "../../RenderCore/Assets/MeshDatabase.h"
+#include "../../Assets/ChunkFile.h"
+#include "../../Assets/ChunkFileAsset.h"
+#include "../../Assets/BlockSerializer.h"
+#include "../../Math/Transformations.h"
+#include "../../Utility/IteratorUtils.h"
+#include "../../Utility/PtrUtils.h"
+#include "../../Utility/Threading/CompletionThreadPool.h"
+#include <vector>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <string>
+#include <cmath>
+
+namespace Benchmarks
+{
+    static void RegisterTransformationMachineBenchmarks(BenchmarkSet& set)
+    {
+            //  Build a machine that looks like a typical skeleton -- chains of
+            //  4 joints, each with a static transform and an output matrix.
+        using namespace RenderCore::Assets;
+        const unsigned chainCount = 16, chainLength = 4;
+        auto machine = std::make_shared<std::vector<uint32>>();
+        std::mt19937 rng(0x9abc);
+        for (unsigned chain=0; chain<chainCount; ++chain) {
+            for (unsigned j=0; j<chainLength; ++j) {
+                auto angle = Deg2Rad((float)std::uniform_real_distribution<>(-180.f, 180.f)(rng));
+                auto transform = AsFloat4x4(ScaleRotationTranslationM(
+                    Float3(1.f, 1.f, 1.f),
+                    MakeRotationMatrix(Float3(0.f, 0.f, 1.f), angle),
+                    Float3(0.f, 0.f, 1.f)));
+
+                machine->push_back((uint32)TransformStackCommand::PushLocalToWorld);
+                machine->push_back((uint32)TransformStackCommand::TransformFloat4x4_Static);
+                machine->insert(machine->end(), (uint32*)(&transform), (uint32*)(&transform + 1));
+                machine->push_back((uint32)TransformStackCommand::WriteOutputMatrix);
+                machine->push_back(chain*chainLength + j);
+            }
+            machine->push_back((uint32)TransformStackCommand::PopLocalToWorld);
+            machine->push_back(chainLength);
+        }
+
+        set.Add("TransformationMachine/64Joints",
+            [machine, chainCount, chainLength](unsigned iterationCount)
+            {
+                std::vector<Float4x4> output(chainCount*chainLength);
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    GenerateOutputTransformsFree(
+                        AsPointer(output.begin()), output.size(),
+                        nullptr, MakeIteratorRange(*machine));
+                    Consume(output[c%output.size()](0,3));
+                }
+            });
+    }
+
+    static std::shared_ptr<RenderCore::Assets::RawAnimationCurve> MakeLinearCurve(unsigned keyCount)
+    {
+        using namespace RenderCore::Assets;
+        namespace NativeFormat = RenderCore::Metal::NativeFormat;
+
+        std::unique_ptr<float[], BlockSerializerDeleter<float[]>> timeMarkers(new float[keyCount]);
+        auto dataSize = keyCount * sizeof(Float3);
+        std::unique_ptr<uint8[], BlockSerializerDeleter<uint8[]>> data(new uint8[dataSize]);
+        auto* positions = (Float3*)data.get();
+        for (unsigned c=0; c<keyCount; ++c) {
+            timeMarkers[c] = float(c) / 30.f;
+            positions[c] = Float3(float(c), float(c&1), 0.f);
+        }
+
+        return std::make_shared<RawAnimationCurve>(
+            keyCount, std::move(timeMarkers),
+            DynamicArray<uint8, BlockSerializerDeleter<uint8[]>>(std::move(data), dataSize),
+            sizeof(Float3), RawAnimationCurve::Linear,
+            NativeFormat::R32G32B32_FLOAT, NativeFormat::Unknown, NativeFormat::Unknown);
+    }
+
+    static void RegisterAnimationCurveBenchmarks(BenchmarkSet& set)
+    {
+        const unsigned keyCount = 256;
+        auto curve = MakeLinearCurve(keyCount);
+        set.Add("RawAnimationCurve/CalculateFloat3",
+            [curve, keyCount](unsigned iterationCount)
+            {
+                    //  step through the curve at a rate that doesn't line up with the keys
+                const float endTime = float(keyCount-1) / 30.f;
+                float time = 0.f, accumulator = 0.f;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    accumulator += curve->Calculate<Float3>(time)[0];
+                    time += 0.0137f;
+                    if (time > endTime) time -= endTime;
+                }
+                Consume(accumulator);
+            });
+    }
+
+    class WeldingSource
+    {
+    public:
+        std::shared_ptr<RenderCore::Assets::GeoProc::IVertexSourceData> _positions, _normals, _texCoords;
+
+        RenderCore::Assets::GeoProc::MeshDatabase BuildMesh() const
+        {
+            RenderCore::Assets::GeoProc::MeshDatabase mesh;
+            mesh.AddStream(_positions, std::vector<unsigned>(), "POSITION", 0);
+            mesh.AddStream(_normals, std::vector<unsigned>(), "NORMAL", 0);
+            mesh.AddStream(_texCoords, std::vector<unsigned>(), "TEXCOORD", 0);
+            return mesh;
+        }
+    };
+
+        //  Like a scanned mesh exported with vertices per face: a grid in which each
+        //  vertex appears 4 times, with a little noise in the positions and normals
+    static std::shared_ptr<WeldingSource> MakeWeldingSource(unsigned vertexCount)
+    {
+        using namespace RenderCore::Assets::GeoProc;
+        namespace NativeFormat = RenderCore::Metal::NativeFormat;
+        const unsigned copies = 4;
+        const auto gridDim = unsigned(std::sqrt(double(vertexCount / copies)));
+        std::vector<Float3> positions, normals;
+        std::vector<Float2> texCoords;
+        positions.reserve(gridDim*gridDim*copies);
+        normals.reserve(gridDim*gridDim*copies);
+        texCoords.reserve(gridDim*gridDim*copies);
+        std::mt19937 rng(0x1e1d);
+        std::uniform_real_distribution<float> noise(-1e-5f, 1e-5f);
+        for (unsigned y=0; y<gridDim; ++y)
+            for (unsigned x=0; x<gridDim; ++x)
+                for (unsigned c=0; c<copies; ++c) {
+                    positions.push_back(Float3(float(x) * 1e-2f + noise(rng), float(y) * 1e-2f + noise(rng), noise(rng)));
+                    normals.push_back(Normalize(Float3(noise(rng), noise(rng), 1.f)));
+                    texCoords.push_back(Float2(float(x) / float(gridDim), float(y) / float(gridDim)));
+                }
+
+        auto result = std::make_shared<WeldingSource>();
+        result->_positions = CreateRawDataSource(
+            AsPointer(positions.cbegin()), AsPointer(positions.cend()), 
+            positions.size(), sizeof(Float3), NativeFormat::R32G32B32_FLOAT);
+        result->_normals = CreateRawDataSource(
+            AsPointer(normals.cbegin()), AsPointer(normals.cend()), 
+            normals.size(), sizeof(Float3), NativeFormat::R32G32B32_FLOAT);
+        result->_texCoords = CreateRawDataSource(
+            AsPointer(texCoords.cbegin()), AsPointer(texCoords.cend()), 
+            texCoords.size(), sizeof(Float2), NativeFormat::R32G32_FLOAT);
+        return result;
+    }
+
+    static void RegisterWeldingBenchmarks(BenchmarkSet& set)
+    {
+            //  WeldVertices() for 100k, 1M and 5M vertex meshes, with no pool and with a pool 
+            //  using every hardware thread. RemoveDuplicates() (the older sort based method, for
+            //  positions only) is only measured for the 100k mesh, because it doesn't scale 
+            //  linearly and takes minutes for the larger meshes.
+        auto pool = std::make_shared<CompletionThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+        const unsigned vertexCounts[] = { 100*1000, 1000*1000, 5000*1000 };
+        const char* names[] = { "100k", "1M", "5M" };
+        for (unsigned c=0; c<dimof(vertexCounts); ++c) {
+            auto source = MakeWeldingSource(vertexCounts[c]);
+            for (unsigned threaded=0; threaded<2; ++threaded) {
+                set.Add((std::string("MeshDatabase/WeldVertices") + names[c] + (threaded ? "/Pool" : "/NoPool")).c_str(),
+                    [source, pool, threaded](unsigned iterationCount)
+                    {
+                        std::vector<unsigned> mapping;
+                        RenderCore::Assets::GeoProc::WeldingSettings settings;
+                        for (unsigned c=0; c<iterationCount; ++c) {
+                            auto mesh = source->BuildMesh();
+                            RenderCore::Assets::GeoProc::WeldVertices(mapping, mesh, settings, threaded ? pool.get() : nullptr);
+                            Consume(uint64(mesh.GetUnifiedVertexCount()));
+                        }
+                    });
+            }
+
+            if (c == 0)
+                set.Add((std::string("MeshDatabase/RemoveDuplicates") + names[c]).c_str(),
+                    [source](unsigned iterationCount)
+                    {
+                        std::vector<unsigned> mapping;
+                        for (unsigned c=0; c<iterationCount; ++c) {
+                            auto result = RenderCore::Assets::GeoProc::RemoveDuplicates(mapping, *source->_positions, std::vector<unsigned>(), 1e-4f);
+                            Consume(uint64(result->GetCount()));
+                        }
+                    });
+        }
+    }
+
+    static void RegisterMeshDatabaseBenchmarks(BenchmarkSet& set)
+    {
+            //  A grid of positions, where each position appears 4 times with
+            //  a small amount of noise (like a mesh with split normals)
+        const unsigned gridDim = 64, copies = 4;
+        auto positions = std::make_shared<std::vector<Float3>>();
+        positions->reserve(gridDim*gridDim*copies);
+        std::mt19937 rng(0xdef0);
+        std::uniform_real_distribution<float> noise(-1e-4f, 1e-4f);
+        for (unsigned y=0; y<gridDim; ++y)
+            for (unsigned x=0; x<gridDim; ++x)
+                for (unsigned c=0; c<copies; ++c)
+                    positions->push_back(Float3(float(x) + noise(rng), float(y) + noise(rng), noise(rng)));
+
+        auto source = RenderCore::Assets::GeoProc::CreateRawDataSource(
+            AsPointer(positions->cbegin()), AsPointer(positions->cend()),
+            positions->size(), sizeof(Float3),
+            RenderCore::Metal::NativeFormat::R32G32B32_FLOAT);
+
+        set.Add("MeshDatabase/RemoveDuplicates16k",
+            [positions, source](unsigned iterationCount)
+            {
+                std::vector<unsigned> mapping;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto result = RenderCore::Assets::GeoProc::RemoveDuplicates(mapping, *source, std::vector<unsigned>(), 1e-3f);
+                    Consume(uint64(result->GetCount()));
+                }
+            });
+
+        RegisterWeldingBenchmarks(set);
+    }
+
+    static const char s_chunkFileName[] = "benchmark_chunkfile.tmp";
+
+        //  A block serialized chunk shaped roughly like a large model scaffold: a
+        //  lot of small objects, each with a pointer to some raw data (16MB total)
+    static void PrepareChunkFile()
+    {
+        static bool prepared = false;
+        if (prepared) return;
+
+        Serialization::NascentBlockSerializer block;
+        std::vector<uint8> payload(1024);
+        for (unsigned c=0; c<16*1024; ++c) {
+            std::fill(payload.begin(), payload.end(), uint8(c));
+            block.SerializeRawSubBlock(AsPointer(payload.cbegin()), AsPointer(payload.cend()));
+            block.SerializeValue(uint32(payload.size()));
+        }
+        auto blockData = block.AsMemoryBlock();
+
+        {
+            Serialization::ChunkFile::SimpleChunkFileWriter writer(
+                1, "benchmark", "benchmark", std::make_tuple(s_chunkFileName, "wb", 0));
+            writer.BeginChunk(1, 0, "Scaffold");
+            writer.Write(blockData.get(), 1, block.Size());
+        }
+        prepared = true;
+    }
+
+    static void RegisterChunkFileBenchmarks(BenchmarkSet& set)
+    {
+            //  These are warm cache numbers (the file will be resident after it
+            //  is first written), so they mostly measure the copy and the relocation
+        static const ::Assets::AssetChunkRequest requests[]
+        {
+            ::Assets::AssetChunkRequest { "Scaffold", 1, 0, ::Assets::AssetChunkRequest::DataType::BlockSerializer }
+        };
+
+        set.Add("ChunkFile/LoadScaffold16MB/Copy",
+            [](unsigned iterationCount)
+            {
+                PrepareChunkFile();
+                ::Assets::SetChunkFileMappedLoading(false);
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto chunks = ::Assets::LoadChunkFileData(s_chunkFileName, MakeIteratorRange(requests));
+                    Consume(uint64(chunks[0]._size));
+                }
+                ::Assets::SetChunkFileMappedLoading(true);
+            });
+
+        set.Add("ChunkFile/LoadScaffold16MB/Mapped",
+            [](unsigned iterationCount)
+            {
+                PrepareChunkFile();
+                ::Assets::SetChunkFileMappedLoading(true);
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto chunks = ::Assets::LoadChunkFileData(s_chunkFileName, MakeIteratorRange(requests));
+                    Consume(uint64(chunks[0]._size));
+                }
+            });
+    }
+
+    void RegisterAssetBenchmarks(BenchmarkSet& set)
+    {
+        RegisterTransformationMachineBenchmarks(set);
+        RegisterAnimationCurveBenchmarks(set);
+        RegisterMeshDatabaseBenchmarks(set);
+        RegisterChunkFileBenchmarks(set);
+    }
+}
+
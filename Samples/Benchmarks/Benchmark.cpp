@@ -0,0 +1,163 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Benchmark.h"
+#include "../../ConsoleRig/Log.h"
+#include "../../Utility/TimeUtils.h"
+#include "../../Utility/Streams/FileUtils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace Benchmarks
+{
+    static volatile uint64 s_sink64 = 0;
+    static volatile float s_sinkFloat = 0.f;
+
+    void Consume(uint64 value) { s_sink64 = s_sink64 + value; }
+    void Consume(float value) { s_sinkFloat = s_sinkFloat + value; }
+
+    void BenchmarkSet::Add(const char name[], BenchmarkFn&& fn)
+    {
+        _benchmarks.push_back(std::make_pair(std::string(name), std::move(fn)));
+    }
+
+    static double TimeRun(const BenchmarkFn& fn, unsigned iterationCount, double freq)
+    {
+        auto start = GetPerformanceCounter();
+        fn(iterationCount);
+        auto end = GetPerformanceCounter();
+        return double(end-start) / freq;
+    }
+
+    std::vector<BenchmarkResult> BenchmarkSet::Run(const char filter[]) const
+    {
+        std::vector<BenchmarkResult> results;
+        const double freq = double(GetPerformanceCounterFrequency());
+
+        for (const auto& b:_benchmarks) {
+            if (filter && *filter && b.first.find(filter) == std::string::npos)
+                continue;
+
+                //  Calibrate -- keep doubling the iteration count until a run takes
+                //  a measurable amount of time, and then scale up to the target
+            unsigned iterationCount = 1;
+            for (;;) {
+                auto seconds = TimeRun(b.second, iterationCount, freq);
+                if (seconds >= _targetSeconds / 8.f || iterationCount >= (1u<<30)) {
+                    auto scale = (seconds > 0.) ? (_targetSeconds / seconds) : 8.;
+                    iterationCount = unsigned(std::max(1., std::min(double(1u<<30), iterationCount * scale)));
+                    break;
+                }
+                iterationCount *= 2;
+            }
+
+            std::vector<double> samples;
+            samples.reserve(_sampleCount);
+            for (unsigned s=0; s<_sampleCount; ++s)
+                samples.push_back(TimeRun(b.second, iterationCount, freq));
+            std::sort(samples.begin(), samples.end());
+            auto median = samples[samples.size()/2];
+
+            BenchmarkResult result;
+            result._name = b.first;
+            result._nsPerOp = median * 1e9 / double(iterationCount);
+            result._iterationCount = iterationCount;
+            results.push_back(result);
+
+            LogInfo << b.first << ": " << result._nsPerOp << "ns/op (" << iterationCount << " iterations)";
+        }
+
+        return std::move(results);
+    }
+
+    BenchmarkSet::BenchmarkSet(float targetSeconds, unsigned sampleCount)
+    : _targetSeconds(targetSeconds), _sampleCount(std::max(1u, sampleCount))
+    {}
+
+    BenchmarkSet::~BenchmarkSet() {}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void WriteJSON(std::ostream& stream, const std::vector<BenchmarkResult>& results)
+    {
+        stream << "{" << std::endl;
+        stream << "    \"benchmarks\": [" << std::endl;
+        for (auto i=results.cbegin(); i!=results.cend(); ++i) {
+                //  benchmark names are plain identifiers; they never need escaping
+            stream << "        { \"name\": \"" << i->_name << "\", "
+                << "\"ns_per_op\": " << i->_nsPerOp << ", "
+                << "\"iterations\": " << i->_iterationCount << " }";
+            if ((i+1) != results.cend()) stream << ",";
+            stream << std::endl;
+        }
+        stream << "    ]" << std::endl;
+        stream << "}" << std::endl;
+    }
+
+    static const char* FindKey(const char* i, const char key[])
+    {
+        auto* t = std::strstr(i, key);
+        if (!t) return nullptr;
+        t += std::strlen(key);
+        while (*t == ' ' || *t == '\t' || *t == ':') ++t;
+        return t;
+    }
+
+    std::vector<BenchmarkResult> LoadBaseline(const char filename[])
+    {
+        std::vector<BenchmarkResult> result;
+
+        size_t size = 0;
+        auto block = LoadFileAsMemoryBlock(filename, &size);
+        if (!block || !size) return std::move(result);
+
+            //  LoadFileAsMemoryBlock null terminates the block, so we can use
+            //  the normal C string functions
+        const char* i = (const char*)block.get();
+        for (;;) {
+            auto* nameStart = FindKey(i, "\"name\"");
+            if (!nameStart || *nameStart != '"') break;
+            ++nameStart;
+            auto* nameEnd = std::strchr(nameStart, '"');
+            if (!nameEnd) break;
+
+            auto* value = FindKey(nameEnd, "\"ns_per_op\"");
+            if (!value) break;
+
+            BenchmarkResult r;
+            r._name = std::string(nameStart, nameEnd);
+            r._nsPerOp = std::strtod(value, nullptr);
+            r._iterationCount = 0;
+            result.push_back(r);
+            i = value;
+        }
+
+        return std::move(result);
+    }
+
+    std::vector<BaselineComparison> CompareToBaseline(
+        const std::vector<BenchmarkResult>& results,
+        const std::vector<BenchmarkResult>& baseline,
+        float threshold)
+    {
+        std::vector<BaselineComparison> comparisons;
+        for (const auto& r:results) {
+            auto b = std::find_if(baseline.cbegin(), baseline.cend(),
+                [&r](const BenchmarkResult& b) { return b._name == r._name; });
+
+            BaselineComparison c;
+            c._name = r._name;
+            c._baselineNsPerOp = (b != baseline.cend()) ? b->_nsPerOp : 0.;
+            c._currentNsPerOp = r._nsPerOp;
+            c._noBaseline = c._baselineNsPerOp <= 0.;
+            c._regression = !c._noBaseline && r._nsPerOp > c._baselineNsPerOp * (1. + threshold);
+            comparisons.push_back(c);
+        }
+        return std::move(comparisons);
+    }
+}
+
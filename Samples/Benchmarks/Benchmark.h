@@ -0,0 +1,85 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../../Core/Types.h"
+#include <functional>
+#include <vector>
+#include <string>
+#include <ostream>
+
+namespace Benchmarks
+{
+    /// <summary>Body of a single benchmark</summary>
+    /// The function should run the operation being measured "iterationCount" times.
+    /// Setup work should happen before the function is constructed (ie, in the
+    /// registration function that captures the test data), so it is not timed.
+    using BenchmarkFn = std::function<void(unsigned iterationCount)>;
+
+    class BenchmarkResult
+    {
+    public:
+        std::string     _name;
+        double          _nsPerOp;
+        uint64          _iterationCount;
+    };
+
+    class BaselineComparison
+    {
+    public:
+        std::string     _name;
+        double          _baselineNsPerOp;
+        double          _currentNsPerOp;
+        bool            _regression;
+        bool            _noBaseline;        // baseline is missing this benchmark, or has no measurement (0 ns/op)
+    };
+
+    /// <summary>Registry and timing harness for the benchmarks</summary>
+    /// Each benchmark is first calibrated to find an iteration count that takes
+    /// around "targetSeconds". Then it is run "sampleCount" times with that iteration
+    /// count, and the median time per iteration is reported.
+    class BenchmarkSet
+    {
+    public:
+        void    Add(const char name[], BenchmarkFn&& fn);
+
+        std::vector<BenchmarkResult> Run(const char filter[]) const;
+
+        BenchmarkSet(float targetSeconds = 0.05f, unsigned sampleCount = 5);
+        ~BenchmarkSet();
+    protected:
+        std::vector<std::pair<std::string, BenchmarkFn>> _benchmarks;
+        float       _targetSeconds;
+        unsigned    _sampleCount;
+    };
+
+    void WriteJSON(std::ostream& stream, const std::vector<BenchmarkResult>& results);
+
+    /// <summary>Loads results previously written with WriteJSON()</summary>
+    /// This is only a minimal reader for the files WriteJSON() writes. It will
+    /// skip over anything it doesn't understand.
+    std::vector<BenchmarkResult> LoadBaseline(const char filename[]);
+
+        //  Compares each result to the baseline result with the same name. A result is
+        //  a regression if it is more than "threshold" slower (ie, 0.1f means 10% slower).
+        //  Results without a baseline measurement are returned with "_noBaseline" set
+    std::vector<BaselineComparison> CompareToBaseline(
+        const std::vector<BenchmarkResult>& results,
+        const std::vector<BenchmarkResult>& baseline,
+        float threshold);
+
+        //  Write to a volatile, so the optimizer can't remove the work that
+        //  produced "value"
+    void Consume(uint64 value);
+    void Consume(float value);
+
+    void RegisterUtilityBenchmarks(BenchmarkSet& set);
+    void RegisterAssetBenchmarks(BenchmarkSet& set);
+    void RegisterSceneBenchmarks(BenchmarkSet& set);
+    void RegisterRenderBenchmarks(BenchmarkSet& set);
+}
+
@@ -0,0 +1,145 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Benchmark.h"
+#include "../../ConsoleRig/GlobalServices.h"
+#include "../../ConsoleRig/Log.h"
+#include "../../Utility/StringUtils.h"
+#include "../../Utility/Streams/StreamFormatter.h"
+#include "../../Utility/Streams/StreamDOM.h"
+#include "../../Utility/Streams/FileUtils.h"
+#include "../../Core/SelectConfiguration.h"
+#include <iostream>
+#include <sstream>
+
+namespace Benchmarks
+{
+        //  Command line attributes:
+        //      out=<filename>          write results as JSON (otherwise written to stdout)
+        //      baseline=<filename>     compare results against a baseline written previously
+        //      threshold=<float>       allowed slow down relative to the baseline (default 0.1, ie 10%)
+        //      filter=<string>         only run benchmarks with names containing this string
+        //      updatebaseline=true     overwrite the baseline file with the new results
+        //      seconds=<float>         target time for each sample (default 0.05)
+        //      samples=<int>           samples per benchmark; the median is reported (default 5)
+        //
+        //  Returns non-zero if any benchmark regressed by more than the threshold, if the
+        //  baseline file can't be loaded, or if any benchmark that ran has no measurement
+        //  in the baseline (so a missing or stale baseline can't pass silently).
+        //  The default baseline is Samples/Benchmarks/Baseline.json (relative to the
+        //  working directory). Baselines are machine specific; the checked in file was
+        //  recorded with the Linux build on the reference machine (1 vCPU Xeon VM,
+        //  Debian 12, g++ 12.2 -O2), which is too noisy for the default threshold (see
+        //  Project/Makefile). Record new numbers with "updatebaseline=true" on the
+        //  machine that runs the comparison.
+    int Execute(StringSection<char> cmdLine)
+    {
+        MemoryMappedInputStream stream(cmdLine.begin(), cmdLine.end());
+        InputStreamFormatter<char> formatter(stream);
+        Document<InputStreamFormatter<char>> doc(formatter);
+
+        auto outFile = doc.Attribute("out").Value().AsString();
+        auto baselineFile = doc.Attribute("baseline").Value().AsString();
+        auto filter = doc.Attribute("filter").Value().AsString();
+        auto threshold = doc.Attribute("threshold", 0.1f);
+        auto updateBaseline = doc.Attribute("updatebaseline", false);
+        auto targetSeconds = doc.Attribute("seconds", 0.05f);
+        auto sampleCount = doc.Attribute("samples", 5u);
+        if (baselineFile.empty())
+            baselineFile = "Samples/Benchmarks/Baseline.json";
+
+        BenchmarkSet set(targetSeconds, sampleCount);
+        RegisterUtilityBenchmarks(set);
+            //  The headless Linux build (Project/Makefile) only builds Utility and
+            //  ConsoleRig; the asset, scene & render libraries are still Windows only
+        #if PLATFORMOS_TARGET == PLATFORMOS_WINDOWS
+            RegisterAssetBenchmarks(set);
+            RegisterSceneBenchmarks(set);
+            RegisterRenderBenchmarks(set);
+        #endif
+
+        auto results = set.Run(filter.c_str());
+
+        std::stringstream json;
+        WriteJSON(json, results);
+        auto jsonStr = json.str();
+        if (!outFile.empty()) {
+            BasicFile file(outFile.c_str(), "wb");
+            file.Write(jsonStr.c_str(), 1, jsonStr.size());
+        } else {
+            std::cout << jsonStr;
+        }
+
+        if (updateBaseline) {
+            BasicFile file(baselineFile.c_str(), "wb");
+            file.Write(jsonStr.c_str(), 1, jsonStr.size());
+            std::cerr << "Updated baseline: " << baselineFile << std::endl;
+            return 0;
+        }
+
+        auto baseline = LoadBaseline(baselineFile.c_str());
+        if (baseline.empty()) {
+            std::cerr << "No baseline found at: " << baselineFile << std::endl;
+            std::cerr << "Run with \"updatebaseline=true\" to record one" << std::endl;
+            return 3;
+        }
+
+        unsigned regressionCount = 0, noBaselineCount = 0;
+        auto comparisons = CompareToBaseline(results, baseline, threshold);
+        for (const auto& c:comparisons) {
+            if (c._noBaseline) {
+                std::cerr << "NO BASELINE " << c._name << ": " << c._currentNsPerOp << "ns/op" << std::endl;
+                ++noBaselineCount;
+                continue;
+            }
+
+            auto change = (c._currentNsPerOp / c._baselineNsPerOp - 1.) * 100.;
+            std::cerr
+                << (c._regression ? "REGRESSION " : "           ")
+                << c._name << ": " << c._currentNsPerOp << "ns/op (baseline "
+                << c._baselineNsPerOp << "ns/op, " << (change >= 0. ? "+" : "") << change << "%)"
+                << std::endl;
+            if (c._regression) ++regressionCount;
+        }
+
+        if (noBaselineCount) {
+            std::cerr << noBaselineCount << " benchmark(s) have no baseline measurement in "
+                << baselineFile << std::endl;
+        }
+        if (regressionCount) {
+            std::cerr << regressionCount << " benchmark(s) regressed by more than "
+                << threshold * 100.f << "%" << std::endl;
+            return 1;
+        }
+        return noBaselineCount ? 3 : 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ConsoleRig::StartupConfig cfg("benchmarks");
+    cfg._setWorkingDir = false;
+    cfg._redirectCout = false;
+    ConsoleRig::GlobalServices services(cfg);
+
+    int result = 0;
+    TRY {
+        std::string cmdLine;
+        for (unsigned c=1; c<unsigned(argc); ++c) {
+                //  attribute values run until ';' or a new line in the stream formatter
+            if (c!=1) cmdLine += "; ";
+            cmdLine += argv[c];
+        }
+        result = Benchmarks::Execute(MakeStringSection(cmdLine));
+    } CATCH (const std::exception& e) {
+        LogAlwaysError << "Hit top level exception. Aborting program!";
+        LogAlwaysError << e.what();
+        result = 2;
+    } CATCH_END
+
+    return result;
+}
+
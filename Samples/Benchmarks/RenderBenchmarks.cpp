@@ -0,0 +1,84 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Benchmark.h"
+#include "../../RenderCore/Metal/Metal.h"
+
+#if GFXAPI_ACTIVE == GFXAPI_NULL
+
+    #include "../../RenderCore/IDevice.h"
+    #include "../../RenderCore/IThreadContext.h"
+    #include "../../RenderCore/Metal/DeviceContext.h"
+    #include "../../RenderCore/Metal/State.h"
+    #include "../../RenderCore/Metal/Buffer.h"
+    #include "../../Math/Matrix.h"
+    #include <memory>
+    #include <iostream>
+
+    namespace Benchmarks
+    {
+        static void RegisterFrameBenchmarks(BenchmarkSet& set)
+        {
+                //  A frame of 1000 draws through the null device. Each draw updates a
+                //  constant buffer and changes some state, roughly like a simple
+                //  forward pass. This measures only the CPU side cost of submission.
+            auto device = RenderCore::CreateDevice();
+            auto presentationChain = std::shared_ptr<RenderCore::IPresentationChain>(
+                device->CreatePresentationChain(nullptr, 1280, 720));
+
+            const unsigned drawsPerFrame = 1000;
+            set.Add("Render/NullDeviceFrame1000Draws",
+                [device, presentationChain](unsigned iterationCount)
+                {
+                    using namespace RenderCore;
+                    auto immediateContext = device->GetImmediateContext();
+                    auto& metalContext = *Metal::DeviceContext::Get(*immediateContext);
+
+                    Metal::ConstantBuffer localTransform(nullptr, sizeof(Float4x4));
+                    Metal::RasterizerState rasterizers[] = { Metal::RasterizerState(Metal::CullMode::Back), Metal::RasterizerState(Metal::CullMode::None) };
+                    Metal::BlendState blendStates[] = { Metal::BlendState(Metal::BlendOp::NoBlending), Metal::BlendState() };
+                    Metal::DepthStencilState depthStencil;
+
+                    for (unsigned f=0; f<iterationCount; ++f) {
+                        device->BeginFrame(presentationChain.get());
+                        metalContext.Bind(depthStencil);
+                        for (unsigned d=0; d<drawsPerFrame; ++d) {
+                            Float4x4 transform = Identity<Float4x4>();
+                            transform(0,3) = float(d);
+                            localTransform.Update(metalContext, &transform, sizeof(transform));
+                            metalContext.BindVS(MakeResourceList(localTransform));
+                            metalContext.Bind(rasterizers[d&1]);
+                            metalContext.Bind(blendStates[(d>>1)&1]);
+                            metalContext.Bind(Metal::Topology::TriangleList);
+                            metalContext.Draw(36);
+                        }
+                        presentationChain->Present();
+                    }
+
+                        //  The commands submitted by the last frame are only counted
+                        //  when the next frame begins
+                    device->BeginFrame(presentationChain.get());
+                    const auto& stats = metalContext.GetCommandLog().GetLastFrame();
+                    Consume(uint64(stats._drawCalls) + stats._stateChanges + stats._bytesUploaded);
+                });
+        }
+
+        void RegisterRenderBenchmarks(BenchmarkSet& set)
+        {
+            RegisterFrameBenchmarks(set);
+        }
+    }
+
+#else
+
+    namespace Benchmarks
+    {
+            //  The frame benchmarks only make sense on the null device (on a real
+            //  device they would measure the driver and GPU as well)
+        void RegisterRenderBenchmarks(BenchmarkSet&) {}
+    }
+
+#endif
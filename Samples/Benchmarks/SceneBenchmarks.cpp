@@ -0,0 +1,614 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Benchmark.h"
+#include "../../SceneEngine/PlacementsQuadTree.h"
+#include "../../SceneEngine/Terrain.h"
+#include "../../SceneEngine/TerrainScaffold.h"
+#include "../../SceneEngine/TerrainConfig.h"
+#include "../../SceneEngine/TerrainNodeEncoding.h"
+#include "../../SceneEngine/DeepOceanSim.h"
+#include "../../SceneEngine/DeepOceanSimCPU.h"
+#include "../../SceneEngine/Fluid.h"
+#include "../../SceneEngine/DualContour.h"
+#include "../../Assets/Assets.h"
+#include "../../Math/ProjectionMath.h"
+#include "../../Math/Transformations.h"
+#include "../../Math/RectanglePacking.h"
+#include "../../Math/Noise.h"
+#include "../../Utility/PtrUtils.h"
+#include "../../Utility/Streams/FileUtils.h"
+#include "../../Utility/Streams/PathUtils.h"
+#include "../../Utility/Threading/CompletionThreadPool.h"
+#include <vector>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <thread>
+
+namespace Benchmarks
+{
+    using BoundingBox = SceneEngine::PlacementsQuadTree::BoundingBox;
+
+    static Float4x4 MakeCellToClip()
+    {
+            //  Camera near the middle of the cell, looking along the ground
+        auto cameraToWorld = MakeCameraToWorld(
+            Normalize(Float3(1.f, .3f, -.2f)), Float3(0.f, 0.f, 1.f), Float3(256.f, 256.f, 50.f));
+        auto projection = PerspectiveProjection(
+            Deg2Rad(40.f), 16.f/9.f, 0.1f, 1000.f,
+            GeometricCoordinateSpace::RightHanded, ClipSpaceType::Positive);
+        return Combine(InvertOrthonormalTransform(cameraToWorld), projection);
+    }
+
+    static void RegisterPlacementCullingBenchmarks(BenchmarkSet& set)
+    {
+            //  A typical placements cell -- 512m square, with objects
+            //  between 1m and 8m in size
+        const unsigned objectCount = 10000;
+        auto boxes = std::make_shared<std::vector<BoundingBox>>();
+        boxes->reserve(objectCount);
+        std::mt19937 rng(0x1357);
+        std::uniform_real_distribution<float> pos(0.f, 512.f), size(1.f, 8.f);
+        for (unsigned c=0; c<objectCount; ++c) {
+            Float3 mins(pos(rng), pos(rng), 0.f);
+            boxes->push_back(std::make_pair(mins, mins + Float3(size(rng), size(rng), size(rng))));
+        }
+
+        auto quadTree = std::make_shared<SceneEngine::PlacementsQuadTree>(
+            AsPointer(boxes->cbegin()), sizeof(BoundingBox), boxes->size());
+
+        set.Add("PlacementCulling/QuadTree10k",
+            [boxes, quadTree](unsigned iterationCount)
+            {
+                __declspec(align(16)) auto cellToClip = MakeCellToClip();
+                std::vector<unsigned> visObjs(quadTree->GetMaxResults());
+                uint64 visibleCount = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    unsigned count = 0;
+                    quadTree->CalculateVisibleObjects(
+                        cellToClip, AsPointer(boxes->cbegin()), sizeof(BoundingBox),
+                        AsPointer(visObjs.begin()), count, unsigned(visObjs.size()));
+                    visibleCount += count;
+                }
+                Consume(visibleCount);
+            });
+
+            //  Brute force culling of the same boxes, as a reference point
+            //  for the quad tree result
+        set.Add("PlacementCulling/BruteForce10k",
+            [boxes](unsigned iterationCount)
+            {
+                __declspec(align(16)) auto cellToClip = MakeCellToClip();
+                uint64 visibleCount = 0;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    for (const auto& b:*boxes)
+                        if (!CullAABB_Aligned(cellToClip, b.first, b.second))
+                            ++visibleCount;
+                Consume(visibleCount);
+            });
+    }
+
+        //  Steady state churn in an atlas (as used for imposters & glyphs). Each
+        //  op frees one random live rectangle and allocates a new one in its place
+    template<typename Packer>
+        static void RegisterRectanglePackerChurn(BenchmarkSet& set, const char name[], UInt2 atlasSize, unsigned liveCount)
+    {
+        using Rectangle = std::pair<UInt2, UInt2>;
+        auto packer = std::make_shared<Packer>(atlasSize);
+        auto live = std::make_shared<std::vector<Rectangle>>();
+        auto rng = std::make_shared<std::mt19937>(0x4680);
+        while (live->size() < liveCount) {
+            auto rect = packer->Allocate(UInt2(8 + (*rng)()%41, 8 + (*rng)()%41));
+            if (rect.second[0] <= rect.first[0]) break;
+            live->push_back(rect);
+        }
+
+        set.Add(name,
+            [packer, live, rng](unsigned iterationCount)
+            {
+                uint64 failures = 0;
+                for (unsigned c=0; c<iterationCount && !live->empty(); ++c) {
+                    auto i = live->begin() + (*rng)()%live->size();
+                    packer->Deallocate(*i);
+                    auto rect = packer->Allocate(UInt2(8 + (*rng)()%41, 8 + (*rng)()%41));
+                    if (rect.second[0] > rect.first[0]) {
+                        *i = rect;
+                    } else {
+                        *i = live->back();
+                        live->pop_back();
+                        ++failures;
+                    }
+                }
+                Consume(failures);
+            });
+    }
+
+    static void RegisterRectanglePackerBenchmarks(BenchmarkSet& set)
+    {
+        RegisterRectanglePackerChurn<RectanglePacker_Guillotine>(set, "RectanglePacker/GuillotineChurn10k", UInt2(4096, 4096), 10000);
+        RegisterRectanglePackerChurn<RectanglePacker_Guillotine>(set, "RectanglePacker/GuillotineChurn1k", UInt2(1024, 1024), 1000);
+            //  (MaxRects is too slow to run with 10k live rectangles)
+        RegisterRectanglePackerChurn<RectanglePacker_MaxRects>(set, "RectanglePacker/MaxRectsChurn1k", UInt2(1024, 1024), 1000);
+    }
+
+        //  Synthetic terrain for the height query benchmarks. Every cell shares the
+        //  same scaffold (16x16 nodes in the highest LOD, 34x34 heights per node),
+        //  but each cell gets its own height file on disk
+    class BenchmarkTerrainCell : public SceneEngine::TerrainCell
+    {
+    public:
+        static const unsigned NodeWidth = 34;
+        static const unsigned NodesPerSide = 16;
+        static const unsigned FirstNode = 85;
+
+        BenchmarkTerrainCell()
+        {
+            _validationCallback = std::make_shared<::Assets::DependencyValidation>();
+            for (unsigned c=0; c<FirstNode; ++c)
+                _nodes.push_back(std::make_unique<Node>(Identity<Float4x4>(), 0, 0, NodeWidth));
+
+            const size_t nodeBytes = NodeWidth*NodeWidth*sizeof(uint16);
+            for (unsigned y=0; y<NodesPerSide; ++y)
+                for (unsigned x=0; x<NodesPerSide; ++x) {
+                    auto localToCell = AsFloat4x4(ScaleTranslation(
+                        Float3(1.f/float(NodesPerSide), 1.f/float(NodesPerSide), 0.05f),
+                        Float3(float(x)/float(NodesPerSide), float(y)/float(NodesPerSide), 0.f)));
+                    _nodes.push_back(std::make_unique<Node>(
+                        localToCell, (y*NodesPerSide+x)*nodeBytes, nodeBytes, NodeWidth));
+                }
+        }
+    };
+
+    class BenchmarkTerrainFormat : public SceneEngine::ITerrainFormat
+    {
+    public:
+        const SceneEngine::TerrainCell& LoadHeights(const char filename[], bool skipDependsCheck) const
+        {
+                //  write the height data for this cell the first time we see it
+            auto i = std::find(_writtenFiles.cbegin(), _writtenFiles.cend(), filename);
+            if (i == _writtenFiles.cend()) {
+                CreateDirectoryRecursive(MakeFileNameSplitter(filename).DriveAndPath());
+                std::mt19937 rng(0x2468);
+                const auto count = BenchmarkTerrainCell::NodesPerSide*BenchmarkTerrainCell::NodesPerSide*BenchmarkTerrainCell::NodeWidth*BenchmarkTerrainCell::NodeWidth;
+                std::vector<uint16> heights(count);
+                for (auto& h:heights) h = uint16(rng());
+                BasicFile(filename, "wb").Write(AsPointer(heights.cbegin()), sizeof(uint16), heights.size());
+                _writtenFiles.push_back(filename);
+            }
+            return _cell;
+        }
+
+        const SceneEngine::TerrainCellTexture& LoadCoverage(const char[]) const
+        {
+            throw ::Exceptions::BasicLabel("Coverage not supported in benchmark terrain");
+        }
+
+        void WriteCell(
+            const char[], SceneEngine::TerrainUberSurfaceGeneric&, 
+            UInt2, UInt2, unsigned, unsigned) const {}
+
+    private:
+        BenchmarkTerrainCell _cell;
+        mutable std::vector<std::string> _writtenFiles;
+    };
+
+    static void RegisterTerrainHeightBenchmarks(BenchmarkSet& set)
+    {
+        using namespace SceneEngine;
+        const float cellSize = 512.f;
+        const unsigned queryCount = 100000;
+        TerrainConfig cfg("int/benchmarkterrain/", UInt2(2, 2));
+        TerrainCoordinateSystem coords(Float3(0.f, 0.f, 0.f), cellSize);
+        auto queries = std::make_shared<TerrainHeightQueries>(
+            std::make_shared<BenchmarkTerrainFormat>(), cfg, coords);
+
+            //  Random queries scattered over the whole terrain; and coherent queries
+            //  (such as a row of objects being placed), which walk across the terrain in order
+        auto randomPositions = std::make_shared<std::vector<Float2>>();
+        auto coherentPositions = std::make_shared<std::vector<Float2>>();
+        std::mt19937 rng(0x1470);
+        std::uniform_real_distribution<float> pos(0.f, 2.f * cellSize);
+        for (unsigned c=0; c<queryCount; ++c) {
+            randomPositions->push_back(Float2(pos(rng), pos(rng)));
+            float t = float(c) / float(queryCount);
+            coherentPositions->push_back(Float2(t * 2.f * cellSize, 300.f + 200.f * XlSin(t * 20.f)));
+        }
+
+        auto heights = std::make_shared<std::vector<float>>(queryCount);
+        auto results = std::make_shared<std::vector<TerrainHeightQueries::QueryResult>>(queryCount);
+
+        auto registerBatch = [&](const char name[], std::shared_ptr<std::vector<Float2>> positions)
+        {
+            set.Add(name,
+                [queries, positions, heights, results](unsigned iterationCount)
+                {
+                    uint64 successCount = 0;
+                    for (unsigned c=0; c<iterationCount; ++c) {
+                        queries->QueryHeights(
+                            MakeIteratorRange(*positions), MakeIteratorRange(*heights), 
+                            MakeIteratorRange(*results));
+                        successCount += std::count(results->cbegin(), results->cend(), TerrainHeightQueries::QueryResult::Success);
+                    }
+                    Consume(successCount);
+                });
+        };
+        registerBatch("TerrainHeights/Random100k", randomPositions);
+        registerBatch("TerrainHeights/Coherent100k", coherentPositions);
+    }
+
+        //  Decoding terrain nodes, and the end-to-end cost of reading a single node from
+        //  disk (with a warm file cache) for raw and encoded data. The node is a 66x66 
+        //  height node, with smooth hills and a little noise
+    static void RegisterTerrainEncodingBenchmarks(BenchmarkSet& set)
+    {
+        const UInt2 dims(66, 66);
+        auto raw = std::make_shared<std::vector<uint16>>(dims[0]*dims[1]);
+        std::mt19937 rng(0x3690);
+        for (unsigned y=0; y<dims[1]; ++y)
+            for (unsigned x=0; x<dims[0]; ++x)
+                (*raw)[y*dims[0]+x] = uint16(
+                      30000.f + 8000.f * XlSin(float(x) * 0.05f) * XlCos(float(y) * 0.04f)
+                    + float(rng() % 9));
+        auto encoded = std::make_shared<std::vector<uint8>>(
+            SceneEngine::EncodeTerrainNode(AsPointer(raw->cbegin()), dims, 1));
+
+        const char filename[] = "int/benchmarkterrain/nodeencoding.tmp";
+        CreateDirectoryRecursive(MakeFileNameSplitter(filename).DriveAndPath());
+        {
+            BasicFile file(filename, "wb");
+            file.Write(AsPointer(raw->cbegin()), sizeof(uint16), raw->size());
+            file.Write(AsPointer(encoded->cbegin()), 1, encoded->size());
+        }
+        auto filenameStr = std::make_shared<std::string>(filename);
+
+        set.Add("TerrainEncoding/DecodePredictive66",
+            [raw, encoded](unsigned iterationCount)
+            {
+                std::vector<uint16> decoded(raw->size());
+                uint64 result = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    SceneEngine::DecodeTerrainNode(
+                        AsPointer(decoded.begin()), decoded.size()*sizeof(uint16),
+                        AsPointer(encoded->cbegin()), encoded->size());
+                    result += decoded[c%decoded.size()];
+                }
+                Consume(result);
+            });
+
+        set.Add("TerrainEncoding/StreamNodeRaw66",
+            [raw, filenameStr](unsigned iterationCount)
+            {
+                std::vector<uint16> loaded(raw->size());
+                uint64 result = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    BasicFile file(filenameStr->c_str(), "rb");
+                    file.Read(AsPointer(loaded.begin()), sizeof(uint16), loaded.size());
+                    result += loaded[c%loaded.size()];
+                }
+                Consume(result);
+            });
+
+        set.Add("TerrainEncoding/StreamNodePredictive66",
+            [raw, encoded, filenameStr](unsigned iterationCount)
+            {
+                std::vector<uint8> loaded(encoded->size());
+                std::vector<uint16> decoded(raw->size());
+                uint64 result = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    BasicFile file(filenameStr->c_str(), "rb");
+                    file.Seek(raw->size()*sizeof(uint16), SEEK_SET);
+                    file.Read(AsPointer(loaded.begin()), 1, loaded.size());
+                    SceneEngine::DecodeTerrainNode(
+                        AsPointer(decoded.begin()), decoded.size()*sizeof(uint16),
+                        AsPointer(loaded.cbegin()), loaded.size());
+                    result += decoded[c%decoded.size()];
+                }
+                Consume(result);
+            });
+    }
+
+        //  CPU ocean simulation for each grid size (multithreaded, and single threaded
+        //  for one size), and height & normal queries for a batch of floating objects
+    static void RegisterOceanBenchmarks(BenchmarkSet& set)
+    {
+        auto pool = std::make_shared<CompletionThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+        
+        const unsigned gridSizes[] = { 64, 128, 256, 512 };
+        for (auto gridSize:gridSizes) {
+            auto sim = std::make_shared<SceneEngine::DeepOceanSimCPU>(pool.get());
+            set.Add((std::string("OceanCPU/Update") + std::to_string(gridSize)).c_str(),
+                [sim, pool, gridSize](unsigned iterationCount)
+                {
+                    SceneEngine::DeepOceanSimSettings settings;
+                    settings._gridDimensions = gridSize;
+                    for (unsigned c=0; c<iterationCount; ++c)
+                        sim->Update(settings, float(c) / 60.f);
+                    Consume(uint64(sim->GetDisplacementGrid()[0] * 1000.f));
+                });
+        }
+
+        set.Add("OceanCPU/Update256SingleThread",
+            [](unsigned iterationCount)
+            {
+                SceneEngine::DeepOceanSimCPU sim;
+                SceneEngine::DeepOceanSimSettings settings;
+                settings._gridDimensions = 256;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    sim.Update(settings, float(c) / 60.f);
+                Consume(uint64(sim.GetDisplacementGrid()[0] * 1000.f));
+            });
+
+        auto buoyancySim = std::make_shared<SceneEngine::DeepOceanSimCPU>();
+        buoyancySim->Update(SceneEngine::DeepOceanSimSettings(), 10.f);
+        auto positions = std::make_shared<std::vector<Float2>>(1000);
+        std::mt19937 rng(0x0cea);
+        for (auto& p:*positions)
+            p = Float2(float(rng() % 100000) * 0.01f, float(rng() % 100000) * 0.01f);
+
+        set.Add("OceanCPU/Buoyancy1000",
+            [buoyancySim, positions](unsigned iterationCount)
+            {
+                std::vector<float> heights(positions->size());
+                std::vector<Float3> normals(positions->size());
+                float result = 0.f;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    buoyancySim->QueryHeightsAndNormals(
+                        MakeIteratorRange(*positions), MakeIteratorRange(heights), MakeIteratorRange(normals));
+                    result += heights[c%heights.size()];
+                }
+                Consume(uint64(result));
+            });
+    }
+
+    static void RegisterFluidBenchmarks(BenchmarkSet& set)
+    {
+            //  Step time for each grid size with 1, 4 and 16 worker threads (and with no
+            //  pool at all, which is the original single threaded path). Each step adds a
+            //  little density and velocity in the middle of the grid, so the solvers always
+            //  have something to do.
+        const unsigned threadCounts[] = { 0, 1, 4, 16 };
+        for (auto threadCount:threadCounts) {
+            std::shared_ptr<CompletionThreadPool> pool;
+            if (threadCount) pool = std::make_shared<CompletionThreadPool>(threadCount);
+            const auto suffix = threadCount ? (std::string("/Threads") + std::to_string(threadCount)) : std::string("/NoPool");
+
+            const unsigned gridSizes2D[] = { 64, 128, 256 };
+            for (auto gridSize:gridSizes2D) {
+                auto solver = std::make_shared<SceneEngine::FluidSolver2D>(UInt2(gridSize, gridSize), pool.get());
+                set.Add((std::string("Fluid2D/Tick") + std::to_string(gridSize) + suffix).c_str(),
+                    [solver, pool, gridSize](unsigned iterationCount)
+                    {
+                        SceneEngine::FluidSolver2D::Settings settings;
+                        for (unsigned c=0; c<iterationCount; ++c) {
+                            solver->AddDensity(UInt2(gridSize/2, gridSize/2), 1.f);
+                            solver->AddVelocity(UInt2(gridSize/2, gridSize/2), Float2(0.f, 1.f));
+                            solver->Tick(1.f / 60.f, settings);
+                        }
+                        Consume(uint64(iterationCount));
+                    });
+            }
+
+                // (preparing the preconditioner for the 3D solver gets very expensive for larger grids)
+            const unsigned gridSizes3D[] = { 24, 32 };
+            for (auto gridSize:gridSizes3D) {
+                auto solver = std::make_shared<SceneEngine::FluidSolver3D>(UInt3(gridSize, gridSize, gridSize), pool.get());
+                set.Add((std::string("Fluid3D/Tick") + std::to_string(gridSize) + suffix).c_str(),
+                    [solver, pool, gridSize](unsigned iterationCount)
+                    {
+                        SceneEngine::FluidSolver3D::Settings settings;
+                        for (unsigned c=0; c<iterationCount; ++c) {
+                            solver->AddDensity(UInt3(gridSize/2, gridSize/2, gridSize/2), 1.f);
+                            solver->Tick(1.f / 60.f, settings);
+                        }
+                        Consume(uint64(iterationCount));
+                    });
+            }
+        }
+    }
+
+    class NoiseDensityFunction : public SceneEngine::IVolumeDensityFunction
+    {
+    public:
+            //  A sphere, displaced with a few octaves of simplex noise. An optional
+            //  spherical hole can be carved out of it, to test remeshing after edits
+        Boundary    GetBoundary() const
+        {
+            return std::make_pair(Float3(-10.f, -10.f, -10.f), Float3(10.f, 10.f, 10.f));
+        }
+
+        float       GetDensity(const Float3& pt) const
+        {
+            float result = 7.f - Magnitude(pt) + 2.f * SimplexFBM(Float3(.25f * pt), 1.f, .5f, 2.f, 4);
+            if (_carveRadius > 0.f)
+                result = std::min(result, Magnitude(pt - _carveCenter) - _carveRadius);
+            return result;
+        }
+
+        void        GetDensities(IteratorRange<float*> dst, IteratorRange<const Float3*> pts) const
+        {
+            std::vector<Float3> scaled(pts.size());
+            for (size_t c=0; c<pts.size(); ++c) scaled[c] = Float3(.25f * pts[c]);
+            SimplexFBM(dst.begin(), AsPointer(scaled.cbegin()), scaled.size(), 1.f, .5f, 2.f, 4);
+            for (size_t c=0; c<pts.size(); ++c) {
+                dst[c] = 7.f - Magnitude(pts[c]) + 2.f * dst[c];
+                if (_carveRadius > 0.f)
+                    dst[c] = std::min(dst[c], Magnitude(pts[c] - _carveCenter) - _carveRadius);
+            }
+        }
+
+        Float3      GetNormal(const Float3& pt) const
+        {
+            Float3 result;
+            GetNormals(MakeIteratorRange(&result, &result+1), MakeIteratorRange(&pt, &pt+1));
+            return result;
+        }
+
+        void        GetNormals(IteratorRange<Float3*> dst, IteratorRange<const Float3*> pts) const
+        {
+                //  Central differences, with all of the offset points for the whole batch
+                //  going through a single call to GetDensities()
+            const float e = 0.01f;
+            const Float3 offsets[] = 
+            {
+                Float3(-e, 0.f, 0.f), Float3(e, 0.f, 0.f), 
+                Float3(0.f, -e, 0.f), Float3(0.f, e, 0.f), 
+                Float3(0.f, 0.f, -e), Float3(0.f, 0.f, e)
+            };
+            std::vector<Float3> samplePts;
+            samplePts.reserve(pts.size() * dimof(offsets));
+            for (const auto& p:pts)
+                for (const auto& o:offsets)
+                    samplePts.push_back(p + o);
+            std::vector<float> densities(samplePts.size());
+            GetDensities(MakeIteratorRange(densities), MakeIteratorRange(samplePts));
+            for (size_t c=0; c<pts.size(); ++c) {
+                const float* d = &densities[c*dimof(offsets)];
+                dst[c] = Normalize(Float3(d[0] - d[1], d[2] - d[3], d[4] - d[5]));
+            }
+        }
+
+        Float3  _carveCenter;
+        float   _carveRadius;
+
+        NoiseDensityFunction() : _carveCenter(0.f, 0.f, 0.f), _carveRadius(0.f) {}
+    };
+
+    static void RegisterDualContourBenchmarks(BenchmarkSet& set)
+    {
+            //  Full mesh build time for a few grid sizes, and the time to remesh after
+            //  a small edit (alternately carving a hole and filling it in again). With 
+            //  no pool, with 1 thread, and with 4 and 16 threads.
+        auto fn = std::make_shared<NoiseDensityFunction>();
+        auto carved = std::make_shared<NoiseDensityFunction>();
+        carved->_carveCenter = Float3(7.f, 0.f, 0.f);
+        carved->_carveRadius = 1.5f;
+        const Float3 carveExtent(1.5f, 1.5f, 1.5f);
+
+        const unsigned threadCounts[] = { 0, 1, 4, 16 };
+        for (auto threadCount:threadCounts) {
+            std::shared_ptr<CompletionThreadPool> pool;
+            if (threadCount) pool = std::make_shared<CompletionThreadPool>(threadCount);
+            const auto suffix = threadCount ? (std::string("/Threads") + std::to_string(threadCount)) : std::string("/NoPool");
+
+            const unsigned gridSizes[] = { 32, 64, 128 };
+            for (auto gridSize:gridSizes) {
+                set.Add((std::string("DualContour/Build") + std::to_string(gridSize) + suffix).c_str(),
+                    [fn, pool, gridSize](unsigned iterationCount)
+                    {
+                        uint64 quadCount = 0;
+                        for (unsigned c=0; c<iterationCount; ++c)
+                            quadCount += SceneEngine::DualContourMesh_Build(gridSize, *fn, pool.get())._quads.size();
+                        Consume(quadCount);
+                    });
+            }
+
+            auto mesher = std::make_shared<SceneEngine::DualContourMesher>(128, fn->GetBoundary(), pool.get());
+            mesher->Build(*fn);
+            set.Add((std::string("DualContour/Update128") + suffix).c_str(),
+                [fn, carved, carveExtent, mesher, pool](unsigned iterationCount)
+                {
+                    uint64 brickCount = 0;
+                    for (unsigned c=0; c<iterationCount; ++c)
+                        brickCount += mesher->Update(
+                            (c&1) ? *fn : *carved, 
+                            carved->_carveCenter - carveExtent, carved->_carveCenter + carveExtent);
+                    Consume(brickCount);
+                });
+        }
+    }
+
+    static const unsigned NoiseBatchSize = 4096;
+
+    template<typename Type>
+        static std::vector<Type> MakeNoisePositions(unsigned count)
+    {
+        std::mt19937 rng(0x4e);
+        std::uniform_real_distribution<float> dist(-500.f, 500.f);
+        std::vector<Type> result(count);
+        for (auto& p:result)
+            for (unsigned c=0; c<p.size(); ++c) p[c] = dist(rng);
+        return result;
+    }
+
+    template<typename Type>
+        static void RegisterNoiseBenchmarks(BenchmarkSet& set, const char dimsName[])
+    {
+            //  One iteration is one sample, so the reported time per iteration converts 
+            //  directly to samples per second. "Scalar" calls the single point functions
+            //  in a loop; the others use the batched functions with each instruction set.
+        auto positions = std::make_shared<std::vector<Type>>(MakeNoisePositions<Type>(NoiseBatchSize));
+        const auto prefix = std::string("Noise/") + dimsName;
+
+        set.Add((prefix + "/Noise/Scalar").c_str(),
+            [positions](unsigned iterationCount)
+            {
+                float total = 0.f;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    total += SimplexNoise((*positions)[c%NoiseBatchSize]);
+                Consume(total);
+            });
+        set.Add((prefix + "/FBM6/Scalar").c_str(),
+            [positions](unsigned iterationCount)
+            {
+                float total = 0.f;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    total += SimplexFBM((*positions)[c%NoiseBatchSize], 50.f, .5f, 2.f, 6);
+                Consume(total);
+            });
+
+        const std::pair<NoiseInstructionSet, const char*> instructionSets[] = 
+        {
+            std::make_pair(NoiseInstructionSet::SSE2, "/SSE2"),
+            std::make_pair(NoiseInstructionSet::AVX2, "/AVX2")
+        };
+        for (const auto& i:instructionSets) {
+            if (!SetNoiseInstructionSet(i.first)) continue;
+            auto instructionSet = i.first;
+            set.Add((prefix + "/Noise" + i.second).c_str(),
+                [positions, instructionSet](unsigned iterationCount)
+                {
+                    SetNoiseInstructionSet(instructionSet);
+                    float results[NoiseBatchSize], total = 0.f;
+                    for (unsigned c=0; c<iterationCount; c+=NoiseBatchSize) {
+                        auto count = std::min(iterationCount-c, NoiseBatchSize);
+                        SimplexNoise(results, AsPointer(positions->cbegin()), count);
+                        total += results[count-1];
+                    }
+                    SetNoiseInstructionSet(NoiseInstructionSet::Best);
+                    Consume(total);
+                });
+            set.Add((prefix + "/FBM6" + i.second).c_str(),
+                [positions, instructionSet](unsigned iterationCount)
+                {
+                    SetNoiseInstructionSet(instructionSet);
+                    float results[NoiseBatchSize], total = 0.f;
+                    for (unsigned c=0; c<iterationCount; c+=NoiseBatchSize) {
+                        auto count = std::min(iterationCount-c, NoiseBatchSize);
+                        SimplexFBM(results, AsPointer(positions->cbegin()), count, 50.f, .5f, 2.f, 6);
+                        total += results[count-1];
+                    }
+                    SetNoiseInstructionSet(NoiseInstructionSet::Best);
+                    Consume(total);
+                });
+        }
+        SetNoiseInstructionSet(NoiseInstructionSet::Best);
+    }
+
+    void RegisterSceneBenchmarks(BenchmarkSet& set)
+    {
+        RegisterPlacementCullingBenchmarks(set);
+        RegisterRectanglePackerBenchmarks(set);
+        RegisterTerrainHeightBenchmarks(set);
+        RegisterTerrainEncodingBenchmarks(set);
+        RegisterOceanBenchmarks(set);
+        RegisterFluidBenchmarks(set);
+        RegisterDualContourBenchmarks(set);
+        RegisterNoiseBenchmarks<Float2>(set, "2D");
+        RegisterNoiseBenchmarks<Float3>(set, "3D");
+    }
+}
+
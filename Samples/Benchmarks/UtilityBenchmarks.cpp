@@ -0,0 +1,585 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "Benchmark.h"
+#include "../../Utility/MemoryUtils.h"
+#include "../../Utility/ParameterBox.h"
+#include "../../Utility/HeapUtils.h"
+#include "../../Utility/PtrUtils.h"
+#include "../../Utility/StringUtils.h"
+#include "../../Utility/Threading/LockFree.h"
+#include "../../Utility/Streams/StreamFormatter.h"
+#include "../../Utility/Streams/StreamDOM.h"
+#include "../../Utility/Streams/XmlStreamFormatter.h"
+#include "../../Utility/Streams/FileUtils.h"
+#include "../../Utility/Streams/Data.h"
+#include <vector>
+#include <random>
+#include <memory>
+#include <algorithm>
+
+namespace Benchmarks
+{
+    static const char s_formatterTestString[] = R"--(~~!Format=1; Tab=4
+
+~EnvSettings
+	Name=environment
+
+	~ToneMapSettings; BloomDesaturationFactor=0.6f; BloomRampingFactor=0.8f; SceneKey=0.23f
+		BloomBlurStdDev=1.32f; Flags=3i; BloomBrightness=20.8f; LuminanceMax=3f; WhitePoint=8f
+		BloomThreshold=10f; LuminanceMin=0.06f; BloomScale=-1405359i
+
+	~AmbientSettings; AmbientLight=-12080934i; AmbientBrightness=0.1f; SkyReflectionBlurriness=2f
+		SkyTexture=Game/xleres/DefaultResources/sky/desertsky.dds; SkyReflectionScale=8f
+		SkyBrightness=0.68f
+
+	~ShadowFrustumSettings; FrustumCount=5i; ShadowRasterDepthBias=400i; FrustumSizeFactor=4f
+		ShadowSlopeScaledBias=1f; Flags=1i; ShadowDepthBiasClamp=0f; MaxBlurSearch=64f
+		MinBlurSearch=2f; MaxDistanceFromCamera=500f; WorldSpaceResolveBias=0f; FocusDistance=3f
+		BlurAngleDegrees=0.25f; Name=shadows; TextureSize=2048i
+
+	~DirectionalLight; DiffuseModel=1i; DiffuseBrightness=3.5f; Diffuse=-1072241i
+		Specular=-1647966i; Flags=1i; SpecularBrightness=19f; DiffuseWideningMin=0.2f
+		Transform={1f, 0f, 0f, 0f, 0f, 1f, 0f, 0f, 0f, 0f, 1f, 0f, -5.05525f, 32.7171f, 5.73295f, 1f}
+		ShadowResolveModel=0i; SpecularNonMetalBrightness=15f; DiffuseWideningMax=0.9f
+		Name=DirLight; ShadowFrustumSettings=shadows; Visible=0u
+)--";
+
+    static void RegisterHashBenchmarks(BenchmarkSet& set)
+    {
+        static const unsigned sizes[] = { 16, 64, 1024, 64*1024 };
+        for (auto size:sizes) {
+            auto buffer = std::make_shared<std::vector<uint8>>(size);
+            std::mt19937 rng(size);
+            for (auto& b:*buffer) b = uint8(rng());
+
+            std::string name = "Hash64/" + std::to_string(size) + "B";
+            set.Add(name.c_str(),
+                [buffer](unsigned iterationCount)
+                {
+                    uint64 hash = DefaultSeed64;
+                    auto* begin = AsPointer(buffer->cbegin());
+                    auto* end = AsPointer(buffer->cend());
+                    for (unsigned c=0; c<iterationCount; ++c)
+                        hash = Hash64(begin, end, hash);
+                    Consume(hash);
+                });
+
+            name = "Hasher64/" + std::to_string(size) + "B";
+            set.Add(name.c_str(),
+                [buffer](unsigned iterationCount)
+                {
+                        //  feed the data in 4 uneven pieces, to include the cost of
+                        //  the internal buffering
+                    uint64 hash = DefaultSeed64;
+                    auto* begin = AsPointer(buffer->cbegin());
+                    auto* end = AsPointer(buffer->cend());
+                    auto* q0 = begin + buffer->size()/5;
+                    auto* q1 = begin + buffer->size()/2;
+                    auto* q2 = end - buffer->size()/7;
+                    for (unsigned c=0; c<iterationCount; ++c) {
+                        Hasher64 hasher(hash);
+                        hasher.Update(begin, q0); hasher.Update(q0, q1);
+                        hasher.Update(q1, q2); hasher.Update(q2, end);
+                        hash = hasher.Digest();
+                    }
+                    Consume(hash);
+                });
+        }
+
+            //  Many short names, typical of shader & material parameter lists
+        auto names = std::make_shared<std::vector<std::string>>();
+        std::mt19937 rng(3462);
+        for (unsigned c=0; c<256; ++c) {
+            std::string n;
+            auto len = 4 + rng() % 28;
+            for (unsigned q=0; q<len; ++q) n.push_back(char('a' + rng()%26));
+            names->push_back(n);
+        }
+        auto sections = std::make_shared<std::vector<StringSection<char>>>();
+        for (const auto& n:*names) sections->push_back(MakeStringSection(n));
+
+        set.Add("Hash64/256Names/Single",
+            [names, sections](unsigned iterationCount)
+            {
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    for (const auto& s:*sections)
+                        accumulator += Hash64(s.begin(), s.end());
+                Consume(accumulator);
+            });
+
+        set.Add("Hash64/256Names/Batch",
+            [names, sections](unsigned iterationCount)
+            {
+                uint64 results[256];
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    Hash64Batch(AsPointer(sections->cbegin()), sections->size(), results);
+                    accumulator += results[c&255];
+                }
+                Consume(accumulator);
+            });
+    }
+
+    static void RegisterParameterBoxBenchmarks(BenchmarkSet& set)
+    {
+            //  Typical material parameter box, with a mixture of types
+        auto box = std::make_shared<ParameterBox>();
+        std::vector<ParameterBox::ParameterNameHash> names;
+        for (unsigned c=0; c<32; ++c) {
+            auto name = "Param" + std::to_string(c);
+            if (c & 1) box->SetParameter((const utf8*)name.c_str(), float(c));
+            else box->SetParameter((const utf8*)name.c_str(), c);
+            names.push_back(ParameterBox::MakeParameterNameHash((const utf8*)name.c_str()));
+        }
+
+        set.Add("ParameterBox/GetParameter",
+            [box, names](unsigned iterationCount)
+            {
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto r = box->GetParameter<unsigned>(names[c%names.size()]);
+                    accumulator += r.second;
+                }
+                Consume(accumulator);
+            });
+
+        set.Add("ParameterBox/GetHash",
+            [box](unsigned iterationCount)
+            {
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    accumulator += box->GetHash();
+                Consume(accumulator);
+            });
+    }
+
+    static void RegisterLRUCacheBenchmarks(BenchmarkSet& set)
+    {
+            //  Working set is larger than the cache, so this includes evictions
+        const unsigned cacheSize = 256;
+        auto keys = std::make_shared<std::vector<uint64>>();
+        std::mt19937 rng(0x1234);
+        for (unsigned c=0; c<1024; ++c) keys->push_back(IntegerHash64(rng() % 384));
+
+        set.Add("LRUCache/InsertGet",
+            [keys, cacheSize](unsigned iterationCount)
+            {
+                LRUCache<unsigned> cache(cacheSize);
+                auto object = std::make_shared<unsigned>(0);
+                uint64 hits = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto key = (*keys)[c%keys->size()];
+                    if (cache.Get(key)) ++hits;
+                    else cache.Insert(key, object);
+                }
+                Consume(hits);
+            });
+    }
+
+    static void RegisterSpanningHeapBenchmarks(BenchmarkSet& set)
+    {
+        set.Add("SpanningHeap/AllocateDeallocate",
+            [](unsigned iterationCount)
+            {
+                    //  Keep a ring of live allocations, so the heap stays fragmented
+                const unsigned heapSize = 1024*1024;
+                const unsigned liveCount = 256;
+                SpanningHeap<uint32> heap(heapSize);
+                std::pair<unsigned, unsigned> live[liveCount];
+                for (auto& l:live) l = std::make_pair(~0u, 0u);
+
+                std::mt19937 rng(0x5678);
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto& slot = live[c%liveCount];
+                    if (slot.first != ~0u)
+                        heap.Deallocate(slot.first, slot.second);
+                    auto size = 64u + (rng() % 4096u);
+                    slot = std::make_pair(heap.Allocate(size), size);
+                }
+                for (auto& l:live)
+                    if (l.first != ~0u) heap.Deallocate(l.first, l.second);
+            });
+    }
+
+    static void RegisterFixedSizeQueueBenchmarks(BenchmarkSet& set)
+    {
+        set.Add("FixedSizeQueue/PushPop",
+            [](unsigned iterationCount)
+            {
+                    //  single threaded push/pop; measures the cost of the interlocked
+                    //  operations, not contention
+                auto queue = std::make_unique<LockFree::FixedSizeQueue<unsigned, 256>>();
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    queue->push(c);
+                    unsigned* front = nullptr;
+                    if (queue->try_front(front)) {
+                        accumulator += *front;
+                        queue->pop();
+                    }
+                }
+                Consume(accumulator);
+            });
+    }
+
+        //  Repeated elements with long attribute values, until the text is at
+        //  least "minSize" bytes
+    static std::shared_ptr<std::string> BuildFormatterTestString(size_t minSize)
+    {
+        auto result = std::make_shared<std::string>("~~!Format=1; Tab=4\r\n");
+        std::mt19937 rng(0x1234);
+        for (unsigned e=0; result->size() < minSize; ++e) {
+            *result += "~Element" + std::to_string(e) + "\r\n";
+            for (unsigned a=0; a<8; ++a) {
+                *result += "\tAttribute" + std::to_string(a) + "=";
+                for (unsigned c=0; c<16; ++c)
+                    *result += std::to_string(rng()%10000) + "f, ";
+                *result += "\r\n";
+            }
+        }
+        return result;
+    }
+
+        //  Similar in shape to a Collada file; most of the bytes are in the
+        //  character data of <float_array> elements
+    static std::shared_ptr<std::string> BuildXmlTestString(size_t minSize)
+    {
+        auto result = std::make_shared<std::string>("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<COLLADA>\r\n");
+        std::mt19937 rng(0x5678);
+        for (unsigned e=0; result->size() < minSize; ++e) {
+            *result += "  <!-- source " + std::to_string(e) + " -->\r\n";
+            *result += "  <source id=\"mesh" + std::to_string(e) + "-positions\">\r\n";
+            *result += "    <float_array id=\"mesh" + std::to_string(e) + "-positions-array\" count=\"192\">";
+            for (unsigned c=0; c<192; ++c) {
+                *result += std::to_string(int(rng()%20000) - 10000) + "." + std::to_string(rng()%1000);
+                *result += ((c%12)==11) ? "\r\n" : " ";
+            }
+            *result += "</float_array>\r\n  </source>\r\n";
+        }
+        *result += "</COLLADA>\r\n";
+        return result;
+    }
+
+    static void RegisterStreamFormatterBenchmarks(BenchmarkSet& set)
+    {
+        set.Add("StreamFormatter/Tokenize",
+            [](unsigned iterationCount)
+            {
+                uint64 tokenCount = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    MemoryMappedInputStream stream(s_formatterTestString, ArrayEnd(s_formatterTestString)-1);
+                    InputStreamFormatter<char> formatter(stream);
+                    InputStreamFormatter<char>::InteriorSection name, value;
+                    for (;;) {
+                        using Blob = InputStreamFormatter<char>::Blob;
+                        auto next = formatter.PeekNext();
+                        if (next == Blob::BeginElement) formatter.TryBeginElement(name);
+                        else if (next == Blob::EndElement) formatter.TryEndElement();
+                        else if (next == Blob::AttributeName) formatter.TryAttribute(name, value);
+                        else break;
+                        ++tokenCount;
+                    }
+                }
+                Consume(tokenCount);
+            });
+
+        set.Add("StreamFormatter/Document",
+            [](unsigned iterationCount)
+            {
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    MemoryMappedInputStream stream(s_formatterTestString, ArrayEnd(s_formatterTestString)-1);
+                    InputStreamFormatter<char> formatter(stream);
+                    Document<InputStreamFormatter<char>> doc(formatter);
+                    Consume(uint64(doc.Element("EnvSettings") ? 1 : 0));
+                }
+            });
+
+            //  The "1MB" benchmarks tokenize 1MB of text per iteration, so throughput
+            //  in MB/s is 1e9 / (ns per op). These are dominated by the scans for
+            //  the next structural character (long strings and character data).
+        auto formatterText = BuildFormatterTestString(1024*1024);
+        set.Add("StreamFormatter/Tokenize1MB",
+            [formatterText](unsigned iterationCount)
+            {
+                uint64 tokenCount = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    MemoryMappedInputStream stream(AsPointer(formatterText->cbegin()), AsPointer(formatterText->cend()));
+                    InputStreamFormatter<char> formatter(stream);
+                    InputStreamFormatter<char>::InteriorSection name, value;
+                    for (;;) {
+                        using Blob = InputStreamFormatter<char>::Blob;
+                        auto next = formatter.PeekNext();
+                        if (next == Blob::BeginElement) formatter.TryBeginElement(name);
+                        else if (next == Blob::EndElement) formatter.TryEndElement();
+                        else if (next == Blob::AttributeName) formatter.TryAttribute(name, value);
+                        else break;
+                        ++tokenCount;
+                    }
+                }
+                Consume(tokenCount);
+            });
+
+        auto xmlText = BuildXmlTestString(1024*1024);
+        set.Add("XmlStreamFormatter/Tokenize1MB",
+            [xmlText](unsigned iterationCount)
+            {
+                uint64 tokenCount = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    XmlInputStreamFormatter<utf8> formatter(
+                        MemoryMappedInputStream(AsPointer(xmlText->cbegin()), AsPointer(xmlText->cend())));
+                    XmlInputStreamFormatter<utf8>::InteriorSection name, value;
+                    for (;;) {
+                        using Blob = XmlInputStreamFormatter<utf8>::Blob;
+                        auto next = formatter.PeekNext(true);
+                        if (next == Blob::BeginElement) formatter.TryBeginElement(name);
+                        else if (next == Blob::EndElement) formatter.TryEndElement();
+                        else if (next == Blob::AttributeName) formatter.TryAttribute(name, value);
+                        else if (next == Blob::CharacterData) formatter.TryCharacterData(value);
+                        else break;
+                        ++tokenCount;
+                    }
+                }
+                Consume(tokenCount);
+            });
+
+            //  Real files from the Working directory (relative to the working directory,
+            //  so run from the root of the tree). Each iteration parses the whole file once.
+            //  These are skipped if the files can't be found.
+        struct FileText { std::unique_ptr<uint8[]> _data; size_t _size; };
+        auto materialFile = std::make_shared<FileText>();
+        materialFile->_data = LoadFileAsMemoryBlock("Working/Game/Model/simple/mattest.material", &materialFile->_size);
+        if (materialFile->_size) {
+            set.Add("StreamFormatter/MaterialFile",
+                [materialFile](unsigned iterationCount)
+                {
+                    uint64 tokenCount = 0;
+                    for (unsigned c=0; c<iterationCount; ++c) {
+                        MemoryMappedInputStream stream(materialFile->_data.get(), PtrAdd(materialFile->_data.get(), materialFile->_size));
+                        InputStreamFormatter<utf8> formatter(stream);
+                        InputStreamFormatter<utf8>::InteriorSection name, value;
+                        for (;;) {
+                            using Blob = InputStreamFormatter<utf8>::Blob;
+                            auto next = formatter.PeekNext();
+                            if (next == Blob::BeginElement) formatter.TryBeginElement(name);
+                            else if (next == Blob::EndElement) formatter.TryEndElement();
+                            else if (next == Blob::AttributeName) formatter.TryAttribute(name, value);
+                            else break;
+                            ++tokenCount;
+                        }
+                    }
+                    Consume(tokenCount);
+                });
+        }
+
+        auto colladaFile = std::make_shared<FileText>();
+        colladaFile->_data = LoadFileAsMemoryBlock("Working/Game/Model/Character/Animations/run.dae", &colladaFile->_size);
+        if (colladaFile->_size) {
+            set.Add("XmlStreamFormatter/ColladaFile",
+                [colladaFile](unsigned iterationCount)
+                {
+                    uint64 tokenCount = 0;
+                    for (unsigned c=0; c<iterationCount; ++c) {
+                        XmlInputStreamFormatter<utf8> formatter(
+                            MemoryMappedInputStream(colladaFile->_data.get(), PtrAdd(colladaFile->_data.get(), colladaFile->_size)));
+                        XmlInputStreamFormatter<utf8>::InteriorSection name, value;
+                        for (;;) {
+                            using Blob = XmlInputStreamFormatter<utf8>::Blob;
+                            auto next = formatter.PeekNext(true);
+                            if (next == Blob::BeginElement) formatter.TryBeginElement(name);
+                            else if (next == Blob::EndElement) formatter.TryEndElement();
+                            else if (next == Blob::AttributeName) formatter.TryAttribute(name, value);
+                            else if (next == Blob::CharacterData) formatter.TryCharacterData(value);
+                            else break;
+                            ++tokenCount;
+                        }
+                    }
+                    Consume(tokenCount);
+                });
+        }
+    }
+
+        //  Similar in shape to a large material file; 1024 materials with 20 
+        //  parameters each
+    static std::shared_ptr<std::string> BuildDataTestString()
+    {
+        auto result = std::make_shared<std::string>();
+        std::mt19937 rng(0x9abc);
+        for (unsigned m=0; m<1024; ++m) {
+            *result += "material" + std::to_string(m) + "\n";
+            for (unsigned p=0; p<20; ++p)
+                *result += "  param" + std::to_string(p) + " " + std::to_string(rng()%1000) + "\n";
+            *result += "  texture \"textures/material" + std::to_string(m) + ".dds\"\n";
+        }
+        return result;
+    }
+
+    static void RegisterDataBenchmarks(BenchmarkSet& set)
+    {
+        auto text = BuildDataTestString();
+        auto paths = std::make_shared<std::vector<std::string>>();
+        std::mt19937 rng(0xdef0);
+        for (unsigned c=0; c<1024; ++c)
+            paths->push_back("material" + std::to_string(rng()%1024) + ".param" + std::to_string(rng()%20));
+
+        set.Add("Data/Parse",
+            [text](unsigned iterationCount)
+            {
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    Data data;
+                    data.Load(text->c_str(), int(text->size()));
+                    Consume(uint64(data.Size()));
+                }
+            });
+
+        set.Add("DataDocument/Parse",
+            [text](unsigned iterationCount)
+            {
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    DataDocument doc;
+                    doc.Load(MakeStringSection(*text));
+                    Consume(uint64(doc.Root().ChildCount()));
+                }
+            });
+
+        auto data = std::make_shared<Data>();
+        data->Load(text->c_str(), int(text->size()));
+        set.Add("Data/IntAttribute",
+            [data, paths](unsigned iterationCount)
+            {
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    accumulator += data->IntAttribute((*paths)[c%paths->size()].c_str());
+                Consume(accumulator);
+            });
+
+            //  (the document refers to the source text, so "text" must be kept alive)
+        auto doc = std::make_shared<DataDocument>();
+        doc->Load(MakeStringSection(*text));
+        set.Add("DataDocument/IntAttribute",
+            [doc, paths, text](unsigned iterationCount)
+            {
+                uint64 accumulator = 0;
+                for (unsigned c=0; c<iterationCount; ++c)
+                    accumulator += doc->Root().IntAttribute(MakeStringSection((*paths)[c%paths->size()]));
+                Consume(accumulator);
+            });
+    }
+
+    static const char s_mappedFileName[] = "benchmark_mappedfile.tmp";
+    static const size_t s_mappedFileSize = 64*1024*1024;
+    static const size_t s_mappedFilePage = 4096;
+
+        //  The test file is created on first use (so it's only written if the
+        //  file benchmarks are actually selected). Note that these are warm cache
+        //  numbers; the file will normally be resident after it is first written.
+    static void PrepareMappedFile()
+    {
+        static bool prepared = false;
+        if (prepared) return;
+        if (GetFileSize(s_mappedFileName) != s_mappedFileSize) {
+            BasicFile file(s_mappedFileName, "wb");
+            std::vector<uint32> block(1024*1024/sizeof(uint32));
+            std::mt19937 rng(0);
+            for (size_t c=0; c<s_mappedFileSize/(1024*1024); ++c) {
+                for (auto& b:block) b = rng();
+                file.Write(AsPointer(block.cbegin()), sizeof(uint32), block.size());
+            }
+        }
+        prepared = true;
+    }
+
+    static uint64 SumMappedFile(MemoryMappedFile::Access::BitField access)
+    {
+        MemoryMappedFile file(s_mappedFileName, 0, access, BasicFile::ShareMode::Read);
+        if (!file.IsValid()) return 0;
+        uint64 result = 0;
+        auto* i = (const uint64*)file.GetData();
+        auto* end = i + file.GetSize()/sizeof(uint64);
+        for (; i<end; ++i) result += *i;
+        return result;
+    }
+
+    static void RegisterMappedFileBenchmarks(BenchmarkSet& set)
+    {
+        set.Add("MappedFile/SequentialSum/Default",
+            [](unsigned iterationCount)
+            {
+                PrepareMappedFile();
+                for (unsigned c=0; c<iterationCount; ++c)
+                    Consume(SumMappedFile(MemoryMappedFile::Access::Read));
+            });
+
+        set.Add("MappedFile/SequentialSum/SequentialHint",
+            [](unsigned iterationCount)
+            {
+                PrepareMappedFile();
+                for (unsigned c=0; c<iterationCount; ++c)
+                    Consume(SumMappedFile(MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Sequential));
+            });
+
+        set.Add("MappedFile/SequentialSum/Populate",
+            [](unsigned iterationCount)
+            {
+                PrepareMappedFile();
+                for (unsigned c=0; c<iterationCount; ++c)
+                    Consume(SumMappedFile(MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Populate));
+            });
+
+            //  Touch one value in each of 4096 randomly selected pages
+        auto pageOrder = std::make_shared<std::vector<size_t>>(s_mappedFileSize/s_mappedFilePage);
+        for (size_t c=0; c<pageOrder->size(); ++c) (*pageOrder)[c] = c;
+        std::shuffle(pageOrder->begin(), pageOrder->end(), std::mt19937(1));
+        pageOrder->resize(4096);
+
+        auto randomPages = [pageOrder](MemoryMappedFile::Access::BitField access, unsigned iterationCount)
+            {
+                PrepareMappedFile();
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    MemoryMappedFile file(s_mappedFileName, 0, access, BasicFile::ShareMode::Read);
+                    if (!file.IsValid()) return;
+                    uint64 result = 0;
+                    for (auto p:*pageOrder)
+                        result += *(const uint64*)PtrAdd(file.GetData(), p*s_mappedFilePage);
+                    Consume(result);
+                }
+            };
+        set.Add("MappedFile/RandomPages/Default",
+            [randomPages](unsigned iterationCount) { randomPages(MemoryMappedFile::Access::Read, iterationCount); });
+        set.Add("MappedFile/RandomPages/RandomHint",
+            [randomPages](unsigned iterationCount) { randomPages(MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Random, iterationCount); });
+
+        set.Add("BasicFile/ReadAt/64KB",
+            [pageOrder](unsigned iterationCount)
+            {
+                PrepareMappedFile();
+                BasicFile file(s_mappedFileName, "rbR");
+                std::vector<uint8> buffer(64*1024);
+                const size_t blockCount = s_mappedFileSize / buffer.size();
+                uint64 result = 0;
+                for (unsigned c=0; c<iterationCount; ++c) {
+                    auto offset = ((*pageOrder)[c%pageOrder->size()] % blockCount) * buffer.size();
+                    result += file.ReadAt(offset, AsPointer(buffer.begin()), buffer.size());
+                    result += buffer[0];
+                }
+                Consume(result);
+            });
+    }
+
+    void RegisterUtilityBenchmarks(BenchmarkSet& set)
+    {
+        RegisterHashBenchmarks(set);
+        RegisterParameterBoxBenchmarks(set);
+        RegisterLRUCacheBenchmarks(set);
+        RegisterSpanningHeapBenchmarks(set);
+        RegisterFixedSizeQueueBenchmarks(set);
+        RegisterStreamFormatterBenchmarks(set);
+        RegisterDataBenchmarks(set);
+        RegisterMappedFileBenchmarks(set);
+    }
+}
+
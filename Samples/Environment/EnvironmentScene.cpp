@@ -32,9 +32,8 @@
 
 namespace Sample
 {
-    std::shared_ptr<SceneEngine::ITerrainFormat>     MainTerrainFormat;
-    SceneEngine::TerrainCoordinateSystem             MainTerrainCoords;
-    SceneEngine::TerrainConfig                       MainTerrainConfig;
+    std::shared_ptr<SceneEngine::ITerrainFormat>         MainTerrainFormat;
+    std::shared_ptr<SceneEngine::TerrainHeightQueries>   MainTerrainHeights;
 
     namespace GPUProfiler = RenderCore::Metal::GPUProfiler;
 
@@ -101,6 +100,7 @@ namespace Sample
 
         using namespace EntityInterface;
         RetainedEntityInterface interf(_retainedEntities);
+        RetainedEntities::ChangeBatch batch(*_retainedEntities);
         Deserialize(
             formatter, interf, 
             interf.GetDocumentTypeId("GameObjects"));
@@ -307,8 +307,7 @@ namespace Sample
                 _pimpl->_terrainManager->Load(container._asset);
                 _pimpl->_terrainCfgVal = container.GetDependencyValidation();
 
-                MainTerrainConfig = container._asset;
-                MainTerrainCoords = _pimpl->_terrainManager->GetCoords();
+                MainTerrainHeights = _pimpl->_terrainManager->GetHeightQueries();
 
                 if (_pimpl->_envFeatures)
                     _pimpl->_envFeatures->SetSurfaceHeights(_pimpl->_terrainManager->GetHeightsProvider());
@@ -133,7 +133,8 @@ namespace Sample
         const auto camHeight = 7.5f;
         const auto secondsPerRotation = 40.f;
         const auto rotationSpeed = -gPI * 2.f / secondsPerRotation;
-        Float3 cameraForward(XlCos(_time * rotationSpeed), XlSin(_time * rotationSpeed), 0.f);
+        const auto time = _preparedTime[_renderBuffer];
+        Float3 cameraForward(XlCos(time * rotationSpeed), XlSin(time * rotationSpeed), 0.f);
         Float3 cameraPosition = -camDist * cameraForward + Float3(0.f, 0.f, camHeight);
         result._cameraToWorld = MakeCameraToWorld(cameraForward, Float3(0.f, 0.f, 1.f), cameraPosition);
         result._farClip = 1000.f;
@@ -232,14 +233,22 @@ namespace Sample
             //  The scene parser can also provide a time value, in seconds.
             //  This is used to control rendering effects, such as wind
             //  and waves.
-        return _time; 
+        return _preparedTime[_renderBuffer]; 
     }
 
-    void BasicSceneParser::Update(float deltaTime)    { _time += deltaTime; }
+    void BasicSceneParser::PrepareSimulation(unsigned bufferIndex, float deltaTime)
+    {
+        _simulationTime += deltaTime;
+        _preparedTime[bufferIndex&1] = _simulationTime;
+    }
+
+    void BasicSceneParser::SetRenderBuffer(unsigned bufferIndex) { _renderBuffer = bufferIndex&1; }
 
     BasicSceneParser::BasicSceneParser()
     {
-        _time = 0.f;
+        _simulationTime = 0.f;
+        _preparedTime[0] = _preparedTime[1] = 0.f;
+        _renderBuffer = 0;
         _model = std::make_unique<Model>();
     }
 
@@ -20,7 +20,14 @@ namespace Sample
     {
     public:
         void PrepareFrame(RenderCore::Metal::DeviceContext* context);
-        void Update(float deltaTime);
+
+            //  The simulation state (just a time value, in this example) is double buffered,
+            //  so the simulation for the next frame can be advanced while the current frame
+            //  is rendered (see PlatformRig::FrameRig::ExecuteFrame). PrepareSimulation()
+            //  writes the buffer it is given. SetRenderBuffer() selects the buffer used by
+            //  all of the rendering methods below.
+        void PrepareSimulation(unsigned bufferIndex, float deltaTime);
+        void SetRenderBuffer(unsigned bufferIndex);
 
         typedef SceneEngine::ShadowProjectionDesc   ShadowProjectionDesc;
         typedef SceneEngine::LightingParserContext  LightingParserContext;
@@ -58,7 +65,9 @@ namespace Sample
     protected:
         class Model;
         std::unique_ptr<Model> _model;
-        float _time;
+        float _simulationTime;      // (only used by PrepareSimulation)
+        float _preparedTime[2];
+        unsigned _renderBuffer;
     };
 
 }
@@ -178,18 +178,29 @@ namespace Sample
                 SceneEngine::LightingParserContext lightingParserContext(*globalTechniqueContext);
                 lightingParserContext._plugins.push_back(stdPlugin);
 
-                auto frameResult = frameRig.ExecuteFrame(
+                    //  The frame is split into a "prepare" step (which advances the scene
+                    //  simulation) and the render step. When pipelining is enabled (from 
+                    //  the console: "MainFrameRig:SetPipelined(true)"), the FrameRig prepares
+                    //  the next frame on a worker thread while this frame is rendered
+                auto* scene = mainScene.get();
+                auto* overlaySys = frameRig.GetMainOverlaySystem().get();
+                frameRig.ExecuteFrame(
                     *context.get(), presentationChain.get(), 
                     g_gpuProfiler.get(), &g_cpuProfiler,
-                    std::bind(
-                        RenderFrame, std::placeholders::_1,
-                        std::ref(lightingParserContext), mainScene.get(), 
-                        presentationChain.get(), 
-                        frameRig.GetMainOverlaySystem().get()));
+                    [scene](unsigned bufferIndex, unsigned, float elapsedTime)
+                    {
+                        scene->PrepareSimulation(bufferIndex, elapsedTime);
+                    },
+                    [&lightingParserContext, scene, &presentationChain, overlaySys](RenderCore::IThreadContext& threadContext, unsigned bufferIndex)
+                    {
+                        scene->SetRenderBuffer(bufferIndex);
+                        return RenderFrame(
+                            threadContext, lightingParserContext, scene,
+                            presentationChain.get(), overlaySys);
+                    });
 
                     // ------- Update ----------------------------------------
                 RenderCore::Assets::Services::GetBufferUploads().Update(*context, false);
-                mainScene->Update(frameResult._elapsedTime);
                 g_cpuProfiler.EndFrame();
                 ++FrameRenderCount;
             }
@@ -284,10 +284,11 @@ namespace Sample
 
             // clamp to terrain...
         #if defined(ENABLE_TERRAIN)
-            if (MainTerrainFormat) {
+            if (MainTerrainHeights) {
+                    //  (if the height data is still loading, just keep the current height)
                 auto pos = ExtractTranslation(_localToWorld);
-                pos[2] = SceneEngine::GetTerrainHeight(*MainTerrainFormat.get(), MainTerrainConfig, MainTerrainCoords, Truncate(pos));
-                SetTranslation(_localToWorld, pos);
+                if (MainTerrainHeights->QueryHeight(Truncate(pos), pos[2]) == SceneEngine::TerrainHeightQueries::QueryResult::Success)
+                    SetTranslation(_localToWorld, pos);
             }
         #endif
 
@@ -13,8 +13,7 @@
 namespace SceneEngine
 {
     class ITerrainFormat;
-    class TerrainCoordinateSystem;
-    class TerrainConfig;
+    class TerrainHeightQueries;
 }
 
 namespace Utility { class HierarchicalCPUProfiler; }
@@ -28,9 +27,8 @@ namespace Sample
     extern Utility::HierarchicalCPUProfiler g_cpuProfiler;
 
     #if defined(ENABLE_TERRAIN)
-        extern std::shared_ptr<SceneEngine::ITerrainFormat>     MainTerrainFormat;
-        extern SceneEngine::TerrainCoordinateSystem             MainTerrainCoords;
-        extern SceneEngine::TerrainConfig                       MainTerrainConfig;
+        extern std::shared_ptr<SceneEngine::ITerrainFormat>         MainTerrainFormat;
+        extern std::shared_ptr<SceneEngine::TerrainHeightQueries>   MainTerrainHeights;
     #endif
 }
 
@@ -52,7 +52,11 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
     ::Assets::ConfigFileContainer<SceneEngine::TerrainConfig> cfg("game/centralcal");
     ToolsRig::GenerateMissingUberSurfaceFiles(cfg._asset, "game/centralcal");
-    ToolsRig::GenerateCellFiles(cfg._asset, "game/centralcal", false, SceneEngine::GradientFlagsSettings());
+        //  Heights within 5cm at the top LOD (doubling for each lower LOD), and lossless
+        //  coverage. The encoding is chosen per node, so this never makes a node larger
+    SceneEngine::TerrainEncodingSettings encoding(
+        SceneEngine::TerrainEncodingSettings::Heights::ErrorBounded, 0.05f, 2.f, true);
+    ToolsRig::GenerateCellFiles(cfg._asset, "game/centralcal", false, SceneEngine::GradientFlagsSettings(), encoding);
 
     // const unsigned nodeDims = 32;
     // const unsigned cellTreeDepth = 5;
@@ -259,6 +259,7 @@ namespace SceneEngine
         Float2 _mouseHover;
 
         PoissonSolver _poissonSolver;
+        Utility::CompletionThreadPool* _workerPool;
 
         DiffusionHelper _velocityDiffusion;
         DiffusionHelper _vaporDiffusion;
@@ -584,7 +585,8 @@ namespace SceneEngine
         AdvectionSettings advSettings {
             (AdvectionMethod)settings._advectionMethod, 
             (AdvectionInterp)settings._interpolationMethod, settings._advectionSteps,
-            AdvectionBorder::Wrap, AdvectionBorder::None, AdvectionBorder::Margin
+            AdvectionBorder::Wrap, AdvectionBorder::None, AdvectionBorder::Margin,
+            _pimpl->_workerPool
         };
         PerformAdvection(
             VectorField2D(&velUT1,      &velVT1,        _pimpl->_dimsWithBorder),
@@ -847,7 +849,8 @@ namespace SceneEngine
         AdvectionSettings advSettings {
             (AdvectionMethod)settings._advectionMethod, 
             (AdvectionInterp)settings._interpolationMethod, settings._advectionSteps,
-            AdvectionBorder::Margin, AdvectionBorder::Margin, AdvectionBorder::Margin
+            AdvectionBorder::Margin, AdvectionBorder::Margin, AdvectionBorder::Margin,
+            _pimpl->_workerPool
         };
         PerformAdvection(
             VectorField2D(&velUT1,      &velVT1,        _pimpl->_dimsWithBorder),
@@ -1085,9 +1088,10 @@ namespace SceneEngine
 
     UInt2 CloudsForm2D::GetDimensions() const { return _pimpl->_dimsWithBorder; }
 
-    CloudsForm2D::CloudsForm2D(UInt2 dimensions)
+    CloudsForm2D::CloudsForm2D(UInt2 dimensions, Utility::CompletionThreadPool* workerPool)
     {
         _pimpl = std::make_unique<Pimpl>();
+        _pimpl->_workerPool = workerPool;
         _pimpl->_dimsWithoutBorder = dimensions;
         _pimpl->_dimsWithBorder = dimensions + UInt2(2, 2);
         auto N = _pimpl->_dimsWithBorder[0] * _pimpl->_dimsWithBorder[1];
@@ -1136,7 +1140,7 @@ namespace SceneEngine
 
         }
 
-        _pimpl->_poissonSolver = PoissonSolver(2, &_pimpl->_dimsWithBorder[0]);
+        _pimpl->_poissonSolver = PoissonSolver(2, &_pimpl->_dimsWithBorder[0], workerPool);
     }
 
     CloudsForm2D::~CloudsForm2D(){}
@@ -12,6 +12,7 @@
 #include "../Math/Vector.h"
 
 namespace RenderCore { namespace Techniques { class ProjectionDesc; }}
+namespace Utility { class CompletionThreadPool; }
 
 namespace SceneEngine
 {
@@ -78,7 +79,7 @@ namespace SceneEngine
             RenderCore::IThreadContext* context, 
             const RenderCore::Techniques::ProjectionDesc& projDesc);
 
-        CloudsForm2D(UInt2 dimensions);
+        CloudsForm2D(UInt2 dimensions, Utility::CompletionThreadPool* workerPool = nullptr);
         ~CloudsForm2D();
 
     private:
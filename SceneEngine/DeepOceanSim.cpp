@@ -24,6 +24,7 @@
 #include "../Utility/StringFormat.h"
 #include "../Utility/BitUtils.h"
 #include "../Utility/ParameterBox.h"
+#include <random>
 
 namespace SceneEngine
 {
@@ -32,27 +33,7 @@ namespace SceneEngine
     class StartingSpectrumBox
     {
     public:
-        class Desc
-        {
-        public:
-            unsigned    _width, _height;
-            Float2      _physicalDimensions;
-            Float2      _windVector;
-            float       _scaleAgainstWind;
-            float       _suppressionFactor;
-            float       _spectrumMin, _spectrumMax;
-
-            Desc(   unsigned width, unsigned height, const 
-                    Float2& physicalDimensions, const Float2& windVector, 
-                    float scaleAgainstWind, float suppressionFactor,
-                    float spectrumMin, float spectrumMax)
-            {   
-                _width = width; _height = height; _windVector = windVector; 
-                _physicalDimensions = physicalDimensions; 
-                _scaleAgainstWind = scaleAgainstWind; _suppressionFactor = suppressionFactor; 
-                _spectrumMin = spectrumMin; _spectrumMax = spectrumMax;
-            }
-        };
+        using Desc = Internal::OceanSpectrumDesc;
 
         StartingSpectrumBox(const Desc& desc);
         ~StartingSpectrumBox();
@@ -73,21 +54,11 @@ namespace SceneEngine
         const DeepOceanSimSettings& oceanSettings, unsigned bufferCounter)
     {
         const unsigned dimensions = oceanSettings._gridDimensions;
-        const Float2 physicalDimensions = Float2(oceanSettings._physicalDimensions, oceanSettings._physicalDimensions);
-
-        const Float2 calmWindVector = oceanSettings._windVelocity[0] * Float2(XlCos(oceanSettings._windAngle[0]), XlSin(oceanSettings._windAngle[0]));
-        const Float2 strongWindVector = oceanSettings._windVelocity[1] * Float2(XlCos(oceanSettings._windAngle[1]), XlSin(oceanSettings._windAngle[1]));
 
         auto& calmSpectrum = Techniques::FindCachedBox<StartingSpectrumBox>(
-            StartingSpectrumBox::Desc(
-                dimensions, dimensions, physicalDimensions, 
-                calmWindVector, oceanSettings._scaleAgainstWind[0], oceanSettings._suppressionFactor[0],
-                oceanSettings._spectrumMin, oceanSettings._spectrumMax));
+            Internal::BuildOceanSpectrumDesc(oceanSettings, 0));
         auto& strongSpectrum = Techniques::FindCachedBox<StartingSpectrumBox>(
-            StartingSpectrumBox::Desc(
-                dimensions, dimensions, physicalDimensions, 
-                strongWindVector, oceanSettings._scaleAgainstWind[1], oceanSettings._suppressionFactor[1],
-                oceanSettings._spectrumMin, oceanSettings._spectrumMax));
+            Internal::BuildOceanSpectrumDesc(oceanSettings, 1));
     
         const char* fftDefines = "";
         auto useMirrorOptimisation = Tweakable("OceanUseMirrorOptimisation", true);
@@ -206,19 +177,10 @@ namespace SceneEngine
     {
         using namespace RenderCore;
 
-        const unsigned dimensions       = oceanSettings._gridDimensions;
-        const Float2 physicalDimensions = Float2(oceanSettings._physicalDimensions, oceanSettings._physicalDimensions);
-        const Float2 calmWindVector     = oceanSettings._windVelocity[0] * Float2(XlCos(oceanSettings._windAngle[0]), XlSin(oceanSettings._windAngle[0]));
-        const Float2 strongWindVector   = oceanSettings._windVelocity[1] * Float2(XlCos(oceanSettings._windAngle[1]), XlSin(oceanSettings._windAngle[1]));
-
         auto& calmSpectrum = Techniques::FindCachedBox<StartingSpectrumBox>(
-            StartingSpectrumBox::Desc(  dimensions,dimensions, physicalDimensions, calmWindVector, 
-                                        oceanSettings._scaleAgainstWind[0], oceanSettings._suppressionFactor[0],
-                                        oceanSettings._spectrumMin, oceanSettings._spectrumMax));
+            Internal::BuildOceanSpectrumDesc(oceanSettings, 0));
         auto& strongSpectrum = Techniques::FindCachedBox<StartingSpectrumBox>(
-            StartingSpectrumBox::Desc(  dimensions,dimensions, physicalDimensions, strongWindVector, 
-                                        oceanSettings._scaleAgainstWind[1], oceanSettings._suppressionFactor[1],
-                                        oceanSettings._spectrumMin, oceanSettings._spectrumMax));
+            Internal::BuildOceanSpectrumDesc(oceanSettings, 1));
 
         SetupVertexGeneratorShader(context);
         context.Bind(Techniques::CommonResources()._blendStraightAlpha);
@@ -254,7 +216,16 @@ namespace SceneEngine
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-    static std::pair<float, float> RandomGaussian(float variance)
+        //  Our random numbers must be the same on every platform (so clients and servers
+        //  agree on the shape of the ocean). The mt19937 output sequence is fully defined
+        //  by the standard, but the std distribution classes aren't, so we do the
+        //  conversion to float ourselves.
+    static float RandomUnitFloat(std::mt19937& rng)
+    {
+        return float(rng()) / float(std::mt19937::max());
+    }
+
+    static std::pair<float, float> RandomGaussian(std::mt19937& rng, float variance)
     {
             //  calculate 2 random numbers using the box muller technique
             //  (see http://en.wikipedia.org/wiki/Box%E2%80%93Muller_transform)
@@ -263,8 +234,8 @@ namespace SceneEngine
         const int method = 1;
         if (constant_expression<method == 0>::result()) {
             return std::make_pair(
-                LinearInterpolate(-1.f, 1.f, rand() / float(RAND_MAX)),
-                LinearInterpolate(-1.f, 1.f, rand() / float(RAND_MAX)));
+                LinearInterpolate(-1.f, 1.f, RandomUnitFloat(rng)),
+                LinearInterpolate(-1.f, 1.f, RandomUnitFloat(rng)));
         }
 
         const bool polarMethod = method==1;
@@ -272,100 +243,136 @@ namespace SceneEngine
             float w;
             float r0, r1;
             do {
-                r0 = LinearInterpolate(-1.f, 1.f, rand() / float(RAND_MAX));
-                r1 = LinearInterpolate(-1.f, 1.f, rand() / float(RAND_MAX));
+                r0 = LinearInterpolate(-1.f, 1.f, RandomUnitFloat(rng));
+                r1 = LinearInterpolate(-1.f, 1.f, RandomUnitFloat(rng));
                 w = r0 * r0 + r1 * r1;
-            } while (w >= 1.f);
+            } while (w >= 1.f || w == 0.f);
 
             float scale = XlSqrt(-2.f * XlLog(w) / w);
             return std::make_pair(r0 * scale, r1 * scale);
         } else {
-            float r0 = (rand()+1) / float(RAND_MAX);        // (prevent 0 result)
+            float r0 = (float(rng())+1.f) / float(std::mt19937::max());        // (prevent 0 result)
             r0 = -2.f * XlLog(r0);
-            float r1 = 2.f * gPI * rand() / float(RAND_MAX);
+            float r1 = 2.f * gPI * RandomUnitFloat(rng);
             float a = XlSqrt(variance * r0);
             return std::make_pair(a * XlCos(r1), a * XlSin(r1));
         }
     }
 
-    StartingSpectrumBox::StartingSpectrumBox(const Desc& desc) 
+    namespace Internal
     {
-        using namespace BufferUploads;
-        auto& uploads = GetBufferUploads();
+        OceanSpectrumDesc::OceanSpectrumDesc(
+            unsigned width, unsigned height, 
+            const Float2& physicalDimensions, const Float2& windVector, 
+            float scaleAgainstWind, float suppressionFactor,
+            float spectrumMin, float spectrumMax,
+            unsigned randomSeed)
+        {
+            _width = width; _height = height; _windVector = windVector; 
+            _physicalDimensions = physicalDimensions; 
+            _scaleAgainstWind = scaleAgainstWind; _suppressionFactor = suppressionFactor; 
+            _spectrumMin = spectrumMin; _spectrumMax = spectrumMax;
+            _randomSeed = randomSeed;
+        }
 
-        auto realValues      = std::make_unique<float[]>(desc._width*desc._height);
-        auto imaginaryValues = std::make_unique<float[]>(desc._width*desc._height);
+        OceanSpectrumDesc BuildOceanSpectrumDesc(const DeepOceanSimSettings& oceanSettings, unsigned windIndex)
+        {
+            const unsigned dimensions = oceanSettings._gridDimensions;
+            const Float2 windVector = oceanSettings._windVelocity[windIndex] 
+                * Float2(XlCos(oceanSettings._windAngle[windIndex]), XlSin(oceanSettings._windAngle[windIndex]));
+            return OceanSpectrumDesc(
+                dimensions, dimensions, 
+                Float2(oceanSettings._physicalDimensions, oceanSettings._physicalDimensions),
+                windVector, oceanSettings._scaleAgainstWind[windIndex], oceanSettings._suppressionFactor[windIndex],
+                oceanSettings._spectrumMin, oceanSettings._spectrumMax,
+                windIndex);
+        }
 
-            //
-            //      Build input to FFT
-            //          using Phillip's spectrum, as suggested by Tessendorf (and commonly used)
-            //
-        const float windVelocity = Magnitude(desc._windVector);
-        Float2 windDirection = desc._windVector / windVelocity;
-        const float gravitionalConstant = 9.8f;
-        const float L = windVelocity * windVelocity / gravitionalConstant;
-        const float Lx = desc._physicalDimensions[0], Ly = desc._physicalDimensions[1];     // physical dimensions of the water grid
-        const float l = desc._suppressionFactor;
-        const float A = 1.f;
-
-        // #define DO_FREQ_BOOST 1
-        #if (DO_FREQ_BOOST==1)
-            const float freqBoost = 2.f;
-        #else
-            const float freqBoost = 1.f;
-        #endif
-
-        float maxMag = (freqBoost * 2.f * gPI) * Magnitude(Float2(desc._width * .5f / Lx, desc._height * .5f / Ly));
-        float kMin = maxMag * desc._spectrumMin;
-        float kMax = maxMag * desc._spectrumMax;
+        void BuildOceanSpectrum(float realValues[], float imaginaryValues[], const OceanSpectrumDesc& desc)
+        {
+            std::mt19937 rng(desc._randomSeed);
+
+                //
+                //      Build input to FFT
+                //          using Phillip's spectrum, as suggested by Tessendorf (and commonly used)
+                //
+            const float windVelocity = Magnitude(desc._windVector);
+            Float2 windDirection = desc._windVector / windVelocity;
+            const float gravitionalConstant = 9.8f;
+            const float L = windVelocity * windVelocity / gravitionalConstant;
+            const float Lx = desc._physicalDimensions[0], Ly = desc._physicalDimensions[1];     // physical dimensions of the water grid
+            const float l = desc._suppressionFactor;
+            const float A = 1.f;
+
+            // #define DO_FREQ_BOOST 1
+            #if (DO_FREQ_BOOST==1)
+                const float freqBoost = 2.f;
+            #else
+                const float freqBoost = 1.f;
+            #endif
+
+            float maxMag = (freqBoost * 2.f * gPI) * Magnitude(Float2(desc._width * .5f / Lx, desc._height * .5f / Ly));
+            float kMin = maxMag * desc._spectrumMin;
+            float kMax = maxMag * desc._spectrumMax;
                     
-        for (unsigned y=0; y<desc._height; ++y) {
-            for (unsigned x=0; x<desc._width; ++x) {
-                float n = x + .5f - float(desc._width/2);
-                float m = y + .5f - float(desc._height/2);
-
-                    //  Actually, I'm not sure if the coefficient here should be 2.f or 4.f
-                    //  (because n is a value between -.5f and 5.f). That's what freqBoost is
-                    //  for. Even if freqBoost isn't physically accurate, it might help us get
-                    //  more high frequency waves.
-                Float2 kVector = (freqBoost * 2.f * gPI) * Float2(n / Lx, m / Ly);
-                float k = Magnitude(kVector);
-
-                float directionalPart = 1.f;
-                float suppressionPart = 1.f; 
-                float Ph = 0.f;
-
-                if (n!=0.f || m!=0.f) {
-                    directionalPart = Dot(windDirection, kVector) / k;
-                    if (directionalPart < 0.f) {
-                        directionalPart *= desc._scaleAgainstWind;
+            for (unsigned y=0; y<desc._height; ++y) {
+                for (unsigned x=0; x<desc._width; ++x) {
+                    float n = x + .5f - float(desc._width/2);
+                    float m = y + .5f - float(desc._height/2);
+
+                        //  Actually, I'm not sure if the coefficient here should be 2.f or 4.f
+                        //  (because n is a value between -.5f and 5.f). That's what freqBoost is
+                        //  for. Even if freqBoost isn't physically accurate, it might help us get
+                        //  more high frequency waves.
+                    Float2 kVector = (freqBoost * 2.f * gPI) * Float2(n / Lx, m / Ly);
+                    float k = Magnitude(kVector);
+
+                    float directionalPart = 1.f;
+                    float suppressionPart = 1.f; 
+                    float Ph = 0.f;
+
+                    if (n!=0.f || m!=0.f) {
+                        directionalPart = Dot(windDirection, kVector) / k;
+                        if (directionalPart < 0.f) {
+                            directionalPart *= desc._scaleAgainstWind;
+                        }
+                        directionalPart *= directionalPart;
+
+                        suppressionPart = XlExp(-k*k*l*l);
+            
+                        float k4 = k * k; k4 *= k4;
+                        Ph = A * directionalPart * suppressionPart * XlExp(-1.f / (k*k*L*L)) / k4;
                     }
-                    directionalPart *= directionalPart;
 
-                    suppressionPart = XlExp(-k*k*l*l);
-            
-                    float k4 = k * k; k4 *= k4;
-                    Ph = A * directionalPart * suppressionPart * XlExp(-1.f / (k*k*L*L)) / k4;
-                }
+                        //  Note that the random values returned are related to
+                        //  each other slightly... It might be better if the 2 elements
+                        //  of the complex number are not related at all.
+                    auto randomValues = RandomGaussian(rng, 1.f);
+                    // randomValues.second = RandomGaussian(1.f).first;        // second tap of the algorithm to guarantee good results
+                    float b = gReciprocalSqrt2 * XlSqrt(Ph);
+                    float realPart       = randomValues.first * b;
+                    float imaginaryPart  = randomValues.second * b;
+
+                    if (k < kMin || k > kMax) {
+                        realPart = 0.f;
+                        imaginaryPart = 0.f;
+                    }
 
-                    //  Note that the random values returned are related to
-                    //  each other slightly... It might be better if the 2 elements
-                    //  of the complex number are not related at all.
-                auto randomValues = RandomGaussian(1.f);
-                // randomValues.second = RandomGaussian(1.f).first;        // second tap of the algorithm to guarantee good results
-                float b = gReciprocalSqrt2 * XlSqrt(Ph);
-                float realPart       = randomValues.first * b;
-                float imaginaryPart  = randomValues.second * b;
-
-                if (k < kMin || k > kMax) {
-                    realPart = 0.f;
-                    imaginaryPart = 0.f;
+                    realValues[y*desc._width+x] = realPart;
+                    imaginaryValues[y*desc._width+x] = imaginaryPart;
                 }
-
-                realValues[y*desc._width+x] = realPart;
-                imaginaryValues[y*desc._width+x] = imaginaryPart;
             }
         }
+    }
+
+    StartingSpectrumBox::StartingSpectrumBox(const Desc& desc) 
+    {
+        using namespace BufferUploads;
+        auto& uploads = GetBufferUploads();
+
+        auto realValues      = std::make_unique<float[]>(desc._width*desc._height);
+        auto imaginaryValues = std::make_unique<float[]>(desc._width*desc._height);
+        Internal::BuildOceanSpectrum(realValues.get(), imaginaryValues.get(), desc);
 
         auto bufferUploadsDesc = BuildRenderTargetDesc(
             BindFlag::ShaderResource, 
@@ -10,6 +10,7 @@
 #include "../RenderCore/Metal/ShaderResource.h"
 #include "../RenderCore/Metal/RenderTargetView.h"
 #include "../BufferUploads/IBufferUploads_Forward.h"
+#include "../Math/Vector.h"
 #include <vector>
 
 namespace BufferUploads { class ResourceLocator; }
@@ -137,5 +138,31 @@ namespace SceneEngine
 
         OceanMaterialConstants BuildOceanMaterialConstants(
             const DeepOceanSimSettings& oceanSettings, float shallowGridPhysicalDimension);
+
+            //  Parameters for the starting spectrum ("h0") of the FFT. There are 2 spectrums 
+            //  (for calm and strong wind); the sim fades between them with "_spectrumFade".
+            //  The random phases come from a seeded generator, so the GPU and CPU sims
+            //  (and different machines) build exactly the same spectrum.
+        class OceanSpectrumDesc
+        {
+        public:
+            unsigned    _width, _height;
+            Float2      _physicalDimensions;
+            Float2      _windVector;
+            float       _scaleAgainstWind;
+            float       _suppressionFactor;
+            float       _spectrumMin, _spectrumMax;
+            unsigned    _randomSeed;
+
+            OceanSpectrumDesc(
+                unsigned width, unsigned height, 
+                const Float2& physicalDimensions, const Float2& windVector, 
+                float scaleAgainstWind, float suppressionFactor,
+                float spectrumMin, float spectrumMax,
+                unsigned randomSeed);
+        };
+
+        OceanSpectrumDesc BuildOceanSpectrumDesc(const DeepOceanSimSettings& oceanSettings, unsigned windIndex);
+        void BuildOceanSpectrum(float realValues[], float imaginaryValues[], const OceanSpectrumDesc& desc);
     }
 }
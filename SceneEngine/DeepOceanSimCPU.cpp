@@ -0,0 +1,599 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "DeepOceanSimCPU.h"
+#include "DeepOceanSim.h"
+#include "../Math/Math.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include "../Utility/MemoryUtils.h"
+#include "../Utility/BitUtils.h"
+#include "../Utility/PtrUtils.h"
+#include "../Core/Exceptions.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+#include <emmintrin.h>
+
+namespace SceneEngine
+{
+    using AlignedFloats = std::unique_ptr<float[], PODAlignedDeletor>;
+
+    static AlignedFloats MakeAlignedFloats(size_t count)
+    {
+        return AlignedFloats((float*)XlMemAlign(sizeof(float)*count, 16));
+    }
+
+    class DeepOceanSimCPU::Pimpl
+    {
+    public:
+        unsigned        _dimensions;
+        uint64          _spectrumHash;
+
+        AlignedFloats   _spectrum;          // calm real, calm imaginary, strong real, strong imaginary
+        AlignedFloats   _waveTables;        // "w", and normalized k.x & k.y for each texel
+        AlignedFloats   _working;           // real & imaginary planes for heights, X and Y
+        AlignedFloats   _displacement;      // 4 floats per texel
+        AlignedFloats   _twiddles;          // dimensions/2 real parts, then dimensions/2 imaginary parts
+        std::vector<unsigned> _bitReverse;
+
+        Float2          _gridShift;
+        float           _physicalDimensions;
+        float           _baseHeight;
+
+        CompletionThreadPool* _workerPool;
+
+        void Resize(unsigned dimensions);
+        void BuildSpectrum(const DeepOceanSimSettings& settings);
+        void Setup(unsigned rowBegin, unsigned rowEnd, float spectrumFade, float time);
+        void RowFFT(unsigned blockBegin, unsigned blockEnd);
+        void ColumnFFTAndResolve(unsigned blockBegin, unsigned blockEnd, float scaleXY, float scaleZ);
+
+        template<typename Fn> void ForEachBlock(unsigned blockCount, Fn&& fn);
+
+        __m128 SampleDisplacement(Float2 texelCoords) const;
+        Float2 FindBasePosition(Float2 worldPosition, Float2& texelCoords) const;
+
+        float* Plane(unsigned index) { return &_working[index*_dimensions*_dimensions]; }
+    };
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void DeepOceanSimCPU::Pimpl::Resize(unsigned dimensions)
+    {
+        const unsigned texelCount = dimensions*dimensions;
+        _spectrum = MakeAlignedFloats(texelCount*4);
+        _waveTables = MakeAlignedFloats(texelCount*3);
+        _working = MakeAlignedFloats(texelCount*6);
+        _displacement = MakeAlignedFloats(texelCount*4);
+        std::fill(_displacement.get(), &_displacement[texelCount*4], 0.f);
+
+            //  Twiddle factors for the forward transform (exp(-2.pi.i.k/N)). Calculating these
+            //  in double precision is a little more accurate than the trigonometric recurrence
+            //  used by the GPU shader.
+        _twiddles = MakeAlignedFloats(dimensions);
+        for (unsigned k=0; k<dimensions/2; ++k) {
+            double angle = -2.0 * 3.14159265358979323846 * double(k) / double(dimensions);
+            _twiddles[k] = float(std::cos(angle));
+            _twiddles[dimensions/2+k] = float(std::sin(angle));
+        }
+
+        unsigned bitCount = IntegerLog2(dimensions);
+        _bitReverse.resize(dimensions);
+        for (unsigned i=0; i<dimensions; ++i) {
+            unsigned r = 0;
+            for (unsigned b=0; b<bitCount; ++b)
+                if (i & (1<<b)) r |= 1 << (bitCount-1-b);
+            _bitReverse[i] = r;
+        }
+
+        _dimensions = dimensions;
+        _spectrumHash = 0;
+    }
+
+    void DeepOceanSimCPU::Pimpl::BuildSpectrum(const DeepOceanSimSettings& settings)
+    {
+        const unsigned texelCount = _dimensions*_dimensions;
+        Internal::BuildOceanSpectrum(
+            &_spectrum[0], &_spectrum[texelCount],
+            Internal::BuildOceanSpectrumDesc(settings, 0));
+        Internal::BuildOceanSpectrum(
+            &_spectrum[texelCount*2], &_spectrum[texelCount*3],
+            Internal::BuildOceanSpectrumDesc(settings, 1));
+
+            //  "w" and the direction of k don't change with time, so we can calculate them
+            //  once here (the GPU recalculates them every frame)
+        float* omega = &_waveTables[0];
+        float* directionX = &_waveTables[texelCount];
+        float* directionY = &_waveTables[texelCount*2];
+        const float freqBoost = 1.f;
+        const float gravitationalConstant = 9.8f;
+        const float gridMidPoint = float(_dimensions)/2.f;
+        for (unsigned y=0; y<_dimensions; ++y)
+            for (unsigned x=0; x<_dimensions; ++x) {
+                const float kx = freqBoost * 2.f * gPI * (float(x) + .5f - gridMidPoint) / settings._physicalDimensions;
+                const float ky = freqBoost * 2.f * gPI * (float(y) + .5f - gridMidPoint) / settings._physicalDimensions;
+                const float magK = XlSqrt(kx*kx + ky*ky);
+                const unsigned i = y*_dimensions+x;
+                omega[i] = XlSqrt(magK*gravitationalConstant);
+                if (magK > 0.00001f) {
+                    directionX[i] = kx / magK;
+                    directionY[i] = ky / magK;
+                } else {
+                    directionX[i] = directionY[i] = 0.f;
+                }
+            }
+    }
+
+        //  4 wide sine & cosine, using the range reduction and polynomials from Cephes.
+        //  Accurate to a few ulps for |x| < 8192 (returns false if the input is outside
+        //  of that range). 
+    static bool SinCos4(__m128 x, __m128& sine, __m128& cosine)
+    {
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+        __m128 sinSign = _mm_and_ps(x, signMask);
+        x = _mm_andnot_ps(signMask, x);
+        if (_mm_movemask_ps(_mm_cmpgt_ps(x, _mm_set1_ps(8192.f))))
+            return false;
+
+            //  j is the octant, rounded up to an even number
+        __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+        j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+        __m128 y = _mm_cvtepi32_ps(j);
+
+        __m128 sinSwap = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+        __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+            _mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+        __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+        sinSign = _mm_xor_ps(sinSign, sinSwap);
+
+            //  extended precision modular arithmetic: x - y*pi/4
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+        __m128 z = _mm_mul_ps(x, x);
+
+        __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+        c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+        c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(.5f)));
+        c = _mm_add_ps(c, _mm_set1_ps(1.f));
+
+        __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+        s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+        s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+        s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+        sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(polyMask, s), _mm_andnot_ps(polyMask, c)), sinSign);
+        cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(polyMask, c), _mm_andnot_ps(polyMask, s)), cosSign);
+        return true;
+    }
+
+    static __m128 Reverse(__m128 x) { return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0,1,2,3)); }
+
+    void DeepOceanSimCPU::Pimpl::Setup(unsigned rowBegin, unsigned rowEnd, float spectrumFade, float time)
+    {
+            //  This is the same as the "Setup" shader in FFT.csh (including the mirror
+            //  optimisation). Half of the grid is the conjugate of the other half, so we
+            //  calculate 2 outputs at a time. We work on 4 texels at once; the mirrored 
+            //  texels are the same 4 in reverse order.
+        const unsigned N = _dimensions;
+        const unsigned texelCount = N*N;
+        const float* calmReal = &_spectrum[0];
+        const float* calmImaginary = &_spectrum[texelCount];
+        const float* strongReal = &_spectrum[texelCount*2];
+        const float* strongImaginary = &_spectrum[texelCount*3];
+        const float* omega = &_waveTables[0];
+        const float* directionX = &_waveTables[texelCount];
+        const float* directionY = &_waveTables[texelCount*2];
+        float* heightsReal = Plane(0); float* heightsImaginary = Plane(1);
+        float* xReal = Plane(2); float* xImaginary = Plane(3);
+        float* yReal = Plane(4); float* yImaginary = Plane(5);
+
+        const __m128 fade = _mm_set1_ps(spectrumFade);
+        const __m128 t = _mm_set1_ps(time);
+        const __m128 zero = _mm_setzero_ps();
+        auto lerp = [fade](const float* a, const float* b, unsigned i)
+            {
+                __m128 a4 = _mm_load_ps(&a[i]);
+                return _mm_add_ps(a4, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&b[i]), a4), fade));
+            };
+
+        for (unsigned y=rowBegin; y<rowEnd; ++y) {
+            unsigned x=0;
+            for (; (x+4)<=N/2; x+=4) {
+                const unsigned k = y*N+x, negK = y*N+(N-4-x);
+                __m128 s, c;
+                if (!SinCos4(_mm_mul_ps(_mm_load_ps(&omega[k]), t), s, c)) break;
+
+                __m128 h0kr = lerp(calmReal, strongReal, k);
+                __m128 h0ki = lerp(calmImaginary, strongImaginary, k);
+                __m128 h0nr = Reverse(lerp(calmReal, strongReal, negK));
+                __m128 h0ni = Reverse(lerp(calmImaginary, strongImaginary, negK));
+
+                    //  result = h0(k) * exp(iwt) + conj(h0(-k)) * exp(-iwt)
+                __m128 rr = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(h0kr, h0nr), c), _mm_mul_ps(_mm_add_ps(h0ki, h0ni), s));
+                __m128 ri = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(h0ki, h0ni), c), _mm_mul_ps(_mm_sub_ps(h0kr, h0nr), s));
+                _mm_store_ps(&heightsReal[k], rr); _mm_store_ps(&heightsImaginary[k], ri);
+                _mm_store_ps(&heightsReal[negK], Reverse(rr)); _mm_store_ps(&heightsImaginary[negK], Reverse(_mm_sub_ps(zero, ri)));
+
+                    //  X & Y displacement are result * (0, -k/|k|) (and the mirrored
+                    //  output uses -k.x)
+                __m128 dx = _mm_load_ps(&directionX[k]), dy = _mm_load_ps(&directionY[k]);
+                __m128 dxri = _mm_mul_ps(dx, ri), dxrr = _mm_mul_ps(dx, rr);
+                __m128 dyri = _mm_mul_ps(dy, ri), dyrr = _mm_mul_ps(dy, rr);
+                _mm_store_ps(&xReal[k], dxri); _mm_store_ps(&xImaginary[k], _mm_sub_ps(zero, dxrr));
+                _mm_store_ps(&yReal[k], dyri); _mm_store_ps(&yImaginary[k], _mm_sub_ps(zero, dyrr));
+                _mm_store_ps(&xReal[negK], Reverse(dxri)); _mm_store_ps(&xImaginary[negK], Reverse(dxrr));
+                _mm_store_ps(&yReal[negK], Reverse(_mm_sub_ps(zero, dyri))); _mm_store_ps(&yImaginary[negK], Reverse(_mm_sub_ps(zero, dyrr)));
+            }
+
+                //  Scalar path for very small grids, and when "w*t" is too large for SinCos4
+            for (; x<N/2; ++x) {
+                const unsigned k = y*N+x, negK = y*N+(N-1-x);
+                float h0kr = LinearInterpolate(calmReal[k], strongReal[k], spectrumFade);
+                float h0ki = LinearInterpolate(calmImaginary[k], strongImaginary[k], spectrumFade);
+                float h0nr = LinearInterpolate(calmReal[negK], strongReal[negK], spectrumFade);
+                float h0ni = LinearInterpolate(calmImaginary[negK], strongImaginary[negK], spectrumFade);
+
+                auto sc = XlSinCos(omega[k]*time);
+                float s = std::get<0>(sc), c = std::get<1>(sc);
+                float rr = (h0kr + h0nr) * c - (h0ki + h0ni) * s;
+                float ri = (h0ki - h0ni) * c + (h0kr - h0nr) * s;
+                heightsReal[k] = rr; heightsImaginary[k] = ri;
+                heightsReal[negK] = rr; heightsImaginary[negK] = -ri;
+
+                float dx = directionX[k], dy = directionY[k];
+                xReal[k] = dx * ri; xImaginary[k] = -dx * rr;
+                yReal[k] = dy * ri; yImaginary[k] = -dy * rr;
+                xReal[negK] = dx * ri; xImaginary[negK] = dx * rr;
+                yReal[negK] = -dy * ri; yImaginary[negK] = -dy * rr;
+            }
+        }
+    }
+
+        //  In-place radix 2 forward FFT of 4 sequences at once. "real" and "imaginary" are
+        //  arrays of N __m128s (one lane per sequence), already in bit reversed order.
+        //  There's no scaling (the same as the non-inverse transform in FFT.csh)
+    static void FFT4(__m128* real, __m128* imaginary, unsigned N, const float twiddles[])
+    {
+        const float* twiddlesReal = twiddles;
+        const float* twiddlesImaginary = &twiddles[N/2];
+
+            //  The first 2 passes have trivial twiddle factors (1 and -i), so we
+            //  can do them together without any multiplies
+        for (unsigned a=0; a<N; a+=4) {
+            __m128 r0 = _mm_add_ps(real[a], real[a+1]), i0 = _mm_add_ps(imaginary[a], imaginary[a+1]);
+            __m128 r1 = _mm_sub_ps(real[a], real[a+1]), i1 = _mm_sub_ps(imaginary[a], imaginary[a+1]);
+            __m128 r2 = _mm_add_ps(real[a+2], real[a+3]), i2 = _mm_add_ps(imaginary[a+2], imaginary[a+3]);
+            __m128 r3 = _mm_sub_ps(real[a+2], real[a+3]), i3 = _mm_sub_ps(imaginary[a+2], imaginary[a+3]);
+            real[a] = _mm_add_ps(r0, r2); imaginary[a] = _mm_add_ps(i0, i2);
+            real[a+2] = _mm_sub_ps(r0, r2); imaginary[a+2] = _mm_sub_ps(i0, i2);
+                // (r3, i3) * -i = (i3, -r3)
+            real[a+1] = _mm_add_ps(r1, i3); imaginary[a+1] = _mm_sub_ps(i1, r3);
+            real[a+3] = _mm_sub_ps(r1, i3); imaginary[a+3] = _mm_add_ps(i1, r3);
+        }
+
+        for (unsigned half=4; half<N; half<<=1) {
+            const unsigned twiddleStep = N/(2*half);
+            for (unsigned j=0; j<half; ++j) {
+                const __m128 wr = _mm_set1_ps(twiddlesReal[j*twiddleStep]);
+                const __m128 wi = _mm_set1_ps(twiddlesImaginary[j*twiddleStep]);
+                for (unsigned a=j; a<N; a+=2*half) {
+                    const unsigned b = a+half;
+                    __m128 tr = _mm_sub_ps(_mm_mul_ps(real[b], wr), _mm_mul_ps(imaginary[b], wi));
+                    __m128 ti = _mm_add_ps(_mm_mul_ps(real[b], wi), _mm_mul_ps(imaginary[b], wr));
+                    real[b] = _mm_sub_ps(real[a], tr);
+                    imaginary[b] = _mm_sub_ps(imaginary[a], ti);
+                    real[a] = _mm_add_ps(real[a], tr);
+                    imaginary[a] = _mm_add_ps(imaginary[a], ti);
+                }
+            }
+        }
+    }
+
+    void DeepOceanSimCPU::Pimpl::RowFFT(unsigned blockBegin, unsigned blockEnd)
+    {
+            //  Rows are transposed into a working buffer 4 at a time, so the FFT can
+            //  work on 4 rows in parallel
+        const unsigned N = _dimensions;
+        std::unique_ptr<__m128, PODAlignedDeletor> scratch((__m128*)XlMemAlign(sizeof(__m128)*N*2, 16));
+        __m128* scratchReal = scratch.get();
+        __m128* scratchImaginary = &scratch.get()[N];
+
+        for (unsigned block=blockBegin; block<blockEnd; ++block) {
+            for (unsigned grid=0; grid<3; ++grid) {
+                float* planes[] = { Plane(grid*2) + block*4*N, Plane(grid*2+1) + block*4*N };
+                __m128* scratchPlanes[] = { scratchReal, scratchImaginary };
+
+                for (unsigned p=0; p<2; ++p)
+                    for (unsigned i=0; i<N; i+=4) {
+                        __m128 r0 = _mm_load_ps(&planes[p][0*N+i]);
+                        __m128 r1 = _mm_load_ps(&planes[p][1*N+i]);
+                        __m128 r2 = _mm_load_ps(&planes[p][2*N+i]);
+                        __m128 r3 = _mm_load_ps(&planes[p][3*N+i]);
+                        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                        scratchPlanes[p][_bitReverse[i+0]] = r0;
+                        scratchPlanes[p][_bitReverse[i+1]] = r1;
+                        scratchPlanes[p][_bitReverse[i+2]] = r2;
+                        scratchPlanes[p][_bitReverse[i+3]] = r3;
+                    }
+
+                FFT4(scratchReal, scratchImaginary, N, _twiddles.get());
+
+                for (unsigned p=0; p<2; ++p)
+                    for (unsigned i=0; i<N; i+=4) {
+                        __m128 r0 = scratchPlanes[p][i+0], r1 = scratchPlanes[p][i+1];
+                        __m128 r2 = scratchPlanes[p][i+2], r3 = scratchPlanes[p][i+3];
+                        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                        _mm_store_ps(&planes[p][0*N+i], r0);
+                        _mm_store_ps(&planes[p][1*N+i], r1);
+                        _mm_store_ps(&planes[p][2*N+i], r2);
+                        _mm_store_ps(&planes[p][3*N+i], r3);
+                    }
+            }
+        }
+    }
+
+    void DeepOceanSimCPU::Pimpl::ColumnFFTAndResolve(
+        unsigned blockBegin, unsigned blockEnd, float scaleXY, float scaleZ)
+    {
+            //  Columns are 4 adjacent floats, so they can be transformed 4 at a time
+            //  without a transpose. We gather 4 blocks at once, so each row read is a 
+            //  full cache line (otherwise the large power of 2 stride between rows 
+            //  causes a lot of cache misses).
+            //  After the transform, we only need the real parts; these get the (-1)^(x+y)
+            //  sign flip and the strength constants, and are interleaved into the final
+            //  displacement grid.
+        const unsigned N = _dimensions;
+        const unsigned blocksPerGroup = 4;
+        std::unique_ptr<__m128, PODAlignedDeletor> scratch(
+            (__m128*)XlMemAlign(sizeof(__m128)*N*blocksPerGroup*(2+3), 16));
+        __m128* scratchReal = scratch.get();
+        __m128* scratchImaginary = &scratch.get()[N*blocksPerGroup];
+        __m128* results = &scratch.get()[N*blocksPerGroup*2];      // [grid][block][row]
+
+        const __m128 evenRowScale[] = {
+            _mm_setr_ps(scaleXY, -scaleXY, scaleXY, -scaleXY),
+            _mm_setr_ps(scaleZ, -scaleZ, scaleZ, -scaleZ) };
+        const __m128 oddRowScale[] = {
+            _mm_sub_ps(_mm_setzero_ps(), evenRowScale[0]),
+            _mm_sub_ps(_mm_setzero_ps(), evenRowScale[1]) };
+
+        for (unsigned groupBegin=blockBegin; groupBegin<blockEnd; groupBegin+=blocksPerGroup) {
+            const unsigned groupSize = std::min(blocksPerGroup, blockEnd-groupBegin);
+            const unsigned column = groupBegin*4;
+
+            for (unsigned grid=0; grid<3; ++grid) {
+                const float* real = Plane(grid*2) + column;
+                const float* imaginary = Plane(grid*2+1) + column;
+                for (unsigned i=0; i<N; ++i) {
+                    const unsigned r = _bitReverse[i];
+                    for (unsigned b=0; b<groupSize; ++b) {
+                        scratchReal[b*N+r] = _mm_load_ps(&real[i*N+b*4]);
+                        scratchImaginary[b*N+r] = _mm_load_ps(&imaginary[i*N+b*4]);
+                    }
+                }
+
+                for (unsigned b=0; b<groupSize; ++b) {
+                    FFT4(&scratchReal[b*N], &scratchImaginary[b*N], N, _twiddles.get());
+                    std::copy(&scratchReal[b*N], &scratchReal[(b+1)*N], &results[(grid*blocksPerGroup+b)*N]);
+                }
+            }
+
+            for (unsigned i=0; i<N; ++i) {
+                const __m128* scale = (i&1) ? oddRowScale : evenRowScale;
+                float* dst = &_displacement[(i*N+column)*4];
+                for (unsigned b=0; b<groupSize; ++b) {
+                    __m128 z = _mm_mul_ps(results[(0*blocksPerGroup+b)*N+i], scale[1]);
+                    __m128 x = _mm_mul_ps(results[(1*blocksPerGroup+b)*N+i], scale[0]);
+                    __m128 y = _mm_mul_ps(results[(2*blocksPerGroup+b)*N+i], scale[0]);
+                    __m128 w = _mm_setzero_ps();
+                    _MM_TRANSPOSE4_PS(x, y, z, w);
+                    _mm_store_ps(dst+0, x);
+                    _mm_store_ps(dst+4, y);
+                    _mm_store_ps(dst+8, z);
+                    _mm_store_ps(dst+12, w);
+                    dst += 16;
+                }
+            }
+        }
+    }
+
+    template<typename Fn>
+        void DeepOceanSimCPU::Pimpl::ForEachBlock(unsigned blockCount, Fn&& fn)
+    {
+            //  Split the work into tasks of a few blocks each (each block is 4 rows or columns)
+        const unsigned blocksPerTask = 4;
+        const unsigned taskCount = (blockCount + blocksPerTask - 1) / blocksPerTask;
+        if (!_workerPool || taskCount <= 1) {
+            fn(0, blockCount);
+            return;
+        }
+
+        auto task = [blockCount, blocksPerTask, &fn](unsigned taskIndex)
+            {
+                fn(taskIndex*blocksPerTask, std::min((taskIndex+1)*blocksPerTask, blockCount));
+            };
+        if (!ParallelFor(*_workerPool, taskCount, task))
+            Throw(::Exceptions::BasicLabel("Failure while updating CPU ocean simulation"));
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void DeepOceanSimCPU::Update(const DeepOceanSimSettings& settings, float time)
+    {
+        auto& pimpl = *_pimpl;
+        const unsigned dimensions = settings._gridDimensions;
+        if (dimensions < 4 || !IsPowerOfTwo(dimensions))
+            Throw(::Exceptions::BasicLabel("Ocean grid dimensions must be a power of 2 (and at least 4) for CPU ocean simulation"));
+
+        if (dimensions != pimpl._dimensions)
+            pimpl.Resize(dimensions);
+
+        pimpl._physicalDimensions = settings._physicalDimensions;
+        pimpl._baseHeight = settings._baseHeight;
+
+        Internal::OceanSpectrumDesc spectrumDescs[] = {
+            Internal::BuildOceanSpectrumDesc(settings, 0),
+            Internal::BuildOceanSpectrumDesc(settings, 1) };
+        auto spectrumHash = Hash64(spectrumDescs, PtrAdd(spectrumDescs, sizeof(spectrumDescs)));
+        if (spectrumHash != pimpl._spectrumHash) {
+            pimpl.BuildSpectrum(settings);
+            pimpl._spectrumHash = spectrumHash;
+        }
+
+            //  The grid moves in the wind direction. This must match
+            //  BuildOceanRenderingConstants() in Ocean.cpp
+        float windAngle = LinearInterpolate(settings._windAngle[0], settings._windAngle[1], settings._spectrumFade);
+        float windSpeed = LinearInterpolate(settings._windVelocity[0], settings._windVelocity[1], settings._spectrumFade);
+        auto sc = XlSinCos(windAngle);
+        Float2 windVector = windSpeed * Float2(std::get<0>(sc), std::get<1>(sc));
+        Float2 gridShift = settings._gridShiftSpeed * time * windVector / settings._physicalDimensions;
+        pimpl._gridShift = Float2(gridShift[0] - XlFloor(gridShift[0]), gridShift[1] - XlFloor(gridShift[1]));
+
+        const unsigned blockCount = dimensions/4;
+        const float fade = settings._spectrumFade;
+        pimpl.ForEachBlock(blockCount,
+            [&pimpl, fade, time](unsigned blockBegin, unsigned blockEnd)
+            { pimpl.Setup(blockBegin*4, blockEnd*4, fade, time); });
+        pimpl.ForEachBlock(blockCount,
+            [&pimpl](unsigned blockBegin, unsigned blockEnd)
+            { pimpl.RowFFT(blockBegin, blockEnd); });
+
+            //  StrengthConstantMultiplier in Ocean.h
+        const float strengthConstantMultiplier = 1.f / 512.f;
+        const float scaleXY = settings._strengthConstantXY * strengthConstantMultiplier;
+        const float scaleZ = settings._strengthConstantZ * strengthConstantMultiplier;
+        pimpl.ForEachBlock(blockCount,
+            [&pimpl, scaleXY, scaleZ](unsigned blockBegin, unsigned blockEnd)
+            { pimpl.ColumnFFTAndResolve(blockBegin, blockEnd, scaleXY, scaleZ); });
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    __m128 DeepOceanSimCPU::Pimpl::SampleDisplacement(Float2 texelCoords) const
+    {
+            //  Bilinear filter, wrapping at the edges (like OceanTextureCustomInterpolate).
+            //  Each texel is (X, Y, Z, 0), so one SIMD register holds the whole displacement
+        const unsigned mask = _dimensions-1;
+        const float fx = XlFloor(texelCoords[0]), fy = XlFloor(texelCoords[1]);
+        const int ix = int(fx), iy = int(fy);
+        const float ax = texelCoords[0] - fx, ay = texelCoords[1] - fy;
+        const unsigned x0 = unsigned(ix)&mask, x1 = unsigned(ix+1)&mask;
+        const unsigned y0 = unsigned(iy)&mask, y1 = unsigned(iy+1)&mask;
+
+        const float* grid = _displacement.get();
+        __m128 s00 = _mm_load_ps(&grid[(y0*_dimensions+x0)*4]);
+        __m128 s10 = _mm_load_ps(&grid[(y0*_dimensions+x1)*4]);
+        __m128 s01 = _mm_load_ps(&grid[(y1*_dimensions+x0)*4]);
+        __m128 s11 = _mm_load_ps(&grid[(y1*_dimensions+x1)*4]);
+
+        __m128 top = _mm_add_ps(s00, _mm_mul_ps(_mm_sub_ps(s10, s00), _mm_set1_ps(ax)));
+        __m128 bottom = _mm_add_ps(s01, _mm_mul_ps(_mm_sub_ps(s11, s01), _mm_set1_ps(ax)));
+        return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(ay)));
+    }
+
+    Float2 DeepOceanSimCPU::Pimpl::FindBasePosition(Float2 worldPosition, Float2& texelCoords) const
+    {
+            //  The waves move the surface horizontally, as well as vertically. So the
+            //  surface point that ends up at "worldPosition" started somewhere else. We can
+            //  find it with a few fixed point iterations (the horizontal displacement is
+            //  small relative to the wave length, so this converges quickly)
+        const unsigned iterationCount = 3;
+        const float texelsPerUnit = float(_dimensions) / _physicalDimensions;
+        const Float2 shiftTexels = float(_dimensions) * _gridShift;
+
+        Float2 base = worldPosition;
+        for (unsigned c=0; ; ++c) {
+            texelCoords = base * texelsPerUnit + shiftTexels;
+            if (c == iterationCount) break;
+
+            __m128 displacement = SampleDisplacement(texelCoords);
+            __declspec(align(16)) float d[4];
+            _mm_store_ps(d, displacement);
+            base = worldPosition - Float2(d[0], d[1]);
+        }
+        return base;
+    }
+
+    void DeepOceanSimCPU::QueryHeights(
+        IteratorRange<const Float2*> worldPositions,
+        IteratorRange<float*> heights) const
+    {
+        assert(heights.size() >= worldPositions.size());
+        auto& pimpl = *_pimpl;
+        if (!pimpl._dimensions) {
+            std::fill(heights.begin(), heights.begin() + worldPositions.size(), 0.f);
+            return;
+        }
+
+        for (size_t q=0; q<worldPositions.size(); ++q) {
+            Float2 texelCoords;
+            pimpl.FindBasePosition(worldPositions[q], texelCoords);
+            __declspec(align(16)) float d[4];
+            _mm_store_ps(d, pimpl.SampleDisplacement(texelCoords));
+            heights[q] = pimpl._baseHeight + d[2];
+        }
+    }
+
+    void DeepOceanSimCPU::QueryHeightsAndNormals(
+        IteratorRange<const Float2*> worldPositions,
+        IteratorRange<float*> heights,
+        IteratorRange<Float3*> normals) const
+    {
+        assert(heights.size() >= worldPositions.size());
+        assert(normals.size() >= worldPositions.size());
+        auto& pimpl = *_pimpl;
+        if (!pimpl._dimensions) {
+            std::fill(heights.begin(), heights.begin() + worldPositions.size(), 0.f);
+            std::fill(normals.begin(), normals.begin() + worldPositions.size(), Float3(0.f, 0.f, 1.f));
+            return;
+        }
+
+            //  Normals are calculated from the displaced positions half a texel either
+            //  side of the sample point (similar to the BuildNormals shader)
+        const float texelSize = pimpl._physicalDimensions / float(pimpl._dimensions);
+        const __m128 tangentU = _mm_setr_ps(texelSize, 0.f, 0.f, 0.f);
+        const __m128 tangentV = _mm_setr_ps(0.f, texelSize, 0.f, 0.f);
+
+        for (size_t q=0; q<worldPositions.size(); ++q) {
+            Float2 texelCoords;
+            pimpl.FindBasePosition(worldPositions[q], texelCoords);
+            __declspec(align(16)) float d[4];
+            _mm_store_ps(d, pimpl.SampleDisplacement(texelCoords));
+            heights[q] = pimpl._baseHeight + d[2];
+
+            __m128 u = _mm_add_ps(tangentU, _mm_sub_ps(
+                pimpl.SampleDisplacement(texelCoords + Float2(.5f, 0.f)),
+                pimpl.SampleDisplacement(texelCoords - Float2(.5f, 0.f))));
+            __m128 v = _mm_add_ps(tangentV, _mm_sub_ps(
+                pimpl.SampleDisplacement(texelCoords + Float2(0.f, .5f)),
+                pimpl.SampleDisplacement(texelCoords - Float2(0.f, .5f))));
+            __declspec(align(16)) float uf[4], vf[4];
+            _mm_store_ps(uf, u); _mm_store_ps(vf, v);
+            normals[q] = Normalize(Cross(Float3(uf[0], uf[1], uf[2]), Float3(vf[0], vf[1], vf[2])));
+        }
+    }
+
+    const float* DeepOceanSimCPU::GetDisplacementGrid() const { return _pimpl->_displacement.get(); }
+    unsigned DeepOceanSimCPU::GetGridDimensions() const { return _pimpl->_dimensions; }
+
+    DeepOceanSimCPU::DeepOceanSimCPU(CompletionThreadPool* workerPool)
+    {
+        _pimpl = std::make_unique<Pimpl>();
+        _pimpl->_dimensions = 0;
+        _pimpl->_spectrumHash = 0;
+        _pimpl->_gridShift = Float2(0.f, 0.f);
+        _pimpl->_physicalDimensions = 1.f;
+        _pimpl->_baseHeight = 0.f;
+        _pimpl->_workerPool = workerPool;
+    }
+
+    DeepOceanSimCPU::~DeepOceanSimCPU() {}
+}
+
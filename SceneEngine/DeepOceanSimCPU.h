@@ -0,0 +1,70 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../Math/Vector.h"
+#include "../Utility/IteratorUtils.h"
+#include <memory>
+
+namespace Utility { class CompletionThreadPool; }
+
+namespace SceneEngine
+{
+    class DeepOceanSimSettings;
+
+    /// <summary>CPU implementation of the deep ocean FFT</summary>
+    /// Calculates the same displacement grids as DeepOceanSim (using the same spectrum,
+    /// the same setup math and the same forward FFT), but on the CPU. This is intended
+    /// for game code that needs to know where the water surface is (eg, buoyancy), and
+    /// for dedicated servers that have no GPU.
+    ///
+    /// The FFT is done 4 rows (or columns) at a time with SIMD, and the rows and columns
+    /// are distributed across the given thread pool (if there is one).
+    ///
+    /// Update() must not run at the same time as queries. Queries don't modify the
+    /// object, so any number of threads can query at once.
+    class DeepOceanSimCPU
+    {
+    public:
+            /// <summary>Calculates the displacement grid for the given time</summary>
+            /// "time" should be the same time value given to the GPU sim (ie, the scene
+            /// parser's time value).
+        void Update(const DeepOceanSimSettings& settings, float time);
+
+            /// <summary>Finds the height of the water surface at the given world positions</summary>
+            /// The horizontal part of the displacement is taken into account, so this is the
+            /// height of the surface that is actually drawn at that XY position (ignoring the
+            /// attenuation of waves in the far distance).
+        void QueryHeights(
+            IteratorRange<const Float2*> worldPositions,
+            IteratorRange<float*> heights) const;
+        void QueryHeightsAndNormals(
+            IteratorRange<const Float2*> worldPositions,
+            IteratorRange<float*> heights,
+            IteratorRange<Float3*> normals) const;
+
+            /// <summary>Returns the displacement grid calculated by the last Update()</summary>
+            /// The grid has GetGridDimensions()^2 texels of 4 floats: X, Y and Z displacement
+            /// in world units, and one unused float. Unlike the GPU textures, the alternating
+            /// sign and the strength constants have already been applied. So, the GPU heights
+            /// texture at (x, y) is equal to:
+            ///     grid[(y*dims+x)*4+2] * (-1)^(x+y) * 512 / _strengthConstantZ
+        const float* GetDisplacementGrid() const;
+        unsigned GetGridDimensions() const;
+
+        DeepOceanSimCPU(Utility::CompletionThreadPool* workerPool = nullptr);
+        ~DeepOceanSimCPU();
+
+        DeepOceanSimCPU(const DeepOceanSimCPU&) = delete;
+        DeepOceanSimCPU& operator=(const DeepOceanSimCPU&) = delete;
+
+    private:
+        class Pimpl;
+        std::unique_ptr<Pimpl> _pimpl;
+    };
+}
+
@@ -9,6 +9,9 @@
 #include "../Math/Transformations.h"
 #include "../Math/Geometry.h"
 #include "../Utility/PtrUtils.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include "../Core/Exceptions.h"
+#include <algorithm>
 
 #pragma warning(disable:4714)
 #pragma push_macro("new")
@@ -53,15 +56,24 @@ namespace SceneEngine
             , _massPointAccum(Zero<Float3>()), _massPointCount(0) {}
     };
 
-    static EdgeIntersection  TestEdge(  const Float3& e0, const Float3& e1, float d0, float d1, 
-                                        const IVolumeDensityFunction& fn)
+    class EdgeSearch
     {
-            //  Test the edge between these points, and attempt to find the point where
+    public:
+        Float3      _e0, _e1;
+        float       _x0, _x1, _d0, _d1;
+        float       _x, _d, _prevX, _prevD;
+        UInt3       _corner;
+        unsigned    _axis;
+    };
+
+    static void TestEdges(  std::vector<EdgeIntersection>& dst, IteratorRange<EdgeSearch*> edges,
+                            const IVolumeDensityFunction& fn)
+    {
+            //  Test the edges between these points, and attempt to find the points where
             //  the surface passes through. 
             //
             //  The caller should have filtered out edges
             //  that don't pass through the surface.
-        assert((d0 < 0.f) != (d1 < 0.f));
 
             //      It might be a good idea to further improve the
             //      result by taking a few steps to try to get to the
@@ -70,41 +82,78 @@ namespace SceneEngine
             //      and so produce strange results when trying to
             //      find the intersection (particularly if there are
             //      really multiple intersections).
+            //
+            //      All of the edges take their steps together, so the density
+            //      function is evaluated with one batched call per step. Each edge
+            //      still takes exactly the steps it would take if it was tested on
+            //      its own.
+
+        const unsigned maxImprovementSteps = 6;
+        const auto edgeCount = edges.size();
+        std::vector<unsigned> active(edgeCount), nextActive;
+        nextActive.reserve(edgeCount);
+        for (size_t c=0; c<edgeCount; ++c) {
+            auto& e = edges[c];
+            assert((e._d0 < 0.f) != (e._d1 < 0.f));
+            e._x0 = 0.f; e._x1 = 1.f;
+            e._x = 1.f; e._d = FLT_MAX;
+            active[c] = unsigned(c);
+        }
 
-        float x0 = 0.f, x1 = 1.f;
-        float x = 1.f, d = FLT_MAX;
-        unsigned maxImprovementSteps = 6;
-        for (unsigned c=0; ; ++c) {
-            float prevD = d; float prevX = x;
-            x = LinearInterpolate(x0, x1, -d0 / (d1 - d0));
-            d = fn.GetDensity(LinearInterpolate(e0, e1, x));
-
-                // along noisy edges we could end up getting a worse result after a step
-                //  In these cases, just give up at the last reasonable result
-            if (XlAbs(d) > XlAbs(prevD)) {
-                x = prevX;
-                break;
+        std::vector<Float3> pts(edgeCount);
+        std::vector<float> densities(edgeCount);
+        for (unsigned c=0; !active.empty(); ++c) {
+            for (size_t i=0; i<active.size(); ++i) {
+                auto& e = edges[active[i]];
+                e._prevD = e._d; e._prevX = e._x;
+                e._x = LinearInterpolate(e._x0, e._x1, -e._d0 / (e._d1 - e._d0));
+                pts[i] = LinearInterpolate(e._e0, e._e1, e._x);
             }
+            fn.GetDensities(
+                MakeIteratorRange(AsPointer(densities.begin()), AsPointer(densities.begin()) + active.size()),
+                MakeIteratorRange(AsPointer(pts.cbegin()), AsPointer(pts.cbegin()) + active.size()));
+
+            nextActive.clear();
+            for (size_t i=0; i<active.size(); ++i) {
+                auto& e = edges[active[i]];
+                e._d = densities[i];
+
+                    // along noisy edges we could end up getting a worse result after a step
+                    //  In these cases, just give up at the last reasonable result
+                if (XlAbs(e._d) > XlAbs(e._prevD)) {
+                    e._x = e._prevX;
+                    continue;
+                }
 
-            if (XlAbs(d) < 1e-6f) break;   // if we get close enough, just stop
-            if ((c+1)>=maxImprovementSteps) break;
-
-                //  We're going to attempt another improvement.
-                //  Divide the search area again, depending on where
-                //  the origin falls
-            if ((d < 0.f) != (d1 < 0.f)) {
-                x0 = x;
-                d0 = d;
-            } else {
-                x1 = x;
-                d1 = d;
+                if (XlAbs(e._d) < 1e-6f) continue;   // if we get close enough, just stop
+                if ((c+1)>=maxImprovementSteps) continue;
+
+                    //  We're going to attempt another improvement.
+                    //  Divide the search area again, depending on where
+                    //  the origin falls
+                if ((e._d < 0.f) != (e._d1 < 0.f)) {
+                    e._x0 = e._x;
+                    e._d0 = e._d;
+                } else {
+                    e._x1 = e._x;
+                    e._d1 = e._d;
+                }
+                nextActive.push_back(active[i]);
             }
+            std::swap(active, nextActive);
+        }
+
+        for (size_t c=0; c<edgeCount; ++c) {
+            assert(edges[c]._x>=0.f && edges[c]._x <= 1.f);
+            pts[c] = LinearInterpolate(edges[c]._e0, edges[c]._e1, edges[c]._x);
         }
 
-        assert(x>=0.f && x <= 1.f);
-        Float3 bestIntersection = LinearInterpolate(e0, e1, x);
-        Float3 normal = fn.GetNormal(bestIntersection);     // note -- we might need to tell the function the sampling density
-        return EdgeIntersection(bestIntersection, normal);
+        std::vector<Float3> normals(edgeCount);     // note -- we might need to tell the function the sampling density
+        fn.GetNormals(MakeIteratorRange(normals), MakeIteratorRange(pts));
+
+        dst.reserve(dst.size() + edgeCount);
+        for (size_t c=0; c<edgeCount; ++c)
+            dst.push_back(EdgeIntersection(pts[c], normals[c]));
     }
 
     static void RotateToUpperTriangle(Eigen::Matrix<float,5,4>& A)
@@ -449,152 +498,187 @@ namespace SceneEngine
 
 #endif
     
-    static void AddQuad(DualContourMesh& mesh, const DualContourMesh::Quad& quad, bool flipDirection)
+    static void AddQuad(std::vector<DualContourMesh::Quad>& quads, const DualContourMesh::Quad& quad, bool flipDirection)
     {
         auto q = quad;
         if (flipDirection)
             std::swap(q._verts[1], q._verts[2]);
-        mesh._quads.push_back(q);
+        quads.push_back(q);
     }
 
-    DualContourMesh     DualContourMesh_Build(  unsigned samplingGridDimensions, 
-                                                const IVolumeDensityFunction& fn)
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static const unsigned BrickDimensions = 16;
+
+        // note --  The order of the cell offsets here is important, because it 
+        //          determines the order of the vertices in the quad.
+    static const Int3 CellOffsets[3][4] = 
     {
-            //  Build a mesh of triangles from the given input function
-            //      (using dual contouring method)
-            //
-            //  First we'll build a grid containing information for each
-            //  voxel. Then we'll go through a calculate the QEF's at
-            //  each grid point -- that will give us enough information
-            //  to generate the triangles needed. Note that the algorithm
-            //  should naturally build quads most of the time. They'll need
-            //  to be split up into triangles.
-            //
-            //  Ideally, we would also do simplification before we calculate
-            //  the QEF's and generate the triangles. But currently, no
-            //  simplification.
-        auto boundary = fn.GetBoundary();
-        auto gridElements = std::make_unique<GridElement[]>(
-            samplingGridDimensions*samplingGridDimensions*samplingGridDimensions);
+        { Int3(0, 0, 0), Int3(0, -1, 0), Int3(0, 0, -1), Int3(0, -1, -1) },
+        { Int3(0, 0, 0), Int3(0, 0, -1), Int3(-1, 0, 0), Int3(-1, 0, -1) },
+        { Int3(0, 0, 0), Int3(-1, 0, 0), Int3(0, -1, 0), Int3(-1, -1, 0) }
+    };
+
+    class DualContourMesher::Pimpl
+    {
+    public:
+        class Brick
+        {
+        public:
+            UInt3   _mins, _maxs;       // range of cells in this brick (maxs is exclusive)
+
+                //  The quads in each brick refer to global cell indices, not vertex
+                //  indices. They get mapped onto vertices in GetMesh(). That way, when
+                //  a brick is rebuilt, its neighbours don't need to change.
+            std::vector<DualContourMesh::Vertex>    _vertices;
+            std::vector<DualContourMesh::Quad>      _quads;
+        };
+
+        unsigned                            _dims;
+        IVolumeDensityFunction::Boundary    _boundary;
+        Float3x4                            _gridToSampleSpace;
+        std::unique_ptr<float[]>            _densities;         // (dims+1)^3 corner samples
+        std::unique_ptr<unsigned[]>         _cellVertices;      // dims^3 vertex indices, relative to the brick
+        std::vector<Brick>                  _bricks;
+        unsigned                            _bricksPerAxis;
+        CompletionThreadPool*               _workerPool;
+
+        unsigned DensityIndex(unsigned x, unsigned y, unsigned z) const { return (z * (_dims+1) + y) * (_dims+1) + x; }
+        unsigned CellIndex(unsigned x, unsigned y, unsigned z) const    { return (z * _dims + y) * _dims + x; }
+        Float3 CellCenter(unsigned x, unsigned y, unsigned z) const
+        {
+            return Float3(
+                LinearInterpolate(_boundary.first[0], _boundary.second[0], (float(x) + .5f) / float(_dims)),
+                LinearInterpolate(_boundary.first[1], _boundary.second[1], (float(y) + .5f) / float(_dims)),
+                LinearInterpolate(_boundary.first[2], _boundary.second[2], (float(z) + .5f) / float(_dims)));
+        }
+
+        void SampleBrick(const Brick& brick, const IVolumeDensityFunction& fn);
+        void MeshBrick(Brick& brick, const IVolumeDensityFunction& fn);
+        void UpdateBricks(IteratorRange<const unsigned*> brickIndices, const IVolumeDensityFunction& fn);
+
+        template<typename Fn>
+            void ForEachBrick(IteratorRange<const unsigned*> brickIndices, Fn&& fn);
+    };
 
+    template<typename Fn>
+        void DualContourMesher::Pimpl::ForEachBrick(IteratorRange<const unsigned*> brickIndices, Fn&& fn)
+    {
+            //  Each brick is big enough to be a task on its own
+        if (!_workerPool || brickIndices.size() <= 1) {
+            for (auto b:brickIndices) fn(b);
+            return;
+        }
+
+        auto task = [brickIndices, &fn](unsigned taskIndex) { fn(brickIndices[taskIndex]); };
+        if (!ParallelFor(*_workerPool, unsigned(brickIndices.size()), task))
+            Throw(::Exceptions::BasicLabel("Failure while building dual contour mesh"));
+    }
+
+    void DualContourMesher::Pimpl::SampleBrick(const Brick& brick, const IVolumeDensityFunction& fn)
+    {
+            //  Each brick samples the corners at the minimum side of its cells. The bricks
+            //  on the positive boundary also take the final row of corners. So every corner
+            //  is written by exactly one brick.
+        UInt3 cornerMaxs;
+        for (unsigned c=0; c<3; ++c)
+            cornerMaxs[c] = (brick._maxs[c] == _dims) ? (_dims+1) : brick._maxs[c];
+
+        const auto rowLength = cornerMaxs[0] - brick._mins[0];
+        const auto count = rowLength * (cornerMaxs[1] - brick._mins[1]) * (cornerMaxs[2] - brick._mins[2]);
+        std::vector<Float3> pts;
+        pts.reserve(count);
+        for (unsigned z=brick._mins[2]; z<cornerMaxs[2]; ++z)
+            for (unsigned y=brick._mins[1]; y<cornerMaxs[1]; ++y)
+                for (unsigned x=brick._mins[0]; x<cornerMaxs[0]; ++x)
+                    pts.push_back(TransformPoint(_gridToSampleSpace, Float3(float(x), float(y), float(z))));
+
+        std::vector<float> densities(count);
+        fn.GetDensities(MakeIteratorRange(densities), MakeIteratorRange(pts));
+
+        auto* src = AsPointer(densities.cbegin());
+        for (unsigned z=brick._mins[2]; z<cornerMaxs[2]; ++z)
+            for (unsigned y=brick._mins[1]; y<cornerMaxs[1]; ++y) {
+                std::copy(src, src + rowLength, &_densities[DensityIndex(brick._mins[0], y, z)]);
+                src += rowLength;
+            }
+    }
+
+    void DualContourMesher::Pimpl::MeshBrick(Brick& brick, const IVolumeDensityFunction& fn)
+    {
             //  For each grid element, let's fill it in with the values from the
             //  density function. Note that we could reduce the work here slightly
             //  by finding a point within the grid that lies on the surface, and
             //  then marching along the surface, into each new grid that takes us.
             //
-            //  The current method will create many redundant tests of the volume
-            //  function -- because most grids are probably not on the surface of the 
-            //  volume.
-            //
             //  Let's find and test each edge. When we find a edge that crosses the 
             //  boundary, we can merge that into the QEF's for that adjacent grid
-            //  elements.
+            //  elements. The densities at the corners have already been calculated,
+            //  so the only calls to the density function here are to improve the
+            //  intersection points, and to find normals.
             //
-            //  It's a good idea to calculate the density results at each corner first
-            //  This will help reduce the number of times we need to call the
-            //  GetDensity() function.
-
-        Float3x4 gridToSampleSpace = Zero<Float3x4>();
-        gridToSampleSpace(0,0) = (boundary.second[0] - boundary.first[0]) / float(samplingGridDimensions);
-        gridToSampleSpace(1,1) = (boundary.second[1] - boundary.first[1]) / float(samplingGridDimensions);
-        gridToSampleSpace(2,2) = (boundary.second[2] - boundary.first[2]) / float(samplingGridDimensions);
-        gridToSampleSpace(0,3) = boundary.first[0];
-        gridToSampleSpace(1,3) = boundary.first[1];
-        gridToSampleSpace(2,3) = boundary.first[2];
-        
-        auto densityResults = std::make_unique<float[]>(
-            (samplingGridDimensions+1)*(samplingGridDimensions+1)*(samplingGridDimensions+1));
-        for (int z=0; z<int(samplingGridDimensions+1); ++z)
-            for (int y=0; y<int(samplingGridDimensions+1); ++y)
-                for (int x=0; x<int(samplingGridDimensions+1); ++x) {
-                    Float3 p0 = TransformPoint(gridToSampleSpace, Float3(float(x), float(y), float(z)));
-                    densityResults[(z * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x] = fn.GetDensity(p0);
-                }
-
-            // note --  The order of the cell offsets here is important, because it 
-            //          determines the order of the vertices in the quad.
-        Int3 cellOffsetsX[] = { Int3(0, 0, 0), Int3(0, -1, 0), Int3(0, 0, -1), Int3(0, -1, -1) };
-        Int3 cellOffsetsY[] = { Int3(0, 0, 0), Int3(0, 0, -1), Int3(-1, 0, 0), Int3(-1, 0, -1) };
-        Int3 cellOffsetsZ[] = { Int3(0, 0, 0), Int3(-1, 0, 0), Int3(0, -1, 0), Int3(-1, -1, 0) };
-
-        for (int z=0; z<int(samplingGridDimensions); ++z) {
-            for (int y=0; y<int(samplingGridDimensions); ++y) {
-                for (int x=0; x<int(samplingGridDimensions); ++x) {
-
-                        //  For each grid element, we're going to test 3 edges.
-                        //  we'll add the effect of those edges to adjacent grids
-                        //  as well. This means each edges gets tested once.
-                        //  However, some edges on the extreme positive boundary
-                        //  of the sampling area will never be tested. We'll assume 
-                        //  that the function doesn't go through these boundary edges.
-
-                    Float3 p0 = TransformPoint(gridToSampleSpace, Float3(float(x), float(y), float(z)));
-                    Float3 p1 = TransformPoint(gridToSampleSpace, Float3(float(x+1), float(y), float(z)));
-                    Float3 p2 = TransformPoint(gridToSampleSpace, Float3(float(x), float(y+1), float(z)));
-                    Float3 p3 = TransformPoint(gridToSampleSpace, Float3(float(x), float(y), float(z+1)));
-
-                    float d0 = densityResults[(z * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x];
-                    float d1 = densityResults[(z * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x + 1];
-                    float d2 = densityResults[(z * (samplingGridDimensions+1) + y + 1) * (samplingGridDimensions+1) + x];
-                    float d3 = densityResults[((z + 1) * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x];
-
-                        //  Look for edges that contain intersections with the surface, and then merge 
-                        //  those edge into all of the grid cells that contain them.
-                        //  Note that TestEdge() will do extra calls to GetDensity to improve the 
-                        //  intersection point.
-                    
-                    if ((d0 < 0.f) != (d1 < 0.f)) {
-                        auto intersection = TestEdge(p0, p1, d0, d1, fn);
-                        for (unsigned c=0; c<dimof(cellOffsetsX); ++c) {
-                            Int3 g(x + cellOffsetsX[c][0], y + cellOffsetsX[c][1], z + cellOffsetsX[c][2]);
-                            if (g[0] >= 0 && g[1] >= 0 && g[2] >= 0) {
-                                const auto cellCenter = Float3(
-                                    LinearInterpolate(boundary.first[0], boundary.second[0], (float(g[0]) + .5f) / float(samplingGridDimensions)),
-                                    LinearInterpolate(boundary.first[1], boundary.second[1], (float(g[1]) + .5f) / float(samplingGridDimensions)),
-                                    LinearInterpolate(boundary.first[2], boundary.second[2], (float(g[2]) + .5f) / float(samplingGridDimensions)));
-
-                                MergeInEdgeIntersection(
-                                    gridElements[(g[2] * samplingGridDimensions + g[1]) * samplingGridDimensions + g[0]],
-                                    intersection, cellCenter);
-                            }
-                        }
-                    }
-
-                    if ((d0 < 0.f) != (d2 < 0.f)) {
-                        auto intersection = TestEdge(p0, p2, d0, d2, fn);
-                        for (unsigned c=0; c<dimof(cellOffsetsY); ++c) {
-                            Int3 g(x + cellOffsetsY[c][0], y + cellOffsetsY[c][1], z + cellOffsetsY[c][2]);
-                            if (g[0] >= 0 && g[1] >= 0 && g[2] >= 0) {
-                                const auto cellCenter = Float3(
-                                    LinearInterpolate(boundary.first[0], boundary.second[0], (float(g[0]) + .5f) / float(samplingGridDimensions)),
-                                    LinearInterpolate(boundary.first[1], boundary.second[1], (float(g[1]) + .5f) / float(samplingGridDimensions)),
-                                    LinearInterpolate(boundary.first[2], boundary.second[2], (float(g[2]) + .5f) / float(samplingGridDimensions)));
-
-                                MergeInEdgeIntersection(
-                                    gridElements[(g[2] * samplingGridDimensions + g[1]) * samplingGridDimensions + g[0]],
-                                    intersection, cellCenter);
-                            }
-                        }
-                    }
-
-                    if ((d0 < 0.f) != (d3 < 0.f)) {
-                        auto intersection = TestEdge(p0, p3, d0, d3, fn);
-                        for (unsigned c=0; c<dimof(cellOffsetsZ); ++c) {
-                            Int3 g(x + cellOffsetsZ[c][0], y + cellOffsetsZ[c][1], z + cellOffsetsZ[c][2]);
-                            if (g[0] >= 0 && g[1] >= 0 && g[2] >= 0) {
-                                const auto cellCenter = Float3(
-                                    LinearInterpolate(boundary.first[0], boundary.second[0], (float(g[0]) + .5f) / float(samplingGridDimensions)),
-                                    LinearInterpolate(boundary.first[1], boundary.second[1], (float(g[1]) + .5f) / float(samplingGridDimensions)),
-                                    LinearInterpolate(boundary.first[2], boundary.second[2], (float(g[2]) + .5f) / float(samplingGridDimensions)));
-
-                                MergeInEdgeIntersection(
-                                    gridElements[(g[2] * samplingGridDimensions + g[1]) * samplingGridDimensions + g[0]],
-                                    intersection, cellCenter);
-                            }
-                        }
+            //  Edges on the faces of the brick are shared with the neighbouring bricks,
+            //  and are tested by both. But the result is the same in both bricks, so
+            //  the vertices on either side of the seam agree.
+            //
+            //  We visit the edges in the same order as if the whole grid was a single
+            //  brick. So each grid element gets its edges merged in the same order,
+            //  regardless of where the brick boundaries are.
+
+        const UInt3 brickSize = brick._maxs - brick._mins;
+        auto gridElements = std::make_unique<GridElement[]>(brickSize[0]*brickSize[1]*brickSize[2]);
+
+        std::vector<EdgeSearch> edges;
+        UInt3 cornerMaxs;
+        for (unsigned c=0; c<3; ++c)
+            cornerMaxs[c] = std::min(brick._maxs[c], _dims-1);
+        for (unsigned z=brick._mins[2]; z<=cornerMaxs[2]; ++z)
+            for (unsigned y=brick._mins[1]; y<=cornerMaxs[1]; ++y)
+                for (unsigned x=brick._mins[0]; x<=cornerMaxs[0]; ++x) {
+                        //  Test the 3 edges in the positive directions from this corner.
+                        //  Some edges on the extreme positive boundary of the sampling area
+                        //  will never be tested. We'll assume that the function doesn't go 
+                        //  through these boundary edges.
+                    const UInt3 corner(x, y, z);
+                    float d0 = _densities[DensityIndex(x, y, z)];
+                    for (unsigned axis=0; axis<3; ++axis) {
+                        if (corner[axis] >= brick._maxs[axis]) continue;     // (this edge belongs to the next brick)
+                        UInt3 end = corner; ++end[axis];
+                        float d1 = _densities[DensityIndex(end[0], end[1], end[2])];
+                        if ((d0 < 0.f) == (d1 < 0.f)) continue;
+
+                        EdgeSearch e;
+                        e._e0 = TransformPoint(_gridToSampleSpace, Float3(float(corner[0]), float(corner[1]), float(corner[2])));
+                        e._e1 = TransformPoint(_gridToSampleSpace, Float3(float(end[0]), float(end[1]), float(end[2])));
+                        e._d0 = d0; e._d1 = d1;
+                        e._corner = corner;
+                        e._axis = axis;
+                        edges.push_back(e);
                     }
-
                 }
+
+        std::vector<EdgeIntersection> intersections;
+        TestEdges(intersections, MakeIteratorRange(edges), fn);
+
+            //  Merge each intersection into all of the grid elements within this brick
+            //  that contain it.
+        for (size_t c=0; c<edges.size(); ++c) {
+            const auto& e = edges[c];
+            for (unsigned q=0; q<4; ++q) {
+                Int3 g(
+                    int(e._corner[0]) + CellOffsets[e._axis][q][0], 
+                    int(e._corner[1]) + CellOffsets[e._axis][q][1], 
+                    int(e._corner[2]) + CellOffsets[e._axis][q][2]);
+                if (    g[0] < int(brick._mins[0]) || g[1] < int(brick._mins[1]) || g[2] < int(brick._mins[2])
+                    ||  g[0] >= int(brick._maxs[0]) || g[1] >= int(brick._maxs[1]) || g[2] >= int(brick._maxs[2]))
+                    continue;
+
+                auto localIndex = 
+                      ((g[2] - brick._mins[2]) * brickSize[1] + (g[1] - brick._mins[1])) * brickSize[0]
+                    + (g[0] - brick._mins[0]);
+                MergeInEdgeIntersection(
+                    gridElements[localIndex], intersections[c], 
+                    CellCenter(unsigned(g[0]), unsigned(g[1]), unsigned(g[2])));
             }
         }
 
@@ -602,99 +686,234 @@ namespace SceneEngine
             //  For each grid element, we can calculate the appropriate point for that
             //  element. Let's make sure we do this only one per grid element (because
             //  typically each vertex will be used in multiple quads.
-
         const auto cellSize = Float3(
-            (boundary.second[0] - boundary.first[0]) / float(samplingGridDimensions),
-            (boundary.second[1] - boundary.first[1]) / float(samplingGridDimensions),
-            (boundary.second[2] - boundary.first[2]) / float(samplingGridDimensions));
-
-        std::vector<DualContourMesh::Vertex> vertices;
-        auto vertexIndices = std::make_unique<unsigned[]>(
-            samplingGridDimensions*samplingGridDimensions*samplingGridDimensions);
-        for (int z=0; z<int(samplingGridDimensions); ++z) {
-            for (int y=0; y<int(samplingGridDimensions); ++y) {
-                for (int x=0; x<int(samplingGridDimensions); ++x) {
-                    auto index = (z * samplingGridDimensions + y) * samplingGridDimensions + x;
-                    const auto& g = gridElements[index];
+            (_boundary.second[0] - _boundary.first[0]) / float(_dims),
+            (_boundary.second[1] - _boundary.first[1]) / float(_dims),
+            (_boundary.second[2] - _boundary.first[2]) / float(_dims));
+
+        std::vector<Float3> pts;
+        for (unsigned z=brick._mins[2]; z<brick._maxs[2]; ++z)
+            for (unsigned y=brick._mins[1]; y<brick._maxs[1]; ++y)
+                for (unsigned x=brick._mins[0]; x<brick._maxs[0]; ++x) {
+                    auto localIndex = ((z - brick._mins[2]) * brickSize[1] + (y - brick._mins[1])) * brickSize[0] + (x - brick._mins[0]);
+                    const auto& g = gridElements[localIndex];
                     if (!g._massPointCount) {
-                        vertexIndices[index] = 0xffffffff;
+                        _cellVertices[CellIndex(x, y, z)] = 0xffffffff;
                         continue;
                     }
 
-                    const auto cellCenter = Float3(
-                        LinearInterpolate(boundary.first[0], boundary.second[0], (float(x) + .5f) / float(samplingGridDimensions)),
-                        LinearInterpolate(boundary.first[1], boundary.second[1], (float(y) + .5f) / float(samplingGridDimensions)),
-                        LinearInterpolate(boundary.first[2], boundary.second[2], (float(z) + .5f) / float(samplingGridDimensions)));
-                    auto pt = CalculateCellPoint(g, cellSize) + cellCenter;
-
-                        //  We need the normal at this location, also.
-                        //  We've lost the locations of the edge intersections -- so we can't
-                        //  just add together the normals from them. However. We can 
-                        //  query the density field again to get the normal at this location.
-                    auto normal = fn.GetNormal(pt);
-                    vertices.push_back(DualContourMesh::Vertex(pt, normal));
-                    vertexIndices[index] = unsigned(vertices.size()-1);
+                    _cellVertices[CellIndex(x, y, z)] = unsigned(pts.size());
+                    pts.push_back(CalculateCellPoint(g, cellSize) + CellCenter(x, y, z));
                 }
-            }
+
+            //  We need the normal at these locations, also.
+            //  We've lost the locations of the edge intersections -- so we can't
+            //  just add together the normals from them. However. We can 
+            //  query the density field again to get the normals at these locations.
+        std::vector<Float3> normals(pts.size());
+        fn.GetNormals(MakeIteratorRange(normals), MakeIteratorRange(pts));
+
+        brick._vertices.clear();
+        brick._vertices.reserve(pts.size());
+        for (size_t c=0; c<pts.size(); ++c)
+            brick._vertices.push_back(DualContourMesh::Vertex(pts[c], normals[c]));
+
+            //  We just need to calculate the quads. 
+            //  For each edge with an intersection, we want to create a quad by joining
+            //  together all of the cells that use this edge. We skip the corners on
+            //  the minimum boundary, because the edge cells have nothing to join
+            //  on to. The cells on the far side of the brick faces might belong to
+            //  other bricks, so we just record the cell indices for now.
+        brick._quads.clear();
+        for (unsigned z=std::max(brick._mins[2], 1u); z<brick._maxs[2]; ++z)
+            for (unsigned y=std::max(brick._mins[1], 1u); y<brick._maxs[1]; ++y)
+                for (unsigned x=std::max(brick._mins[0], 1u); x<brick._maxs[0]; ++x) {
+                    const UInt3 corner(x, y, z);
+                    float d0 = _densities[DensityIndex(x, y, z)];
+                    for (unsigned axis=0; axis<3; ++axis) {
+                        UInt3 end = corner; ++end[axis];
+                        float d1 = _densities[DensityIndex(end[0], end[1], end[2])];
+                        if ((d0 < 0.f) == (d1 < 0.f)) continue;
+
+                        DualContourMesh::Quad q;
+                        for (unsigned c=0; c<4; ++c)
+                            q._verts[c] = CellIndex(
+                                x + CellOffsets[axis][c][0], 
+                                y + CellOffsets[axis][c][1], 
+                                z + CellOffsets[axis][c][2]);
+                        AddQuad(brick._quads, q, d0 < 0.f);
+                    }
+                }
+    }
+
+    void DualContourMesher::Pimpl::UpdateBricks(IteratorRange<const unsigned*> brickIndices, const IVolumeDensityFunction& fn)
+    {
+            //  All of the samples must be finished before any brick is meshed, because
+            //  meshing reads the corners on the far side of the brick
+        ForEachBrick(brickIndices, [this, &fn](unsigned b) { SampleBrick(_bricks[b], fn); });
+        ForEachBrick(brickIndices, [this, &fn](unsigned b) { MeshBrick(_bricks[b], fn); });
+    }
+
+    void DualContourMesher::Build(const IVolumeDensityFunction& fn)
+    {
+            //  Build a mesh of triangles from the given input function
+            //      (using dual contouring method)
+            //
+            //  First we'll build a grid containing information for each
+            //  voxel. Then we'll go through a calculate the QEF's at
+            //  each grid point -- that will give us enough information
+            //  to generate the triangles needed. Note that the algorithm
+            //  should naturally build quads most of the time. They'll need
+            //  to be split up into triangles.
+            //
+            //  Ideally, we would also do simplification before we calculate
+            //  the QEF's and generate the triangles. But currently, no
+            //  simplification.
+        std::vector<unsigned> brickIndices(_pimpl->_bricks.size());
+        for (unsigned c=0; c<unsigned(brickIndices.size()); ++c) brickIndices[c] = c;
+        _pimpl->UpdateBricks(MakeIteratorRange(brickIndices), fn);
+    }
+
+    unsigned DualContourMesher::Update(const IVolumeDensityFunction& fn, const Float3& editMins, const Float3& editMaxs)
+    {
+            //  Find the cells that overlap the edit, and expand by one cell. Any cell that
+            //  shares a corner or an edge with a changed sample is within that range. Then
+            //  rebuild every brick that touches that range of cells.
+        UInt3 brickMins, brickMaxs;
+        const auto dims = _pimpl->_dims;
+        const auto& boundary = _pimpl->_boundary;
+        for (unsigned c=0; c<3; ++c) {
+            float cellSize = (boundary.second[c] - boundary.first[c]) / float(dims);
+            float cellMin = XlFloor((editMins[c] - boundary.first[c]) / cellSize) - 1.f;
+            float cellMax = XlFloor((editMaxs[c] - boundary.first[c]) / cellSize) + 1.f;
+            if (cellMax < 0.f || cellMin >= float(dims) || cellMax < cellMin) return 0;
+            brickMins[c] = unsigned(std::max(cellMin, 0.f)) / BrickDimensions;
+            brickMaxs[c] = unsigned(std::min(cellMax, float(dims-1))) / BrickDimensions;
         }
 
-            //  We just need to calculate the triangles. 
-            //  For each edge with an intersection, we want to create a quad.
-            //  we start at one here, because the edge cells have nothing to join
-            //  on to.
+        std::vector<unsigned> brickIndices;
+        const auto bricksPerAxis = _pimpl->_bricksPerAxis;
+        for (unsigned z=brickMins[2]; z<=brickMaxs[2]; ++z)
+            for (unsigned y=brickMins[1]; y<=brickMaxs[1]; ++y)
+                for (unsigned x=brickMins[0]; x<=brickMaxs[0]; ++x)
+                    brickIndices.push_back((z * bricksPerAxis + y) * bricksPerAxis + x);
+
+        _pimpl->UpdateBricks(MakeIteratorRange(brickIndices), fn);
+        return unsigned(brickIndices.size());
+    }
+
+    DualContourMesh DualContourMesher::GetMesh() const
+    {
+            //  Join the bricks together. Vertices are ordered by brick, and the quads
+            //  get their cell indices replaced with the final vertex indices.
+        const auto& bricks = _pimpl->_bricks;
+        std::vector<unsigned> vertexOffsets(bricks.size()), quadOffsets(bricks.size());
+        size_t vertexCount = 0, quadCount = 0;
+        for (size_t b=0; b<bricks.size(); ++b) {
+            vertexOffsets[b] = unsigned(vertexCount);
+            quadOffsets[b] = unsigned(quadCount);
+            vertexCount += bricks[b]._vertices.size();
+            quadCount += bricks[b]._quads.size();
+        }
 
         DualContourMesh mesh;
-        mesh._vertices = std::move(vertices);
+        mesh._vertices.reserve(vertexCount);
+        for (const auto& b:bricks)
+            mesh._vertices.insert(mesh._vertices.end(), b._vertices.begin(), b._vertices.end());
+
+        mesh._quads.resize(quadCount);
+        const auto dims = _pimpl->_dims;
+        const auto bricksPerAxis = _pimpl->_bricksPerAxis;
+        const auto* cellVertices = _pimpl->_cellVertices.get();
+        std::vector<unsigned> brickIndices(bricks.size());
+        for (unsigned c=0; c<unsigned(brickIndices.size()); ++c) brickIndices[c] = c;
+        _pimpl->ForEachBrick(MakeIteratorRange(brickIndices),
+            [&](unsigned b)
+            {
+                auto* dst = &mesh._quads[quadOffsets[b]];
+                for (const auto& q:bricks[b]._quads) {
+                    for (unsigned c=0; c<4; ++c) {
+                        auto cell = q._verts[c];
+                        auto x = cell % dims, y = (cell / dims) % dims, z = cell / (dims*dims);
+                        auto cellBrick = ((z / BrickDimensions) * bricksPerAxis + (y / BrickDimensions)) * bricksPerAxis + (x / BrickDimensions);
+                        assert(cellVertices[cell] != 0xffffffff);
+                        dst->_verts[c] = vertexOffsets[cellBrick] + cellVertices[cell];
+                    }
+                    ++dst;
+                }
+            });
 
-        for (int z=1; z<int(samplingGridDimensions); ++z) {
-            for (int y=1; y<int(samplingGridDimensions); ++y) {
-                for (int x=1; x<int(samplingGridDimensions); ++x) {
+        return mesh;
+    }
 
-                    float d0 = densityResults[(z * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x];
-                    float d1 = densityResults[(z * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x + 1];
-                    float d2 = densityResults[(z * (samplingGridDimensions+1) + y + 1) * (samplingGridDimensions+1) + x];
-                    float d3 = densityResults[((z + 1) * (samplingGridDimensions+1) + y) * (samplingGridDimensions+1) + x];
+    unsigned DualContourMesher::GetBrickCount() const { return unsigned(_pimpl->_bricks.size()); }
 
-                        //  If the edge has a intersection point. We want to create a 
-                        //  quad by joining together all of the cells that use this edge.
-                    if ((d0 < 0.f) != (d1 < 0.f)) {
-                        DualContourMesh::Quad q;
-                        for (unsigned c=0; c<4; ++c) {
-                            Int3 g(x + cellOffsetsX[c][0], y + cellOffsetsX[c][1], z + cellOffsetsX[c][2]);
-                            auto index = (g[2] * samplingGridDimensions + g[1]) * samplingGridDimensions + g[0];
-                            q._verts[c] = vertexIndices[index];
-                            assert(q._verts[c] < mesh._vertices.size());
-                        }
-                        AddQuad(mesh, q, d0 < 0.f);
-                    }
+    DualContourMesher::DualContourMesher(
+        unsigned samplingGridDimensions, 
+        const IVolumeDensityFunction::Boundary& boundary,
+        CompletionThreadPool* workerPool)
+    {
+        if (!samplingGridDimensions)
+            Throw(::Exceptions::BasicLabel("Dual contour sampling grid must not be empty"));
 
-                    if ((d0 < 0.f) != (d2 < 0.f)) {
-                        DualContourMesh::Quad q;
-                        for (unsigned c=0; c<4; ++c) {
-                            Int3 g(x + cellOffsetsY[c][0], y + cellOffsetsY[c][1], z + cellOffsetsY[c][2]);
-                            auto index = (g[2] * samplingGridDimensions + g[1]) * samplingGridDimensions + g[0];
-                            q._verts[c] = vertexIndices[index];
-                            assert(q._verts[c] < mesh._vertices.size());
-                        }
-                        AddQuad(mesh, q, d0 < 0.f);
-                    }
+        _pimpl = std::make_unique<Pimpl>();
+        _pimpl->_dims = samplingGridDimensions;
+        _pimpl->_boundary = boundary;
+        _pimpl->_workerPool = workerPool;
 
-                    if ((d0 < 0.f) != (d3 < 0.f)) {
-                        DualContourMesh::Quad q;
-                        for (unsigned c=0; c<4; ++c) {
-                            Int3 g(x + cellOffsetsZ[c][0], y + cellOffsetsZ[c][1], z + cellOffsetsZ[c][2]);
-                            auto index = (g[2] * samplingGridDimensions + g[1]) * samplingGridDimensions + g[0];
-                            q._verts[c] = vertexIndices[index];
-                            assert(q._verts[c] < mesh._vertices.size());
-                        }
-                        AddQuad(mesh, q, d0 < 0.f);
-                    }
+        auto& gridToSampleSpace = _pimpl->_gridToSampleSpace;
+        gridToSampleSpace = Zero<Float3x4>();
+        gridToSampleSpace(0,0) = (boundary.second[0] - boundary.first[0]) / float(samplingGridDimensions);
+        gridToSampleSpace(1,1) = (boundary.second[1] - boundary.first[1]) / float(samplingGridDimensions);
+        gridToSampleSpace(2,2) = (boundary.second[2] - boundary.first[2]) / float(samplingGridDimensions);
+        gridToSampleSpace(0,3) = boundary.first[0];
+        gridToSampleSpace(1,3) = boundary.first[1];
+        gridToSampleSpace(2,3) = boundary.first[2];
 
+        const auto cornerDims = samplingGridDimensions+1;
+        _pimpl->_densities = std::make_unique<float[]>(cornerDims*cornerDims*cornerDims);
+        _pimpl->_cellVertices = std::make_unique<unsigned[]>(samplingGridDimensions*samplingGridDimensions*samplingGridDimensions);
+        std::fill(_pimpl->_densities.get(), _pimpl->_densities.get() + cornerDims*cornerDims*cornerDims, 0.f);
+        std::fill(_pimpl->_cellVertices.get(), _pimpl->_cellVertices.get() + samplingGridDimensions*samplingGridDimensions*samplingGridDimensions, 0xffffffff);
+
+        const auto bricksPerAxis = (samplingGridDimensions + BrickDimensions - 1) / BrickDimensions;
+        _pimpl->_bricksPerAxis = bricksPerAxis;
+        _pimpl->_bricks.resize(bricksPerAxis*bricksPerAxis*bricksPerAxis);
+        for (unsigned z=0; z<bricksPerAxis; ++z)
+            for (unsigned y=0; y<bricksPerAxis; ++y)
+                for (unsigned x=0; x<bricksPerAxis; ++x) {
+                    auto& brick = _pimpl->_bricks[(z * bricksPerAxis + y) * bricksPerAxis + x];
+                    brick._mins = UInt3(x, y, z) * BrickDimensions;
+                    for (unsigned c=0; c<3; ++c)
+                        brick._maxs[c] = std::min(brick._mins[c] + BrickDimensions, samplingGridDimensions);
                 }
-            }
-        }
+    }
 
-        return mesh;
+    DualContourMesher::~DualContourMesher() {}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void IVolumeDensityFunction::GetDensities(IteratorRange<float*> dst, IteratorRange<const Float3*> pts) const
+    {
+        assert(dst.size() == pts.size());
+        for (size_t c=0; c<pts.size(); ++c)
+            dst[c] = GetDensity(pts[c]);
+    }
+
+    void IVolumeDensityFunction::GetNormals(IteratorRange<Float3*> dst, IteratorRange<const Float3*> pts) const
+    {
+        assert(dst.size() == pts.size());
+        for (size_t c=0; c<pts.size(); ++c)
+            dst[c] = GetNormal(pts[c]);
+    }
+
+    DualContourMesh     DualContourMesh_Build(  unsigned samplingGridDimensions, 
+                                                const IVolumeDensityFunction& fn,
+                                                CompletionThreadPool* workerPool)
+    {
+        DualContourMesher mesher(samplingGridDimensions, fn.GetBoundary(), workerPool);
+        mesher.Build(fn);
+        return mesher.GetMesh();
     }
 
 
@@ -7,7 +7,11 @@
 #pragma once
 
 #include "../Math/Vector.h"
+#include "../Utility/IteratorUtils.h"
 #include <vector>
+#include <memory>
+
+namespace Utility { class CompletionThreadPool; }
 
 namespace SceneEngine
 {
@@ -23,6 +27,15 @@ namespace SceneEngine
         virtual Boundary    GetBoundary() const = 0;
         virtual float       GetDensity(const Float3& pt) const = 0;
         virtual Float3      GetNormal(const Float3& pt) const = 0;
+
+            //  Batched versions of GetDensity() and GetNormal(). The mesher always asks
+            //  for a whole brick (or a whole list of edge points) at once, so implementations
+            //  that can evaluate many points together (eg, with SIMD, or with analytic
+            //  normals) should override these. The defaults just call the single point
+            //  versions. When meshing with a thread pool, these are called from several
+            //  threads at the same time.
+        virtual void        GetDensities(IteratorRange<float*> dst, IteratorRange<const Float3*> pts) const;
+        virtual void        GetNormals(IteratorRange<Float3*> dst, IteratorRange<const Float3*> pts) const;
     };
 
         ////////////////////////////////////////////////////////
@@ -44,8 +57,42 @@ namespace SceneEngine
 
         ////////////////////////////////////////////////////////
 
+    /// <summary>Builds a dual contour mesh brick by brick, and can rebuild parts of it</summary>
+    /// The sampling grid is split into bricks of 16x16x16 cells. Each brick evaluates the
+    /// density function with batched calls, and the bricks are meshed in parallel on the
+    /// given thread pool (if there is one). The vertex for each cell doesn't depend on the
+    /// brick layout or the number of threads, so the bricks always stitch together without
+    /// cracks, and the final mesh is the same for any thread count.
+    ///
+    /// After the density function has been edited, call Update() with the bounding box of
+    /// the edit to remesh only the bricks it touches. The function must not have changed
+    /// outside of that box. Update() returns the number of bricks that were rebuilt.
+    class DualContourMesher
+    {
+    public:
+        void            Build(const IVolumeDensityFunction& fn);
+        unsigned        Update(const IVolumeDensityFunction& fn, const Float3& editMins, const Float3& editMaxs);
+        DualContourMesh GetMesh() const;
+        unsigned        GetBrickCount() const;
+
+        DualContourMesher(
+            unsigned samplingGridDimensions, 
+            const IVolumeDensityFunction::Boundary& boundary,
+            Utility::CompletionThreadPool* workerPool = nullptr);
+        ~DualContourMesher();
+
+        DualContourMesher(const DualContourMesher&) = delete;
+        DualContourMesher& operator=(const DualContourMesher&) = delete;
+    protected:
+        class Pimpl;
+        std::unique_ptr<Pimpl> _pimpl;
+    };
+
+        ////////////////////////////////////////////////////////
+
     DualContourMesh     DualContourMesh_Build(  unsigned samplingGridDimensions, 
-                                                const IVolumeDensityFunction& fn);
+                                                const IVolumeDensityFunction& fn,
+                                                Utility::CompletionThreadPool* workerPool = nullptr);
 
         ////////////////////////////////////////////////////////
 
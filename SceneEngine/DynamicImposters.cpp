@@ -7,6 +7,7 @@
 #include "DynamicImposters.h"
 #include "GestaltResource.h"
 #include "SceneEngineUtils.h"
+#include "SpriteAtlasAllocator.h"
 #include "../RenderCore/Metal/State.h"
 #include "../RenderCore/Metal/DeviceContext.h"
 #include "../RenderCore/Metal/Shader.h"
@@ -25,12 +26,11 @@
 #include "../Assets/Assets.h"
 #include "../ConsoleRig/Console.h"
 #include "../Math/Transformations.h"
-#include "../Math/RectanglePacking.h"
 #include "../Utility/IteratorUtils.h"
 #include "../Utility/MemoryUtils.h"
 #include "../Utility/FunctionUtils.h"
 #include "../Utility/StringFormat.h"
-#include "../Utility/HeapUtils.h"
+#include "../Utility/TimeUtils.h"
 #include "../Utility/Meta/ClassAccessors.h"
 #include "../Utility/Meta/ClassAccessorsImpl.h"
 #include "../Utility/Meta/AccessorSerialize.h"
@@ -39,8 +39,6 @@ namespace SceneEngine
 {
     using namespace RenderCore;
 
-    using Packer = RectanglePacker_MaxRects;
-
     static unsigned GetXYAngle(
         const RenderCore::Assets::ModelScaffold& scaffold,
         const Float3x4& localToWorld, const Float3& cameraPosition, 
@@ -79,13 +77,6 @@ namespace SceneEngine
         return Float2(XlCos(angle), XlSin(angle));
     }
 
-    static UInt2 MipMapDims(UInt2 dims, unsigned mipMapLevel)
-    {
-        return UInt2(
-            std::max(dims[0] >> mipMapLevel, 1u),
-            std::max(dims[1] >> mipMapLevel, 1u));
-    }
-
     class ImposterSpriteAtlas
     {
     public:
@@ -168,48 +159,58 @@ namespace SceneEngine
 
         using SpriteHash = uint64;
 
+        static SpriteHash MakeSpriteHash(const ModelRenderer* renderer, unsigned xyAngle)
+        {
+            return HashCombine(IntegerHash64(size_t(renderer)), xyAngle);
+        }
+
         class QueuedObject
         {
         public:
             const ModelRenderer*    _renderer;
             const ModelScaffold*    _scaffold;
             unsigned                _XYangle;
+            float                   _screenSize;    // approximate size on screen of the largest instance (radius / distance)
 
-            SpriteHash MakeHash() const { return HashCombine(IntegerHash64(size_t(_renderer)), _XYangle); }
+            SpriteHash MakeHash() const { return MakeSpriteHash(_renderer, _XYangle); }
         };
         std::vector<std::pair<SpriteHash, QueuedObject>>    _queuedObjects;
         std::vector<std::pair<SpriteHash, Float4>>          _queuedInstances;
 
         static const unsigned MipMapCount = 5;
+        static const unsigned InvalidSprite = SpriteAtlasAllocator::InvalidSprite;
 
         using Rectangle = std::pair<UInt2, UInt2>;
         class PreparedSprite
         {
         public:
-            Rectangle   _rect[MipMapCount];
             Float3      _projectionCentre;
             Float2      _worldSpaceHalfSize;
-            unsigned    _createFrame;
-            unsigned    _usageFrame;
+
+                // instances drawn with this sprite in _countFrame
+            unsigned    _countFrame;
+            unsigned    _instanceCount;
+            unsigned    _standInCount;
 
             PreparedSprite()
             {
-                XlZeroMemory(_rect);
                 _projectionCentre = Zero<Float3>();
                 _worldSpaceHalfSize = Zero<Float2>();
-                _createFrame = 0;
-                _usageFrame = 0;
+                _countFrame = _instanceCount = _standInCount = 0;
             }
         };
 
             //// //// //// //// Prepared Sprites Table //// //// //// ////
-        LRUQueue                        _lruQueue;
+        SpriteAtlasAllocator            _allocator;
         std::vector<PreparedSprite>     _preparedSprites;
         std::vector<std::pair<SpriteHash, unsigned>> _preparedSpritesLookup;
-        SpanningHeap<uint16>            _preparedSpritesHeap;
+
+            //// //// //// //// Update Queue //// //// //// ////
+            // sprites that have been requested, but not prepared yet; and the
+            // frame they were first requested
+        std::vector<std::pair<SpriteHash, unsigned>> _pendingSince;
 
             //// //// //// //// Atlas //// //// //// ////
-        Packer                          _packer;
         ImposterSpriteAtlas             _atlas;
 
             //// //// //// //// Rendering //// //// //// ////
@@ -220,21 +221,26 @@ namespace SceneEngine
 
             //// //// //// //// Metrics //// //// //// ////
         unsigned    _overflowCounter;
-        unsigned    _overflowMaxSpritesCounter;
         unsigned    _pendingCounter;
         unsigned    _copyCounter;
         unsigned    _evictionCounter;
+        unsigned    _updateCounter;
+        unsigned    _standInCounter;
+        float       _updateTime;
 
         unsigned    _frameCounter;
 
         void BuildNewSprites(
             Metal::DeviceContext& context,
             Techniques::ParsingContext& parserContext);
-        PreparedSprite BuildSprite(
+        unsigned BuildSprite(
             Metal::DeviceContext& context,
             Techniques::ParsingContext& parserContext,
             const QueuedObject& ob);
-        bool AttemptEviction();
+        unsigned FindSprite(SpriteHash hash) const;
+        unsigned FindStandIn(const QueuedObject& ob, unsigned& angularError) const;
+        void RemoveFromLookup(unsigned spriteIndex);
+        void ResetSpriteTable();
         void RenderObject(
             Metal::DeviceContext& context,
             Techniques::ParsingContext& parserContext,
@@ -254,16 +260,57 @@ namespace SceneEngine
         return StringMeldAppend(parserContext._stringHelpers->_quickMetrics);
     }
 
-    static bool IsGood(const std::pair<UInt2, UInt2>& rect)
+    auto DynamicImposters::Pimpl::FindSprite(SpriteHash hash) const -> unsigned
     {
-        return rect.second[0] > rect.first[0]
-            && rect.second[1] > rect.first[1];
+        auto i = LowerBound(_preparedSpritesLookup, hash);
+        if (i != _preparedSpritesLookup.end() && i->first == hash)
+            return i->second;
+        return InvalidSprite;
     }
 
-    static const unsigned MaxPreparePerFrame = 3;
-    static const unsigned MaxEvictionPerFrame = 3;
-    static const unsigned EvictionCreateGracePeriod = 60;   // don't evict sprites within this many frames from their creation
-    static const unsigned EvictionUsageGracePeriod = 5;     // don't evict sprites within this many frames of being used
+    auto DynamicImposters::Pimpl::FindStandIn(const QueuedObject& ob, unsigned& angularError) const -> unsigned
+    {
+            // Look for a sprite of the same model from the nearest angle. While the
+            // correct sprite is pending, we can draw this one in its place.
+            // "angularError" is the number of angle steps between them (or _angleQuant if 
+            // there are no prepared sprites for this model at all)
+        const auto angleQuant = _config._angleQuant;
+        for (unsigned d=1; d<=angleQuant/2; ++d) {
+            auto sprite = FindSprite(MakeSpriteHash(ob._renderer, (ob._XYangle + d) % angleQuant));
+            if (sprite == InvalidSprite)
+                sprite = FindSprite(MakeSpriteHash(ob._renderer, (ob._XYangle + angleQuant - d) % angleQuant));
+            if (sprite != InvalidSprite) {
+                angularError = d;
+                return sprite;
+            }
+        }
+        angularError = angleQuant;
+        return InvalidSprite;
+    }
+
+    void DynamicImposters::Pimpl::RemoveFromLookup(unsigned spriteIndex)
+    {
+        auto i = std::find_if(
+            _preparedSpritesLookup.begin(), _preparedSpritesLookup.end(),
+            [spriteIndex](const std::pair<SpriteHash, unsigned>& p) { return p.second == spriteIndex; });
+        assert(i!=_preparedSpritesLookup.end());
+        if (i!=_preparedSpritesLookup.end())
+            _preparedSpritesLookup.erase(i);
+    }
+
+    void DynamicImposters::Pimpl::ResetSpriteTable()
+    {
+            // (the allocator and eviction rules are always built from the current config)
+        SpriteAtlasAllocator::EvictionRules evictionRules;
+        evictionRules._maxEvictionsPerFrame = _config._maxEvictionsPerFrame;
+        _allocator = SpriteAtlasAllocator(
+            Truncate(_config._altasSize), _config._maxSpriteCount, MipMapCount, evictionRules);
+        _preparedSprites.clear();
+        _preparedSpritesLookup.clear();
+        _pendingSince.clear();
+        _preparedSprites.resize(_config._maxSpriteCount);
+        _preparedSpritesLookup.reserve(_config._maxSpriteCount);
+    }
 
     void DynamicImposters::Pimpl::BuildNewSprites(
         Metal::DeviceContext& context,
@@ -277,120 +324,82 @@ namespace SceneEngine
             | ProtectState::States::BlendState;
         bool initProtectState = false;
 
-        const unsigned maxPreparePerFrame = Tweakable("ImpostersReset", false) ? INT_MAX : MaxPreparePerFrame;
-        unsigned preparedThisFrame = 0;
-
         _overflowCounter = 0;
-        _overflowMaxSpritesCounter = 0;
         _pendingCounter = 0;
         _evictionCounter = 0;
-
-        auto preparedSpritesI = _preparedSpritesLookup.begin();
-        for (const auto& o:_queuedObjects) {
-            uint64 hash = o.first;
-            preparedSpritesI = std::lower_bound(preparedSpritesI, _preparedSpritesLookup.end(), hash, CompareFirst<Pimpl::SpriteHash, unsigned>());
-            if (preparedSpritesI != _preparedSpritesLookup.end() && preparedSpritesI->first == hash) {
-            } else {
-                if (preparedThisFrame++ >= maxPreparePerFrame) {
+        _updateCounter = 0;
+        _updateTime = 0.f;
+
+            // Find the sprites that need to be built, and prioritise them. Large objects
+            // on screen come first; and objects that have no stand-in (or only a stand-in
+            // from a distant angle) are given a higher priority than those that have a
+            // stand-in from a neighbouring angle.
+            // We also track when each request first appeared, so we know how long
+            // requests are waiting in the queue.
+        std::vector<std::pair<float, unsigned>> requests;
+        std::vector<std::pair<SpriteHash, unsigned>> pendingSince;
+        requests.reserve(_queuedObjects.size());
+        pendingSince.reserve(_queuedObjects.size());
+        for (unsigned c=0; c<unsigned(_queuedObjects.size()); ++c) {
+            const auto& o = _queuedObjects[c];
+            if (FindSprite(o.first) != InvalidSprite) continue;
+
+            unsigned angularError;
+            FindStandIn(o.second, angularError);
+            requests.push_back(std::make_pair(o.second._screenSize * float(1 + angularError), c));
+
+            auto existing = LowerBound(_pendingSince, o.first);
+            auto firstFrame = (existing != _pendingSince.end() && existing->first == o.first) ? existing->second : _frameCounter;
+            pendingSince.push_back(std::make_pair(o.first, firstFrame));
+        }
+        _pendingSince = std::move(pendingSince);    // (sorted, because _queuedObjects is sorted)
+        std::sort(requests.begin(), requests.end(),
+            [](const std::pair<float, unsigned>& lhs, const std::pair<float, unsigned>& rhs) 
+            { return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second); });
+
+            // Build sprites in priority order until we run out of this frame's budget. We
+            // always build at least one, so everything will get built eventually. Note that 
+            // the time budget is CPU time spent submitting the work; not GPU time.
+        const bool unlimited = Tweakable("ImpostersReset", false);
+        const auto startTime = GetPerformanceCounter();
+        const auto timeBudget = uint64(double(_config._updateTimeBudget) / 1000.0 * double(GetPerformanceCounterFrequency()));
+        unsigned attemptCount = 0;
+
+        for (const auto& r:requests) {
+            if (!unlimited && attemptCount > 0) {
+                if (    attemptCount >= _config._maxUpdatesPerFrame
+                    ||  (GetPerformanceCounter() - startTime) >= timeBudget) {
                     ++_pendingCounter;
                     continue;
                 }
-
-                unsigned newIndex = _preparedSpritesHeap.Allocate(1<<4)>>4;
-                if (newIndex == (~0x0u)>>4) {
-                    ++_overflowMaxSpritesCounter;
-                    continue;
-                }
-
-                if (!initProtectState) {
-                    protectState = ProtectState(context, volatileStates);
-                    initProtectState = true;
-                }
-                
-                TRY {
-                    auto& newSprite = _preparedSprites[newIndex];
-                    newSprite = BuildSprite(context, parserContext, o.second);
-                    if (!IsGood(newSprite._rect[0])) {
-                        if (AttemptEviction()) {
-                                // reset preparedSpritesI, because _preparedSpritesLookup
-                                // may have changed in AttemptEviction!
-                                // (note that we have to do this before BuildSprite, because BuildSprite can throw)
-                            preparedSpritesI = std::lower_bound(
-                                _preparedSpritesLookup.begin(), _preparedSpritesLookup.end(), 
-                                hash, CompareFirst<Pimpl::SpriteHash, unsigned>());
-
-                            newSprite = BuildSprite(context, parserContext, o.second);
-                        }
-                    }
-
-                    if (IsGood(newSprite._rect[0])) {
-                        preparedSpritesI = _preparedSpritesLookup.insert(preparedSpritesI, std::make_pair(hash, newIndex));
-                        _lruQueue.BringToFront(newIndex);
-                    } else {
-                        ++_overflowCounter;
-                        _preparedSpritesHeap.Deallocate(newIndex<<4, 1<<4);
-                    }
-                } CATCH(const ::Assets::Exceptions::AssetException&e) {
-                    parserContext.Process(e);
-                    ++_pendingCounter;
-                    _preparedSpritesHeap.Deallocate(newIndex<<4, 1<<4);
-                } CATCH(...) {
-                    _preparedSpritesHeap.Deallocate(newIndex<<4, 1<<4);
-                    throw;
-                } CATCH_END
             }
-        }
-    }
-
-    bool DynamicImposters::Pimpl::AttemptEviction()
-    {
-            // Attempt to evict the oldest sprites from the list to free
-            // up some more space in the altas.
-            // Note that the oldest sprites are not guaranteed to be 
-            // contiguous, nor are they guaranteed to be large (relative
-            // to the new sprite we want to insert).
-            //
-            // So it's quite possible that evicting some sprites may not
-            // free up enough room to insert the new sprite we want.
-            //
-            // It may take a few frames of eviction before we can insert
-            // the particular new sprite we want.
-        if (_evictionCounter != 0) return false;
-
-        const unsigned evictionCount = MaxEvictionPerFrame;
-        unsigned evicted=0;
-        for (evicted; evicted<evictionCount; evicted++) {
-            if (_preparedSpritesHeap.IsEmpty()) break;
-
-            auto oldest = _lruQueue.GetOldestValue();
-
-            auto& sprite = _preparedSprites[oldest];
-
-                // Check the grace period... prevent sprites from being evicted too
-                // soon after being created or used. We will tend to hit these breaks
-                // when the atlas is saturated and we can't fit in any more sprites...
-            if ((_frameCounter - sprite._createFrame) < EvictionCreateGracePeriod) break;
-            if ((_frameCounter - sprite._usageFrame) < EvictionUsageGracePeriod) break;
+            ++attemptCount;
 
-            for (unsigned c=0; c<dimof(sprite._rect); ++c) {
-                _packer.Deallocate(sprite._rect[c]);        // return rectangle to the packer
-                sprite._rect[c] = std::make_pair(UInt2(0,0), UInt2(0,0));
+            if (!initProtectState) {
+                protectState = ProtectState(context, volatileStates);
+                initProtectState = true;
             }
 
-            _preparedSpritesHeap.Deallocate(oldest<<4, 1<<4);
-            auto i = std::find_if(
-                _preparedSpritesLookup.cbegin(), _preparedSpritesLookup.cend(),
-                [oldest](const std::pair<SpriteHash, unsigned>& p) { return p.second == oldest; });
-            assert(i!=_preparedSpritesLookup.cend());
-            _preparedSpritesLookup.erase(i);
-
-                // we have to bring it to the front in order to
-                // get a new oldest value
-            _lruQueue.DisconnectOldest();
+            const auto& o = _queuedObjects[r.second];
+            TRY {
+                auto newIndex = BuildSprite(context, parserContext, o.second);
+                if (newIndex != InvalidSprite) {
+                    auto i = LowerBound(_preparedSpritesLookup, o.first);
+                    _preparedSpritesLookup.insert(i, std::make_pair(o.first, newIndex));
+                    auto p = LowerBound(_pendingSince, o.first);
+                    if (p != _pendingSince.end() && p->first == o.first)
+                        _pendingSince.erase(p);
+                    ++_updateCounter;
+                } else {
+                    ++_overflowCounter;
+                }
+            } CATCH(const ::Assets::Exceptions::AssetException&e) {
+                parserContext.Process(e);
+                ++_pendingCounter;
+            } CATCH_END
         }
 
-        _evictionCounter = evicted;
-        return evicted > 0;
+        _updateTime = float(double(GetPerformanceCounter() - startTime) * 1000.0 / double(GetPerformanceCounterFrequency()));
     }
 
     void DynamicImposters::Render(
@@ -438,20 +447,37 @@ namespace SceneEngine
             // sorting when sorting on a per-sprite basis)
         std::sort(_pimpl->_queuedInstances.begin(), _pimpl->_queuedInstances.end(), CompareFirst<uint64, Float4>());
 
-        auto preparedSpritesI = _pimpl->_preparedSpritesLookup.begin();
+        _pimpl->_standInCounter = 0;
         for (auto i=_pimpl->_queuedInstances.cbegin(); i!=_pimpl->_queuedInstances.cend();) {
             uint64 hash = i->first;
             auto start = i++;
             while (i < _pimpl->_queuedInstances.cend() && i->first == hash) ++i;
 
-            preparedSpritesI = std::lower_bound(preparedSpritesI, _pimpl->_preparedSpritesLookup.end(), hash, CompareFirst<Pimpl::SpriteHash, unsigned>());
-            if (preparedSpritesI == _pimpl->_preparedSpritesLookup.end() || preparedSpritesI->first != hash)
-                continue;
+                // If the sprite for this angle isn't ready yet, we can use a sprite
+                // from a nearby angle as a stand-in
+            bool standIn = false;
+            unsigned spriteIndex = _pimpl->FindSprite(hash);
+            if (spriteIndex == Pimpl::InvalidSprite) {
+                auto ob = LowerBound(_pimpl->_queuedObjects, hash);
+                if (ob == _pimpl->_queuedObjects.end() || ob->first != hash) continue;
+                unsigned angularError;
+                spriteIndex = _pimpl->FindStandIn(ob->second, angularError);
+                if (spriteIndex == Pimpl::InvalidSprite) continue;
+                standIn = true;
+            }
 
-            unsigned spriteIndex = preparedSpritesI->second;
             auto& sprite = _pimpl->_preparedSprites[spriteIndex];
-            assert(sprite._rect[0].second[0] > sprite._rect[0].first[0]
-                && sprite._rect[0].second[1] > sprite._rect[0].first[1]);
+            assert(_pimpl->_allocator.GetSprite(spriteIndex)._allocated);
+            if (sprite._countFrame != _pimpl->_frameCounter) {
+                sprite._countFrame = _pimpl->_frameCounter;
+                sprite._instanceCount = sprite._standInCount = 0;
+            }
+            auto instanceCount = unsigned(i - start);
+            sprite._instanceCount += instanceCount;
+            if (standIn) {
+                sprite._standInCount += instanceCount;
+                _pimpl->_standInCounter += instanceCount;
+            }
 
                 // We should have a number of sprites of the same instance. Expand the sprite into 
                 // triangles here, on the CPU. 
@@ -468,8 +494,7 @@ namespace SceneEngine
                 vertices.push_back(Vertex {center + scale * projectionCenter, cameraRight, cameraUp, scale * projectionSize, spriteIndex, sortingDistance});
             }
 
-            _pimpl->_lruQueue.BringToFront(spriteIndex);
-            sprite._usageFrame = _pimpl->_frameCounter;
+            _pimpl->_allocator.Touch(spriteIndex, _pimpl->_frameCounter);
         }
 
         if (vertices.empty()) return;
@@ -493,7 +518,7 @@ namespace SceneEngine
         for (unsigned c=0; c<std::min(unsigned(_pimpl->_preparedSprites.size()), maxSprites); ++c) {
             auto& e = buffer[c];
             for (unsigned m=0; m<Pimpl::MipMapCount; ++m) {
-                const auto &r = _pimpl->_preparedSprites[c]._rect[m];
+                const auto &r = _pimpl->_allocator.GetSprite(c)._rect[m];
                 e._coords[m] = UInt4(r.first[0], r.first[1], r.second[0], r.second[1]);
             }
         }
@@ -526,7 +551,7 @@ namespace SceneEngine
     auto DynamicImposters::Pimpl::BuildSprite(
         RenderCore::Metal::DeviceContext& context,
         RenderCore::Techniques::ParsingContext& parserContext,
-        const QueuedObject& ob) -> PreparedSprite
+        const QueuedObject& ob) -> unsigned
     {
         Metal::GPUProfiler::DebugAnnotation annon(context, L"Imposter-Prepare");
 
@@ -629,47 +654,42 @@ namespace SceneEngine
         }
 
             // Reserve some space before we render
-            // Note that we have to be careful here, because this operation must
-            // be reversable. If there is an exception during rendering (eg, pending
-            // asset) or a failure while allocating space for mip-maps, then we want
-            // to revert to our previous state.
-            // Note that copying the packer here results in an allocation... It would
-            // be good if we could avoid this allocation!
-        Packer newPacker = _packer;
-
-        Rectangle reservedSpace[MipMapCount];
-        for (unsigned c=0; c<MipMapCount; ++c) {
-            reservedSpace[c] = newPacker.Allocate(MipMapDims(dims, c));
-            if (    reservedSpace[c].first[0] >= reservedSpace[c].second[0]
-                ||  reservedSpace[c].first[1] >= reservedSpace[c].second[1]) {
-                return PreparedSprite();
-            }
-        }
-
-            // Render the object to our temporary buffer with the given camera
-            // and focus points (and the viewport we've calculated)
-            // Is it best to render with a perspective camera? Or orthogonal?
-            // Because the sprite is used at different distances, the perspective
-            // is not fixed... But a fixed perspective camera might still be a better
-            // approximation than an orthogonal camera.
+            // This may evict some old sprites to make room. Those are removed from
+            // the lookup table immediately -- they are gone, even if we fail below.
+            // If there is an exception during rendering (eg, pending asset), we will
+            // release the new space again.
+        std::vector<unsigned> evicted;
+        auto spriteIndex = _allocator.Allocate(dims, _frameCounter, &evicted);
+        for (auto e:evicted) RemoveFromLookup(e);
+        _evictionCounter += unsigned(evicted.size());
+        if (spriteIndex == InvalidSprite) return InvalidSprite;
+
+        const auto& reservedSpace = _allocator.GetSprite(spriteIndex)._rect;
         Float4x4 finalProj = adjustmentMatrix * virtualProj;
-        RenderObject(
-            context, parserContext, ob,
-            camToWorld, Metal::ViewportDesc(0.f, 0.f, float(maxCoords[0] - minCoords[0]), float(maxCoords[1] - minCoords[1])),
-            finalProj);
-
-            // Now we want to copy the rendered sprite into the atlas
-            // We should generate the mip-maps in this step as well.
-        context.Bind(Techniques::CommonResources()._blendOpaque);
-        for (unsigned c=0; c<MipMapCount; ++c) {
-            CopyToAltas(
-                context, reservedSpace[c],
-                Rectangle(UInt2(0, 0), maxCoords - minCoords));
-        }
-
-            // once everything is complete (and there is no further possibility of an exception,
-            // we should commit our changes to the rectangle packer)
-        _packer = std::move(newPacker);
+        TRY {
+                // Render the object to our temporary buffer with the given camera
+                // and focus points (and the viewport we've calculated)
+                // Is it best to render with a perspective camera? Or orthogonal?
+                // Because the sprite is used at different distances, the perspective
+                // is not fixed... But a fixed perspective camera might still be a better
+                // approximation than an orthogonal camera.
+            RenderObject(
+                context, parserContext, ob,
+                camToWorld, Metal::ViewportDesc(0.f, 0.f, float(maxCoords[0] - minCoords[0]), float(maxCoords[1] - minCoords[1])),
+                finalProj);
+
+                // Now we want to copy the rendered sprite into the atlas
+                // We should generate the mip-maps in this step as well.
+            context.Bind(Techniques::CommonResources()._blendOpaque);
+            for (unsigned c=0; c<MipMapCount; ++c) {
+                CopyToAltas(
+                    context, reservedSpace[c],
+                    Rectangle(UInt2(0, 0), maxCoords - minCoords));
+            }
+        } CATCH(...) {
+            _allocator.Release(spriteIndex);
+            throw;
+        } CATCH_END
 
         for (unsigned c=0; c<MipMapCount; ++c)
             _copyCounter += 
@@ -677,9 +697,8 @@ namespace SceneEngine
                 *   (reservedSpace[c].second[1] - reservedSpace[c].first[1])
                 ;
 
-        PreparedSprite result;
-        for (unsigned c=0; c<MipMapCount; ++c)
-            result._rect[c] = reservedSpace[c];
+        auto& result = _preparedSprites[spriteIndex];
+        result = PreparedSprite();
         result._projectionCentre = centre;
 
             // Get the world space sprite rectangle for the plane through a point exactly
@@ -695,9 +714,7 @@ namespace SceneEngine
             result._worldSpaceHalfSize[0] = aspect * result._worldSpaceHalfSize[1];
         }
 
-        result._createFrame = _frameCounter;
-
-        return result;
+        return spriteIndex;
     }
 
     void DynamicImposters::Pimpl::CopyToAltas(
@@ -865,15 +882,8 @@ namespace SceneEngine
         _pimpl->_queuedInstances.clear();
 
         if (Tweakable("ImpostersReset", false)) {
-            _pimpl->_packer = Packer(Truncate(_pimpl->_config._altasSize));
             _pimpl->_copyCounter = 0;
-
-            _pimpl->_preparedSprites.clear();
-            _pimpl->_preparedSpritesLookup.clear();
-            _pimpl->_lruQueue = LRUQueue(_pimpl->_config._maxSpriteCount);
-            _pimpl->_preparedSprites.resize(_pimpl->_config._maxSpriteCount);
-            _pimpl->_preparedSpritesLookup.reserve(_pimpl->_config._maxSpriteCount);
-            _pimpl->_preparedSpritesHeap = SpanningHeap<uint16>(_pimpl->_config._maxSpriteCount<<4);
+            _pimpl->ResetSpriteTable();
         }
     }
 
@@ -887,17 +897,27 @@ namespace SceneEngine
             // For objects that are incorrectly exported (eg wrong up vector), we will sometimes 
             // rotate all instances to compenstate. But that will be ignored when we get to this 
             // point!
-        auto qo = Pimpl::QueuedObject { &renderer, &scaffold, GetXYAngle(scaffold, localToWorld, cameraPosition, _pimpl->_config._angleQuant) };
+            //
+            // The approximate screen size (bounding sphere radius / distance) is used
+            // to prioritise building sprites. We only need the largest instance.
+        const auto translation = ExtractTranslation(localToWorld);
+        const auto scale = ExtractUniformScaleFast(localToWorld);
+        const auto& bb = scaffold.GetStaticBoundingBox();
+        float screenSize = 
+            (.5f * scale * Magnitude(bb.second - bb.first))
+            / std::max(Magnitude(translation - cameraPosition), 1e-3f);
+
+        auto qo = Pimpl::QueuedObject { &renderer, &scaffold, GetXYAngle(scaffold, localToWorld, cameraPosition, _pimpl->_config._angleQuant), screenSize };
         auto hash = qo.MakeHash();
         auto existing = LowerBound(_pimpl->_queuedObjects, hash);
 
-        if (existing == _pimpl->_queuedObjects.end() || existing->first != hash)
+        if (existing == _pimpl->_queuedObjects.end() || existing->first != hash) {
             _pimpl->_queuedObjects.insert(existing, std::make_pair(hash, qo));
+        } else {
+            existing->second._screenSize = std::max(existing->second._screenSize, screenSize);
+        }
                 
-        _pimpl->_queuedInstances.push_back(
-            std::make_pair(hash, Expand(
-                ExtractTranslation(localToWorld),
-                ExtractUniformScaleFast(localToWorld))));
+        _pimpl->_queuedInstances.push_back(std::make_pair(hash, Expand(translation, scale)));
     }
 
     void DynamicImposters::Load(const Config& config)
@@ -907,7 +927,6 @@ namespace SceneEngine
         _pimpl->_config = config;
 
         auto atlasSize = Truncate(config._altasSize);
-        _pimpl->_packer = Packer(atlasSize);
         _pimpl->_copyCounter = 0;
 
             // the formats we initialize for the atlas really depend on whether we're going
@@ -916,12 +935,7 @@ namespace SceneEngine
             atlasSize, config._maxDims, { Metal::NativeFormat::R8G8B8A8_UNORM_SRGB, Metal::NativeFormat::R8G8B8A8_SNORM});
 
             // allocate the sprite table 
-        _pimpl->_preparedSprites.clear();
-        _pimpl->_preparedSpritesLookup.clear();
-        _pimpl->_lruQueue = LRUQueue(config._maxSpriteCount);
-        _pimpl->_preparedSprites.resize(config._maxSpriteCount);
-        _pimpl->_preparedSpritesLookup.reserve(config._maxSpriteCount);
-        _pimpl->_preparedSpritesHeap = SpanningHeap<uint16>(_pimpl->_config._maxSpriteCount<<4);
+        _pimpl->ResetSpriteTable();
     }
 
     void DynamicImposters::Disable()
@@ -929,12 +943,11 @@ namespace SceneEngine
         Reset();
         _pimpl->_preparedSprites.clear();
         _pimpl->_config = Config();
-        _pimpl->_packer = Packer();
         _pimpl->_atlas = ImposterSpriteAtlas();
-        _pimpl->_lruQueue = LRUQueue();
+        _pimpl->_allocator = SpriteAtlasAllocator();
         _pimpl->_preparedSprites = decltype(_pimpl->_preparedSprites)();
         _pimpl->_preparedSpritesLookup = decltype(_pimpl->_preparedSpritesLookup)();
-        _pimpl->_preparedSpritesHeap = decltype(_pimpl->_preparedSpritesHeap)();
+        _pimpl->_pendingSince = decltype(_pimpl->_pendingSince)();
     }
 
     float DynamicImposters::GetThresholdDistance() const { return _pimpl->_config._thresholdDistance; }
@@ -942,37 +955,40 @@ namespace SceneEngine
 
     auto DynamicImposters::GetMetrics() const -> Metrics
     {
+        const auto& allocator = _pimpl->_allocator;
         Metrics result;
-        result._spriteCount = _pimpl->_preparedSpritesHeap.CalculateAllocatedSpace() >> 4;
-        result._maxSpriteCount = (unsigned)_pimpl->_preparedSprites.size();
-        result._pixelsAllocated = 0;
-        for (const auto&i:_pimpl->_preparedSprites) {
-            for (unsigned m=0; m<dimof(i._rect); ++m) {
-                const auto& r = i._rect[m];
-                result._pixelsAllocated += (r.second[0] - r.first[0]) * (r.second[1] - r.first[1]);
-            }
-        }
+        result._spriteCount = allocator.GetSpriteCount();
+        result._maxSpriteCount = allocator.GetMaxSpriteCount();
+        result._pixelsAllocated = allocator.GetPixelsAllocated();
         result._pixelsTotal = 
               _pimpl->_config._altasSize[0]
             * _pimpl->_config._altasSize[1]
             * _pimpl->_config._altasSize[2]
             ;
-        result._overflowCounter = _pimpl->_overflowCounter + _pimpl->_overflowMaxSpritesCounter;
+        result._overflowCounter = _pimpl->_overflowCounter;
         result._pendingCounter = _pimpl->_pendingCounter;
         result._evictionCounter = _pimpl->_evictionCounter;
-        std::tie(result._largestFreeBlockArea, result._largestFreeBlockSide) 
-            = _pimpl->_packer.LargestFreeBlock();
-        
+        std::tie(result._largestFreeBlockArea, result._largestFreeBlockSide) = allocator.LargestFreeBlock();
+        result._fragmentation = allocator.Fragmentation();
+
         result._bytesPerPixel = 
             (Metal::BitsPerPixel(Metal::NativeFormat::R8G8B8A8_UNORM_SRGB) + Metal::BitsPerPixel(Metal::NativeFormat::R8G8B8A8_SNORM)) / 8;
         result._layerCount = (unsigned)_pimpl->_atlas._layers.size();
 
-        auto oldest = _pimpl->_lruQueue.GetOldestValue();
-        if (oldest != unsigned(0x0)) {
-            result._mostStaleCounter = _pimpl->_frameCounter - _pimpl->_preparedSprites[oldest]._usageFrame;
+        auto oldest = allocator.GetLeastRecentlyUsed();
+        if (oldest != Pimpl::InvalidSprite) {
+            result._mostStaleCounter = _pimpl->_frameCounter - allocator.GetSprite(oldest)._usageFrame;
         } else {
             result._mostStaleCounter = 0;
         }
+
+        result._queueDepth = (unsigned)_pimpl->_pendingSince.size();
+        result._oldestPendingAge = 0;
+        for (const auto& p:_pimpl->_pendingSince)
+            result._oldestPendingAge = std::max(result._oldestPendingAge, _pimpl->_frameCounter - p.second);
+        result._updateCounter = _pimpl->_updateCounter;
+        result._updateTime = _pimpl->_updateTime;
+        result._standInCounter = _pimpl->_standInCounter;
         return result;
     }
 
@@ -983,12 +999,16 @@ namespace SceneEngine
 
     auto DynamicImposters::GetSpriteMetrics(unsigned spriteIndex) -> SpriteMetrics
     {
-        const auto& sprite = _pimpl->_preparedSprites[spriteIndex];
+        const auto& sprite = _pimpl->_allocator.GetSprite(spriteIndex);
+        const auto& prepared = _pimpl->_preparedSprites[spriteIndex];
         SpriteMetrics result;
         for (unsigned c=0; c<dimof(result._mipMaps); ++c)
             result._mipMaps[c] = sprite._rect[c];
         result._age = _pimpl->_frameCounter - sprite._createFrame;
         result._timeSinceUsage = _pimpl->_frameCounter - sprite._usageFrame;
+        const bool drawnThisFrame = sprite._allocated && prepared._countFrame == _pimpl->_frameCounter;
+        result._instanceCount = drawnThisFrame ? prepared._instanceCount : 0;
+        result._standInCount = drawnThisFrame ? prepared._standInCount : 0;
         return result;
     }
 
@@ -997,10 +1017,12 @@ namespace SceneEngine
         _pimpl = std::make_unique<Pimpl>();
         _pimpl->_sharedStateSet = &sharedStateSet;
         _pimpl->_overflowCounter = 0;
-        _pimpl->_overflowMaxSpritesCounter = 0;
         _pimpl->_pendingCounter = 0;
         _pimpl->_copyCounter = 0;
         _pimpl->_evictionCounter = 0;
+        _pimpl->_updateCounter = 0;
+        _pimpl->_standInCounter = 0;
+        _pimpl->_updateTime = 0.f;
         _pimpl->_frameCounter = 0;
 
         _pimpl->_material = Techniques::TechniqueMaterial(
@@ -1024,6 +1046,9 @@ namespace SceneEngine
         _maxDims = UInt2(128, 128);
         _altasSize = UInt3(1024, 256, 1); // UInt3(4096, 2048, 1);
         _maxSpriteCount = 256;
+        _maxUpdatesPerFrame = 3;
+        _updateTimeBudget = 2.f;
+        _maxEvictionsPerFrame = 3;
     }
 
     DynamicImposters::Metrics::Metrics()
@@ -1035,6 +1060,14 @@ namespace SceneEngine
         _largestFreeBlockSide = UInt2(0,0);
         _overflowCounter = 0;
         _pendingCounter = 0;
+        _evictionCounter = 0;
+        _mostStaleCounter = 0;
+        _fragmentation = 0.f;
+        _queueDepth = 0;
+        _oldestPendingAge = 0;
+        _updateCounter = 0;
+        _updateTime = 0.f;
+        _standInCounter = 0;
         _bytesPerPixel = 0;
         _layerCount = 0;
     }
@@ -1058,6 +1091,9 @@ template<> const ClassAccessors& GetAccessors<SceneEngine::DynamicImposters::Con
         props.Add(u("MaxDims"), DefaultGet(Obj, _maxDims),  DefaultSet(Obj, _maxDims));
         props.Add(u("AltasSize"), DefaultGet(Obj, _altasSize),  DefaultSet(Obj, _altasSize));
         props.Add(u("MaxSpriteCount"), DefaultGet(Obj, _maxSpriteCount),  DefaultSet(Obj, _maxSpriteCount));
+        props.Add(u("MaxUpdatesPerFrame"), DefaultGet(Obj, _maxUpdatesPerFrame),  DefaultSet(Obj, _maxUpdatesPerFrame));
+        props.Add(u("UpdateTimeBudget"), DefaultGet(Obj, _updateTimeBudget),  DefaultSet(Obj, _updateTimeBudget));
+        props.Add(u("MaxEvictionsPerFrame"), DefaultGet(Obj, _maxEvictionsPerFrame),  DefaultSet(Obj, _maxEvictionsPerFrame));
 
         init = true;
     }
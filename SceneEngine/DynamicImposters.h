@@ -20,6 +20,13 @@ namespace SceneEngine
     /// several sprites for different angles and lighting conditions).
     ///
     /// In this case, the sprites are dynamically created as required.
+    ///
+    /// Sprites that are needed but not yet built go into a prioritised queue. Each frame,
+    /// the most important sprites are built, up to a limit on the number of sprites and on
+    /// the time spent. Larger objects on screen are built first; and objects that can't be
+    /// drawn at all come before objects that can borrow a sprite from a neighbouring angle
+    /// in the meantime. Space in the atlas is managed by a SpriteAtlasAllocator, which
+    /// evicts the least recently used sprites when the atlas is full.
     class DynamicImposters
     {
     public:
@@ -52,6 +59,9 @@ namespace SceneEngine
             UInt2       _maxDims;
             UInt3       _altasSize;
             unsigned    _maxSpriteCount;
+            unsigned    _maxUpdatesPerFrame;
+            float       _updateTimeBudget;      // in milliseconds (CPU time for building sprites each frame)
+            unsigned    _maxEvictionsPerFrame;
 
             Config();
         };
@@ -93,6 +103,14 @@ namespace SceneEngine
         unsigned    _pendingCounter;
         unsigned    _evictionCounter;
         unsigned    _mostStaleCounter;  // how many frames since the "most stale" sprite was used
+        float       _fragmentation;     // 0 when the free space is a single rectangle, approaching 1 when it's broken up
+
+            // update queue
+        unsigned    _queueDepth;        // sprites requested, but not yet built
+        unsigned    _oldestPendingAge;  // how many frames the oldest request in the queue has been waiting
+        unsigned    _updateCounter;     // sprites built this frame
+        float       _updateTime;        // milliseconds spent building sprites this frame
+        unsigned    _standInCounter;    // instances drawn with a sprite from a neighbouring angle
 
             // atlas config
         unsigned    _bytesPerPixel;
@@ -106,6 +124,8 @@ namespace SceneEngine
     public:
         std::pair<UInt2, UInt2> _mipMaps[5];
         unsigned _age, _timeSinceUsage;
+        unsigned _instanceCount;        // instances drawn with this sprite this frame
+        unsigned _standInCount;         // (of those, the ones that were drawn as a stand-in for another angle)
     };
 }
 
@@ -147,6 +147,7 @@ namespace SceneEngine
         unsigned _N;
 
         PoissonSolver _poissonSolver;
+        Utility::CompletionThreadPool* _workerPool;
         DiffusionHelper _densityDiffusion;
         DiffusionHelper _velocityDiffusion;
         DiffusionHelper _temperatureDiffusion;
@@ -234,7 +235,8 @@ namespace SceneEngine
 
         AdvectionSettings advSettings {
             (AdvectionMethod)settings._advectionMethod, (AdvectionInterp)settings._interpolationMethod, settings._advectionSteps,
-            (AdvectionBorder)settings._borderX, (AdvectionBorder)settings._borderY, AdvectionBorder::None
+            (AdvectionBorder)settings._borderX, (AdvectionBorder)settings._borderY, AdvectionBorder::None,
+            _pimpl->_workerPool
         };
         PerformAdvection(
             VectorField2D(&velUT1,      &velVT1,        _pimpl->_dimsWithBorder),
@@ -344,9 +346,10 @@ namespace SceneEngine
 
     UInt2 FluidSolver2D::GetDimensions() const { return _pimpl->_dimsWithBorder; }
 
-    FluidSolver2D::FluidSolver2D(UInt2 dimensions)
+    FluidSolver2D::FluidSolver2D(UInt2 dimensions, Utility::CompletionThreadPool* workerPool)
     {
         _pimpl = std::make_unique<Pimpl>();
+        _pimpl->_workerPool = workerPool;
         _pimpl->_dimsWithoutBorder = dimensions;
         _pimpl->_dimsWithBorder = dimensions + UInt2(2, 2);
         auto N = _pimpl->_dimsWithBorder[0] * _pimpl->_dimsWithBorder[1];
@@ -423,7 +426,7 @@ namespace SceneEngine
         // _pimpl->_bandedPrecon = SparseBandedMatrix(std::move(bandedPrecon), _pimpl->_bands, dimof(_pimpl->_bands));
 
         UInt2 fullDims(dimensions[0]+2, dimensions[1]+2);
-        _pimpl->_poissonSolver = PoissonSolver(2, &fullDims[0]);
+        _pimpl->_poissonSolver = PoissonSolver(2, &fullDims[0], workerPool);
     }
 
     FluidSolver2D::~FluidSolver2D(){}
@@ -459,6 +462,7 @@ namespace SceneEngine
         unsigned _N;
 
         PoissonSolver _poissonSolver;
+        Utility::CompletionThreadPool* _workerPool;
         std::shared_ptr<PoissonSolver::PreparedMatrix> _densityDiffusion;
         std::shared_ptr<PoissonSolver::PreparedMatrix> _velocityDiffusion;
         std::shared_ptr<PoissonSolver::PreparedMatrix> _incompressibility;
@@ -517,7 +521,8 @@ namespace SceneEngine
 
         AdvectionSettings advSettings { 
             (AdvectionMethod)settings._advectionMethod, (AdvectionInterp)settings._interpolationMethod, settings._advectionSteps,
-            AdvectionBorder::Margin, AdvectionBorder::Margin, AdvectionBorder::Margin
+            AdvectionBorder::Margin, AdvectionBorder::Margin, AdvectionBorder::Margin,
+            _pimpl->_workerPool
         };
         PerformAdvection(
             VectorField3D(&velUT1,      &velVT1,        &velWT1,        _pimpl->_dimsWithBorder),
@@ -621,9 +626,10 @@ namespace SceneEngine
 
     UInt3 FluidSolver3D::GetDimensions() const { return _pimpl->_dimsWithoutBorder; }
 
-    FluidSolver3D::FluidSolver3D(UInt3 dimensions)
+    FluidSolver3D::FluidSolver3D(UInt3 dimensions, Utility::CompletionThreadPool* workerPool)
     {
         _pimpl = std::make_unique<Pimpl>();
+        _pimpl->_workerPool = workerPool;
         _pimpl->_dimsWithoutBorder = dimensions;
         _pimpl->_dimsWithBorder = dimensions + UInt3(2, 2, 2);
         auto N = _pimpl->_dimsWithBorder[0] * _pimpl->_dimsWithBorder[1] * _pimpl->_dimsWithBorder[2];
@@ -644,7 +650,7 @@ namespace SceneEngine
         }
 
         UInt3 fullDims(dimensions[0]+2, dimensions[1]+2, dimensions[2]+2);
-        _pimpl->_poissonSolver = PoissonSolver(3, &fullDims[0]);
+        _pimpl->_poissonSolver = PoissonSolver(3, &fullDims[0], workerPool);
         _pimpl->_incompressibility = _pimpl->_poissonSolver.PrepareDivergenceMatrix(
             PoissonSolver::Method::PreconCG, 0u);
 
@@ -10,6 +10,8 @@
 #include "../Math/Vector.h"
 #include <memory>
 
+namespace Utility { class CompletionThreadPool; }
+
 namespace SceneEngine
 {
     class LightingParserContext;
@@ -50,6 +52,9 @@ namespace SceneEngine
         std::unique_ptr<Pimpl> _pimpl;
     };
 
+    /// <summary>2D CPU fluid simulation</summary>
+    /// If a worker pool is given, the advection and the conjugate gradient solvers are
+    /// distributed across it. The result doesn't depend on the number of threads.
     class FluidSolver2D
     {
     public:
@@ -91,7 +96,7 @@ namespace SceneEngine
             LightingParserContext& parserContext,
             FluidDebuggingMode debuggingMode = FluidDebuggingMode::Density);
 
-        FluidSolver2D(UInt2 dimensions);
+        FluidSolver2D(UInt2 dimensions, Utility::CompletionThreadPool* workerPool = nullptr);
         ~FluidSolver2D();
 
     private:
@@ -99,6 +104,8 @@ namespace SceneEngine
         std::unique_ptr<Pimpl> _pimpl;
     };
 
+    /// <summary>3D CPU fluid simulation</summary>
+    /// Uses the worker pool (if given) in the same way as FluidSolver2D.
     class FluidSolver3D
     {
     public:
@@ -134,7 +141,7 @@ namespace SceneEngine
             LightingParserContext& parserContext,
             FluidDebuggingMode debuggingMode = FluidDebuggingMode::Density);
 
-        FluidSolver3D(UInt3 dimensions);
+        FluidSolver3D(UInt3 dimensions, Utility::CompletionThreadPool* workerPool = nullptr);
         ~FluidSolver3D();
     private:
         class Pimpl;
@@ -6,6 +6,8 @@
 
 #include "FluidAdvection.h"
 #include "../Math/RegularNumberField.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include <emmintrin.h>
 
 #pragma warning(disable:4714)
 #pragma push_macro("new")
@@ -42,20 +44,23 @@ namespace SceneEngine
             const Field& velFieldT0, const Field& velFieldT1,
             typename Field::Coord pt, typename Field::FloatCoord velScale)
         {
+                // (note -- the intermediate values must be stored as ValueType, rather than "auto". 
+                // Otherwise they hold cml expression templates that refer to temporaries)
+            using ValueType = typename Field::ValueType;
             const auto s = velScale;
             const auto halfS = decltype(s)(s / 2);
     
             auto startTap = ConvertVector<typename Field::FloatCoord>(pt);
             auto k1 = velFieldT0.Load(pt);
-            auto k2 = .5f * velFieldT0.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k1))
-                    + .5f * velFieldT1.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k1))
-                    ;
-            auto k3 = .5f * velFieldT0.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k2))
-                    + .5f * velFieldT1.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k2))
-                    ;
-            auto k4 = velFieldT1.Sample<SamplingFlags>(startTap + MultiplyAcross(s, k3));
+            ValueType k2 = .5f * velFieldT0.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k1))
+                         + .5f * velFieldT1.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k1))
+                         ;
+            ValueType k3 = .5f * velFieldT0.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k2))
+                         + .5f * velFieldT1.Sample<SamplingFlags>(startTap + MultiplyAcross(halfS, k2))
+                         ;
+            ValueType k4 = velFieldT1.Sample<SamplingFlags>(startTap + MultiplyAcross(s, k3));
     
-            auto finalVel = (1.f / 6.f) * (k1 + 2.f * k2 + 2.f * k3 + k4);
+            ValueType finalVel = (1.f / 6.f) * (k1 + 2.f * k2 + 2.f * k3 + k4);
             return startTap + MultiplyAcross(s, finalVel);
         }
 
@@ -64,20 +69,21 @@ namespace SceneEngine
             const Field& velFieldT0, const Field& velFieldT1,
             typename Field::FloatCoord pt, typename Field::FloatCoord velScale)
         {
+            using ValueType = typename Field::ValueType;
             const auto s = velScale;
             const auto halfS = decltype(s)(s / 2);
 
                 // when using a float point input, we need bilinear interpolation
             auto k1 = velFieldT0.Sample<SamplingFlags>(pt);
-            auto k2 = .5f * velFieldT0.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k1))
-                    + .5f * velFieldT1.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k1))
-                    ;
-            auto k3 = .5f * velFieldT0.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k2))
-                    + .5f * velFieldT1.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k2))
-                    ;
-            auto k4 = velFieldT1.Sample<SamplingFlags>(pt + MultiplyAcross(s, k3));
-
-            auto finalVel = (1.f / 6.f) * (k1 + 2.f * k2 + 2.f * k3 + k4);
+            ValueType k2 = .5f * velFieldT0.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k1))
+                         + .5f * velFieldT1.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k1))
+                         ;
+            ValueType k3 = .5f * velFieldT0.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k2))
+                         + .5f * velFieldT1.Sample<SamplingFlags>(pt + MultiplyAcross(halfS, k2))
+                         ;
+            ValueType k4 = velFieldT1.Sample<SamplingFlags>(pt + MultiplyAcross(s, k3));
+
+            ValueType finalVel = (1.f / 6.f) * (k1 + 2.f * k2 + 2.f * k3 + k4);
             return pt + MultiplyAcross(s, finalVel);
         }
 
@@ -146,6 +152,336 @@ namespace SceneEngine
             }
         }
     
+///////////////////////////////////////////////////////////////////////////////////////////////////
+            //   P E R   C E L L
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    template<unsigned SamplingFlags, typename Field, typename VelField>
+        static void AdvectCell_RK4(
+            Field& dstValues, const Field& srcValues, 
+            const VelField& velFieldT0, const VelField& velFieldT1,
+            typename VelField::Coord coord, float deltaTime, typename VelField::FloatCoord velFieldScale)
+    {
+            // This is the RK4 version
+            // We'll use the average of the velocity field at t and
+            // the velocity field at t+dt as an estimate of the field
+            // at t+.5*dt
+
+            // Note that we're tracing the velocity field backwards.
+            // So doing k1 on velField1, and k4 on velFieldT0
+            //      -- hoping this will interact with the velocity diffusion more sensibly
+        const auto tap = AdvectRK4<SamplingFlags>(velFieldT1, velFieldT0, coord, -deltaTime * velFieldScale);
+        dstValues.Write(coord, srcValues.Sample<SamplingFlags>(tap));
+    }
+
+    template<unsigned SamplingFlags, typename Field>
+        static typename Field::ValueType MacCormackCorrection(
+            const Field& srcValues, typename Field::FloatCoord predictor,
+            typename Field::ValueType originalValue, typename Field::ValueType reversedValue)
+    {
+            // Here we clamp the final result within the range of the neighbour cells of the 
+            // original predictor. This prevents the scheme from becoming unstable (by avoiding
+            // irrational values for 0.5f * (originalValue - reversedValue)
+        typename Field::ValueType finalValue;
+        const bool doRangeClamping = true;
+        if (constant_expression<doRangeClamping>::result()) {
+            typename Field::ValueType minNeighbour, maxNeighbour;
+            auto predictorValue = LoadWithNearbyRange<SamplingFlags>(minNeighbour, maxNeighbour, srcValues, predictor);
+            finalValue = typename Field::ValueType(predictorValue + .5f * (originalValue - reversedValue));
+            finalValue = MaxAcross(finalValue, minNeighbour);
+            finalValue = MinAcross(finalValue, maxNeighbour);
+        } else {
+            auto predictorValue = srcValues.Sample<SamplingFlags>(predictor);
+            finalValue = typename Field::ValueType(predictorValue + .5f * (originalValue - reversedValue));
+        }
+        return finalValue;
+    }
+
+    template<unsigned SamplingFlags, typename Field, typename VelField>
+        static void AdvectCell_MacCormack(
+            Field& dstValues, const Field& srcValues, 
+            const VelField& velFieldT0, const VelField& velFieldT1,
+            typename VelField::Coord coord, float deltaTime, typename VelField::FloatCoord velFieldScale)
+    {
+            // advect backwards in time first, to find the predictor
+        const auto predictor = AdvectRK4<SamplingFlags>(velFieldT1, velFieldT0, coord, -deltaTime * velFieldScale);
+            // advect forward again to find the error tap
+        const auto reversedTap = AdvectRK4<SamplingFlags>(velFieldT0, velFieldT1, predictor, deltaTime * velFieldScale);
+
+        auto originalValue = srcValues.Load(coord);
+        auto reversedValue = srcValues.Sample<SamplingFlags>(reversedTap);
+        dstValues.Write(coord, MacCormackCorrection<SamplingFlags>(srcValues, predictor, originalValue, reversedValue));
+    }
+
+    template<unsigned SamplingFlags, typename Field, typename VelField, typename FloatCoord>
+        static void AdvectRow_RK4(
+            Field& dstValues, const Field& srcValues, 
+            const VelField& velFieldT0, const VelField& velFieldT1,
+            unsigned xBegin, unsigned xEnd, unsigned y, unsigned z,
+            float deltaTime, FloatCoord velFieldScale)
+    {
+        for (unsigned x=xBegin; x<xEnd; ++x)
+            AdvectCell_RK4<SamplingFlags>(
+                dstValues, srcValues, velFieldT0, velFieldT1, 
+                ConvertVector<typename VelField::Coord>(UInt3(x, y, z)), deltaTime, velFieldScale);
+    }
+
+    template<unsigned SamplingFlags, typename Field, typename VelField, typename FloatCoord>
+        static void AdvectRow_MacCormack(
+            Field& dstValues, const Field& srcValues, 
+            const VelField& velFieldT0, const VelField& velFieldT1,
+            unsigned xBegin, unsigned xEnd, unsigned y, unsigned z,
+            float deltaTime, FloatCoord velFieldScale)
+    {
+        for (unsigned x=xBegin; x<xEnd; ++x)
+            AdvectCell_MacCormack<SamplingFlags>(
+                dstValues, srcValues, velFieldT0, velFieldT1, 
+                ConvertVector<typename VelField::Coord>(UInt3(x, y, z)), deltaTime, velFieldScale);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+            //   4   C E L L S   A T   A   T I M E   ( 2 D ,   B I L I N E A R )
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+        //  The 2D bilinear RK4 methods are the most common case. Here, we advect 4 adjacent
+        //  cells in a row at once with SSE. The taps for each cell point in different directions,
+        //  so values are still loaded from the fields one at a time. But the weights, the RK4
+        //  steps and the interpolation are done for all 4 cells together. The order of operations
+        //  is the same as the scalar code, so the results should be identical.
+
+    static __m128 Floor4(__m128 x)
+    {
+            // (valid within the range of 32 bit ints, which is fine for grid coordinates)
+        __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+    }
+
+    template<unsigned SamplingFlags>
+        class BilinearTaps4
+    {
+    public:
+        __m128 _weights[4];
+        unsigned _indices[4][4];    // [corner][cell]
+
+        __m128 Gather(const float values[]) const
+        {
+            __m128 result = _mm_mul_ps(_weights[0], Load(values, 0));
+            result = _mm_add_ps(result, _mm_mul_ps(_weights[1], Load(values, 1)));
+            result = _mm_add_ps(result, _mm_mul_ps(_weights[2], Load(values, 2)));
+            result = _mm_add_ps(result, _mm_mul_ps(_weights[3], Load(values, 3)));
+            return result;
+        }
+
+        BilinearTaps4(__m128 x, __m128 y, UInt2 dims);
+
+    private:
+        __m128 Load(const float values[], unsigned corner) const
+        {
+            const auto* i = _indices[corner];
+            return _mm_setr_ps(values[i[0]], values[i[1]], values[i[2]], values[i[3]]);
+        }
+    };
+
+    template<unsigned SamplingFlags>
+        BilinearTaps4<SamplingFlags>::BilinearTaps4(__m128 x, __m128 y, UInt2 dims)
+    {
+            // weights and edge rules must match SampleBilinear() in RegularNumberField.cpp
+        const __m128 fx = Floor4(x), fy = Floor4(y);
+        const __m128 a = _mm_sub_ps(x, fx), b = _mm_sub_ps(y, fy);
+        const __m128 oneMinusA = _mm_sub_ps(_mm_set1_ps(1.f), a);
+        const __m128 oneMinusB = _mm_sub_ps(_mm_set1_ps(1.f), b);
+        _weights[0] = _mm_mul_ps(oneMinusA, oneMinusB);
+        _weights[1] = _mm_mul_ps(a, oneMinusB);
+        _weights[2] = _mm_mul_ps(oneMinusA, b);
+        _weights[3] = _mm_mul_ps(a, b);
+
+        float fxs[4], fys[4];
+        _mm_storeu_ps(fxs, fx);
+        _mm_storeu_ps(fys, fy);
+        for (unsigned c=0; c<4; ++c) {
+            unsigned x0, x1, y0, y1;
+            if (constant_expression<(SamplingFlags & RNFSample::WrapX)!=0>::result()) {
+                x0 = unsigned((int(fxs[c]) + int(dims[0]))%dims[0]);
+                x1 = (x0+1u)%dims[0];
+            } else if (constant_expression<(SamplingFlags & RNFSample::ClampX)!=0>::result()) {
+                x0 = unsigned(Clamp(fxs[c], 0.f, float(dims[0]-1)));
+                x1 = std::min(x0+1u, dims[0]-1u);
+            } else {
+                x0 = unsigned(fxs[c]); x1 = x0+1;
+            }
+
+            if (constant_expression<(SamplingFlags & RNFSample::WrapY)!=0>::result()) {
+                y0 = unsigned((int(fys[c]) + int(dims[1]))%dims[1]);
+                y1 = (y0+1u)%dims[1];
+            } else if (constant_expression<(SamplingFlags & RNFSample::ClampY)!=0>::result()) {
+                y0 = unsigned(Clamp(fys[c], 0.f, float(dims[1]-1)));
+                y1 = std::min(y0+1u, dims[1]-1u);
+            } else {
+                y0 = unsigned(fys[c]); y1 = y0+1;
+            }
+            assert(x1 < dims[0] && y1 < dims[1]);
+
+            _indices[0][c] = y0*dims[0]+x0;
+            _indices[1][c] = y0*dims[0]+x1;
+            _indices[2][c] = y1*dims[0]+x0;
+            _indices[3][c] = y1*dims[0]+x1;
+        }
+    }
+
+    template<unsigned SamplingFlags>
+        static void Sample4(float result[4], const ScalarField2D& field, const BilinearTaps4<SamplingFlags>& taps)
+    {
+        _mm_storeu_ps(result, taps.Gather(field._u->data()));
+    }
+
+    template<unsigned SamplingFlags>
+        static void Sample4(Float2 result[4], const VectorField2D& field, const BilinearTaps4<SamplingFlags>& taps)
+    {
+        float u[4], v[4];
+        _mm_storeu_ps(u, taps.Gather(field._u->data()));
+        _mm_storeu_ps(v, taps.Gather(field._v->data()));
+        for (unsigned c=0; c<4; ++c) result[c] = Float2(u[c], v[c]);
+    }
+
+    template<unsigned SamplingFlags>
+        static void AdvectRK4_4(
+            __m128& x, __m128& y, __m128 k1u, __m128 k1v,
+            const VectorField2D& velFieldA, const VectorField2D& velFieldB, Float2 velScale)
+    {
+            //  Same as AdvectRK4(), but for 4 points at once. "x" and "y" are the starting
+            //  points on input, and the advected points on output.
+        const auto dims = velFieldA.Dimensions();
+        const float* au = velFieldA._u->data(), *av = velFieldA._v->data();
+        const float* bu = velFieldB._u->data(), *bv = velFieldB._v->data();
+        const __m128 sx = _mm_set1_ps(velScale[0]), sy = _mm_set1_ps(velScale[1]);
+        const __m128 halfSx = _mm_set1_ps(velScale[0] / 2), halfSy = _mm_set1_ps(velScale[1] / 2);
+        const __m128 half = _mm_set1_ps(.5f);
+
+        BilinearTaps4<SamplingFlags> taps2(_mm_add_ps(x, _mm_mul_ps(halfSx, k1u)), _mm_add_ps(y, _mm_mul_ps(halfSy, k1v)), dims);
+        const __m128 k2u = _mm_add_ps(_mm_mul_ps(half, taps2.Gather(au)), _mm_mul_ps(half, taps2.Gather(bu)));
+        const __m128 k2v = _mm_add_ps(_mm_mul_ps(half, taps2.Gather(av)), _mm_mul_ps(half, taps2.Gather(bv)));
+
+        BilinearTaps4<SamplingFlags> taps3(_mm_add_ps(x, _mm_mul_ps(halfSx, k2u)), _mm_add_ps(y, _mm_mul_ps(halfSy, k2v)), dims);
+        const __m128 k3u = _mm_add_ps(_mm_mul_ps(half, taps3.Gather(au)), _mm_mul_ps(half, taps3.Gather(bu)));
+        const __m128 k3v = _mm_add_ps(_mm_mul_ps(half, taps3.Gather(av)), _mm_mul_ps(half, taps3.Gather(bv)));
+
+        BilinearTaps4<SamplingFlags> taps4(_mm_add_ps(x, _mm_mul_ps(sx, k3u)), _mm_add_ps(y, _mm_mul_ps(sy, k3v)), dims);
+        const __m128 k4u = taps4.Gather(bu), k4v = taps4.Gather(bv);
+
+        const __m128 two = _mm_set1_ps(2.f), sixth = _mm_set1_ps(1.f / 6.f);
+        const __m128 finalU = _mm_mul_ps(sixth, _mm_add_ps(_mm_add_ps(_mm_add_ps(k1u, _mm_mul_ps(two, k2u)), _mm_mul_ps(two, k3u)), k4u));
+        const __m128 finalV = _mm_mul_ps(sixth, _mm_add_ps(_mm_add_ps(_mm_add_ps(k1v, _mm_mul_ps(two, k2v)), _mm_mul_ps(two, k3v)), k4v));
+        x = _mm_add_ps(x, _mm_mul_ps(sx, finalU));
+        y = _mm_add_ps(y, _mm_mul_ps(sy, finalV));
+    }
+
+    template<unsigned SamplingFlags, typename Field>
+        static void AdvectRow_RK4(
+            Field& dstValues, const Field& srcValues, 
+            const VectorField2D& velFieldT0, const VectorField2D& velFieldT1,
+            unsigned xBegin, unsigned xEnd, unsigned y, unsigned z,
+            float deltaTime, Float2 velFieldScale)
+    {
+        unsigned x = xBegin;
+        if (constant_expression<(SamplingFlags & RNFSample::Cubic)==0>::result()) {
+            const auto dims = velFieldT1.Dimensions();
+            const Float2 backwardScale = -deltaTime * velFieldScale;
+            for (; (x+4)<=xEnd; x+=4) {
+                __m128 tapX = _mm_cvtepi32_ps(_mm_setr_epi32(x, x+1, x+2, x+3));
+                __m128 tapY = _mm_set1_ps(float(y));
+                    // (k1 comes straight from the grid)
+                const auto k1u = _mm_loadu_ps(&(*velFieldT1._u)[y*dims[0]+x]);
+                const auto k1v = _mm_loadu_ps(&(*velFieldT1._v)[y*dims[0]+x]);
+                AdvectRK4_4<SamplingFlags>(tapX, tapY, k1u, k1v, velFieldT1, velFieldT0, backwardScale);
+
+                typename Field::ValueType values[4];
+                Sample4(values, srcValues, BilinearTaps4<SamplingFlags>(tapX, tapY, dims));
+                for (unsigned c=0; c<4; ++c)
+                    dstValues.Write(UInt2(x+c, y), values[c]);
+            }
+        }
+
+        for (; x<xEnd; ++x)
+            AdvectCell_RK4<SamplingFlags>(dstValues, srcValues, velFieldT0, velFieldT1, UInt2(x, y), deltaTime, velFieldScale);
+    }
+
+    template<unsigned SamplingFlags, typename Field>
+        static void AdvectRow_MacCormack(
+            Field& dstValues, const Field& srcValues, 
+            const VectorField2D& velFieldT0, const VectorField2D& velFieldT1,
+            unsigned xBegin, unsigned xEnd, unsigned y, unsigned z,
+            float deltaTime, Float2 velFieldScale)
+    {
+        unsigned x = xBegin;
+        if (constant_expression<(SamplingFlags & RNFSample::Cubic)==0>::result()) {
+            const auto dims = velFieldT1.Dimensions();
+            const Float2 backwardScale = -deltaTime * velFieldScale;
+            const Float2 forwardScale = deltaTime * velFieldScale;
+            for (; (x+4)<=xEnd; x+=4) {
+                __m128 predictorX = _mm_cvtepi32_ps(_mm_setr_epi32(x, x+1, x+2, x+3));
+                __m128 predictorY = _mm_set1_ps(float(y));
+                const auto k1u = _mm_loadu_ps(&(*velFieldT1._u)[y*dims[0]+x]);
+                const auto k1v = _mm_loadu_ps(&(*velFieldT1._v)[y*dims[0]+x]);
+                AdvectRK4_4<SamplingFlags>(predictorX, predictorY, k1u, k1v, velFieldT1, velFieldT0, backwardScale);
+
+                    // starting from a point between cells, so k1 must be interpolated
+                BilinearTaps4<SamplingFlags> predictorTaps(predictorX, predictorY, dims);
+                __m128 reversedX = predictorX, reversedY = predictorY;
+                AdvectRK4_4<SamplingFlags>(
+                    reversedX, reversedY, 
+                    predictorTaps.Gather(velFieldT0._u->data()), predictorTaps.Gather(velFieldT0._v->data()), 
+                    velFieldT0, velFieldT1, forwardScale);
+
+                typename Field::ValueType reversedValues[4];
+                Sample4(reversedValues, srcValues, BilinearTaps4<SamplingFlags>(reversedX, reversedY, dims));
+
+                float px[4], py[4];
+                _mm_storeu_ps(px, predictorX);
+                _mm_storeu_ps(py, predictorY);
+                for (unsigned c=0; c<4; ++c) {
+                    UInt2 coord(x+c, y);
+                    dstValues.Write(
+                        coord, 
+                        MacCormackCorrection<SamplingFlags>(srcValues, Float2(px[c], py[c]), srcValues.Load(coord), reversedValues[c]));
+                }
+            }
+        }
+
+        for (; x<xEnd; ++x)
+            AdvectCell_MacCormack<SamplingFlags>(dstValues, srcValues, velFieldT0, velFieldT1, UInt2(x, y), deltaTime, velFieldScale);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    template<typename Fn>
+        static void ForEachRow(UInt3 dims, UInt3 margin, CompletionThreadPool* workerPool, Fn&& fn)
+    {
+            //  Each cell is written independently of the others (and the destination is never 
+            //  one of the source fields). So we can split the grid into slabs of rows, and 
+            //  distribute the slabs across the worker pool.
+        const unsigned height = dims[1]-2*margin[1], depth = dims[2]-2*margin[2];
+        const unsigned rowCount = height*depth;
+        const unsigned rowsPerTask = std::max(1u, 2048u / dims[0]);
+        const unsigned taskCount = (rowCount + rowsPerTask - 1) / rowsPerTask;
+        auto rows = [&](unsigned rowBegin, unsigned rowEnd)
+            {
+                for (unsigned r=rowBegin; r<rowEnd; ++r)
+                    fn(margin[1] + r%height, margin[2] + r/height);
+            };
+
+        if (!workerPool || taskCount <= 1) {
+            rows(0, rowCount);
+            return;
+        }
+
+        auto task = [&](unsigned taskIndex)
+            {
+                rows(taskIndex*rowsPerTask, std::min((taskIndex+1)*rowsPerTask, rowCount));
+            };
+        if (!ParallelFor(*workerPool, taskCount, task))
+            Throw(::Exceptions::BasicLabel("Failure in worker thread during fluid advection"));
+    }
+    
     template<unsigned WrappingFlags, typename Field, typename VelField>
         static void PerformAdvection_Internal(
             Field dstValues, Field srcValues, 
@@ -198,6 +534,7 @@ namespace SceneEngine
                 float(dims[1]-2*margin[1]),
                 float(dims[2]-2*margin[2])));   // (grid size without borders)
         const auto clampMax = ConvertVector<FloatCoord>(dims);
+        const unsigned xBegin = margin[0], xEnd = dims[0]-margin[0];
 
         if (advectionMethod == AdvectionMethod::ForwardEuler) {
 
@@ -205,22 +542,25 @@ namespace SceneEngine
                 //  through the velocity field to find an approximation
                 //  of where the point was in the previous frame.
 
-            for (unsigned z=margin[2]; z<dims[2]-margin[2]; ++z)
-                for (unsigned y=margin[1]; y<dims[1]-margin[1]; ++y)
-                    for (unsigned x=margin[0]; x<dims[0]-margin[0]; ++x) {
+            ForEachRow(dims, margin, settings._workerPool,
+                [&](unsigned y, unsigned z)
+                {
+                    for (unsigned x=xBegin; x<xEnd; ++x) {
                         auto coord = ConvertVector<Coord>(UInt3(x, y, z));
                         auto startVel = velFieldT1.Load(coord);
                         FloatCoord tap = ConvertVector<FloatCoord>(coord) - MultiplyAcross(deltaTime * velFieldScale, startVel);
                         tap = ApplyBoundary<WrappingFlags>(tap, clampMax);
-                        dstValues.Write(coord, srcValues.Sample<0>(tap));
+                        dstValues.Write(coord, srcValues.Sample<WrappingFlags>(tap));
                     }
+                });
 
         } else if (advectionMethod == AdvectionMethod::ForwardEulerDiv) {
 
             auto stepScale = decltype(velFieldScale)(deltaTime * velFieldScale / float(adjvectionSteps));
-            for (unsigned z=margin[2]; z<dims[2]-margin[2]; ++z)
-                for (unsigned y=margin[1]; y<dims[1]-margin[1]; ++y)
-                    for (unsigned x=margin[0]; x<dims[0]-margin[0]; ++x) {
+            ForEachRow(dims, margin, settings._workerPool,
+                [&](unsigned y, unsigned z)
+                {
+                    for (unsigned x=xBegin; x<xEnd; ++x) {
 
                         auto coord = ConvertVector<Coord>(UInt3(x, y, z));
                         auto tap = ConvertVector<FloatCoord>(UInt3(x, y, z));
@@ -231,48 +571,33 @@ namespace SceneEngine
                             if (s>=adjvectionSteps) break;
 
                             vel = LinearInterpolate(
-                                velFieldT0.Sample<0>(tap),
-                                velFieldT1.Sample<0>(tap),
+                                velFieldT0.Sample<WrappingFlags>(tap),
+                                velFieldT1.Sample<WrappingFlags>(tap),
                                 s / float(adjvectionSteps-1));
                         }
 
                         dstValues.Write(coord, srcValues.Sample<WrappingFlags>(tap));
                     }
+                });
 
         } else if (advectionMethod == AdvectionMethod::RungeKutta) {
 
             if (settings._interpolation == AdvectionInterp::Bilinear) {
-
-                const auto SamplingFlags = WrappingFlags;
-                for (unsigned z=margin[2]; z<dims[2]-margin[2]; ++z)
-                    for (unsigned y=margin[1]; y<dims[1]-margin[1]; ++y)
-                        for (unsigned x=margin[0]; x<dims[0]-margin[0]; ++x) {
-
-                                // This is the RK4 version
-                                // We'll use the average of the velocity field at t and
-                                // the velocity field at t+dt as an estimate of the field
-                                // at t+.5*dt
-
-                                // Note that we're tracing the velocity field backwards.
-                                // So doing k1 on velField1, and k4 on velFieldT0
-                                //      -- hoping this will interact with the velocity diffusion more sensibly
-                            auto coord = ConvertVector<Coord>(UInt3(x, y, z));
-                            const auto tap = AdvectRK4<SamplingFlags>(velFieldT1, velFieldT0, coord, -deltaTime * velFieldScale);
-                            dstValues.Write(coord, srcValues.Sample<SamplingFlags>(tap));
-
-                        }
-
+                ForEachRow(dims, margin, settings._workerPool,
+                    [&](unsigned y, unsigned z)
+                    {
+                        AdvectRow_RK4<WrappingFlags>(
+                            dstValues, srcValues, velFieldT0, velFieldT1,
+                            xBegin, xEnd, y, z, deltaTime, velFieldScale);
+                    });
             } else {
-
-                const auto SamplingFlags = RNFSample::Cubic|WrappingFlags;
-                for (unsigned z=margin[2]; z<dims[2]-margin[2]; ++z)
-                    for (unsigned y=margin[1]; y<dims[1]-margin[1]; ++y)
-                        for (unsigned x=margin[0]; x<dims[0]-margin[0]; ++x) {
-                            auto coord = ConvertVector<Coord>(UInt3(x, y, z));
-                            const auto tap = AdvectRK4<SamplingFlags>(velFieldT1, velFieldT0, coord, -deltaTime * velFieldScale);
-                            dstValues.Write(coord, srcValues.Sample<SamplingFlags>(tap));
-                        }
-
+                ForEachRow(dims, margin, settings._workerPool,
+                    [&](unsigned y, unsigned z)
+                    {
+                        AdvectRow_RK4<RNFSample::Cubic|WrappingFlags>(
+                            dstValues, srcValues, velFieldT0, velFieldT1,
+                            xBegin, xEnd, y, z, deltaTime, velFieldScale);
+                    });
             }
 
         } else if (advectionMethod == AdvectionMethod::MacCormackRK4) {
@@ -303,66 +628,21 @@ namespace SceneEngine
                 //
 
             if (settings._interpolation == AdvectionInterp::Bilinear) {
-
-                const auto SamplingFlags = WrappingFlags;
-                for (unsigned z=margin[2]; z<dims[2]-margin[2]; ++z)
-                    for (unsigned y=margin[1]; y<dims[1]-margin[1]; ++y)
-                        for (unsigned x=margin[0]; x<dims[0]-margin[0]; ++x) {
-
-                            auto coord = ConvertVector<Coord>(UInt3(x, y, z));
-
-                                // advect backwards in time first, to find the predictor
-                            const auto predictor = AdvectRK4<SamplingFlags>(velFieldT1, velFieldT0, coord, -deltaTime * velFieldScale);
-                                // advect forward again to find the error tap
-                            const auto reversedTap = AdvectRK4<SamplingFlags>(velFieldT0, velFieldT1, predictor, deltaTime * velFieldScale);
-
-                            auto originalValue = srcValues.Load(coord);
-                            auto reversedValue = srcValues.Sample<SamplingFlags>(reversedTap);
-                            Field::ValueType finalValue;
-
-                                // Here we clamp the final result within the range of the neighbour cells of the 
-                                // original predictor. This prevents the scheme from becoming unstable (by avoiding
-                                // irrational values for 0.5f * (originalValue - reversedValue)
-                            const bool doRangeClamping = true;
-                            if (constant_expression<doRangeClamping>::result()) {
-                                typename Field::ValueType minNeighbour, maxNeighbour;
-                                auto predictorValue = LoadWithNearbyRange<SamplingFlags>(minNeighbour, maxNeighbour, srcValues, predictor);
-                                finalValue = typename Field::ValueType(predictorValue + .5f * (originalValue - reversedValue));
-                                finalValue = MaxAcross(finalValue, minNeighbour);
-                                finalValue = MinAcross(finalValue, maxNeighbour);
-                            } else {
-                                auto predictorValue = srcValues.Sample<SamplingFlags>(predictor);
-                                finalValue = typename Field::ValueType(predictorValue + .5f * (originalValue - reversedValue));
-                            }
-
-                            dstValues.Write(coord, finalValue);
-
-                        }   
-
+                ForEachRow(dims, margin, settings._workerPool,
+                    [&](unsigned y, unsigned z)
+                    {
+                        AdvectRow_MacCormack<WrappingFlags>(
+                            dstValues, srcValues, velFieldT0, velFieldT1,
+                            xBegin, xEnd, y, z, deltaTime, velFieldScale);
+                    });
             } else {
-
-                const auto SamplingFlags = RNFSample::Cubic|WrappingFlags;
-                for (unsigned z=margin[2]; z<dims[2]-margin[2]; ++z)
-                    for (unsigned y=margin[1]; y<dims[1]-margin[1]; ++y)
-                        for (unsigned x=margin[0]; x<dims[0]-margin[0]; ++x) {
-
-                            auto coord = ConvertVector<Coord>(UInt3(x, y, z));
-                            const auto predictor = AdvectRK4<SamplingFlags>(velFieldT1, velFieldT0, coord, -deltaTime * velFieldScale);
-                            const auto reversedTap = AdvectRK4<SamplingFlags>(velFieldT0, velFieldT1, predictor, deltaTime * velFieldScale);
-
-                            auto originalValue = srcValues.Load(coord);
-                            auto reversedValue = srcValues.Sample<SamplingFlags>(reversedTap);
-
-                            Field::ValueType minNeighbour, maxNeighbour;
-                            auto predictorValue = LoadWithNearbyRange<SamplingFlags>(minNeighbour, maxNeighbour, srcValues, predictor);
-                            auto finalValue = Field::ValueType(predictorValue + .5f * (originalValue - reversedValue));
-                            finalValue = MaxAcross(finalValue, minNeighbour);
-                            finalValue = MinAcross(finalValue, maxNeighbour);
-
-                            dstValues.Write(coord, finalValue);
-
-                        }
-
+                ForEachRow(dims, margin, settings._workerPool,
+                    [&](unsigned y, unsigned z)
+                    {
+                        AdvectRow_MacCormack<RNFSample::Cubic|WrappingFlags>(
+                            dstValues, srcValues, velFieldT0, velFieldT1,
+                            xBegin, xEnd, y, z, deltaTime, velFieldScale);
+                    });
             }
 
         }
@@ -432,13 +712,15 @@ namespace SceneEngine
         _borderX = AdvectionBorder::Margin; 
         _borderY = AdvectionBorder::Margin; 
         _borderZ = AdvectionBorder::Margin;
+        _workerPool = nullptr;
     }
 
     AdvectionSettings::AdvectionSettings(
         AdvectionMethod method,
         AdvectionInterp interpolation,
         unsigned        subSteps,
-        AdvectionBorder borderX, AdvectionBorder borderY, AdvectionBorder borderZ)
+        AdvectionBorder borderX, AdvectionBorder borderY, AdvectionBorder borderZ,
+        CompletionThreadPool* workerPool)
     {
         _method = method;
         _interpolation = interpolation;
@@ -446,6 +728,7 @@ namespace SceneEngine
         _borderX = borderX;
         _borderY = borderY;
         _borderZ = borderZ;
+        _workerPool = workerPool;
     }
 
     template void PerformAdvection(
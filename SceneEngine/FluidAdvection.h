@@ -6,6 +6,8 @@
 
 #pragma once
 
+namespace Utility { class CompletionThreadPool; }
+
 namespace SceneEngine
 {
     enum class AdvectionMethod { ForwardEuler, ForwardEulerDiv, RungeKutta, MacCormackRK4 };
@@ -20,12 +22,17 @@ namespace SceneEngine
         unsigned        _subSteps;
         AdvectionBorder _borderX, _borderY, _borderZ;
 
+            // When a worker pool is given, slabs of rows are advected on the pool's
+            // threads. The result is identical to the single threaded result.
+        Utility::CompletionThreadPool* _workerPool;
+
         AdvectionSettings();
         AdvectionSettings(
             AdvectionMethod method,
             AdvectionInterp interpolation,
             unsigned        subSteps,
-            AdvectionBorder borderX, AdvectionBorder borderY, AdvectionBorder borderZ);
+            AdvectionBorder borderX, AdvectionBorder borderY, AdvectionBorder borderZ,
+            Utility::CompletionThreadPool* workerPool = nullptr);
     };
 
     template<typename Field, typename VelField>
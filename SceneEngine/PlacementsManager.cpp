@@ -18,6 +18,7 @@
 #include "../RenderCore/Assets/ModelCache.h"
 
 #include "../RenderCore/Techniques/ParsingContext.h"
+#include "../RenderCore/Techniques/CommonBindings.h"
 
 #include "../Assets/Assets.h"
 #include "../Assets/ChunkFile.h"
@@ -43,6 +44,8 @@
 #include "../Utility/Streams/StreamDOM.h"
 #include "../Utility/Conversion.h"
 #include "../Core/Types.h"
+#include "../Core/SelectConfiguration.h"
+#include "../Foreign/Hash/MurmurHash2.h"
 
 #include <random>
 
@@ -114,6 +117,24 @@ namespace SceneEngine
 
     static const uint64 ChunkType_Placements = ConstHash64<'Plac','emen','ts'>::Value;
 
+        //  Placements files store hash values (in the string table and in the top part
+        //  of object ids). Placements are source data, so they can't be rebuilt when
+        //  Hash64 changes (see Hash64Version). Instead we use a fixed algorithm here:
+        //  MurmurHash2, which is what Hash64 used when the existing files were written.
+    static uint64 PlacementsHash64(const void* begin, const void* end, uint64 seed = DefaultSeed64)
+    {
+        #if TARGET_64BIT
+            return MurmurHash64A(begin, int(size_t(end)-size_t(begin)), seed);
+        #else
+            return MurmurHash64B(begin, int(size_t(end)-size_t(begin)), seed);
+        #endif
+    }
+
+    static uint64 PlacementsHash64(StringSection<ResChar> str, uint64 seed = DefaultSeed64)
+    {
+        return PlacementsHash64(str.begin(), str.end(), seed);
+    }
+
     class PlacementsHeader
     {
     public:
@@ -188,8 +209,8 @@ namespace SceneEngine
         unsigned replacementStart = 0, preReplacementEnd = 0;
         unsigned postReplacementEnd = 0;
 
-        uint64 oldHash = Hash64(oldString);
-        uint64 newHash = Hash64(newString);
+        uint64 oldHash = PlacementsHash64(MakeStringSection(oldString));
+        uint64 newHash = PlacementsHash64(MakeStringSection(newString));
 
             //  first, look through and find the old string.
             //  then, 
@@ -408,7 +429,7 @@ namespace SceneEngine
     class PlacementsRenderer::Pimpl
     {
     public:
-        void BeginPrepare();
+        void BeginPrepare(unsigned techniqueIndex);
         void EndPrepare();
         void ClearPrepared();
         void CommitPrepared(
@@ -477,6 +498,7 @@ namespace SceneEngine
         std::shared_ptr<PlacementsCache> _placementsCache;
         std::shared_ptr<ModelCache> _cache;
         DelayedDrawCallSet _preparedRenders;
+        bool _clusterBackfaceCulling;
 
         std::shared_ptr<RenderCore::Assets::IModelFormat> _modelFormat;
         std::shared_ptr<DynamicImposters> _imposters;
@@ -511,9 +533,20 @@ namespace SceneEngine
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-    void PlacementsRenderer::Pimpl::BeginPrepare()
+    void PlacementsRenderer::Pimpl::BeginPrepare(unsigned techniqueIndex)
     {
         _preparedRenders.Reset();
+
+            //  The cluster normal cones are tested against the camera position in
+            //  _cameraToWorld. That's only correct for the techniques that render from
+            //  the main camera with back face culling. Shadow gen (and the ray traced
+            //  shadow triangle writes) substitute another projection, and ray tests and
+            //  vegetation spawn must see every triangle. So only use it for this short list.
+        using namespace RenderCore::Techniques;
+        _clusterBackfaceCulling = 
+                techniqueIndex == TechniqueIndex::Forward
+            ||  techniqueIndex == TechniqueIndex::Deferred
+            ||  techniqueIndex == TechniqueIndex::DepthOnly;
         if (_imposters)
             _imposters->Reset();
     }
@@ -660,7 +693,7 @@ namespace SceneEngine
 
             Metrics _metrics;
 
-            RendererHelper(DynamicImposters* imposters)
+            RendererHelper(DynamicImposters* imposters, RenderCore::Assets::ClusterCulling* clusterCulling)
             {
                 _currentModel = _currentMaterial = 0ull;
                 _currentSupplements = 0u;
@@ -671,6 +704,7 @@ namespace SceneEngine
                 _maxDistanceSq = maxDistance * maxDistance;
 
                 _imposters = imposters;
+                _clusterCulling = clusterCulling;
                 _currentModelRendered = false;
             }
         protected:
@@ -680,6 +714,7 @@ namespace SceneEngine
             float _maxDistanceSq;
             bool _currentModelRendered;
             DynamicImposters* _imposters;
+            RenderCore::Assets::ClusterCulling* _clusterCulling;
         };
 
         template<bool UseImposters>
@@ -757,7 +792,8 @@ namespace SceneEngine
                 delayedDrawCalls, 
                 cache.GetSharedStateSet(), 
                 AsFloat4x4(localToWorld), 
-                RenderCore::Assets::MeshToModel(*_current._model));
+                RenderCore::Assets::MeshToModel(*_current._model),
+                _clusterCulling);
 
             ++_metrics._instancesPrepared;
             _metrics._uniqueModelsPrepared += !_currentModelRendered;
@@ -851,7 +887,14 @@ namespace SceneEngine
 
         const uint64* filterIterator = filterStart;
         const bool doFilter = filterStart != filterEnd;
-        Internal::RendererHelper helper(_imposters.get());
+
+            //  Large models can be split into clusters of triangles, which are culled individually
+        const auto& projDesc = parserContext.GetProjectionDesc();
+        RenderCore::Assets::ClusterCulling clusterCulling(
+            projDesc._worldToProjection, ExtractTranslation(projDesc._cameraToWorld),
+            _clusterBackfaceCulling);
+        const bool doClusterCulling = Tweakable("ClusterCulling", true);
+        Internal::RendererHelper helper(_imposters.get(), doClusterCulling ? &clusterCulling : nullptr);
 
         auto cameraPositionCell = ExtractTranslation(parserContext.GetProjectionDesc()._cameraToWorld);
         cameraPositionCell = TransformPointByOrthonormalInverse(cellToWorld, cameraPositionCell);
@@ -900,6 +943,8 @@ namespace SceneEngine
         } /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
         QuickMetrics(parserContext) << "Placements cell: (" << helper._metrics._instancesPrepared << ") instances from (" << helper._metrics._uniqueModelsPrepared << ") models. Imposters: (" << helper._metrics._impostersQueued << ")\n";
+        if (clusterCulling._clustersTested)
+            QuickMetrics(parserContext) << "Placements clusters: (" << clusterCulling._clustersVisible << ") visible of (" << clusterCulling._clustersTested << ")\n";
     }
 
     PlacementsRenderer::Pimpl::Pimpl(
@@ -908,6 +953,7 @@ namespace SceneEngine
     : _placementsCache(std::move(placementsCache))
     , _cache(std::move(modelCache))
     , _preparedRenders(typeid(ModelRenderer).hash_code())
+    , _clusterBackfaceCulling(true)
     {}
 
     PlacementsRenderer::Pimpl::~Pimpl() {}
@@ -954,7 +1000,7 @@ namespace SceneEngine
             return;
         }
 
-        _pimpl->BeginPrepare();
+        _pimpl->BeginPrepare(techniqueIndex);
 
         static std::vector<unsigned> visibleObjects;
 
@@ -1009,7 +1055,7 @@ namespace SceneEngine
             return;
         }
 
-        _pimpl->BeginPrepare();
+        _pimpl->BeginPrepare(techniqueIndex);
 
         auto* prepared = preparedScene.Get<PreCulledPlacements>((PreparedScene::Id)&cellSet);
         if (!prepared) return;
@@ -1107,7 +1153,7 @@ namespace SceneEngine
         const PlacementGUID* begin, const PlacementGUID* end,
         const std::function<bool(const RenderCore::Assets::DelayedDrawCall&)>& predicate)
     {
-        _pimpl->BeginPrepare();
+        _pimpl->BeginPrepare(techniqueIndex);
 
         static std::vector<unsigned> visibleObjects;
 
@@ -1311,7 +1357,7 @@ namespace SceneEngine
     unsigned DynamicPlacements::AddString(StringSection<ResChar> str)
     {
         unsigned result = ~unsigned(0x0);
-        auto stringHash = Hash64(str.begin(), str.end());
+        auto stringHash = PlacementsHash64(str);
 
         auto* start = AsPointer(_filenamesBuffer.begin());
         auto* end = AsPointer(_filenamesBuffer.end());
@@ -1940,7 +1986,8 @@ namespace SceneEngine
 
     static uint64 ObjectIdTopPart(const std::string& model, const std::string& material)
     {
-        auto modelAndMaterialHash = Hash64(model, Hash64(material));
+        auto modelAndMaterialHash = PlacementsHash64(
+            MakeStringSection(model), PlacementsHash64(MakeStringSection(material)));
         return uint64(EverySecondBit(modelAndMaterialHash)) << 32ull;
     }
     
@@ -0,0 +1,224 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "SpriteAtlasAllocator.h"
+#include <algorithm>
+#include <assert.h>
+
+namespace SceneEngine
+{
+    static UInt2 MipMapDims(UInt2 dims, unsigned mipMapLevel)
+    {
+        return UInt2(
+            std::max(dims[0] >> mipMapLevel, 1u),
+            std::max(dims[1] >> mipMapLevel, 1u));
+    }
+
+    static bool IsGood(const SpriteAtlasAllocator::Rectangle& rect)
+    {
+        return rect.second[0] > rect.first[0]
+            && rect.second[1] > rect.first[1];
+    }
+
+    bool SpriteAtlasAllocator::AllocateRectangles(UInt2 dims, Rectangle rects[])
+    {
+            // Allocate the full mip-map chain, or nothing at all
+        for (unsigned c=0; c<_mipMapCount; ++c) {
+            rects[c] = _packer.Allocate(MipMapDims(dims, c));
+            if (!IsGood(rects[c])) {
+                for (unsigned q=0; q<c; ++q)
+                    _packer.Deallocate(rects[q]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SpriteAtlasAllocator::EvictOldest(unsigned currentFrame, std::vector<unsigned>* evicted)
+    {
+        if (_evictionFrame != currentFrame) {
+            _evictionFrame = currentFrame;
+            _evictionsThisFrame = 0;
+        }
+        if (_evictionsThisFrame >= _evictionRules._maxEvictionsPerFrame) return false;
+        if (_lruOldest == InvalidSprite) return false;
+
+            // Check the grace period... prevent sprites from being evicted too
+            // soon after being created or used. We will tend to hit this
+            // when the atlas is saturated and we can't fit in any more sprites...
+        const auto& oldest = _sprites[_lruOldest];
+        if ((currentFrame - oldest._createFrame) < _evictionRules._createGracePeriod) return false;
+        if ((currentFrame - oldest._usageFrame) < _evictionRules._usageGracePeriod) return false;
+
+        if (evicted) evicted->push_back(_lruOldest);
+        Release(_lruOldest);
+        ++_evictionsThisFrame;
+        return true;
+    }
+
+    unsigned SpriteAtlasAllocator::Allocate(UInt2 dims, unsigned currentFrame, std::vector<unsigned>* evicted)
+    {
+            //  Sprites that can never fit shouldn't cause any evictions
+        auto atlasDims = _packer.TotalSize();
+        if (!dims[0] || !dims[1] || dims[0] > atlasDims[0] || dims[1] > atlasDims[1] || _sprites.empty())
+            return InvalidSprite;
+
+            //  Note that the oldest sprites are not guaranteed to be contiguous, nor are
+            //  they guaranteed to be large (relative to the new sprite). So evicting a
+            //  few sprites may not free up enough room -- it may take a few frames of
+            //  eviction before the new sprite will fit.
+        while (_freeSprites.empty())
+            if (!EvictOldest(currentFrame, evicted))
+                return InvalidSprite;
+
+        Rectangle rects[MaxMipMaps];
+        while (!AllocateRectangles(dims, rects))
+            if (!EvictOldest(currentFrame, evicted))
+                return InvalidSprite;
+
+        auto result = _freeSprites.back();
+        _freeSprites.pop_back();
+        auto& sprite = _sprites[result];
+        for (unsigned c=0; c<MaxMipMaps; ++c)
+            sprite._rect[c] = (c < _mipMapCount) ? rects[c] : Rectangle(UInt2(0,0), UInt2(0,0));
+        sprite._createFrame = sprite._usageFrame = currentFrame;
+        sprite._allocated = true;
+        LinkNewest(result);
+        ++_spriteCount;
+        return result;
+    }
+
+    void SpriteAtlasAllocator::Release(unsigned spriteIndex)
+    {
+        auto& sprite = _sprites[spriteIndex];
+        assert(sprite._allocated);
+        for (unsigned c=0; c<_mipMapCount; ++c) {
+            _packer.Deallocate(sprite._rect[c]);        // return rectangle to the packer
+            sprite._rect[c] = std::make_pair(UInt2(0,0), UInt2(0,0));
+        }
+        sprite._allocated = false;
+        Unlink(spriteIndex);
+        _freeSprites.push_back(spriteIndex);
+        --_spriteCount;
+    }
+
+    void SpriteAtlasAllocator::Touch(unsigned spriteIndex, unsigned currentFrame)
+    {
+        assert(_sprites[spriteIndex]._allocated);
+        _sprites[spriteIndex]._usageFrame = currentFrame;
+        if (_lruNewest != spriteIndex) {
+            Unlink(spriteIndex);
+            LinkNewest(spriteIndex);
+        }
+    }
+
+    unsigned SpriteAtlasAllocator::GetPixelsAllocated() const
+    {
+        unsigned result = 0;
+        for (const auto& s:_sprites)
+            if (s._allocated)
+                for (unsigned c=0; c<_mipMapCount; ++c)
+                    result += (s._rect[c].second[0] - s._rect[c].first[0]) * (s._rect[c].second[1] - s._rect[c].first[1]);
+        return result;
+    }
+
+    void SpriteAtlasAllocator::LinkNewest(unsigned spriteIndex)
+    {
+        auto& sprite = _sprites[spriteIndex];
+        sprite._lruPrev = InvalidSprite;
+        sprite._lruNext = _lruNewest;
+        if (_lruNewest != InvalidSprite) _sprites[_lruNewest]._lruPrev = spriteIndex;
+        else _lruOldest = spriteIndex;
+        _lruNewest = spriteIndex;
+    }
+
+    void SpriteAtlasAllocator::Unlink(unsigned spriteIndex)
+    {
+        auto& sprite = _sprites[spriteIndex];
+        if (sprite._lruPrev != InvalidSprite) _sprites[sprite._lruPrev]._lruNext = sprite._lruNext;
+        else _lruNewest = sprite._lruNext;
+        if (sprite._lruNext != InvalidSprite) _sprites[sprite._lruNext]._lruPrev = sprite._lruPrev;
+        else _lruOldest = sprite._lruPrev;
+        sprite._lruPrev = sprite._lruNext = InvalidSprite;
+    }
+
+    SpriteAtlasAllocator::SpriteAtlasAllocator(
+        UInt2 atlasDims, unsigned maxSpriteCount, unsigned mipMapCount,
+        const EvictionRules& evictionRules)
+    : _packer(atlasDims)
+    , _evictionRules(evictionRules)
+    {
+        assert(mipMapCount >= 1 && mipMapCount <= MaxMipMaps);
+        _mipMapCount = std::min(std::max(mipMapCount, 1u), unsigned(MaxMipMaps));
+        _spriteCount = 0;
+        _lruNewest = _lruOldest = InvalidSprite;
+        _evictionFrame = 0;
+        _evictionsThisFrame = 0;
+
+        Sprite blank;
+        for (unsigned c=0; c<MaxMipMaps; ++c)
+            blank._rect[c] = std::make_pair(UInt2(0,0), UInt2(0,0));
+        blank._createFrame = blank._usageFrame = 0;
+        blank._allocated = false;
+        blank._lruPrev = blank._lruNext = InvalidSprite;
+        _sprites.resize(maxSpriteCount, blank);
+
+            // (lowest indices are allocated first)
+        _freeSprites.reserve(maxSpriteCount);
+        for (unsigned c=0; c<maxSpriteCount; ++c)
+            _freeSprites.push_back(maxSpriteCount-1-c);
+    }
+
+    SpriteAtlasAllocator::SpriteAtlasAllocator()
+    {
+        _spriteCount = 0;
+        _mipMapCount = 1;
+        _lruNewest = _lruOldest = InvalidSprite;
+        _evictionFrame = 0;
+        _evictionsThisFrame = 0;
+    }
+
+    SpriteAtlasAllocator::~SpriteAtlasAllocator() {}
+
+    SpriteAtlasAllocator::SpriteAtlasAllocator(SpriteAtlasAllocator&& moveFrom) never_throws
+    : _packer(std::move(moveFrom._packer))
+    , _sprites(std::move(moveFrom._sprites))
+    , _freeSprites(std::move(moveFrom._freeSprites))
+    , _spriteCount(moveFrom._spriteCount)
+    , _mipMapCount(moveFrom._mipMapCount)
+    , _lruNewest(moveFrom._lruNewest), _lruOldest(moveFrom._lruOldest)
+    , _evictionRules(moveFrom._evictionRules)
+    , _evictionFrame(moveFrom._evictionFrame)
+    , _evictionsThisFrame(moveFrom._evictionsThisFrame)
+    {
+        moveFrom._spriteCount = 0;
+        moveFrom._lruNewest = moveFrom._lruOldest = InvalidSprite;
+    }
+
+    SpriteAtlasAllocator& SpriteAtlasAllocator::operator=(SpriteAtlasAllocator&& moveFrom) never_throws
+    {
+        _packer = std::move(moveFrom._packer);
+        _sprites = std::move(moveFrom._sprites);
+        _freeSprites = std::move(moveFrom._freeSprites);
+        _spriteCount = moveFrom._spriteCount;
+        _mipMapCount = moveFrom._mipMapCount;
+        _lruNewest = moveFrom._lruNewest; _lruOldest = moveFrom._lruOldest;
+        _evictionRules = moveFrom._evictionRules;
+        _evictionFrame = moveFrom._evictionFrame;
+        _evictionsThisFrame = moveFrom._evictionsThisFrame;
+        moveFrom._spriteCount = 0;
+        moveFrom._lruNewest = moveFrom._lruOldest = InvalidSprite;
+        return *this;
+    }
+
+    SpriteAtlasAllocator::EvictionRules::EvictionRules()
+    {
+        _maxEvictionsPerFrame = 3;
+        _createGracePeriod = 60;
+        _usageGracePeriod = 5;
+    }
+}
+
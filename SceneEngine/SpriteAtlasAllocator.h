@@ -0,0 +1,102 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../Math/RectanglePacking.h"
+#include "../Math/Vector.h"
+#include <vector>
+
+namespace SceneEngine
+{
+    /// <summary>Allocates space for sprites within a texture atlas, with eviction</summary>
+    /// Each sprite gets a chain of rectangles, one for each mip-map level, which are packed
+    /// with a RectanglePacker_Guillotine (so space can be reused as sprites come and go).
+    ///
+    /// Sprites are kept in least-recently-used order. When there isn't enough space (or no
+    /// free sprite slots) for a new sprite, the least recently used sprites are evicted.
+    /// But sprites that were created or used very recently are never evicted, and only a
+    /// limited number of sprites can be evicted per frame. This prevents thrashing when
+    /// the atlas is saturated -- in that case, new sprites will have to wait.
+    ///
+    /// This only manages the space in the atlas; it doesn't touch any GPU resources. The
+    /// client renders into the rectangles, and gets a list of evicted sprites from Allocate()
+    /// so it can update its own tables.
+    class SpriteAtlasAllocator
+    {
+    public:
+        using Rectangle = std::pair<UInt2, UInt2>;
+        static const unsigned MaxMipMaps = 5;
+        static const unsigned InvalidSprite = ~0u;
+
+        class Sprite
+        {
+        public:
+            Rectangle   _rect[MaxMipMaps];
+            unsigned    _createFrame;
+            unsigned    _usageFrame;
+            bool        _allocated;
+
+            unsigned    _lruPrev, _lruNext;     // toward the more recently used, and the less recently used
+        };
+
+        class EvictionRules
+        {
+        public:
+            unsigned    _maxEvictionsPerFrame;
+            unsigned    _createGracePeriod;     // don't evict sprites within this many frames from their creation
+            unsigned    _usageGracePeriod;      // don't evict sprites within this many frames of being used
+
+            EvictionRules();
+        };
+
+            //  Returns InvalidSprite if there is no room, even after evicting what we can.
+            //  The indices of evicted sprites are appended to "evicted" (if it's not null)
+        unsigned    Allocate(UInt2 dims, unsigned currentFrame, std::vector<unsigned>* evicted = nullptr);
+        void        Release(unsigned sprite);
+        void        Touch(unsigned sprite, unsigned currentFrame);
+
+        const Sprite& GetSprite(unsigned sprite) const { return _sprites[sprite]; }
+        unsigned    GetMipMapCount() const { return _mipMapCount; }
+        unsigned    GetSpriteCount() const { return _spriteCount; }
+        unsigned    GetMaxSpriteCount() const { return unsigned(_sprites.size()); }
+        unsigned    GetPixelsAllocated() const;
+
+            //  The least recently used sprite, or InvalidSprite if there are none
+        unsigned    GetLeastRecentlyUsed() const { return _lruOldest; }
+
+        UInt2       GetAtlasDims() const { return _packer.TotalSize(); }
+        std::pair<UInt2, UInt2> LargestFreeBlock() const { return _packer.LargestFreeBlock(); }
+        float       Fragmentation() const { return _packer.Fragmentation(); }
+
+        SpriteAtlasAllocator(
+            UInt2 atlasDims, unsigned maxSpriteCount, unsigned mipMapCount = MaxMipMaps,
+            const EvictionRules& evictionRules = EvictionRules());
+        SpriteAtlasAllocator();
+        ~SpriteAtlasAllocator();
+
+        SpriteAtlasAllocator(SpriteAtlasAllocator&& moveFrom) never_throws;
+        SpriteAtlasAllocator& operator=(SpriteAtlasAllocator&& moveFrom) never_throws;
+
+    private:
+        RectanglePacker_Guillotine  _packer;
+        std::vector<Sprite>         _sprites;
+        std::vector<unsigned>       _freeSprites;
+        unsigned                    _spriteCount;
+        unsigned                    _mipMapCount;
+        unsigned                    _lruNewest, _lruOldest;
+
+        EvictionRules               _evictionRules;
+        unsigned                    _evictionFrame;
+        unsigned                    _evictionsThisFrame;
+
+        bool        AllocateRectangles(UInt2 dims, Rectangle rects[]);
+        bool        EvictOldest(unsigned currentFrame, std::vector<unsigned>* evicted);
+        void        LinkNewest(unsigned sprite);
+        void        Unlink(unsigned sprite);
+    };
+}
+
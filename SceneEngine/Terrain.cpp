@@ -28,11 +28,20 @@ namespace SceneEngine
     {
     }
 
-    TerrainCell::Node::Node(const Float4x4& localToCell, size_t heightMapFileOffset, size_t heightMapFileSize, unsigned widthInElements)
+    TerrainCell::Node::Node(
+        const Float4x4& localToCell, size_t heightMapFileOffset, size_t heightMapFileSize, unsigned widthInElements,
+        TerrainNodeEncoding::Enum heightMapEncoding)
     : _localToCell(localToCell), _heightMapFileOffset(heightMapFileOffset), _heightMapFileSize(heightMapFileSize)
-    , _widthInElements(widthInElements)
+    , _widthInElements(widthInElements), _heightMapEncoding(heightMapEncoding)
     {}
 
+    bool TerrainCell::Node::HasHeightData() const
+    {
+            // (encoded nodes are only ever written with complete data)
+        if (_heightMapEncoding != TerrainNodeEncoding::Raw) return _heightMapFileSize != 0;
+        return _heightMapFileSize >= _widthInElements*_widthInElements*sizeof(uint16);
+    }
+
     //////////////////////////////////////////////////////////////////////////////////////////
 
     TerrainCellTexture::TerrainCellTexture() 
@@ -10,6 +10,8 @@
 #include "../RenderCore/Metal/Forward.h"    // (for RenderCore::Metal::DeviceContext)
 #include "../Math/Vector.h"
 #include "../Assets/AssetsCore.h"
+#include "../Utility/IteratorUtils.h"
+#include <memory>
 
 namespace RenderCore { namespace Techniques { class CameraDesc; } }
 namespace Utility { class OutputStream; }
@@ -24,6 +26,7 @@ namespace SceneEngine
     class CoverageUberSurfaceInterface;
     class ITerrainFormat;
     class ISurfaceHeightsProvider;
+    class TerrainHeightQueries;
     
     class TerrainConfig;
     class TerrainCoordinateSystem;
@@ -84,6 +87,12 @@ namespace SceneEngine
         CoverageUberSurfaceInterface*   GetCoverageInterface(TerrainCoverageId id);
         std::shared_ptr<ISurfaceHeightsProvider>    GetHeightsProvider();
 
+            /// <summary>CPU side height queries against the currently loaded terrain</summary>
+            /// Rebuilt whenever the terrain is loaded or moved, so clients should
+            /// not hold onto the result across those operations. Returns nullptr if
+            /// no terrain is loaded.
+        std::shared_ptr<TerrainHeightQueries>       GetHeightQueries();
+
         const TerrainCoordinateSystem&  GetCoords() const;
         const TerrainConfig&            GetConfig() const;
         const TerrainMaterialConfig&    GetMaterialConfig() const;
@@ -131,26 +140,64 @@ namespace SceneEngine
         std::unique_ptr<Pimpl> _pimpl;
     };
 
-    /// <summary>Gets the height of the terrain at a position, without using the GPU</summary>
+    /// <summary>Gets the height of the terrain at positions, without using the GPU</summary>
     /// There are 2 forms of intersection testing supported by the system.
     /// TerrainManager::CalculateIntersections uses the GPU, and calculates an intersection against
     /// post-LOD geometry. It is intended for tools that want match mouse clicks against rendered
     /// geometry.
-    /// In constrast, GetTerrainHeight does not use the GPU and only tests against the top LOD.
+    /// In constrast, TerrainHeightQueries does not use the GPU and only tests against the top LOD.
     /// This is used by simple physical simulations (such as sliding a character across the terrain
     /// surface).
     /// Note that this requires loading some terrain height data into main memory (whereas rendering 
     /// only requires height data in GPU memory). So, this can require reading height data from disk
     /// a second time.
-    float GetTerrainHeight(
-        ITerrainFormat& ioFormat, const TerrainConfig& cfg, 
-        const TerrainCoordinateSystem& coords, Float2 queryPosition);
-
-    /// <summary>Like GetTerrainHeight, but also returns the normal</summary>
-    bool GetTerrainHeightAndNormal(
-        float& height, Float3& normal,
-        ITerrainFormat& ioFormat, const TerrainConfig& cfg, 
-        const TerrainCoordinateSystem& coords, Float2 queryPosition);
+    ///
+    /// It is thread safe, for clients that make many height queries per frame (possibly from
+    /// several threads at once). Height data for recently used nodes is kept in a cache of
+    /// the given size, shared by all threads. TerrainManager::GetHeightQueries() returns an
+    /// instance for the loaded terrain.
+    ///
+    /// QueryHeights() groups the queries by terrain node (sorting them if they
+    /// aren't already coherent), so each node is looked up once per batch. The
+    /// bilinear filtering is done 4 queries at a time with SIMD.
+    ///
+    /// Queries that land on height data that is still loading return 
+    /// QueryResult::NotLoaded (rather than a height of 0), so the client can try
+    /// again later.
+    class TerrainHeightQueries
+    {
+    public:
+        enum class QueryResult { Success, NotLoaded, OutsideTerrain, Error };
+
+        QueryResult QueryHeight(Float2 queryPosition, float& height) const;
+        QueryResult QueryHeightAndNormal(Float2 queryPosition, float& height, Float3& normal) const;
+
+        void QueryHeights(
+            IteratorRange<const Float2*> queryPositions,
+            IteratorRange<float*> heights,
+            IteratorRange<QueryResult*> results) const;
+        void QueryHeightsAndNormals(
+            IteratorRange<const Float2*> queryPositions,
+            IteratorRange<float*> heights,
+            IteratorRange<Float3*> normals,
+            IteratorRange<QueryResult*> results) const;
+
+            /// <summary>Releases all cached height data</summary>
+        void ClearCache();
+
+        TerrainHeightQueries(
+            std::shared_ptr<ITerrainFormat> ioFormat,
+            const TerrainConfig& cfg, const TerrainCoordinateSystem& coords,
+            unsigned cacheSize = 256);
+        ~TerrainHeightQueries();
+
+        TerrainHeightQueries(const TerrainHeightQueries&) = delete;
+        TerrainHeightQueries& operator=(const TerrainHeightQueries&) = delete;
+
+    private:
+        class Pimpl;
+        std::unique_ptr<Pimpl> _pimpl;
+    };
 
     class TerrainCell;
     class TerrainCellTexture;
@@ -12,15 +12,18 @@
 #include "../ConsoleRig/Log.h"
 #include "../Utility/Streams/FileUtils.h"
 #include "../Utility/HeapUtils.h"
+#include "../Utility/Threading/Mutex.h"
 #include <memory>
+#include <algorithm>
+#include <emmintrin.h>
 
 namespace SceneEngine
 {
     class TerrainNodeHeightCollision
     {
     public:
-        float   GetHeight(Float2 cellBasedCoord) const;
         bool    GetHeightAndNormal(Float2 cellBasedCoord, float& height, Float3& normal) const;
+        void    GetHeights(const Float2 cellBasedCoords[], float heights[], size_t count) const;
 
         const std::shared_ptr<::Assets::DependencyValidation>& GetDependencyValidation() const   { return _validationCallback; }
 
@@ -32,18 +35,9 @@ namespace SceneEngine
         std::shared_ptr<Assets::DependencyValidation>  _validationCallback;
         bool _encodedGradientFlags;
 
-        float GetHeightSample(Int2 coord) const;
         void GetHeightAndNormalSample(Int2 coord, float& height, Float3& normal) const;
     };
 
-    inline float TerrainNodeHeightCollision::GetHeightSample(Int2 coord) const
-    {
-        assert(coord[1] < int(_scaffoldData._widthInElements) && coord[0] < int(_scaffoldData._widthInElements));
-        const auto mask = CompressedHeightMask(_encodedGradientFlags);
-        auto rawSample = _heightData.get()[coord[1] * _scaffoldData._widthInElements + coord[0]] & mask;
-        return float(rawSample) * _scaffoldData._localToCell(2, 2) + _scaffoldData._localToCell(2, 3);
-    }
-
     inline void TerrainNodeHeightCollision::GetHeightAndNormalSample(Int2 coord, float& height, Float3& normal) const
     {
         // Using the same method to calculate the normal as the shader code
@@ -76,40 +70,6 @@ namespace SceneEngine
         height = height00;
     }
 
-    float TerrainNodeHeightCollision::GetHeight(Float2 cellBasedCoord) const
-    {
-        Float2 nodeCoord(
-            (cellBasedCoord[0] - _scaffoldData._localToCell(0,3)) / _scaffoldData._localToCell(0,0),
-            (cellBasedCoord[1] - _scaffoldData._localToCell(1,3)) / _scaffoldData._localToCell(1,1));
-        nodeCoord *= float(_scaffoldData._widthInElements - _scaffoldData.GetOverlapWidth());
-
-        Float2 A(XlFloor(nodeCoord[0]), XlFloor(nodeCoord[1]));
-        Int2 baseIndex((int)A[0], (int)A[1]);
-        if (   baseIndex[0] < 0 || baseIndex[1] < 0
-            || (baseIndex[0]+1) >= int(_scaffoldData._widthInElements) 
-            || (baseIndex[1]+1) >= int(_scaffoldData._widthInElements)) {
-            assert(0);      // probably testing the wrong node. The coordinates given don't match the node transform
-            return 0.f;
-        }
-
-        Float2 B = nodeCoord - A;
-            //  Typical bilinear filtering -- get results with 4 taps.
-            //  Note that this isn't exactly the same as the rendered result. When rendering
-            //  the quad, the edge in the center may become a hill or a valley. But here, the 
-            //  bilinear filter will smooth that out differently. It may result in objects
-            //  hovering. If we know the direction of the center edge, we can do this test
-            //  with just 3 taps.
-        float h0 = GetHeightSample(baseIndex);
-        float h1 = GetHeightSample(baseIndex + Int2(1,0));
-        float h2 = GetHeightSample(baseIndex + Int2(0,1));
-        float h3 = GetHeightSample(baseIndex + Int2(1,1));
-        float w0 = (1.0f - B[0]) * (1.f - B[1]);
-        float w1 = B[0] * (1.f - B[1]);
-        float w2 = (1.0f - B[0]) * B[1];
-        float w3 = B[0] * B[1];
-        return h0 * w0 + h1 * w1 + h2 * w2 + h3 * w3;
-    }
-
     bool TerrainNodeHeightCollision::GetHeightAndNormal(Float2 cellBasedCoord, float& height, Float3& normal) const
     {
         Float2 nodeCoord(
@@ -150,6 +110,75 @@ namespace SceneEngine
         return true;
     }
 
+    void TerrainNodeHeightCollision::GetHeights(const Float2 cellBasedCoords[], float heights[], size_t count) const
+    {
+            //  Bilinear filtering for 4 queries at a time. The taps are gathered with
+            //  scalar loads, but the coordinate transforms and filtering use SSE.
+            //  Coordinates outside of the node are clamped to the edge.
+        const int width = int(_scaffoldData._widthInElements);
+        const unsigned mask = CompressedHeightMask(_encodedGradientFlags);
+        const float elementCount = float(width - int(_scaffoldData.GetOverlapWidth()));
+        const auto& localToCell = _scaffoldData._localToCell;
+
+        const auto scaleX = _mm_set1_ps(elementCount / localToCell(0,0));
+        const auto scaleY = _mm_set1_ps(elementCount / localToCell(1,1));
+        const auto offsetX = _mm_set1_ps(localToCell(0,3));
+        const auto offsetY = _mm_set1_ps(localToCell(1,3));
+        const auto heightScale = _mm_set1_ps(localToCell(2,2));
+        const auto heightOffset = _mm_set1_ps(localToCell(2,3));
+        const auto zero = _mm_setzero_ps();
+        const auto maxBase = _mm_set1_ps(float(width-2));
+        const auto maxCoord = _mm_set1_ps(float(width-1));
+        const auto* data = _heightData.get();
+
+        for (size_t c=0; c<count; c+=4) {
+            auto n = std::min(count-c, size_t(4));
+            __declspec(align(16)) float xs[4], ys[4];
+            for (unsigned q=0; q<4; ++q) {
+                const auto& p = cellBasedCoords[c + std::min(size_t(q), n-1)];
+                xs[q] = p[0]; ys[q] = p[1];
+            }
+
+            auto x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(xs), offsetX), scaleX);
+            auto y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ys), offsetY), scaleY);
+            x = _mm_min_ps(_mm_max_ps(x, zero), maxCoord);
+            y = _mm_min_ps(_mm_max_ps(y, zero), maxCoord);
+
+                // (x and y are positive, so truncation is the same as floor)
+            auto baseX = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(x)), maxBase);
+            auto baseY = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(y)), maxBase);
+            auto fracX = _mm_sub_ps(x, baseX);
+            auto fracY = _mm_sub_ps(y, baseY);
+
+            __declspec(align(16)) int32 ix[4], iy[4];
+            _mm_store_si128((__m128i*)ix, _mm_cvttps_epi32(baseX));
+            _mm_store_si128((__m128i*)iy, _mm_cvttps_epi32(baseY));
+
+            __declspec(align(16)) int32 taps[4][4];
+            for (unsigned q=0; q<4; ++q) {
+                const auto* row = &data[iy[q] * width + ix[q]];
+                taps[0][q] = row[0] & mask;
+                taps[1][q] = row[1] & mask;
+                taps[2][q] = row[width] & mask;
+                taps[3][q] = row[width+1] & mask;
+            }
+
+            auto h00 = _mm_cvtepi32_ps(_mm_load_si128((const __m128i*)taps[0]));
+            auto h10 = _mm_cvtepi32_ps(_mm_load_si128((const __m128i*)taps[1]));
+            auto h01 = _mm_cvtepi32_ps(_mm_load_si128((const __m128i*)taps[2]));
+            auto h11 = _mm_cvtepi32_ps(_mm_load_si128((const __m128i*)taps[3]));
+
+            auto top = _mm_add_ps(h00, _mm_mul_ps(_mm_sub_ps(h10, h00), fracX));
+            auto bottom = _mm_add_ps(h01, _mm_mul_ps(_mm_sub_ps(h11, h01), fracX));
+            auto filtered = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fracY));
+
+                // (the height transform is linear, so we can apply it after filtering)
+            __declspec(align(16)) float result[4];
+            _mm_store_ps(result, _mm_add_ps(_mm_mul_ps(filtered, heightScale), heightOffset));
+            std::copy(result, &result[n], &heights[c]);
+        }
+    }
+
     TerrainNodeHeightCollision::TerrainNodeHeightCollision(const char cellFilename[], ITerrainFormat& ioFormat, unsigned nodeIndex)
         : _scaffoldData(Identity<Float4x4>(), 0, 0, 0)
     {
@@ -165,11 +194,24 @@ namespace SceneEngine
             //  a coordinate space defined by a single precision floating 
             //  point transform.
         auto& node = *cell._nodes[nodeIndex];
-        auto heightData = std::make_unique<uint16[]>(node._heightMapFileSize/2);
-        {
+        std::unique_ptr<uint16[]> heightData;
+        if (node._heightMapEncoding == TerrainNodeEncoding::Raw) {
+            heightData = std::make_unique<uint16[]>(node._heightMapFileSize/2);
             BasicFile file(cellFilename, "rb");
             file.Seek(node._heightMapFileOffset, SEEK_SET);
             file.Read(heightData.get(), 1, node._heightMapFileSize);
+        } else {
+            auto encodedData = std::make_unique<uint8[]>(node._heightMapFileSize);
+            {
+                BasicFile file(cellFilename, "rb");
+                file.Seek(node._heightMapFileOffset, SEEK_SET);
+                file.Read(encodedData.get(), 1, node._heightMapFileSize);
+            }
+
+            auto elementCount = node._widthInElements*node._widthInElements;
+            heightData = std::make_unique<uint16[]>(elementCount);
+            if (!DecodeTerrainNode(heightData.get(), elementCount*sizeof(uint16), encodedData.get(), node._heightMapFileSize))
+                throw ::Exceptions::BasicLabel("Bad encoded height data in TerrainNodeHeightCollision");
         }
 
         auto validCallback = std::make_shared<Assets::DependencyValidation>();
@@ -185,129 +227,249 @@ namespace SceneEngine
     TerrainNodeHeightCollision::~TerrainNodeHeightCollision()
     {}
 
-    extern Int2 TerrainOffset;
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    using QueryResult = TerrainHeightQueries::QueryResult;
 
-    float GetTerrainHeight(
-        ITerrainFormat& ioFormat, const TerrainConfig& cfg, 
-        const TerrainCoordinateSystem& coords, Float2 queryPosition)
+    class TerrainHeightQueries::Pimpl
     {
-        TRY
-        {
-                //
-                //  Find the cell and node that contains this position.
-                //  Once we've found it, we need to find a cached TerrainNodeHeightCollision
-                //  for the given node, and get the height data from that.
-                //
-                //  We're going to make some assumptions to make this faster. 
-                //      * We'll assume that the cells are arranged in a grid, so we can find the cell quickly
-                //      * we'll also make similar assumptions about the arrangement of nodes within
-                //          the cell, so we can find the node index directly (within loading the cell node)
-                //  
-
-            auto worldToCell = coords.WorldToCellBased();
-            auto cellBasedCoord = Truncate(
-                TransformPoint(worldToCell, Expand(queryPosition, 0.f)));
-
-            Float2 cellIndex(XlFloor(cellBasedCoord[0]), XlFloor(cellBasedCoord[1]));
-
-            if (    cellIndex[0] < 0.f || cellIndex[0] >= float(cfg._cellCount[0])
-                ||  cellIndex[1] < 0.f || cellIndex[1] >= float(cfg._cellCount[1])) {
-                return 0.f;
-            }
+    public:
+        std::shared_ptr<ITerrainFormat> _ioFormat;
+        TerrainConfig               _cfg;
+        Float4x4                    _worldToCell;
+        float                       _heightOffset;
+        UInt2                       _cellDimsInNodes;
+        unsigned                    _firstNodeIndex;
+
+        Threading::Mutex            _cacheLock;
+        LRUCache<TerrainNodeHeightCollision> _cache;
+        unsigned                    _cacheSize;
+        Threading::Mutex            _loadLock;
+
+        bool CalculateNodeKey(Float2 queryPosition, uint32& nodeKey, Float2& cellFrac) const;
+        std::shared_ptr<TerrainNodeHeightCollision> GetNode(uint32 nodeKey, QueryResult& result);
+        std::shared_ptr<TerrainNodeHeightCollision> TryGetCached(uint32 nodeKey);
+        std::vector<uint64> GroupQueriesByNode(
+            IteratorRange<const Float2*> queryPositions,
+            IteratorRange<QueryResult*> results,
+            std::vector<Float2>& cellFracs) const;
+
+        Pimpl(unsigned cacheSize) : _cache(cacheSize), _cacheSize(cacheSize) {}
+    };
 
-            Float2 cellFrac(cellBasedCoord[0] - cellIndex[0], cellBasedCoord[1] - cellIndex[1]);
-        
-            auto cellDimsInNodes = cfg.CellDimensionsInNodes();
-            float nodeX = XlFloor(cellFrac[0] * float(cellDimsInNodes[0]));
-            float nodeY = XlFloor(cellFrac[1] * float(cellDimsInNodes[1]));
-            unsigned nodeIndex = 85 + unsigned(nodeY) * cellDimsInNodes[0] + unsigned(nodeX);
-
-            uint64 cellHash = (uint64(nodeIndex) << 32ull) | (uint64(cellIndex[1]) << 6ull) | uint64(cellIndex[0]);
-
-                // (simple cache for recently used terrain files -- so we don't have to continually re-load every frame)
-                //      -- \todo -- this cache should be in a manager object! todo many statics in functions!
-            static LRUCache<TerrainNodeHeightCollision> CollisionCache(8);
-            auto collisionObject = CollisionCache.Get(cellHash);
-            if (!collisionObject) {
-                char cellFilename[MaxPath];
-                cfg.GetCellFilename(cellFilename, dimof(cellFilename), UInt2(unsigned(cellIndex[0]), unsigned(cellIndex[1])), CoverageId_Heights);
-                collisionObject = std::make_shared<TerrainNodeHeightCollision>(cellFilename, ioFormat, nodeIndex);
-                CollisionCache.Insert(cellHash, collisionObject);
-            }
+    bool TerrainHeightQueries::Pimpl::CalculateNodeKey(Float2 queryPosition, uint32& nodeKey, Float2& cellFrac) const
+    {
+            //  We assume that the cells are arranged in a grid, and that
+            //  the nodes in the highest LOD are arranged in a grid within each cell. So we can
+            //  find the node directly, without loading the cell
+        auto cellBasedCoord = Truncate(TransformPoint(_worldToCell, Expand(queryPosition, 0.f)));
+        Float2 cellIndex(XlFloor(cellBasedCoord[0]), XlFloor(cellBasedCoord[1]));
+        if (    !(cellIndex[0] >= 0.f) || cellIndex[0] >= float(_cfg._cellCount[0])
+            ||  !(cellIndex[1] >= 0.f) || cellIndex[1] >= float(_cfg._cellCount[1]))
+            return false;
 
-            assert(collisionObject);
-            return collisionObject->GetHeight(cellFrac) + coords.TerrainOffset()[2];
+        cellFrac = Float2(cellBasedCoord[0] - cellIndex[0], cellBasedCoord[1] - cellIndex[1]);
+        auto nodeX = std::min(unsigned(cellFrac[0] * float(_cellDimsInNodes[0])), _cellDimsInNodes[0]-1);
+        auto nodeY = std::min(unsigned(cellFrac[1] * float(_cellDimsInNodes[1])), _cellDimsInNodes[1]-1);
+        auto cell = unsigned(cellIndex[1]) * _cfg._cellCount[0] + unsigned(cellIndex[0]);
+        nodeKey = (cell * _cellDimsInNodes[1] + nodeY) * _cellDimsInNodes[0] + nodeX;
+        return true;
+    }
 
+    std::shared_ptr<TerrainNodeHeightCollision> TerrainHeightQueries::Pimpl::TryGetCached(uint32 nodeKey)
+    {
+        ScopedLock(_cacheLock);
+        auto result = _cache.Get(nodeKey);
+        if (result && result->GetDependencyValidation()->GetValidationIndex() != 0)
+            return nullptr;     // (source data has changed; we must reload)
+        return result;
+    }
+
+    std::shared_ptr<TerrainNodeHeightCollision> TerrainHeightQueries::Pimpl::GetNode(uint32 nodeKey, QueryResult& result)
+    {
+        auto existing = TryGetCached(nodeKey);
+        if (existing) { result = QueryResult::Success; return existing; }
+
+            //  Loading happens outside of the cache lock, so other threads can continue to 
+            //  query cached nodes. But we will only load one node at a time.
+        auto nodesPerCell = _cellDimsInNodes[0] * _cellDimsInNodes[1];
+        auto cell = nodeKey / nodesPerCell;
+        auto nodeInCell = nodeKey % nodesPerCell;
+        UInt2 cellIndex(cell % _cfg._cellCount[0], cell / _cfg._cellCount[0]);
+
+        TRY
+        {
+            std::shared_ptr<TerrainNodeHeightCollision> newNode;
+            {
+                ScopedLock(_loadLock);
+                    // another thread may have loaded this node while we were waiting
+                newNode = TryGetCached(nodeKey);
+                if (!newNode) {
+                    char cellFilename[MaxPath];
+                    _cfg.GetCellFilename(cellFilename, dimof(cellFilename), cellIndex, CoverageId_Heights);
+                    newNode = std::make_shared<TerrainNodeHeightCollision>(cellFilename, *_ioFormat, _firstNodeIndex + nodeInCell);
+
+                    ScopedLock(_cacheLock);
+                    _cache.Insert(nodeKey, newNode);
+                }
+            }
+            result = QueryResult::Success;
+            return newNode;
         } CATCH(const ::Assets::Exceptions::PendingAsset&) {
+            result = QueryResult::NotLoaded;
         } CATCH(const std::exception&) {
-            // we can sometimes get missing files. Just return a default height
-            LogWarning << "Error when querying terrain height at " << queryPosition[0] << ", " << queryPosition[1];
+            LogWarning << "Error when loading terrain heights for cell (" << cellIndex[0] << ", " << cellIndex[1] << ")";
+            result = QueryResult::Error;
         } CATCH_END
 
-        return 0.f;
+        return nullptr;
     }
 
-    bool GetTerrainHeightAndNormal(
-        float& height, Float3& normal,
-        ITerrainFormat& ioFormat, const TerrainConfig& cfg, 
-        const TerrainCoordinateSystem& coords, Float2 queryPosition)
+    auto TerrainHeightQueries::QueryHeight(Float2 queryPosition, float& height) const -> QueryResult
     {
-        TRY
-        {
-                //
-                //  Find the cell and node that contains this position.
-                //  Once we've found it, we need to find a cached TerrainNodeHeightCollision
-                //  for the given node, and get the height data from that.
-                //
-                //  We're going to make some assumptions to make this faster. 
-                //      * We'll assume that the cells are arranged in a grid, so we can find the cell quickly
-                //      * we'll also make similar assumptions about the arrangement of nodes within
-                //          the cell, so we can find the node index directly (within loading the cell node)
-                //  
-
-            auto worldToCell = coords.WorldToCellBased();
-            auto cellBasedCoord = Truncate(
-                TransformPoint(worldToCell, Expand(queryPosition, 0.f)));
-
-            Float2 cellIndex(XlFloor(cellBasedCoord[0]), XlFloor(cellBasedCoord[1]));
-
-            if (    cellIndex[0] < 0.f || cellIndex[0] >= float(cfg._cellCount[0])
-                ||  cellIndex[1] < 0.f || cellIndex[1] >= float(cfg._cellCount[1])) {
-                return false;
+        auto result = QueryResult::OutsideTerrain;
+        QueryHeights(
+            MakeIteratorRange(&queryPosition, &queryPosition+1),
+            MakeIteratorRange(&height, &height+1),
+            MakeIteratorRange(&result, &result+1));
+        return result;
+    }
+
+    auto TerrainHeightQueries::QueryHeightAndNormal(Float2 queryPosition, float& height, Float3& normal) const -> QueryResult
+    {
+        auto result = QueryResult::OutsideTerrain;
+        QueryHeightsAndNormals(
+            MakeIteratorRange(&queryPosition, &queryPosition+1),
+            MakeIteratorRange(&height, &height+1),
+            MakeIteratorRange(&normal, &normal+1),
+            MakeIteratorRange(&result, &result+1));
+        return result;
+    }
+
+        //  Calculates the node for each query, and returns a list of (nodeKey << 32 | queryIndex)
+        //  grouped by node. Queries outside of the terrain are marked in "results" and excluded.
+    std::vector<uint64> TerrainHeightQueries::Pimpl::GroupQueriesByNode(
+        IteratorRange<const Float2*> queryPositions,
+        IteratorRange<QueryResult*> results,
+        std::vector<Float2>& cellFracs) const
+    {
+        std::vector<uint64> result;
+        result.reserve(queryPositions.size());
+        cellFracs.resize(queryPositions.size());
+
+        unsigned runCount = 0;
+        uint32 lastKey = ~0u;
+        for (size_t q=0; q<queryPositions.size(); ++q) {
+            uint32 nodeKey;
+            if (!CalculateNodeKey(queryPositions[q], nodeKey, cellFracs[q])) {
+                results[q] = QueryResult::OutsideTerrain;
+                continue;
             }
+            result.push_back((uint64(nodeKey) << 32ull) | uint64(q));
+            runCount += (nodeKey != lastKey);
+            lastKey = nodeKey;
+        }
+
+            //  Coherent queries are already mostly grouped, and only need a few more node 
+            //  lookups than sorted queries would. So only pay for the sort when it's needed.
+        if (runCount > (result.size() / 16))
+            std::sort(result.begin(), result.end());
+        return result;
+    }
 
-            Float2 cellFrac(cellBasedCoord[0] - cellIndex[0], cellBasedCoord[1] - cellIndex[1]);
-        
-            auto cellDimsInNodes = cfg.CellDimensionsInNodes();
-            float nodeX = XlFloor(cellFrac[0] * float(cellDimsInNodes[0]));
-            float nodeY = XlFloor(cellFrac[1] * float(cellDimsInNodes[1]));
-            unsigned nodeIndex = 85 + unsigned(nodeY) * cellDimsInNodes[0] + unsigned(nodeX);
-
-            uint64 cellHash = (uint64(nodeIndex) << 32ull) | (uint64(cellIndex[1]) << 6ull) | uint64(cellIndex[0]);
-
-                // (simple cache for recently used terrain files -- so we don't have to continually re-load every frame)
-                //      -- \todo -- this cache should be in a manager object! todo many statics in functions!
-            static LRUCache<TerrainNodeHeightCollision> CollisionCache(8);
-            auto collisionObject = CollisionCache.Get(cellHash);
-            if (!collisionObject) {
-                char cellFilename[MaxPath];
-                cfg.GetCellFilename(cellFilename, dimof(cellFilename), UInt2(unsigned(cellIndex[0]), unsigned(cellIndex[1])), CoverageId_Heights);
-                collisionObject = std::make_shared<TerrainNodeHeightCollision>(cellFilename, ioFormat, nodeIndex);
-                CollisionCache.Insert(cellHash, collisionObject);
+    void TerrainHeightQueries::QueryHeights(
+        IteratorRange<const Float2*> queryPositions,
+        IteratorRange<float*> heights,
+        IteratorRange<QueryResult*> results) const
+    {
+        assert(heights.size() == queryPositions.size() && results.size() == queryPositions.size());
+        std::fill(heights.begin(), heights.end(), 0.f);
+
+        std::vector<Float2> cellFracs;
+        auto groups = _pimpl->GroupQueriesByNode(queryPositions, results, cellFracs);
+
+        const unsigned batchSize = 64;
+        Float2 batchCoords[batchSize];
+        float batchHeights[batchSize];
+
+        for (auto i=groups.cbegin(); i!=groups.cend();) {
+            auto nodeKey = uint32(*i >> 32ull);
+            auto runEnd = i+1;
+            while (runEnd != groups.cend() && uint32(*runEnd >> 32ull) == nodeKey) ++runEnd;
+
+            QueryResult nodeResult;
+            auto node = _pimpl->GetNode(nodeKey, nodeResult);
+            if (!node) {
+                for (; i!=runEnd; ++i)
+                    results[size_t(*i & 0xffffffffull)] = nodeResult;
+                continue;
             }
 
-            assert(collisionObject);
-            bool queryResult = collisionObject->GetHeightAndNormal(cellFrac, height, normal);
-            height += coords.TerrainOffset()[2];
-            return queryResult;
+            while (i != runEnd) {
+                auto count = std::min(size_t(runEnd - i), size_t(batchSize));
+                for (size_t c=0; c<count; ++c)
+                    batchCoords[c] = cellFracs[size_t(i[c] & 0xffffffffull)];
+                node->GetHeights(batchCoords, batchHeights, count);
+                for (size_t c=0; c<count; ++c) {
+                    auto q = size_t(i[c] & 0xffffffffull);
+                    heights[q] = batchHeights[c] + _pimpl->_heightOffset;
+                    results[q] = QueryResult::Success;
+                }
+                i += count;
+            }
+        }
+    }
 
-        } CATCH(const ::Assets::Exceptions::PendingAsset&) {
-        } CATCH(const std::exception&) {
-            // we can sometimes get missing files. Just return a default height
-            LogWarning << "Error when querying terrain height at " << queryPosition[0] << ", " << queryPosition[1];
-        } CATCH_END
+    void TerrainHeightQueries::QueryHeightsAndNormals(
+        IteratorRange<const Float2*> queryPositions,
+        IteratorRange<float*> heights,
+        IteratorRange<Float3*> normals,
+        IteratorRange<QueryResult*> results) const
+    {
+        assert(heights.size() == queryPositions.size() && normals.size() == queryPositions.size() && results.size() == queryPositions.size());
+        std::fill(heights.begin(), heights.end(), 0.f);
+        std::fill(normals.begin(), normals.end(), Float3(0.f, 0.f, 1.f));
+
+        std::vector<Float2> cellFracs;
+        auto groups = _pimpl->GroupQueriesByNode(queryPositions, results, cellFracs);
+
+        for (auto i=groups.cbegin(); i!=groups.cend();) {
+            auto nodeKey = uint32(*i >> 32ull);
+            QueryResult nodeResult;
+            auto node = _pimpl->GetNode(nodeKey, nodeResult);
+            for (; i!=groups.cend() && uint32(*i >> 32ull) == nodeKey; ++i) {
+                auto q = size_t(*i & 0xffffffffull);
+                if (node && node->GetHeightAndNormal(cellFracs[q], heights[q], normals[q])) {
+                    heights[q] += _pimpl->_heightOffset;
+                    results[q] = QueryResult::Success;
+                } else {
+                    results[q] = node ? QueryResult::Error : nodeResult;
+                }
+            }
+        }
+    }
 
-        return false;
+    void TerrainHeightQueries::ClearCache()
+    {
+        ScopedLock(_pimpl->_cacheLock);
+        _pimpl->_cache = LRUCache<TerrainNodeHeightCollision>(_pimpl->_cacheSize);
     }
 
-}
\ No newline at end of file
+    TerrainHeightQueries::TerrainHeightQueries(
+        std::shared_ptr<ITerrainFormat> ioFormat,
+        const TerrainConfig& cfg, const TerrainCoordinateSystem& coords,
+        unsigned cacheSize)
+    {
+        _pimpl = std::make_unique<Pimpl>(cacheSize);
+        _pimpl->_ioFormat = std::move(ioFormat);
+        _pimpl->_cfg = cfg;
+        _pimpl->_worldToCell = coords.WorldToCellBased();
+        _pimpl->_heightOffset = coords.TerrainOffset()[2];
+        _pimpl->_cellDimsInNodes = cfg.CellDimensionsInNodes();
+            // the highest LOD nodes come after all of the nodes in the lower LODs (ie, 1 + 4 + 16 + ...)
+        _pimpl->_firstNodeIndex = ((1u << (2u*(cfg.CellTreeDepth()-1u))) - 1u) / 3u;
+    }
+
+    TerrainHeightQueries::~TerrainHeightQueries() {}
+
+}
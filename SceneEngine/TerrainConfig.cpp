@@ -171,6 +171,18 @@ namespace SceneEngine
                 _coverageLayers.push_back(layer);
             }
         }
+
+            //  "Heights" is the TerrainEncodingSettings::Heights value (0: QuantRange,
+            //  1: Predictive, 2: ErrorBounded)
+        auto encoding = doc.Element(u("Encoding"));
+        if (encoding) {
+            auto heights = encoding(u("Heights"), unsigned(_encodingSettings._heights));
+            if (heights <= unsigned(TerrainEncodingSettings::Heights::ErrorBounded))
+                _encodingSettings._heights = TerrainEncodingSettings::Heights(heights);
+            _encodingSettings._maxHeightError       = encoding(u("MaxHeightError"), _encodingSettings._maxHeightError);
+            _encodingSettings._errorScalePerLOD     = encoding(u("ErrorScalePerLOD"), _encodingSettings._errorScalePerLOD);
+            _encodingSettings._predictiveCoverage   = encoding(u("PredictiveCoverage"), _encodingSettings._predictiveCoverage);
+        }
     }
 
     void TerrainConfig::Write(OutputStreamFormatter& formatter) const
@@ -197,6 +209,13 @@ namespace SceneEngine
             formatter.EndElement(ele);
         }
         formatter.EndElement(covEle);
+
+        auto encodingEle = formatter.BeginElement(u("Encoding"));
+        Serialize(formatter, u("Heights"), unsigned(_encodingSettings._heights));
+        Serialize(formatter, u("MaxHeightError"), _encodingSettings._maxHeightError);
+        Serialize(formatter, u("ErrorScalePerLOD"), _encodingSettings._errorScalePerLOD);
+        Serialize(formatter, u("PredictiveCoverage"), _encodingSettings._predictiveCoverage);
+        formatter.EndElement(encodingEle);
     }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "TerrainCoverageId.h"
+#include "TerrainEncodingSettings.h"
 #include "../Assets/AssetUtils.h"
 #include "../Math/Vector.h"
 #include "../Math/Matrix.h"
@@ -71,6 +72,9 @@ namespace SceneEngine
         float       SunPathAngle() const            { return _sunPathAngle; }
         bool        EncodedGradientFlags() const    { return _encodedGradientFlags; }
 
+        const TerrainEncodingSettings& EncodingSettings() const     { return _encodingSettings; }
+        void        SetEncodingSettings(const TerrainEncodingSettings& settings) { _encodingSettings = settings; }
+
         unsigned    GetCoverageLayerCount() const;
         const CoverageLayer& GetCoverageLayer(unsigned index) const;
         void        AddCoverageLayer(const CoverageLayer& layer);
@@ -84,6 +88,7 @@ namespace SceneEngine
         float       _elementSpacing;
         float       _sunPathAngle;
         bool        _encodedGradientFlags;
+        TerrainEncodingSettings _encodingSettings;
         std::vector<CoverageLayer> _coverageLayers;
     };
 
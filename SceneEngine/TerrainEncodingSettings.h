@@ -0,0 +1,37 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+namespace SceneEngine
+{
+    /// <summary>Selects the encodings used when writing terrain cells</summary>
+    /// Heights are always quantized to 16 bit values. "QuantRange" stores those values
+    /// raw, using the full 16 bit range within each node. "Predictive" applies lossless 
+    /// predictive coding to the quantized values. "ErrorBounded" first quantizes with the
+    /// coarsest step that keeps every sample within "_maxHeightError" of the source
+    /// (before applying predictive coding). Coarser steps give much smaller residuals.
+    ///
+    /// The encoding is chosen per node. Nodes where predictive coding doesn't reduce
+    /// the size are stored raw.
+    ///
+    /// These settings are stored per terrain, in the "Encoding" element of the
+    /// TerrainConfig.
+    class TerrainEncodingSettings
+    {
+    public:
+        enum class Heights { QuantRange, Predictive, ErrorBounded };
+        Heights     _heights;
+        float       _maxHeightError;        ///< in world units, for the most detailed LOD
+        float       _errorScalePerLOD;      ///< lower LODs allow the error to grow by this factor per level
+        bool        _predictiveCoverage;    ///< lossless coding for coverage layers with 16 bit channels
+
+        TerrainEncodingSettings(
+            Heights heights = Heights::QuantRange, float maxHeightError = 0.05f, 
+            float errorScalePerLOD = 1.f, bool predictiveCoverage = false);
+    };
+}
+
@@ -7,12 +7,14 @@
 #include "TerrainFormat.h"
 #include "TerrainUberSurface.h"
 #include "TerrainScaffold.h"
+#include "TerrainNodeEncoding.h"
 #include "../RenderCore/Resource.h"
 #include "../RenderCore/Metal/Format.h"
 #include "../Assets/ChunkFile.h"
 #include "../Assets/Assets.h"
 #include "../Utility/Streams/FileUtils.h"
 #include "../Utility/PtrUtils.h"
+#include "../ConsoleRig/Log.h"
 #include "../Core/Types.h"
 
 #include <stack>
@@ -49,9 +51,17 @@ namespace SceneEngine
             enum Enum 
             {
                 None,
-                QuantRange      ///< high precision min-max range, with low precision values in between
+                QuantRange,             ///< high precision min-max range, with low precision values in between
+                Predictive,             ///< "None", with TerrainNodeEncoding::Predictive applied
+                QuantRangePredictive    ///< "QuantRange", with TerrainNodeEncoding::Predictive applied
             };
             typedef unsigned Type;
+
+            static bool HasQuantRange(Type type) { return type == QuantRange || type == QuantRangePredictive; }
+            static TerrainNodeEncoding::Enum AsNodeEncoding(Type type)
+            {
+                return (type == Predictive || type == QuantRangePredictive) ? TerrainNodeEncoding::Predictive : TerrainNodeEncoding::Raw;
+            }
         }
 
         namespace DownsampleMethod
@@ -109,11 +119,15 @@ namespace SceneEngine
             Header _hdr;
         };
 
+            //  Nodes written with the predictive encodings have header version 1. They are 
+            //  otherwise the same, but older readers will reject them (rather than misreading them)
+        static const unsigned NodeHeaderVersion_Predictive = 1;
+
         static NodeDesc LoadNodeStructure(BasicFile& file)
         {
             NodeDesc result;
             file.Read(&result._hdr, sizeof(result._hdr), 1);
-            assert(result._hdr._nodeHeaderVersion == 0);
+            assert(result._hdr._nodeHeaderVersion <= NodeHeaderVersion_Predictive);
             return result;
         }
 
@@ -175,7 +189,7 @@ namespace SceneEngine
                     for (unsigned y=0; y<(1u<<l); ++y) {
                         for (unsigned x=0; x<(1u<<l); ++x) {
                             auto loadInfo = LoadNodeStructure(file);
-                            if (loadInfo._hdr._nodeHeaderVersion != 0) {
+                            if (loadInfo._hdr._nodeHeaderVersion > NodeHeaderVersion_Predictive) {
                                 throw ::Assets::Exceptions::FormatError(
                                     "Unexpected version number in terrain node file: %s (node header version: %i)", 
                                     filename, loadInfo._hdr._nodeHeaderVersion);
@@ -183,7 +197,7 @@ namespace SceneEngine
 
                             float compressionData[2] = { 0.f, 1.f };
                             if (loadInfo._hdr._compressionDataSize) {
-                                if (loadInfo._hdr._compressionType == Compression::QuantRange && loadInfo._hdr._compressionDataSize >= (sizeof(float)*2)) {
+                                if (Compression::HasQuantRange(loadInfo._hdr._compressionType) && loadInfo._hdr._compressionDataSize >= (sizeof(float)*2)) {
                                     file.Read(compressionData, sizeof(float), 2);
                                     file.Seek(loadInfo._hdr._compressionDataSize - sizeof(float)*2, SEEK_CUR);
                                 } else {
@@ -199,7 +213,8 @@ namespace SceneEngine
 
                             auto node = std::make_unique<Node>(
                                 localToCell, loadInfo._hdr._dataOffset + heightDataChunk._fileOffset, 
-                                loadInfo._hdr._dataSize, loadInfo._hdr._dimensionsInElements);
+                                loadInfo._hdr._dataSize, loadInfo._hdr._dimensionsInElements,
+                                Compression::AsNodeEncoding(loadInfo._hdr._compressionType));
 
                             nodes.push_back(std::move(node));
                         }
@@ -255,6 +270,8 @@ namespace SceneEngine
                 file.Read(&cellDesc._hdr, sizeof(cellDesc._hdr), 1);
 
                 std::vector<unsigned> fileOffsetsBreadthFirst;
+                std::vector<unsigned> fileSizes;
+                std::vector<TerrainNodeEncoding::Enum> encodings;
         
                 {
                     //  nodes are stored as a breadth-first quad tree, starting with
@@ -264,16 +281,33 @@ namespace SceneEngine
 
                     auto nodeCount = NodeCountFromTreeDepth(cellDesc._hdr._treeDepth);
                     fileOffsetsBreadthFirst.reserve(nodeCount);
+                    fileSizes.reserve(nodeCount);
+                    encodings.reserve(nodeCount);
                     for (unsigned l=0; l<cellDesc._hdr._treeDepth; ++l) {
                         for (unsigned y=0; y<(1u<<l); ++y) {
                             for (unsigned x=0; x<(1u<<l); ++x) {
                                 auto loadInfo = LoadNodeStructure(file);
+                                if (loadInfo._hdr._compressionDataSize)
+                                    file.Seek(loadInfo._hdr._compressionDataSize, SEEK_CUR);
+
+                                auto encoding = Compression::AsNodeEncoding(loadInfo._hdr._compressionType);
                                 fileOffsetsBreadthFirst.push_back(loadInfo._hdr._dataOffset + coverageDataChunk._fileOffset);
+                                fileSizes.push_back(loadInfo._hdr._dataSize);
+                                encodings.push_back(encoding);
+
+                                    //  Encoded nodes vary in size on disk, but the decoded texture 
+                                    //  is always the same size
+                                unsigned textureByteCount = loadInfo._hdr._dataSize;
+                                if (encoding != TerrainNodeEncoding::Raw)
+                                    textureByteCount = 
+                                          loadInfo._hdr._dimensionsInElements * loadInfo._hdr._dimensionsInElements 
+                                        * Metal::BitsPerPixel(Metal::NativeFormat::Enum(loadInfo._hdr._format)) / 8;
+
                                 if (!_nodeTextureByteCount) {
-                                    _nodeTextureByteCount = loadInfo._hdr._dataSize;
+                                    _nodeTextureByteCount = textureByteCount;
                                 } else {
                                         // assert all nodes have the same size data
-                                    assert(loadInfo._hdr._dataSize == _nodeTextureByteCount);
+                                    assert(textureByteCount == _nodeTextureByteCount);
                                 }
                             }
                         }
@@ -285,6 +319,8 @@ namespace SceneEngine
                 _fieldCount = (unsigned)cellDesc._hdr._treeDepth;
                 _sourceFileName = filename;
                 _nodeFileOffsets = std::move(fileOffsetsBreadthFirst);
+                _nodeFileSizes = std::move(fileSizes);
+                _nodeEncodings = std::move(encodings);
                 _validationCallback = std::move(validationCallback);
             } 
             CATCH (const Utility::Exceptions::IOException&) { Throw(::Assets::Exceptions::InvalidAsset(filename, "Missing terrain texture")); }
@@ -314,20 +350,51 @@ namespace SceneEngine
         template<> Metal::NativeFormat::Enum AsFormat<std::pair<float, float>>()    { return Metal::NativeFormat::R32G32_FLOAT; }
         template<> Metal::NativeFormat::Enum AsFormat<std::pair<uint16, uint16>>()  { return Metal::NativeFormat::R16G16_UNORM; }       // note -- UNORM (not UINT). Required for shadow samples to work right
 
+            //  Predictive coding works on elements made from 16 bit integer channels. This returns 0 for other types
+        template<typename Element> unsigned PredictiveChannelCount()                { return 0; }
+        template<> unsigned PredictiveChannelCount<uint16>()                        { return 1; }
+        template<> unsigned PredictiveChannelCount<int16>()                         { return 1; }
+        template<> unsigned PredictiveChannelCount<std::pair<uint16, uint16>>()     { return 2; }
+
         class CoverageDataResult
         {
         public:
             std::vector<uint8> _compressionData;
             Metal::NativeFormat::Enum _nativeFormat;
             unsigned _rawDataSize;
+            Compression::Enum _compressionType;
+            float _maxError;            // largest difference between a source sample and its decoded value
 
             CoverageDataResult(
-                std::vector<uint8>&& compressionData, Metal::NativeFormat::Enum nativeFormat, unsigned rawDataSize)
+                std::vector<uint8>&& compressionData, Metal::NativeFormat::Enum nativeFormat, unsigned rawDataSize,
+                Compression::Enum compressionType, float maxError = 0.f)
             : _compressionData(std::forward<std::vector<uint8>>(compressionData))
             , _nativeFormat(nativeFormat)
-            , _rawDataSize(rawDataSize) {}
+            , _rawDataSize(rawDataSize)
+            , _compressionType(compressionType)
+            , _maxError(maxError) {}
         };
 
+            //  Writes either the raw data, or the predictive encoded data (if it's smaller). Returns
+            //  the number of bytes written and whether the data was encoded
+        static std::pair<unsigned, bool> WriteNodeData(
+            BasicFile& destinationFile, const void* rawData, unsigned rawDataSize,
+            unsigned dimensionsInElements, unsigned predictiveChannelCount)
+        {
+            if (predictiveChannelCount) {
+                auto encoded = EncodeTerrainNode(
+                    (const uint16*)rawData, UInt2(dimensionsInElements, dimensionsInElements), 
+                    predictiveChannelCount);
+                if (encoded.size() < rawDataSize) {
+                    destinationFile.Write(AsPointer(encoded.cbegin()), encoded.size(), 1);
+                    return std::make_pair(unsigned(encoded.size()), true);
+                }
+            }
+
+            destinationFile.Write(rawData, rawDataSize, 1);
+            return std::make_pair(rawDataSize, false);
+        }
+
         template<typename Element>
             Element GetValue(TerrainUberSurfaceGeneric& surf, UInt2 coord)
             {
@@ -430,7 +497,8 @@ namespace SceneEngine
             static CoverageDataResult WriteCoverageData(
                 BasicFile& destinationFile, TerrainUberSurfaceGeneric& surface,
                 unsigned startx, unsigned starty, signed downsample, unsigned dimensionsInElements,
-                const GradientFlagsSettings& gradFlagsSettings, Compression::Enum compression)
+                const GradientFlagsSettings& gradFlagsSettings, Compression::Enum compression,
+                const TerrainEncodingSettings& encodingSettings, float maxHeightError)
         {
             float minValue =  FLT_MAX;
             float maxValue = -FLT_MAX;
@@ -504,34 +572,51 @@ namespace SceneEngine
                     XlSetMemory(sampledGradientFlags.get(), 0, sizeof(uint16)*dimensionsInElements*dimensionsInElements);
                 }
 
-                auto compressedHeightData = std::make_unique<uint16[]>(dimensionsInElements*dimensionsInElements);
-                for (unsigned y=0; y<dimensionsInElements; ++y)
-                    for (unsigned x=0; x<dimensionsInElements; ++x) {
-                        auto s = AsScalar(sampledValues[y*dimensionsInElements+x]);
-                        float ch = (s - minValue) * float(compressedHeightMask) / (maxValue - minValue);
-
-                        uint16 compressedValue = (uint16)std::min(float(compressedHeightMask), std::max(0.f, ch));
-                        compressedValue |= sampledGradientFlags[y*dimensionsInElements+x];
-                        compressedHeightData[y*dimensionsInElements+x] = compressedValue;
-                    }
+                    //  With error bounded encoding, we use the coarsest quantization step that keeps
+                    //  every sample within "maxHeightError" of the source value. When the range of
+                    //  the node is too large for that, the node gets the full 16 bit precision (same
+                    //  as QuantRange), and we return the error actually achieved so the caller can
+                    //  report it. See QuantizeHeights()
+                using HeightsEncoding = TerrainEncodingSettings::Heights;
+                const bool errorBounded = encodingSettings._heights == HeightsEncoding::ErrorBounded;
+                const auto elementCount = dimensionsInElements*dimensionsInElements;
+                auto scalarValues = std::make_unique<float[]>(elementCount);
+                for (unsigned c=0; c<elementCount; ++c)
+                    scalarValues[c] = AsScalar(sampledValues[c]);
+
+                auto compressedHeightData = std::make_unique<uint16[]>(elementCount);
+                auto quantization = QuantizeHeights(
+                    compressedHeightData.get(), scalarValues.get(), elementCount,
+                    compressedHeightMask, errorBounded ? maxHeightError : 0.f);
+                for (unsigned c=0; c<elementCount; ++c)
+                    compressedHeightData[c] |= sampledGradientFlags[c];
 
                     // write all these results to the file...
                 auto rawDataSize = sizeof(uint16)*dimensionsInElements*dimensionsInElements;
-                destinationFile.Write(compressedHeightData.get(), rawDataSize, 1);
+                auto written = WriteNodeData(
+                    destinationFile, compressedHeightData.get(), unsigned(rawDataSize), dimensionsInElements,
+                    (encodingSettings._heights != HeightsEncoding::QuantRange) ? 1 : 0);
 
                 std::vector<uint8> compressionData;
                 compressionData.resize(sizeof(float)*2);
-                *(std::pair<float, float>*)AsPointer(compressionData.begin()) = std::make_pair(minValue, (maxValue - minValue) / float(compressedHeightMask));
-                return CoverageDataResult(std::move(compressionData), Metal::NativeFormat::R16_UINT, (unsigned)rawDataSize);
+                *(std::pair<float, float>*)AsPointer(compressionData.begin()) = std::make_pair(quantization._minValue, quantization._step);
+                return CoverageDataResult(
+                    std::move(compressionData), Metal::NativeFormat::R16_UINT, written.first,
+                    written.second ? Compression::QuantRangePredictive : Compression::QuantRange,
+                    quantization._maxError);
 
             } else if (compression == Compression::None) {
 
                 auto rawDataSize = sizeof(Element)*dimensionsInElements*dimensionsInElements;
-                destinationFile.Write(sampledValues.get(), rawDataSize, 1);
-                return CoverageDataResult(std::vector<uint8>(), AsFormat<Element>(), (unsigned)rawDataSize);
+                auto written = WriteNodeData(
+                    destinationFile, sampledValues.get(), unsigned(rawDataSize), dimensionsInElements,
+                    encodingSettings._predictiveCoverage ? PredictiveChannelCount<Element>() : 0);
+                return CoverageDataResult(
+                    std::vector<uint8>(), AsFormat<Element>(), written.first,
+                    written.second ? Compression::Predictive : Compression::None);
 
             } else {
-                return CoverageDataResult(std::vector<uint8>(), Metal::NativeFormat::Unknown, 0);
+                return CoverageDataResult(std::vector<uint8>(), Metal::NativeFormat::Unknown, 0, compression);
             }
         }
 
@@ -540,7 +625,8 @@ namespace SceneEngine
                 const char destinationFile[], TerrainUberSurfaceGeneric& surface, 
                 UInt2 cellMins, UInt2 cellMaxs, unsigned treeDepth, unsigned overlapElements,
                 const GradientFlagsSettings& gradFlagsSettings,
-                Compression::Enum compression, std::pair<const char*, const char*> versionInfo)
+                Compression::Enum compression, const TerrainEncodingSettings& encodingSettings,
+                std::pair<const char*, const char*> versionInfo)
         {
             using namespace Serialization::ChunkFile;
 
@@ -582,11 +668,12 @@ namespace SceneEngine
 
             unsigned heightDataOffsetIterator = 0;
             unsigned nodeIndex = 0;
+            unsigned errorBoundMisses = 0;
+            float worstErrorRatio = 0.f;
             for (unsigned l=0; l<treeDepth; ++l) {
                 for (unsigned y=0; y<(1u<<l); ++y) {
                     for (unsigned x=0; x<(1u<<l); ++x, ++nodeIndex) {
                         NodeDesc::Header nodeHdr;
-                        nodeHdr._nodeHeaderVersion = 0;
                         nodeHdr._dimensionsInElements = uniqueElementsDimension + overlapElements;
                         std::fill(nodeHdr._dummy, &nodeHdr._dummy[dimof(nodeHdr._dummy)], 0);
 
@@ -595,17 +682,27 @@ namespace SceneEngine
                         unsigned rawCoordX = cellMins[0] + x * uniqueElementsDimension * skip;
                         unsigned rawCoordY = cellMins[1] + y * uniqueElementsDimension * skip;
 
+                            //  lower LODs are viewed from further away, so they can tolerate more error
+                        float maxHeightError = encodingSettings._maxHeightError * std::pow(encodingSettings._errorScalePerLOD, float(downsample));
+
                         auto p = WriteCoverageData<Element>(
                             outputFile, surface, rawCoordX, rawCoordY,
                             downsample, uniqueElementsDimension + overlapElements, 
-                            gradFlagsSettings, compression);
+                            gradFlagsSettings, compression, encodingSettings, maxHeightError);
                         assert(p._compressionData.size() == compressionDataPerNode);
 
+                        if (p._maxError > maxHeightError) {
+                            ++errorBoundMisses;
+                            worstErrorRatio = std::max(worstErrorRatio, p._maxError / maxHeightError);
+                        }
+
                         nodeHdr._dataOffset = heightDataOffsetIterator;
                         nodeHdr._dataSize = p._rawDataSize;
                         heightDataOffsetIterator += nodeHdr._dataSize;
 
-                        nodeHdr._compressionType = compression;
+                        nodeHdr._nodeHeaderVersion = 
+                            (Compression::AsNodeEncoding(p._compressionType) != TerrainNodeEncoding::Raw) ? NodeHeaderVersion_Predictive : 0;
+                        nodeHdr._compressionType = p._compressionType;
                         nodeHdr._compressionDataSize = compressionDataPerNode;
                         nodeHdr._format = p._nativeFormat;
 
@@ -618,6 +715,14 @@ namespace SceneEngine
             assert(nodeIndex == nodeCount);
             outputFile.FinishCurrentChunk();
 
+                //  Only error bounded encoding promises to stay within the bound. For those cells,
+                //  report nodes whose height range is too large for the bound with 16 bit values
+            if (errorBoundMisses && encodingSettings._heights == TerrainEncodingSettings::Heights::ErrorBounded)
+                LogWarning 
+                    << "Terrain cell (" << destinationFile << "): height error bound exceeded in " 
+                    << errorBoundMisses << " of " << nodeCount << " nodes (worst error is " 
+                    << worstErrorRatio << "x the bound). The height range of these nodes is too large to meet the bound with 16 bit quantization.";
+
                 // go back and write the node headers in the node header chunk
             outputFile.Seek(nodeHeaderArray, SEEK_SET);
             outputFile.Write(AsPointer(nodeHeaders.begin()), nodeHeaders.size(), 1);
@@ -647,43 +752,46 @@ namespace SceneEngine
             MainTerrainFormat::WriteCellFromUberSurface<float>(
                 destinationFile, surface, 
                 cellMins, cellMaxs, treeDepth, overlapElements, _gradFlagsSettings,
-                MainTerrainFormat::Compression::QuantRange, 
+                MainTerrainFormat::Compression::QuantRange, _encodingSettings,
                 std::make_pair(VersionString, BuildDateString));
         } else if (surface.Format() == ImpliedTyping::TypeOf<ShadowSample>()) {
             MainTerrainFormat::WriteCellFromUberSurface<ShadowSample>(
                 destinationFile, surface, 
                 cellMins, cellMaxs, treeDepth, overlapElements, _gradFlagsSettings,
-                MainTerrainFormat::Compression::None, 
+                MainTerrainFormat::Compression::None, _encodingSettings,
                 std::make_pair(VersionString, BuildDateString));
         } else if (surface.Format() == ImpliedTyping::TypeOf<uint8>()) {
             MainTerrainFormat::WriteCellFromUberSurface<uint8>(
                 destinationFile, surface, 
                 cellMins, cellMaxs, treeDepth, overlapElements, _gradFlagsSettings,
-                MainTerrainFormat::Compression::None, 
+                MainTerrainFormat::Compression::None, _encodingSettings,
                 std::make_pair(VersionString, BuildDateString));
         } else if (surface.Format() == ImpliedTyping::TypeOf<uint16>()) {
             MainTerrainFormat::WriteCellFromUberSurface<uint16>(
                 destinationFile, surface, 
                 cellMins, cellMaxs, treeDepth, overlapElements, _gradFlagsSettings,
-                MainTerrainFormat::Compression::None, 
+                MainTerrainFormat::Compression::None, _encodingSettings,
                 std::make_pair(VersionString, BuildDateString));
         } else if (surface.Format() == ImpliedTyping::TypeOf<int8>()) {
             MainTerrainFormat::WriteCellFromUberSurface<int8>(
                 destinationFile, surface, 
                 cellMins, cellMaxs, treeDepth, overlapElements, _gradFlagsSettings,
-                MainTerrainFormat::Compression::None, 
+                MainTerrainFormat::Compression::None, _encodingSettings,
                 std::make_pair(VersionString, BuildDateString));
         } else if (surface.Format() == ImpliedTyping::TypeOf<int16>()) {
             MainTerrainFormat::WriteCellFromUberSurface<int16>(
                 destinationFile, surface, 
                 cellMins, cellMaxs, treeDepth, overlapElements, _gradFlagsSettings,
-                MainTerrainFormat::Compression::None, 
+                MainTerrainFormat::Compression::None, _encodingSettings,
                 std::make_pair(VersionString, BuildDateString));
         }
     }
 
-    TerrainFormat::TerrainFormat(const GradientFlagsSettings& gradFlagsSettings)
-    : _gradFlagsSettings(gradFlagsSettings) {}
+    TerrainFormat::TerrainFormat(
+        const GradientFlagsSettings& gradFlagsSettings,
+        const TerrainEncodingSettings& encodingSettings)
+    : _gradFlagsSettings(gradFlagsSettings)
+    , _encodingSettings(encodingSettings) {}
 
     TerrainFormat::~TerrainFormat() {}
 
@@ -699,5 +807,11 @@ namespace SceneEngine
         _slopeThresholds[2] = slope2Threshold;
     }
 
-}
+    TerrainEncodingSettings::TerrainEncodingSettings(
+        Heights heights, float maxHeightError, 
+        float errorScalePerLOD, bool predictiveCoverage)
+    : _heights(heights), _maxHeightError(maxHeightError)
+    , _errorScalePerLOD(errorScalePerLOD), _predictiveCoverage(predictiveCoverage)
+    {}
 
+}
@@ -8,11 +8,12 @@
 
 #include "Terrain.h"
 #include "GradientFlagSettings.h"
+#include "TerrainEncodingSettings.h"
 
 namespace SceneEngine
 {
     class TerrainUberSurfaceGeneric;
-   
+
     /// <summary>Native XLE file format for terrain</summary>
     /// XLE allows for support for multiple formats for storing
     /// terrain data using the ITerrainFormat interface. This
@@ -27,11 +28,14 @@ namespace SceneEngine
             const char destinationFile[], TerrainUberSurfaceGeneric& surface, 
             UInt2 cellMins, UInt2 cellMaxs, unsigned treeDepth, unsigned overlapElements) const;
 
-        TerrainFormat(const GradientFlagsSettings& gradFlagsSettings = GradientFlagsSettings());
+        TerrainFormat(
+            const GradientFlagsSettings& gradFlagsSettings = GradientFlagsSettings(),
+            const TerrainEncodingSettings& encodingSettings = TerrainEncodingSettings());
         ~TerrainFormat();
 
     protected:
         GradientFlagsSettings _gradFlagsSettings;
+        TerrainEncodingSettings _encodingSettings;
     };
 }
 
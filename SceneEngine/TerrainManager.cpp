@@ -240,6 +240,7 @@ namespace SceneEngine
     public:
         std::shared_ptr<TerrainCellRenderer> _renderer;
         std::shared_ptr<TerrainSurfaceHeightsProvider> _heightsProvider;
+        std::shared_ptr<TerrainHeightQueries> _heightQueries;
         std::shared_ptr<ITerrainFormat> _ioFormat;
 
         std::unique_ptr<TerrainUberHeightsSurface> _uberSurface;
@@ -496,6 +497,7 @@ namespace SceneEngine
     void TerrainManager::Reset()
     {
         _pimpl->_cells.clear();
+        _pimpl->_heightQueries.reset();
         _pimpl->_uberSurfaceInterface.reset();
         _pimpl->_uberSurface.reset();
         _pimpl->_uberSurfaceBridge.reset();
@@ -550,6 +552,7 @@ namespace SceneEngine
             cellMax = cfg._cellCount + UInt2(1,1);
 
         _pimpl->AddCells(cfg, cellMin, cellMax);
+        _pimpl->_heightQueries = std::make_shared<TerrainHeightQueries>(_pimpl->_ioFormat, _pimpl->_cfg, _pimpl->_coords);
 
         ////////////////////////////////////////////////////////////////////////////
 
@@ -918,6 +921,10 @@ namespace SceneEngine
             i._aabbMin += change;
             i._aabbMax += change;
         }
+
+            //  (the height queries cache the world to cell transform)
+        if (_pimpl->_heightQueries)
+            _pimpl->_heightQueries = std::make_shared<TerrainHeightQueries>(_pimpl->_ioFormat, _pimpl->_cfg, _pimpl->_coords);
     }
 
     void TerrainManager::SetShortCircuitSettings(const GradientFlagsSettings& gradientFlagsSettings)
@@ -930,6 +937,7 @@ namespace SceneEngine
     const TerrainCoordinateSystem&  TerrainManager::GetCoords() const               { return _pimpl->_coords; }
     HeightsUberSurfaceInterface* TerrainManager::GetHeightsInterface()              { return _pimpl->_uberSurfaceInterface.get(); }
     std::shared_ptr<ISurfaceHeightsProvider> TerrainManager::GetHeightsProvider()   { return _pimpl->_heightsProvider; }
+    std::shared_ptr<TerrainHeightQueries> TerrainManager::GetHeightQueries()        { return _pimpl->_heightQueries; }
 
     CoverageUberSurfaceInterface*   TerrainManager::GetCoverageInterface(TerrainCoverageId id)
     {
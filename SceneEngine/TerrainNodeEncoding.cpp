@@ -0,0 +1,322 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "TerrainNodeEncoding.h"
+#include "../Utility/PtrUtils.h"
+#include "../Utility/MemoryUtils.h"
+#include "../Math/Math.h"
+#include <memory>
+#include <algorithm>
+#include <emmintrin.h>
+#include <assert.h>
+
+namespace SceneEngine
+{
+        //  Predictive encoding layout:
+        //      Header
+        //      uint8 bit widths (one per block of 16 residuals)
+        //      residual blocks (each block is 16 values of "bit width" bits, so 2*width bytes)
+        //      padding (so the decoder can always read 32 bits at a time)
+        //
+        //  The predictor is "left + up - upLeft" (for each channel independently). This
+        //  predicts smooth slopes exactly, and it's linear -- so the decoder can reconstruct
+        //  each row with a prefix sum (which we can do with SIMD), rather than serially.
+    class PredictiveHeader
+    {
+    public:
+        uint16  _width, _height;
+        uint8   _channelCount;
+        uint8   _version;
+        uint16  _dummy;
+    };
+
+    static const unsigned BlockSize = 16;
+    static const unsigned TailPadding = 4;
+
+    static uint16 ZigZag(uint16 value)     { auto s = int16(value); return uint16((s << 1) ^ (s >> 15)); }
+    static uint16 UnZigZag(uint16 value)   { return uint16((value >> 1) ^ (0u - (value & 1u))); }
+
+    static unsigned BitWidth(unsigned value)
+    {
+        unsigned result = 0;
+        while (value) { ++result; value >>= 1; }
+        return result;
+    }
+
+    std::vector<uint8> EncodeTerrainNode(const uint16 elements[], UInt2 dimensions, unsigned channelCount)
+    {
+        assert(dimensions[0] && dimensions[1] && channelCount);
+        assert(dimensions[0] <= 0xffff && dimensions[1] <= 0xffff && channelCount <= 0xff);
+
+        const unsigned rowLength = dimensions[0] * channelCount;
+        const unsigned count = rowLength * dimensions[1];
+        const unsigned blockCount = (count + BlockSize - 1) / BlockSize;
+
+        std::vector<uint16> residuals(blockCount * BlockSize, 0);
+        for (unsigned y=0; y<dimensions[1]; ++y) {
+            const uint16* row = &elements[y*rowLength];
+            const uint16* prevRow = y ? &elements[(y-1)*rowLength] : nullptr;
+            for (unsigned i=0; i<rowLength; ++i) {
+                unsigned left = (i >= channelCount) ? row[i-channelCount] : 0u;
+                unsigned up = prevRow ? prevRow[i] : 0u;
+                unsigned upLeft = (prevRow && i >= channelCount) ? prevRow[i-channelCount] : 0u;
+                auto prediction = uint16(left + up - upLeft);
+                residuals[y*rowLength+i] = ZigZag(uint16(row[i] - prediction));
+            }
+        }
+
+        PredictiveHeader hdr;
+        hdr._width = uint16(dimensions[0]);
+        hdr._height = uint16(dimensions[1]);
+        hdr._channelCount = uint8(channelCount);
+        hdr._version = 0;
+        hdr._dummy = 0;
+
+        std::vector<uint8> result(sizeof(hdr) + blockCount);
+        XlCopyMemory(AsPointer(result.begin()), &hdr, sizeof(hdr));
+
+        for (unsigned b=0; b<blockCount; ++b) {
+            const uint16* block = &residuals[b*BlockSize];
+            unsigned maxValue = 0;
+            for (unsigned c=0; c<BlockSize; ++c) maxValue = std::max(maxValue, unsigned(block[c]));
+            auto width = BitWidth(maxValue);
+            result[sizeof(hdr)+b] = uint8(width);
+
+                // (16 values of "width" bits always fill exactly 2*width bytes)
+            auto blockStart = result.size();
+            result.resize(blockStart + 2*width, 0);
+            for (unsigned c=0; c<BlockSize; ++c) {
+                auto bitOffset = c*width;
+                uint32 bits = uint32(block[c]) << (bitOffset&7);
+                for (unsigned q=0; q<3 && bits; ++q, bits >>= 8)
+                    result[blockStart + (bitOffset>>3) + q] |= uint8(bits);
+            }
+        }
+
+        result.resize(result.size() + TailPadding, 0);
+        return result;
+    }
+
+    static uint32 LoadUnaligned32(const uint8* ptr) { uint32 result; XlCopyMemory(&result, ptr, sizeof(result)); return result; }
+
+        //  With a constant width, all of the shifts and offsets are known at compile time.
+        //  Unpacker<> unrolls the block so each value is just a load, shift and mask.
+    template<unsigned Width, unsigned Index>
+        struct Unpacker
+        {
+            static void Unpack(uint16 dst[], const uint8* data)
+            {
+                const uint32 mask = (1u << Width) - 1u;
+                dst[Index] = uint16((LoadUnaligned32(&data[(Index*Width)>>3]) >> ((Index*Width)&7)) & mask);
+                Unpacker<Width, Index+1>::Unpack(dst, data);
+            }
+        };
+
+    template<unsigned Width>
+        struct Unpacker<Width, BlockSize>
+        {
+            static void Unpack(uint16[], const uint8*) {}
+        };
+
+    template<unsigned Width>
+        static void UnpackBlock(uint16 dst[], const uint8* data)
+    {
+        Unpacker<Width, 0>::Unpack(dst, data);
+    }
+
+    template<> void UnpackBlock<0>(uint16 dst[], const uint8*)
+    {
+        _mm_storeu_si128((__m128i*)dst, _mm_setzero_si128());
+        _mm_storeu_si128((__m128i*)&dst[8], _mm_setzero_si128());
+    }
+
+    template<> void UnpackBlock<8>(uint16 dst[], const uint8* data)
+    {
+        auto bytes = _mm_loadu_si128((const __m128i*)data);
+        _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi8(bytes, _mm_setzero_si128()));
+        _mm_storeu_si128((__m128i*)&dst[8], _mm_unpackhi_epi8(bytes, _mm_setzero_si128()));
+    }
+
+    template<> void UnpackBlock<16>(uint16 dst[], const uint8* data)
+    {
+        XlCopyMemory(dst, data, BlockSize*sizeof(uint16));
+    }
+
+    static bool UnpackResiduals(uint16 dst[], unsigned blockCount, const uint8* widths, const uint8* data, const uint8* dataEnd)
+    {
+        using UnpackFn = void(*)(uint16[], const uint8*);
+        static const UnpackFn unpackFns[] = 
+        {
+            &UnpackBlock< 0>, &UnpackBlock< 1>, &UnpackBlock< 2>, &UnpackBlock< 3>,
+            &UnpackBlock< 4>, &UnpackBlock< 5>, &UnpackBlock< 6>, &UnpackBlock< 7>,
+            &UnpackBlock< 8>, &UnpackBlock< 9>, &UnpackBlock<10>, &UnpackBlock<11>,
+            &UnpackBlock<12>, &UnpackBlock<13>, &UnpackBlock<14>, &UnpackBlock<15>,
+            &UnpackBlock<16>
+        };
+
+        for (unsigned b=0; b<blockCount; ++b) {
+            unsigned width = widths[b];
+            if (width > 16 || size_t(dataEnd - data) < (2*width + TailPadding)) return false;
+            (*unpackFns[width])(dst, data);
+            dst += BlockSize;
+            data += 2*width;
+        }
+        return true;
+    }
+
+        //  Within a row, (value - up) is a prefix sum of the residuals (with a stride
+        //  of the channel count). So we can reconstruct 8 elements at a time with the
+        //  usual log-step scan, carrying the last channels from one group of 8 to the next.
+    template<unsigned ChannelCount> static __m128i PrefixSum(__m128i x);
+    template<unsigned ChannelCount> static __m128i BroadcastLast(__m128i x);
+
+    template<> __m128i PrefixSum<1>(__m128i x)
+    {
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+        return _mm_add_epi16(x, _mm_slli_si128(x, 8));
+    }
+
+    template<> __m128i PrefixSum<2>(__m128i x)
+    {
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+        return _mm_add_epi16(x, _mm_slli_si128(x, 8));
+    }
+
+    template<> __m128i PrefixSum<4>(__m128i x)
+    {
+        return _mm_add_epi16(x, _mm_slli_si128(x, 8));
+    }
+
+    template<> __m128i BroadcastLast<1>(__m128i x) { auto t = _mm_shufflehi_epi16(x, _MM_SHUFFLE(3,3,3,3)); return _mm_unpackhi_epi64(t, t); }
+    template<> __m128i BroadcastLast<2>(__m128i x) { return _mm_shuffle_epi32(x, _MM_SHUFFLE(3,3,3,3)); }
+    template<> __m128i BroadcastLast<4>(__m128i x) { return _mm_shuffle_epi32(x, _MM_SHUFFLE(3,2,3,2)); }
+
+    template<unsigned ChannelCount>
+        static void ReconstructRows(
+            uint16 dst[], unsigned paddedRowLength,
+            const uint16 residuals[], unsigned rowLength, unsigned rowCount)
+    {
+        const auto one = _mm_set1_epi16(1);
+        const auto zero = _mm_setzero_si128();
+        for (unsigned y=0; y<rowCount; ++y) {
+            auto* row = &dst[y*paddedRowLength];
+            const auto* prevRow = y ? &dst[(y-1)*paddedRowLength] : nullptr;
+            const auto* src = &residuals[y*rowLength];
+            auto carry = zero;
+            for (unsigned i=0; i<rowLength; i+=8) {
+                auto z = _mm_loadu_si128((const __m128i*)&src[i]);
+                auto r = _mm_xor_si128(_mm_srli_epi16(z, 1), _mm_sub_epi16(zero, _mm_and_si128(z, one)));
+                auto d = _mm_add_epi16(PrefixSum<ChannelCount>(r), carry);
+                carry = BroadcastLast<ChannelCount>(d);
+                auto up = prevRow ? _mm_load_si128((const __m128i*)&prevRow[i]) : zero;
+                _mm_store_si128((__m128i*)&row[i], _mm_add_epi16(d, up));
+            }
+        }
+    }
+
+    static void ReconstructRowsGeneric(
+        uint16 dst[], unsigned paddedRowLength,
+        const uint16 residuals[], unsigned rowLength, unsigned rowCount,
+        unsigned channelCount)
+    {
+        for (unsigned y=0; y<rowCount; ++y) {
+            auto* row = &dst[y*paddedRowLength];
+            const auto* prevRow = y ? &dst[(y-1)*paddedRowLength] : nullptr;
+            for (unsigned i=0; i<rowLength; ++i) {
+                unsigned left = (i >= channelCount) ? row[i-channelCount] : 0u;
+                unsigned up = prevRow ? prevRow[i] : 0u;
+                unsigned upLeft = (prevRow && i >= channelCount) ? prevRow[i-channelCount] : 0u;
+                row[i] = uint16(UnZigZag(residuals[y*rowLength+i]) + left + up - upLeft);
+            }
+        }
+    }
+
+    bool DecodeTerrainNode(
+        void* destination, size_t destinationSize,
+        const void* source, size_t sourceSize)
+    {
+        if (sourceSize < sizeof(PredictiveHeader)) return false;
+        PredictiveHeader hdr;
+        XlCopyMemory(&hdr, source, sizeof(hdr));
+        if (hdr._version != 0 || !hdr._channelCount) return false;
+
+        const unsigned rowLength = unsigned(hdr._width) * unsigned(hdr._channelCount);
+        const unsigned count = rowLength * unsigned(hdr._height);
+        if (destinationSize != count * sizeof(uint16)) return false;
+
+        const unsigned blockCount = (count + BlockSize - 1) / BlockSize;
+        auto* widths = PtrAdd((const uint8*)source, sizeof(hdr));
+        auto* sourceEnd = PtrAdd((const uint8*)source, sourceSize);
+        if (size_t(sourceEnd - widths) < blockCount) return false;
+
+            //  Residuals are unpacked into a temporary buffer (with space for the SIMD loop
+            //  to read past the end of the last row). Rows are reconstructed into a buffer with
+            //  16 byte aligned rows, and then copied into the destination
+        const unsigned paddedRowLength = (rowLength + 7u) & ~7u;
+        const unsigned residualCount = std::max(blockCount * BlockSize, count + 8u);
+        std::unique_ptr<uint16, PODAlignedDeletor> workingMemory(
+            (uint16*)XlMemAlign(sizeof(uint16) * (residualCount + paddedRowLength*hdr._height), 16));
+        auto* rows = workingMemory.get();
+        auto* residuals = &rows[paddedRowLength*hdr._height];
+        std::fill(&residuals[blockCount * BlockSize], &residuals[residualCount], uint16(0));
+
+        if (!UnpackResiduals(residuals, blockCount, widths, widths + blockCount, sourceEnd))
+            return false;
+
+        switch (hdr._channelCount) {
+        case 1: ReconstructRows<1>(rows, paddedRowLength, residuals, rowLength, hdr._height); break;
+        case 2: ReconstructRows<2>(rows, paddedRowLength, residuals, rowLength, hdr._height); break;
+        case 4: ReconstructRows<4>(rows, paddedRowLength, residuals, rowLength, hdr._height); break;
+        default: ReconstructRowsGeneric(rows, paddedRowLength, residuals, rowLength, hdr._height, hdr._channelCount); break;
+        }
+
+        for (unsigned y=0; y<hdr._height; ++y)
+            XlCopyMemory(
+                PtrAdd(destination, y*rowLength*sizeof(uint16)),
+                &rows[y*paddedRowLength], rowLength*sizeof(uint16));
+        return true;
+    }
+
+    HeightQuantization QuantizeHeights(
+        uint16 destination[], const float source[], size_t count,
+        unsigned mask, float maxError)
+    {
+        HeightQuantization result;
+        result._minValue = 0.f; result._step = 0.f; result._maxError = 0.f;
+        if (!count) return result;
+
+        float minValue = source[0], maxValue = source[0];
+        for (size_t c=1; c<count; ++c) {
+            minValue = std::min(minValue, source[c]);
+            maxValue = std::max(maxValue, source[c]);
+        }
+
+        const bool errorBounded = maxError > 0.f;
+        float step = (maxValue - minValue) / float(mask);
+        if (errorBounded)
+            step = std::max(step, 2.f * maxError);
+
+        float achievedError = 0.f;
+        for (size_t c=0; c<count; ++c) {
+            float q = 0.f;
+            if (step > 0.f)
+                q = errorBounded
+                    ? XlFloor((source[c] - minValue) / step + .5f)
+                    : (source[c] - minValue) * float(mask) / (maxValue - minValue);
+
+            auto quantized = (uint16)std::min(float(mask), std::max(0.f, q));
+            achievedError = std::max(achievedError, XlAbs(minValue + float(quantized) * step - source[c]));
+            destination[c] = quantized;
+        }
+
+        result._minValue = minValue;
+        result._step = step;
+        result._maxError = achievedError;
+        return result;
+    }
+}
+
@@ -0,0 +1,62 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../Math/Vector.h"
+#include "../Core/Types.h"
+#include <vector>
+
+namespace SceneEngine
+{
+    /// <summary>Encodings for the data in a single terrain node</summary>
+    /// Each node is encoded independently, so nodes can be streamed and
+    /// decoded in any order. "Raw" data is in the same layout as the texture
+    /// it will be uploaded to.
+    namespace TerrainNodeEncoding
+    {
+        enum Enum
+        {
+            Raw,
+            Predictive      ///< lossless 2D predictive coding of 16 bit channels, with variable length residuals
+        };
+    }
+
+        //  Predictive encoding works on nodes with "channelCount" interleaved 16 bit channels
+        //  (eg, 1 for height data, 2 for shadow samples). The result is self-describing, so
+        //  DecodeTerrainNode() only needs to know the size of the destination.
+    std::vector<uint8> EncodeTerrainNode(const uint16 elements[], UInt2 dimensions, unsigned channelCount);
+
+    /// <summary>Decodes the result of EncodeTerrainNode()</summary>
+    /// "destinationSize" must match the size of the raw data exactly. Returns false if the
+    /// source data is invalid or doesn't match the destination.
+    /// The decode is intended to be run on streaming threads; it is thread safe and
+    /// uses only a small amount of temporary memory.
+    bool DecodeTerrainNode(
+        void* destination, size_t destinationSize,
+        const void* source, size_t sourceSize);
+
+    /// <summary>Result of QuantizeHeights()</summary>
+    /// Heights decode as "_minValue + quantized * _step". "_maxError" is the largest difference
+    /// between a source height and its decoded value.
+    class HeightQuantization
+    {
+    public:
+        float   _minValue;
+        float   _step;
+        float   _maxError;
+    };
+
+        //  Quantizes heights to values between 0 and "mask" (inclusive). With "maxError" <= 0,
+        //  the full range of the node is spread over the quantized range. Otherwise, we use
+        //  the coarsest step that keeps every height within "maxError" of the source. That
+        //  can't be finer than the full range step; so when the range of the node is too large
+        //  the returned _maxError will be larger than "maxError", and the caller should report it.
+    HeightQuantization QuantizeHeights(
+        uint16 destination[], const float source[], size_t count,
+        unsigned mask, float maxError);
+}
+
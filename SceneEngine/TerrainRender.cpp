@@ -559,7 +559,8 @@ namespace SceneEngine
 				#endif
                 heightTile.Queue(
                     *_heightMapTileSet, cellRenderInfo._heightMapStreamingFilePtr,
-                    unsigned(sourceNode._heightMapFileOffset), unsigned(sourceNode._heightMapFileSize));
+                    unsigned(sourceNode._heightMapFileOffset), unsigned(sourceNode._heightMapFileSize),
+                    sourceNode._heightMapEncoding);
                 ++uploadsThisFrame;
 
                 _pendingUploads.push_back(UploadPair(&cellRenderInfo, n));
@@ -573,7 +574,8 @@ namespace SceneEngine
                         auto& c = cellRenderInfo._coverage[covIndex];
                         c._tiles[n].Queue(
                             *_coverageTileSet[covIndex], c._streamingFilePtr, 
-                            c._source->_nodeFileOffsets[n], c._source->_nodeTextureByteCount);
+                            c._source->_nodeFileOffsets[n], c._source->_nodeFileSizes[n],
+                            c._source->_nodeEncodings[n]);
 
                         ++uploadsThisFrame;
                         anyCoverageUploads = true;
@@ -908,8 +910,7 @@ namespace SceneEngine
 			auto& sourceNode = sourceCell._nodes[n];
 			auto nodeToCell = cellRenderInfo.NodeToCell(n);
 
-            const unsigned expectedDataSize = sourceNode->_widthInElements*sourceNode->_widthInElements*2;
-            if (sourceNode->_heightMapFileSize < expectedDataSize) {
+            if (!sourceNode->HasHeightData()) {
                     // some nodes have "holes". We have to ignore them.
                 cullResults[n - field._nodeBegin] = AABBIntersection::Culled;
             } else {
@@ -1031,8 +1032,7 @@ namespace SceneEngine
                 }
             }
             
-            const unsigned expectedDataSize = sourceNode->_widthInElements*sourceNode->_widthInElements*2;
-            if (sourceNode->_heightMapFileSize < expectedDataSize)
+            if (!sourceNode->HasHeightData())
                 continue;   // some nodes have "holes". We have to ignore them.
 
                 //  we should check for valid data & required uploads. Mark the flags now, and we'll 
@@ -1387,12 +1387,19 @@ namespace SceneEngine
 
     void TerrainCellRenderer::NodeCoverageInfo::Queue(
         TextureTileSet& coverageTileSet,
-        const void* filePtr, unsigned fileOffset, unsigned fileSize)
+        const void* filePtr, unsigned fileOffset, unsigned fileSize,
+        TerrainNodeEncoding::Enum encoding)
     {
             // the caller should check to see if we need an upload before calling this
         assert(!coverageTileSet.IsValid(_tile));
         assert(!coverageTileSet.IsValid(_pendingTile));
-        coverageTileSet.Transaction_Begin(_pendingTile, filePtr, fileOffset, fileSize);
+
+            //  Encoded nodes are decoded by the buffer uploads system, in the background
+            //  thread that reads the file
+        BufferUploads::FileDataDecoder decoder;
+        if (encoding == TerrainNodeEncoding::Predictive)
+            decoder = &DecodeTerrainNode;
+        coverageTileSet.Transaction_Begin(_pendingTile, filePtr, fileOffset, fileSize, std::move(decoder));
     }
 
     void TerrainCellRenderer::NodeCoverageInfo::EndTransactions(BufferUploads::IManager& bufferUploads)
@@ -7,6 +7,7 @@
 #include "TerrainCoverageId.h"
 #include "TextureTileSet.h"
 #include "GradientFlagSettings.h"
+#include "TerrainNodeEncoding.h"
 #include "../RenderCore/Metal/Forward.h"
 #include "../RenderCore/Metal/Buffer.h"
 #include "../RenderCore/Metal/State.h"
@@ -136,7 +137,9 @@ namespace SceneEngine
 				float _heightScale, _heightOffset;
 			#endif
 
-            void Queue(TextureTileSet& coverageTileSet, const void* filePtr, unsigned fileOffset, unsigned fileSize);
+            void Queue(
+                TextureTileSet& coverageTileSet, const void* filePtr, unsigned fileOffset, unsigned fileSize,
+                TerrainNodeEncoding::Enum encoding);
             bool CompleteUpload(BufferUploads::IManager& bufferUploads);
             void EndTransactions(BufferUploads::IManager& bufferUploads);
 
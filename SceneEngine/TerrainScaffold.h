@@ -9,6 +9,7 @@
 #include "../Assets/Assets.h"
 #include "../Core/Types.h"
 #include "../Math/Matrix.h"
+#include "TerrainNodeEncoding.h"
 #include <vector>
 #include <string>
 #include <memory>
@@ -37,7 +38,13 @@ namespace SceneEngine
             size_t      _heightMapFileOffset;
             size_t      _heightMapFileSize;
             unsigned    _widthInElements;
-            Node(const Float4x4& localToCell, size_t heightMapFileOffset, size_t heightMapFileSize, unsigned widthInElements);
+            TerrainNodeEncoding::Enum _heightMapEncoding;
+            Node(   const Float4x4& localToCell, size_t heightMapFileOffset, size_t heightMapFileSize, unsigned widthInElements,
+                    TerrainNodeEncoding::Enum heightMapEncoding = TerrainNodeEncoding::Raw);
+
+                //  The height map data is "widthInElements" squared 16 bit values once decoded. Nodes
+                //  with less data than that are "holes" in the terrain.
+            bool        HasHeightData() const;
 
                 //  Note -- hack here for 32x32 tiles!
             unsigned    GetOverlapWidth() const { return (_widthInElements==33)?1:2; }
@@ -85,7 +92,9 @@ namespace SceneEngine
 
     protected:
         std::vector<unsigned>   _nodeFileOffsets;
-        unsigned                _nodeTextureByteCount;
+        std::vector<unsigned>   _nodeFileSizes;
+        std::vector<TerrainNodeEncoding::Enum> _nodeEncodings;
+        unsigned                _nodeTextureByteCount;      ///< size of each node once decoded
         unsigned                _fieldCount;
         std::string             _sourceFileName;
 
@@ -60,7 +60,7 @@ namespace SceneEngine
             //  Load the file as a Win32 "mapped file"
             //  the format is very simple.. it's just a basic header, and then
             //  a huge 2D array of height values
-        auto mappedFile = std::make_unique<MemoryMappedFile>(filename, 0, MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Write, BasicFile::ShareMode::Read);
+        auto mappedFile = std::make_unique<MemoryMappedFile>(filename, 0, MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Write|MemoryMappedFile::Access::Random, BasicFile::ShareMode::Read);
         if (!mappedFile->IsValid())
             Throw(::Assets::Exceptions::InvalidAsset(
                 filename, "Failed while opening uber surface file"));
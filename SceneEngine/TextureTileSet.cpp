@@ -80,7 +80,9 @@ namespace SceneEngine
         return coords[0] + coords[1] * elesPerSlice[0] + coords[2] * (elesPerSlice[0] * elesPerSlice[1]);
     }
 
-    void TextureTileSet::Transaction_Begin(TextureTile& tile, const void* fileHandle, size_t offset, size_t dataSize)
+    void TextureTileSet::Transaction_Begin(
+        TextureTile& tile, const void* fileHandle, size_t offset, size_t dataSize,
+        BufferUploads::FileDataDecoder decoder)
     {
         CompleteCreation();
         if (!_resource || _resource->IsEmpty()) {
@@ -163,7 +165,8 @@ namespace SceneEngine
         const unsigned slicePitch = rowPitch * _elementSize[1];
 
         auto dataPacket = BufferUploads::CreateFileDataSource(
-            fileHandle, offset, dataSize, BufferUploads::TexturePitches(rowPitch, slicePitch));
+            fileHandle, offset, dataSize, BufferUploads::TexturePitches(rowPitch, slicePitch),
+            std::move(decoder));
         _bufferUploads->UpdateData(
             tile._transaction, dataPacket.get(),
             BufferUploads::PartialResource(destinationBox, 0, 0, address[2], address[2]));
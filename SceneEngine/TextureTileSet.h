@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../../BufferUploads/IBufferUploads.h"
+#include "../../BufferUploads/DataPacket.h"
 #include "../../RenderCore/Metal/Forward.h"
 #include "../../RenderCore/Metal/ShaderResource.h"
 #include "../../RenderCore/Metal/RenderTargetView.h"
@@ -26,7 +27,8 @@ namespace SceneEngine
     public:
         void    Transaction_Begin(
             TextureTile& tile,
-            const void* fileHandle, size_t offset, size_t dataSize);
+            const void* fileHandle, size_t offset, size_t dataSize,
+            BufferUploads::FileDataDecoder decoder = nullptr);
 
         bool    IsValid(const TextureTile& tile) const;
 
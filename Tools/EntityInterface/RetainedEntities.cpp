@@ -7,7 +7,10 @@
 #include "RetainedEntities.h"
 #include "../../Utility/StringUtils.h"
 #include "../../Utility/PtrUtils.h"
+#include "../../Utility/IteratorUtils.h"
+#include "../../Utility/MemoryUtils.h"
 #include "../../Utility/Streams/StreamFormatter.h"
+#include <unordered_set>
 
 namespace EntityInterface
 {
@@ -28,8 +31,10 @@ namespace EntityInterface
 
     auto RetainedEntities::GetObjectType(ObjectTypeId id) const -> RegisteredObjectType*
     {
-        for (auto i=_registeredObjectTypes.begin(); i!=_registeredObjectTypes.end(); ++i)
-            if (i->first == id) return &i->second;
+            // type ids are allocated in increasing order, so _registeredObjectTypes is always sorted
+        auto i = LowerBound(_registeredObjectTypes, id);
+        if (i != _registeredObjectTypes.end() && i->first == id)
+            return &i->second;
         return nullptr;
     }
 
@@ -43,8 +48,30 @@ namespace EntityInterface
 
     void RetainedEntities::InvokeOnChange(RegisteredObjectType& type, RetainedEntity& obj, ChangeType changeType) const
     {
-        for (auto i=type._onChange.begin(); i!=type._onChange.end(); ++i) {
-            (*i)(*this, Identifier(obj._doc, obj._id, obj._type), changeType);
+        if (_batchDepth) {
+                // Queue the change to be invoked at the end of the batch. Apart from
+                // Create & Delete, we only need to record a given change type once
+                // per object.
+            bool queue = true;
+            if (changeType != ChangeType::Create && changeType != ChangeType::Delete) {
+                auto* slot = GetSlot(obj._doc, obj._id);
+                if (slot) {
+                    auto bit = 1u << unsigned(changeType);
+                    queue = !(slot->_pendingChanges & bit);
+                    slot->_pendingChanges |= bit;
+                }
+            }
+
+            if (queue) {
+                PendingChange change;
+                change._id = Identifier(obj._doc, obj._id, obj._type);
+                change._changeType = changeType;
+                _pendingChanges.push_back(change);
+            }
+        } else {
+            for (auto i=type._onChange.begin(); i!=type._onChange.end(); ++i) {
+                (*i)(*this, Identifier(obj._doc, obj._id, obj._type), changeType);
+            }
         }
 
         if ((   changeType == ChangeType::SetProperty || changeType == ChangeType::ChildSetProperty 
@@ -57,59 +84,237 @@ namespace EntityInterface
                 ||  changeType == ChangeType::ChangeHierachy || changeType == ChangeType::Delete)
                 newChangeType = ChangeType::ChangeHierachy;
 
-            for (auto i=_objects.begin(); i!=_objects.end(); ++i)
-                if (i->_id == obj._parent && i->_doc == obj._doc) {
-                    auto type = GetObjectType(i->_type);
-                    if (type) 
-                        InvokeOnChange(*type, *i, newChangeType);
+            auto* parent = GetEntityInt(obj._doc, obj._parent);
+            if (parent) {
+                auto type = GetObjectType(parent->_type);
+                if (type) 
+                    InvokeOnChange(*type, *parent, newChangeType);
+            }
+        }
+    }
+
+    void RetainedEntities::BeginChangeBatch()
+    {
+        ++_batchDepth;
+    }
+
+    void RetainedEntities::EndChangeBatch()
+    {
+        assert(_batchDepth > 0);
+        if (--_batchDepth == 0)
+            FlushPendingChanges();
+    }
+
+    void RetainedEntities::FlushPendingChanges()
+    {
+        std::vector<PendingChange> changes;
+        std::swap(changes, _pendingChanges);
+
+            // Clear the merge flags before invoking any callbacks, so that changes
+            // made by the callbacks themselves will be dispatched normally
+        for (const auto& c:changes) {
+            auto* slot = GetSlot(c._id.Document(), c._id.Object());
+            if (slot) slot->_pendingChanges = 0;
+        }
+
+            // Changes to an entity that was deleted later in the same batch must not be
+            // delivered (the callbacks would see an entity that no longer exists). Walk backwards,
+            // tracking entities that are deleted after the current change. A Create ends
+            // the tracking (because changes before it belong to a previous entity with
+            // the same id)
+        std::vector<bool> dropped(changes.size(), false);
+        {
+            std::unordered_set<EntityKey, EntityKeyHash> deletedLater;
+            for (size_t c=changes.size(); c-->0;) {
+                EntityKey key(changes[c]._id.Document(), changes[c]._id.Object());
+                if (changes[c]._changeType == ChangeType::Delete) {
+                    deletedLater.insert(key);
+                } else if (changes[c]._changeType == ChangeType::Create) {
+                    deletedLater.erase(key);
+                } else {
+                    dropped[c] = deletedLater.find(key) != deletedLater.end();
                 }
+            }
+        }
+
+        for (size_t ci=0; ci<changes.size(); ++ci) {
+            if (dropped[ci]) continue;
+            const auto& c = changes[ci];
+            auto type = GetObjectType(c._id.ObjectType());
+            if (!type) continue;
+            for (auto i=type->_onChange.begin(); i!=type->_onChange.end(); ++i)
+                (*i)(*this, c._id, c._changeType);
         }
     }
 
+    size_t RetainedEntities::EntityKeyHash::operator()(const EntityKey& key) const
+    {
+        return size_t(HashCombine(key.first, key.second));
+    }
+
+    auto RetainedEntities::GetSlot(DocumentId doc, ObjectId obj) const -> Slot*
+    {
+        auto i = _keyIndex.find(EntityKey(doc, obj));
+        if (i == _keyIndex.end()) return nullptr;
+        return &_slots[i->second];
+    }
+
     auto RetainedEntities::GetEntity(DocumentId doc, ObjectId obj) const -> const RetainedEntity*
     {
-        for (auto i=_objects.begin(); i!=_objects.end(); ++i)
-            if (i->_id == obj && i->_doc == doc) {
-                return AsPointer(i);
-            }
-        return nullptr;
+        return GetEntityInt(doc, obj);
     }
 
     auto RetainedEntities::GetEntity(const Identifier& id) const -> const RetainedEntity*
     {
-        for (auto i=_objects.begin(); i!=_objects.end(); ++i)
-            if (i->_id == id.Object() && i->_doc == id.Document() && i->_type == id.ObjectType())
-                return AsPointer(i);
+        auto* result = GetEntityInt(id.Document(), id.Object());
+        if (result && result->_type == id.ObjectType())
+            return result;
         return nullptr;
     }
 
     auto RetainedEntities::GetEntityInt(DocumentId doc, ObjectId obj) const -> RetainedEntity* 
     {
-        for (auto i=_objects.begin(); i!=_objects.end(); ++i)
-            if (i->_id == obj && i->_doc == doc) {
-                return AsPointer(i);
-            }
-        return nullptr;
+        auto* slot = GetSlot(doc, obj);
+        return slot ? &slot->_entity : nullptr;
+    }
+
+    auto RetainedEntities::GetEntity(Handle handle) const -> const RetainedEntity*
+    {
+        auto slotIndex = uint32(handle);
+        auto generation = uint32(handle >> 32ull);
+        if (slotIndex >= _slots.size()) return nullptr;
+        const auto& slot = _slots[slotIndex];
+        if (!slot._alive || slot._generation != generation) return nullptr;
+        return &slot._entity;
+    }
+
+    auto RetainedEntities::GetHandle(DocumentId doc, ObjectId obj) const -> Handle
+    {
+        auto i = _keyIndex.find(EntityKey(doc, obj));
+        if (i == _keyIndex.end()) return InvalidHandle;
+        return (Handle(_slots[i->second]._generation) << 32ull) | Handle(i->second);
     }
 
     auto RetainedEntities::FindEntitiesOfType(ObjectTypeId typeId) const -> std::vector<const RetainedEntity*>
     {
         std::vector<const RetainedEntity*> result;
-        for (auto i=_objects.begin(); i!=_objects.end(); ++i)
-            if (i->_type == typeId) {
-                result.push_back(AsPointer(i));
-            }
+        auto i = LowerBound(_typeIndex, typeId);
+        if (i != _typeIndex.end() && i->first == typeId) {
+            result.reserve(i->second._slots.size() - i->second._removedCount);
+            for (auto s:i->second._slots)
+                if (s != ~0u) result.push_back(&_slots[s]._entity);
+        }
+        return std::move(result);
+    }
+
+    auto RetainedEntities::FindEntitiesInDocument(DocumentId doc) const -> std::vector<const RetainedEntity*>
+    {
+        std::vector<const RetainedEntity*> result;
+        auto i = LowerBound(_docIndex, doc);
+        if (i != _docIndex.end() && i->first == doc) {
+            result.reserve(i->second._slots.size() - i->second._removedCount);
+            for (auto s:i->second._slots)
+                if (s != ~0u) result.push_back(&_slots[s]._entity);
+        }
         return std::move(result);
     }
 
+    template<typename Id, typename List>
+        static List& GetIndexList(std::vector<std::pair<Id, List>>& lists, Id id)
+    {
+        auto i = LowerBound(lists, id);
+        if (i == lists.end() || i->first != id)
+            i = lists.insert(i, std::make_pair(id, List()));
+        return i->second;
+    }
+
+    void RetainedEntities::AddToIndexList(IndexList& list, uint32 slotIndex, uint32 Slot::*listIndex)
+    {
+        _slots[slotIndex].*listIndex = uint32(list._slots.size());
+        list._slots.push_back(slotIndex);
+    }
+
+    void RetainedEntities::RemoveFromIndexList(IndexList& list, uint32 slotIndex, uint32 Slot::*listIndex)
+    {
+            // We just mark the entry as removed, so the list remains in creation order.
+            // When enough entries are removed, we compact the list (and so the cost of
+            // compaction is amortized across the removals)
+        auto index = _slots[slotIndex].*listIndex;
+        assert(index < list._slots.size() && list._slots[index] == slotIndex);
+        list._slots[index] = ~0u;
+        ++list._removedCount;
+
+        if (list._removedCount > 32 && list._removedCount > list._slots.size()/2) {
+            auto dst = list._slots.begin();
+            for (auto src=list._slots.begin(); src!=list._slots.end(); ++src)
+                if (*src != ~0u) {
+                    _slots[*src].*listIndex = uint32(std::distance(list._slots.begin(), dst));
+                    *dst++ = *src;
+                }
+            list._slots.erase(dst, list._slots.end());
+            list._removedCount = 0;
+        }
+    }
+
+    uint32 RetainedEntities::AllocateSlot(RetainedEntity&& entity)
+    {
+        uint32 slotIndex;
+        if (!_freeSlots.empty()) {
+            slotIndex = _freeSlots.back();
+            _freeSlots.pop_back();
+        } else {
+            slotIndex = uint32(_slots.size());
+            _slots.emplace_back();
+        }
+
+        auto& slot = _slots[slotIndex];
+        assert(!slot._alive);
+        slot._entity = std::move(entity);
+        slot._alive = true;
+        slot._pendingChanges = 0;
+
+        _keyIndex.insert(std::make_pair(EntityKey(slot._entity._doc, slot._entity._id), slotIndex));
+        AddToIndexList(GetIndexList(_typeIndex, slot._entity._type), slotIndex, &Slot::_typeListIndex);
+        AddToIndexList(GetIndexList(_docIndex, slot._entity._doc), slotIndex, &Slot::_docListIndex);
+        return slotIndex;
+    }
+
+    void RetainedEntities::ReleaseSlot(uint32 slotIndex)
+    {
+        auto& slot = _slots[slotIndex];
+        assert(slot._alive);
+        RemoveFromIndexList(GetIndexList(_typeIndex, slot._entity._type), slotIndex, &Slot::_typeListIndex);
+        RemoveFromIndexList(GetIndexList(_docIndex, slot._entity._doc), slotIndex, &Slot::_docListIndex);
+        _keyIndex.erase(EntityKey(slot._entity._doc, slot._entity._id));
+
+        slot._entity = RetainedEntity();
+        slot._alive = false;
+        slot._pendingChanges = 0;
+        ++slot._generation;     // invalidates any handles to this slot
+        _freeSlots.push_back(slotIndex);
+    }
+
+    static uint64 HashTypeName(const utf8 name[])
+    {
+            // type names are case insensitive, so hash the lower case form
+        std::basic_string<utf8> lower(name);
+        for (auto& c:lower) c = XlToLower(c);
+        return Hash64(AsPointer(lower.cbegin()), AsPointer(lower.cend()));
+    }
+
     ObjectTypeId RetainedEntities::GetTypeId(const utf8 name[]) const
     {
-        for (auto i=_registeredObjectTypes.cbegin(); i!=_registeredObjectTypes.cend(); ++i)
-            if (!XlCompareStringI(i->second._name.c_str(), name))
-                return i->first;
+        auto hash = HashTypeName(name);
+        auto i = LowerBound(_typeNameIndex, hash);
+        for (auto q=i; q!=_typeNameIndex.end() && q->first == hash; ++q) {
+            auto type = GetObjectType(q->second);
+            if (type && !XlCompareStringI(type->_name.c_str(), name))
+                return q->second;
+        }
         
         _registeredObjectTypes.push_back(
             std::make_pair(_nextObjectTypeId, RegisteredObjectType(name)));
+        _typeNameIndex.insert(i, std::make_pair(hash, _nextObjectTypeId));
         return _nextObjectTypeId++;
     }
 
@@ -152,10 +357,15 @@ namespace EntityInterface
     {
         _nextObjectTypeId = 1;
         _nextObjectId = 1;
+        _batchDepth = 0;
     }
 
     RetainedEntities::~RetainedEntities() {}
 
+    RetainedEntities::Slot::Slot()
+    : _generation(1), _typeListIndex(~0u), _docListIndex(~0u), _pendingChanges(0), _alive(false)
+    {}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
     RetainedEntity::RetainedEntity() {}
@@ -196,8 +406,7 @@ namespace EntityInterface
         auto type = _scene->GetObjectType(id.ObjectType());
         if (!type) return false;
 
-        for (auto i=_scene->_objects.cbegin(); i!=_scene->_objects.cend(); ++i)
-            if (i->_doc == id.Document() && i->_id == id.Object()) return false;
+        if (_scene->GetSlot(id.Document(), id.Object())) return false;
 
         RetainedEntity newObject;
         newObject._doc = id.Document();
@@ -208,26 +417,26 @@ namespace EntityInterface
         for (size_t c=0; c<initializerCount; ++c)
             _scene->SetSingleProperties(newObject, *type, initializers[c]);
 
-        _scene->_objects.push_back(std::move(newObject));
+        auto slotIndex = _scene->AllocateSlot(std::move(newObject));
 
-        _scene->InvokeOnChange(*type, _scene->_objects[_scene->_objects.size()-1], RetainedEntities::ChangeType::Create);
+        _scene->InvokeOnChange(*type, _scene->_slots[slotIndex]._entity, RetainedEntities::ChangeType::Create);
         return true;
     }
 
 	bool RetainedEntityInterface::DeleteObject(const Identifier& id)
     {
-        for (auto i=_scene->_objects.begin(); i!=_scene->_objects.end(); ++i)
-            if (i->_doc == id.Document() && i->_id == id.Object()) {
-                assert(i->_type == id.ObjectType());
-                RetainedEntity copy(std::move(*i));
-                _scene->_objects.erase(i);
+        auto i = _scene->_keyIndex.find(RetainedEntities::EntityKey(id.Document(), id.Object()));
+        if (i == _scene->_keyIndex.end()) return false;
 
-                auto type = _scene->GetObjectType(id.ObjectType());
-                if (type)
-                    _scene->InvokeOnChange(*type, copy, RetainedEntities::ChangeType::Delete);
-                return true;
-            }
-        return false;
+        auto slotIndex = i->second;
+        assert(_scene->_slots[slotIndex]._entity._type == id.ObjectType());
+        RetainedEntity copy(std::move(_scene->_slots[slotIndex]._entity));
+        _scene->ReleaseSlot(slotIndex);
+
+        auto type = _scene->GetObjectType(id.ObjectType());
+        if (type)
+            _scene->InvokeOnChange(*type, copy, RetainedEntities::ChangeType::Delete);
+        return true;
     }
 
 	bool RetainedEntityInterface::SetProperty(
@@ -237,18 +446,16 @@ namespace EntityInterface
         auto type = _scene->GetObjectType(id.ObjectType());
         if (!type) return false;
 
-        for (auto i=_scene->_objects.begin(); i!=_scene->_objects.end(); ++i)
-            if (i->_doc == id.Document() && i->_id == id.Object()) {
-                bool gotChange = false;
-                for (size_t c=0; c<initializerCount; ++c) {
-                    auto& prop = initializers[c];
-                    gotChange |= _scene->SetSingleProperties(*i, *type, prop);
-                }
-                if (gotChange) _scene->InvokeOnChange(*type, *i, RetainedEntities::ChangeType::SetProperty);
-                return true;
-            }
+        auto* obj = _scene->GetEntityInt(id.Document(), id.Object());
+        if (!obj) return false;
 
-        return false;
+        bool gotChange = false;
+        for (size_t c=0; c<initializerCount; ++c) {
+            auto& prop = initializers[c];
+            gotChange |= _scene->SetSingleProperties(*obj, *type, prop);
+        }
+        if (gotChange) _scene->InvokeOnChange(*type, *obj, RetainedEntities::ChangeType::SetProperty);
+        return true;
     }
 
 	bool RetainedEntityInterface::GetProperty(const Identifier& id, PropertyId prop, void* dest, unsigned* destSize) const
@@ -259,16 +466,14 @@ namespace EntityInterface
 
         const auto& propertyName = type->_properties[prop-1];
 
-        for (auto i=_scene->_objects.begin(); i!=_scene->_objects.end(); ++i)
-            if (i->_doc == id.Document() && i->_id == id.Object()) {
-                auto res = i->_properties.GetParameter<unsigned>(propertyName.c_str());
-                if (res.first) {
-                    *(unsigned*)dest = res.second;
-                }
-                return true;
-            }
+        auto* obj = _scene->GetEntityInt(id.Document(), id.Object());
+        if (!obj) return false;
 
-        return false;
+        auto res = obj->_properties.GetParameter<unsigned>(propertyName.c_str());
+        if (res.first) {
+            *(unsigned*)dest = res.second;
+        }
+        return true;
     }
 
     bool RetainedEntityInterface::SetParent(
@@ -287,10 +492,14 @@ namespace EntityInterface
         if (childObj->_parent != 0) {
             auto* oldParent = _scene->GetEntityInt(child.Document(), childObj->_parent);
             if (oldParent) {
-                auto i = std::find(oldParent->_children.begin(), oldParent->_children.end(), child.Object());
-                oldParent->_children.erase(i);
-
-                auto oldParentType = _scene->GetObjectType(parent.ObjectType());
+                    // search from the back, because recently added children are the
+                    // most likely to be removed again
+                auto& children = oldParent->_children;
+                auto i = std::find(children.rbegin(), children.rend(), child.Object());
+                if (i != children.rend())
+                    children.erase((i+1).base());
+
+                auto oldParentType = _scene->GetObjectType(oldParent->_type);
                 if (oldParentType)
                     _scene->InvokeOnChange(
                         *oldParentType, *oldParent, 
@@ -11,6 +11,8 @@
 #include "../../Assets/Assets.h"        // for rstring
 #include <string>
 #include <vector>
+#include <deque>
+#include <unordered_map>
 #include <functional>
 
 namespace Utility { template<typename Type> class InputStreamFormatter; }
@@ -45,12 +47,35 @@ namespace EntityInterface
     ///
     /// All of the properties and data related to that object will be available in
     /// the callback.
+    ///
+    /// Entities are stored in a slot map indexed by (DocumentId, ObjectId). Entity
+    /// pointers and handles remain valid until the entity is deleted (creating
+    /// other entities will not move existing ones). A handle can be safely tested
+    /// after the entity is destroyed (GetEntity(Handle) will just return null).
+    ///
+    /// Per-type and per-document lists are maintained, so FindEntitiesOfType()
+    /// and FindEntitiesInDocument() only visit the matching entities. Results are
+    /// in creation order.
+    ///
+    /// When making many changes at once (eg, while loading a document) use
+    /// ChangeBatch (or BeginChangeBatch() / EndChangeBatch()). Within a batch,
+    /// callbacks are queued and then invoked when the outermost batch ends.
+    /// Repeated notifications of the same type for the same object are merged
+    /// (except for Create and Delete). So, for example, when adding 1000 children to
+    /// a parent, the parent will receive just a single AddChild callback.
     class RetainedEntities
     {
     public:
+        using Handle = uint64;
+        static const Handle InvalidHandle = 0;
+
         const RetainedEntity* GetEntity(DocumentId doc, ObjectId obj) const;
         const RetainedEntity* GetEntity(const Identifier&) const;
+        const RetainedEntity* GetEntity(Handle handle) const;
+        Handle GetHandle(DocumentId doc, ObjectId obj) const;
+
         std::vector<const RetainedEntity*> FindEntitiesOfType(ObjectTypeId typeId) const;
+        std::vector<const RetainedEntity*> FindEntitiesInDocument(DocumentId doc) const;
 
         enum class ChangeType 
         {
@@ -86,11 +111,57 @@ namespace EntityInterface
 
         std::basic_string<utf8> GetTypeName(ObjectTypeId id) const;
 
+        void BeginChangeBatch();
+        void EndChangeBatch();
+
+        class ChangeBatch
+        {
+        public:
+            ChangeBatch(RetainedEntities& entities) : _entities(&entities) { _entities->BeginChangeBatch(); }
+            ~ChangeBatch() { _entities->EndChangeBatch(); }
+        private:
+            RetainedEntities* _entities;
+            ChangeBatch(const ChangeBatch&);
+            ChangeBatch& operator=(const ChangeBatch&);
+        };
+
         RetainedEntities();
         ~RetainedEntities();
     protected:
         mutable ObjectId _nextObjectId;
-        mutable std::vector<RetainedEntity> _objects;
+
+        class Slot
+        {
+        public:
+            RetainedEntity  _entity;
+            uint32          _generation;
+            uint32          _typeListIndex;
+            uint32          _docListIndex;
+            uint32          _pendingChanges;    // bit per ChangeType queued in the current batch
+            bool            _alive;
+
+            Slot();
+        };
+        mutable std::deque<Slot> _slots;
+        mutable std::vector<uint32> _freeSlots;
+
+        using EntityKey = std::pair<DocumentId, ObjectId>;
+        class EntityKeyHash
+        {
+        public:
+            size_t operator()(const EntityKey& key) const;
+        };
+        mutable std::unordered_map<EntityKey, uint32, EntityKeyHash> _keyIndex;
+
+        class IndexList
+        {
+        public:
+            std::vector<uint32> _slots;         // ~0u marks removed entries
+            unsigned _removedCount;
+            IndexList() : _removedCount(0) {}
+        };
+        mutable std::vector<std::pair<ObjectTypeId, IndexList>> _typeIndex;
+        mutable std::vector<std::pair<DocumentId, IndexList>> _docIndex;
 
         class RegisteredObjectType
         {
@@ -104,14 +175,31 @@ namespace EntityInterface
             RegisteredObjectType(const std::basic_string<utf8>& name) : _name(name) {}
         };
         mutable std::vector<std::pair<ObjectTypeId, RegisteredObjectType>> _registeredObjectTypes;
+        mutable std::vector<std::pair<uint64, ObjectTypeId>> _typeNameIndex;
 
         mutable ObjectTypeId _nextObjectTypeId;
 
+        class PendingChange
+        {
+        public:
+            Identifier  _id;
+            ChangeType  _changeType;
+        };
+        unsigned _batchDepth;
+        mutable std::vector<PendingChange> _pendingChanges;
+
         RegisteredObjectType* GetObjectType(ObjectTypeId id) const;
         void InvokeOnChange(RegisteredObjectType& type, RetainedEntity& obj, ChangeType changeType) const;
+        void FlushPendingChanges();
         RetainedEntity* GetEntityInt(DocumentId doc, ObjectId obj) const;
+        Slot* GetSlot(DocumentId doc, ObjectId obj) const;
         bool SetSingleProperties(RetainedEntity& dest, const RegisteredObjectType& type, const PropertyInitializer& initializer) const;
 
+        uint32 AllocateSlot(RetainedEntity&& entity);
+        void ReleaseSlot(uint32 slotIndex);
+        void AddToIndexList(IndexList& list, uint32 slotIndex, uint32 Slot::*listIndex);
+        void RemoveFromIndexList(IndexList& list, uint32 slotIndex, uint32 Slot::*listIndex);
+
         friend class RetainedEntityInterface;
     };
 
@@ -226,11 +226,13 @@ namespace GUILayer
             IntersectionTestSceneWrapper^ testScene,
             float worldX, float worldY)
         {
-            auto& terrain = *testScene->GetNative().GetTerrain();
-            height = SceneEngine::GetTerrainHeight(
-                *terrain.GetFormat().get(), terrain.GetConfig(), terrain.GetCoords(),
-                Float2(worldX, worldY));
-            return true;
+            auto heightQueries = testScene->GetNative().GetTerrain()->GetHeightQueries();
+            float nativeHeight = 0.f;
+            auto queryResult = heightQueries 
+                ? heightQueries->QueryHeight(Float2(worldX, worldY), nativeHeight)
+                : SceneEngine::TerrainHeightQueries::QueryResult::OutsideTerrain;
+            height = nativeHeight;
+            return queryResult == SceneEngine::TerrainHeightQueries::QueryResult::Success;
         }
 
         static bool GetTerrainHeightAndNormal(
@@ -238,16 +240,15 @@ namespace GUILayer
             IntersectionTestSceneWrapper^ testScene,
             float worldX, float worldY)
         {
-            auto& terrain = *testScene->GetNative().GetTerrain();
-            Float3 nativeNormal;
-            float nativeHeight;
-            bool queryResult = SceneEngine::GetTerrainHeightAndNormal(
-                nativeHeight, nativeNormal,
-                *terrain.GetFormat().get(), terrain.GetConfig(), terrain.GetCoords(),
-                Float2(worldX, worldY));
+            auto heightQueries = testScene->GetNative().GetTerrain()->GetHeightQueries();
+            Float3 nativeNormal(0.f, 0.f, 1.f);
+            float nativeHeight = 0.f;
+            auto queryResult = heightQueries 
+                ? heightQueries->QueryHeightAndNormal(Float2(worldX, worldY), nativeHeight, nativeNormal)
+                : SceneEngine::TerrainHeightQueries::QueryResult::OutsideTerrain;
             height = nativeHeight;
             normal = AsVector3(nativeNormal);
-            return queryResult;
+            return queryResult == SceneEngine::TerrainHeightQueries::QueryResult::Success;
         }
 
         static bool GetTerrainUnderCursor(
@@ -454,7 +455,7 @@ namespace GUILayer
             ToolsRig::GenerateCellFiles(
                 cfg->GetNative(), 
                 clix::marshalString<clix::E_UTF8>(uberSurfaceDir).c_str(), 
-                overwriteExisting, gradFlagSettings, nativeProgress.get());
+                overwriteExisting, gradFlagSettings, cfg->GetNative().EncodingSettings(), nativeProgress.get());
         }
 
         static void GenerateCellFiles(
@@ -52,7 +52,7 @@ namespace GUILayer
 		void Render(
 			Metal::DeviceContext& devContext,
 			ParsingContext& parserContext,
-			Metal::ConstantBufferPacket localTransform,
+			const Float4x4& localToWorld,
 			unsigned techniqueIndex, const ::Assets::ResChar techniqueConfig[],
 			const ParameterBox& materialParams) const;
 
@@ -68,6 +68,8 @@ namespace GUILayer
 		TechniqueMaterial _material;
 		unsigned _vbStride;
 		Metal::NativeFormat::Enum _ibFormat;
+		Float4x4 _geoSpaceToNodeSpace;		// (for quantized vertex positions)
+		Float4 _texCoordScaleOffset;		// (for quantized texture coordinates)
 		::Assets::DepValPtr _depVal;
 
 		void Build(const RenderCore::Assets::RawGeometry& geo, const ::Assets::ResChar filename[], unsigned largeBlocksOffset);
@@ -76,12 +78,17 @@ namespace GUILayer
 	void SimpleModel::Render(
 		Metal::DeviceContext& devContext,
 		ParsingContext& parserContext,
-		Metal::ConstantBufferPacket localTransform,
+		const Float4x4& localToWorld,
 		unsigned techniqueIndex, const ::Assets::ResChar techniqueConfig[],
 		const ParameterBox& materialParams) const
 	{
 		auto shader = _material.FindVariation(parserContext, techniqueIndex, techniqueConfig);
 		if (shader._shader._shaderProgram) {
+			auto localTransformConstants = MakeLocalTransform(
+				Combine(_geoSpaceToNodeSpace, localToWorld), 
+				ExtractTranslation(parserContext.GetProjectionDesc()._cameraToWorld));
+			localTransformConstants._texCoordScaleOffset = _texCoordScaleOffset;
+			auto localTransform = MakeSharedPkt(localTransformConstants);
 			auto matParams0 = shader._cbLayout->BuildCBDataAsPkt(materialParams);
 			Float3 col0 = Float3(.66f, 0.2f, 0.f);
 			Float3 col1 = Float3(0.44f, 0.6f, 0.1f);
@@ -117,6 +124,8 @@ namespace GUILayer
 	}
 
 	SimpleModel::SimpleModel(const ::Assets::ResChar filename[])
+	: _geoSpaceToNodeSpace(Identity<Float4x4>())
+	, _texCoordScaleOffset(1.f, 1.f, 0.f, 0.f)
 	{
 		auto& scaffold = ::Assets::GetAssetComp<RenderCore::Assets::ModelScaffold>(filename);
 		if (scaffold.ImmutableData()._geoCount > 0)
@@ -133,6 +142,8 @@ namespace GUILayer
 		_drawCalls.insert(_drawCalls.begin(), geo._drawCalls.cbegin(), geo._drawCalls.cend());
 		_vbStride = geo._vb._ia._vertexStride;
 		_ibFormat = Metal::NativeFormat::Enum(geo._ib._format);
+		_geoSpaceToNodeSpace = geo._geoSpaceToNodeSpace;
+		_texCoordScaleOffset = geo._texCoordScaleOffset;
 
 		// also construct a technique material for the geometry format
 		std::vector<Metal::InputElementDesc> eles;
@@ -226,6 +237,7 @@ namespace GUILayer
 	{
 	public:
 		Metal::ConstantBufferPacket _localTransform;
+		Float4x4					_localToWorld;
 		ParameterBox				_matParams;
 
 		ObjectParams(const RetainedEntity& obj, ParsingContext& parserContext, bool directionalTransform = false)
@@ -236,6 +248,7 @@ namespace GUILayer
 				auto translation = ExtractTranslation(trans);
 				trans = MakeObjectToWorld(-Normalize(translation), Float3(0.f, 0.f, 1.f), translation);
 			}
+			_localToWorld = trans;
 			_localTransform = MakeLocalTransformPacket(
 				trans, ExtractTranslation(parserContext.GetProjectionDesc()._cameraToWorld));
 
@@ -252,7 +265,7 @@ namespace GUILayer
     {
 		CATCH_ASSETS_BEGIN
 			auto& asset = ::Assets::GetAssetDep<SimpleModel>("game/model/simple/spherestandin.dae");
-			asset.Render(devContext, parserContext, params._localTransform, techniqueIndex, technique, params._matParams);
+			asset.Render(devContext, parserContext, params._localToWorld, techniqueIndex, technique, params._matParams);
 			return;
 		CATCH_ASSETS_END(parserContext)
 
@@ -271,7 +284,7 @@ namespace GUILayer
 	{
 		CATCH_ASSETS_BEGIN
 			auto& asset = ::Assets::GetAssetDep<SimpleModel>("game/model/simple/pointerstandin.dae");
-		asset.Render(devContext, parserContext, params._localTransform, techniqueIndex, technique, params._matParams);
+		asset.Render(devContext, parserContext, params._localToWorld, techniqueIndex, technique, params._matParams);
 		return;
 		CATCH_ASSETS_END(parserContext)
 
@@ -34,6 +34,39 @@ namespace GUILayer
     float TerrainConfig::SunPathAngle::get() { return _native->SunPathAngle(); }
     bool TerrainConfig::EncodedGradientFlags::get() { return _native->EncodedGradientFlags(); }
 
+    unsigned TerrainConfig::HeightsEncoding::get() { return unsigned(_native->EncodingSettings()._heights); }
+    void TerrainConfig::HeightsEncoding::set(unsigned value)
+    {
+        if (value > unsigned(SceneEngine::TerrainEncodingSettings::Heights::ErrorBounded)) return;
+        auto settings = _native->EncodingSettings();
+        settings._heights = SceneEngine::TerrainEncodingSettings::Heights(value);
+        _native->SetEncodingSettings(settings);
+    }
+
+    float TerrainConfig::MaxHeightError::get() { return _native->EncodingSettings()._maxHeightError; }
+    void TerrainConfig::MaxHeightError::set(float value)
+    {
+        auto settings = _native->EncodingSettings();
+        settings._maxHeightError = value;
+        _native->SetEncodingSettings(settings);
+    }
+
+    float TerrainConfig::HeightErrorScalePerLOD::get() { return _native->EncodingSettings()._errorScalePerLOD; }
+    void TerrainConfig::HeightErrorScalePerLOD::set(float value)
+    {
+        auto settings = _native->EncodingSettings();
+        settings._errorScalePerLOD = value;
+        _native->SetEncodingSettings(settings);
+    }
+
+    bool TerrainConfig::PredictiveCoverage::get() { return _native->EncodingSettings()._predictiveCoverage; }
+    void TerrainConfig::PredictiveCoverage::set(bool value)
+    {
+        auto settings = _native->EncodingSettings();
+        settings._predictiveCoverage = value;
+        _native->SetEncodingSettings(settings);
+    }
+
     unsigned TerrainConfig::CoverageLayerCount::get() { return _native->GetCoverageLayerCount(); }
     TerrainConfig::CoverageLayerDesc^ TerrainConfig::GetCoverageLayer(unsigned index)
     {
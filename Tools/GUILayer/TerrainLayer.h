@@ -53,6 +53,12 @@ namespace GUILayer
         property float SunPathAngle { float get(); }
         property bool EncodedGradientFlags { bool get(); }
 
+            //  Encoding used when generating cell files (see SceneEngine::TerrainEncodingSettings)
+        property unsigned HeightsEncoding { unsigned get(); void set(unsigned); }
+        property float MaxHeightError { float get(); void set(float); }
+        property float HeightErrorScalePerLOD { float get(); void set(float); }
+        property bool PredictiveCoverage { bool get(); void set(bool); }
+
         property unsigned CoverageLayerCount { unsigned get(); }
         CoverageLayerDesc^ GetCoverageLayer(unsigned index);
         void Add(CoverageLayerDesc^ layer);
@@ -467,6 +467,11 @@ namespace ToolsRig
                 if (transformMarker < meshToModel._skeletonOutputCount)
                     toModel = meshToModel._skeletonOutput[transformMarker];
 
+                    // quantized positions must be transformed back into node space first
+                    // (this transform is always just a uniform scale and translation)
+                toModel = Combine(rawGeo._geoSpaceToNodeSpace, toModel);
+                const float geoSpaceScale = rawGeo._geoSpaceToNodeSpace(0,0);
+
                 auto vbStart = model.LargeBlocksOffset() + rawGeo._vb._offset;
                 auto vbEnd = vbStart + rawGeo._vb._size;
                 auto vertexCount = rawGeo._vb._size / rawGeo._vb._ia._vertexStride;
@@ -510,7 +515,7 @@ namespace ToolsRig
                 std::vector<unsigned> remapping;
                 auto newSource = RemoveDuplicates(
                     remapping, stream.GetSourceData(), 
-                    stream.GetVertexMap(), duplicatesThreshold);
+                    stream.GetVertexMap(), duplicatesThreshold / geoSpaceScale);
 
                 mesh.RemoveStream(posElement);
                 posElement = mesh.AddStream(newSource, std::move(remapping), "POSITION", 0);
@@ -523,6 +528,7 @@ namespace ToolsRig
 
                 const auto& pStream = mesh.GetStreams()[posElement];
                 const auto& nStream = mesh.GetStreams()[nEle];
+                const bool octahedralNormals = nStream.GetSourceData().GetFormat() == Metal::NativeFormat::R16G16_SNORM;
                 std::vector<std::pair<unsigned, unsigned>> pn;
                 pn.reserve(mesh.GetUnifiedVertexCount());
                 for (unsigned q=0; q<mesh.GetUnifiedVertexCount(); ++q)
@@ -542,7 +548,9 @@ namespace ToolsRig
 
                     auto n = Zero<Float3>();
                     for (auto q=p; q<p2; ++q)
-                        n += GetVertex<Float3>(nStream.GetSourceData(), q->second);
+                        n += octahedralNormals
+                            ? DecodeOctahedral(GetVertex<Float2>(nStream.GetSourceData(), q->second))
+                            : GetVertex<Float3>(nStream.GetSourceData(), q->second);
                     n = Normalize(n);
                     auto baseSamplePoint = GetVertex<Float3>(pStream.GetSourceData(), p->first);
 
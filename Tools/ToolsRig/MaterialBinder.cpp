@@ -346,10 +346,12 @@ namespace ToolsRig
             mat._constants, sysConstants, 
             UInt2(unsigned(currentViewport.Width), unsigned(currentViewport.Height)));
             
+        auto localTransform = Techniques::MakeLocalTransform(
+            sysConstants._objectToWorld, ExtractTranslation(parsingContext.GetProjectionDesc()._cameraToWorld));
+        localTransform._texCoordScaleOffset = sysConstants._texCoordScaleOffset;
+
         std::vector<RenderCore::Metal::ConstantBufferPacket> constantBufferPackets;
-        constantBufferPackets.push_back(
-            Techniques::MakeLocalTransformPacket(
-                sysConstants._objectToWorld, ExtractTranslation(parsingContext.GetProjectionDesc()._cameraToWorld)));
+        constantBufferPackets.push_back(MakeSharedPkt(localTransform));
         boundLayout.BindConstantBuffer(Techniques::ObjectCB::LocalTransform, 0, 1);
         for (auto i=materialConstants.cbegin(); i!=materialConstants.cend(); ++i) {
             boundLayout.BindConstantBuffer(i->first, unsigned(constantBufferPackets.size()), 1);
@@ -371,5 +373,6 @@ namespace ToolsRig
         _lightNegativeDirection = Float3(0.f, 0.f, 1.f);
         _lightColour = Float3(1.f, 1.f, 1.f);
         _objectToWorld = Identity<Float4x4>();
+        _texCoordScaleOffset = Float4(1.f, 1.f, 0.f, 0.f);
     }
 }
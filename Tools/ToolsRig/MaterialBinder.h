@@ -35,6 +35,7 @@ namespace ToolsRig
             Float3      _lightNegativeDirection;
             Float3      _lightColour;
             Float4x4    _objectToWorld;
+            Float4      _texCoordScaleOffset;
             SystemConstants();
         };
 
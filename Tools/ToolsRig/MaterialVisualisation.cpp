@@ -290,6 +290,8 @@ namespace ToolsRig
                 } else {
                     sysContants._objectToWorld = Identity<Float4x4>();
                 }
+                sysContants._objectToWorld = Combine(rawGeo._geoSpaceToNodeSpace, sysContants._objectToWorld);   // (dequantize positions)
+                sysContants._texCoordScaleOffset = rawGeo._texCoordScaleOffset;
 
                 auto shaderProgram = _object->_materialBinder->Apply(
                     metalContext, parserContext, techniqueIndex,
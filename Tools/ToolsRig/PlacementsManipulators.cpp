@@ -167,9 +167,9 @@ namespace ToolsRig
             float terrainHeight = 0.f;
             auto terrain = hitTestScene.GetTerrain().get();
             if (terrain) {
-                terrainHeight = GetTerrainHeight(
-                    *terrain->GetFormat().get(), terrain->GetConfig(), terrain->GetCoords(), 
-                    finalXY);
+                auto heightQueries = terrain->GetHeightQueries();
+                if (heightQueries)
+                    heightQueries->QueryHeight(finalXY, terrainHeight);
             }
             
             transform = AsFloat4x4(Float3(-ExtractTranslation(inputObj._localToWorld) + Expand(finalXY, terrainHeight)));
@@ -1199,17 +1199,20 @@ namespace ToolsRig
             //  Now add new placements for all of these pts.
             //  We need to clamp them to the terrain surface as we do this
 
-        for (auto p=noisyPts.begin(); p!=noisyPts.end(); ++p) {
-            Float2 pt = *p + Truncate(centre);
-            float height = 0.f;
-            auto terrain = hitTestScene.GetTerrain().get();
-            if (terrain) {
-                height = SceneEngine::GetTerrainHeight(
-                    *terrain->GetFormat().get(), terrain->GetConfig(), terrain->GetCoords(), pt);
-            }
+        for (auto& p:noisyPts) p += Truncate(centre);
+        std::vector<float> heights(noisyPts.size(), 0.f);
 
-            _spawnPositions.push_back(Expand(pt, height));
+        auto terrain = hitTestScene.GetTerrain().get();
+        auto heightQueries = terrain ? terrain->GetHeightQueries() : nullptr;
+        if (heightQueries) {
+                // (failed queries get a height of 0)
+            std::vector<SceneEngine::TerrainHeightQueries::QueryResult> results(noisyPts.size());
+            heightQueries->QueryHeights(
+                MakeIteratorRange(noisyPts), MakeIteratorRange(heights), MakeIteratorRange(results));
         }
+
+        for (size_t c=0; c<noisyPts.size(); ++c)
+            _spawnPositions.push_back(Expand(noisyPts[c], heights[c]));
     }
 
     void ScatterPlacements::PerformScatter(
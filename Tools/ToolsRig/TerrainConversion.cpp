@@ -90,9 +90,10 @@ namespace ToolsRig
         const ::Assets::ResChar uberSurfaceDir[],
         bool overwriteExisting,
         const GradientFlagsSettings& gradFlagSettings,
+        const TerrainEncodingSettings& encodingSettings,
         ConsoleRig::IProgress* progress)
     {
-        auto outputIOFormat = std::make_shared<TerrainFormat>(gradFlagSettings);
+        auto outputIOFormat = std::make_shared<TerrainFormat>(gradFlagSettings, encodingSettings);
         assert(outputIOFormat);
 
         //////////////////////////////////////////////////////////////////////////////////////
@@ -171,7 +172,8 @@ namespace ToolsRig
         auto layerIndex = FindLayer(outputConfig, coverageId);
         if (layerIndex == ~0u) return;
 
-        auto outputIOFormat = std::make_shared<TerrainFormat>();
+            //  (gradient flags only apply to the heights, so they aren't needed here)
+        auto outputIOFormat = std::make_shared<TerrainFormat>(GradientFlagsSettings(), outputConfig.EncodingSettings());
         assert(outputIOFormat);
 
         ::Assets::ResChar layerUberSurface[MaxPath];
@@ -579,7 +581,7 @@ namespace ToolsRig
             if (dstType != ImpliedTyping::TypeCat::Float)
                 Throw(::Exceptions::BasicLabel("Attempting to load float format input into non-float destination (%s)", op._sourceFile.c_str()));
 
-            MemoryMappedFile inputFileData(op._sourceFile.c_str(), 0, MemoryMappedFile::Access::Read);
+            MemoryMappedFile inputFileData(op._sourceFile.c_str(), 0, MemoryMappedFile::Access::Read|MemoryMappedFile::Access::Sequential);
             if (!inputFileData.IsValid())
                 Throw(::Exceptions::BasicLabel("Couldn't open input file (%s)", op._sourceFile.c_str()));
 
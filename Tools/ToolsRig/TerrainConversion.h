@@ -65,6 +65,7 @@ namespace ToolsRig
         const ::Assets::ResChar uberSurfaceDir[],
         bool overwriteExisting,
         const SceneEngine::GradientFlagsSettings& gradFlagSettings,
+        const SceneEngine::TerrainEncodingSettings& encodingSettings,
         ConsoleRig::IProgress* progress = nullptr);
 
     void GenerateCellFiles(
@@ -0,0 +1,267 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../RenderCore/Assets/MeshDatabase.h"
+#include "../Math/Vector.h"
+#include "../Math/Matrix.h"
+#include "../Math/Math.h"
+#include "../Utility/MemoryUtils.h"
+#include <CppUnitTest.h>
+#include <vector>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    using namespace RenderCore::Assets::GeoProc;
+    namespace NativeFormat = RenderCore::Metal::NativeFormat;
+
+    template<typename Type>
+        static void AddStream(MeshDatabase& mesh, const std::vector<Type>& values, NativeFormat::Enum format, const char semantic[])
+    {
+        mesh.AddStream(
+            CreateRawDataSource(
+                AsPointer(values.cbegin()), AsPointer(values.cend()),
+                values.size(), sizeof(Type), format),
+            std::vector<unsigned>(), semantic, 0);
+    }
+
+    static Float3 RandomUnitVector(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> d(-1.f, 1.f);
+        for (;;) {
+            Float3 v(d(rng), d(rng), d(rng));
+            auto magSq = MagnitudeSquared(v);
+            if (magSq > 1e-3f && magSq <= 1.f) return v / XlSqrt(magSq);
+        }
+    }
+
+    static float AngleBetween(Float3 lhs, Float3 rhs)
+    {
+        return XlATan2(Magnitude(Cross(lhs, rhs)), Dot(lhs, rhs));
+    }
+
+    static NativeFormat::Enum StreamFormat(const MeshDatabase& mesh, const char semantic[])
+    {
+        return mesh.GetStreams()[mesh.FindElement(semantic)].GetSourceData().GetFormat();
+    }
+
+        //  A mesh with every kind of stream that can be quantized. The positions are
+        //  well away from the origin, like a building in a large scene
+    static MeshDatabase MakeTestMesh(
+        unsigned vertexCount,
+        std::vector<Float3>& positions, std::vector<Float3>& normals,
+        std::vector<Float4>& tangents, std::vector<Float2>& texCoords)
+    {
+        std::mt19937 rng(0x50);
+        std::uniform_real_distribution<float> px(-40.f, 25.f), py(1000.f, 1012.f), pz(-3.f, 60.f), t(0.f, 1.f);
+        positions.clear(); normals.clear(); tangents.clear(); texCoords.clear();
+        for (unsigned v=0; v<vertexCount; ++v) {
+            positions.push_back(Float3(px(rng), py(rng), pz(rng)));
+            normals.push_back(RandomUnitVector(rng));
+            tangents.push_back(Expand(RandomUnitVector(rng), (v&1) ? -1.f : 1.f));
+            texCoords.push_back(Float2(t(rng), t(rng)));
+        }
+
+        MeshDatabase mesh;
+        AddStream(mesh, positions, NativeFormat::R32G32B32_FLOAT, "POSITION");
+        AddStream(mesh, normals, NativeFormat::R32G32B32_FLOAT, "NORMAL");
+        AddStream(mesh, tangents, NativeFormat::R32G32B32A32_FLOAT, "TEXTANGENT");
+        AddStream(mesh, texCoords, NativeFormat::R32G32_FLOAT, "TEXCOORD");
+        return mesh;
+    }
+
+	TEST_CLASS(AttributeQuantization)
+	{
+	public:
+		TEST_METHOD(OctahedralEncoding)
+		{
+            std::mt19937 rng(0x48);
+            for (unsigned c=0; c<10000; ++c) {
+                auto n = RandomUnitVector(rng);
+                auto e = EncodeOctahedral(n);
+                Assert::IsTrue(XlAbs(e[0]) <= 1.f && XlAbs(e[1]) <= 1.f);
+                Assert::IsTrue(AngleBetween(DecodeOctahedral(e), n) < 1e-3f);
+            }
+
+                //  the axes (and the seams of the octahedron) must survive exactly
+            const Float3 axes[] = { Float3(1,0,0), Float3(-1,0,0), Float3(0,1,0), Float3(0,-1,0), Float3(0,0,1), Float3(0,0,-1) };
+            for (const auto& a:axes)
+                Assert::IsTrue(MagnitudeSquared(Float3(DecodeOctahedral(EncodeOctahedral(a)) - a)) < 1e-10f);
+        }
+
+        TEST_METHOD(RoundTripErrors)
+        {
+            std::vector<Float3> positions, normals;
+            std::vector<Float4> tangents;
+            std::vector<Float2> texCoords;
+            auto mesh = MakeTestMesh(20000, positions, normals, tangents, texCoords);
+
+            auto result = QuantizeVertexStreams(mesh, QuantizationSettings());
+            Assert::AreEqual(size_t(4), result._streams.size());
+            for (const auto& s:result._streams) Assert::IsTrue(s._quantized);
+
+            Assert::IsTrue(StreamFormat(mesh, "POSITION") == NativeFormat::R16G16B16A16_UNORM);
+            Assert::IsTrue(StreamFormat(mesh, "NORMAL") == NativeFormat::R16G16_SNORM);
+            Assert::IsTrue(StreamFormat(mesh, "TEXTANGENT") == NativeFormat::R16G16_SNORM);
+            Assert::IsTrue(StreamFormat(mesh, "TEXCOORD") == NativeFormat::R16G16_UNORM);
+
+                //  Decode each vertex the same way the shaders do, and check the errors against
+                //  the theoretical bounds. The largest extent of the mesh is 65 units, so the
+                //  positions should be within half a quantization step on each axis
+            const float positionBound = 65.f / 65535.f * .5f * XlSqrt(3.f) * 1.01f;
+            const float normalBound = Deg2Rad(.02f);
+            const float tangentBound = Deg2Rad(.04f);
+            auto posEle = mesh.FindElement("POSITION"), normalEle = mesh.FindElement("NORMAL");
+            auto tangentEle = mesh.FindElement("TEXTANGENT"), texCoordEle = mesh.FindElement("TEXCOORD");
+            float maxPositionError = 0.f;
+            for (unsigned v=0; v<mesh.GetUnifiedVertexCount(); ++v) {
+                auto q = mesh.GetUnifiedElement<Float3>(v, posEle);
+                Assert::IsTrue(q[0] >= 0.f && q[0] <= 1.f && q[1] >= 0.f && q[1] <= 1.f && q[2] >= 0.f && q[2] <= 1.f);
+                auto p = Truncate(result._geoSpaceToNodeSpace * Expand(q, 1.f));
+                float positionError = Magnitude(Float3(p - positions[v]));
+                Assert::IsTrue(positionError <= positionBound);
+                maxPositionError = std::max(maxPositionError, positionError);
+
+                auto n = DecodeOctahedral(mesh.GetUnifiedElement<Float2>(v, normalEle));
+                Assert::IsTrue(AngleBetween(n, normals[v]) <= normalBound);
+
+                auto t = mesh.GetUnifiedElement<Float2>(v, tangentEle);
+                auto tangent = DecodeOctahedral(Float2(t[0], XlAbs(t[1]) * 2.f - 1.f));
+                Assert::IsTrue(AngleBetween(tangent, Truncate(tangents[v])) <= tangentBound);
+                Assert::AreEqual(tangents[v][3], (t[1] < 0.f) ? -1.f : 1.f);
+
+                    //  (texture coordinates are remapped onto their range in the mesh, which is within [0, 1])
+                auto tc = mesh.GetUnifiedElement<Float2>(v, texCoordEle);
+                tc = Float2(
+                    tc[0] * result._texCoordScaleOffset[0] + result._texCoordScaleOffset[2],
+                    tc[1] * result._texCoordScaleOffset[1] + result._texCoordScaleOffset[3]);
+                Assert::IsTrue(XlAbs(tc[0] - texCoords[v][0]) <= .5f / 65535.f + 1e-6f);
+                Assert::IsTrue(XlAbs(tc[1] - texCoords[v][1]) <= .5f / 65535.f + 1e-6f);
+            }
+
+                //  the measured errors reported should match what we found
+            Assert::IsTrue(XlAbs(result._streams[0]._maxError - maxPositionError) < 1e-4f);
+            Assert::IsTrue(result._streams[1]._maxError <= normalBound);
+            Assert::IsTrue(result._streams[2]._maxError <= tangentBound);
+        }
+
+        TEST_METHOD(ToleranceFallback)
+        {
+            std::vector<Float3> positions, normals;
+            std::vector<Float4> tangents;
+            std::vector<Float2> texCoords;
+            auto mesh = MakeTestMesh(1000, positions, normals, tangents, texCoords);
+
+                //  Streams that exceed the tolerance must be left exactly as they were
+            QuantizationSettings settings;
+            settings._positionTolerance = 1e-6f;
+            settings._texCoords = false;
+            auto result = QuantizeVertexStreams(mesh, settings);
+            Assert::AreEqual(size_t(3), result._streams.size());
+            Assert::IsFalse(result._streams[0]._quantized);
+            Assert::IsTrue(Equivalent(result._geoSpaceToNodeSpace, Identity<Float4x4>(), 1e-6f));
+            Assert::IsTrue(StreamFormat(mesh, "POSITION") == NativeFormat::R32G32B32_FLOAT);
+            Assert::IsTrue(StreamFormat(mesh, "NORMAL") == NativeFormat::R16G16_SNORM);
+            Assert::IsTrue(StreamFormat(mesh, "TEXCOORD") == NativeFormat::R32G32_FLOAT);
+            auto posEle = mesh.FindElement("POSITION");
+            for (unsigned v=0; v<mesh.GetUnifiedVertexCount(); ++v)
+                Assert::IsTrue(MagnitudeSquared(Float3(mesh.GetUnifiedElement<Float3>(v, posEle) - positions[v])) == 0.f);
+        }
+
+        TEST_METHOD(TexCoordRanges)
+        {
+                //  TEXCOORD0 is remapped onto its range in the mesh (with the scale and offset
+                //  returned in the result). Other texture coordinates can only use the normalized
+                //  formats if they already fit.
+            MeshDatabase mesh;
+            std::vector<Float2> tiledTexCoords { Float2(-2.f, 0.f), Float2(4.f, .5f), Float2(4.f, 3.f) };
+            std::vector<Float2> signedTexCoords { Float2(-.5f, 0.f), Float2(1.f, -1.f), Float2(0.f, .25f) };
+            std::vector<Float2> tiledTexCoords2 { Float2(0.f, 0.f), Float2(4.f, 0.f), Float2(4.f, 4.f) };
+            AddStream(mesh, tiledTexCoords, NativeFormat::R32G32_FLOAT, "TEXCOORD");
+            mesh.AddStream(
+                CreateRawDataSource(
+                    AsPointer(signedTexCoords.cbegin()), AsPointer(signedTexCoords.cend()),
+                    signedTexCoords.size(), sizeof(Float2), NativeFormat::R32G32_FLOAT),
+                std::vector<unsigned>(), "TEXCOORD", 1);
+            mesh.AddStream(
+                CreateRawDataSource(
+                    AsPointer(tiledTexCoords2.cbegin()), AsPointer(tiledTexCoords2.cend()),
+                    tiledTexCoords2.size(), sizeof(Float2), NativeFormat::R32G32_FLOAT),
+                std::vector<unsigned>(), "TEXCOORD", 2);
+            auto result = QuantizeVertexStreams(mesh, QuantizationSettings());
+            Assert::IsTrue(mesh.GetStreams()[0].GetSourceData().GetFormat() == NativeFormat::R16G16_UNORM);
+            Assert::IsTrue(mesh.GetStreams()[1].GetSourceData().GetFormat() == NativeFormat::R16G16_SNORM);
+            Assert::IsTrue(mesh.GetStreams()[2].GetSourceData().GetFormat() == NativeFormat::R32G32_FLOAT);
+            Assert::IsTrue(Equivalent(result._texCoordScaleOffset, Float4(6.f, 3.f, -2.f, 0.f), 1e-6f));
+            for (unsigned v=0; v<3; ++v) {
+                auto tc = mesh.GetUnifiedElement<Float2>(v, 0);
+                tc = Float2(
+                    tc[0] * result._texCoordScaleOffset[0] + result._texCoordScaleOffset[2],
+                    tc[1] * result._texCoordScaleOffset[1] + result._texCoordScaleOffset[3]);
+                Assert::IsTrue(XlAbs(tc[0] - tiledTexCoords[v][0]) <= 6.f * .5f / 65535.f + 1e-6f);
+                Assert::IsTrue(XlAbs(tc[1] - tiledTexCoords[v][1]) <= 3.f * .5f / 65535.f + 1e-6f);
+
+                tc = mesh.GetUnifiedElement<Float2>(v, 1);
+                Assert::IsTrue(XlAbs(tc[0] - signedTexCoords[v][0]) <= .5f / 32767.f + 1e-7f);
+                Assert::IsTrue(XlAbs(tc[1] - signedTexCoords[v][1]) <= .5f / 32767.f + 1e-7f);
+            }
+        }
+
+        TEST_METHOD(VertexBufferSize)
+        {
+            std::vector<Float3> positions, normals;
+            std::vector<Float4> tangents;
+            std::vector<Float2> texCoords;
+            auto mesh = MakeTestMesh(100, positions, normals, tangents, texCoords);
+            const NativeVBSettings vbSettings = { true };
+            auto originalLayout = BuildDefaultLayout(mesh, vbSettings);
+
+            QuantizeVertexStreams(mesh, QuantizationSettings());
+            auto quantizedLayout = BuildDefaultLayout(mesh, vbSettings);
+            Assert::AreEqual(28u, originalLayout._vertexStride);
+            Assert::AreEqual(20u, quantizedLayout._vertexStride);
+
+                //  The pre-encoded streams must be copied into the vertex buffer unchanged
+            auto vb = mesh.BuildNativeVertexBuffer(quantizedLayout);
+            Assert::AreEqual(size_t(100 * 20), vb.size());
+            const auto& normalSource = mesh.GetStreams()[mesh.FindElement("NORMAL")].GetSourceData();
+            for (unsigned v=0; v<100; ++v)
+                Assert::IsTrue(XlCompareMemory(
+                    PtrAdd(vb.get(), v * 20 + quantizedLayout._elements[1]._alignedByteOffset),
+                    PtrAdd(normalSource.GetData(), v * 4), 4) == 0);
+        }
+
+        TEST_METHOD(SkinningWeights)
+        {
+            std::mt19937 rng(0x77);
+            std::uniform_real_distribution<float> w(0.f, 1.f);
+            for (unsigned c=0; c<10000; ++c) {
+                float weights[4];
+                unsigned count = 1 + (c % 4);
+                float total = 0.f;
+                for (unsigned q=0; q<count; ++q) { weights[q] = w(rng); total += weights[q]; }
+
+                uint8 quantized[4];
+                QuantizeWeights(quantized, weights, count);
+                unsigned sum = 0;
+                for (unsigned q=0; q<count; ++q) {
+                    sum += quantized[q];
+                    Assert::IsTrue(XlAbs(float(quantized[q]) - weights[q] / total * 255.f) < 1.f);
+                }
+                Assert::AreEqual(255u, sum);
+            }
+
+                //  equal thirds can't be represented exactly, but must still sum to 255
+            const float thirds[] = { 1.f, 1.f, 1.f };
+            uint8 quantized[3];
+            QuantizeWeights(quantized, thirds, 3);
+            Assert::AreEqual(255u, unsigned(quantized[0]) + unsigned(quantized[1]) + unsigned(quantized[2]));
+        }
+    };
+}
+
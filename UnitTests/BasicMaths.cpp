@@ -7,8 +7,11 @@
 #include "../Math/Transformations.h"
 #include "../Math/ProjectionMath.h"
 #include "../Math/Geometry.h"
+#include "../Math/RectanglePacking.h"
 #include <CppUnitTest.h>
 #include <random>
+#include <vector>
+#include <algorithm>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -175,5 +178,63 @@ namespace UnitTests
             }
         }
 
+        TEST_METHOD(RectanglePackerChurn)
+        {
+            using Rectangle = RectanglePacker_Guillotine::Rectangle;
+            auto overlaps = 
+                [](const Rectangle& lhs, const Rectangle& rhs)
+                {
+                    return !(lhs.second[0] <= rhs.first[0] || lhs.second[1] <= rhs.first[1]
+                        || lhs.first[0] >= rhs.second[0] || lhs.first[1] >= rhs.second[1]);
+                };
+            auto checkLive = 
+                [&overlaps](const std::vector<Rectangle>& live, const RectanglePacker_Guillotine& packer)
+                {
+                    unsigned area = 0;
+                    for (auto i=live.begin(); i!=live.end(); ++i) {
+                        Assert::IsTrue(i->second[0] <= packer.TotalSize()[0] && i->second[1] <= packer.TotalSize()[1]);
+                        for (auto i2=i+1; i2!=live.end(); ++i2)
+                            Assert::IsFalse(overlaps(*i, *i2));
+                        area += (i->second[0] - i->first[0]) * (i->second[1] - i->first[1]);
+                    }
+                    Assert::AreEqual(packer.TotalSize()[0] * packer.TotalSize()[1], area + packer.FreeArea());
+                };
+
+            std::mt19937 rng(0x2718);
+            RectanglePacker_Guillotine packer(UInt2(512, 512));
+            std::vector<Rectangle> live;
+            for (unsigned c=0; c<10000; ++c) {
+                if (live.empty() || (rng()%3) != 0) {
+                    auto rect = packer.Allocate(UInt2(1 + rng()%40, 1 + rng()%40));
+                    if (rect.second[0] > rect.first[0]) live.push_back(rect);
+                } else {
+                    auto i = live.begin() + rng()%live.size();
+                    packer.Deallocate(*i);
+                    *i = live.back();
+                    live.pop_back();
+                }
+
+                if ((c%1000) == 0) {
+                    checkLive(live, packer);
+
+                        // Moves from compaction should refer to live rectangles, and 
+                        // leave everything valid once applied
+                    auto moves = packer.PlanCompaction(16);
+                    for (const auto& m:moves) {
+                        auto i = std::find(live.begin(), live.end(), m._from);
+                        Assert::IsTrue(i != live.end());
+                        *i = m._to;
+                    }
+                    checkLive(live, packer);
+                }
+            }
+
+                //  With everything freed, all of the free space should be merged 
+                //  back into a single rectangle
+            for (const auto& r:live) packer.Deallocate(r);
+            Assert::IsTrue(packer.LargestFreeBlock().first == UInt2(512, 512));
+            Assert::AreEqual(0.f, packer.Fragmentation());
+        }
+
 	};
 }
\ No newline at end of file
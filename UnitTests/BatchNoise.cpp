@@ -0,0 +1,130 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../Math/Noise.h"
+#include <CppUnitTest.h>
+#include <vector>
+#include <random>
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    template<typename Type>
+        static std::vector<Type> MakeRandomPositions(unsigned count, float range)
+    {
+        std::mt19937 rng(0x46);
+        std::uniform_real_distribution<float> dist(-range, range);
+        std::vector<Type> result(count);
+        for (auto& p:result)
+            for (unsigned c=0; c<p.size(); ++c) p[c] = dist(rng);
+        return result;
+    }
+
+        //  Evaluate every batched function for one set of positions, with all of the
+        //  results concatenated
+    template<typename Type>
+        static std::vector<float> EvaluateAllBatched(const std::vector<Type>& positions)
+    {
+        using namespace XLEMath;
+        const auto count = positions.size();
+        std::vector<float> result(count * 4);
+        SimplexNoise(&result[0], positions.data(), count);
+        SimplexFBM(&result[count], positions.data(), count, 16.f, .5f, 2.f, 5);
+        SimplexRidgedFBM(&result[count*2], positions.data(), count, 16.f, .5f, 2.f, 5);
+        SimplexWarpedFBM(&result[count*3], positions.data(), count, 16.f, .5f, 2.f, 5, 4.f);
+        return result;
+    }
+
+    template<typename Type>
+        static void CheckBatchMatchesSinglePoint()
+    {
+            //  The count isn't a multiple of the chunk size or the lane count, so the
+            //  padding at the end of the last chunk is tested, also.
+        using namespace XLEMath;
+        auto positions = MakeRandomPositions<Type>(1037, 200.f);
+        std::vector<float> noise(positions.size()), fbm(positions.size());
+        SimplexNoise(noise.data(), positions.data(), positions.size());
+        SimplexFBM(fbm.data(), positions.data(), positions.size(), 16.f, .5f, 2.f, 5);
+        for (size_t c=0; c<positions.size(); ++c) {
+                // (allowing for fast floating point optimisations in the single point version)
+            Assert::AreEqual(SimplexNoise(positions[c]), noise[c], 1e-4f);
+            Assert::AreEqual(SimplexFBM(positions[c], 16.f, .5f, 2.f, 5), fbm[c], 1e-4f);
+            Assert::IsTrue(noise[c] >= -1.f && noise[c] <= 1.f);
+        }
+    }
+
+    template<typename Type>
+        static void CheckInstructionSetsMatch()
+    {
+        using namespace XLEMath;
+        auto positions = MakeRandomPositions<Type>(517, 200.f);
+        Assert::IsTrue(SetNoiseInstructionSet(NoiseInstructionSet::SSE2));
+        auto sse2 = EvaluateAllBatched(positions);
+        if (SetNoiseInstructionSet(NoiseInstructionSet::AVX2)) {
+            auto avx2 = EvaluateAllBatched(positions);
+            Assert::IsTrue(sse2 == avx2);
+        }
+        SetNoiseInstructionSet(NoiseInstructionSet::Best);
+    }
+
+	TEST_CLASS(BatchNoise)
+	{
+	public:
+		TEST_METHOD(BatchMatchesSinglePoint)
+		{
+            CheckBatchMatchesSinglePoint<Float2>();
+            CheckBatchMatchesSinglePoint<Float3>();
+            CheckBatchMatchesSinglePoint<Float4>();
+        }
+
+        TEST_METHOD(InstructionSetsMatchExactly)
+        {
+                //  SSE2 and AVX2 do the same operations in the same order, so the results
+                //  must be bit-identical (the AVX2 part is skipped on CPUs without it)
+            CheckInstructionSetsMatch<Float2>();
+            CheckInstructionSetsMatch<Float3>();
+            CheckInstructionSetsMatch<Float4>();
+        }
+
+        TEST_METHOD(RidgedAndWarpedFBM)
+        {
+            using namespace XLEMath;
+            auto positions = MakeRandomPositions<Float3>(300, 100.f);
+            const unsigned octaves = 5;
+            const float gain = .5f;
+            std::vector<float> noise(positions.size()), ridged(positions.size()), warped(positions.size());
+            SimplexRidgedFBM(ridged.data(), positions.data(), positions.size(), 16.f, gain, 2.f, octaves);
+
+                //  With one octave, the ridged version is just (1-|noise|)^2
+            std::vector<float> ridged1(positions.size());
+            std::vector<Float3> scaled(positions.size());
+            for (size_t c=0; c<positions.size(); ++c) scaled[c] = Float3(positions[c] * (1.f/16.f));
+            SimplexNoise(noise.data(), scaled.data(), scaled.size());
+            SimplexRidgedFBM(ridged1.data(), positions.data(), positions.size(), 16.f, gain, 2.f, 1);
+            float maxRidged = 0.f;
+            for (unsigned c=0; c<octaves; ++c) maxRidged += std::pow(gain, float(c));
+            for (size_t c=0; c<positions.size(); ++c) {
+                float expected = (1.f - XlAbs(noise[c])) * (1.f - XlAbs(noise[c]));
+                Assert::AreEqual(expected, ridged1[c], 1e-4f);
+                Assert::IsTrue(ridged[c] >= 0.f && ridged[c] <= maxRidged);
+            }
+
+                //  With no warping, the warped version is the same as plain FBM. Otherwise it
+                //  should be different, but still deterministic
+            std::vector<float> fbm(positions.size()), warped2(positions.size());
+            SimplexFBM(fbm.data(), positions.data(), positions.size(), 16.f, gain, 2.f, octaves);
+            SimplexWarpedFBM(warped.data(), positions.data(), positions.size(), 16.f, gain, 2.f, octaves, 0.f);
+            Assert::IsTrue(fbm == warped);
+            SimplexWarpedFBM(warped.data(), positions.data(), positions.size(), 16.f, gain, 2.f, octaves, 8.f);
+            SimplexWarpedFBM(warped2.data(), positions.data(), positions.size(), 16.f, gain, 2.f, octaves, 8.f);
+            Assert::IsTrue(warped == warped2);
+            Assert::IsTrue(fbm != warped);
+        }
+    };
+}
+
@@ -0,0 +1,264 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../RenderCore/Assets/DrawCallClusters.h"
+#include "../RenderCore/Metal/DeviceContext.h"
+#include "../Math/Transformations.h"
+#include "../Math/ProjectionMath.h"
+#include <CppUnitTest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <tuple>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    using namespace RenderCore::Assets;
+
+    class BoxMesh
+    {
+    public:
+        std::vector<Float3> _positions;
+        std::vector<uint32> _indices;
+        std::vector<DrawCallDesc> _drawCalls;
+    };
+
+        //  A large box, with each face divided into a grid of quads (like a building that
+        //  has been tessellated for lighting). Triangles are counter clockwise when looking
+        //  from outside. The first 3 faces are in the first draw call, and the rest in the second.
+    static BoxMesh MakeBox(float size, unsigned gridDim)
+    {
+        const Float3 faces[6][3] = {
+            { Float3(0.f, 0.f, 0.f),  Float3(0.f, 1.f, 0.f), Float3(1.f, 0.f, 0.f) },
+            { Float3(0.f, 0.f, 1.f),  Float3(1.f, 0.f, 0.f), Float3(0.f, 1.f, 0.f) },
+            { Float3(0.f, 0.f, 0.f),  Float3(0.f, 0.f, 1.f), Float3(0.f, 1.f, 0.f) },
+            { Float3(1.f, 0.f, 0.f),  Float3(0.f, 1.f, 0.f), Float3(0.f, 0.f, 1.f) },
+            { Float3(0.f, 0.f, 0.f),  Float3(1.f, 0.f, 0.f), Float3(0.f, 0.f, 1.f) },
+            { Float3(0.f, 1.f, 0.f),  Float3(0.f, 0.f, 1.f), Float3(1.f, 0.f, 0.f) }
+        };
+
+        BoxMesh result;
+        for (unsigned f=0; f<6; ++f) {
+            if (f == 0 || f == 3)
+                result._drawCalls.push_back(
+                    DrawCallDesc(unsigned(result._indices.size()), 0, 0, unsigned(result._drawCalls.size()), RenderCore::Metal::Topology::TriangleList));
+
+            auto base = unsigned(result._positions.size());
+            for (unsigned y=0; y<=gridDim; ++y)
+                for (unsigned x=0; x<=gridDim; ++x)
+                    result._positions.push_back(size * (faces[f][0] + (float(x) / float(gridDim)) * faces[f][1] + (float(y) / float(gridDim)) * faces[f][2]));
+            for (unsigned y=0; y<gridDim; ++y)
+                for (unsigned x=0; x<gridDim; ++x) {
+                    auto a = base + y*(gridDim+1) + x;
+                    uint32 quad[] = { a, a+1, a+gridDim+1, a+gridDim+1, a+1, a+gridDim+2 };
+                    result._indices.insert(result._indices.end(), quad, &quad[dimof(quad)]);
+                }
+            result._drawCalls.back()._indexCount = unsigned(result._indices.size()) - result._drawCalls.back()._firstIndex;
+        }
+        return result;
+    }
+
+    static Float4x4 MakeWorldToProjection(const Float3& position, const Float3& forward, float verticalHalfFOV)
+    {
+        auto cameraToWorld = MakeCameraToWorld(forward, Float3(0.f, 0.f, 1.f), position);
+        auto projection = PerspectiveProjection(
+            verticalHalfFOV, 16.f/9.f, 0.1f, 5000.f,
+            GeometricCoordinateSpace::RightHanded, ClipSpaceType::Positive);
+        return Combine(InvertOrthonormalTransform(cameraToWorld), projection);
+    }
+
+    static bool IsInRanges(unsigned index, const std::vector<std::pair<unsigned, unsigned>>& ranges)
+    {
+        for (const auto& r:ranges)
+            if (index >= r.first && index < (r.first + r.second)) return true;
+        return false;
+    }
+
+        //  True if the triangle can't produce any pixels (ie, it's back facing or entirely
+        //  outside of one of the clipping planes)
+    static bool IsTriangleInvisible(const Float3 tri[3], const Float4x4& worldToProjection, const Float3& view)
+    {
+        auto normal = Cross(Float3(tri[1] - tri[0]), Float3(tri[2] - tri[0]));
+        if (Dot(normal, Float3(tri[0] - view)) >= 0.f) return true;
+
+        Float4 clip[3];
+        for (unsigned c=0; c<3; ++c) clip[c] = worldToProjection * Expand(tri[c], 1.f);
+        for (unsigned axis=0; axis<3; ++axis) {
+            bool allBelow = true, allAbove = true;
+            for (unsigned c=0; c<3; ++c) {
+                auto lower = (axis == 2) ? 0.f : -clip[c][3];
+                allBelow &= clip[c][axis] < lower;
+                allAbove &= clip[c][axis] > clip[c][3];
+            }
+            if (allBelow || allAbove) return true;
+        }
+        return false;
+    }
+
+	TEST_CLASS(DrawCallClustering)
+	{
+	public:
+		TEST_METHOD(BuildsContiguousClusters)
+		{
+            auto box = MakeBox(100.f, 40);
+            auto originalIndices = box._indices;
+            auto clusters = GeoProc::BuildDrawCallClusters(
+                AsPointer(box._indices.begin()), RenderCore::Metal::NativeFormat::R32_UINT,
+                MakeIteratorRange(box._drawCalls), MakeIteratorRange(box._positions), 64);
+
+                //  Clusters must exactly cover each draw call, in order
+            unsigned clusterIndex = 0, clustersWithCones = 0;
+            for (unsigned d=0; d<box._drawCalls.size(); ++d) {
+                const auto& drawCall = box._drawCalls[d];
+                auto cursor = drawCall._firstIndex;
+                while (clusterIndex < clusters.size() && clusters[clusterIndex]._drawCallIndex == d) {
+                    const auto& cluster = clusters[clusterIndex++];
+                    Assert::AreEqual(cursor, cluster._firstIndex);
+                    Assert::IsTrue(cluster._indexCount > 0 && cluster._indexCount <= 64*3 && (cluster._indexCount%3) == 0);
+                    cursor += cluster._indexCount;
+
+                        //  Every vertex is within the sphere, and every triangle within the cone
+                    auto minDot = std::sqrt(std::max(1.f - cluster._coneCutoff*cluster._coneCutoff, 0.f));
+                    for (unsigned i=cluster._firstIndex; i<cluster._firstIndex+cluster._indexCount; i+=3) {
+                        Float3 tri[3];
+                        for (unsigned c=0; c<3; ++c) {
+                            tri[c] = box._positions[box._indices[i+c]];
+                            Assert::IsTrue(Magnitude(Float3(tri[c] - cluster._sphereCentre)) <= cluster._sphereRadius);
+                        }
+                        if (cluster._coneCutoff < 1.f) {
+                            auto normal = Normalize(Cross(Float3(tri[1] - tri[0]), Float3(tri[2] - tri[0])));
+                            Assert::IsTrue(Dot(normal, cluster._coneAxis) >= minDot - 1e-4f);
+                        }
+                    }
+                    clustersWithCones += cluster._coneCutoff < 1.f;
+                }
+                Assert::AreEqual(drawCall._firstIndex + drawCall._indexCount, cursor);
+            }
+            Assert::AreEqual(size_t(clusterIndex), clusters.size());
+            Assert::IsTrue(clustersWithCones > clusters.size() * 3 / 4);
+
+                //  The same triangles must remain in each draw call (only the order changes)
+            for (const auto& drawCall:box._drawCalls) {
+                using Tri = std::tuple<uint32, uint32, uint32>;
+                std::vector<Tri> before, after;
+                for (unsigned i=drawCall._firstIndex; i<drawCall._firstIndex+drawCall._indexCount; i+=3) {
+                    before.push_back(Tri(originalIndices[i], originalIndices[i+1], originalIndices[i+2]));
+                    after.push_back(Tri(box._indices[i], box._indices[i+1], box._indices[i+2]));
+                }
+                std::sort(before.begin(), before.end());
+                std::sort(after.begin(), after.end());
+                Assert::IsTrue(before == after);
+            }
+
+                //  16 bit indices should give the same result
+            auto box16 = MakeBox(100.f, 40);
+            std::vector<uint16> indices16(box16._indices.begin(), box16._indices.end());
+            auto clusters16 = GeoProc::BuildDrawCallClusters(
+                AsPointer(indices16.begin()), RenderCore::Metal::NativeFormat::R16_UINT,
+                MakeIteratorRange(box16._drawCalls), MakeIteratorRange(box16._positions), 64);
+            Assert::AreEqual(clusters.size(), clusters16.size());
+            Assert::IsTrue(std::equal(indices16.begin(), indices16.end(), box._indices.begin()));
+        }
+
+        TEST_METHOD(CullingIsConservative)
+        {
+            auto box = MakeBox(100.f, 30);
+            auto clusters = GeoProc::BuildDrawCallClusters(
+                AsPointer(box._indices.begin()), RenderCore::Metal::NativeFormat::R32_UINT,
+                MakeIteratorRange(box._drawCalls), MakeIteratorRange(box._positions), 96);
+            Assert::IsTrue((clusters.size() % 4) != 0);     // (so both the SIMD and the scalar paths are used)
+
+                //  Random cameras around the box. Culled clusters must never contain a
+                //  visible triangle
+            std::mt19937 rng(0x3a1);
+            std::uniform_real_distribution<float> pos(-150.f, 250.f), dir(-1.f, 1.f);
+            unsigned totalCulled = 0;
+            for (unsigned test=0; test<200; ++test) {
+                Float3 view(pos(rng), pos(rng), pos(rng));
+                Float3 target(pos(rng) * .5f + 25.f, pos(rng) * .5f + 25.f, pos(rng) * .5f + 25.f);
+                Float3 forward;
+                if (!Normalize_Checked(&forward, Float3(target - view))) continue;
+                auto worldToProjection = MakeWorldToProjection(view, forward, Deg2Rad(35.f));
+
+                std::vector<std::pair<unsigned, unsigned>> ranges;
+                auto visible = CullDrawCallClusters(ranges, MakeIteratorRange(clusters), worldToProjection, view);
+                totalCulled += unsigned(clusters.size()) - visible;
+
+                for (const auto& cluster:clusters) {
+                    if (IsInRanges(cluster._firstIndex, ranges)) continue;
+                    for (unsigned i=cluster._firstIndex; i<cluster._firstIndex+cluster._indexCount; i+=3) {
+                        Float3 tri[] = { box._positions[box._indices[i]], box._positions[box._indices[i+1]], box._positions[box._indices[i+2]] };
+                        Assert::IsTrue(IsTriangleInvisible(tri, worldToProjection, view));
+                    }
+                }
+            }
+            Assert::IsTrue(totalCulled > 0);
+
+                //  Looking at the whole box from far away, nothing is outside of the frustum.
+                //  Without backface culling, the result is the whole of each draw call
+            Float3 farView(-400.f, -300.f, 250.f);
+            auto worldToProjection = MakeWorldToProjection(farView, Normalize(Float3(Float3(50.f, 50.f, 50.f) - farView)), Deg2Rad(35.f));
+            std::vector<std::pair<unsigned, unsigned>> ranges;
+            auto visible = CullDrawCallClusters(ranges, MakeIteratorRange(clusters), worldToProjection, farView, false);
+            Assert::AreEqual(unsigned(clusters.size()), visible);
+            Assert::AreEqual(size_t(1), ranges.size());
+            Assert::AreEqual(box._drawCalls[1]._firstIndex + box._drawCalls[1]._indexCount, ranges[0].second);
+
+                //  With backface culling, the 3 faces pointing away are culled
+            ranges.clear();
+            visible = CullDrawCallClusters(ranges, MakeIteratorRange(clusters), worldToProjection, farView, true);
+            Assert::IsTrue(visible < clusters.size() * 3 / 4);
+        }
+
+        TEST_METHOD(MeasureCullingSavings)
+        {
+                //  A building that's much larger than the view. The camera moves along one wall,
+                //  looking at the wall, so only a small part is visible at any time
+            auto box = MakeBox(400.f, 200);
+            auto totalTriangles = unsigned(box._indices.size() / 3);
+            auto buildStart = std::chrono::high_resolution_clock::now();
+            auto clusters = GeoProc::BuildDrawCallClusters(
+                AsPointer(box._indices.begin()), RenderCore::Metal::NativeFormat::R32_UINT,
+                MakeIteratorRange(box._drawCalls), MakeIteratorRange(box._positions), 96);
+            auto buildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count();
+
+            const unsigned frames = 256;
+            std::vector<Float4x4> worldToProjection;
+            std::vector<Float3> views;
+            for (unsigned f=0; f<frames; ++f) {
+                Float3 view(400.f * float(f) / float(frames), -30.f, 20.f);
+                views.push_back(view);
+                worldToProjection.push_back(MakeWorldToProjection(view, Normalize(Float3(.3f, 1.f, .2f)), Deg2Rad(30.f)));
+            }
+
+            std::vector<std::pair<unsigned, unsigned>> ranges;
+            uint64 submittedTriangles = 0, rangeCount = 0;
+            auto cullStart = std::chrono::high_resolution_clock::now();
+            for (unsigned f=0; f<frames; ++f) {
+                ranges.clear();
+                CullDrawCallClusters(ranges, MakeIteratorRange(clusters), worldToProjection[f], views[f]);
+                for (const auto& r:ranges) submittedTriangles += r.second / 3;
+                rangeCount += ranges.size();
+            }
+            auto cullTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - cullStart).count();
+
+            auto averageSubmitted = double(submittedTriangles) / double(frames);
+            std::stringstream str;
+            str << "Cluster culling: " << totalTriangles << " triangles in " << clusters.size() << " clusters (built in " << buildTime << "ms). "
+                << "Average submitted per frame: " << averageSubmitted << " triangles (" << 100.0 * averageSubmitted / double(totalTriangles) << "%) "
+                << "in " << double(rangeCount) / double(frames) << " draws. "
+                << "Culling cost: " << cullTime / double(frames) << "us per frame" << std::endl;
+            Logger::WriteMessage(str.str().c_str());
+
+            Assert::IsTrue(averageSubmitted < .25 * double(totalTriangles));
+        }
+    };
+}
+
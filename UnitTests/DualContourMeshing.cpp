@@ -0,0 +1,129 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../SceneEngine/DualContour.h"
+#include "../Math/Noise.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include <CppUnitTest.h>
+#include <map>
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    class NoisySphereDensity : public SceneEngine::IVolumeDensityFunction
+    {
+    public:
+        Boundary    GetBoundary() const
+        {
+            return std::make_pair(Float3(-10.f, -10.f, -10.f), Float3(10.f, 10.f, 10.f));
+        }
+
+        float       GetDensity(const Float3& pt) const
+        {
+            float result = 7.f - Magnitude(pt) + 1.5f * XLEMath::SimplexNoise(Float3(.3f * pt));
+            if (_carveRadius > 0.f)
+                result = std::min(result, Magnitude(pt - _carveCenter) - _carveRadius);
+            return result;
+        }
+
+        Float3      GetNormal(const Float3& pt) const
+        {
+            const float e = 0.01f;
+            return Normalize(Float3(
+                GetDensity(pt - Float3(e, 0.f, 0.f)) - GetDensity(pt + Float3(e, 0.f, 0.f)),
+                GetDensity(pt - Float3(0.f, e, 0.f)) - GetDensity(pt + Float3(0.f, e, 0.f)),
+                GetDensity(pt - Float3(0.f, 0.f, e)) - GetDensity(pt + Float3(0.f, 0.f, e))));
+        }
+
+        Float3  _carveCenter;
+        float   _carveRadius;
+
+        NoisySphereDensity() : _carveCenter(0.f, 0.f, 0.f), _carveRadius(0.f) {}
+    };
+
+    static bool AreIdentical(const SceneEngine::DualContourMesh& lhs, const SceneEngine::DualContourMesh& rhs)
+    {
+        if (lhs._vertices.size() != rhs._vertices.size() || lhs._quads.size() != rhs._quads.size())
+            return false;
+        for (size_t c=0; c<lhs._vertices.size(); ++c)
+            if (    lhs._vertices[c]._pt != rhs._vertices[c]._pt
+                ||  lhs._vertices[c]._normal != rhs._vertices[c]._normal)
+                return false;
+        for (size_t c=0; c<lhs._quads.size(); ++c)
+            if (!std::equal(lhs._quads[c]._verts, &lhs._quads[c]._verts[4], rhs._quads[c]._verts))
+                return false;
+        return true;
+    }
+
+	TEST_CLASS(DualContourMeshing)
+	{
+	public:
+		TEST_METHOD(ThreadedMeshMatchesSerial)
+		{
+                //  The grid size isn't a multiple of the brick size, so the last brick
+                //  on each axis is a partial one
+            NoisySphereDensity fn;
+            CompletionThreadPool pool(4);
+            auto serial = SceneEngine::DualContourMesh_Build(40, fn);
+            auto threaded = SceneEngine::DualContourMesh_Build(40, fn, &pool);
+            Assert::IsTrue(!serial._quads.empty());
+            Assert::IsTrue(AreIdentical(serial, threaded));
+        }
+
+        TEST_METHOD(BricksStitchWithoutCracks)
+        {
+                //  The surface is closed and doesn't touch the edges of the sampling area.
+                //  So every edge in the mesh must be shared by an even number of quads
+                //  (an edge used only once would be a crack along a seam between bricks).
+            NoisySphereDensity fn;
+            auto mesh = SceneEngine::DualContourMesh_Build(48, fn);
+            std::map<std::pair<unsigned, unsigned>, unsigned> edgeCounts;
+            for (const auto& q:mesh._quads) {
+                    // (quad vertices are in a "Z" pattern)
+                const unsigned edges[][2] = { {0, 1}, {1, 3}, {3, 2}, {2, 0} };
+                for (const auto& e:edges) {
+                    auto a = q._verts[e[0]], b = q._verts[e[1]];
+                    Assert::IsTrue(a < mesh._vertices.size() && b < mesh._vertices.size());
+                    ++edgeCounts[std::make_pair(std::min(a, b), std::max(a, b))];
+                }
+            }
+            Assert::IsTrue(!edgeCounts.empty());
+            for (const auto& e:edgeCounts)
+                Assert::IsTrue((e.second % 2) == 0);
+        }
+
+        TEST_METHOD(UpdateMatchesFullRebuild)
+        {
+                //  Carve a hole in the surface, and remesh only the bricks around it.
+                //  The result should be exactly the same as meshing the edited function
+                //  from scratch.
+            NoisySphereDensity fn;
+            CompletionThreadPool pool(4);
+            SceneEngine::DualContourMesher incremental(64, fn.GetBoundary(), &pool);
+            incremental.Build(fn);
+            auto before = incremental.GetMesh();
+
+            NoisySphereDensity edited = fn;
+            edited._carveCenter = Float3(7.f, 0.f, 0.f);
+            edited._carveRadius = 2.f;
+            const Float3 extent(2.f, 2.f, 2.f);
+            auto rebuiltBricks = incremental.Update(edited, edited._carveCenter - extent, edited._carveCenter + extent);
+            Assert::IsTrue(rebuiltBricks > 0 && rebuiltBricks < incremental.GetBrickCount());
+
+            SceneEngine::DualContourMesher full(64, edited.GetBoundary());
+            full.Build(edited);
+            auto after = incremental.GetMesh();
+            Assert::IsTrue(!AreIdentical(before, after));
+            Assert::IsTrue(AreIdentical(full.GetMesh(), after));
+
+                //  An edit outside of the sampling area doesn't touch any bricks
+            Assert::IsTrue(incremental.Update(edited, Float3(20.f, 20.f, 20.f), Float3(21.f, 21.f, 21.f)) == 0);
+        }
+    };
+}
+
@@ -0,0 +1,161 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "UnitTestHelper.h"
+#include "../Tools/EntityInterface/RetainedEntities.h"
+#include "../ConsoleRig/Log.h"
+#include "../ConsoleRig/GlobalServices.h"
+#include "../Utility/TimeUtils.h"
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+	TEST_CLASS(EntityInterface)
+	{
+	public:
+
+        TEST_METHOD(RetainedEntitiesPerformance)
+        {
+                //  Load 100k entities into a RetainedEntities store (distributed
+                //  between a number of folders), and then move them all to a
+                //  different folder. This is similar to what happens when loading
+                //  a large level into the editor.
+            using namespace ::EntityInterface;
+
+            UnitTest_SetWorkingDirectory();
+            ConsoleRig::GlobalServices services(GetStartupConfig());
+
+            auto entities = std::make_shared<RetainedEntities>();
+            RetainedEntityInterface interf(entities);
+
+            const DocumentId doc = 1;
+            auto folderType = interf.GetTypeId("Folder");
+            auto objectType = interf.GetTypeId("Object");
+            auto valueProp = interf.GetPropertyId(objectType, "Value");
+            Assert::AreEqual(folderType, interf.GetTypeId("folder"));
+
+            unsigned folderCallbacks = 0, objectCallbacks = 0;
+            entities->RegisterCallback(folderType,
+                [&folderCallbacks](const RetainedEntities&, const Identifier&, RetainedEntities::ChangeType) { ++folderCallbacks; });
+            entities->RegisterCallback(objectType,
+                [&objectCallbacks](const RetainedEntities&, const Identifier&, RetainedEntities::ChangeType) { ++objectCallbacks; });
+
+            const unsigned folderCount = 100;
+            const unsigned objectCount = 100000;
+            std::vector<Identifier> folders, objects;
+            folders.reserve(folderCount);
+            objects.reserve(objectCount);
+
+            auto loadStart = GetPerformanceCounter();
+            {
+                RetainedEntities::ChangeBatch batch(*entities);
+                for (unsigned c=0; c<folderCount; ++c) {
+                    Identifier id(doc, interf.AssignObjectId(doc, folderType), folderType);
+                    interf.CreateObject(id, nullptr, 0);
+                    folders.push_back(id);
+                }
+
+                for (unsigned c=0; c<objectCount; ++c) {
+                    PropertyInitializer init;
+                    init._prop = valueProp;
+                    init._src = &c;
+                    init._elementType = unsigned(ImpliedTyping::TypeCat::UInt32);
+                    init._arrayCount = 1;
+
+                    Identifier id(doc, interf.AssignObjectId(doc, objectType), objectType);
+                    interf.CreateObject(id, &init, 1);
+                    interf.SetParent(id, folders[c%folderCount], -1);
+                    objects.push_back(id);
+                }
+            }
+            auto loadEnd = GetPerformanceCounter();
+
+                // Within the batch, each folder should get a single Create & AddChild
+                // callback, and each object a single Create & SetParent callback
+            Assert::AreEqual(folderCount*2, folderCallbacks);
+            Assert::AreEqual(objectCount*2, objectCallbacks);
+
+            {
+                RetainedEntities::ChangeBatch batch(*entities);
+                for (unsigned c=0; c<objectCount; ++c)
+                    interf.SetParent(objects[c], folders[(c+1)%folderCount], -1);
+            }
+            auto reparentEnd = GetPerformanceCounter();
+
+            auto found = entities->FindEntitiesOfType(objectType);
+            auto findEnd = GetPerformanceCounter();
+
+            Assert::AreEqual(size_t(objectCount), found.size());
+            for (unsigned c=0; c<objectCount; ++c) {
+                Assert::AreEqual(objects[c].Object(), found[c]->_id);
+                Assert::AreEqual(folders[(c+1)%folderCount].Object(), found[c]->_parent);
+            }
+            Assert::AreEqual(size_t(objectCount/folderCount), entities->GetEntity(folders[0])->_children.size());
+            Assert::AreEqual(size_t(objectCount+folderCount), entities->FindEntitiesInDocument(doc).size());
+
+                // handles should be invalidated when the entity is destroyed
+            auto handle = entities->GetHandle(doc, objects[5].Object());
+            Assert::IsTrue(entities->GetEntity(handle) == found[5]);
+            interf.DeleteObject(objects[5]);
+            Assert::IsTrue(entities->GetEntity(handle) == nullptr);
+            Assert::IsTrue(entities->GetEntity(objects[5]) == nullptr);
+            Assert::AreEqual(size_t(objectCount-1), entities->FindEntitiesOfType(objectType).size());
+
+            auto freq = GetPerformanceCounterFrequency();
+            LogAlwaysWarning << "Load " << objectCount << " entities: " << (loadEnd-loadStart) / float(freq/1000) << "ms";
+            LogAlwaysWarning << "Reparent " << objectCount << " entities: " << (reparentEnd-loadEnd) / float(freq/1000) << "ms";
+            LogAlwaysWarning << "FindEntitiesOfType: " << (findEnd-reparentEnd) / float(freq/1000) << "ms";
+        }
+
+        TEST_METHOD(RetainedEntitiesDeleteInBatch)
+        {
+                //  Changes queued for an entity that is deleted later in the same
+                //  batch must not be delivered
+            using namespace ::EntityInterface;
+
+            UnitTest_SetWorkingDirectory();
+            ConsoleRig::GlobalServices services(GetStartupConfig());
+
+            auto entities = std::make_shared<RetainedEntities>();
+            RetainedEntityInterface interf(entities);
+
+            const DocumentId doc = 1;
+            auto objectType = interf.GetTypeId("Object");
+            auto valueProp = interf.GetPropertyId(objectType, "Value");
+
+            std::vector<std::pair<ObjectId, RetainedEntities::ChangeType>> callbacks;
+            entities->RegisterCallback(objectType,
+                [&callbacks](const RetainedEntities&, const Identifier& id, RetainedEntities::ChangeType changeType) 
+                { callbacks.push_back(std::make_pair(id.Object(), changeType)); });
+
+            Identifier a(doc, interf.AssignObjectId(doc, objectType), objectType);
+            Identifier b(doc, interf.AssignObjectId(doc, objectType), objectType);
+            interf.CreateObject(a, nullptr, 0);
+            interf.CreateObject(b, nullptr, 0);
+            callbacks.clear();
+
+            {
+                RetainedEntities::ChangeBatch batch(*entities);
+                unsigned value = 5;
+                PropertyInitializer init;
+                init._prop = valueProp;
+                init._src = &value;
+                init._elementType = unsigned(ImpliedTyping::TypeCat::UInt32);
+                init._arrayCount = 1;
+                interf.SetProperty(a, &init, 1);
+                interf.SetProperty(b, &init, 1);
+                interf.DeleteObject(a);
+            }
+
+            Assert::AreEqual(size_t(2), callbacks.size());
+            Assert::IsTrue(callbacks[0] == std::make_pair(b.Object(), RetainedEntities::ChangeType::SetProperty));
+            Assert::IsTrue(callbacks[1] == std::make_pair(a.Object(), RetainedEntities::ChangeType::Delete));
+        }
+
+	};
+}
@@ -0,0 +1,140 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../SceneEngine/FluidAdvection.h"
+#include "../Math/RegularNumberField.h"
+#include "../Math/PoissonSolver.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include <CppUnitTest.h>
+#include <random>
+
+#pragma warning(disable:4714)
+#pragma push_macro("new")
+#undef new
+#include <Eigen/Dense>
+#pragma pop_macro("new")
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    using VectorX = Eigen::VectorXf;
+    using ScalarField2D = XLEMath::ScalarField2D<VectorX>;
+    using VectorField2D = XLEMath::VectorField2DSeparate<VectorX>;
+
+    static VectorX MakeRandomField(std::mt19937& rng, unsigned count, float scale)
+    {
+        std::uniform_real_distribution<float> dist(-scale, scale);
+        VectorX result(count);
+        for (unsigned c=0; c<count; ++c) result[c] = dist(rng);
+        return result;
+    }
+
+	TEST_CLASS(FluidSolvers)
+	{
+	public:
+		TEST_METHOD(ThreadedAdvectionMatchesSerial)
+		{
+                //  Every cell is calculated independently, so splitting the grid into slabs
+                //  of rows must give exactly the same result as the single threaded path.
+                //  The width isn't a multiple of 4, so some cells in each row will go through
+                //  the scalar path and the rest through the SIMD path.
+            using namespace SceneEngine;
+            const UInt2 dims(67, 64);
+            const unsigned N = dims[0]*dims[1];
+            std::mt19937 rng(0x44);
+            VectorX u0 = MakeRandomField(rng, N, .02f), v0 = MakeRandomField(rng, N, .02f);
+            VectorX u1 = MakeRandomField(rng, N, .02f), v1 = MakeRandomField(rng, N, .02f);
+            VectorX src = MakeRandomField(rng, N, 1.f);
+
+            CompletionThreadPool pool(4);
+            const AdvectionMethod methods[] = { AdvectionMethod::ForwardEuler, AdvectionMethod::RungeKutta, AdvectionMethod::MacCormackRK4 };
+            const AdvectionInterp interps[] = { AdvectionInterp::Bilinear, AdvectionInterp::MonotonicCubic };
+            const AdvectionBorder borders[] = { AdvectionBorder::Margin, AdvectionBorder::Wrap };
+            for (auto method:methods)
+                for (auto interp:interps)
+                    for (auto border:borders) {
+                        VectorX serial = src, threaded = src;
+                        PerformAdvection(
+                            ScalarField2D(&serial, dims), ScalarField2D(&src, dims),
+                            VectorField2D(&u0, &v0, dims), VectorField2D(&u1, &v1, dims),
+                            1.3f, AdvectionSettings(method, interp, 4, border, AdvectionBorder::Margin, AdvectionBorder::None));
+                        PerformAdvection(
+                            ScalarField2D(&threaded, dims), ScalarField2D(&src, dims),
+                            VectorField2D(&u0, &v0, dims), VectorField2D(&u1, &v1, dims),
+                            1.3f, AdvectionSettings(method, interp, 4, border, AdvectionBorder::Margin, AdvectionBorder::None, &pool));
+                        Assert::IsTrue(serial == threaded);
+                    }
+        }
+
+        TEST_METHOD(AdvectionShiftsByConstantVelocity)
+        {
+                //  With a constant velocity field, every RK4 step lands on the same point. So
+                //  the result should be the source field shifted by a whole number of cells.
+            using namespace SceneEngine;
+            const UInt2 dims(35, 20);
+            const unsigned N = dims[0]*dims[1];
+            std::mt19937 rng(0x45);
+            VectorX src = MakeRandomField(rng, N, 1.f);
+            VectorX u(N), v(N);
+            u.fill(1.f); v.fill(-2.f);
+
+                // (with wrapping on both axes, the velocity scale is the full grid size)
+            const float deltaTime = 1.f / float(dims[0]);
+            const float vScale = float(dims[1]) / float(dims[0]);
+            const AdvectionMethod methods[] = { AdvectionMethod::RungeKutta, AdvectionMethod::MacCormackRK4 };
+            for (auto method:methods) {
+                VectorX dst = src;
+                PerformAdvection(
+                    ScalarField2D(&dst, dims), ScalarField2D(&src, dims),
+                    VectorField2D(&u, &v, dims), VectorField2D(&u, &v, dims),
+                    deltaTime, AdvectionSettings(method, AdvectionInterp::Bilinear, 4, AdvectionBorder::Wrap, AdvectionBorder::Wrap, AdvectionBorder::None));
+
+                for (unsigned y=0; y<dims[1]; ++y)
+                    for (unsigned x=0; x<dims[0]; ++x) {
+                            // tracing backwards, so cell (x, y) comes from (x-1, y+2*vScale)
+                        float sy = float(y) + 2.f * vScale;
+                        unsigned y0 = unsigned(sy);
+                        float b = sy - float(y0);
+                        unsigned x0 = (x + dims[0] - 1) % dims[0];
+                        float expected
+                            = (1.f-b) * src[(y0%dims[1])*dims[0]+x0]
+                            +      b  * src[((y0+1)%dims[1])*dims[0]+x0];
+                        Assert::AreEqual(expected, dst[y*dims[0]+x], 1e-4f);
+                    }
+            }
+        }
+
+        TEST_METHOD(ThreadedPoissonSolverIsDeterministic)
+        {
+                //  Dot products in the conjugate gradient solvers are summed in fixed size
+                //  blocks. So the results must be the same for any number of threads.
+            using namespace XLEMath;
+            unsigned dims[] = { 130, 97 };
+            const unsigned N = dims[0]*dims[1];
+            std::mt19937 rng(0x46);
+            VectorX b = MakeRandomField(rng, N, 1.f);
+
+            CompletionThreadPool pool1(1), pool4(4);
+            PoissonSolver serial(2, dims), threaded1(2, dims, &pool1), threaded4(2, dims, &pool4);
+            const PoissonSolver::Method methods[] = { PoissonSolver::Method::PlainCG, PoissonSolver::Method::PreconCG };
+            for (auto method:methods) {
+                for (unsigned wrap=0; wrap<2; ++wrap) {
+                    VectorX x0 = b, x1 = b, x4 = b;
+                    auto A0 = serial.PrepareDiffusionMatrix(.2f, method, wrap);
+                    auto A1 = threaded1.PrepareDiffusionMatrix(.2f, method, wrap);
+                    auto A4 = threaded4.PrepareDiffusionMatrix(.2f, method, wrap);
+                    serial.Solve(ScalarField1D{x0.data(), N}, *A0, ScalarField1D{b.data(), N}, method);
+                    threaded1.Solve(ScalarField1D{x1.data(), N}, *A1, ScalarField1D{b.data(), N}, method);
+                    threaded4.Solve(ScalarField1D{x4.data(), N}, *A4, ScalarField1D{b.data(), N}, method);
+                    Assert::IsTrue(x0 == x1);
+                    Assert::IsTrue(x0 == x4);
+                }
+            }
+        }
+    };
+}
+
@@ -9,12 +9,16 @@
 #include "../RenderCore/Assets/ModelRunTime.h"
 #include "../RenderCore/Assets/ModelImmutableData.h"
 #include "../RenderCore/Assets/Services.h"
+#include "../RenderCore/Assets/TextureCompiler.h"
 #include "../ColladaConversion/DLLInterface.h"
 #include "../ColladaConversion/NascentModel.h"
 #include "../Assets/IntermediateAssets.h"
 #include "../Assets/Assets.h"
 #include "../Assets/AssetServices.h"
 #include "../Assets/CompileAndAsyncManager.h"
+#include "../Assets/ChunkFile.h"
+#include "../Assets/ChunkFileAsset.h"
+#include "../Assets/BlockSerializer.h"
 #include "../ConsoleRig/Console.h"
 #include "../ConsoleRig/Log.h"
 #include "../ConsoleRig/GlobalServices.h"
@@ -28,6 +32,7 @@
 #include "../Utility/Streams/XmlStreamFormatter.h"
 #include "../Core/SelectConfiguration.h"
 #include <CppUnitTest.h>
+#include <algorithm>
 
 #include "../Core/WinAPI/IncludeWindows.h"
 
@@ -280,5 +285,103 @@ namespace UnitTests
             }
         }
 
+
+        TEST_METHOD(ChunkFileMappedLoading)
+        {
+                //  Write a small chunk file with a raw chunk and a block serialized
+                //  chunk, and then load it both by copying and from a mapped view.
+                //  The results should be identical; and the chunks should be aligned
+            const char filename[] = "chunkfile_test.dat";
+            using namespace Serialization::ChunkFile;
+
+            const uint8 rawData[] = { 1, 2, 3, 4, 5, 6, 7 };    // (odd size, so the next chunk needs padding)
+            Serialization::NascentBlockSerializer subBlock;
+            for (unsigned c=0; c<64; ++c) subBlock.SerializeValue(uint32(c));
+            Serialization::NascentBlockSerializer block;
+            block.SerializeSubBlock(subBlock);
+            block.SerializeValue(uint32(64));
+            auto blockData = block.AsMemoryBlock();
+
+            {
+                SimpleChunkFileWriter writer(2, "test", "test", std::make_tuple(filename, "wb", 0));
+                writer.BeginChunk(1, 0, "Raw");
+                writer.Write(rawData, 1, dimof(rawData));
+                writer.BeginChunk(2, 0, "Block");
+                writer.Write(blockData.get(), 1, block.Size());
+            }
+
+            const ::Assets::AssetChunkRequest requests[]
+            {
+                ::Assets::AssetChunkRequest { "Raw", 1, 0, ::Assets::AssetChunkRequest::DataType::Raw },
+                ::Assets::AssetChunkRequest { "Block", 2, 0, ::Assets::AssetChunkRequest::DataType::BlockSerializer }
+            };
+
+            for (unsigned mapped=0; mapped<2; ++mapped) {
+                ::Assets::SetChunkFileMappedLoading(mapped != 0);
+                auto chunks = ::Assets::LoadChunkFileData(filename, MakeIteratorRange(requests));
+                Assert::AreEqual(size_t(2), chunks.size());
+                Assert::AreEqual(0u, unsigned(chunks[0]._offset % ChunkAlignment));
+                Assert::AreEqual(0u, unsigned(chunks[1]._offset % ChunkAlignment));
+
+                Assert::AreEqual(dimof(rawData), chunks[0]._size);
+                Assert::IsTrue(std::equal(rawData, ArrayEnd(rawData), chunks[0]._buffer.get()));
+
+                auto* firstObject = (const size_t*)Serialization::Block_GetFirstObject(chunks[1]._buffer.get());
+                auto* values = (const uint32*)firstObject[0];
+                Assert::IsTrue(values > (const void*)chunks[1]._buffer.get() && values < PtrAdd(chunks[1]._buffer.get(), chunks[1]._size));
+                for (unsigned c=0; c<64; ++c)
+                    Assert::AreEqual(c, values[c]);
+                Assert::AreEqual(64u, *(const uint32*)&firstObject[1]);
+            }
+
+            ::Assets::SetChunkFileMappedLoading(true);
+            XlDeleteFile((const utf8*)filename);
+        }
+
+        TEST_METHOD(CookedTextureReuse)
+        {
+                //  Cook a texture, and then check that the next request finds the
+                //  cooked output up to date (rather than cooking it again). The
+                //  source texture has no ".metadata" file, so this also checks that
+                //  a missing optional dependency doesn't invalidate the cooked file.
+            UnitTest_SetWorkingDirectory();
+            ConsoleRig::GlobalServices services(GetStartupConfig());
+
+            {
+                auto aservices = std::make_shared<::Assets::Services>(0);
+                auto& asyncMan = aservices->GetAsyncMan();
+                auto raservices = std::make_shared<RenderCore::Assets::Services>(nullptr);
+
+                using ::Assets::ResChar;
+                using RenderCore::Assets::TextureCompiler;
+                const ResChar sourceTexture[] = "game/xleres/defaultresources/waternoise.png";
+                ResChar metadataFile[MaxPath];
+                XlCopyString(metadataFile, sourceTexture);
+                XlCatString(metadataFile, ".metadata");
+                Assert::IsFalse(DoesFileExist(metadataFile));
+
+                const ResChar* initializers[] = { sourceTexture, "" };
+                auto& compilers = asyncMan.GetIntermediateCompilers();
+                auto& store = asyncMan.GetIntermediateStore();
+
+                auto firstMarker = compilers.PrepareAsset(
+                    TextureCompiler::CompileProcessType, initializers, dimof(initializers), store);
+                auto firstLocator = firstMarker->GetExistingAsset();
+                XlDeleteFile((const utf8*)firstLocator._sourceID0);
+
+                auto pendingCook = firstMarker->InvokeCompile();
+                Assert::IsTrue(pendingCook.get() != nullptr);
+                Assert::IsTrue(pendingCook->StallWhilePending() == ::Assets::AssetState::Ready);
+
+                auto secondMarker = compilers.PrepareAsset(
+                    TextureCompiler::CompileProcessType, initializers, dimof(initializers), store);
+                auto secondLocator = secondMarker->GetExistingAsset();
+                Assert::IsTrue(XlEqString(firstLocator._sourceID0, secondLocator._sourceID0));
+                Assert::IsTrue(DoesFileExist(secondLocator._sourceID0));
+                Assert::IsTrue(secondLocator._dependencyValidation.get() != nullptr, L"Cooked texture was not reused on the second request");
+                Assert::AreEqual(0u, secondLocator._dependencyValidation->GetValidationIndex());
+            }
+        }
+
 	};
 }
\ No newline at end of file
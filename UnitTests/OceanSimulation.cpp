@@ -0,0 +1,118 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../SceneEngine/DeepOceanSimCPU.h"
+#include "../SceneEngine/DeepOceanSim.h"
+#include "../Math/Math.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include "../Utility/MemoryUtils.h"
+#include "../Utility/PtrUtils.h"
+#include <CppUnitTest.h>
+#include <vector>
+#include <complex>
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+	TEST_CLASS(OceanSimulation)
+	{
+	public:
+		TEST_METHOD(MatchesReferenceTransform)
+		{
+                //  Calculate the heights with a naive (double precision) 2D DFT of the
+                //  same spectrum, and compare to the FFT
+            const unsigned N = 16;
+            SceneEngine::DeepOceanSimSettings settings;
+            settings._gridDimensions = N;
+            settings._physicalDimensions = 64.f;
+            settings._spectrumFade = .3f;
+            const float time = 12.5f;
+
+            SceneEngine::DeepOceanSimCPU sim;
+            sim.Update(settings, time);
+
+            std::vector<float> calmReal(N*N), calmImaginary(N*N), strongReal(N*N), strongImaginary(N*N);
+            SceneEngine::Internal::BuildOceanSpectrum(
+                AsPointer(calmReal.begin()), AsPointer(calmImaginary.begin()),
+                SceneEngine::Internal::BuildOceanSpectrumDesc(settings, 0));
+            SceneEngine::Internal::BuildOceanSpectrum(
+                AsPointer(strongReal.begin()), AsPointer(strongImaginary.begin()),
+                SceneEngine::Internal::BuildOceanSpectrumDesc(settings, 1));
+
+            using Complex = std::complex<double>;
+            std::vector<Complex> h(N*N);
+            for (unsigned y=0; y<N; ++y)
+                for (unsigned x=0; x<N; ++x) {
+                    auto h0 = [&](unsigned i)
+                        {
+                            return Complex(
+                                calmReal[i] + (strongReal[i] - calmReal[i]) * settings._spectrumFade,
+                                calmImaginary[i] + (strongImaginary[i] - calmImaginary[i]) * settings._spectrumFade);
+                        };
+                    double kx = 2.0 * gPI * (x + .5 - N/2.0) / settings._physicalDimensions;
+                    double ky = 2.0 * gPI * (y + .5 - N/2.0) / settings._physicalDimensions;
+                    double w = std::sqrt(std::sqrt(kx*kx + ky*ky) * 9.8);
+                    h[y*N+x] = h0(y*N+x) * std::exp(Complex(0., w*time))
+                             + std::conj(h0(y*N+N-1-x)) * std::exp(Complex(0., -w*time));
+                }
+
+            double maxError = 0.0, maxHeight = 0.0;
+            for (unsigned y=0; y<N; ++y)
+                for (unsigned x=0; x<N; ++x) {
+                    Complex sum = 0.;
+                    for (unsigned v=0; v<N; ++v)
+                        for (unsigned u=0; u<N; ++u)
+                            sum += h[v*N+u] * std::exp(Complex(0., -2.0 * gPI * double(u*x+v*y) / double(N)));
+                    double expected = (((x+y)&1) ? -1.0 : 1.0) * sum.real() * settings._strengthConstantZ / 512.0;
+                    double actual = sim.GetDisplacementGrid()[(y*N+x)*4+2];
+                    maxError = std::max(maxError, std::abs(expected - actual));
+                    maxHeight = std::max(maxHeight, std::abs(expected));
+                }
+
+            Assert::IsTrue(maxHeight > 0.01);
+            Assert::IsTrue(maxError < 1e-5 * maxHeight * N);
+        }
+
+        TEST_METHOD(ThreadedUpdateAndQueries)
+        {
+            SceneEngine::DeepOceanSimSettings settings;
+            settings._gridDimensions = 128;
+            settings._baseHeight = 5.f;
+
+            CompletionThreadPool pool(4);
+            SceneEngine::DeepOceanSimCPU serial, threaded(&pool);
+            serial.Update(settings, 3.f);
+            threaded.Update(settings, 3.f);
+            Assert::IsTrue(!XlCompareMemory(
+                serial.GetDisplacementGrid(), threaded.GetDisplacementGrid(),
+                sizeof(float)*4*128*128));
+
+                //  Without horizontal displacement (and at time 0, so there's no grid shift),
+                //  queries on texel centres should return the grid values exactly
+            settings._strengthConstantXY = 0.f;
+            serial.Update(settings, 0.f);
+            const float texelSize = settings._physicalDimensions / 128.f;
+            std::vector<Float2> positions;
+            for (unsigned y=0; y<128; y+=7)
+                for (unsigned x=0; x<128; x+=5)
+                    positions.push_back(Float2(x*texelSize, y*texelSize));
+            std::vector<float> heights(positions.size());
+            std::vector<Float3> normals(positions.size());
+            serial.QueryHeightsAndNormals(MakeIteratorRange(positions), MakeIteratorRange(heights), MakeIteratorRange(normals));
+
+            for (size_t c=0; c<positions.size(); ++c) {
+                unsigned x = unsigned(positions[c][0] / texelSize + .5f), y = unsigned(positions[c][1] / texelSize + .5f);
+                float expected = settings._baseHeight + serial.GetDisplacementGrid()[(y*128+x)*4+2];
+                Assert::AreEqual(expected, heights[c], 1e-5f);
+                Assert::IsTrue(normals[c][2] > 0.f);
+                Assert::AreEqual(1.f, Magnitude(normals[c]), 1e-4f);
+            }
+        }
+    };
+}
+
@@ -0,0 +1,148 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../SceneEngine/SpriteAtlasAllocator.h"
+#include <CppUnitTest.h>
+#include <vector>
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    using SceneEngine::SpriteAtlasAllocator;
+
+    static bool Overlaps(const SpriteAtlasAllocator::Rectangle& lhs, const SpriteAtlasAllocator::Rectangle& rhs)
+    {
+        return lhs.first[0] < rhs.second[0] && rhs.first[0] < lhs.second[0]
+            && lhs.first[1] < rhs.second[1] && rhs.first[1] < lhs.second[1];
+    }
+
+    static bool NoOverlaps(const SpriteAtlasAllocator& allocator)
+    {
+        std::vector<SpriteAtlasAllocator::Rectangle> rects;
+        for (unsigned s=0; s<allocator.GetMaxSpriteCount(); ++s) {
+            const auto& sprite = allocator.GetSprite(s);
+            if (!sprite._allocated) continue;
+            for (unsigned m=0; m<allocator.GetMipMapCount(); ++m)
+                rects.push_back(sprite._rect[m]);
+        }
+        for (size_t a=0; a<rects.size(); ++a)
+            for (size_t b=a+1; b<rects.size(); ++b)
+                if (Overlaps(rects[a], rects[b])) return false;
+        return true;
+    }
+
+	TEST_CLASS(SpriteAtlasAllocation)
+	{
+	public:
+		TEST_METHOD(AllocatesMipMapChains)
+		{
+            SpriteAtlasAllocator allocator(UInt2(256, 256), 16);
+            auto sprite = allocator.Allocate(UInt2(64, 32), 0);
+            Assert::IsTrue(sprite != SpriteAtlasAllocator::InvalidSprite);
+            Assert::AreEqual(1u, allocator.GetSpriteCount());
+
+            unsigned expectedPixels = 0;
+            for (unsigned m=0; m<SpriteAtlasAllocator::MaxMipMaps; ++m) {
+                const auto& r = allocator.GetSprite(sprite)._rect[m];
+                Assert::AreEqual(std::max(64u >> m, 1u), r.second[0] - r.first[0]);
+                Assert::AreEqual(std::max(32u >> m, 1u), r.second[1] - r.first[1]);
+                expectedPixels += (r.second[0] - r.first[0]) * (r.second[1] - r.first[1]);
+            }
+            Assert::AreEqual(expectedPixels, allocator.GetPixelsAllocated());
+
+                //  Sprites that can never fit fail immediately
+            Assert::IsTrue(allocator.Allocate(UInt2(512, 16), 0) == SpriteAtlasAllocator::InvalidSprite);
+
+                //  Releasing everything returns the atlas to a single free block
+            for (unsigned c=0; c<8; ++c)
+                Assert::IsTrue(allocator.Allocate(UInt2(20 + c*3, 40 - c*2), 0) != SpriteAtlasAllocator::InvalidSprite);
+            Assert::IsTrue(NoOverlaps(allocator));
+            for (unsigned s=0; s<allocator.GetMaxSpriteCount(); ++s)
+                if (allocator.GetSprite(s)._allocated)
+                    allocator.Release(s);
+            Assert::AreEqual(0u, allocator.GetSpriteCount());
+            Assert::AreEqual(0u, allocator.GetPixelsAllocated());
+            Assert::AreEqual(0.f, allocator.Fragmentation());
+            Assert::IsTrue(allocator.LargestFreeBlock().first == UInt2(256, 256));
+        }
+
+        TEST_METHOD(EvictsLeastRecentlyUsed)
+        {
+                //  Only 4 sprite slots. Once they are all used, new sprites evict the
+                //  least recently used ones
+            SpriteAtlasAllocator::EvictionRules rules;
+            rules._maxEvictionsPerFrame = 1;
+            rules._createGracePeriod = 10;
+            rules._usageGracePeriod = 2;
+            SpriteAtlasAllocator allocator(UInt2(256, 256), 4, 3, rules);
+
+            unsigned sprites[4];
+            for (unsigned c=0; c<4; ++c)
+                sprites[c] = allocator.Allocate(UInt2(32, 32), c);
+            Assert::AreEqual(sprites[0], allocator.GetLeastRecentlyUsed());
+
+                //  Within the creation grace period, nothing can be evicted
+            std::vector<unsigned> evicted;
+            Assert::IsTrue(allocator.Allocate(UInt2(32, 32), 5, &evicted) == SpriteAtlasAllocator::InvalidSprite);
+            Assert::IsTrue(evicted.empty());
+
+                //  Using sprites 0 and 1 makes sprite 2 the least recently used
+            allocator.Touch(sprites[0], 20);
+            allocator.Touch(sprites[1], 21);
+            Assert::AreEqual(sprites[2], allocator.GetLeastRecentlyUsed());
+            auto newSprite = allocator.Allocate(UInt2(32, 32), 30, &evicted);
+            Assert::IsTrue(newSprite != SpriteAtlasAllocator::InvalidSprite);
+            Assert::IsTrue(evicted.size() == 1 && evicted[0] == sprites[2]);
+            Assert::AreEqual(sprites[2], newSprite);     // (the slot is reused)
+            Assert::AreEqual(sprites[3], allocator.GetLeastRecentlyUsed());
+
+                //  Only one eviction allowed per frame
+            evicted.clear();
+            Assert::IsTrue(allocator.Allocate(UInt2(32, 32), 30, &evicted) == SpriteAtlasAllocator::InvalidSprite);
+            Assert::IsTrue(evicted.empty());
+            Assert::IsTrue(allocator.Allocate(UInt2(32, 32), 31, &evicted) != SpriteAtlasAllocator::InvalidSprite);
+            Assert::IsTrue(evicted.size() == 1 && evicted[0] == sprites[3]);
+
+                //  Sprites used very recently can't be evicted
+            allocator.Touch(sprites[0], 100);
+            allocator.Touch(sprites[1], 100);
+            allocator.Touch(sprites[2], 100);
+            allocator.Touch(sprites[3], 100);
+            evicted.clear();
+            Assert::IsTrue(allocator.Allocate(UInt2(32, 32), 101, &evicted) == SpriteAtlasAllocator::InvalidSprite);
+            Assert::IsTrue(evicted.empty());
+            Assert::AreEqual(4u, allocator.GetSpriteCount());
+        }
+
+        TEST_METHOD(EvictsToMakeSpace)
+        {
+                //  Plenty of sprite slots, but the atlas fills up. The oldest sprites should
+                //  be evicted until the new sprite fits, and the live sprites never overlap
+            SpriteAtlasAllocator::EvictionRules rules;
+            rules._maxEvictionsPerFrame = 64;
+            rules._createGracePeriod = 0;
+            rules._usageGracePeriod = 0;
+            SpriteAtlasAllocator allocator(UInt2(256, 128), 256, 5, rules);
+
+            unsigned frame = 0, failures = 0;
+            for (unsigned c=0; c<500; ++c) {
+                UInt2 dims(16 + (c*37)%48, 16 + (c*23)%48);
+                std::vector<unsigned> evicted;
+                auto sprite = allocator.Allocate(dims, ++frame, &evicted);
+                if (sprite == SpriteAtlasAllocator::InvalidSprite) { ++failures; continue; }
+                for (auto e:evicted)
+                    Assert::IsTrue(e == sprite || !allocator.GetSprite(e)._allocated);
+                Assert::IsTrue(NoOverlaps(allocator));
+            }
+            Assert::AreEqual(0u, failures);
+            Assert::IsTrue(allocator.GetPixelsAllocated() <= 256u * 128u);
+            Assert::IsTrue(allocator.Fragmentation() >= 0.f && allocator.Fragmentation() <= 1.f);
+        }
+    };
+}
+
@@ -11,8 +11,15 @@
 #include "../ConsoleRig/GlobalServices.h"
 #include "../Utility/Streams/StreamFormatter.h"
 #include "../Utility/Streams/StreamDOM.h"
+#include "../Utility/Streams/Data.h"
+#include "../Utility/Streams/XmlStreamFormatter.h"
 #include "../Utility/Conversion.h"
+#include "../Utility/PtrUtils.h"
 #include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <random>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -101,6 +108,110 @@ namespace UnitTests
             RunBasicTest<ucs4>();
 		}
 
+        TEST_METHOD(StructuralCharacterScans)
+        {
+                //  The vectorized scans must agree with simple loops, particularly
+                //  around the edges of blocks (and for "\r\n" split across blocks)
+            const utf8 alphabet[] = { 'a', 'b', ' ', '<', '>', ';', '~', '\r', '\n' };
+            const utf8 chars[] = { '<', ';', '~', '\n' };
+            std::mt19937 rng(0x3141);
+            std::vector<utf8> buffer(256);
+            for (unsigned test=0; test<10000; ++test) {
+                auto density = 1 + rng()%32;
+                for (auto& c:buffer)
+                    c = ((rng()%density)==0) ? alphabet[rng()%dimof(alphabet)] : utf8('a' + rng()%3);
+                auto* begin = AsPointer(buffer.cbegin()) + rng()%64;
+                auto* end = begin + rng()%(AsPointer(buffer.cend()) - begin + 1);
+                
+                auto charCount = 1 + unsigned(rng()%dimof(chars));
+                auto* expected = begin;
+                while (expected < end && std::find(chars, &chars[charCount], *expected) == &chars[charCount]) ++expected;
+                Assert::IsTrue(XlFindAnyChar(begin, end, chars, charCount) == expected);
+
+                unsigned expectedLines = 0, lines = 0;
+                const utf8* expectedLineStart = begin, *lineStart = begin;
+                for (expected = begin; expected < end && *expected != '<'; ++expected) {
+                    if (*expected == '\r' || *expected == '\n') {
+                        if (*expected == '\r' && (expected+1) < end && expected[1] == '\n') ++expected;
+                        expectedLineStart = expected+1;
+                        ++expectedLines;
+                    }
+                }
+                Assert::IsTrue(XlFindCharCountLines(begin, end, utf8('<'), lines, lineStart) == expected);
+                Assert::AreEqual(expectedLines, lines);
+                Assert::IsTrue(lineStart == expectedLineStart);
+            }
+
+                //  Locations reported by the xml formatter should count "\r\n" as a single new line
+            std::string xml = "<?xml version=\"1.0\"?>\r\n<root>\r\n";
+            for (unsigned c=0; c<40; ++c) xml += "1.0 2.0 3.0\r\n";
+            xml += "\n\r<child a=\"1\r\n2\"/></root>";
+            XmlInputStreamFormatter<utf8> formatter(
+                MemoryMappedInputStream(AsPointer(xml.cbegin()), AsPointer(xml.cend())));
+            XmlInputStreamFormatter<utf8>::InteriorSection name, value;
+            Assert::IsTrue(formatter.TryBeginElement(name));
+            Assert::IsTrue(formatter.TryCharacterData(value));
+            Assert::IsTrue(formatter.TryBeginElement(name));
+            Assert::AreEqual(45u, formatter.GetLocation()._lineIndex);
+            Assert::IsTrue(formatter.TryAttribute(name, value));
+            Assert::AreEqual(46u, formatter.GetLocation()._lineIndex);
+            Assert::IsTrue(formatter.TryEndElement());
+            Assert::IsTrue(formatter.TryEndElement());
+
+                //  Peeking for character data first must still skip over the <?xml ?> header
+            XmlInputStreamFormatter<utf8> cdataFormatter(
+                MemoryMappedInputStream(AsPointer(xml.cbegin()), AsPointer(xml.cend())));
+            Assert::IsTrue(cdataFormatter.PeekNext(true) == XmlInputStreamFormatter<utf8>::Blob::CharacterData);
+            Assert::IsTrue(cdataFormatter.TryCharacterData(value));
+            Assert::IsTrue(cdataFormatter.TryBeginElement(name));
+            Assert::IsTrue(XlEqString(name, (const utf8*)"root"));
+        }
+
+        TEST_METHOD(DataDocumentParse)
+        {
+                //  DataDocument must produce the same tree as Data, including for
+                //  values that can't be referenced directly from the source text
+            const char testData[] = 
+                "# material settings\n"
+                "material\n"
+                "  name \"quoted value\"\n"
+                "  escaped \"a\\\"b\"\n"
+                "  multiline 'line one\r\nline two'\n"
+                "  list (1, 2, 3)\n"
+                "  width 1024 # trailing comment\n"
+                "  ratio 1.5\n"
+                "  texture a\n"
+                "  texture b\n"
+                "  texture c\n"
+                "  'dotted.name' x\n";
+
+            Data data;
+            Assert::IsTrue(data.Load(testData, int(dimof(testData)-1)));
+
+            DataDocument doc;
+            Assert::IsTrue(doc.Load(MakeStringSection(testData, ArrayEnd(testData)-1), 4));
+
+            std::unique_ptr<Data> clone(doc.Root().CloneAsData());
+            Assert::IsTrue(*clone == data);
+
+            const auto& root = doc.Root();
+            Assert::AreEqual(1024, root.IntAttribute("material.width"));
+            Assert::AreEqual(1.5f, root.FloatAttribute("material.ratio"));
+            Assert::IsTrue(XlEqString(root.StrAttribute("material.escaped"), "a\"b"));
+            Assert::IsTrue(XlEqString(root.StrAttribute("material.multiline"), "line one\nline two"));
+            Assert::IsTrue(XlEqString(root.StrAttribute("material.texture[2]"), "c"));
+            Assert::IsTrue(XlEqString(root.StrAttribute("material.'dotted.name'"), "x"));
+            Assert::IsTrue(root.Attribute("material.texture[3]") == nullptr);
+            Assert::IsTrue(root.Attribute("material.missing") == nullptr);
+
+                //  "material" has enough children to have a child index
+            auto* material = doc.Find("material");
+            unsigned textureCount = 0;
+            for (auto* t = material->ChildWithValue("texture"); t; t = t->NextWithValue("texture"))
+                ++textureCount;
+            Assert::AreEqual(3u, textureCount);
+        }
+
         TEST_METHOD(ClassPropertiesPerformance)
         {
             const std::basic_string<utf8> testString = (const utf8*)R"~~(~~!Format=1; Tab=4
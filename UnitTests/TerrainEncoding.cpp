@@ -0,0 +1,143 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../SceneEngine/TerrainNodeEncoding.h"
+#include "../Utility/PtrUtils.h"
+#include <CppUnitTest.h>
+#include <random>
+#include <vector>
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    static std::vector<uint16> MakeSmoothHeights(std::mt19937& rng, UInt2 dims, unsigned channelCount)
+    {
+            //  Rolling hills, with a little noise (similar to quantized height data)
+        std::vector<uint16> result(dims[0]*dims[1]*channelCount);
+        for (unsigned y=0; y<dims[1]; ++y)
+            for (unsigned x=0; x<dims[0]; ++x)
+                for (unsigned c=0; c<channelCount; ++c)
+                    result[(y*dims[0]+x)*channelCount+c] = uint16(
+                          30000.f + 8000.f * std::sin(float(x) * 0.05f + float(c)) * std::cos(float(y) * 0.04f)
+                        + float(rng() % 9));
+        return result;
+    }
+
+	TEST_CLASS(TerrainEncoding)
+	{
+	public:
+		TEST_METHOD(PredictiveRoundTrip)
+		{
+            std::mt19937 rng(0x5a5a);
+            for (unsigned iteration=0; iteration<500; ++iteration) {
+                UInt2 dims(1 + rng()%70, 1 + rng()%70);
+                unsigned channelCount = 1 + rng()%4;
+
+                    // alternate between smooth and random data (which has the largest residuals)
+                std::vector<uint16> source;
+                if (iteration & 1) {
+                    source = MakeSmoothHeights(rng, dims, channelCount);
+                } else {
+                    source.resize(dims[0]*dims[1]*channelCount);
+                    for (auto& s:source) s = uint16(rng());
+                }
+
+                auto encoded = SceneEngine::EncodeTerrainNode(AsPointer(source.cbegin()), dims, channelCount);
+
+                std::vector<uint16> decoded(source.size(), 0xcdcd);
+                Assert::IsTrue(SceneEngine::DecodeTerrainNode(
+                    AsPointer(decoded.begin()), decoded.size()*sizeof(uint16),
+                    AsPointer(encoded.cbegin()), encoded.size()));
+                Assert::IsTrue(decoded == source);
+
+                    // truncated data and mismatched destinations must be rejected
+                Assert::IsFalse(SceneEngine::DecodeTerrainNode(
+                    AsPointer(decoded.begin()), decoded.size()*sizeof(uint16),
+                    AsPointer(encoded.cbegin()), encoded.size()-1));
+                Assert::IsFalse(SceneEngine::DecodeTerrainNode(
+                    AsPointer(decoded.begin()), (decoded.size()-1)*sizeof(uint16),
+                    AsPointer(encoded.cbegin()), encoded.size()));
+            }
+        }
+
+        TEST_METHOD(PredictiveCompressesSmoothData)
+        {
+            std::mt19937 rng(0x1234);
+            const UInt2 dims(66, 66);
+            auto source = MakeSmoothHeights(rng, dims, 1);
+            auto encoded = SceneEngine::EncodeTerrainNode(AsPointer(source.cbegin()), dims, 1);
+            Assert::IsTrue(encoded.size() * 2 < source.size() * sizeof(uint16));
+
+                // slopes are predicted exactly, so a plane should be almost free
+            std::vector<uint16> plane(dims[0]*dims[1]);
+            for (unsigned y=0; y<dims[1]; ++y)
+                for (unsigned x=0; x<dims[0]; ++x)
+                    plane[y*dims[0]+x] = uint16(1000 + x*37 + y*11);
+            encoded = SceneEngine::EncodeTerrainNode(AsPointer(plane.cbegin()), dims, 1);
+            Assert::IsTrue(encoded.size() * 6 < plane.size() * sizeof(uint16));
+        }
+
+        TEST_METHOD(ErrorBoundedQuantization)
+        {
+                //  Heights in meters, with about 200m of range in the node. With a 5cm
+                //  error bound, every decoded height must be within 5cm of the source, even
+                //  after the predictive encoding round trip. And the coarser step should
+                //  encode smaller than full range quantization
+            std::mt19937 rng(0x4242);
+            const UInt2 dims(66, 66);
+            const float maxError = 0.05f;
+            std::vector<float> heights(dims[0]*dims[1]);
+            for (unsigned y=0; y<dims[1]; ++y)
+                for (unsigned x=0; x<dims[0]; ++x)
+                    heights[y*dims[0]+x] = 
+                          500.f + 100.f * std::sin(float(x) * 0.05f) * std::cos(float(y) * 0.04f)
+                        + float(rng() % 1000) * 0.001f;
+
+            std::vector<uint16> bounded(heights.size()), fullRange(heights.size());
+            auto q = SceneEngine::QuantizeHeights(AsPointer(bounded.begin()), AsPointer(heights.cbegin()), heights.size(), 0xffff, maxError);
+            auto f = SceneEngine::QuantizeHeights(AsPointer(fullRange.begin()), AsPointer(heights.cbegin()), heights.size(), 0xffff, 0.f);
+            Assert::IsTrue(q._maxError <= maxError);
+            Assert::IsTrue(q._step >= 2.f * maxError);
+
+            auto encoded = SceneEngine::EncodeTerrainNode(AsPointer(bounded.cbegin()), dims, 1);
+            std::vector<uint16> decoded(bounded.size());
+            Assert::IsTrue(SceneEngine::DecodeTerrainNode(
+                AsPointer(decoded.begin()), decoded.size()*sizeof(uint16),
+                AsPointer(encoded.cbegin()), encoded.size()));
+            for (size_t c=0; c<heights.size(); ++c)
+                Assert::IsTrue(std::abs(q._minValue + float(decoded[c]) * q._step - heights[c]) <= maxError * 1.001f);
+
+            auto fullRangeEncoded = SceneEngine::EncodeTerrainNode(AsPointer(fullRange.cbegin()), dims, 1);
+            Assert::IsTrue(encoded.size() < fullRangeEncoded.size());
+                //  (full range quantization truncates, so its error is up to one step)
+            Assert::IsTrue(f._maxError <= f._step * 1.05f);
+        }
+
+        TEST_METHOD(ErrorBoundTooSmallForRange)
+        {
+                //  10km of range can't be stored with a 1cm bound in 16 bits (the full range
+                //  step is about 15cm). This must be reported through _maxError, and the
+                //  result must still use the full 16 bit precision
+            const UInt2 dims(34, 34);
+            const float maxError = 0.01f;
+            std::vector<float> heights(dims[0]*dims[1]);
+            for (unsigned c=0; c<heights.size(); ++c)
+                heights[c] = 10000.f * float(c) / float(heights.size()-1) + 0.37f * float(c&3);
+
+            std::vector<uint16> quantized(heights.size());
+            auto q = SceneEngine::QuantizeHeights(AsPointer(quantized.begin()), AsPointer(heights.cbegin()), heights.size(), 0xffff, maxError);
+            Assert::IsTrue(q._maxError > maxError);
+            Assert::IsTrue(q._step <= (10000.f + 2.f) / float(0xffff));
+                //  (half a step, plus float rounding at this magnitude)
+            Assert::IsTrue(q._maxError <= q._step * .55f);
+            for (size_t c=0; c<heights.size(); ++c)
+                Assert::IsTrue(std::abs(q._minValue + float(quantized[c]) * q._step - heights[c]) <= q._maxError * 1.001f);
+        }
+    };
+}
+
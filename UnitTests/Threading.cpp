@@ -7,7 +7,11 @@
 #include "UnitTestHelper.h"
 #include "../Assets/AsyncLoadOperation.h"
 #include "../Utility/Threading/CompletionThreadPool.h"
+#include "../Utility/Threading/FramePipeline.h"
+#include "../Utility/MemoryUtils.h"
+#include "../Utility/IteratorUtils.h"
 #include <CppUnitTest.h>
+#include <random>
 
 namespace UnitTests
 {
@@ -51,6 +55,73 @@ namespace UnitTests
                 }
             }
         }
+
+            //  Simple simulation, split into a "prepare" stage (which owns the simulation
+            //  state) and a "submit" stage (which only reads the prepared buffers)
+        class PipelineReplay
+        {
+        public:
+            std::vector<float>      _simulation;
+            std::vector<float>      _prepared[2];
+            std::vector<unsigned>   _preparedFrames;
+            std::vector<uint64>     _output;
+
+            void Prepare(unsigned bufferIndex, unsigned frameIndex, float elapsedTime)
+            {
+                std::mt19937 rng(frameIndex);
+                for (auto& p:_simulation)
+                    p += elapsedTime * std::uniform_real_distribution<float>(-1.f, 1.f)(rng);
+                _prepared[bufferIndex] = _simulation;
+                _preparedFrames.push_back(frameIndex);
+            }
+
+            void Submit(unsigned bufferIndex)
+            {
+                const auto& b = _prepared[bufferIndex];
+                _output.push_back(Hash64(AsPointer(b.cbegin()), AsPointer(b.cend())));
+            }
+
+            PipelineReplay() : _simulation(4096, 0.f) {}
+        };
+
+        static std::vector<uint64> RunPipelineReplay(CompletionThreadPool& pool, bool pipelined, unsigned frameCount, unsigned switchFrame = ~0u)
+        {
+            PipelineReplay replay;
+            {
+                FramePipeline pipeline(pool, pipelined);
+                FramePipeline::PrepareFunction prepareFn = 
+                    [&replay](unsigned bufferIndex, unsigned frameIndex, float elapsedTime)
+                    { replay.Prepare(bufferIndex, frameIndex, elapsedTime); };
+
+                for (unsigned c=0; c<frameCount; ++c) {
+                    if (c == switchFrame)
+                        pipeline.SetPipelined(!pipeline.IsPipelined());
+                    auto bufferIndex = pipeline.BeginFrame(prepareFn, 1.f/60.f);
+                    replay.Submit(bufferIndex);
+                }
+                pipeline.Sync();
+            }
+
+                //  frames must always be prepared in order, exactly once each
+                //  (the pipelined version will have prepared one extra frame)
+            Assert::IsTrue(replay._preparedFrames.size() >= frameCount);
+            for (unsigned c=0; c<replay._preparedFrames.size(); ++c)
+                Assert::AreEqual(c, replay._preparedFrames[c]);
+            return replay._output;
+        }
+
+        TEST_METHOD(FramePipelineReplay)
+        {
+            CompletionThreadPool pool(1);
+            const unsigned frameCount = 256;
+            auto serial = RunPipelineReplay(pool, false, frameCount);
+            auto pipelined = RunPipelineReplay(pool, true, frameCount);
+            auto switched = RunPipelineReplay(pool, true, frameCount, frameCount/2);
+
+            Assert::AreEqual(frameCount, (unsigned)serial.size());
+            Assert::IsTrue(serial == pipelined);
+            Assert::IsTrue(serial == switched);
+        }
     };
 }
 
@@ -11,11 +11,21 @@
 #include "../Utility/Streams/Stream.h"
 #include "../Utility/Streams/StreamTypes.h"
 #include "../Utility/Streams/PathUtils.h"
+#include "../Utility/Streams/FileSystemMonitor.h"
+#include "../Utility/Streams/FileSystemMonitorInternal.h"
+#include "../Utility/Threading/LockFree.h"
+#include "../Utility/Threading/ThreadingUtils.h"
 #include "../Utility/FunctionUtils.h"
 #include "../Utility/MemoryUtils.h"
+#include "../Utility/HeapUtils.h"
+#include "../Utility/PtrUtils.h"
+#include "../Utility/StringUtils.h"
 #include "../Math/Vector.h"
 #include <CppUnitTest.h>
 #include <stdexcept>
+#include <random>
+#include <algorithm>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -36,6 +46,21 @@ namespace UnitTests
     bool ThrowOnDestructor::s_expectingDestroy = false;
     unsigned ThrowOnDestructor::s_destroyCount = 0;
 
+    class RecordingChangeCallback : public OnChangeCallback
+    {
+    public:
+        std::vector<unsigned> _batchIds;            // GetFileChangeBatchId() for each call
+        std::vector<unsigned> _otherThreadBatchIds; // GetFileChangeBatchId() from another thread during each call
+
+        void OnChange()
+        {
+            _batchIds.push_back(GetFileChangeBatchId());
+            unsigned otherThreadId = ~0u;
+            std::thread([&otherThreadId]() { otherThreadId = GetFileChangeBatchId(); }).join();
+            _otherThreadBatchIds.push_back(otherThreadId);
+        }
+    };
+
     TEST_CLASS(Utilities)
     {
     public:
@@ -258,6 +283,162 @@ namespace UnitTests
                 ConstHash64<'1234', '5678', '90qw', 'erty'>::Value,
                 ConstHash64FromString(s1.begin(), s1.end()));
         }
+
+        TEST_METHOD(Hash64StreamingTest)
+        {
+                //  Hasher64 and Hash64Batch must match Hash64 exactly, regardless of
+                //  how the input is split up. Cover the short & long input paths, and
+                //  lengths that straddle the internal block & stripe boundaries
+            std::mt19937 rng(6523);
+            std::vector<uint8> data(20*1024);
+            for (auto& d:data) d = uint8(rng());
+
+            const size_t lengths[] = { 0, 1, 3, 8, 16, 17, 100, 128, 129, 240, 255, 256, 1023, 1024, 1025, 4099, 20*1024 };
+            for (auto len:lengths) {
+                auto* begin = AsPointer(data.cbegin());
+                auto expected = Hash64(begin, begin+len);
+
+                Hasher64 hasher;
+                size_t i = 0;
+                while (i < len) {
+                    auto chunk = std::min(size_t(rng() % 300), len-i);
+                    hasher.Update(begin+i, begin+i+chunk);
+                    i += chunk;
+                }
+                Assert::AreEqual(expected, hasher.Digest());
+
+                hasher.Reset(1234ull);
+                hasher.Update(begin, begin+len);
+                Assert::AreEqual(Hash64(begin, begin+len, 1234ull), hasher.Digest());
+            }
+
+            std::vector<std::string> strings;
+            for (unsigned c=0; c<100; ++c)
+                strings.push_back(std::string(rng()%70, char('a' + c%26)));
+            std::vector<StringSection<char>> sections;
+            for (const auto& s:strings) sections.push_back(MakeStringSection(s));
+            std::vector<uint64> results(strings.size());
+            Hash64Batch(AsPointer(sections.cbegin()), sections.size(), AsPointer(results.begin()));
+            for (size_t c=0; c<strings.size(); ++c)
+                Assert::AreEqual(Hash64(AsPointer(strings[c].cbegin()), AsPointer(strings[c].cend())), results[c]);
+        }
+
+        TEST_METHOD(TLSFHeapTest)
+        {
+                // Random allocations & deallocations (including partial deallocations of
+                // allocated blocks), checking that the heap's book keeping remains consistent
+            const unsigned heapSize = 4*1024*1024;
+            TLSFHeap heap(heapSize);
+            std::vector<std::pair<unsigned,unsigned>> allocations;
+            unsigned allocatedSpace = 0;
+            std::srand(0);
+            for (unsigned c=0; c<50000; ++c) {
+                if ((std::rand()%3)==0 && !allocations.empty()) {
+                    auto i = allocations.begin() + (std::rand()%allocations.size());
+                    unsigned front = heap.AlignSize(i->second/2);
+                    unsigned third = heap.AlignSize(i->second/3), twoThirds = heap.AlignSize(2*i->second/3);
+                    if (third && twoThirds > third && twoThirds < heap.AlignSize(i->second) && (std::rand()&1)) {
+                            // release the middle of the block first, then the ends
+                        Assert::IsTrue(heap.Deallocate(i->first + third, twoThirds - third));
+                        Assert::IsTrue(heap.Deallocate(i->first + twoThirds, i->second - twoThirds));
+                        Assert::IsTrue(heap.Deallocate(i->first, third));
+                    } else if (front < heap.AlignSize(i->second)) {
+                        Assert::IsTrue(heap.Deallocate(i->first + front, i->second - front));
+                        Assert::IsTrue(heap.Deallocate(i->first, front));
+                    } else {
+                        Assert::IsTrue(heap.Deallocate(i->first, i->second));
+                    }
+                    allocatedSpace -= heap.AlignSize(i->second);
+                    allocations.erase(i);
+                } else {
+                    unsigned size = std::rand()%0x2000 + 1;
+                    unsigned alignment = (std::rand()%4)==0 ? 1024 : 16;
+                    unsigned allocation = heap.AllocateAligned(size, alignment);
+                    if (allocation != ~unsigned(0x0)) {
+                        Assert::AreEqual(0u, allocation%alignment);
+                        allocations.push_back(std::make_pair(allocation, size));
+                        allocatedSpace += heap.AlignSize(size);
+                    }
+                }
+                Assert::AreEqual(allocatedSpace, heap.CalculateAllocatedSpace());
+
+                if ((c%1000)==0) {
+                    TLSFHeap dupe = heap;
+                    dupe.PerformDefrag(dupe.CalculateDefragSteps());
+                    Assert::AreEqual(allocatedSpace, dupe.CalculateAllocatedSpace());
+                    Assert::AreEqual(dupe.CalculateAvailableSpace(), dupe.CalculateLargestFreeBlock());
+                }
+            }
+
+            for (auto i=allocations.cbegin(); i!=allocations.cend(); ++i) {
+                heap.Deallocate(i->first, i->second);
+            }
+            Assert::IsTrue(heap.IsEmpty());
+            Assert::AreEqual(heapSize, heap.CalculateLargestFreeBlock());
+            Assert::AreEqual(0.f, heap.CalculateFragmentationMetrics()._fragmentation);
+        }
+
+        TEST_METHOD(FileChangeBatching)
+        {
+            Utility::Internal::ClearFileChanges();
+            auto a = std::make_shared<RecordingChangeCallback>();
+            auto b = std::make_shared<RecordingChangeCallback>();
+
+                //  Each callback is executed once per batch, no matter how many times
+                //  it was queued, and all callbacks in a batch see the same batch id
+            std::weak_ptr<OnChangeCallback> changes[] = { a, b, a, a };
+            Utility::Internal::QueueFileChanges(changes, ArrayEnd(changes));
+            Utility::Internal::FlushFileChanges(true);
+            Assert::AreEqual(size_t(1), a->_batchIds.size());
+            Assert::AreEqual(size_t(1), b->_batchIds.size());
+            Assert::AreNotEqual(0u, a->_batchIds[0]);
+            Assert::AreEqual(a->_batchIds[0], b->_batchIds[0]);
+            Assert::AreEqual(0u, GetFileChangeBatchId());
+
+                //  The batch id is only visible on the delivering thread
+            Assert::AreEqual(0u, a->_otherThreadBatchIds[0]);
+
+                //  The next batch gets a new id
+            Utility::Internal::QueueFileChanges(changes, &changes[1]);
+            Utility::Internal::FlushFileChanges(true);
+            Assert::AreEqual(size_t(2), a->_batchIds.size());
+            Assert::AreNotEqual(a->_batchIds[0], a->_batchIds[1]);
+            Assert::AreEqual(size_t(1), b->_batchIds.size());
+        }
+
+        TEST_METHOD(FileChangeDebouncing)
+        {
+            Utility::Internal::ClearFileChanges();
+            Assert::AreEqual(XL_INFINITE, Utility::Internal::GetFileChangeFlushTimeout());
+
+            const unsigned debounce = 50;
+            SetFileSystemMonitorDebounce(debounce);
+            auto a = std::make_shared<RecordingChangeCallback>();
+            std::weak_ptr<OnChangeCallback> changes[] = { a };
+
+                //  Changes aren't delivered until the debounce period has passed
+                //  without any new changes
+            Utility::Internal::QueueFileChanges(changes, ArrayEnd(changes));
+            auto timeout = Utility::Internal::GetFileChangeFlushTimeout();
+            Assert::IsTrue(timeout > 0 && timeout <= debounce);
+            Utility::Internal::FlushFileChanges(false);
+            Assert::AreEqual(size_t(0), a->_batchIds.size());
+
+            Threading::Sleep(debounce/2);
+            Utility::Internal::QueueFileChanges(changes, ArrayEnd(changes));
+            Threading::Sleep(debounce/2 + 5);
+            Assert::AreNotEqual(0u, Utility::Internal::GetFileChangeFlushTimeout());     // (restarted by the second change)
+            Utility::Internal::FlushFileChanges(false);
+            Assert::AreEqual(size_t(0), a->_batchIds.size());
+
+            Threading::Sleep(debounce + 5);
+            Assert::AreEqual(0u, Utility::Internal::GetFileChangeFlushTimeout());
+            Utility::Internal::FlushFileChanges(false);
+            Assert::AreEqual(size_t(1), a->_batchIds.size());
+            Assert::AreEqual(XL_INFINITE, Utility::Internal::GetFileChangeFlushTimeout());
+
+            SetFileSystemMonitorDebounce(100);
+        }
     };
 }
 
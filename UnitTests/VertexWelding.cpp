@@ -0,0 +1,196 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../RenderCore/Assets/MeshDatabase.h"
+#include "../Utility/Threading/CompletionThreadPool.h"
+#include "../Math/Vector.h"
+#include <CppUnitTest.h>
+#include <vector>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    using namespace RenderCore::Assets::GeoProc;
+
+    static void AddFloat3Stream(MeshDatabase& mesh, const std::vector<Float3>& values, const char semantic[])
+    {
+        mesh.AddStream(
+            CreateRawDataSource(
+                AsPointer(values.cbegin()), AsPointer(values.cend()),
+                values.size(), sizeof(Float3), RenderCore::Metal::NativeFormat::R32G32B32_FLOAT),
+            std::vector<unsigned>(), semantic, 0);
+    }
+
+    static Float3 GetPosition(const MeshDatabase& mesh, unsigned vertex)
+    {
+        return mesh.GetUnifiedElement<Float3>(vertex, mesh.FindElement("POSITION"));
+    }
+
+        //  A cube with 3 vertices at each corner (one for each face that touches it)
+    static MeshDatabase MakeCube(bool smoothNormals)
+    {
+        std::vector<Float3> positions, normals;
+        for (unsigned corner=0; corner<8; ++corner) {
+            Float3 p(float(corner&1), float((corner>>1)&1), float((corner>>2)&1));
+            for (unsigned axis=0; axis<3; ++axis) {
+                positions.push_back(p);
+                Float3 n(0.f, 0.f, 0.f);
+                if (smoothNormals) n = Normalize(Float3(p - Float3(.5f, .5f, .5f)));
+                else n[axis] = (p[axis] > .5f) ? 1.f : -1.f;
+                normals.push_back(n);
+            }
+        }
+        MeshDatabase mesh;
+        AddFloat3Stream(mesh, positions, "POSITION");
+        AddFloat3Stream(mesh, normals, "NORMAL");
+        return mesh;
+    }
+
+        //  A grid of positions, where each position appears several times with a small
+        //  amount of noise (like the output of an exporter that writes vertices per face)
+    static MeshDatabase MakeNoisyGrid(unsigned gridDim, unsigned copies, float noiseRange)
+    {
+        std::vector<Float3> positions;
+        std::mt19937 rng(0x48);
+        std::uniform_real_distribution<float> noise(-noiseRange, noiseRange);
+        for (unsigned y=0; y<gridDim; ++y)
+            for (unsigned x=0; x<gridDim; ++x)
+                for (unsigned c=0; c<copies; ++c)
+                    positions.push_back(Float3(float(x) + noise(rng), float(y) + noise(rng), noise(rng)));
+        std::shuffle(positions.begin(), positions.end(), rng);
+
+        MeshDatabase mesh;
+        AddFloat3Stream(mesh, positions, "POSITION");
+        return mesh;
+    }
+
+	TEST_CLASS(VertexWelding)
+	{
+	public:
+		TEST_METHOD(WeldsWithinTolerance)
+		{
+            auto mesh = MakeNoisyGrid(32, 4, 1e-5f);
+            std::vector<Float3> original;
+            for (unsigned v=0; v<mesh.GetUnifiedVertexCount(); ++v)
+                original.push_back(GetPosition(mesh, v));
+
+            WeldingSettings settings;
+            std::vector<unsigned> mapping;
+            WeldVertices(mapping, mesh, settings);
+            Assert::AreEqual(size_t(32*32), mesh.GetUnifiedVertexCount());
+            Assert::AreEqual(original.size(), mapping.size());
+
+                //  Every vertex must be mapped onto a vertex within the threshold. And the new
+                //  vertices must keep the original ordering
+            unsigned lastNewVertex = 0;
+            for (unsigned v=0; v<mapping.size(); ++v) {
+                Assert::IsTrue(mapping[v] < mesh.GetUnifiedVertexCount());
+                Assert::IsTrue(Magnitude(Float3(GetPosition(mesh, mapping[v]) - original[v])) <= 1e-4f);
+                Assert::IsTrue(mapping[v] <= lastNewVertex + 1);
+                lastNewVertex = std::max(lastNewVertex, mapping[v]);
+            }
+
+                //  With a zero threshold, nothing in the noisy grid can be welded
+            auto mesh2 = MakeNoisyGrid(32, 4, 1e-5f);
+            settings._semanticThresholds.clear();
+            settings._defaultThreshold = 0.f;
+            WeldVertices(mapping, mesh2, settings);
+            Assert::AreEqual(size_t(32*32*4), mesh2.GetUnifiedVertexCount());
+        }
+
+        TEST_METHOD(PreservesHardEdges)
+        {
+            std::vector<unsigned> mapping;
+            auto hardCube = MakeCube(false);
+            WeldVertices(mapping, hardCube, WeldingSettings());
+            Assert::AreEqual(size_t(24), hardCube.GetUnifiedVertexCount());
+
+            auto smoothCube = MakeCube(true);
+            WeldVertices(mapping, smoothCube, WeldingSettings());
+            Assert::AreEqual(size_t(8), smoothCube.GetUnifiedVertexCount());
+            for (unsigned v=0; v<24; ++v)
+                Assert::AreEqual(v/3, mapping[v]);
+        }
+
+        TEST_METHOD(ChainsDontCreep)
+        {
+                //  A line of vertices, each closer than the threshold to the next. Welding
+                //  must never move a vertex further than the threshold
+            const float threshold = 1e-3f;
+            std::vector<Float3> positions;
+            for (unsigned c=0; c<100; ++c)
+                positions.push_back(Float3(float(c) * .4f * threshold, 0.f, 0.f));
+            MeshDatabase mesh;
+            AddFloat3Stream(mesh, positions, "POSITION");
+
+            WeldingSettings settings;
+            settings._semanticThresholds.clear();
+            settings._defaultThreshold = threshold;
+            std::vector<unsigned> mapping;
+            WeldVertices(mapping, mesh, settings);
+            Assert::IsTrue(mesh.GetUnifiedVertexCount() > 1 && mesh.GetUnifiedVertexCount() < 100);
+            for (unsigned v=0; v<mapping.size(); ++v)
+                Assert::IsTrue(Magnitude(Float3(GetPosition(mesh, mapping[v]) - positions[v])) <= threshold);
+        }
+
+        TEST_METHOD(ThreadedMatchesSerial)
+        {
+            WeldingSettings settings;
+            settings._chunkSize = 1000;     // (lots of chunks)
+
+            auto serialMesh = MakeNoisyGrid(100, 5, 1e-4f);
+            std::vector<unsigned> serialMapping;
+            WeldVertices(serialMapping, serialMesh, settings);
+
+            CompletionThreadPool pool(4);
+            auto threadedMesh = MakeNoisyGrid(100, 5, 1e-4f);
+            std::vector<unsigned> threadedMapping;
+            WeldVertices(threadedMapping, threadedMesh, settings, &pool);
+
+            Assert::IsTrue(serialMapping == threadedMapping);
+            Assert::AreEqual(serialMesh.GetUnifiedVertexCount(), threadedMesh.GetUnifiedVertexCount());
+            Assert::IsTrue(serialMesh.GetUnifiedVertexCount() < 100*100*5);
+        }
+
+        TEST_METHOD(SkinnedKeepsPositionIndices)
+        {
+                //  Two coincident source positions (as for vertices bound to different
+                //  joints), each referenced by 2 unified vertices. Skin weights are bound by
+                //  position index, so with _matchPositionIndices only vertices that share a
+                //  position index may be welded
+            auto makeMesh = []()
+            {
+                std::vector<Float3> positions { Float3(1.f, 2.f, 3.f), Float3(1.f, 2.f, 3.f) };
+                MeshDatabase mesh;
+                mesh.AddStream(
+                    CreateRawDataSource(
+                        AsPointer(positions.cbegin()), AsPointer(positions.cend()),
+                        positions.size(), sizeof(Float3), RenderCore::Metal::NativeFormat::R32G32B32_FLOAT),
+                    std::vector<unsigned>{ 0, 0, 1, 1 }, "POSITION", 0);
+                return mesh;
+            };
+
+            std::vector<unsigned> mapping;
+            auto unskinned = makeMesh();
+            WeldVertices(mapping, unskinned, WeldingSettings());
+            Assert::AreEqual(size_t(1), unskinned.GetUnifiedVertexCount());
+
+            auto skinned = makeMesh();
+            WeldingSettings settings;
+            settings._matchPositionIndices = true;
+            WeldVertices(mapping, skinned, settings);
+            Assert::AreEqual(size_t(2), skinned.GetUnifiedVertexCount());
+
+            const unsigned originalPositionIndices[] = { 0, 0, 1, 1 };
+            auto positionIndices = skinned.BuildUnifiedVertexIndexToPositionIndex();
+            for (unsigned v=0; v<4; ++v)
+                Assert::AreEqual(originalPositionIndices[v], positionIndices[mapping[v]]);
+        }
+    };
+}
+
@@ -187,12 +187,13 @@ namespace Utility
 
         #endif
 
-    #elif COMPILER_ACTIVE == COMPILER_GCC
+    #elif COMPILER_ACTIVE == COMPILER_TYPE_GCC
 
-        inline uint32 xl_ctz4(const uint32& x) { __builtin_ctz(x); }
-        inline uint32 xl_clz4(const uint32& x) { __builtin_clz(x); }
-        inline uint32 xl_ctz8(const uint64& x) { __builtin_ctzll(x); }
-        inline uint32 xl_clz8(const uint64& x) { __builtin_clzll(x); }
+            // (the builtins are undefined for 0, so match the MSVC versions above for that case)
+        inline uint32 xl_ctz4(const uint32& x) { return x ? (uint32)__builtin_ctz(x) : 32; }
+        inline uint32 xl_clz4(const uint32& x) { return x ? (uint32)__builtin_clz(x) : 32; }
+        inline uint32 xl_ctz8(const uint64& x) { return x ? (uint32)__builtin_ctzll(x) : 64; }
+        inline uint32 xl_clz8(const uint64& x) { return x ? (uint32)__builtin_clzll(x) : 64; }
 
     #else
 
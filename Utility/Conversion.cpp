@@ -24,7 +24,11 @@ namespace Conversion
     template<> std::basic_string<wchar_t> Convert(uint64 input)
     {
         wchar_t buffer[64];
-        _ui64tow_s(input, buffer, dimof(buffer), 10);
+        #if CLIBRARIES_ACTIVE == CLIBRARIES_MSVC
+            _ui64tow_s(input, buffer, dimof(buffer), 10);
+        #else
+            swprintf(buffer, dimof(buffer), L"%llu", (unsigned long long)input);
+        #endif
         return buffer;
     }
 
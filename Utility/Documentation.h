@@ -60,6 +60,7 @@
             LRUCache | <i>Records a finite subset of the most recently used items of a larger set</i>
             MiniHeap | <i>Moderate performance (but highly flexible) heap implementation. Used for small and special case heap implementations</i>
             SpanningHeap | <i>Heap management utility for arbitrarily sized blocks</i>
+            TLSFHeap | <i>Constant time two-level segregated fit heap for managing large buffers with 32 bit offsets</i>
             BitHeap | <i>Records allocated/deallocated status for a fixed set of equal heap blocks</i>
 
     ## Misc
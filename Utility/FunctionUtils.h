@@ -9,8 +9,10 @@
 #include "IteratorUtils.h"
 #include "PtrUtils.h"
 #include "../Core/Exceptions.h"
+#include "../Core/Types.h"
 #include <functional>
 #include <utility>
+#include <stdexcept>
 #include <vector>
 #include <stdint.h>
 
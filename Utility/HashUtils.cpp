@@ -7,30 +7,377 @@
 #include "MemoryUtils.h"
 #include "PtrUtils.h"
 #include "StringUtils.h"
-#include "../Foreign/Hash/MurmurHash2.h"
+#include "SystemUtils.h"
+#include "../Core/SelectConfiguration.h"
 #include "../Foreign/Hash/MurmurHash3.h"
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #define HASH_SSE2 1
+    #include <emmintrin.h>
+    #include <immintrin.h>
+    #if COMPILER_ACTIVE == COMPILER_TYPE_GCC
+        #define HASH_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #define HASH_TARGET_AVX2
+    #endif
+#else
+    #define HASH_SSE2 0
+#endif
+
+#if COMPILER_ACTIVE == COMPILER_TYPE_MSVC
+    #include <intrin.h>
+#endif
 
 namespace Utility
 {
-    uint64 Hash64(const void* begin, const void* end, uint64 seed)
+            //
+            //      Hash64 is a 64 bit hash built in the same way as XXH3 (see
+            //      https://github.com/Cyan4973/xxHash). But it is not XXH3 and won't
+            //      produce the same values!
+            //
+            //      Short inputs are mixed with a few 64 bit multiplies. Long inputs are
+            //      processed in 64 byte "stripes", with 8 independant 64 bit accumulators.
+            //      Each accumulator lane only uses 32x32->64 multiplies, which map directly
+            //      onto _mm_mul_epu32 / _mm256_mul_epu32. So the SSE2 and AVX2 paths
+            //      produce exactly the same results as the scalar path.
+            //
+            //      Every 16 stripes (a "block") the accumulators are scrambled, so that
+            //      the low bits don't lose entropy.
+            //
+
+    static const uint64 Prime32_1 = 0x9E3779B1ull;
+    static const uint64 Prime32_2 = 0x85EBCA77ull;
+    static const uint64 Prime32_3 = 0xC2B2AE3Dull;
+    static const uint64 Prime64_1 = 0x9E3779B185EBCA87ull;
+    static const uint64 Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+    static const uint64 Prime64_3 = 0x165667B19E3779F9ull;
+    static const uint64 Prime64_4 = 0x85EBCA77C2B2AE63ull;
+    static const uint64 Prime64_5 = 0x27D4EB2F165667C5ull;
+
+    static const unsigned SecretWords = 24;
+    static const unsigned StripeLength = 64;
+    static const unsigned StripesPerBlock = SecretWords - StripeLength/8;    // 16
+    static const unsigned BlockLength = StripeLength * StripesPerBlock;
+    static const unsigned ScrambleSecretWord = SecretWords - StripeLength/8;
+    static const unsigned LastStripeSecretWord = ScrambleSecretWord - 1;
+    static const unsigned MergeSecretWord = 3;
+    static const unsigned StreamBufferSize = 256;
+
+        // (arbitrary random numbers)
+    static const uint64 s_baseSecret[SecretWords] =
     {
-                //
-                //      Use MurmurHash2 to generate a 64 bit value.
-                //      (MurmurHash3 only generates 32 bit and 128 bit values)
-                //      
-                //      Note that there may be some compatibility problems, because
-                //      murmur hash doesn't generate the same value for big and little
-                //      endian processors. It's not clear if the quality of the 
-                //      hashing is as good on big endian processors.
-                //
-                //      "MurmurHash64A" is optimised for 64 bit processors; 
-                //      "MurmurHash64B" is for 32 bit processors.
-                //
-        #if TARGET_64BIT
-            return MurmurHash64A(begin, int(size_t(end)-size_t(begin)), seed);
+        0xFAF44D770B4318CDull, 0x2585D1A23DF3833Cull, 0x9611ADEEE5BBE039ull, 0x8781A20715D68A57ull,
+        0x6BF408DF56E9086Dull, 0x29A7E1E71541A6D4ull, 0xCD4AC43D3F2654E4ull, 0xAEF2A8F2BAC44392ull,
+        0x30733A1E55A283DAull, 0xABE4DFC480BF355Dull, 0x45E1D553C3679101ull, 0x1D43D642F3AF2C22ull,
+        0xBD3CE7FCE16EE4AAull, 0x0A7F6D02F2A009B4ull, 0xB82D5164D92BE4A0ull, 0x8677CC034B0EF955ull,
+        0x25613DAD3801B10Full, 0x127DBCA1A651643Aull, 0x6D29454F087449E9ull, 0xD8268AFF32C0993Full,
+        0xA55B746149D1654Bull, 0xE2C5CBFFF77117C1ull, 0x7F79B28B87E63E6Eull, 0x0B4089000BD26713ull,
+    };
+
+    static inline uint64 Read64(const void* p) { uint64 result; memcpy(&result, p, sizeof(result)); return result; }
+    static inline uint32 Read32(const void* p) { uint32 result; memcpy(&result, p, sizeof(result)); return result; }
+    static inline uint64 Rotl64(uint64 x, unsigned r) { return (x << r) | (x >> (64 - r)); }
+
+    static inline uint64 Mul128Fold64(uint64 lhs, uint64 rhs)
+    {
+            //  Full 64x64->128 bit multiply, and then xor the high and low parts
+        #if COMPILER_ACTIVE == COMPILER_TYPE_MSVC && TARGET_64BIT
+            uint64 high;
+            uint64 low = _umul128(lhs, rhs, &high);
+            return low ^ high;
+        #elif COMPILER_ACTIVE == COMPILER_TYPE_GCC && TARGET_64BIT
+            auto product = (unsigned __int128)lhs * (unsigned __int128)rhs;
+            return uint64(product) ^ uint64(product >> 64);
         #else
-            return MurmurHash64B(begin, size_t(end)-size_t(begin), seed);
+            uint64 loLo = (lhs & 0xffffffff) * (rhs & 0xffffffff);
+            uint64 hiLo = (lhs >> 32) * (rhs & 0xffffffff);
+            uint64 loHi = (lhs & 0xffffffff) * (rhs >> 32);
+            uint64 hiHi = (lhs >> 32) * (rhs >> 32);
+            uint64 cross = (loLo >> 32) + (hiLo & 0xffffffff) + loHi;
+            uint64 upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+            uint64 lower = (cross << 32) | (loLo & 0xffffffff);
+            return lower ^ upper;
+        #endif
+    }
+
+    static inline uint64 Avalanche(uint64 h)
+    {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9ull;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static inline uint64 StrongAvalanche(uint64 h, uint64 length)
+    {
+            //  Used for very short inputs, where there is only a single multiply
+            //  before this point
+        h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+        h *= 0x9FB21C651E98DF25ull;
+        h ^= (h >> 35) + length;
+        h *= 0x9FB21C651E98DF25ull;
+        return h ^ (h >> 28);
+    }
+
+    static inline uint64 Mix16(const uint8* p, const uint64* secret, uint64 seed)
+    {
+        return Mul128Fold64(Read64(p) ^ (secret[0] + seed), Read64(p+8) ^ (secret[1] - seed));
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static uint64 Hash0To16(const uint8* p, size_t length, uint64 seed)
+    {
+        const auto* secret = s_baseSecret;
+        if (length > 8) {
+            auto lo = Read64(p) ^ ((secret[3] ^ secret[4]) + seed);
+            auto hi = Read64(p + length - 8) ^ ((secret[5] ^ secret[6]) - seed);
+            auto acc = uint64(length) + Rotl64(lo, 32) + hi + Mul128Fold64(lo, hi);
+            return Avalanche(acc);
+        }
+
+        if (length >= 4) {
+                //  (the two reads overlap when length < 8)
+            auto input = uint64(Read32(p + length - 4)) + (uint64(Read32(p)) << 32);
+            return StrongAvalanche(input ^ ((secret[1] ^ secret[2]) - seed), length);
+        }
+
+        if (length > 0) {
+            auto combined = (uint32(p[0]) << 16) | (uint32(p[length>>1]) << 24) | uint32(p[length-1]) | (uint32(length) << 8);
+            return StrongAvalanche(uint64(combined) ^ (uint64(uint32(secret[0]) ^ uint32(secret[0] >> 32)) + seed), length);
+        }
+
+        return Avalanche(seed ^ secret[7] ^ secret[8]);
+    }
+
+    static uint64 Hash17To128(const uint8* p, size_t length, uint64 seed)
+    {
+        const auto* secret = s_baseSecret;
+        uint64 acc = uint64(length) * Prime64_1;
+        if (length > 32) {
+            if (length > 64) {
+                if (length > 96) {
+                    acc += Mix16(p+48, secret+12, seed);
+                    acc += Mix16(p+length-64, secret+14, seed);
+                }
+                acc += Mix16(p+32, secret+8, seed);
+                acc += Mix16(p+length-48, secret+10, seed);
+            }
+            acc += Mix16(p+16, secret+4, seed);
+            acc += Mix16(p+length-32, secret+6, seed);
+        }
+        acc += Mix16(p, secret+0, seed);
+        acc += Mix16(p+length-16, secret+2, seed);
+        return Avalanche(acc);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static void AccumulateStripes_Scalar(uint64 acc[8], const uint8* p, const uint64* secret, size_t stripeCount)
+    {
+        for (size_t s=0; s<stripeCount; ++s) {
+            const auto* stripe = p + s*StripeLength;
+            for (unsigned j=0; j<8; ++j) {
+                auto data = Read64(stripe + j*8);
+                auto key = data ^ secret[s+j];
+                acc[j^1] += data;
+                acc[j] += (key & 0xffffffff) * (key >> 32);
+            }
+        }
+    }
+
+    static void ScrambleAccumulators_Scalar(uint64 acc[8], const uint64* secret)
+    {
+        for (unsigned j=0; j<8; ++j) {
+            auto a = acc[j];
+            a ^= a >> 47;
+            a ^= secret[j];
+            a *= Prime32_1;
+            acc[j] = a;
+        }
+    }
+
+    #if HASH_SSE2
+        static void AccumulateStripes_SSE2(uint64 acc[8], const uint8* p, const uint64* secret, size_t stripeCount)
+        {
+            __m128i a[4];
+            for (unsigned j=0; j<4; ++j) a[j] = _mm_loadu_si128((const __m128i*)&acc[j*2]);
+
+            for (size_t s=0; s<stripeCount; ++s) {
+                const auto* stripe = p + s*StripeLength;
+                for (unsigned j=0; j<4; ++j) {
+                    auto data = _mm_loadu_si128((const __m128i*)(stripe + j*16));
+                    auto key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)&secret[s+j*2]));
+                        //  multiply the low 32 bits of each lane with the high 32 bits
+                    auto keyHigh = _mm_shuffle_epi32(key, _MM_SHUFFLE(0,3,0,1));
+                    auto product = _mm_mul_epu32(key, keyHigh);
+                        //  the data is added to the neighbouring lane
+                    auto dataSwap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1,0,3,2));
+                    a[j] = _mm_add_epi64(a[j], _mm_add_epi64(product, dataSwap));
+                }
+            }
+
+            for (unsigned j=0; j<4; ++j) _mm_storeu_si128((__m128i*)&acc[j*2], a[j]);
+        }
+
+        static void ScrambleAccumulators_SSE2(uint64 acc[8], const uint64* secret)
+        {
+            const auto prime = _mm_set1_epi32(int(Prime32_1));
+            for (unsigned j=0; j<4; ++j) {
+                auto a = _mm_loadu_si128((const __m128i*)&acc[j*2]);
+                a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+                a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)&secret[j*2]));
+                    //  64 bit multiply by a 32 bit constant, from two 32x32->64 multiplies
+                auto productLow = _mm_mul_epu32(a, prime);
+                auto productHigh = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+                a = _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32));
+                _mm_storeu_si128((__m128i*)&acc[j*2], a);
+            }
+        }
+
+        HASH_TARGET_AVX2 static void AccumulateStripes_AVX2(uint64 acc[8], const uint8* p, const uint64* secret, size_t stripeCount)
+        {
+            auto a0 = _mm256_loadu_si256((const __m256i*)&acc[0]);
+            auto a1 = _mm256_loadu_si256((const __m256i*)&acc[4]);
+
+            for (size_t s=0; s<stripeCount; ++s) {
+                const auto* stripe = p + s*StripeLength;
+                auto data0 = _mm256_loadu_si256((const __m256i*)(stripe));
+                auto data1 = _mm256_loadu_si256((const __m256i*)(stripe + 32));
+                auto key0 = _mm256_xor_si256(data0, _mm256_loadu_si256((const __m256i*)&secret[s]));
+                auto key1 = _mm256_xor_si256(data1, _mm256_loadu_si256((const __m256i*)&secret[s+4]));
+                auto product0 = _mm256_mul_epu32(key0, _mm256_shuffle_epi32(key0, _MM_SHUFFLE(0,3,0,1)));
+                auto product1 = _mm256_mul_epu32(key1, _mm256_shuffle_epi32(key1, _MM_SHUFFLE(0,3,0,1)));
+                a0 = _mm256_add_epi64(a0, _mm256_add_epi64(product0, _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1,0,3,2))));
+                a1 = _mm256_add_epi64(a1, _mm256_add_epi64(product1, _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1,0,3,2))));
+            }
+
+            _mm256_storeu_si256((__m256i*)&acc[0], a0);
+            _mm256_storeu_si256((__m256i*)&acc[4], a1);
+            _mm256_zeroupper();
+        }
+    #endif
+
+    namespace Internal
+    {
+        class HashImplementation
+        {
+        public:
+            void (*_accumulate)(uint64 acc[8], const uint8* p, const uint64* secret, size_t stripeCount);
+            void (*_scramble)(uint64 acc[8], const uint64* secret);
+        };
+    }
+
+    static Internal::HashImplementation SelectHashImplementation()
+    {
+        Internal::HashImplementation result;
+        result._accumulate = &AccumulateStripes_Scalar;
+        result._scramble = &ScrambleAccumulators_Scalar;
+        #if HASH_SSE2
+            const auto& features = XlGetCPUFeatures();
+            if (features._sse2) {
+                result._accumulate = &AccumulateStripes_SSE2;
+                result._scramble = &ScrambleAccumulators_SSE2;
+            }
+            if (features._avx2) {
+                    //  (scrambling happens only once per 1KB, so there's little
+                    //  to gain from an AVX2 version)
+                result._accumulate = &AccumulateStripes_AVX2;
+            }
         #endif
+        return result;
+    }
+
+    static const Internal::HashImplementation& GetHashImplementation()
+    {
+        static Internal::HashImplementation impl = SelectHashImplementation();
+        return impl;
+    }
+
+    static void InitAccumulators(uint64 acc[8])
+    {
+        acc[0] = Prime32_3; acc[1] = Prime64_1; acc[2] = Prime64_2; acc[3] = Prime64_3;
+        acc[4] = Prime64_4; acc[5] = Prime32_2; acc[6] = Prime64_5; acc[7] = Prime32_1;
+    }
+
+    static void DeriveSecret(uint64 result[SecretWords], uint64 seed)
+    {
+        for (unsigned c=0; c<SecretWords; c+=2) {
+            result[c] = s_baseSecret[c] + seed;
+            result[c+1] = s_baseSecret[c+1] - seed;
+        }
+    }
+
+    static const uint64* GetSecret(uint64 seed, uint64 buffer[SecretWords])
+    {
+            //  Most hashes use the default seed, so we can avoid deriving
+            //  the secret in that case
+        static struct DefaultSecret
+        {
+            uint64 _secret[SecretWords];
+            DefaultSecret() { DeriveSecret(_secret, DefaultSeed64); }
+        } defaultSecret;
+        if (seed == DefaultSeed64) return defaultSecret._secret;
+        DeriveSecret(buffer, seed);
+        return buffer;
+    }
+
+    static uint64 MergeAccumulators(const uint64 acc[8], const uint64* secret, uint64 start)
+    {
+        auto result = start;
+        for (unsigned c=0; c<4; ++c)
+            result += Mul128Fold64(acc[c*2] ^ secret[MergeSecretWord+c*2], acc[c*2+1] ^ secret[MergeSecretWord+c*2+1]);
+        return Avalanche(result);
+    }
+
+        //  Process "stripeCount" regular stripes, continuing from stripe "stripesInBlock"
+        //  within the current block. Returns the new position within the block
+    static unsigned AccumulateRegularStripes(
+        uint64 acc[8], const uint8* p, size_t stripeCount,
+        unsigned stripesInBlock, const uint64* secret)
+    {
+        const auto& impl = GetHashImplementation();
+        while (stripeCount) {
+            auto count = std::min(stripeCount, size_t(StripesPerBlock - stripesInBlock));
+            (*impl._accumulate)(acc, p, secret + stripesInBlock, count);
+            stripesInBlock += unsigned(count);
+            if (stripesInBlock == StripesPerBlock) {
+                (*impl._scramble)(acc, secret + ScrambleSecretWord);
+                stripesInBlock = 0;
+            }
+            p += count * StripeLength;
+            stripeCount -= count;
+        }
+        return stripesInBlock;
+    }
+
+    static uint64 HashLong(const uint8* p, size_t length, const uint64* secret)
+    {
+            //  All stripes that end before the last byte are "regular" stripes. The
+            //  last stripe is always the last 64 bytes (which may overlap the previous
+            //  stripe), and uses a different part of the secret
+        uint64 acc[8];
+        InitAccumulators(acc);
+        AccumulateRegularStripes(acc, p, (length-1) / StripeLength, 0, secret);
+        (*GetHashImplementation()._accumulate)(acc, p + length - StripeLength, secret + LastStripeSecretWord, 1);
+        return MergeAccumulators(acc, secret, uint64(length) * Prime64_1);
+    }
+
+    static uint64 HashAny(const uint8* p, size_t length, uint64 seed)
+    {
+        if (length <= 16) return Hash0To16(p, length, seed);
+        if (length <= 128) return Hash17To128(p, length, seed);
+        uint64 secretBuffer[SecretWords];
+        return HashLong(p, length, GetSecret(seed, secretBuffer));
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    uint64 Hash64(const void* begin, const void* end, uint64 seed)
+    {
+        return HashAny((const uint8*)begin, size_t(end)-size_t(begin), seed);
     }
 
     uint64 Hash64(const char str[], uint64 seed)
@@ -43,6 +390,110 @@ namespace Utility
         return Hash64(AsPointer(str.begin()), AsPointer(str.end()), seed);
     }
 
+    void Hash64Batch(const StringSection<char> strings[], size_t count, uint64 results[], uint64 seed)
+    {
+            //  Most strings in batches are short names, so we avoid the length dispatch
+            //  and the secret lookup in HashAny for those. The loop iterations are
+            //  independent, so the processor can overlap the multiplies from
+            //  several strings
+        uint64 secretBuffer[SecretWords];
+        const uint64* secret = nullptr;
+        for (size_t c=0; c<count; ++c) {
+            const auto* p = (const uint8*)strings[c].begin();
+            auto length = strings[c].Length();
+            if (length <= 16) {
+                results[c] = Hash0To16(p, length, seed);
+            } else if (length <= 128) {
+                results[c] = Hash17To128(p, length, seed);
+            } else {
+                if (!secret) secret = GetSecret(seed, secretBuffer);
+                results[c] = HashLong(p, length, secret);
+            }
+        }
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void Hasher64::Update(const void* begin, const void* end)
+    {
+        auto* p = (const uint8*)begin;
+        auto length = size_t(end) - size_t(begin);
+        _totalLength += length;
+
+            //  We always keep at least 1 byte in the buffer, because the final
+            //  stripe must be processed differently from the regular stripes
+        if (_bufferedSize + length <= StreamBufferSize) {
+            XlCopyMemory(&_buffer[_bufferedSize], p, length);
+            _bufferedSize += unsigned(length);
+            return;
+        }
+
+        if (_bufferedSize) {
+            auto fill = StreamBufferSize - _bufferedSize;
+            XlCopyMemory(&_buffer[_bufferedSize], p, fill);
+            p += fill; length -= fill;
+            _stripesInBlock = AccumulateRegularStripes(
+                _accumulators, _buffer, StreamBufferSize/StripeLength, _stripesInBlock, _secret);
+            XlCopyMemory(_lastStripe, &_buffer[StreamBufferSize-StripeLength], StripeLength);
+            _bufferedSize = 0;
+        }
+
+        if (length > StreamBufferSize) {
+                //  consume stripes directly from the input, leaving between
+                //  (StreamBufferSize-StripeLength, StreamBufferSize] bytes
+            auto stripeCount = (length - StreamBufferSize + StripeLength - 1) / StripeLength;
+            _stripesInBlock = AccumulateRegularStripes(
+                _accumulators, p, stripeCount, _stripesInBlock, _secret);
+            p += stripeCount * StripeLength; length -= stripeCount * StripeLength;
+            XlCopyMemory(_lastStripe, p - StripeLength, StripeLength);
+        }
+
+        XlCopyMemory(_buffer, p, length);
+        _bufferedSize = unsigned(length);
+    }
+
+    uint64 Hasher64::Digest() const
+    {
+        if (_totalLength <= StreamBufferSize)
+            return HashAny(_buffer, size_t(_totalLength), _seed);
+
+        uint64 acc[8];
+        std::copy(_accumulators, &_accumulators[8], acc);
+        AccumulateRegularStripes(acc, _buffer, (_bufferedSize-1) / StripeLength, _stripesInBlock, _secret);
+
+        uint8 lastStripeBuffer[StripeLength];
+        const uint8* lastStripe;
+        if (_bufferedSize >= StripeLength) {
+            lastStripe = &_buffer[_bufferedSize - StripeLength];
+        } else {
+                //  The last stripe spans previously consumed data
+            auto fromPrevious = StripeLength - _bufferedSize;
+            XlCopyMemory(lastStripeBuffer, &_lastStripe[StripeLength - fromPrevious], fromPrevious);
+            XlCopyMemory(&lastStripeBuffer[fromPrevious], _buffer, _bufferedSize);
+            lastStripe = lastStripeBuffer;
+        }
+
+        (*GetHashImplementation()._accumulate)(acc, lastStripe, _secret + LastStripeSecretWord, 1);
+        return MergeAccumulators(acc, _secret, _totalLength * Prime64_1);
+    }
+
+    void Hasher64::Reset(uint64 seed)
+    {
+        InitAccumulators(_accumulators);
+        DeriveSecret(_secret, seed);
+        _totalLength = 0;
+        _seed = seed;
+        _bufferedSize = 0;
+        _stripesInBlock = 0;
+    }
+
+    Hasher64::Hasher64(uint64 seed)
+    {
+        Reset(seed);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
     uint32 Hash32(const void* begin, const void* end, uint32 seed)
     {
         uint32 temp;
@@ -62,7 +513,7 @@ namespace Utility
         key = (key^0xb55a4f09) ^ (key>>16);
         return key;
     }
-    
+
     uint64 IntegerHash64(uint64 key)
     {
             // taken from https://gist.github.com/badboy/6267743
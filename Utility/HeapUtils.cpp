@@ -7,6 +7,7 @@
 #include "HeapUtils.h"
 #include "PtrUtils.h"
 #include "MemoryUtils.h"
+#include "BitUtils.h"
 #include <assert.h>
 
 namespace Utility
@@ -147,8 +148,8 @@ namespace Utility
         Marker largestFreeBlock[2] = {0,0};
         Marker largestFreeBlockPosition = 0;
 
-        std::vector<Marker>::iterator best = _markers.end();
-        for (std::vector<Marker>::iterator i=_markers.begin(); i<(_markers.end()-1);i+=2) {
+        typename std::vector<Marker>::iterator best = _markers.end();
+        for (typename std::vector<Marker>::iterator i=_markers.begin(); i<(_markers.end()-1);i+=2) {
             Marker blockSize = *(i+1) - *i;
             if (blockSize >= internalSize && blockSize < bestSize) {
                 bestSize = blockSize;
@@ -240,7 +241,7 @@ namespace Utility
         _largestFreeBlockValid = false; // have to recalculate largest free after deallocate. We could update based on local changes, but...
 
             // find the span in which this belongs, and mark the space deallocated
-        std::vector<Marker>::iterator i = _markers.begin()+(allocateOperation?0:1);
+        typename std::vector<Marker>::iterator i = _markers.begin()+(allocateOperation?0:1);
         for (; (i+1)<_markers.end();i+=2) {
             Marker start = *i;
             Marker end = *(i+1);
@@ -300,7 +301,7 @@ namespace Utility
     {
         Marker largestBlock = 0;
         assert(!_markers.empty());
-        std::vector<Marker>::const_iterator i = _markers.begin();
+        typename std::vector<Marker>::const_iterator i = _markers.begin();
         for (; i<(_markers.end()-1);i+=2) {
             Marker start = *i;
             Marker end = *(i+1);
@@ -314,7 +315,7 @@ namespace Utility
     {
         ScopedLock(_lock);
         unsigned result = 0;
-        std::vector<Marker>::const_iterator i = _markers.begin();
+        typename std::vector<Marker>::const_iterator i = _markers.begin();
         for (; (i+1)<_markers.end();i+=2) {
             Marker start = *i;
             Marker end = *(i+1);
@@ -341,7 +342,7 @@ namespace Utility
         if (_markers.empty()) return 0;
 
         unsigned result = 0;
-        std::vector<Marker>::const_iterator i = _markers.begin()+1;
+        typename std::vector<Marker>::const_iterator i = _markers.begin()+1;
         for (; i<(_markers.end()-1);i+=2) {
             Marker start = *i;
             Marker end = *(i+1);
@@ -407,7 +408,7 @@ namespace Utility
         ScopedLock(_lock);
         std::vector<unsigned> result;
         result.reserve(_markers.size());
-        std::vector<Marker>::const_iterator i = _markers.begin();
+        typename std::vector<Marker>::const_iterator i = _markers.begin();
         for (; i!=_markers.end();++i) {
             result.push_back(ToExternalSize(*i));
         }
@@ -447,7 +448,7 @@ namespace Utility
 
         std::vector<std::pair<Marker, Marker> > allocatedBlocks;
         allocatedBlocks.reserve(_markers.size()/2);
-        std::vector<Marker>::const_iterator i = _markers.begin()+1;
+        typename std::vector<Marker>::const_iterator i = _markers.begin()+1;
         for (; (i+1)<_markers.end();i+=2) {
             Marker start = *i;
             Marker end   = *(i+1);
@@ -472,7 +473,7 @@ namespace Utility
         result.reserve(allocatedBlocks.size());
 
         Marker compressedPosition = 0;
-        for (std::vector<std::pair<Marker, Marker> >::const_iterator i=allocatedBlocks.begin(); i!=allocatedBlocks.end(); ++i) {
+        for (typename std::vector<std::pair<Marker, Marker> >::const_iterator i=allocatedBlocks.begin(); i!=allocatedBlocks.end(); ++i) {
             assert(i->first < i->second);
             DefragStep step;
             step._sourceStart    = ToExternalSize(i->first);
@@ -634,7 +635,728 @@ namespace Utility
         SpanningHeap<Marker>::~SpanningHeap()
     {}
 
-    template SpanningHeap<uint16>;
-    template SpanningHeap<uint32>;
+    template class SpanningHeap<uint16>;
+    template class SpanningHeap<uint32>;
+
+
+        /////////////////////////////////////////////////////////////////////////////////
+            //////   T L S F   H E A P   //////
+        /////////////////////////////////////////////////////////////////////////////////
+
+    static std::pair<uint32, uint32> EmptySlot() { return std::make_pair(~uint32(0x0), ~uint32(0x0)); }
+
+    void TLSFHeap::AllocatedIndex::Reset(uint32 heapSize)
+    {
+            //  Level 0 has a bit for every unit in the heap. Each higher level has
+            //  a bit for every word in the level below, set when that word is non-zero.
+        _bits.clear();
+        _levelCount = 0;
+        _unitCount = heapSize;
+        unsigned wordCount = (heapSize + 63) >> 6;
+        while (wordCount) {
+            assert(_levelCount < dimof(_levelStart));
+            _levelStart[_levelCount++] = unsigned(_bits.size());
+            _bits.resize(_bits.size() + wordCount, 0);
+            if (wordCount == 1) break;
+            wordCount = (wordCount + 63) >> 6;
+        }
+
+        _tableLog2 = 6;
+        _table.clear();
+        _table.resize(size_t(1) << _tableLog2, EmptySlot());
+        _count = 0;
+    }
+
+    unsigned TLSFHeap::AllocatedIndex::TableSlot(uint32 offset) const
+    {
+        return (offset * 2654435761u) >> (32 - _tableLog2);
+    }
+
+    void TLSFHeap::AllocatedIndex::TableInsert(uint32 offset, uint32 block)
+    {
+        auto mask = unsigned(_table.size()) - 1;
+        auto slot = TableSlot(offset);
+        while (_table[slot].first != InvalidBlock) {
+            assert(_table[slot].first != offset);
+            slot = (slot + 1) & mask;
+        }
+        _table[slot] = std::make_pair(offset, block);
+    }
+
+    void TLSFHeap::AllocatedIndex::Insert(uint32 offset, uint32 block)
+    {
+            //  Keep the table at most half full, so probe sequences stay short
+        if ((_count + 1) * 2 > _table.size()) {
+            std::vector<std::pair<uint32, uint32>> oldTable;
+            oldTable.swap(_table);
+            ++_tableLog2;
+            _table.resize(size_t(1) << _tableLog2, EmptySlot());
+            for (auto i=oldTable.cbegin(); i!=oldTable.cend(); ++i) {
+                if (i->first != InvalidBlock) {
+                    TableInsert(i->first, i->second);
+                }
+            }
+        }
+        TableInsert(offset, block);
+        ++_count;
+
+        for (unsigned l=0; l<_levelCount; ++l) {
+            auto& word = _bits[_levelStart[l] + (offset >> 6)];
+            bool wasEmpty = !word;
+            word |= uint64(1) << (offset & 63);
+            if (!wasEmpty) break;
+            offset >>= 6;
+        }
+    }
+
+    void TLSFHeap::AllocatedIndex::Erase(uint32 offset)
+    {
+        auto mask = unsigned(_table.size()) - 1;
+        auto slot = TableSlot(offset);
+        while (_table[slot].first != offset) {
+            assert(_table[slot].first != InvalidBlock);
+            slot = (slot + 1) & mask;
+        }
+
+            //  Shift back any following entries that would no longer be reachable
+            //  from their home slot (so we never need tombstones)
+        for (auto next = (slot + 1) & mask; _table[next].first != InvalidBlock; next = (next + 1) & mask) {
+            auto home = TableSlot(_table[next].first);
+            bool reachable = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+            if (!reachable) {
+                _table[slot] = _table[next];
+                slot = next;
+            }
+        }
+        _table[slot] = EmptySlot();
+        --_count;
+
+        for (unsigned l=0; l<_levelCount; ++l) {
+            auto& word = _bits[_levelStart[l] + (offset >> 6)];
+            word &= ~(uint64(1) << (offset & 63));
+            if (word) break;
+            offset >>= 6;
+        }
+    }
+
+    uint32 TLSFHeap::AllocatedIndex::FindPrevious(unsigned level, uint32 index) const
+    {
+            //  Returns the highest set bit at or before "index" in the given level
+        auto word = index >> 6;
+        auto bits = _bits[_levelStart[level] + word] & (~uint64(0) >> (63 - (index & 63)));
+        if (bits) {
+            return (word << 6) + 63 - xl_clz8(bits);
+        }
+        if (!word || (level+1) >= _levelCount) {
+            return InvalidBlock;
+        }
+
+        auto prevWord = FindPrevious(level+1, word-1);
+        if (prevWord == InvalidBlock) {
+            return InvalidBlock;
+        }
+        return (prevWord << 6) + 63 - xl_clz8(_bits[_levelStart[level] + prevWord]);
+    }
+
+    uint32 TLSFHeap::AllocatedIndex::FindContaining(uint32 offset) const
+    {
+            //  Returns the allocated block with the highest start offset that is 
+            //  less than or equal to "offset". The caller must check that the
+            //  offset is actually within that block.
+        if (offset >= _unitCount) {
+            return InvalidBlock;
+        }
+        auto start = FindPrevious(0, offset);
+        if (start == InvalidBlock) {
+            return InvalidBlock;
+        }
+
+        auto mask = unsigned(_table.size()) - 1;
+        auto slot = TableSlot(start);
+        while (_table[slot].first != start) {
+            assert(_table[slot].first != InvalidBlock);
+            slot = (slot + 1) & mask;
+        }
+        return _table[slot].second;
+    }
+
+    TLSFHeap::AllocatedIndex::AllocatedIndex()
+    {
+        Reset(0);
+    }
+
+    void TLSFHeap::MappingInsert(uint32 size, unsigned& fl, unsigned& sl)
+    {
+            //  First level is the position of the most significant bit. Second level
+            //  subdivides that power of 2 range linearly into SLCount lists.
+            //  Small sizes (less than SLCount) all fall into first level 0, where
+            //  the second level index is just the size.
+        assert(size > 0);
+        if (size < SLCount) {
+            fl = 0;
+            sl = size;
+        } else {
+            auto msb = IntegerLog2(size);
+            fl = msb - SLLog2 + 1;
+            sl = (size >> (msb - SLLog2)) - SLCount;
+        }
+        assert(fl < FLCount && sl < SLCount);
+    }
+
+    void TLSFHeap::MappingSearch(uint32 size, unsigned& fl, unsigned& sl)
+    {
+            //  Round up to the start of the next size class, so that every block in 
+            //  the list we find is guaranteed to be large enough
+        if (size >= SLCount) {
+            uint32 round = (1u << (IntegerLog2(size) - SLLog2)) - 1u;
+            assert(size + round >= size);
+            size += round;
+        }
+        MappingInsert(size, fl, sl);
+    }
+
+    uint32 TLSFHeap::NewBlock(uint32 offset, uint32 size)
+    {
+        uint32 result;
+        if (!_unusedBlocks.empty()) {
+            result = _unusedBlocks.back();
+            _unusedBlocks.pop_back();
+        } else {
+            result = uint32(_blocks.size());
+            _blocks.push_back(Block());
+        }
+
+        auto& block = _blocks[result];
+        block._offset = offset;
+        block._size = size;
+        block._prevPhysical = block._nextPhysical = InvalidBlock;
+        block._prevFree = block._nextFree = InvalidBlock;
+        block._isFree = false;
+        return result;
+    }
+
+    void TLSFHeap::ReleaseBlock(uint32 block)
+    {
+        _blocks[block]._size = 0;
+        _unusedBlocks.push_back(block);
+    }
+
+    void TLSFHeap::InsertFree(uint32 blockIndex)
+    {
+        auto& block = _blocks[blockIndex];
+        unsigned fl, sl;
+        MappingInsert(block._size, fl, sl);
+
+        block._isFree = true;
+        block._prevFree = InvalidBlock;
+        block._nextFree = _freeLists[fl][sl];
+        if (block._nextFree != InvalidBlock) {
+            _blocks[block._nextFree]._prevFree = blockIndex;
+        }
+        _freeLists[fl][sl] = blockIndex;
+        _flBitmap |= 1u << fl;
+        _slBitmap[fl] |= 1u << sl;
+    }
+
+    void TLSFHeap::RemoveFree(uint32 blockIndex)
+    {
+        auto& block = _blocks[blockIndex];
+        assert(block._isFree);
+        if (block._prevFree != InvalidBlock) {
+            _blocks[block._prevFree]._nextFree = block._nextFree;
+        } else {
+            unsigned fl, sl;
+            MappingInsert(block._size, fl, sl);
+            assert(_freeLists[fl][sl] == blockIndex);
+            _freeLists[fl][sl] = block._nextFree;
+            if (block._nextFree == InvalidBlock) {
+                _slBitmap[fl] &= ~(1u << sl);
+                if (!_slBitmap[fl]) {
+                    _flBitmap &= ~(1u << fl);
+                }
+            }
+        }
+
+        if (block._nextFree != InvalidBlock) {
+            _blocks[block._nextFree]._prevFree = block._prevFree;
+        }
+        block._prevFree = block._nextFree = InvalidBlock;
+        block._isFree = false;
+    }
+
+    uint32 TLSFHeap::FindFree(uint32 size) const
+    {
+        unsigned fl, sl;
+        MappingSearch(size, fl, sl);
+
+        uint32 slMap = _slBitmap[fl] & (~uint32(0x0) << sl);
+        if (!slMap) {
+            uint32 flMap = (fl+1 < FLCount) ? (_flBitmap & (~uint32(0x0) << (fl+1))) : 0;
+            if (flMap) {
+                fl = xl_ctz4(flMap);
+                slMap = _slBitmap[fl];
+                assert(slMap);
+            }
+        }
+
+        if (slMap) {
+            auto result = _freeLists[fl][xl_ctz4(slMap)];
+            assert(result != InvalidBlock && _blocks[result]._size >= size);
+            return result;
+        }
+
+            //  The rounded search failed. But there may still be a block large enough
+            //  in the size class of the request itself (this matters when the heap
+            //  is nearly full, and the request closely matches the remaining space)
+        MappingInsert(size, fl, sl);
+        for (auto b = _freeLists[fl][sl]; b != InvalidBlock; b = _blocks[b]._nextFree) {
+            if (_blocks[b]._size >= size) {
+                return b;
+            }
+        }
+
+        return InvalidBlock;
+    }
+
+    uint32 TLSFHeap::SplitBlock(uint32 blockIndex, uint32 offset)
+    {
+            //  Split the given block into 2 at "offset". The original block becomes
+            //  the front part, and we return the new back part. Neither part is
+            //  added to the free lists or the allocated blocks table here.
+        assert(offset > _blocks[blockIndex]._offset);
+        assert(offset < _blocks[blockIndex]._offset + _blocks[blockIndex]._size);
+        auto tailIndex = NewBlock(offset, _blocks[blockIndex]._offset + _blocks[blockIndex]._size - offset);
+
+        auto& head = _blocks[blockIndex];
+        auto& tail = _blocks[tailIndex];
+        head._size = offset - head._offset;
+        tail._prevPhysical = blockIndex;
+        tail._nextPhysical = head._nextPhysical;
+        if (head._nextPhysical != InvalidBlock) {
+            _blocks[head._nextPhysical]._prevPhysical = tailIndex;
+        }
+        head._nextPhysical = tailIndex;
+        return tailIndex;
+    }
+
+    void TLSFHeap::MarkAllocated(uint32 blockIndex)
+    {
+        auto& block = _blocks[blockIndex];
+        assert(!block._isFree && block._prevFree == InvalidBlock && block._nextFree == InvalidBlock);
+        _allocatedBlocks.Insert(block._offset, blockIndex);
+        _allocatedSize += block._size;
+    }
+
+    uint32 TLSFHeap::MarkFreeAndMerge(uint32 blockIndex)
+    {
+        {
+            auto& block = _blocks[blockIndex];
+            assert(!block._isFree);
+            _allocatedBlocks.Erase(block._offset);
+            assert(_allocatedSize >= block._size);
+            _allocatedSize -= block._size;
+        }
+
+            //  merge with the previous & next blocks if they are also free
+            //  (so there are never 2 adjacent free blocks)
+        auto prev = _blocks[blockIndex]._prevPhysical;
+        if (prev != InvalidBlock && _blocks[prev]._isFree) {
+            RemoveFree(prev);
+            _blocks[prev]._size += _blocks[blockIndex]._size;
+            _blocks[prev]._nextPhysical = _blocks[blockIndex]._nextPhysical;
+            if (_blocks[blockIndex]._nextPhysical != InvalidBlock) {
+                _blocks[_blocks[blockIndex]._nextPhysical]._prevPhysical = prev;
+            }
+            ReleaseBlock(blockIndex);
+            blockIndex = prev;
+        }
+
+        auto next = _blocks[blockIndex]._nextPhysical;
+        if (next != InvalidBlock && _blocks[next]._isFree) {
+            RemoveFree(next);
+            _blocks[blockIndex]._size += _blocks[next]._size;
+            _blocks[blockIndex]._nextPhysical = _blocks[next]._nextPhysical;
+            if (_blocks[next]._nextPhysical != InvalidBlock) {
+                _blocks[_blocks[next]._nextPhysical]._prevPhysical = blockIndex;
+            }
+            ReleaseBlock(next);
+        }
+
+        InsertFree(blockIndex);
+        return blockIndex;
+    }
+
+    void TLSFHeap::Reset(uint32 heapSize)
+    {
+        _blocks.clear();
+        _unusedBlocks.clear();
+        _allocatedBlocks.Reset(heapSize);
+        _flBitmap = 0;
+        for (unsigned c=0; c<FLCount; ++c) {
+            _slBitmap[c] = 0;
+            for (unsigned c2=0; c2<SLCount; ++c2) {
+                _freeLists[c][c2] = InvalidBlock;
+            }
+        }
+
+        _heapSize = heapSize;
+        _allocatedSize = 0;
+        _firstBlock = InvalidBlock;
+        if (heapSize) {
+            _firstBlock = NewBlock(0, heapSize);
+            InsertFree(_firstBlock);
+        }
+    }
+
+    unsigned TLSFHeap::AlignSize(unsigned size) const
+    {
+        return CeilToMultiplePow2(std::max(size, 1u), _granularity);
+    }
+
+    unsigned TLSFHeap::Allocate(unsigned size)
+    {
+        return AllocateAligned(size, _granularity);
+    }
+
+    unsigned TLSFHeap::AllocateAligned(unsigned size, unsigned alignment)
+    {
+        uint32 units = AlignSize(size) >> _granularityLog2;
+        uint32 alignmentUnits = std::max(alignment, _granularity) >> _granularityLog2;
+        assert(IsPowerOfTwo(alignmentUnits));
+
+            //  When the alignment is larger than the granularity, we need to search
+            //  for a block that is large enough to contain the worst case padding
+        auto blockIndex = FindFree(units + alignmentUnits - 1);
+        if (blockIndex == InvalidBlock) {
+            return ~unsigned(0x0);
+        }
+
+        RemoveFree(blockIndex);
+        auto alignedOffset = CeilToMultiplePow2(_blocks[blockIndex]._offset, alignmentUnits);
+        if (alignedOffset != _blocks[blockIndex]._offset) {
+            auto aligned = SplitBlock(blockIndex, alignedOffset);
+            InsertFree(blockIndex);     // the padding goes back into the free lists
+            blockIndex = aligned;
+        }
+
+        if (_blocks[blockIndex]._size > units) {
+            InsertFree(SplitBlock(blockIndex, _blocks[blockIndex]._offset + units));
+        }
+
+        MarkAllocated(blockIndex);
+        return _blocks[blockIndex]._offset << _granularityLog2;
+    }
+
+    bool TLSFHeap::Allocate(unsigned ptr, unsigned size)
+    {
+            //  Mark a specific range as allocated. This is rarely used, so we just
+            //  walk through the physical block list to find the free block that 
+            //  contains the range
+        assert((ptr & (_granularity-1)) == 0);
+        uint32 offset = ptr >> _granularityLog2;
+        uint32 units = AlignSize(size) >> _granularityLog2;
+
+        for (auto b=_firstBlock; b!=InvalidBlock; b=_blocks[b]._nextPhysical) {
+            if (offset >= _blocks[b]._offset && offset < (_blocks[b]._offset + _blocks[b]._size)) {
+                if (!_blocks[b]._isFree || (offset + units) > (_blocks[b]._offset + _blocks[b]._size)) {
+                    assert(0);      // part of this range is already allocated
+                    return false;
+                }
+
+                RemoveFree(b);
+                if (offset > _blocks[b]._offset) {
+                    auto tail = SplitBlock(b, offset);
+                    InsertFree(b);
+                    b = tail;
+                }
+                if (_blocks[b]._size > units) {
+                    InsertFree(SplitBlock(b, offset + units));
+                }
+                MarkAllocated(b);
+                return true;
+            }
+        }
+
+        assert(0);      // couldn't find it within our heap
+        return false;
+    }
+
+    bool TLSFHeap::Deallocate(unsigned ptr, unsigned size)
+    {
+        assert((ptr & (_granularity-1)) == 0);
+        uint32 offset = ptr >> _granularityLog2;
+        uint32 end = offset + (AlignSize(size) >> _granularityLog2);
+
+            //  The range we're deallocating might be just part of an allocated block
+            //  (or, rarely, might straddle multiple adjacent allocated blocks). Split
+            //  off the parts that should remain allocated, and free the rest.
+        while (offset < end) {
+            auto blockIndex = _allocatedBlocks.FindContaining(offset);
+            if (blockIndex == InvalidBlock) {
+                assert(0);      // couldn't find it within our heap
+                return false;
+            }
+
+            auto blockEnd = _blocks[blockIndex]._offset + _blocks[blockIndex]._size;
+            if (offset >= blockEnd) {
+                assert(0);      // this space isn't allocated
+                return false;
+            }
+
+            if (offset > _blocks[blockIndex]._offset) {
+                blockIndex = SplitBlock(blockIndex, offset);
+                _allocatedBlocks.Insert(offset, blockIndex);
+            }
+            if (end < blockEnd) {
+                auto tail = SplitBlock(blockIndex, end);
+                _allocatedBlocks.Insert(end, tail);
+            }
+
+            offset = std::min(end, blockEnd);
+            MarkFreeAndMerge(blockIndex);
+        }
+
+        return true;
+    }
+
+    uint32 TLSFHeap::CalculateLargestFreeBlock_Internal() const
+    {
+            //  The largest free block must be in the highest non-empty size class.
+        if (!_flBitmap) {
+            return 0;
+        }
+
+        auto fl = IntegerLog2(_flBitmap);
+        auto sl = IntegerLog2(_slBitmap[fl]);
+        uint32 result = 0;
+        for (auto b=_freeLists[fl][sl]; b!=InvalidBlock; b=_blocks[b]._nextFree) {
+            result = std::max(result, _blocks[b]._size);
+        }
+        return result;
+    }
+
+    unsigned TLSFHeap::CalculateAvailableSpace() const
+    {
+        return (_heapSize - _allocatedSize) << _granularityLog2;
+    }
+
+    unsigned TLSFHeap::CalculateLargestFreeBlock() const
+    {
+        return CalculateLargestFreeBlock_Internal() << _granularityLog2;
+    }
+
+    unsigned TLSFHeap::CalculateAllocatedSpace() const
+    {
+        return _allocatedSize << _granularityLog2;
+    }
+
+    unsigned TLSFHeap::CalculateHeapSize() const
+    {
+        return _heapSize << _granularityLog2;
+    }
+
+    bool TLSFHeap::IsEmpty() const
+    {
+        return _allocatedSize == 0;
+    }
+
+    std::vector<unsigned> TLSFHeap::CalculateMetrics() const
+    {
+            //  Returns a list of markers, in the same format as SpanningHeap.
+            //  Markers alternate between the start of free and allocated spans, 
+            //  starting with a (possibly empty) free span at 0 and ending with
+            //  the heap size.
+        std::vector<unsigned> result;
+        result.reserve(_allocatedBlocks.GetCount()*2+2);
+        result.push_back(0);
+        bool inFreeSpan = true;
+        for (auto b=_firstBlock; b!=InvalidBlock; b=_blocks[b]._nextPhysical) {
+            if (_blocks[b]._isFree != inFreeSpan) {
+                result.push_back(_blocks[b]._offset << _granularityLog2);
+                inFreeSpan = _blocks[b]._isFree;
+            }
+        }
+        result.push_back(_heapSize << _granularityLog2);
+        return result;
+    }
+
+    uint64 TLSFHeap::CalculateHash() const
+    {
+        auto markers = CalculateMetrics();
+        return Hash64(AsPointer(markers.cbegin()), AsPointer(markers.cend()));
+    }
+
+    TLSFHeapMetrics TLSFHeap::CalculateFragmentationMetrics() const
+    {
+        TLSFHeapMetrics result;
+        result._allocatedSpace = _allocatedSize << _granularityLog2;
+        result._availableSpace = (_heapSize - _allocatedSize) << _granularityLog2;
+        result._largestFreeBlock = CalculateLargestFreeBlock_Internal() << _granularityLog2;
+        result._allocatedBlockCount = _allocatedBlocks.GetCount();
+        result._freeBlockCount = 0;
+        for (auto b=_firstBlock; b!=InvalidBlock; b=_blocks[b]._nextPhysical) {
+            if (_blocks[b]._isFree) {
+                ++result._freeBlockCount;
+            }
+        }
+        result._fragmentation = result._availableSpace 
+            ? (1.f - float(result._largestFreeBlock) / float(result._availableSpace)) 
+            : 0.f;
+        return result;
+    }
+
+    static bool SortDefragStep_SourceStart_TLSF(const DefragStep& lhs, const DefragStep& rhs)
+    {
+        return lhs._sourceStart < rhs._sourceStart;
+    }
+
+    std::vector<DefragStep> TLSFHeap::CalculateDefragSteps() const
+    {
+            //  Same approach as SpanningHeap::CalculateDefragSteps... We move allocated
+            //  spans (not individual blocks) so that adjacent blocks always move together.
+            //  Spans are compressed into the start of a new heap, smallest first.
+
+        std::vector<std::pair<uint32, uint32>> allocatedSpans;
+        allocatedSpans.reserve(_allocatedBlocks.GetCount());
+        for (auto b=_firstBlock; b!=InvalidBlock; b=_blocks[b]._nextPhysical) {
+            if (_blocks[b]._isFree) continue;
+            auto start = _blocks[b]._offset, end = start + _blocks[b]._size;
+            if (!allocatedSpans.empty() && allocatedSpans.back().second == start) {
+                allocatedSpans.back().second = end;
+            } else {
+                allocatedSpans.push_back(std::make_pair(start, end));
+            }
+        }
+
+        std::sort(allocatedSpans.begin(), allocatedSpans.end(), SortAllocatedBlocks_SmallestToLargest<uint32>);
+
+        std::vector<DefragStep> result;
+        result.reserve(allocatedSpans.size());
+        uint32 compressedPosition = 0;
+        for (auto i=allocatedSpans.cbegin(); i!=allocatedSpans.cend(); ++i) {
+            DefragStep step;
+            step._sourceStart    = i->first << _granularityLog2;
+            step._sourceEnd      = i->second << _granularityLog2;
+            step._destination    = compressedPosition << _granularityLog2;
+            compressedPosition  += i->second - i->first;
+            assert(compressedPosition <= _heapSize);
+            result.push_back(step);
+        }
+
+        std::sort(result.begin(), result.end(), SortDefragStep_SourceStart_TLSF);
+        return result;
+    }
+
+    void TLSFHeap::PerformDefrag(const std::vector<DefragStep>& defrag)
+    {
+            //  Rebuild the heap from scratch, with just the destination ranges
+            //  of the given steps allocated.
+        std::vector<DefragStep> defragByDestination(defrag);
+        std::sort(defragByDestination.begin(), defragByDestination.end(), SortDefragStep_Destination);
+
+        Reset(_heapSize);
+        auto tail = _firstBlock;
+        for (auto i=defragByDestination.cbegin(); i!=defragByDestination.cend(); ++i) {
+            assert((i->_destination & (_granularity-1)) == 0);
+            uint32 offset = i->_destination >> _granularityLog2;
+            uint32 units = AlignSize(i->_sourceEnd - i->_sourceStart) >> _granularityLog2;
+            assert(tail != InvalidBlock && _blocks[tail]._isFree);
+            assert(offset >= _blocks[tail]._offset && (offset+units) <= (_blocks[tail]._offset + _blocks[tail]._size));
+
+            RemoveFree(tail);
+            if (offset > _blocks[tail]._offset) {
+                auto aligned = SplitBlock(tail, offset);
+                InsertFree(tail);
+                tail = aligned;
+            }
+
+            auto next = InvalidBlock;
+            if (_blocks[tail]._size > units) {
+                next = SplitBlock(tail, offset + units);
+                InsertFree(next);
+            }
+            MarkAllocated(tail);
+            tail = next;
+        }
+    }
+
+    void TLSFHeap::CopyFrom(const TLSFHeap& cloneFrom)
+    {
+        _blocks = cloneFrom._blocks;
+        _unusedBlocks = cloneFrom._unusedBlocks;
+        _allocatedBlocks = cloneFrom._allocatedBlocks;
+        _flBitmap = cloneFrom._flBitmap;
+        XlCopyMemory(_slBitmap, cloneFrom._slBitmap, sizeof(_slBitmap));
+        XlCopyMemory(_freeLists, cloneFrom._freeLists, sizeof(_freeLists));
+        _firstBlock = cloneFrom._firstBlock;
+        _heapSize = cloneFrom._heapSize;
+        _allocatedSize = cloneFrom._allocatedSize;
+        _granularity = cloneFrom._granularity;
+        _granularityLog2 = cloneFrom._granularityLog2;
+    }
+
+    TLSFHeap::TLSFHeap(unsigned size, unsigned granularity)
+    {
+        assert(granularity > 0 && IsPowerOfTwo(granularity));
+        _granularity = granularity;
+        _granularityLog2 = IntegerLog2(uint32(granularity));
+        _blocks.reserve(64);
+        Reset(size ? (AlignSize(size) >> _granularityLog2) : 0);
+    }
+
+    TLSFHeap::TLSFHeap()
+    {
+        _granularity = 16;
+        _granularityLog2 = 4;
+        Reset(0);
+    }
+
+    TLSFHeap::~TLSFHeap() {}
+
+    TLSFHeap::TLSFHeap(TLSFHeap&& moveFrom) never_throws
+    : _blocks(std::move(moveFrom._blocks))
+    , _unusedBlocks(std::move(moveFrom._unusedBlocks))
+    , _allocatedBlocks(std::move(moveFrom._allocatedBlocks))
+    {
+        _flBitmap = moveFrom._flBitmap;
+        XlCopyMemory(_slBitmap, moveFrom._slBitmap, sizeof(_slBitmap));
+        XlCopyMemory(_freeLists, moveFrom._freeLists, sizeof(_freeLists));
+        _firstBlock = moveFrom._firstBlock;
+        _heapSize = moveFrom._heapSize;
+        _allocatedSize = moveFrom._allocatedSize;
+        _granularity = moveFrom._granularity;
+        _granularityLog2 = moveFrom._granularityLog2;
+        moveFrom.Reset(0);
+    }
+
+    TLSFHeap& TLSFHeap::operator=(TLSFHeap&& moveFrom) never_throws
+    {
+        _blocks = std::move(moveFrom._blocks);
+        _unusedBlocks = std::move(moveFrom._unusedBlocks);
+        _allocatedBlocks = std::move(moveFrom._allocatedBlocks);
+        _flBitmap = moveFrom._flBitmap;
+        XlCopyMemory(_slBitmap, moveFrom._slBitmap, sizeof(_slBitmap));
+        XlCopyMemory(_freeLists, moveFrom._freeLists, sizeof(_freeLists));
+        _firstBlock = moveFrom._firstBlock;
+        _heapSize = moveFrom._heapSize;
+        _allocatedSize = moveFrom._allocatedSize;
+        _granularity = moveFrom._granularity;
+        _granularityLog2 = moveFrom._granularityLog2;
+        moveFrom.Reset(0);
+        return *this;
+    }
+
+    TLSFHeap::TLSFHeap(const TLSFHeap& cloneFrom)
+    {
+        CopyFrom(cloneFrom);
+    }
+
+    TLSFHeap& TLSFHeap::operator=(const TLSFHeap& cloneFrom)
+    {
+        if (&cloneFrom != this) {
+            CopyFrom(cloneFrom);
+        }
+        return *this;
+    }
 }
 
@@ -8,6 +8,7 @@
 
 #include "../Core/Types.h"
 #include "Threading/Mutex.h"
+#include "IteratorUtils.h"     // (for CompareFirst)
 #include <vector>
 #include <algorithm>
 #include <memory>
@@ -181,6 +182,10 @@ namespace Utility
         SpanningHeap(const SpanningHeap& cloneFrom);
         const SpanningHeap& operator=(const SpanningHeap& cloneFrom);
     protected:
+        using MarkerHeap<Marker>::ToInternalSize;
+        using MarkerHeap<Marker>::ToExternalSize;
+        using MarkerHeap<Marker>::AlignSize;
+
         std::vector<Marker>         _markers;
         mutable Threading::Mutex    _lock;
         mutable bool                _largestFreeBlockValid;
@@ -192,6 +197,146 @@ namespace Utility
 
     typedef SpanningHeap<uint16> SimpleSpanningHeap;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    class TLSFHeapMetrics
+    {
+    public:
+        unsigned    _allocatedSpace, _availableSpace;
+        unsigned    _largestFreeBlock;
+        unsigned    _freeBlockCount, _allocatedBlockCount;
+        float       _fragmentation;     // 0 when all free space is in one block, approaching 1 as it is scattered
+    };
+
+    class TLSFHeap
+    {
+    public:
+
+            //
+            //      Two-level segregated fit heap. Like SpanningHeap, this only manages
+            //      offsets into some external memory (usually a GPU buffer), so none of
+            //      the book keeping lives in the managed memory itself.
+            //
+            //      Free blocks are bucketed by size class (first level is the power of 2,
+            //      second level subdivides that range linearly). The bucket bitmaps
+            //      allow us to find a suitable free block in constant time, regardless
+            //      of how many blocks are in the heap.
+            //
+            //      Offsets and sizes are 32 bit; all allocations are rounded up to the 
+            //      granularity passed to the constructor.
+            //
+            //      Like SpanningHeap, the client is expected to deallocate the same
+            //      space it allocated. But it may also deallocate sub-ranges of an 
+            //      allocated block (the batching system does this for super blocks).
+            //      Deallocate finds the block containing the given offset through a
+            //      flat index (see AllocatedIndex), so frees are also constant time.
+            //
+            //      Unlike SpanningHeap, there is no internal lock. The client must
+            //      serialise access to the heap (including the const queries).
+            //
+
+        unsigned            Allocate(unsigned size);
+        unsigned            AllocateAligned(unsigned size, unsigned alignment);
+        bool                Allocate(unsigned ptr, unsigned size);
+        bool                Deallocate(unsigned ptr, unsigned size);
+        
+        unsigned            CalculateAvailableSpace() const;
+        unsigned            CalculateLargestFreeBlock() const;
+        unsigned            CalculateAllocatedSpace() const;
+        unsigned            CalculateHeapSize() const;
+        uint64              CalculateHash() const;
+        bool                IsEmpty() const;
+        unsigned            GetGranularity() const { return _granularity; }
+        unsigned            AlignSize(unsigned size) const;
+
+        std::vector<unsigned>       CalculateMetrics() const;
+        TLSFHeapMetrics             CalculateFragmentationMetrics() const;
+        std::vector<DefragStep>     CalculateDefragSteps() const;
+        void                        PerformDefrag(const std::vector<DefragStep>& defrag);
+
+        TLSFHeap();
+        TLSFHeap(unsigned size, unsigned granularity = 16);
+        ~TLSFHeap();
+
+        TLSFHeap(TLSFHeap&& moveFrom) never_throws;
+        TLSFHeap& operator=(TLSFHeap&& moveFrom) never_throws;
+        TLSFHeap(const TLSFHeap& cloneFrom);
+        TLSFHeap& operator=(const TLSFHeap& cloneFrom);
+    protected:
+        static const unsigned SLLog2 = 4;
+        static const unsigned SLCount = 1<<SLLog2;
+        static const unsigned FLCount = 32 - SLLog2 + 1;
+        static const uint32 InvalidBlock = ~uint32(0x0);
+
+        class Block
+        {
+        public:
+            uint32  _offset, _size;     // (in units of _granularity)
+            uint32  _prevPhysical, _nextPhysical;
+            uint32  _prevFree, _nextFree;
+            bool    _isFree;
+        };
+
+        class AllocatedIndex
+        {
+        public:
+                //  Maps offsets to the allocated block that contains them. The start
+                //  of each allocated block is recorded in a hierarchical bitmap (64
+                //  way, so at most 6 levels for 32 bit offsets) and an open addressing
+                //  table from start offset to block index. Finding the block containing
+                //  an offset is a fixed number of word operations plus a table lookup.
+            void        Insert(uint32 offset, uint32 block);
+            void        Erase(uint32 offset);
+            uint32      FindContaining(uint32 offset) const;
+            unsigned    GetCount() const { return _count; }
+            void        Reset(uint32 heapSize);
+
+            AllocatedIndex();
+        private:
+            std::vector<uint64>     _bits;
+            unsigned                _levelStart[6];
+            unsigned                _levelCount;
+            uint32                  _unitCount;
+
+            std::vector<std::pair<uint32, uint32>> _table;     // start offset -> block index
+            unsigned                _tableLog2;
+            unsigned                _count;
+
+            uint32      FindPrevious(unsigned level, uint32 index) const;
+            unsigned    TableSlot(uint32 offset) const;
+            void        TableInsert(uint32 offset, uint32 block);
+        };
+
+        std::vector<Block>          _blocks;
+        std::vector<uint32>         _unusedBlocks;
+        AllocatedIndex              _allocatedBlocks;
+
+        uint32      _flBitmap;
+        uint32      _slBitmap[FLCount];
+        uint32      _freeLists[FLCount][SLCount];
+
+        uint32      _firstBlock;
+        uint32      _heapSize;          // (in units of _granularity)
+        uint32      _allocatedSize;     // (in units of _granularity)
+        unsigned    _granularity;
+        unsigned    _granularityLog2;
+
+        uint32      NewBlock(uint32 offset, uint32 size);
+        void        ReleaseBlock(uint32 block);
+        void        InsertFree(uint32 block);
+        void        RemoveFree(uint32 block);
+        uint32      FindFree(uint32 size) const;
+        uint32      SplitBlock(uint32 block, uint32 offset);
+        void        MarkAllocated(uint32 block);
+        uint32      MarkFreeAndMerge(uint32 block);
+        void        Reset(uint32 heapSize);
+        uint32      CalculateLargestFreeBlock_Internal() const;
+        void        CopyFrom(const TLSFHeap& cloneFrom);
+
+        static void     MappingInsert(uint32 size, unsigned& fl, unsigned& sl);
+        static void     MappingSearch(uint32 size, unsigned& fl, unsigned& sl);
+    };
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     template <typename Marker>
@@ -38,14 +38,14 @@ namespace Utility
 
     template <typename First, typename Second, typename Allocator>
         static typename std::vector<std::pair<First, Second>, Allocator>::iterator LowerBound(
-            typename std::vector<std::pair<First, Second>, Allocator>&v, First compareToFirst)
+            std::vector<std::pair<First, Second>, Allocator>&v, First compareToFirst)
         {
             return std::lower_bound(v.begin(), v.end(), compareToFirst, CompareFirst<First, Second>());
         }
 
     template <typename First, typename Second, typename Allocator>
         static typename std::vector<std::pair<First, Second>, Allocator>::const_iterator LowerBound(
-            typename const std::vector<std::pair<First, Second>, Allocator>&v, First compareToFirst)
+            const std::vector<std::pair<First, Second>, Allocator>&v, First compareToFirst)
         {
             return std::lower_bound(v.cbegin(), v.cend(), compareToFirst, CompareFirst<First, Second>());
         }
@@ -105,14 +105,14 @@ namespace Utility
         class IteratorRange : public std::pair<Iterator, Iterator>
         {
         public:
-            Iterator begin() const      { return first; }
-            Iterator end() const        { return second; }
-            Iterator cbegin() const     { return first; }
-            Iterator cend() const       { return second; }
-            size_t size() const         { return std::distance(first, second); }
-            bool empty() const          { return first == second; }
-
-            decltype(*std::declval<Iterator>()) operator[](size_t index) const { return first[index]; }
+            Iterator begin() const      { return this->first; }
+            Iterator end() const        { return this->second; }
+            Iterator cbegin() const     { return this->first; }
+            Iterator cend() const       { return this->second; }
+            size_t size() const         { return std::distance(this->first, this->second); }
+            bool empty() const          { return this->first == this->second; }
+
+            decltype(*std::declval<Iterator>()) operator[](size_t index) const { return this->first[index]; }
 
             IteratorRange() : std::pair<Iterator, Iterator>(nullptr, nullptr) {}
             IteratorRange(Iterator f, Iterator s) : std::pair<Iterator, Iterator>(f, s) {}
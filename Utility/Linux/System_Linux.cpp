@@ -0,0 +1,271 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../../Core/Prefix.h"
+#include "../../Core/SelectConfiguration.h"
+
+#if PLATFORMOS_TARGET == PLATFORMOS_LINUX
+
+#include "../../Core/Types.h"
+#include "../StringUtils.h"
+#include "../SystemUtils.h"
+#include "../TimeUtils.h"
+#include "../Threading/LockFree.h"
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace Utility
+{
+
+//////////////////////////////////////////////////////////////////////////
+
+static uint64 MonotonicNanoseconds()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return uint64(t.tv_sec) * 1000000000ull + uint64(t.tv_nsec);
+}
+
+Millisecond Millisecond_Now()
+{
+    return Millisecond(MonotonicNanoseconds() / 1000000ull);
+}
+
+Microsecond Microsecond_Now()
+{
+    return MonotonicNanoseconds() / 1000ull;
+}
+
+    //  CLOCK_MONOTONIC is already in nanoseconds, so the "performance
+    //  counter" is just that value with a fixed frequency.
+uint64 GetPerformanceCounter()             { return MonotonicNanoseconds(); }
+uint64 GetPerformanceCounterFrequency()    { return 1000000000ull; }
+
+//////////////////////////////////////////////////////////////////////////
+
+void XlGetLocalTime(uint64 time, struct tm* local)
+{
+    time_t fileTime = (time_t)time;
+    localtime_r(&fileTime, local);
+}
+
+uint64 XlMakeFileTime(struct tm* local)
+{
+    return (uint64)mktime(local);
+}
+
+uint64 XlGetCurrentFileTime()
+{
+    return (uint64)::time(nullptr);
+}
+
+double XlDiffTime(uint64 endTime, uint64 beginTime)
+{
+    return difftime((time_t)endTime, (time_t)beginTime);
+}
+
+//////////////////////////////////////////////////////////////////////////
+static char s_moduleMarker;
+ModuleId GetCurrentModuleId()
+{
+        // See the WinAPI version. Any static global is unique to the
+        // module it's linked into, so its address works as an id.
+    return (ModuleId)&s_moduleMarker;
+}
+
+uint32 XlGetCurrentThreadId()
+{
+    return (uint32)syscall(SYS_gettid);
+}
+
+//////////////////////////////////////////////////////////////////////////
+    //  Win32 style events. All events share one mutex and condition variable,
+    //  which keeps waiting on multiple events simple. Events are only used for
+    //  infrequent thread pool & pipeline signalling, so contention isn't a concern.
+namespace Internal
+{
+    class Event
+    {
+    public:
+        bool _manualReset;
+        bool _signalled;
+    };
+
+    static std::mutex& EventLock()                      { static std::mutex m; return m; }
+    static std::condition_variable& EventCondition()    { static std::condition_variable c; return c; }
+}
+
+XlHandle XlCreateEvent(bool manualReset)
+{
+    auto* e = new Internal::Event;
+    e->_manualReset = manualReset;
+    e->_signalled = false;
+    return (XlHandle)e;
+}
+
+bool XlResetEvent(XlHandle h)
+{
+    std::unique_lock<std::mutex> lock(Internal::EventLock());
+    ((Internal::Event*)h)->_signalled = false;
+    return true;
+}
+
+bool XlSetEvent(XlHandle h)
+{
+    {
+        std::unique_lock<std::mutex> lock(Internal::EventLock());
+        ((Internal::Event*)h)->_signalled = true;
+    }
+    Internal::EventCondition().notify_all();
+    return true;
+}
+
+bool XlCloseSyncObject(XlHandle h)
+{
+    delete (Internal::Event*)h;
+    return true;
+}
+
+uint32 XlWaitForMultipleSyncObjects(uint32 waitCount, XlHandle waitObjects[], bool waitAll, uint32 waitTime, bool alterable)
+{
+        //  "alterable" has no equivalent here (there are no completion routines to execute)
+    (void)alterable;
+    auto events = (Internal::Event**)waitObjects;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(waitTime);
+
+    std::unique_lock<std::mutex> lock(Internal::EventLock());
+    for (;;) {
+        if (waitAll) {
+            bool allSignalled = true;
+            for (uint32 c=0; c<waitCount; ++c) allSignalled &= events[c]->_signalled;
+            if (allSignalled) {
+                for (uint32 c=0; c<waitCount; ++c)
+                    if (!events[c]->_manualReset) events[c]->_signalled = false;
+                return XL_WAIT_OBJECT_0;
+            }
+        } else {
+            for (uint32 c=0; c<waitCount; ++c)
+                if (events[c]->_signalled) {
+                    if (!events[c]->_manualReset) events[c]->_signalled = false;
+                    return XL_WAIT_OBJECT_0 + c;
+                }
+        }
+
+        if (waitTime == XL_INFINITE) {
+            Internal::EventCondition().wait(lock);
+        } else if (Internal::EventCondition().wait_until(lock, deadline) == std::cv_status::timeout) {
+            return XL_WAIT_TIMEOUT;
+        }
+    }
+}
+
+uint32 XlWaitForSyncObject(XlHandle h, uint32 waitTime)
+{
+    return XlWaitForMultipleSyncObjects(1, &h, true, waitTime, false);
+}
+
+void XlGetNumCPUs(int* physical, int* logical, int* avail)
+{
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (physical) *physical = count;
+    if (logical) *logical = count;
+    if (avail) *avail = count;
+}
+
+uint32 XlGetCurrentProcessId()
+{
+    return (uint32)getpid();
+}
+
+bool XlGetCurrentDirectory(uint32 nBufferLength, char lpBuffer[])
+{
+    return getcwd(lpBuffer, nBufferLength) != nullptr;
+}
+
+bool XlGetCurrentDirectory(uint32 nBufferLength, ucs2 lpBuffer[])
+{
+    char buffer[MaxPath];
+    if (!getcwd(buffer, dimof(buffer))) return false;
+    return utf8_2_ucs2((const utf8*)buffer, XlStringLen(buffer), lpBuffer, nBufferLength) >= 0;
+}
+
+void XlOutputDebugString(const char* format)
+{
+    fputs(format, stderr);
+}
+
+void XlMessageBox(const char* content, const char* title)
+{
+        //  no windowing system to rely on here; just report it on stderr
+    fprintf(stderr, "%s: %s\n", title, content);
+}
+
+void XlGetProcessPath(utf8 dst[], size_t bufferCount)
+{
+    if (!bufferCount) return;
+    auto len = readlink("/proc/self/exe", (char*)dst, bufferCount-1);
+    dst[(len > 0) ? len : 0] = '\0';
+}
+
+void XlGetProcessPath(ucs2 dst[], size_t bufferCount)
+{
+    utf8 buffer[MaxPath];
+    XlGetProcessPath(buffer, dimof(buffer));
+    utf8_2_ucs2(buffer, XlStringLen(buffer), dst, bufferCount);
+}
+
+void XlChDir(const utf8 path[])     { auto result = chdir((const char*)path); (void)result; }
+
+void XlChDir(const ucs2 path[])
+{
+    utf8 buffer[MaxPath];
+    ucs2_2_utf8(path, XlStringLen(path), buffer, dimof(buffer));
+    XlChDir(buffer);
+}
+
+void XlDeleteFile(const utf8 path[]) { auto result = unlink((const char*)path); (void)result; }
+
+void XlDeleteFile(const ucs2 path[])
+{
+    utf8 buffer[MaxPath];
+    ucs2_2_utf8(path, XlStringLen(path), buffer, dimof(buffer));
+    XlDeleteFile(buffer);
+}
+
+void XlMoveFile(const utf8 destination[], const utf8 source[])
+{
+    auto result = rename((const char*)source, (const char*)destination); (void)result;
+}
+
+const char* XlGetCommandLine()
+{
+        //  /proc/self/cmdline separates the arguments with nulls; join
+        //  them with spaces so it looks like the Windows command line
+    static char buffer[4096];
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        buffer[0] = '\0';
+        auto* file = fopen("/proc/self/cmdline", "rb");
+        if (file) {
+            auto len = fread(buffer, 1, dimof(buffer)-1, file);
+            fclose(file);
+            buffer[len] = '\0';
+            for (size_t c=0; (c+1)<len; ++c)
+                if (!buffer[c]) buffer[c] = ' ';
+        }
+    }
+    return buffer;
+}
+
+}
+
+#endif
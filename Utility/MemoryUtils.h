@@ -11,6 +11,7 @@
 #include <string>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <memory>
 
 namespace Utility
@@ -51,11 +52,9 @@ namespace Utility
 
         inline void* XlMemAlign(size_t size, size_t alignment)
         {
-            // void* result = nullptr;
-            // int errorNumber = posix_memalign(&result, size, alignment);
-            // assert(!errorNumber);
-            // return result;
-            return memalign(size, alignment);
+            void* result = nullptr;
+            int errorNumber = posix_memalign(&result, alignment, size);
+            return errorNumber ? nullptr : result;
         }
         
         inline void XlMemAlignFree(void* data)
@@ -83,9 +82,51 @@ namespace Utility
 
         ////////////   H A S H I N G   ////////////
 
+    template<typename CharType> class StringSection;
+
+    /// <summary>Fast, general purpose 64 bit hash</summary>
+    /// Uses SSE2 or AVX2 (when available) for large inputs. The result doesn't depend
+    /// on which instruction set is used, but it does depend on the version of the
+    /// algorithm. So hash values that are stored on disk must be invalidated when the
+    /// algorithm changes (see Hash64Version).
+    /// Note that the results will not match the compile time ConstHash64.
     static const uint64 DefaultSeed64 = 0xE49B0E3F5C27F17Eull;
     XL_UTILITY_API uint64 Hash64(const void* begin, const void* end, uint64 seed = DefaultSeed64);
 
+        //  Incremented whenever Hash64 produces different results. Include it in the
+        //  version numbers of any file formats that store Hash64 values.
+    static const unsigned Hash64Version = 2;
+
+    /// <summary>Hash a number of short strings in one call</summary>
+    /// Equivalent to calling Hash64() for each string, but cheaper for large numbers
+    /// of short strings (such as lists of parameter or shader binding names)
+    XL_UTILITY_API void Hash64Batch(
+        const StringSection<char> strings[], size_t count, 
+        uint64 results[], uint64 seed = DefaultSeed64);
+
+    /// <summary>Calculate a Hash64 value incrementally</summary>
+    /// The result is the same as calling Hash64() on the concatenation of all of 
+    /// the data passed to Update(). Use this to avoid concatenating buffers just
+    /// to hash them.
+    class XL_UTILITY_API Hasher64
+    {
+    public:
+        void    Update(const void* begin, const void* end);
+        uint64  Digest() const;
+        void    Reset(uint64 seed = DefaultSeed64);
+
+        Hasher64(uint64 seed = DefaultSeed64);
+    private:
+        uint64      _accumulators[8];
+        uint64      _secret[24];
+        uint8       _buffer[256];
+        uint8       _lastStripe[64];
+        uint64      _totalLength;
+        uint64      _seed;
+        unsigned    _bufferedSize;
+        unsigned    _stripesInBlock;
+    };
+
     static const uint64 DefaultSeed32 = 0xB0F57EE3;
     XL_UTILITY_API uint32 Hash32(const void* begin, const void* end, uint32 seed = DefaultSeed32);
 
@@ -5,6 +5,14 @@
 // http://www.opensource.org/licenses/mit-license.php)
 
 #include "MemoryUtils.h"
+#include "SystemUtils.h"
+#include "../Core/SelectConfiguration.h"
+
+#if COMPILER_ACTIVE == COMPILER_TYPE_MSVC
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
 
 namespace Utility
 {
@@ -37,6 +45,63 @@ namespace Utility
 
         return result;
     }
-}
 
+    static void CPUID(int result[4], int function)
+    {
+        #if COMPILER_ACTIVE == COMPILER_TYPE_MSVC
+            __cpuidex(result, function, 0);
+        #elif defined(__x86_64__) || defined(__i386__)
+            unsigned a, b, c, d;
+            __cpuid_count(function, 0, a, b, c, d);
+            result[0] = int(a); result[1] = int(b); result[2] = int(c); result[3] = int(d);
+        #else
+            result[0] = result[1] = result[2] = result[3] = 0;
+        #endif
+    }
+
+    static uint64 ReadXCR0()
+    {
+        #if COMPILER_ACTIVE == COMPILER_TYPE_MSVC
+            return _xgetbv(0);
+        #elif defined(__x86_64__) || defined(__i386__)
+            unsigned a, d;
+            __asm__ volatile("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+            return uint64(a) | (uint64(d) << 32);
+        #else
+            return 0;
+        #endif
+    }
+
+    static CPUFeatures DetectCPUFeatures()
+    {
+        CPUFeatures result;
+        result._sse2 = result._sse41 = result._avx2 = result._fma = false;
+
+        int info[4];
+        CPUID(info, 0);
+        auto maxFunction = info[0];
+        if (maxFunction < 1) return result;
+
+        CPUID(info, 1);
+        result._sse2 = (info[3] & (1<<26)) != 0;
+        result._sse41 = (info[2] & (1<<19)) != 0;
 
+            //  AVX instructions can only be used if the OS saves the upper
+            //  halves of the ymm registers on context switches (checked via XCR0)
+        bool avx = (info[2] & (1<<28)) != 0;
+        bool fma = (info[2] & (1<<12)) != 0;
+        bool osxsave = (info[2] & (1<<27)) != 0;
+        if (avx && osxsave && ((ReadXCR0() & 6) == 6) && maxFunction >= 7) {
+            CPUID(info, 7);
+            result._avx2 = (info[1] & (1<<5)) != 0;
+            result._fma = fma;
+        }
+        return result;
+    }
+
+    const CPUFeatures& XlGetCPUFeatures()
+    {
+        static CPUFeatures features = DetectCPUFeatures();
+        return features;
+    }
+}
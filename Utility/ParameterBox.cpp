@@ -1112,7 +1112,7 @@ namespace Utility
             // (it could be a sub-element, or the end of this element)
             // then we will stop reading and return
         while (stream.PeekNext() == InputStreamFormatter<CharType>::Blob::AttributeName) {
-            InputStreamFormatter<CharType>::InteriorSection name, value;
+            typename InputStreamFormatter<CharType>::InteriorSection name, value;
             bool success = stream.TryAttribute(name, value);
             if (!success)
                 throw ::Exceptions::BasicLabel("Parsing exception while reading attribute in parameter box deserialization");
@@ -1174,7 +1174,7 @@ namespace Utility
         }
     }
 
-    ParameterBox::ParameterBox(ParameterBox&& moveFrom)
+    ParameterBox::ParameterBox(ParameterBox&& moveFrom) never_throws
     : _hashNames(std::move(moveFrom._hashNames))
     , _offsets(std::move(moveFrom._offsets))
     , _names(std::move(moveFrom._names))
@@ -1185,7 +1185,7 @@ namespace Utility
         _cachedParameterNameHash = moveFrom._cachedParameterNameHash;
     }
         
-    ParameterBox& ParameterBox::operator=(ParameterBox&& moveFrom)
+    ParameterBox& ParameterBox::operator=(ParameterBox&& moveFrom) never_throws
     {
         _hashNames = std::move(moveFrom._hashNames);
         _offsets = std::move(moveFrom._offsets);
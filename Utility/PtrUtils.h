@@ -233,14 +233,10 @@ namespace Utility
 
     #else
 
-        template <typename Type> 
-            Type * AsPointer( const typename std::vector<Type>::iterator & i )                   { return &(*i); }
-
-        template <typename Type> 
-            const Type * AsPointer( const typename std::vector<Type>::const_iterator & i )       { return &(*i); }
-
-        template <typename Type> 
-            Type * AsPointer( const __gnu_cxx::__normal_iterator<Type, std::vector<Type> > & i )       { return &(*i); }
+            //  libstdc++ vector and string iterators are both __normal_iterator wrappers
+            //  around a raw pointer (which is also valid for the end iterator)
+        template <typename Ptr, typename Container>
+            Ptr AsPointer( const __gnu_cxx::__normal_iterator<Ptr, Container> & i )            { return i.base(); }
 
     #endif
 
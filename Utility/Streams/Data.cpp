@@ -14,6 +14,8 @@
 #include "Stream.h"
 #include "StreamTypes.h"
 #include <vector>
+#include <algorithm>
+#include <new>
 #include <assert.h>
 
 namespace Utility
@@ -458,7 +460,7 @@ void Data::SetPreComment(const char* comment)
 
 void Data::SetPostComment(const char* comment)
 {
-    SafeDeleteArray(preComment);
+    SafeDeleteArray(postComment);
     postComment = DupString(comment);
 }
 
@@ -725,9 +727,17 @@ static bool IsValidChar(int c)
     return ( c == -1 || c >= ' ' || c == '\t' || c == '\n' || c == '\r' );
 }
 
-class DataParser {
+// The parser is shared between Data and DataDocument. "Builder" creates and links
+// the nodes. Values that appear unchanged in the source text are passed to the
+// builder as sections of that text (with "persistent" set); others are passed
+// as sections of the parser's temporary buffer.
+
+template<typename Builder>
+    class DataParser {
 public:
-    DataParser(Data* root);
+    typedef typename Builder::Node Node;
+
+    DataParser(Builder& builder, Node* root);
     ~DataParser();
 
     bool InitFromFile(const char* filename);
@@ -735,9 +745,9 @@ public:
 
     int Space();
     void Newline();
-    Data* Scalar();
-    Data* List();
-    Data* Group();
+    Node* Scalar();
+    Node* List();
+    Node* Group();
     void Line();
     void Graph();
 
@@ -752,16 +762,19 @@ private:
     void SaveCurrent();
     void Match(int t);
     void MatchClose(int t, int lineNo);
+    StringSection<char> Buffer() const { return StringSection<char>(_buf.get(), _buf.get() + _offset); }
 
-    char* _data;
+    Builder* _builder;
+    std::unique_ptr<char[]> _data;
     int _count;
     const char* _p;
+    const char* _lookaheadPtr;
     int _lookahead;
     std::unique_ptr<char[]> _buf;
     int _offset;
-    Data* _lineParent;
+    Node* _lineParent;
     int _parentIndent[MAX_INDENT];
-    Data* _parent[MAX_INDENT];
+    Node* _parent[MAX_INDENT];
     int _level;
     int _nest;
     bool _startOfLine;
@@ -774,11 +787,13 @@ private:
     bool _error;
 };
 
-DataParser::DataParser(Data* root)
+template<typename Builder>
+    DataParser<Builder>::DataParser(Builder& builder, Node* root)
 {
-    _data = NULL;
+    _builder = &builder;
     _count = 0;
-    _p = _data;
+    _p = nullptr;
+    _lookaheadPtr = nullptr;
     _lookahead = -1;
     _offset = 0;
     _lineParent = 0;
@@ -797,13 +812,14 @@ DataParser::DataParser(Data* root)
     _error = false;
 }
 
-DataParser::~DataParser()
+template<typename Builder>
+    DataParser<Builder>::~DataParser()
 {
-    delete [] _data;
     free(_comment);
 }
 
-void DataParser::Report(const char* msg)
+template<typename Builder>
+    void DataParser<Builder>::Report(const char* msg)
 {
 //    LogSave(LOG_PRI_ERROR, _parent[0]->value, _lineNum);
 //    CommonDllWarning("%s", msg);
@@ -811,12 +827,13 @@ void DataParser::Report(const char* msg)
     _lookahead = -1;
 }
 
-void DataParser::Init()
+template<typename Builder>
+    void DataParser<Builder>::Init()
 {
     assert(XlIsValidUtf8((const utf8*)_p, _count));
 
     // scan for encoding tags
-    if (XlHasUtf8Bom((const utf8*)_p)) {
+    if (_count >= 3 && XlHasUtf8Bom((const utf8*)_p)) {
         _p += 3;
         _count -= 3;
     }
@@ -824,23 +841,9 @@ void DataParser::Init()
     NextChar();
 }
 
-bool DataParser::InitFromFile(const char* filename)
+template<typename Builder>
+    bool DataParser<Builder>::InitFromFile(const char* filename)
 {
-    // MemoryMap* mm = XlOpenMemoryMap(filename);
-    // if (!mm) {
-    //     //CommonDllWarning("Failed to open file: %s", filename);
-    //     return false;
-    // }
-    // 
-    // _data = new char[mm->len];
-    // XlCopyMemory(_data, mm->addr, mm->len);
-    // _count = mm->len;
-    // _p = _data;
-    // 
-    // XlCloseMemoryMap(mm);
-
-    delete[] _data; _data = NULL;
-
     size_t size = 0;
     {
         Utility::BasicFile file(filename, "rb");
@@ -848,31 +851,33 @@ bool DataParser::InitFromFile(const char* filename)
         size = file.TellP();
         file.Seek(0, SEEK_SET);
 
-        _data = new char[size];
-        file.Read(_data, 1, size);
+        _data = std::make_unique<char[]>(size);
+        file.Read(_data.get(), 1, size);
     }
     _count = (int)size;
-    _p = _data;
+    _p = _data.get();
 
     Init();
 
     return true;
 }
 
-void DataParser::InitFromString(const char* str, int len)
+template<typename Builder>
+    void DataParser<Builder>::InitFromString(const char* str, int len)
 {
-    _data = new char[len];
-    XlCopyMemory(_data, str, len);
-
-    _p = _data;
+        // (parse in place; "str" must remain valid until parsing is finished,
+        // and for longer if the builder keeps persistent strings)
+    _p = str;
     _count = len;
     Init();
 }
 
-void DataParser::NextChar()
+template<typename Builder>
+    void DataParser<Builder>::NextChar()
 {
     if (_count == 0) {
         _lookahead = -1;
+        _lookaheadPtr = _p;
     } else {
         if (IsBreakChar(_lookahead)) {
             _startOfLine = true;
@@ -881,6 +886,7 @@ void DataParser::NextChar()
             _startOfLine = false;
         }
 
+        _lookaheadPtr = _p;
         _lookahead = *(uint8*)_p++;
         _count--;
 
@@ -900,13 +906,15 @@ void DataParser::NextChar()
     }
 }
 
-void DataParser::ClearBuffer()
+template<typename Builder>
+    void DataParser<Builder>::ClearBuffer()
 {
     _offset = 0;
     _reportToken = true;
 }
 
-void DataParser::SaveChar(int c)
+template<typename Builder>
+    void DataParser<Builder>::SaveChar(int c)
 {
     if (_offset >= BSIZE) {
         if (_reportToken) {
@@ -918,13 +926,15 @@ void DataParser::SaveChar(int c)
     }
 }
 
-void DataParser::SaveCurrent()
+template<typename Builder>
+    void DataParser<Builder>::SaveCurrent()
 {
     SaveChar(_lookahead);
     NextChar();
 }
 
-void DataParser::Match(int t)
+template<typename Builder>
+    void DataParser<Builder>::Match(int t)
 {
     if (_lookahead == t) {
         NextChar();
@@ -935,7 +945,8 @@ void DataParser::Match(int t)
     }
 }
 
-void DataParser::MatchClose(int t, int lineNo)
+template<typename Builder>
+    void DataParser<Builder>::MatchClose(int t, int lineNo)
 {
     if (_lookahead == t) {
         NextChar();
@@ -946,7 +957,8 @@ void DataParser::MatchClose(int t, int lineNo)
     }
 }
 
-int DataParser::Space()
+template<typename Builder>
+    int DataParser<Builder>::Space()
 {
     int i = 0;
     while (_lookahead == ' ' || _lookahead == '\t' || 
@@ -957,7 +969,8 @@ int DataParser::Space()
     return i;
 }
 
-void DataParser::Newline()
+template<typename Builder>
+    void DataParser<Builder>::Newline()
 {
     if (_lookahead == '\r') {
         NextChar();
@@ -974,7 +987,8 @@ void DataParser::Newline()
     }
 }
 
-Data* DataParser::Scalar()
+template<typename Builder>
+    auto DataParser<Builder>::Scalar() -> Node*
 {
     int startLineNum = _lineNum;
     ClearBuffer();
@@ -985,25 +999,25 @@ Data* DataParser::Scalar()
 
         if (_lookahead == '?') {
             NextChar();
-            Data* meta = new Data("#?");
+            Node* meta = _builder->NewNode(MakeStringSection("#?"), true);
 
             if (_comment) {
-                meta->SetPreComment(_comment);
+                _builder->SetPreComment(meta, _comment);
                 free(_comment);
                 _comment = 0;
             }
 
-            Data* oldParent = _lineParent;
+            Node* oldParent = _lineParent;
             _lineParent = meta;
             List();
             _lineParent = oldParent;
 
             if (_level > 1) {
                 Report("meta data can only exist at the top level");
-                delete meta;
+                _builder->Delete(meta);
             } else {
                 // This replaces any previous meta data.
-                 _parent[0]->SetMeta(meta);
+                _builder->SetMeta(_parent[0], meta);
             }
 
             return 0;
@@ -1032,7 +1046,7 @@ Data* DataParser::Scalar()
 				}
             } else {
                 SaveChar('\0');
-                _lineParent->SetPostComment(_buf.get());
+                _builder->SetPostComment(_lineParent, _buf.get());
             }
 
             return 0;
@@ -1047,12 +1061,21 @@ Data* DataParser::Scalar()
     else
         quote = 0;
 
+    StringSection<char> value;
+    bool persistent = false;
+
     if (quote) {
         bool reportTabs = _reportTabs;
         _reportTabs = false;
         NextChar();
+
+            // If there are no escapes or line breaks, the value is exactly the
+            // text between the quotes
+        const char* start = _lookaheadPtr;
+        bool verbatim = true;
         while (_lookahead >= 0 && _lookahead != quote) {
             if (_lookahead == '\\') {
+                verbatim = false;
                 NextChar();
                 if (!IsEscapeableChar(_lookahead))
                     SaveChar('\\');
@@ -1060,6 +1083,7 @@ Data* DataParser::Scalar()
 
             } else if (IsBreakChar(_lookahead)) {
                 // All EOL's become \n in the value.
+                verbatim = false;
                 Newline();
                 SaveChar('\n');
 
@@ -1068,6 +1092,13 @@ Data* DataParser::Scalar()
             }
         }
 
+        if (verbatim) {
+            value = StringSection<char>(start, _lookaheadPtr);
+            persistent = true;
+        } else {
+            value = Buffer();
+        }
+
         if (_lookahead != quote)
             Report("missing end quote");
 
@@ -1081,6 +1112,7 @@ Data* DataParser::Scalar()
         int saveLineNum = _lineNum;
         int saveCount = _count;
         const char* saveP = _p;
+        const char* saveLookaheadPtr = _lookaheadPtr;
 
         Newline();
         startLineNum = _lineNum;
@@ -1102,6 +1134,7 @@ Data* DataParser::Scalar()
             saveLineNum = _lineNum;
             saveCount = _count;
             saveP = _p;
+            saveLookaheadPtr = _lookaheadPtr;
 
             Newline();
             indent = Space();
@@ -1113,35 +1146,42 @@ Data* DataParser::Scalar()
         _lineNum = saveLineNum;
         _count = saveCount;
         _p = saveP;
+        _lookaheadPtr = saveLookaheadPtr;
+
+        value = Buffer();
 
     } else {
         if (!(IsValidChar(_lookahead))) {
             Report("illegal character in file");
             SaveCurrent();
+            value = Buffer();
         } else {
+                // (words never contain escapes, so they can always be
+                // taken directly from the source text)
+            const char* start = _lookaheadPtr;
             while (IsWordChar(_lookahead))
-                SaveCurrent();
+                NextChar();
+            value = StringSection<char>(start, _lookaheadPtr);
+            persistent = true;
         }
     }
 
-    Data* n;
-    if (_offset > 0 || quote) {
-        SaveChar('\0');
-
-        n = new Data(_buf.get());
+    Node* n;
+    if (!value.Empty() || quote) {
+        n = _builder->NewNode(value, persistent);
         if (_comment) {
-            if (!_lineParent->parent && !_lineParent->child) {
+            if (_builder->IsEmptyRoot(_lineParent)) {
                 // special case for first comment in the file
-                _lineParent->SetPreComment(_comment);
+                _builder->SetPreComment(_lineParent, _comment);
             } else {
-                n->SetPreComment(_comment);
+                _builder->SetPreComment(n, _comment);
             }
             free(_comment);
             _comment = 0;
         }
-        n->lineNum = startLineNum;
+        _builder->SetLineNumber(n, startLineNum);
 
-        _lineParent->Add(n);
+        _builder->Add(_lineParent, n);
         _lineParent = n;
     } else {
         n = 0;
@@ -1150,10 +1190,11 @@ Data* DataParser::Scalar()
     return n;
 }
 
-Data* DataParser::List()
+template<typename Builder>
+    auto DataParser<Builder>::List() -> Node*
 {
-    Data* p = _lineParent;
-    Data* n = Group();
+    Node* p = _lineParent;
+    Node* n = Group();
 
     for (;;) {
         Space();
@@ -1171,9 +1212,10 @@ Data* DataParser::List()
     return n;
 }
 
-Data* DataParser::Group()
+template<typename Builder>
+    auto DataParser<Builder>::Group() -> Node*
 {
-    Data* n;
+    Node* n;
 
     if (_lookahead == '(') {
         int lineNum = _lineNum;
@@ -1191,7 +1233,8 @@ Data* DataParser::Group()
     return n;
 }
 
-void DataParser::Line()
+template<typename Builder>
+    void DataParser<Builder>::Line()
 {
     if (_level >= MAX_INDENT - 1) {
         _error = true;
@@ -1212,7 +1255,7 @@ void DataParser::Line()
     }
 
     _lineParent = _parent[_level-1];
-    Data* n = List();
+    Node* n = List();
     Space();
 
     if (n) {
@@ -1224,7 +1267,8 @@ void DataParser::Line()
 }
 
 
-void DataParser::Graph()
+template<typename Builder>
+    void DataParser<Builder>::Graph()
 {
     Line();
     while (_lookahead >= 0 && !_error) {
@@ -1238,10 +1282,34 @@ void DataParser::Graph()
     }
 
     if (_comment) {
-        _parent[0]->SetPostComment(_comment);
+        _builder->SetPostComment(_parent[0], _comment);
     }
 }
 
+class DataBuilder
+{
+public:
+    typedef Data Node;
+
+    Data* NewNode(StringSection<char> value, bool)
+    {
+        _scratch.assign(value.begin(), value.end());
+        _scratch.push_back('\0');
+        return new Data(AsPointer(_scratch.cbegin()));
+    }
+
+    void Delete(Data* node)                                 { delete node; }
+    void Add(Data* parent, Data* child)                     { parent->Add(child); }
+    void SetPreComment(Data* node, const char* comment)     { node->SetPreComment(comment); }
+    void SetPostComment(Data* node, const char* comment)    { node->SetPostComment(comment); }
+    void SetMeta(Data* node, Data* meta)                    { node->SetMeta(meta); }
+    void SetLineNumber(Data* node, int lineNum)             { node->lineNum = lineNum; }
+    bool IsEmptyRoot(const Data* node)                      { return !node->parent && !node->child; }
+
+private:
+    std::vector<char> _scratch;
+};
+
 // --------------------------------------------------------------------------
 // Serialization
 // --------------------------------------------------------------------------
@@ -1254,7 +1322,8 @@ bool Data::Load(const char* ptr, int len)
         return true;
     }
 
-    DataParser parser(this);
+    DataBuilder builder;
+    DataParser<DataBuilder> parser(builder, this);
     parser.InitFromString(ptr, len);
 
     Clear();
@@ -1265,7 +1334,8 @@ bool Data::Load(const char* ptr, int len)
 bool Data::LoadFromFile(const char* filename, bool* noFile)
 {
     SetValue(filename);
-    DataParser parser(this);
+    DataBuilder builder;
+    DataParser<DataBuilder> parser(builder, this);
     if (!parser.InitFromFile(filename)) {
         if (noFile) {
             *noFile = true;
@@ -1493,5 +1563,509 @@ bool Data::SaveToBuffer(char* s, int* len) const
     return true;
 }
 
+// --------------------------------------------------------------------------
+// DataDocument
+// --------------------------------------------------------------------------
+
+class DataNode::ChildIndex
+{
+public:
+    class Entry
+    {
+    public:
+        uint64      _hash;
+        DataNode*   _first;
+    };
+    Entry*      _entries;
+    unsigned    _mask;
+};
+
+DataNode::DataNode(StringSection<char> value, uint64 hash)
+: _value(value), _hash(hash)
+, _parent(nullptr), _firstChild(nullptr), _lastChild(nullptr)
+, _next(nullptr), _prev(nullptr), _nextSameValue(nullptr)
+, _childIndex(nullptr), _childCount(0), _lineNum(0)
+{
+}
+
+static uint64 HashValue(StringSection<char> value)
+{
+    return Hash64(value.begin(), value.end());
+}
+
+const DataNode* DataNode::ChildAt(unsigned index) const
+{
+    const DataNode* p = _firstChild;
+    while (p && index--) {
+        p = p->_next;
+    }
+    return p;
+}
+
+const DataNode* DataNode::ChildWithValue(StringSection<char> value) const
+{
+    auto hash = HashValue(value);
+    if (_childIndex) {
+        auto mask = _childIndex->_mask;
+        for (auto i = unsigned(hash) & mask;; i = (i+1) & mask) {
+            const auto& entry = _childIndex->_entries[i];
+            if (!entry._first) return nullptr;
+            if (entry._hash == hash && XlEqString(entry._first->_value, value))
+                return entry._first;
+        }
+    }
+
+    for (auto* c = _firstChild; c; c = c->_next)
+        if (c->_hash == hash && XlEqString(c->_value, value))
+            return c;
+    return nullptr;
+}
+
+const DataNode* DataNode::NextWithValue(StringSection<char> value) const
+{
+    auto hash = HashValue(value);
+    if (_parent && _parent->_childIndex && _hash == hash && XlEqString(_value, value))
+        return _nextSameValue;
+
+    for (auto* c = _next; c; c = c->_next)
+        if (c->_hash == hash && XlEqString(c->_value, value))
+            return c;
+    return nullptr;
+}
+
+    //  Parse "[n]" from a path ("i" starts on the '[')
+static bool ParsePathIndex(const char*& i, const char* end, unsigned& result, bool allowEmpty)
+{
+    assert(*i == '[');
+    const char* start = ++i;
+    result = 0;
+    while (i < end && XlIsDigit(*i)) {
+        result = result * 10 + unsigned(*i - '0');
+        ++i;
+    }
+    if (i == end || *i != ']' || (i == start && !allowEmpty))
+        return false;
+    ++i;
+    return true;
+}
+
+const DataNode* DataNode::Find(StringSection<char> path) const
+{
+        //  Supports the same path language as Data::Find; except that "name[]"
+        //  is the same as "name[0]" (since we only return a single node)
+    const DataNode* node = this;
+    const char* i = path.begin();
+    while (node && i < path.end()) {
+        if (*i == '.') {
+            ++i;
+            continue;
+        }
+
+        if (*i == '[') {
+            unsigned index;
+            if (!ParsePathIndex(i, path.end(), index, false))
+                return nullptr;
+            node = node->ChildAt(index);
+            continue;
+        }
+
+        StringSection<char> name;
+        if (*i == '\'' || *i == '"') {
+            char quote = *i++;
+            const char* start = i;
+            while (i < path.end() && *i != quote) ++i;
+            name = StringSection<char>(start, i);
+            if (i < path.end()) ++i;
+        } else {
+            const char* start = i;
+            while (i < path.end() && IsPathWordChar(*i)) ++i;
+            name = StringSection<char>(start, i);
+            if (name.Empty()) return nullptr;
+        }
+
+        unsigned index = 0;
+        if (i < path.end() && *i == '[')
+            if (!ParsePathIndex(i, path.end(), index, true))
+                return nullptr;
+
+        node = node->ChildWithValue(name);
+        while (node && index--)
+            node = node->NextWithValue(name);
+    }
+    return node;
+}
+
+const DataNode* DataNode::Attribute(StringSection<char> path) const
+{
+    auto* node = Find(path);
+    return node ? node->_firstChild : nullptr;
 }
 
+    //  (the string to number conversions require null terminated strings)
+template<int Count>
+    static const char* TerminatedCopy(StringSection<char> str, char (&buffer)[Count])
+    {
+        auto length = std::min(str.Length(), size_t(Count-1));
+        XlCopyMemory(buffer, str.begin(), length);
+        buffer[length] = '\0';
+        return buffer;
+    }
+
+bool DataNode::BoolValue() const        { char buffer[64]; return XlAtoBool(TerminatedCopy(_value, buffer)); }
+int DataNode::IntValue() const          { char buffer[64]; return XlAtoI32(TerminatedCopy(_value, buffer)); }
+int64 DataNode::Int64Value() const      { char buffer[64]; return XlAtoI64(TerminatedCopy(_value, buffer)); }
+float DataNode::FloatValue() const      { char buffer[64]; return XlAtoF32(TerminatedCopy(_value, buffer)); }
+double DataNode::DoubleValue() const    { char buffer[64]; return XlAtoF64(TerminatedCopy(_value, buffer)); }
+
+bool DataNode::BoolAttribute(StringSection<char> path, bool def) const
+{
+    auto* a = Attribute(path);
+    return a ? a->BoolValue() : def;
+}
+
+int DataNode::IntAttribute(StringSection<char> path, int def) const
+{
+    auto* a = Attribute(path);
+    return a ? a->IntValue() : def;
+}
+
+int64 DataNode::Int64Attribute(StringSection<char> path, int64 def) const
+{
+    auto* a = Attribute(path);
+    return a ? a->Int64Value() : def;
+}
+
+float DataNode::FloatAttribute(StringSection<char> path, float def) const
+{
+    auto* a = Attribute(path);
+    return a ? a->FloatValue() : def;
+}
+
+double DataNode::DoubleAttribute(StringSection<char> path, double def) const
+{
+    auto* a = Attribute(path);
+    return a ? a->DoubleValue() : def;
+}
+
+StringSection<char> DataNode::StrAttribute(StringSection<char> path, StringSection<char> def) const
+{
+    auto* a = Attribute(path);
+    return a ? a->_value : def;
+}
+
+Data* DataNode::CloneAsData() const
+{
+    auto* result = new Data(_value.AsString().c_str());
+    if (!_preComment.Empty())
+        result->SetPreComment(_preComment.AsString().c_str());
+    if (!_postComment.Empty())
+        result->SetPostComment(_postComment.AsString().c_str());
+    result->lineNum = _lineNum;
+
+        //  (link the children directly, because Data::Add() searches for the end of the list)
+    Data* prev = nullptr;
+    for (auto* c = _firstChild; c; c = c->_next) {
+        auto* n = c->CloneAsData();
+        n->parent = result;
+        n->prev = prev;
+        if (prev) prev->next = n;
+        else result->child = n;
+        prev = n;
+    }
+    return result;
+}
+
+class DataDocument::Pimpl
+{
+public:
+    class InternedString
+    {
+    public:
+        uint64              _hash;
+        StringSection<char> _value;
+    };
+
+    std::vector<std::unique_ptr<uint8[]>> _blocks;
+    uint8*                      _blockNext;
+    uint8*                      _blockEnd;
+    size_t                      _arenaSize;
+
+    std::vector<InternedString> _internTable;
+    size_t                      _internCount;
+
+    DataNode*                   _root;
+    DataNode*                   _meta;
+    MemoryMappedFile            _sourceFile;
+
+    void*               Allocate(size_t size, size_t alignment);
+    StringSection<char> CopyString(StringSection<char> str);
+    StringSection<char> Intern(StringSection<char> str, uint64 hash, bool persistent);
+    void                GrowInternTable();
+    void                Reset();
+
+    Pimpl();
+};
+
+static const size_t ArenaBlockSize = 64 * 1024;
+static const size_t InitialInternTableSize = 256;
+
+void* DataDocument::Pimpl::Allocate(size_t size, size_t alignment)
+{
+    auto align = [alignment](uint8* ptr) { return (uint8*)((size_t(ptr) + alignment - 1) & ~(alignment - 1)); };
+
+    if (_blockNext) {
+        auto* result = align(_blockNext);
+        if (result + size <= _blockEnd) {
+            _blockNext = result + size;
+            return result;
+        }
+    }
+
+        //  Large allocations get a block of their own, so that we don't throw 
+        //  away the rest of the current block
+    if (size > ArenaBlockSize / 4) {
+        _blocks.push_back(std::unique_ptr<uint8[]>(new uint8[size + alignment]));
+        _arenaSize += size + alignment;
+        return align(_blocks.back().get());
+    }
+
+    _blocks.push_back(std::unique_ptr<uint8[]>(new uint8[ArenaBlockSize]));
+    _arenaSize += ArenaBlockSize;
+    auto* result = align(_blocks.back().get());
+    _blockNext = result + size;
+    _blockEnd = _blocks.back().get() + ArenaBlockSize;
+    return result;
+}
+
+StringSection<char> DataDocument::Pimpl::CopyString(StringSection<char> str)
+{
+    auto* dst = (char*)Allocate(str.Length(), 1);
+    XlCopyMemory(dst, str.begin(), str.Length());
+    return StringSection<char>(dst, dst + str.Length());
+}
+
+StringSection<char> DataDocument::Pimpl::Intern(StringSection<char> str, uint64 hash, bool persistent)
+{
+    static const char emptyString[] = "";
+    if (str.Empty())
+        return StringSection<char>(emptyString, emptyString);
+
+    if ((_internCount + 1) * 2 > _internTable.size())
+        GrowInternTable();
+
+    auto mask = _internTable.size() - 1;
+    for (auto i = size_t(hash) & mask;; i = (i+1) & mask) {
+        auto& entry = _internTable[i];
+        if (!entry._value._start) {
+            entry._hash = hash;
+            entry._value = persistent ? str : CopyString(str);
+            ++_internCount;
+            return entry._value;
+        }
+        if (entry._hash == hash && XlEqString(entry._value, str))
+            return entry._value;
+    }
+}
+
+void DataDocument::Pimpl::GrowInternTable()
+{
+    std::vector<InternedString> newTable(std::max(_internTable.size() * 2, InitialInternTableSize));
+    auto mask = newTable.size() - 1;
+    for (const auto& e:_internTable) {
+        if (!e._value._start) continue;
+        auto i = size_t(e._hash) & mask;
+        while (newTable[i]._value._start) i = (i+1) & mask;
+        newTable[i] = e;
+    }
+    _internTable = std::move(newTable);
+}
+
+void DataDocument::Pimpl::Reset()
+{
+    _blocks.clear();
+    _blockNext = _blockEnd = nullptr;
+    _arenaSize = 0;
+    _internTable.clear();
+    _internCount = 0;
+    _root = _meta = nullptr;
+    _sourceFile = MemoryMappedFile();
+}
+
+DataDocument::Pimpl::Pimpl()
+: _blockNext(nullptr), _blockEnd(nullptr), _arenaSize(0)
+, _internCount(0), _root(nullptr), _meta(nullptr)
+{
+}
+
+class DataDocumentBuilder
+{
+public:
+    typedef DataNode Node;
+
+    DataNode* NewNode(StringSection<char> value, bool persistent)
+    {
+        auto hash = HashValue(value);
+        auto interned = _pimpl->Intern(value, hash, persistent);
+        return new(_pimpl->Allocate(sizeof(DataNode), sizeof(uint64))) DataNode(interned, hash);
+    }
+
+    void Delete(DataNode*) {}      // (released along with the arena)
+
+    void Add(DataNode* parent, DataNode* child)
+    {
+        assert(!child->_parent && !child->_next && !child->_prev);
+        child->_parent = parent;
+        child->_prev = parent->_lastChild;
+        if (parent->_lastChild) parent->_lastChild->_next = child;
+        else parent->_firstChild = child;
+        parent->_lastChild = child;
+        ++parent->_childCount;
+        parent->_childIndex = nullptr;
+    }
+
+    void SetPreComment(DataNode* node, const char* comment)     { node->_preComment = _pimpl->CopyString(MakeStringSection(comment)); }
+    void SetPostComment(DataNode* node, const char* comment)    { node->_postComment = _pimpl->CopyString(MakeStringSection(comment)); }
+    void SetMeta(DataNode*, DataNode* meta)                     { _pimpl->_meta = meta; }
+    void SetLineNumber(DataNode* node, int lineNum)             { node->_lineNum = lineNum; }
+    bool IsEmptyRoot(const DataNode* node)                      { return !node->_parent && !node->_firstChild; }
+
+    void BuildChildIndices(DataNode& node, unsigned minChildCount);
+
+    DataDocumentBuilder(DataDocument::Pimpl& pimpl) : _pimpl(&pimpl) {}
+private:
+    DataDocument::Pimpl* _pimpl;
+    std::vector<DataNode*> _lastInSlot;
+
+    void BuildChildIndex(DataNode& node);
+};
+
+void DataDocumentBuilder::BuildChildIndex(DataNode& node)
+{
+    typedef DataNode::ChildIndex::Entry Entry;
+
+    unsigned capacity = 1;
+    while (capacity < node._childCount * 2) capacity <<= 1;
+
+    auto* index = new(_pimpl->Allocate(sizeof(DataNode::ChildIndex), sizeof(uint64))) DataNode::ChildIndex;
+    index->_entries = (Entry*)_pimpl->Allocate(sizeof(Entry) * capacity, sizeof(uint64));
+    index->_mask = capacity - 1;
+    for (unsigned c=0; c<capacity; ++c) {
+        index->_entries[c]._hash = 0;
+        index->_entries[c]._first = nullptr;
+    }
+
+        //  Each slot records the first child with a given value. Children with 
+        //  the same value are linked together through _nextSameValue. Values are
+        //  interned, so equal values have the same pointer.
+    _lastInSlot.resize(capacity);
+    for (auto* c = node._firstChild; c; c = c->_next) {
+        c->_nextSameValue = nullptr;
+        for (auto i = unsigned(c->_hash) & index->_mask;; i = (i+1) & index->_mask) {
+            auto& entry = index->_entries[i];
+            if (!entry._first) {
+                entry._hash = c->_hash;
+                entry._first = c;
+                _lastInSlot[i] = c;
+                break;
+            }
+            if (entry._hash == c->_hash && entry._first->_value._start == c->_value._start) {
+                _lastInSlot[i]->_nextSameValue = c;
+                _lastInSlot[i] = c;
+                break;
+            }
+        }
+    }
+
+    node._childIndex = index;
+}
+
+void DataDocumentBuilder::BuildChildIndices(DataNode& node, unsigned minChildCount)
+{
+    if (node._childCount >= minChildCount && !node._childIndex)
+        BuildChildIndex(node);
+    for (auto* c = node._firstChild; c; c = c->_next)
+        BuildChildIndices(*c, minChildCount);
+}
+
+bool DataDocument::Load(StringSection<char> source, unsigned childIndexThreshold)
+{
+    _pimpl->Reset();
+    DataDocumentBuilder builder(*_pimpl);
+    _pimpl->_root = builder.NewNode(MakeStringSection("__none__"), true);
+    if (source.Empty())
+        return true;
+
+    DataParser<DataDocumentBuilder> parser(builder, _pimpl->_root);
+    parser.InitFromString(source.begin(), int(source.Length()));
+    parser.Graph();
+    builder.BuildChildIndices(*_pimpl->_root, childIndexThreshold);
+    return !parser.Error();
+}
+
+bool DataDocument::LoadFromFile(const char filename[], unsigned childIndexThreshold)
+{
+    _pimpl->Reset();
+    DataDocumentBuilder builder(*_pimpl);
+    _pimpl->_root = builder.NewNode(MakeStringSection(filename), false);
+
+    _pimpl->_sourceFile = MemoryMappedFile(
+        filename, 0, MemoryMappedFile::Access::Read | MemoryMappedFile::Access::Sequential, 
+        BasicFile::ShareMode::Read);
+    if (!_pimpl->_sourceFile.IsValid())
+        return false;
+
+    auto size = _pimpl->_sourceFile.GetSize();
+    if (!size)
+        return true;
+
+    DataParser<DataDocumentBuilder> parser(builder, _pimpl->_root);
+    parser.InitFromString((const char*)_pimpl->_sourceFile.GetData(), int(size));
+    parser.Graph();
+    builder.BuildChildIndices(*_pimpl->_root, childIndexThreshold);
+    return !parser.Error();
+}
+
+const DataNode& DataDocument::Root() const  { return *_pimpl->_root; }
+DataNode& DataDocument::Root()              { return *_pimpl->_root; }
+const DataNode* DataDocument::Meta() const  { return _pimpl->_meta; }
+
+DataNode* DataDocument::CreateNode(StringSection<char> value)
+{
+    return DataDocumentBuilder(*_pimpl).NewNode(value, false);
+}
+
+void DataDocument::Add(DataNode& parent, DataNode& child)
+{
+    DataDocumentBuilder(*_pimpl).Add(&parent, &child);
+}
+
+void DataDocument::BuildChildIndices(unsigned minChildCount)
+{
+    DataDocumentBuilder(*_pimpl).BuildChildIndices(*_pimpl->_root, minChildCount);
+}
+
+size_t DataDocument::GetArenaSize() const
+{
+    return _pimpl->_arenaSize;
+}
+
+DataDocument::DataDocument()
+{
+    _pimpl = std::make_unique<Pimpl>();
+    _pimpl->_root = DataDocumentBuilder(*_pimpl).NewNode(MakeStringSection("__none__"), true);
+}
+
+DataDocument::DataDocument(DataDocument&& moveFrom)
+: _pimpl(std::move(moveFrom._pimpl))
+{
+}
+
+DataDocument& DataDocument::operator=(DataDocument&& moveFrom)
+{
+    _pimpl = std::move(moveFrom._pimpl);
+    return *this;
+}
+
+DataDocument::~DataDocument() {}
+
+}
@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include "../StringUtils.h"
 #include "../../Core/Types.h"
+#include <memory>
 
 namespace Utility
 {
@@ -115,6 +117,126 @@ namespace Utility
         void SaveToOutputStream(OutputStream& f, bool includeComment = true) const;
     };
 
+    class DataDocument;
+    class DataDocumentBuilder;
+
+    /// <summary>Read-mostly node in a DataDocument</summary>
+    /// Nodes are allocated from the arena of the document that owns them, and are only
+    /// valid for the lifetime of that document. The strings are not null terminated.
+    /// Strings that appear in the source text unchanged point directly into that text;
+    /// other strings (eg, quoted strings with escapes) are copied into the arena.
+    ///
+    /// Lookups by value compare hashes first. Nodes with many children can have a 
+    /// hashed index (see DataDocument::BuildChildIndices), which makes ChildWithValue()
+    /// and NextWithValue() constant time.
+    class DataNode
+    {
+    public:
+        StringSection<char>     Value() const           { return _value; }
+        StringSection<char>     PreComment() const      { return _preComment; }
+        StringSection<char>     PostComment() const     { return _postComment; }
+        int                     LineNumber() const      { return _lineNum; }
+
+        const DataNode*         Parent() const          { return _parent; }
+        const DataNode*         FirstChild() const      { return _firstChild; }
+        const DataNode*         NextSibling() const     { return _next; }
+        const DataNode*         PrevSibling() const     { return _prev; }
+        unsigned                ChildCount() const      { return _childCount; }
+        const DataNode*         ChildAt(unsigned index) const;
+
+        const DataNode*         ChildWithValue(StringSection<char> value) const;
+        const DataNode*         NextWithValue(StringSection<char> value) const;
+
+            //  "path" uses the same syntax as Data::Find(). Eg, "Material.Texture[1]"
+        const DataNode*         Find(StringSection<char> path) const;
+        const DataNode*         Attribute(StringSection<char> path) const;
+
+        bool                    BoolAttribute(StringSection<char> path, bool def = false) const;
+        int                     IntAttribute(StringSection<char> path, int def = 0) const;
+        int64                   Int64Attribute(StringSection<char> path, int64 def = 0) const;
+        float                   FloatAttribute(StringSection<char> path, float def = 0.f) const;
+        double                  DoubleAttribute(StringSection<char> path, double def = 0.) const;
+        StringSection<char>     StrAttribute(StringSection<char> path, StringSection<char> def = StringSection<char>()) const;
+
+        bool                    BoolValue() const;
+        int                     IntValue() const;
+        int64                   Int64Value() const;
+        float                   FloatValue() const;
+        double                  DoubleValue() const;
+
+            //  Copy this node and all of its children into a new Data tree (for 
+            //  clients that need to modify or save the result)
+        Data*                   CloneAsData() const;
+
+    private:
+        class ChildIndex;
+
+        StringSection<char>     _value;
+        StringSection<char>     _preComment;
+        StringSection<char>     _postComment;
+        uint64                  _hash;
+        DataNode*               _parent;
+        DataNode*               _firstChild;
+        DataNode*               _lastChild;
+        DataNode*               _next;
+        DataNode*               _prev;
+        DataNode*               _nextSameValue;     // only valid when the parent has a _childIndex
+        const ChildIndex*       _childIndex;
+        unsigned                _childCount;
+        int                     _lineNum;
+
+        DataNode(StringSection<char> value, uint64 hash);
+        friend class DataDocument;
+        friend class DataDocumentBuilder;
+    };
+
+    /// <summary>Arena allocated alternative to Data</summary>
+    /// Parses the same text format as Data, but all nodes and strings are allocated
+    /// from a single arena that is released in one step when the document is
+    /// destroyed (or reloaded). Repeated values are interned, so they are stored only 
+    /// once.
+    ///
+    /// Load() doesn't copy the source text; it must remain valid for the lifetime of
+    /// the document. LoadFromFile() parses directly from a memory mapped view of the
+    /// file, and keeps that mapping open.
+    ///
+    /// The document is intended for loading & querying. Once loaded, it can be read 
+    /// from multiple threads. Use DataNode::CloneAsData() when the tree must be 
+    /// modified or saved.
+    class DataDocument
+    {
+    public:
+        static const unsigned DefaultIndexThreshold = 16;
+
+        bool Load(StringSection<char> source, unsigned childIndexThreshold = DefaultIndexThreshold);
+        bool LoadFromFile(const char filename[], unsigned childIndexThreshold = DefaultIndexThreshold);
+
+        const DataNode& Root() const;
+        const DataNode* Meta() const;
+        const DataNode* Find(StringSection<char> path) const { return Root().Find(path); }
+
+            //  Building documents programmatically. Adding children to a node removes 
+            //  its child index; call BuildChildIndices() again afterwards if necessary.
+        DataNode&   Root();
+        DataNode*   CreateNode(StringSection<char> value);
+        void        Add(DataNode& parent, DataNode& child);
+
+            //  Build a hashed child index for each node that has at least
+            //  "minChildCount" children (Load() does this automatically)
+        void        BuildChildIndices(unsigned minChildCount = DefaultIndexThreshold);
+
+        size_t      GetArenaSize() const;
+
+        DataDocument();
+        DataDocument(DataDocument&& moveFrom);
+        DataDocument& operator=(DataDocument&& moveFrom);
+        ~DataDocument();
+    private:
+        class Pimpl;
+        std::unique_ptr<Pimpl> _pimpl;
+        friend class DataDocumentBuilder;
+    };
+
     #define foreachData(i, d) \
         for (Data* i = (d)->child; i; i = i->next)
     #define foreachDataValue(i, d, v) \
@@ -0,0 +1,185 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../../Core/Prefix.h"
+#include "FileSystemMonitorInternal.h"
+#include "../Threading/LockFree.h"
+#include "../MemoryUtils.h"
+#include "../IteratorUtils.h"
+#include "../TimeUtils.h"
+#include <algorithm>
+
+namespace Utility
+{
+    namespace Internal
+    {
+        uint64 MonitoredCallbacks::HashFilename(StringSection<char> filename)
+        {
+            char buffer[MaxPath];
+            const char *i = filename._start;
+            const char *iend = filename._end;
+            char* b = buffer;
+            while (i!=iend && b!=ArrayEnd(buffer)) {
+                *b = XlToLower(*i); ++i; ++b;
+            }
+            return Hash64(buffer, b);
+        }
+
+        void MonitoredCallbacks::AttachCallback(
+            uint64 filenameHash,
+            std::shared_ptr<OnChangeCallback> callback)
+        {
+            ScopedLock(_callbacksLock);
+            _callbacks.insert(
+                LowerBound(_callbacks, filenameHash),
+                std::make_pair(filenameHash, std::move(callback)));
+        }
+
+        void MonitoredCallbacks::OnChange(StringSection<char> filename)
+        {
+            auto hash = HashFilename(filename);
+            std::weak_ptr<OnChangeCallback> changed[8];
+            std::vector<std::weak_ptr<OnChangeCallback>> changedOverflow;
+            unsigned changedCount = 0;
+
+            {
+                ScopedLock(_callbacksLock);
+                #if (STL_ACTIVE == STL_MSVC) && (_ITERATOR_DEBUG_LEVEL >= 2)
+                    auto range = std::_Equal_range(
+                        _callbacks.begin(), _callbacks.end(), hash, 
+                        CompareFirst<uint64, std::weak_ptr<OnChangeCallback>>(),
+                        _Dist_type(_callbacks.begin()));
+                #else
+                    auto range = std::equal_range(
+                        _callbacks.begin(), _callbacks.end(),
+                        hash, CompareFirst<uint64, std::weak_ptr<OnChangeCallback>>());
+                #endif
+
+                bool foundExpired = false;
+                for (auto i=range.first; i!=range.second; ++i) {
+                    if (i->second.expired()) { foundExpired = true; continue; }
+                    if (changedCount < dimof(changed)) changed[changedCount++] = i->second;
+                    else changedOverflow.push_back(i->second);
+                }
+
+                if (foundExpired) {
+                        // Remove any pointers that have expired
+                        // (note that we only check matching pointers. Non-matching pointers
+                        // that have expired are untouched)
+                    _callbacks.erase(
+                        std::remove_if(range.first, range.second,
+                            [](std::pair<uint64, std::weak_ptr<OnChangeCallback>>& i)
+                            { return i.second.expired(); }),
+                        range.second);
+                }
+            }
+
+            QueueFileChanges(changed, &changed[changedCount]);
+            if (!changedOverflow.empty())
+                QueueFileChanges(AsPointer(changedOverflow.cbegin()), AsPointer(changedOverflow.cend()));
+        }
+
+        MonitoredCallbacks::MonitoredCallbacks() {}
+        MonitoredCallbacks::~MonitoredCallbacks() {}
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+
+        static Threading::Mutex                             PendingChangesLock;
+        static std::vector<std::weak_ptr<OnChangeCallback>> PendingChanges;
+        static uint64                                       PendingFirstTime = 0;
+        static uint64                                       PendingLastTime = 0;
+        static unsigned                                     DebounceMilliseconds = 100;
+
+            //  Only one batch is delivered at a time. This is recursive because callbacks
+            //  are allowed to call FakeFileChange().
+            //  The current batch id is per thread, because OnChange() can also be called
+            //  on other threads while a batch is being delivered (and those calls aren't 
+            //  part of the batch). NextBatchId is protected by DeliveryLock.
+        static Threading::RecursiveMutex                    DeliveryLock;
+        static thread_local unsigned                        CurrentBatchId = 0;
+        static unsigned                                     NextBatchId = 1;
+
+        void QueueFileChanges(const std::weak_ptr<OnChangeCallback>* begin, const std::weak_ptr<OnChangeCallback>* end)
+        {
+            if (begin == end) return;
+
+            auto now = GetPerformanceCounter();
+            ScopedLock(PendingChangesLock);
+            if (PendingChanges.empty())
+                PendingFirstTime = now;
+            PendingLastTime = now;
+            PendingChanges.insert(PendingChanges.end(), begin, end);
+        }
+
+        uint32 GetFileChangeFlushTimeout()
+        {
+            ScopedLock(PendingChangesLock);
+            if (PendingChanges.empty()) return XL_INFINITE;
+
+                //  Wait until there has been a quiet period of "DebounceMilliseconds", but
+                //  don't allow a continuous stream of changes to hold back delivery forever
+            auto frequency = GetPerformanceCounterFrequency();
+            auto window = DebounceMilliseconds * frequency / 1000;
+            auto deadline = std::min(PendingLastTime + window, PendingFirstTime + 10 * window);
+            auto now = GetPerformanceCounter();
+            if (now >= deadline) return 0;
+            return uint32(std::max(uint64(1), (deadline - now) * 1000 / frequency));
+        }
+
+        void FlushFileChanges(bool force)
+        {
+            if (!force && GetFileChangeFlushTimeout() != 0) return;
+
+            std::unique_lock<Threading::RecursiveMutex> deliveryLock(DeliveryLock);
+
+            std::vector<std::weak_ptr<OnChangeCallback>> batch;
+            {
+                ScopedLock(PendingChangesLock);
+                batch.swap(PendingChanges);
+            }
+            if (batch.empty()) return;
+
+                //  Remove duplicates, so that each callback is executed only once per batch
+            std::vector<std::shared_ptr<OnChangeCallback>> callbacks;
+            callbacks.reserve(batch.size());
+            for (const auto& b:batch) {
+                auto l = b.lock();
+                if (l) callbacks.push_back(std::move(l));
+            }
+            std::sort(callbacks.begin(), callbacks.end());
+            callbacks.erase(std::unique(callbacks.begin(), callbacks.end()), callbacks.end());
+
+            auto prevBatchId = CurrentBatchId;
+            CurrentBatchId = NextBatchId++;
+            if (!NextBatchId) NextBatchId = 1;      // (0 is reserved for "no batch")
+
+            for (const auto& c:callbacks)
+                c->OnChange();
+
+            CurrentBatchId = prevBatchId;
+        }
+
+        void ClearFileChanges()
+        {
+            ScopedLock(PendingChangesLock);
+            PendingChanges.clear();
+        }
+    }
+
+    void SetFileSystemMonitorDebounce(unsigned milliseconds)
+    {
+        ScopedLock(Internal::PendingChangesLock);
+        Internal::DebounceMilliseconds = milliseconds;
+    }
+
+    unsigned GetFileChangeBatchId()
+    {
+        return Internal::CurrentBatchId;
+    }
+
+    OnChangeCallback::~OnChangeCallback() {}
+}
+
@@ -27,9 +27,29 @@ namespace Utility
     
     /// <summary>Executed all on-change callbacks associated with file</summary>
     /// This will create a fake change event for a file, and execute any attached
-    /// callbacks.
+    /// callbacks. The callbacks are executed immediately (along with any other changes
+    /// that have been queued), without waiting for the debounce window.
     void    FakeFileChange(StringSection<char> directoryName, StringSection<char> filename);
 
+    /// <summary>Set the window used to coalesce file change events</summary>
+    /// Change events are not delivered immediately. Instead they are queued until no
+    /// new changes have arrived for the given number of milliseconds (or, for a continuous
+    /// stream of changes, until 10 times that period has passed since the first change).
+    /// The queued changes are then delivered as a single batch, and each callback is 
+    /// executed at most once per batch, regardless of how many of its files changed.
+    ///
+    /// This means that when a tool writes many files at once (eg, a batch export) every
+    /// dependent asset is invalidated just once. Set to 0 to deliver changes as soon as
+    /// the operating system reports them (they are still batched per report).
+    void    SetFileSystemMonitorDebounce(unsigned milliseconds);
+
+    /// <summary>Returns an id for the batch of file changes currently being delivered</summary>
+    /// While OnChangeCallback::OnChange() is being executed as part of a batch of
+    /// changes, this returns a non-zero value that is unique to that batch. Otherwise
+    /// (including on any thread other than the one delivering the batch) it returns 0. Callbacks that propagate changes to other objects can use this
+    /// to avoid processing the same batch more than once.
+    unsigned GetFileChangeBatchId();
+
     /// <summary>Shut down all file system monitoring</summary>
     /// Intended to be called on application shutdown, this frees all resources
     /// used by file system monitoring.
@@ -0,0 +1,45 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "FileSystemMonitor.h"
+#include "../Threading/Mutex.h"
+#include "../../Core/Types.h"
+#include <vector>
+#include <memory>
+
+    //  Shared between the platform specific file system monitor implementations
+    //  (not intended to be used by clients)
+
+namespace Utility { namespace Internal
+{
+    /// <summary>Callbacks attached to the files in a single monitored directory</summary>
+    class MonitoredCallbacks
+    {
+    public:
+        static uint64   HashFilename(StringSection<char> filename);
+        void            AttachCallback(uint64 filenameHash, std::shared_ptr<OnChangeCallback> callback);
+
+            //  Queue the callbacks attached to the given file (see QueueFileChanges)
+        void            OnChange(StringSection<char> filename);
+
+        MonitoredCallbacks();
+        ~MonitoredCallbacks();
+    private:
+        std::vector<std::pair<uint64, std::weak_ptr<OnChangeCallback>>>  _callbacks;
+        Threading::Mutex  _callbacksLock;
+    };
+
+        //  Changes are queued by the monitoring thread, and delivered in batches by
+        //  FlushFileChanges(). The monitoring thread should wait for at most
+        //  GetFileChangeFlushTimeout() milliseconds before calling FlushFileChanges(false).
+    void        QueueFileChanges(const std::weak_ptr<OnChangeCallback>* begin, const std::weak_ptr<OnChangeCallback>* end);
+    uint32      GetFileChangeFlushTimeout();
+    void        FlushFileChanges(bool force);
+    void        ClearFileChanges();
+}}
+
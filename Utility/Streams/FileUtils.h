@@ -16,7 +16,11 @@
 #include <vector>
 #include <string>
 
-typedef struct _iobuf FILE;
+#if PLATFORMOS_TARGET == PLATFORMOS_WINDOWS
+    typedef struct _iobuf FILE;
+#else
+    #include <stdio.h>
+#endif
 
 namespace Utility 
 {
@@ -70,11 +74,17 @@ namespace Utility
         size_t      TellP() const never_throws;
         void        Flush() const never_throws;
 
+            //  Read "size" bytes from an absolute offset in the file. On POSIX platforms
+            //  this doesn't use or change the current file position (so it's safe to call 
+            //  from multiple threads at the same time). On Windows the file position is 
+            //  left after the bytes read.
+        size_t      ReadAt(uint64 offset, void* buffer, size_t size) const never_throws;
+
         uint64      GetSize() never_throws;
 
         struct ShareMode
         {
-            enum { Read = 1<<0, Write = 1<<1 };
+            enum { Read = 1<<0, Write = 1<<1, Delete = 1<<2 };
             typedef unsigned BitField;
         };
 
@@ -98,7 +108,20 @@ namespace Utility
     public:
         struct Access
         {
-            enum Enum { Read = 1<<0, Write = 1<<1, OpenAlways = 1<<2 };
+            enum Enum 
+            {
+                Read = 1<<0, Write = 1<<1, OpenAlways = 1<<2,
+
+                    //  Hints for how the mapping will be used
+                Sequential = 1<<3,      // mostly read from front to back (more aggressive read ahead)
+                Random = 1<<4,          // mostly scattered access (no read ahead)
+                Populate = 1<<5,        // read the whole file in during construction
+                HugePages = 1<<6,       // use large pages, where supported (ignored on Windows)
+
+                    //  The mapping is writable, but changes are private to this process
+                    //  and never written back to the file (the file is opened read-only)
+                CopyOnWrite = 1<<7
+            };
             typedef unsigned BitField;
         };
 
@@ -107,6 +130,17 @@ namespace Utility
         bool            IsValid()           { return _mappedData != 0; }
         size_t          GetSize() const;
 
+        enum class AccessPattern { Normal, Sequential, Random };
+
+            //  Change the access pattern hint for part of the mapping (or all
+            //  of it, by default). Ignored on Windows.
+        void            SetAccessPattern(AccessPattern pattern, size_t offset = 0, size_t size = ~size_t(0)) never_throws;
+
+            //  Begin reading the given range from disk asynchronously, so that it's 
+            //  resident before it's accessed. Use this for data that will be needed
+            //  soon, but isn't needed yet (eg, the next terrain cells during streaming)
+        void            Prefetch(size_t offset, size_t size) const never_throws;
+
         MemoryMappedFile(
             const char filename[], uint64 size, 
             Access::BitField access,
@@ -120,6 +154,7 @@ namespace Utility
         void* _mapping;
         void* _fileHandle;
         void* _mappedData;
+        size_t _mappedSize;
     };
 
     XL_UTILITY_API bool DoesFileExist(const char filename[]);
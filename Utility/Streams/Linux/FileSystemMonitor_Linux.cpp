@@ -0,0 +1,234 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../../../Core/Prefix.h"
+#include "../../../Core/SelectConfiguration.h"
+
+#if PLATFORMOS_TARGET == PLATFORMOS_LINUX
+
+#include "../FileSystemMonitorInternal.h"
+#include "../../../Core/Types.h"
+#include "../../Threading/Mutex.h"
+#include "../../Threading/LockFree.h"
+#include "../../IteratorUtils.h"
+#include "../../StringUtils.h"
+#include "../../../ConsoleRig/Log.h"
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+namespace Utility
+{
+        //  We create one inotify watch per directory, regardless of how many files
+        //  in that directory have callbacks attached. Events for files without
+        //  callbacks are just ignored.
+    class MonitoredDirectory
+    {
+    public:
+        Internal::MonitoredCallbacks    _callbacks;
+        std::string                     _directoryName;
+        int                             _watchDescriptor;
+
+        MonitoredDirectory(const std::string& directoryName)
+        : _directoryName(directoryName), _watchDescriptor(-1) {}
+    };
+
+    static Utility::Threading::Mutex MonitoredDirectoriesLock;
+    static std::vector<std::pair<uint64, std::unique_ptr<MonitoredDirectory>>>  MonitoredDirectories;
+
+        //  Sorted by watch descriptor. The same descriptor can appear more than once, if
+        //  the same directory was attached using differently formatted names
+    static std::vector<std::pair<int, MonitoredDirectory*>> WatchDescriptors;
+
+    static int                                  InotifyFD = -1;
+    static int                                  WakeFD = -1;
+    static std::unique_ptr<std::thread>         MonitoringThread;
+    static Utility::Threading::Mutex            MonitoringThreadLock;
+    static volatile bool                        MonitoringQuit = false;
+
+        //  Most editors just write to the file in place. But some write a temporary
+        //  file and rename it over the original (for error safety). To catch those
+        //  cases, we need to look for moves and creation/deletion, as well
+    static const uint32 WatchMask =
+        IN_CLOSE_WRITE | IN_MODIFY
+        | IN_MOVED_TO | IN_MOVED_FROM
+        | IN_CREATE | IN_DELETE;
+
+    static void ProcessEvents(const uint8* begin, const uint8* end)
+    {
+        ScopedLock(MonitoredDirectoriesLock);
+        for (auto* i=begin; i<end;) {
+            const auto* evnt = (const inotify_event*)i;
+            i += sizeof(inotify_event) + evnt->len;
+
+            if (evnt->mask & IN_Q_OVERFLOW) {
+                LogWarning << "File system monitor event queue overflowed. Some file changes may have been missed.";
+                continue;
+            }
+
+            auto range = std::equal_range(
+                WatchDescriptors.begin(), WatchDescriptors.end(),
+                evnt->wd, CompareFirst<int, MonitoredDirectory*>());
+
+            if (evnt->mask & IN_IGNORED) {
+                    // the directory was deleted (or the file system unmounted), so the watch is gone
+                for (auto w=range.first; w!=range.second; ++w)
+                    w->second->_watchDescriptor = -1;
+                WatchDescriptors.erase(range.first, range.second);
+                continue;
+            }
+
+            if (!evnt->len) continue;   // (event on the directory itself)
+
+            StringSection<char> filename(evnt->name, &evnt->name[XlStringLen(evnt->name)]);
+            for (auto w=range.first; w!=range.second; ++w)
+                w->second->_callbacks.OnChange(filename);
+        }
+    }
+
+    static void MonitoringEntryPoint()
+    {
+            //  (inotify_event structures must be correctly aligned in this buffer)
+        std::vector<uint64> buffer(16*1024/sizeof(uint64));
+        auto* bufferStart = (uint8*)AsPointer(buffer.begin());
+        auto bufferSize = buffer.size() * sizeof(uint64);
+
+        while (!MonitoringQuit) {
+                //  Wait until there are new events, or until the queued changes
+                //  should be delivered
+            auto timeout = Internal::GetFileChangeFlushTimeout();
+            pollfd fds[2];
+            fds[0].fd = InotifyFD; fds[0].events = POLLIN; fds[0].revents = 0;
+            fds[1].fd = WakeFD; fds[1].events = POLLIN; fds[1].revents = 0;
+            auto pollResult = poll(fds, dimof(fds), (timeout == XL_INFINITE) ? -1 : int(timeout));
+            if (pollResult < 0 && errno != EINTR) {
+                LogWarning << "Polling for file system changes failed. Stopping file system monitoring.";
+                break;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                uint64 counter;
+                (void)read(WakeFD, &counter, sizeof(counter));
+            }
+
+            if (fds[0].revents & POLLIN) {
+                for (;;) {
+                    auto bytesRead = read(InotifyFD, bufferStart, bufferSize);
+                    if (bytesRead <= 0) break;  // (EAGAIN once we've read everything)
+                    ProcessEvents(bufferStart, PtrAdd(bufferStart, bytesRead));
+                }
+            }
+
+            Internal::FlushFileChanges(false);
+        }
+    }
+
+    static bool StartMonitoring()
+    {
+        ScopedLock(MonitoringThreadLock);
+        if (!MonitoringThread) {
+            InotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            WakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (InotifyFD < 0 || WakeFD < 0) {
+                LogWarning << "Could not initialise inotify. File system monitoring is disabled.";
+                if (InotifyFD >= 0) close(InotifyFD);
+                if (WakeFD >= 0) close(WakeFD);
+                InotifyFD = WakeFD = -1;
+                return false;
+            }
+
+            MonitoringQuit = false;
+            MonitoringThread = std::make_unique<std::thread>(MonitoringEntryPoint);
+        }
+        return true;
+    }
+
+    void TerminateFileSystemMonitoring()
+    {
+        {
+            ScopedLock(MonitoringThreadLock);
+            if (MonitoringThread) {
+                MonitoringQuit = true;
+                uint64 counter = 1;
+                (void)write(WakeFD, &counter, sizeof(counter));
+                MonitoringThread->join();
+                MonitoringThread.reset();
+
+                close(InotifyFD);   // (also removes all watches)
+                close(WakeFD);
+                InotifyFD = WakeFD = -1;
+            }
+        }
+        {
+            ScopedLock(MonitoredDirectoriesLock);
+            WatchDescriptors.clear();
+            MonitoredDirectories.clear();
+        }
+        Internal::ClearFileChanges();
+    }
+
+    void AttachFileSystemMonitor(
+        StringSection<char> directoryName,
+        StringSection<char> filename,
+        std::shared_ptr<OnChangeCallback> callback)
+    {
+        if (!StartMonitoring()) return;
+
+        ScopedLock(MonitoredDirectoriesLock);
+        if (directoryName.Empty())
+            directoryName = StringSection<char>("./");
+
+        auto hash = Internal::MonitoredCallbacks::HashFilename(directoryName);
+        auto i = std::lower_bound(
+            MonitoredDirectories.begin(), MonitoredDirectories.end(),
+            hash, CompareFirst<uint64, std::unique_ptr<MonitoredDirectory>>());
+        if (i == MonitoredDirectories.end() || i->first != hash) {
+            i = MonitoredDirectories.insert(
+                i, std::make_pair(hash, std::make_unique<MonitoredDirectory>(directoryName.AsString())));
+
+                //  inotify_add_watch returns the existing descriptor if this directory is
+                //  already being watched (eg, under a different name)
+            auto* dir = i->second.get();
+            dir->_watchDescriptor = inotify_add_watch(InotifyFD, dir->_directoryName.c_str(), WatchMask);
+            if (dir->_watchDescriptor >= 0) {
+                WatchDescriptors.insert(
+                    std::upper_bound(
+                        WatchDescriptors.begin(), WatchDescriptors.end(), dir->_watchDescriptor,
+                        [](int lhs, const std::pair<int, MonitoredDirectory*>& rhs) { return lhs < rhs.first; }),
+                    std::make_pair(dir->_watchDescriptor, dir));
+            } else {
+                LogWarning << "Could not monitor directory (" << dir->_directoryName << ") for changes (errno: " << errno << ")";
+            }
+        }
+
+        i->second->_callbacks.AttachCallback(Internal::MonitoredCallbacks::HashFilename(filename), std::move(callback));
+    }
+
+    void    FakeFileChange(StringSection<char> directoryName, StringSection<char> filename)
+    {
+        {
+            ScopedLock(MonitoredDirectoriesLock);
+            auto hash = Internal::MonitoredCallbacks::HashFilename(directoryName);
+            auto i = std::lower_bound(
+                MonitoredDirectories.cbegin(), MonitoredDirectories.cend(),
+                hash, CompareFirst<uint64, std::unique_ptr<MonitoredDirectory>>());
+            if (i != MonitoredDirectories.cend() && i->first == hash) {
+                i->second->_callbacks.OnChange(filename);
+            }
+        }
+        Internal::FlushFileChanges(true);
+    }
+}
+
+#endif
+
@@ -0,0 +1,601 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "../../../Core/Prefix.h"
+#include "../../../Core/SelectConfiguration.h"
+
+#if PLATFORMOS_TARGET == PLATFORMOS_LINUX
+
+#include "../FileUtils.h"
+#include "../PathUtils.h"
+#include "../../StringUtils.h"
+#include "../../PtrUtils.h"
+#include "../../MemoryUtils.h"
+#include "../../Threading/Mutex.h"
+#include <assert.h>
+#include <utility>
+#include <algorithm>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <glob.h>
+#include <errno.h>
+#include <string.h>
+
+namespace Utility
+{
+        //  File descriptors are stored in the "void*" handles in the header, so
+        //  that the header is the same for all platforms. -1 is used for "invalid"
+        //  (matching INVALID_HANDLE_VALUE on Windows)
+    static int AsFD(void* handle)       { return int(intptr_t(handle)); }
+    static void* AsHandle(int fd)       { return (void*)intptr_t(fd); }
+    static void* const InvalidHandle = (void*)intptr_t(-1);
+
+    static Exceptions::IOException::Reason AsExceptionReason(int errorCode)
+    {
+        switch (errorCode) {
+        case ENOENT:
+        case ENOTDIR:
+            return Exceptions::IOException::Reason::FileNotFound;
+
+        case EACCES:
+        case EPERM:
+            return Exceptions::IOException::Reason::AccessDenied;
+
+        case EROFS:
+            return Exceptions::IOException::Reason::WriteProtect;
+
+        default:
+            return Exceptions::IOException::Reason::Complex;
+        }
+    }
+
+    namespace Internal
+    {
+        struct UnderlyingOpenMode
+        {
+            int _flags;
+            int _advice;
+        };
+    }
+
+    static Internal::UnderlyingOpenMode AsUnderlyingOpenMode(const char openMode[])
+    {
+        Internal::UnderlyingOpenMode result = { O_CLOEXEC, POSIX_FADV_NORMAL };
+
+        auto* i = openMode;
+        while (*i != '\0') {
+            switch (*i) {
+            case 'w':
+                if (*(i+1) == '+') {
+                    ++i;
+                    result._flags |= O_RDWR | O_CREAT | O_TRUNC;
+                } else {
+                    result._flags |= O_WRONLY | O_CREAT | O_TRUNC;
+                }
+                break;
+
+            case 'r':
+                if (*(i+1) == '+') {
+                    ++i;
+                    result._flags |= O_RDWR;
+                } else {
+                    result._flags |= O_RDONLY;
+                }
+                break;
+
+            case 'b': break;    // binary mode -- actually the only supported mode
+
+            case 'T':
+            case 'D': break;    // (temporary file hints have no equivalent)
+            case 'R': result._advice = POSIX_FADV_RANDOM; break;
+            case 'S': result._advice = POSIX_FADV_SEQUENTIAL; break;
+
+            case 'a':
+                Throw(Exceptions::IOException(Exceptions::IOException::Reason::Complex, "Append file mode not supported"));
+
+            case 't':
+                Throw(Exceptions::IOException(Exceptions::IOException::Reason::Complex, "Text oriented file modes not supported"));
+
+            case 'c':
+                if (XlBeginsWith(MakeStringSection(i), MakeStringSection("ccs=")))
+                    Throw(Exceptions::IOException(Exceptions::IOException::Reason::Complex, "Encoded text file modes supported"));
+                // else, fall through...
+
+            default:
+                Throw(Exceptions::IOException(Exceptions::IOException::Reason::Complex, "Unknown characters found in open mode string (%s)", openMode));
+            }
+            ++i;
+        }
+
+        return result;
+    }
+
+        //  Files that are currently mapped by a MemoryMappedFile in this process,
+        //  as (device, inode) pairs. A file mapped more than once appears once
+        //  for each mapping.
+    static Threading::Mutex                             MappedFilesLock;
+    static std::vector<std::pair<uint64, uint64>>       MappedFiles;
+
+    static std::pair<uint64, uint64> AsFileId(const struct stat& s) { return std::make_pair(uint64(s.st_dev), uint64(s.st_ino)); }
+
+    static void RegisterMappedFile(const struct stat& s)
+    {
+        ScopedLock(MappedFilesLock);
+        MappedFiles.push_back(AsFileId(s));
+    }
+
+    static void DeregisterMappedFile(int fd)
+    {
+        struct stat s;
+        if (fstat(fd, &s) != 0) return;
+        ScopedLock(MappedFilesLock);
+        auto i = std::find(MappedFiles.begin(), MappedFiles.end(), AsFileId(s));
+        if (i != MappedFiles.end())
+            MappedFiles.erase(i);
+    }
+
+    static void UnlinkBeforeTruncate(const char filename[], int flags)
+    {
+            //  Truncating a file that is mapped (eg, a chunk file loaded with mapped
+            //  loading) would either SIGBUS the reader or change the data underneath
+            //  it. So, if the file is currently mapped, we unlink it and create a new
+            //  inode instead; the existing mappings keep the old contents until they
+            //  are closed. Files that aren't mapped are truncated as normal (so hard
+            //  links and file permissions are preserved).
+            //  Only mappings made by this process are known here.
+            //  (symlinks are left alone, so we still write through them)
+        if (!(flags & O_TRUNC)) return;
+        struct stat s;
+        if (lstat(filename, &s) != 0 || !S_ISREG(s.st_mode)) return;
+
+        bool isMapped;
+        {
+            ScopedLock(MappedFilesLock);
+            isMapped = std::find(MappedFiles.begin(), MappedFiles.end(), AsFileId(s)) != MappedFiles.end();
+        }
+        if (isMapped)
+            unlink(filename);
+    }
+
+    static int OpenFile(const char filename[], const char openMode[])
+    {
+            //  (POSIX only has advisory locks, so the share mode is ignored)
+        auto underlyingOpenMode = AsUnderlyingOpenMode(openMode);
+        UnlinkBeforeTruncate(filename, underlyingOpenMode._flags);
+        auto fd = open(filename, underlyingOpenMode._flags, 0666);
+        if (fd >= 0 && underlyingOpenMode._advice != POSIX_FADV_NORMAL)
+            posix_fadvise(fd, 0, 0, underlyingOpenMode._advice);
+        return fd;
+    }
+
+    BasicFile::BasicFile(   const char filename[], const char openMode[],
+                            ShareMode::BitField shareMode)
+    {
+        assert(filename && filename[0]);
+        assert(openMode);
+        (void)shareMode;
+
+        auto fd = OpenFile(filename, openMode);
+        if (fd < 0) {
+            auto errorCode = errno;
+            Throw(Exceptions::IOException(
+                AsExceptionReason(errorCode),
+                "Failure during file open. Probably missing file or bad privileges: (%s), openMode: (%s), error string: (%s)",
+                filename, openMode, strerror(errorCode)));
+        }
+
+        _file = AsHandle(fd);
+    }
+
+    auto BasicFile::TryOpen(const char filename[], const char openMode[], ShareMode::BitField shareMode) never_throws -> Exceptions::IOException::Reason
+    {
+        assert(_file == InvalidHandle);
+        assert(filename && filename[0]);
+        assert(openMode);
+        (void)shareMode;
+
+        auto fd = OpenFile(filename, openMode);
+        if (fd >= 0) {
+            _file = AsHandle(fd);
+            return Exceptions::IOException::Reason::Success;
+        }
+
+        return AsExceptionReason(errno);
+    }
+
+    BasicFile::BasicFile(BasicFile&& moveFrom) never_throws
+    {
+        _file = moveFrom._file;
+        moveFrom._file = InvalidHandle;
+    }
+
+    BasicFile& BasicFile::operator=(BasicFile&& moveFrom) never_throws
+    {
+        if (_file != InvalidHandle) {
+            close(AsFD(_file));
+        }
+        _file = moveFrom._file;
+        moveFrom._file = InvalidHandle;
+        return *this;
+    }
+
+    BasicFile::BasicFile(const BasicFile& copyFrom) never_throws
+    {
+        _file = InvalidHandle;
+        if (copyFrom._file == InvalidHandle) return;
+
+            // (note that the duplicate shares the file position with the original, like DuplicateHandle)
+        auto fd = fcntl(AsFD(copyFrom._file), F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            auto errorCode = errno;
+            Throw(Exceptions::IOException(
+                AsExceptionReason(errorCode),
+                "Failure while attempting to duplicate file handle. Error string: (%s)", strerror(errorCode)));
+        }
+        _file = AsHandle(fd);
+    }
+
+    BasicFile& BasicFile::operator=(const BasicFile& copyFrom) never_throws
+    {
+        if (_file != InvalidHandle)
+            close(AsFD(_file));
+        _file = InvalidHandle;
+        if (copyFrom._file == InvalidHandle) return *this;
+
+        auto fd = fcntl(AsFD(copyFrom._file), F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            auto errorCode = errno;
+            Throw(Exceptions::IOException(
+                AsExceptionReason(errorCode),
+                "Failure while attempting to duplicate file handle. Error string: (%s)", strerror(errorCode)));
+        }
+        _file = AsHandle(fd);
+        return *this;
+    }
+
+    BasicFile::BasicFile()
+    {
+        _file = InvalidHandle;
+    }
+
+    BasicFile::~BasicFile()
+    {
+        if (_file != InvalidHandle) {
+            close(AsFD(_file));
+        }
+    }
+
+    size_t   BasicFile::Read(void *buffer, size_t size, size_t count) const never_throws
+    {
+        if (!(size * count)) return 0;
+            //  read() can return less than requested (eg, if interrupted by a signal),
+            //  so we must loop until we reach the end of the file
+        size_t bytesRead = 0, bytesRequested = size * count;
+        while (bytesRead < bytesRequested) {
+            auto r = read(AsFD(_file), PtrAdd(buffer, bytesRead), bytesRequested - bytesRead);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) break;
+            bytesRead += size_t(r);
+        }
+        return bytesRead/size;
+    }
+
+    size_t   BasicFile::Write(const void *buffer, size_t size, size_t count) never_throws
+    {
+        if (!(size * count)) return 0;
+        size_t bytesWritten = 0, bytesRequested = size * count;
+        while (bytesWritten < bytesRequested) {
+            auto r = write(AsFD(_file), PtrAdd(buffer, bytesWritten), bytesRequested - bytesWritten);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) break;
+            bytesWritten += size_t(r);
+        }
+        return bytesWritten/size;
+    }
+
+    size_t   BasicFile::Seek(size_t offset, int origin) never_throws
+    {
+        assert(origin == SEEK_SET || origin == SEEK_CUR || origin == SEEK_END);
+        return size_t(lseek(AsFD(_file), off_t(offset), origin));
+    }
+
+    size_t   BasicFile::TellP() const never_throws
+    {
+        return size_t(lseek(AsFD(_file), 0, SEEK_CUR));
+    }
+
+    void    BasicFile::Flush() const never_throws
+    {
+        fsync(AsFD(_file));
+    }
+
+    size_t  BasicFile::ReadAt(uint64 offset, void* buffer, size_t size) const never_throws
+    {
+        size_t bytesRead = 0;
+        while (bytesRead < size) {
+            auto r = pread(AsFD(_file), PtrAdd(buffer, bytesRead), size - bytesRead, off_t(offset + bytesRead));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) break;
+            bytesRead += size_t(r);
+        }
+        return bytesRead;
+    }
+
+    uint64      BasicFile::GetSize() never_throws
+    {
+        if (_file == InvalidHandle) return 0;
+        struct stat s;
+        if (fstat(AsFD(_file), &s) != 0) return 0;
+        return uint64(s.st_size);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+    bool DoesFileExist(const char filename[])
+    {
+        struct stat s;
+        return stat(filename, &s) == 0 && !S_ISDIR(s.st_mode);
+    }
+
+    bool DoesDirectoryExist(const char filename[])
+    {
+        struct stat s;
+        return stat(filename, &s) == 0 && S_ISDIR(s.st_mode);
+    }
+
+    void CreateDirectoryRecursive(const StringSection<char> filename)
+    {
+                // note that because our input string may not have a null
+                // terminator at the very end, we have to copy at least
+                // once... So might as well copy and then we can safely
+                // modify the copy as we go through
+        char buffer[MaxPath];
+        XlCopyString(buffer, filename);
+
+        SplitPath<char> split(buffer);
+        for (const auto& section:split.GetSections()) {
+            char q = 0;
+            std::swap(q, *const_cast<char*>(section.end()));
+            mkdir(buffer, 0777);
+            std::swap(q, *const_cast<char*>(section.end()));
+        }
+    }
+
+    uint64 GetFileModificationTime(const char filename[])
+    {
+            //  (nanoseconds since the epoch. Only useful for comparing against other
+            //  values returned from this function)
+        struct stat s;
+        if (stat(filename, &s) != 0) return 0ull;
+        return uint64(s.st_mtim.tv_sec) * 1000000000ull + uint64(s.st_mtim.tv_nsec);
+    }
+
+    uint64 GetFileSize(const char filename[])
+    {
+        struct stat s;
+        if (stat(filename, &s) != 0) return 0ull;
+        return uint64(s.st_size);
+    }
+
+    std::vector<std::string> FindFiles(const std::string& searchPath, FindFilesFilter::BitField filter)
+    {
+        std::vector<std::string> result;
+
+        glob_t globResult;
+        XlZeroMemory(globResult);
+        if (glob(searchPath.c_str(), 0, nullptr, &globResult) == 0) {
+            for (size_t c=0; c<globResult.gl_pathc; ++c) {
+                struct stat s;
+                if (stat(globResult.gl_pathv[c], &s) != 0) continue;
+                bool isDir = S_ISDIR(s.st_mode);
+                if (filter & (1<<unsigned(isDir))) {
+                    result.push_back(globResult.gl_pathv[c]);
+                }
+            }
+        }
+        globfree(&globResult);
+
+        return std::move(result);
+    }
+
+    static std::vector<std::string> FindAllDirectories(const std::string& rootDirectory)
+    {
+        std::string basePath = rootDirectory;
+        if (!basePath.empty() && basePath[basePath.size()-1]!='/') {
+            basePath += "/";
+        }
+        std::vector<std::string> result;
+        result.push_back(basePath);
+
+        auto* dir = opendir(basePath.c_str());
+        if (dir) {
+            while (auto* entry = readdir(dir)) {
+                if (entry->d_name[0] == '.') continue;
+
+                bool isDir = entry->d_type == DT_DIR;
+                if (entry->d_type == DT_UNKNOWN) {
+                    struct stat s;
+                    isDir = stat((basePath + entry->d_name).c_str(), &s) == 0 && S_ISDIR(s.st_mode);
+                }
+
+                if (isDir) {
+                    auto sub = FindAllDirectories(basePath + entry->d_name);
+                    result.insert(result.end(), sub.begin(), sub.end());
+                }
+            }
+            closedir(dir);
+        }
+
+        return std::move(result);
+    }
+
+    std::vector<std::string> FindFilesHierarchical(const std::string& rootDirectory, const std::string& filePattern, FindFilesFilter::BitField filter)
+    {
+        auto dirs = FindAllDirectories(rootDirectory);
+
+        std::vector<std::string> result;
+        for(const auto&d:dirs) {
+            auto files = FindFiles(d + filePattern, filter);
+            result.insert(result.end(), files.begin(), files.end());
+        }
+
+        return std::move(result);
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static size_t GetPageSize()
+    {
+        static size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+        return pageSize;
+    }
+
+    static void Advise(void* mappedData, size_t mappedSize, size_t offset, size_t size, int advice)
+    {
+            //  madvise requires a page aligned start address
+        if (!mappedData || offset >= mappedSize) return;
+        size = std::min(size, mappedSize - offset);
+        auto alignedOffset = offset & ~(GetPageSize()-1);
+        madvise(PtrAdd(mappedData, alignedOffset), size + (offset - alignedOffset), advice);
+    }
+
+    MemoryMappedFile::MemoryMappedFile(
+        const char filename[], uint64 size, Access::BitField access,
+        BasicFile::ShareMode::BitField shareMode)
+    {
+        _mapping = nullptr;
+        _fileHandle = InvalidHandle;
+        _mappedData = nullptr;
+        _mappedSize = 0;
+        (void)shareMode;
+
+        int openFlags = O_CLOEXEC | ((access & Access::Write) ? O_RDWR : O_RDONLY);
+        if (access & Access::Write && (!(access & Access::Read))) {
+            openFlags |= O_CREAT | O_TRUNC;
+        } else if (access & Access::OpenAlways) {
+            openFlags |= O_CREAT;
+        }
+
+        UnlinkBeforeTruncate(filename, openFlags);
+        auto fd = open(filename, openFlags, 0666);
+        if (fd < 0) return;
+
+            //  As with CreateFileMapping, a size of 0 means "the current size of the
+            //  file", and a larger size will grow a writable file
+        struct stat s;
+        if (fstat(fd, &s) != 0) { close(fd); return; }
+        uint64 mappedSize = size ? size : uint64(s.st_size);
+        if (mappedSize > uint64(s.st_size)) {
+            if (!(access & Access::Write) || ftruncate(fd, off_t(mappedSize)) != 0) {
+                close(fd);
+                return;
+            }
+        }
+        if (!mappedSize) { close(fd); return; }
+
+        int prot = PROT_READ | ((access & (Access::Write|Access::CopyOnWrite)) ? PROT_WRITE : 0);
+        int flags = (access & Access::CopyOnWrite) ? MAP_PRIVATE : MAP_SHARED;
+        #if defined(MAP_POPULATE)
+            if (access & Access::Populate) flags |= MAP_POPULATE;
+        #endif
+
+        auto* mappingStart = mmap(nullptr, size_t(mappedSize), prot, flags, fd, 0);
+        if (mappingStart == MAP_FAILED) {
+            close(fd);
+            return;
+        }
+
+        _mappedData = mappingStart;
+        _fileHandle = AsHandle(fd);
+        _mappedSize = size_t(mappedSize);
+        RegisterMappedFile(s);
+
+        if (access & Access::Sequential) SetAccessPattern(AccessPattern::Sequential);
+        else if (access & Access::Random) SetAccessPattern(AccessPattern::Random);
+
+            //  Transparent huge pages for file mappings depend on the kernel configuration
+            //  and file system. If they're not supported, this just fails silently
+        #if defined(MADV_HUGEPAGE)
+            if (access & Access::HugePages)
+                madvise(_mappedData, _mappedSize, MADV_HUGEPAGE);
+        #endif
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        if (_mappedData != nullptr) {
+            munmap(_mappedData, _mappedSize);
+            DeregisterMappedFile(AsFD(_fileHandle));
+        }
+        if (_fileHandle != InvalidHandle)
+            close(AsFD(_fileHandle));
+    }
+
+    MemoryMappedFile::MemoryMappedFile()
+    {
+        _mapping = nullptr;
+        _fileHandle = InvalidHandle;
+        _mappedData = nullptr;
+        _mappedSize = 0;
+    }
+
+    MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& moveFrom) never_throws
+    {
+        _mapping = moveFrom._mapping;
+        _fileHandle = moveFrom._fileHandle;
+        _mappedData = moveFrom._mappedData;
+        _mappedSize = moveFrom._mappedSize;
+        moveFrom._mapping = nullptr;
+        moveFrom._fileHandle = InvalidHandle;
+        moveFrom._mappedData = nullptr;
+        moveFrom._mappedSize = 0;
+    }
+
+    MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& moveFrom) never_throws
+    {
+        if (_mappedData != nullptr) {
+            munmap(_mappedData, _mappedSize);
+            DeregisterMappedFile(AsFD(_fileHandle));
+        }
+        if (_fileHandle != InvalidHandle)
+            close(AsFD(_fileHandle));
+
+        _mapping = moveFrom._mapping;
+        _fileHandle = moveFrom._fileHandle;
+        _mappedData = moveFrom._mappedData;
+        _mappedSize = moveFrom._mappedSize;
+        moveFrom._mapping = nullptr;
+        moveFrom._fileHandle = InvalidHandle;
+        moveFrom._mappedData = nullptr;
+        moveFrom._mappedSize = 0;
+        return *this;
+    }
+
+    size_t MemoryMappedFile::GetSize() const
+    {
+        return _mappedSize;
+    }
+
+    void MemoryMappedFile::SetAccessPattern(AccessPattern pattern, size_t offset, size_t size) never_throws
+    {
+        int advice = MADV_NORMAL;
+        if (pattern == AccessPattern::Sequential) advice = MADV_SEQUENTIAL;
+        else if (pattern == AccessPattern::Random) advice = MADV_RANDOM;
+        Advise(_mappedData, _mappedSize, offset, size, advice);
+    }
+
+    void MemoryMappedFile::Prefetch(size_t offset, size_t size) const never_throws
+    {
+        Advise(_mappedData, _mappedSize, offset, size, MADV_WILLNEED);
+    }
+}
+
+#endif
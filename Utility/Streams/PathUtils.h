@@ -35,11 +35,13 @@ namespace Utility
 
     XL_UTILITY_API void XlConcatPath(char* dst, int count, const char* a, const char* b, const char* bEnd);
     XL_UTILITY_API void XlConcatPath(ucs2* dst, int count, const ucs2* a, const ucs2* b, const ucs2* bEnd);
+    inline void XlConcatPath(utf8* dst, int count, const utf8* a, const utf8* b, const utf8* bEnd)    { XlConcatPath((char*)dst, count, (const char*)a, (const char*)b, (const char*)bEnd); }
 
     XL_UTILITY_API template<typename CharType> const CharType* XlExtension(const CharType* path);
     XL_UTILITY_API void XlChopExtension(char* path);
     XL_UTILITY_API void XlDirname(char* dst, int count, const char* path);
     XL_UTILITY_API void XlDirname(ucs2* dst, int count, const ucs2* path);
+    inline void XlDirname(utf8* dst, int count, const utf8* path)    { XlDirname((char*)dst, count, (const char*)path); }
     XL_UTILITY_API void XlBasename(char* dst, int count, const char* path);
     XL_UTILITY_API const char* XlBasename(const char* path);
 
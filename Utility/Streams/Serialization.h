@@ -8,6 +8,7 @@
 
 #include "../../Core/Exceptions.h"
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace Utility
@@ -31,6 +32,9 @@ namespace Utility
         class BlockSerializerAllocator : public std::allocator<Type>
     {
     public:
+        typedef typename std::allocator<Type>::pointer pointer;
+        typedef typename std::allocator<Type>::size_type size_type;
+
         pointer allocate(size_type n, std::allocator<void>::const_pointer ptr= 0)
         {
             if (_fromFixedStorage) {
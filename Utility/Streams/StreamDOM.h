@@ -8,6 +8,8 @@
 
 #include "../PtrUtils.h"    // (for Default)
 #include "../StringUtils.h" // (for StringSection)
+#include "../ParameterBox.h" // (for ImpliedTyping)
+#include "../Conversion.h"
 #include <vector>
 #include <string>
 
@@ -143,7 +145,7 @@ namespace Utility
         template<typename Type>
             Type Document<Formatter>::Attribute(const value_type name[], const Type& def) const
     {
-        auto temp = Attribute(name).As<Type>();
+        auto temp = Attribute(name).template As<Type>();
         if (temp.first) return temp.second;
         return def;
     }
@@ -152,7 +154,7 @@ namespace Utility
         template<typename Type>
             Type DocElementHelper<Formatter>::Attribute(const value_type name[], const Type& def) const
     {
-        auto temp = Attribute(name).As<Type>();
+        auto temp = Attribute(name).template As<Type>();
         if (temp.first) return temp.second;
         return def;
     }
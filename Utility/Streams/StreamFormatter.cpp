@@ -38,6 +38,8 @@ namespace Utility
 
         static const CharType CommentPrefix[];
         static const CharType HeaderPrefix[];
+
+        static const CharType FormattingChars[6];
     };
 
     template<typename CharType, int Count> 
@@ -255,7 +257,7 @@ namespace Utility
         void Eat(MemoryMappedInputStream& stream, CharType (&pattern)[Count], StreamLocation location)
     {
         if (stream.RemainingBytes() < (sizeof(CharType)*Count))
-            Throw(FormatException("Blob prefix clipped", lineIndex, charIndex));
+            Throw(FormatException("Blob prefix clipped", location));
 
         const auto* test = (const CharType*)stream.ReadPointer();
         for (unsigned c=0; c<Count; ++c)
@@ -277,6 +279,9 @@ namespace Utility
             const auto* end = ((const CharType*)stream.End()) - patternLength;
             const auto* ptr = (const CharType*)stream.ReadPointer();
             while (ptr <= end) {
+                ptr = XlFindAnyChar(ptr, end+1, pattern, 1);
+                if (ptr > end) break;
+
                 for (unsigned c=0; c<patternLength; ++c)
                     if (ptr[c] != pattern[c])
                         goto advptr;
@@ -291,19 +296,16 @@ namespace Utility
         } else {
                 // we must read forward until we hit a formatting character
                 // the end of the string will be the last non-whitespace before that formatting character
+                // here, hitting EOF is the same as hitting a formatting char
+            using Consts = FormatterConstants<CharType>;
             const auto* end = ((const CharType*)stream.End());
-            const auto* ptr = (const CharType*)stream.ReadPointer();
+            const auto* start = (const CharType*)stream.ReadPointer();
+            const auto* ptr = XlFindAnyChar(start, end, Consts::FormattingChars, dimof(Consts::FormattingChars));
+            stream.SetPointer(ptr);
+
             const auto* stringEnd = ptr;
-            for (;;) {
-                    // here, hitting EOF is the same as hitting a formatting char
-                if (ptr == end || FormattingChar(*ptr)) {
-                    stream.SetPointer(ptr);
-                    return stringEnd;
-                } else if (!WhitespaceChar(*ptr)) {
-                    stringEnd = ptr+1;
-                }
-                ++ptr;
-            }
+            while (stringEnd > start && WhitespaceChar(*(stringEnd-1))) --stringEnd;
+            return stringEnd;
         }
     }
 
@@ -393,8 +395,7 @@ namespace Utility
                     {
                         const auto* end = ((const CharType*)_stream.End());
                         const auto* ptr = (const CharType*)_stream.ReadPointer();
-                        while (ptr < end && *ptr!='\r' && *ptr!='\n') ++ptr;
-                        _stream.SetPointer(ptr);
+                        _stream.SetPointer(XlFindAnyChar(ptr, end, Consts::EndLine, 2));
                     }
                     break;
                 }
@@ -622,39 +623,44 @@ namespace Utility
     template class InputStreamFormatter<ucs2>;
     template class InputStreamFormatter<char>;
 
-    const utf8 FormatterConstants<utf8>::EndLine[] = { (utf8)'\r', (utf8)'\n' };
-    const ucs2 FormatterConstants<ucs2>::EndLine[] = { (ucs2)'\r', (ucs2)'\n' };
-    const ucs4 FormatterConstants<ucs4>::EndLine[] = { (ucs4)'\r', (ucs4)'\n' };
-    const char FormatterConstants<char>::EndLine[] = { (char)'\r', (char)'\n' };
-
-    const utf8 FormatterConstants<utf8>::ProtectedNamePrefix[] = { (utf8)'<', (utf8)':', (utf8)'(' };
-    const ucs2 FormatterConstants<ucs2>::ProtectedNamePrefix[] = { (ucs2)'<', (ucs2)':', (ucs2)'(' };
-    const ucs4 FormatterConstants<ucs4>::ProtectedNamePrefix[] = { (ucs4)'<', (ucs4)':', (ucs4)'(' };
-    const char FormatterConstants<char>::ProtectedNamePrefix[] = { (char)'<', (char)':', (char)'(' };
-
-    const utf8 FormatterConstants<utf8>::ProtectedNamePostfix[] = { (utf8)')', (utf8)':', (utf8)'>' };
-    const ucs2 FormatterConstants<ucs2>::ProtectedNamePostfix[] = { (ucs2)')', (ucs2)':', (ucs2)'>' };
-    const ucs4 FormatterConstants<ucs4>::ProtectedNamePostfix[] = { (ucs4)')', (ucs4)':', (ucs4)'>' };
-    const char FormatterConstants<char>::ProtectedNamePostfix[] = { (char)')', (char)':', (char)'>' };
-
-    const utf8 FormatterConstants<utf8>::CommentPrefix[] = { (utf8)'~', (utf8)'~' };
-    const ucs2 FormatterConstants<ucs2>::CommentPrefix[] = { (ucs2)'~', (ucs2)'~' };
-    const ucs4 FormatterConstants<ucs4>::CommentPrefix[] = { (ucs4)'~', (ucs4)'~' };
-    const char FormatterConstants<char>::CommentPrefix[] = { (char)'~', (char)'~' };
-
-    const utf8 FormatterConstants<utf8>::HeaderPrefix[] = { (utf8)'~', (utf8)'~', (utf8)'!' };
-    const ucs2 FormatterConstants<ucs2>::HeaderPrefix[] = { (ucs2)'~', (ucs2)'~', (ucs2)'!' };
-    const ucs4 FormatterConstants<ucs4>::HeaderPrefix[] = { (ucs4)'~', (ucs4)'~', (ucs4)'!' };
-    const char FormatterConstants<char>::HeaderPrefix[] = { (char)'~', (char)'~', (char)'!' };
-
-    const utf8 FormatterConstants<utf8>::Tab = (utf8)'\t';
-    const ucs2 FormatterConstants<ucs2>::Tab = (ucs2)'\t';
-    const ucs4 FormatterConstants<ucs4>::Tab = (ucs4)'\t';
-    const char FormatterConstants<char>::Tab = (char)'\t';
-
-    const utf8 FormatterConstants<utf8>::ElementPrefix = (utf8)'~';
-    const ucs2 FormatterConstants<ucs2>::ElementPrefix = (ucs2)'~';
-    const ucs4 FormatterConstants<ucs4>::ElementPrefix = (ucs4)'~';
-    const char FormatterConstants<char>::ElementPrefix = (char)'~';
+    template<> const utf8 FormatterConstants<utf8>::EndLine[] = { (utf8)'\r', (utf8)'\n' };
+    template<> const ucs2 FormatterConstants<ucs2>::EndLine[] = { (ucs2)'\r', (ucs2)'\n' };
+    template<> const ucs4 FormatterConstants<ucs4>::EndLine[] = { (ucs4)'\r', (ucs4)'\n' };
+    template<> const char FormatterConstants<char>::EndLine[] = { (char)'\r', (char)'\n' };
+
+    template<> const utf8 FormatterConstants<utf8>::ProtectedNamePrefix[] = { (utf8)'<', (utf8)':', (utf8)'(' };
+    template<> const ucs2 FormatterConstants<ucs2>::ProtectedNamePrefix[] = { (ucs2)'<', (ucs2)':', (ucs2)'(' };
+    template<> const ucs4 FormatterConstants<ucs4>::ProtectedNamePrefix[] = { (ucs4)'<', (ucs4)':', (ucs4)'(' };
+    template<> const char FormatterConstants<char>::ProtectedNamePrefix[] = { (char)'<', (char)':', (char)'(' };
+
+    template<> const utf8 FormatterConstants<utf8>::ProtectedNamePostfix[] = { (utf8)')', (utf8)':', (utf8)'>' };
+    template<> const ucs2 FormatterConstants<ucs2>::ProtectedNamePostfix[] = { (ucs2)')', (ucs2)':', (ucs2)'>' };
+    template<> const ucs4 FormatterConstants<ucs4>::ProtectedNamePostfix[] = { (ucs4)')', (ucs4)':', (ucs4)'>' };
+    template<> const char FormatterConstants<char>::ProtectedNamePostfix[] = { (char)')', (char)':', (char)'>' };
+
+    template<> const utf8 FormatterConstants<utf8>::CommentPrefix[] = { (utf8)'~', (utf8)'~' };
+    template<> const ucs2 FormatterConstants<ucs2>::CommentPrefix[] = { (ucs2)'~', (ucs2)'~' };
+    template<> const ucs4 FormatterConstants<ucs4>::CommentPrefix[] = { (ucs4)'~', (ucs4)'~' };
+    template<> const char FormatterConstants<char>::CommentPrefix[] = { (char)'~', (char)'~' };
+
+    template<> const utf8 FormatterConstants<utf8>::HeaderPrefix[] = { (utf8)'~', (utf8)'~', (utf8)'!' };
+    template<> const ucs2 FormatterConstants<ucs2>::HeaderPrefix[] = { (ucs2)'~', (ucs2)'~', (ucs2)'!' };
+    template<> const ucs4 FormatterConstants<ucs4>::HeaderPrefix[] = { (ucs4)'~', (ucs4)'~', (ucs4)'!' };
+    template<> const char FormatterConstants<char>::HeaderPrefix[] = { (char)'~', (char)'~', (char)'!' };
+
+    template<> const utf8 FormatterConstants<utf8>::FormattingChars[] = { (utf8)'~', (utf8)';', (utf8)'=', (utf8)'\r', (utf8)'\n', (utf8)0 };
+    template<> const ucs2 FormatterConstants<ucs2>::FormattingChars[] = { (ucs2)'~', (ucs2)';', (ucs2)'=', (ucs2)'\r', (ucs2)'\n', (ucs2)0 };
+    template<> const ucs4 FormatterConstants<ucs4>::FormattingChars[] = { (ucs4)'~', (ucs4)';', (ucs4)'=', (ucs4)'\r', (ucs4)'\n', (ucs4)0 };
+    template<> const char FormatterConstants<char>::FormattingChars[] = { (char)'~', (char)';', (char)'=', (char)'\r', (char)'\n', (char)0 };
+
+    template<> const utf8 FormatterConstants<utf8>::Tab = (utf8)'\t';
+    template<> const ucs2 FormatterConstants<ucs2>::Tab = (ucs2)'\t';
+    template<> const ucs4 FormatterConstants<ucs4>::Tab = (ucs4)'\t';
+    template<> const char FormatterConstants<char>::Tab = (char)'\t';
+
+    template<> const utf8 FormatterConstants<utf8>::ElementPrefix = (utf8)'~';
+    template<> const ucs2 FormatterConstants<ucs2>::ElementPrefix = (ucs2)'~';
+    template<> const ucs4 FormatterConstants<ucs4>::ElementPrefix = (ucs4)'~';
+    template<> const char FormatterConstants<char>::ElementPrefix = (char)'~';
 }
 
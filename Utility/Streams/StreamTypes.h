@@ -9,6 +9,7 @@
 #include "../../Core/Types.h"
 #include "Stream.h"
 #include <streambuf>
+#include <type_traits>
 
 namespace Utility
 {
@@ -52,12 +53,9 @@ namespace Utility
     private:
         template <typename C> static unsigned StrTest(decltype(&C::str)*);
         template <typename C> static char StrTest(...);
-        template <typename C> static unsigned IsFullTest(decltype(&C::str)*);
+        template <typename C> static unsigned IsFullTest(decltype(&C::IsFull)*);
         template <typename C> static char IsFullTest(...);
 
-        template<typename U, void (U::*)(typename U::char_type*, size_t) const> struct FunctionSignature {};
-        template <typename C> static unsigned ConstructorTest(FunctionSignature<C, &C::C>*);
-        template <typename C> static char ConstructorTest(...);
     public:
 
             //  If the "BufferType" type has a method called str(), then we
@@ -84,7 +82,7 @@ namespace Utility
 
         template<
             typename Buffer = BufferType,
-            typename std::enable_if<(sizeof(ConstructorTest<Buffer>(0)) > 1)>::type* = nullptr>
+            typename std::enable_if<std::is_constructible<Buffer, typename Buffer::char_type*, size_t>::value>::type* = nullptr>
             StreamBuf(CharType* buffer, size_t bufferCharCount)
             : _buffer(buffer, bufferCharCount) {}
 
@@ -99,8 +97,8 @@ namespace Utility
         {
             typedef typename std::basic_streambuf<CharType>::char_type char_type;
 
-            bool IsFull() const { return pptr() >= epptr(); }
-            unsigned Length() const { return unsigned(pptr() - pbase()); }
+            bool IsFull() const { return this->pptr() >= this->epptr(); }
+            unsigned Length() const { return unsigned(this->pptr() - this->pbase()); }
 
             FixedMemoryBuffer2(CharType buffer[], size_t bufferCharCount) 
             {
@@ -116,8 +114,8 @@ namespace Utility
         {
             typedef typename std::basic_stringbuf<CharType>::char_type char_type;
 
-            CharType* Begin() const { return pbase(); }
-            CharType* End() const   { return pptr(); }
+            CharType* Begin() const { return this->pbase(); }
+            CharType* End() const   { return this->pptr(); }
 
             ResizeableMemoryBuffer() {}
             ~ResizeableMemoryBuffer() {}
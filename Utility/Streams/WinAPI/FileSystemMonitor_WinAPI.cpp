@@ -5,7 +5,7 @@
 // http://www.opensource.org/licenses/mit-license.php)
 
 #include "../../../Core/Prefix.h"
-#include "../FileSystemMonitor.h"
+#include "../FileSystemMonitorInternal.h"
 #include "../../../Core/Types.h"
 #include "../../../Core/WinAPI/IncludeWindows.h"
 #include "../../Threading/Mutex.h"
@@ -26,8 +26,8 @@ namespace Utility
         MonitoredDirectory(const std::string& directoryName);
         ~MonitoredDirectory();
 
-        static uint64   HashFilename(StringSection<char> filename);
-        void            AttachCallback(uint64 filenameHash, std::shared_ptr<OnChangeCallback> callback);
+        static uint64   HashFilename(StringSection<char> filename) { return Internal::MonitoredCallbacks::HashFilename(filename); }
+        void            AttachCallback(uint64 filenameHash, std::shared_ptr<OnChangeCallback> callback) { _callbacks.AttachCallback(filenameHash, std::move(callback)); }
         void            OnTriggered();
 
         void                BeginMonitoring();
@@ -35,10 +35,9 @@ namespace Utility
         const OVERLAPPED*   GetOverlappedPtr() const { return &_overlapped; }
         unsigned            GetCreationOrderId() const { return _monitoringUpdateId; }
 
-        void OnChange(StringSection<char> filename);
+        void OnChange(StringSection<char> filename) { _callbacks.OnChange(filename); }
     private:
-        std::vector<std::pair<uint64, std::weak_ptr<OnChangeCallback>>>  _callbacks;
-        Threading::Mutex  _callbacksLock;
+        Internal::MonitoredCallbacks _callbacks;
         XlHandle        _directoryHandle;
         uint8           _resultBuffer[1024];
         DWORD           _bytesReturned;
@@ -82,28 +81,6 @@ namespace Utility
         CloseHandle(_overlapped.hEvent);
     }
 
-    uint64 MonitoredDirectory::HashFilename(StringSection<char> filename)
-    {
-        char buffer[MaxPath];
-        const char *i = filename._start;
-        const char *iend = filename._end;
-        char* b = buffer;
-        while (i!=iend && b!=ArrayEnd(buffer)) {
-            *b = XlToLower(*i); ++i; ++b;
-        }
-        return Hash64(buffer, b);
-    }
-
-    void MonitoredDirectory::AttachCallback(
-        uint64 filenameHash, 
-        std::shared_ptr<OnChangeCallback> callback)
-    {
-        ScopedLock(_callbacksLock);
-        _callbacks.insert(
-            LowerBound(_callbacks, filenameHash),
-            std::make_pair(filenameHash, std::move(callback)));
-    }
-
     void            MonitoredDirectory::OnTriggered()
     {
         FILE_NOTIFY_INFORMATION* notifyInformation = 
@@ -142,41 +119,6 @@ namespace Utility
         BeginMonitoring();
     }
 
-    void MonitoredDirectory::OnChange(StringSection<char> filename)
-    {
-        auto hash = MonitoredDirectory::HashFilename(filename);
-        ScopedLock(_callbacksLock);
-        #if (STL_ACTIVE == STL_MSVC) && (_ITERATOR_DEBUG_LEVEL >= 2)
-            auto range = std::_Equal_range(
-                _callbacks.begin(), _callbacks.end(), hash, 
-                CompareFirst<uint64, std::weak_ptr<OnChangeCallback>>(),
-                _Dist_type(_callbacks.begin()));
-        #else
-            auto range = std::equal_range(
-                _callbacks.begin(), _callbacks.end(), 
-                hash, CompareFirst<uint64, std::weak_ptr<OnChangeCallback>>());
-        #endif
-
-        bool foundExpired = false;
-        for (auto i2=range.first; i2!=range.second; ++i2) {
-                // todo -- what happens if OnChange() results in a change to _callbacks?
-            auto l = i2->second.lock();
-            if (l) l->OnChange();
-            else foundExpired = true;
-        }
-
-        if (foundExpired) {
-                // Remove any pointers that have expired
-                // (note that we only check matching pointers. Non-matching pointers
-                // that have expired are untouched)
-            _callbacks.erase(
-                std::remove_if(range.first, range.second, 
-                    [](std::pair<uint64, std::weak_ptr<OnChangeCallback>>& i)
-                    { return i.second.expired(); }),
-                range.second);
-        }
-    }
-
     void CALLBACK MonitoredDirectory::CompletionRoutine(
         DWORD dwErrorCode, DWORD dwNumberOfBytesTransfered,
         LPOVERLAPPED lpOverlapped )
@@ -225,9 +167,14 @@ namespace Utility
                 CreationOrderId_Background = newId;
             }
 
+                //  Changes are queued by the completion routines (which execute during this
+                //  wait). We wake up when the debounce window expires, and deliver the
+                //  queued changes as a single batch
             XlWaitForMultipleSyncObjects(
                 1, &RestartMonitoringEvent, 
-                false, XL_INFINITE, true);
+                false, Internal::GetFileChangeFlushTimeout(), true);
+
+            Internal::FlushFileChanges(false);
         }
 
         return 0;
@@ -258,6 +205,7 @@ namespace Utility
             ScopedLock(MonitoredDirectoriesLock);
             MonitoredDirectories.clear();
         }
+        Internal::ClearFileChanges();
     }
 
     void AttachFileSystemMonitor(
@@ -305,18 +253,18 @@ namespace Utility
 
     void    FakeFileChange(StringSection<char> directoryName, StringSection<char> filename)
     {
-        ScopedLock(MonitoredDirectoriesLock);
-        auto hash = MonitoredDirectory::HashFilename(directoryName);
-        auto i = std::lower_bound(
-            MonitoredDirectories.cbegin(), MonitoredDirectories.cend(), 
-            hash, CompareFirst<uint64, std::unique_ptr<MonitoredDirectory>>());
-        if (i != MonitoredDirectories.cend() && i->first == hash) {
-            i->second->OnChange(filename);
+        {
+            ScopedLock(MonitoredDirectoriesLock);
+            auto hash = MonitoredDirectory::HashFilename(directoryName);
+            auto i = std::lower_bound(
+                MonitoredDirectories.cbegin(), MonitoredDirectories.cend(), 
+                hash, CompareFirst<uint64, std::unique_ptr<MonitoredDirectory>>());
+            if (i != MonitoredDirectories.cend() && i->first == hash) {
+                i->second->OnChange(filename);
+            }
         }
+        Internal::FlushFileChanges(true);
     }
-
-
-    OnChangeCallback::~OnChangeCallback() {}
     
 }
 
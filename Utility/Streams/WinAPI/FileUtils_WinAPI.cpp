@@ -7,8 +7,12 @@
 #include "../FileUtils.h"
 #include "../PathUtils.h"
 #include "../../StringUtils.h"
+#include "../../StringFormat.h"
+#include "../../PtrUtils.h"
+#include "../../MemoryUtils.h"
 #include <assert.h>
 #include <utility>
+#include <algorithm>
 
 #include "../../Core/WinAPI/IncludeWindows.h"
 
@@ -19,9 +23,39 @@ namespace Utility
         unsigned underlyingShareMode = 0;
         if (shareMode & BasicFile::ShareMode::Write)   { underlyingShareMode |= FILE_SHARE_WRITE; }
         if (shareMode & BasicFile::ShareMode::Read)    { underlyingShareMode |= FILE_SHARE_READ; }
+        if (shareMode & BasicFile::ShareMode::Delete)  { underlyingShareMode |= FILE_SHARE_DELETE; }
         return underlyingShareMode;
     }
 
+    static HANDLE CreateFileReplacing(
+        const char filename[], unsigned accessMode, unsigned shareMode,
+        unsigned creationDisposition, unsigned flags)
+    {
+        auto handle = CreateFile(filename, accessMode, shareMode, nullptr, creationDisposition, flags, nullptr);
+        if (handle != INVALID_HANDLE_VALUE || creationDisposition != CREATE_ALWAYS)
+            return handle;
+
+            //  If the existing file is still mapped (eg, a chunk file loaded with
+            //  mapped loading), we can't truncate it. But if the mapping allowed
+            //  FILE_SHARE_DELETE, we can move it aside and mark it for deletion. The
+            //  old contents stay valid for the mapping until it is closed, and we
+            //  write the new file under the original name.
+        auto dw = GetLastError();
+        if (dw != ERROR_SHARING_VIOLATION && dw != ERROR_USER_MAPPED_FILE)
+            return handle;
+
+        static LONG s_replaceCounter = 0;
+        StringMeld<MaxPath> asideName;
+        asideName << filename << "." << GetCurrentProcessId() << "." << InterlockedIncrement(&s_replaceCounter) << ".old";
+        if (!MoveFileEx(filename, asideName, MOVEFILE_REPLACE_EXISTING)) {
+            SetLastError(dw);
+            return handle;
+        }
+        DeleteFile(asideName);
+
+        return CreateFile(filename, accessMode, shareMode, nullptr, creationDisposition, flags, nullptr);
+    }
+
     namespace Internal
     {
         struct UnderlyingOpenMode
@@ -115,12 +149,12 @@ namespace Utility
         auto underlyingShareMode = AsUnderlyingShareMode(shareMode);
         auto underlyingOpenMode = AsUnderlyingOpenMode(openMode);
 
-        auto handle = CreateFile(
+        auto handle = CreateFileReplacing(
             filename, 
             underlyingOpenMode._underlyingAccessMode,
             underlyingShareMode,
-            nullptr, underlyingOpenMode._creationDisposition,
-            underlyingOpenMode._underlyingFlags, nullptr);
+            underlyingOpenMode._creationDisposition,
+            underlyingOpenMode._underlyingFlags);
         
         if (handle == INVALID_HANDLE_VALUE) {
                 // use "FormatMessage" to get error code
@@ -170,12 +204,12 @@ namespace Utility
         auto underlyingShareMode = AsUnderlyingShareMode(shareMode);
         auto underlyingOpenMode = AsUnderlyingOpenMode(openMode);
 
-        _file = CreateFile(
+        _file = CreateFileReplacing(
             filename, 
             underlyingOpenMode._underlyingAccessMode,
             underlyingShareMode,
-            nullptr, underlyingOpenMode._creationDisposition,
-            underlyingOpenMode._underlyingFlags, nullptr);
+            underlyingOpenMode._creationDisposition,
+            underlyingOpenMode._underlyingFlags);
 
         if (_file != INVALID_HANDLE_VALUE && _file != nullptr)
             return Exceptions::IOException::Reason::Success;
@@ -323,6 +357,18 @@ namespace Utility
         FlushFileBuffers(_file);
     }
 
+    size_t  BasicFile::ReadAt(uint64 offset, void* buffer, size_t size) const never_throws
+    {
+        if (!size) return 0;
+        OVERLAPPED overlapped;
+        XlZeroMemory(overlapped);
+        overlapped.Offset = DWORD(offset);
+        overlapped.OffsetHigh = DWORD(offset >> 32ull);
+        DWORD bytesRead = 0;
+        auto result = ReadFile(_file, buffer, DWORD(size), &bytesRead, &overlapped);
+        return result?bytesRead:0;
+    }
+
     uint64      BasicFile::GetSize() never_throws
     {
         if (_file == INVALID_HANDLE_VALUE) return 0;
@@ -459,6 +505,7 @@ namespace Utility
         _mapping = INVALID_HANDLE_VALUE;
         _fileHandle = INVALID_HANDLE_VALUE;
         _mappedData = nullptr;
+        _mappedSize = 0;
 
         unsigned underlyingAccess = 0;
         if (access & Access::Read)  underlyingAccess |= GENERIC_READ;
@@ -473,13 +520,19 @@ namespace Utility
             creationDisposition = OPEN_ALWAYS;
         }
 
-        auto fileHandle = CreateFile(
-            filename, underlyingAccess, underlyingShareMode, nullptr, creationDisposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+            //  The cache manager uses these flags to decide how much to read ahead
+        unsigned flags = FILE_ATTRIBUTE_NORMAL;
+        if (access & Access::Sequential) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+        else if (access & Access::Random) flags |= FILE_FLAG_RANDOM_ACCESS;
+
+        auto fileHandle = CreateFileReplacing(
+            filename, underlyingAccess, underlyingShareMode, creationDisposition, flags);
         if (fileHandle == INVALID_HANDLE_VALUE) {
             return;
         }
 
         unsigned pageAccessMode = (access & Access::Write) ? PAGE_READWRITE : PAGE_READONLY;
+        if (access & Access::CopyOnWrite) pageAccessMode = PAGE_WRITECOPY;
         auto mapping = CreateFileMapping(
             fileHandle, nullptr, pageAccessMode, DWORD(size>>32), DWORD(size), nullptr);
         if (!mapping || mapping == INVALID_HANDLE_VALUE) {
@@ -488,6 +541,7 @@ namespace Utility
         }
 
         unsigned mapAccess = (access & Access::Write) ? FILE_MAP_WRITE : FILE_MAP_READ;
+        if (access & Access::CopyOnWrite) mapAccess = FILE_MAP_COPY;
         auto mappingStart = MapViewOfFile(mapping, mapAccess, 0, 0, 0);
         if (!mappingStart) {
             CloseHandle(mapping);
@@ -498,6 +552,12 @@ namespace Utility
         _mappedData = mappingStart;
         _mapping = mapping;
         _fileHandle = fileHandle;
+        _mappedSize = GetSize();
+
+            //  (large pages aren't supported for file mappings on Windows, so
+            //  Access::HugePages is ignored)
+        if (access & Access::Populate)
+            Prefetch(0, _mappedSize);
     }
 
     MemoryMappedFile::~MemoryMappedFile()
@@ -514,6 +574,7 @@ namespace Utility
         _mapping = INVALID_HANDLE_VALUE;
         _fileHandle = INVALID_HANDLE_VALUE;
         _mappedData = nullptr;
+        _mappedSize = 0;
     }
 
     MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& moveFrom) never_throws
@@ -521,9 +582,11 @@ namespace Utility
         _mapping = moveFrom._mapping;
         _fileHandle = moveFrom._fileHandle;
         _mappedData = moveFrom._mappedData;
+        _mappedSize = moveFrom._mappedSize;
         moveFrom._mapping = INVALID_HANDLE_VALUE;
         moveFrom._fileHandle = INVALID_HANDLE_VALUE;
         moveFrom._mappedData = nullptr;
+        moveFrom._mappedSize = 0;
     }
 
     MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& moveFrom) never_throws
@@ -537,9 +600,11 @@ namespace Utility
         _mapping = moveFrom._mapping;
         _fileHandle = moveFrom._fileHandle;
         _mappedData = moveFrom._mappedData;
+        _mappedSize = moveFrom._mappedSize;
         moveFrom._mapping = INVALID_HANDLE_VALUE;
         moveFrom._fileHandle = INVALID_HANDLE_VALUE;
         moveFrom._mappedData = nullptr;
+        moveFrom._mappedSize = 0;
         return *this;
     }
 
@@ -549,5 +614,34 @@ namespace Utility
         GetFileSizeEx(_fileHandle, &fileSize);
         return (size_t)fileSize.QuadPart;
     }
+
+    void MemoryMappedFile::SetAccessPattern(AccessPattern, size_t, size_t) never_throws
+    {
+            //  There's no way to change the read ahead behaviour of a mapped view after
+            //  it's been created on Windows. Use the Access flags in the constructor instead.
+    }
+
+        //  PrefetchVirtualMemory is only available on Windows 8 and above, so we
+        //  must look for it dynamically
+    struct MemoryRangeEntry { PVOID _virtualAddress; SIZE_T _numberOfBytes; };
+    typedef BOOL (WINAPI PrefetchVirtualMemoryFn)(HANDLE, ULONG_PTR, MemoryRangeEntry*, ULONG);
+
+    static PrefetchVirtualMemoryFn* GetPrefetchVirtualMemory()
+    {
+        static PrefetchVirtualMemoryFn* fn = (PrefetchVirtualMemoryFn*)GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+        return fn;
+    }
+
+    void MemoryMappedFile::Prefetch(size_t offset, size_t size) const never_throws
+    {
+        if (!_mappedData || offset >= _mappedSize) return;
+        auto* fn = GetPrefetchVirtualMemory();
+        if (!fn) return;
+
+        MemoryRangeEntry range;
+        range._virtualAddress = PtrAdd(_mappedData, offset);
+        range._numberOfBytes = std::min(size, _mappedSize - offset);
+        (*fn)(GetCurrentProcess(), 1, &range, 0);
+    }
 }
 
@@ -32,6 +32,14 @@ namespace Utility
         ++_ptr;
     }
 
+    template<typename CharType>
+        void TextStreamMarker<CharType>::AdvanceToChar(CharType chr)
+    {
+            // skip forward to the next "chr" (or the end of the stream), with the same
+            // new line tracking as repeated calls to AdvanceCheckNewLine()
+        _ptr = XlFindCharCountLines(_ptr, _end, chr, _lineIndex, _lineStart);
+    }
+
     template<typename CharType>
         TextStreamMarker<CharType>::TextStreamMarker(const MemoryMappedInputStream& stream)
     : _ptr((const CharType*)stream.ReadPointer())
@@ -97,7 +105,7 @@ namespace Utility
     }
 
     template<typename CharType>
-        struct FormatterConstants 
+        struct XmlFormatterConstants 
     {
         static CharType PIStart[2];
         static CharType PIEnd[2];
@@ -109,22 +117,22 @@ namespace Utility
     };
 
     template<typename CharType>
-        CharType FormatterConstants<CharType>::PIStart[] = { CharType('<'), CharType('?') };
+        CharType XmlFormatterConstants<CharType>::PIStart[] = { CharType('<'), CharType('?') };
     template<typename CharType>
-        CharType FormatterConstants<CharType>::PIEnd[] = { CharType('?'), CharType('>') };
+        CharType XmlFormatterConstants<CharType>::PIEnd[] = { CharType('?'), CharType('>') };
 
     template<typename CharType>
-        CharType FormatterConstants<CharType>::CommentPrefix[] = { CharType('-'), CharType('-') };
+        CharType XmlFormatterConstants<CharType>::CommentPrefix[] = { CharType('-'), CharType('-') };
     template<typename CharType>
-        CharType FormatterConstants<CharType>::CommentEnd[] = { CharType('-'), CharType('-'), CharType('>') };
+        CharType XmlFormatterConstants<CharType>::CommentEnd[] = { CharType('-'), CharType('-'), CharType('>') };
 
     template<typename CharType>
-        CharType FormatterConstants<CharType>::CDataPrefix[] = { CharType('['), CharType('C'), CharType('D'), CharType('A'), CharType('T'), CharType('A'), CharType('[') };
+        CharType XmlFormatterConstants<CharType>::CDataPrefix[] = { CharType('['), CharType('C'), CharType('D'), CharType('A'), CharType('T'), CharType('A'), CharType('[') };
     template<typename CharType>
-        CharType FormatterConstants<CharType>::CDataEnd[] = { CharType(']'), CharType(']'), CharType('>') };
+        CharType XmlFormatterConstants<CharType>::CDataEnd[] = { CharType(']'), CharType(']'), CharType('>') };
 
     template<typename CharType>
-        CharType FormatterConstants<CharType>::CloseAngleBracket[] = { CharType('>') };
+        CharType XmlFormatterConstants<CharType>::CloseAngleBracket[] = { CharType('>') };
 
 
     enum TryEatResult { NoMatch, Match, Clipped };
@@ -146,6 +154,7 @@ namespace Utility
             const char exceptionMsg[], const StreamLocation& exceptionLoc)
     {
         for (;;) {
+            mark.AdvanceToChar(endPattern[0]);
             auto er = TryEat(endPattern, mark);
             if (er == Clipped)
                 Throw(FormatException(exceptionMsg, exceptionLoc));
@@ -173,7 +182,7 @@ namespace Utility
     {
         if (_primed != Blob::None) return _primed;
 
-        using Const = FormatterConstants<CharType>;
+        using Const = XmlFormatterConstants<CharType>;
         register TextStreamMarker<CharType> mark = _marker;
 
         if (_pendingHeader) {
@@ -201,6 +210,8 @@ namespace Utility
                 } else break;
             }
 
+                // commit the header now; the character data return below doesn't update _marker
+            _marker = mark;
             _pendingHeader = false;
         }
 
@@ -218,14 +229,11 @@ namespace Utility
                 {
                         // scan forward over any whitespace or "character data"
                         // we need to record line breaks, however
-                    for (;;) {
-                        if (mark.Remaining() < 1) { 
-                                // reached end of tile
-                            if (scopeType == Scope::Type::None) { _marker = mark; return Blob::None; }
-                            Throw(FormatException("Unexpected end of file in element", mark.GetLocation()));
-                        }
-                        if (*mark == '<') break;
-                        mark.AdvanceCheckNewLine();
+                    mark.AdvanceToChar('<');
+                    if (mark.Remaining() < 1) { 
+                            // reached end of tile
+                        if (scopeType == Scope::Type::None) { _marker = mark; return Blob::None; }
+                        Throw(FormatException("Unexpected end of file in element", mark.GetLocation()));
                     }
 
                     ++mark;
@@ -430,27 +438,9 @@ namespace Utility
 
         cdata._start = _marker.Pointer();
 
-        bool gotEnd = false;
-        while (_marker.Remaining() >= 64 && !gotEnd) {
-            for (unsigned c=0; c<64; ++c) {
-                if (*_marker == '<') { gotEnd = true; break; }
-                _marker.AdvanceCheckNewLine();
-            }
-        }
-
-        if (!gotEnd) {
-            for (;;) {
-                if (_marker.Remaining() < 1) { 
-                        // reached end of tile
-                    if (_scopeStack.top()._type != Scope::Type::None) {
-                        Throw(FormatException("Unexpected end of file in element", _marker.GetLocation()));
-                        break;
-                    }
-                }
-                if (*_marker == '<') break;
-                _marker.AdvanceCheckNewLine();
-            }
-        }
+        _marker.AdvanceToChar('<');
+        if (_marker.Remaining() < 1 && _scopeStack.top()._type != Scope::Type::None)
+            Throw(FormatException("Unexpected end of file in element", _marker.GetLocation()));
 
         cdata._end = _marker.Pointer();
 
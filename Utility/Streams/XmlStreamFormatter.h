@@ -24,6 +24,7 @@ namespace Utility
 
         StreamLocation GetLocation() const;
         void AdvanceCheckNewLine();
+        void AdvanceToChar(CharType chr);
 
         TextStreamMarker(const MemoryMappedInputStream& stream);
         ~TextStreamMarker();
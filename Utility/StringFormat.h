@@ -13,6 +13,7 @@
 #include "MemoryUtils.h"
 #include "StringUtils.h"        // just for StringSection
 #include <string>
+#include <ostream>
 #include <stdarg.h>
 
 namespace Utility
@@ -68,8 +69,8 @@ namespace Utility
                 std::fill_n(_buffer, dimof(_buffer), 0);
             }
 
-            const void* begin() const { return pbase(); }
-            const void* end() const { return pptr(); }
+            const void* begin() const { return this->pbase(); }
+            const void* end() const { return this->pptr(); }
         };
     }
 
@@ -139,6 +140,7 @@ namespace Utility
             }
 
             uint8* Begin() { return (uint8*)pbase(); }
+            const uint8* Begin() const { return (const uint8*)pbase(); }
         };
 
         /// <summary>Dynamic string formatting utility<summary>
@@ -158,8 +160,8 @@ namespace Utility
         public:
             mutable std::ostream _stream;
 
-            operator const CharType*() const    { return (const CharType*)_buffer._buffer; }
-            const CharType* get() const         { return (const CharType*)_buffer._buffer; }
+            operator const CharType*() const    { return (const CharType*)_buffer.Begin(); }
+            const CharType* get() const         { return (const CharType*)_buffer.Begin(); }
 
             StringMeldInPlace(CharType* bufferStart, CharType* bufferEnd)
             : _stream(&_buffer)
@@ -9,6 +9,9 @@
 #include "StringUtils.h"
 #include "MemoryUtils.h"
 #include "PtrUtils.h"   // for AsPointer
+#include "SystemUtils.h"
+#include "ArithmeticUtils.h"
+#include "../Core/SelectConfiguration.h"
 #include <string.h>
 #include <wchar.h>
 #include <locale>
@@ -16,6 +19,8 @@
 #include <errno.h>
 #include <math.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <float.h>
 
 #if OS_OSX
     #include <xlocale.h>
@@ -26,6 +31,19 @@
     #include <mbstring.h>
 #endif
 
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #define STRING_SSE2 1
+    #include <emmintrin.h>
+    #include <immintrin.h>
+    #if COMPILER_ACTIVE == COMPILER_TYPE_GCC
+        #define STRING_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #define STRING_TARGET_AVX2
+    #endif
+#else
+    #define STRING_SSE2 0
+#endif
+
 namespace Utility
 {
 
@@ -400,6 +418,87 @@ int      XlComparePrefixI    (const utf8* x, const utf8* y, size_t size)
         return _wcsicmp((const wchar_t*)x, (const wchar_t*)y);
     }
 
+#else
+
+        //  wchar_t is 32 bit here, so the wide string functions can't be used for ucs2
+    void XlCopyString(wchar_t* dst, size_t size, const wchar_t* src)
+    {
+        if (!size) return;
+        wcsncpy(dst, src, size-1);
+        dst[size-1] = 0;
+    }
+
+    void XlCopyNString(wchar_t* dst, size_t count, const wchar_t*src, size_t length)
+    {
+        XlCopyString(dst, std::min(count, length+1), src);
+    }
+
+    void XlCopyString(ucs2* dst, size_t count, const ucs2* src)
+    {
+        if (!count)
+            return;
+
+        if (!src) {
+            *dst = 0;
+            return;
+        }
+
+        while (--count && (*dst++ = *src++))
+            ;
+        *dst = 0;
+    }
+
+    void XlCopyNString(ucs2* dst, size_t count, const ucs2*src, size_t length)
+    {
+        XlCopyString(dst, std::min(count, length+1), src);
+    }
+
+    void XlCatString(ucs2* dst, size_t size, const ucs2* src)
+    {
+        XlCatNString(dst, size, src, size_t(-1));
+    }
+
+    void XlCatNString(ucs2* dst, size_t size, const ucs2* src, size_t length)
+    {
+        for (size_t i = 0; i < size - 1; ++i) {
+            if (dst[i] == 0) {
+                size_t c=0;
+                for (; (i < size - 1); ++i, ++c) {
+                    if (c >= length) { dst[i] = 0; return; }
+                    dst[i] = *src;
+                    if (*src == 0) return;
+                    src++;
+                }
+                break;
+            }
+        }
+        dst[size - 1] = 0;
+    }
+
+    size_t XlStringSize(const ucs2* str)
+    {
+        return XlStringLen(str);
+    }
+
+    size_t XlStringLen(const ucs2* str)
+    {
+        const ucs2* i = str;
+        while (*i) ++i;
+        return size_t(i - str);
+    }
+
+    size_t XlCompareString(const ucs2* x, const ucs2* y)
+    {
+        while (*x && *x == *y) { ++x; ++y; }
+        return size_t(int(*x) - int(*y));
+    }
+
+    size_t XlCompareStringI(const ucs2* x, const ucs2* y)
+    {
+        while (*x && XlToLower(*x) == XlToLower(*y)) { ++x; ++y; }
+        return size_t(int(XlToLower(*x)) - int(XlToLower(*y)));
+    }
+
 #endif
 
 
@@ -718,6 +817,233 @@ char*  XlFindNot(char s[], const char delims[])
     return nullptr;
 }
 
+    //
+    //      Range based searches, used by the stream formatters. These are
+    //      vectorized, because the formatters spend most of their time looking
+    //      for the next structural character (often through long runs of 
+    //      character data, such as the numeric arrays in Collada files).
+    //
+
+template<typename CharType>
+    static const CharType* FindAnyChar_Scalar(const CharType* i, const CharType* end, const CharType chars[], unsigned charCount)
+{
+    for (; i<end; ++i)
+        for (unsigned c=0; c<charCount; ++c)
+            if (*i == chars[c]) return i;
+    return end;
+}
+
+template<typename CharType>
+    static const CharType* FindCharCountLines_Scalar(
+        const CharType* i, const CharType* end, CharType chr,
+        unsigned& lineCount, const CharType*& lineStart)
+{
+    for (; i<end; ++i) {
+        if (*i == chr) return i;
+        if (*i == '\n' || (*i == '\r' && !((i+1) < end && i[1] == '\n'))) {
+                // ("\r\n" is counted once, at the '\n')
+            ++lineCount;
+            lineStart = i+1;
+        }
+    }
+    return end;
+}
+
+#if STRING_SSE2
+
+        //  Load 16 bytes, even if fewer remain, provided that we won't cross into
+        //  the next page (so the load can't fault). Bytes past "end" are ignored by 
+        //  the caller.
+    static bool CanOverRead16(const uint8* i) { return (size_t(i) & 4095) <= (4096 - 16); }
+
+    static const uint8* FindAnyChar_SSE2(const uint8* i, const uint8* end, const uint8 chars[], unsigned charCount)
+    {
+        __m128i patterns[MaxFindChars];
+        for (unsigned c=0; c<charCount; ++c)
+            patterns[c] = _mm_set1_epi8(char(chars[c]));
+
+        for (;;) {
+            auto remaining = end - i;
+            if (remaining < 16 && (remaining <= 0 || !CanOverRead16(i)))
+                break;
+
+            auto data = _mm_loadu_si128((const __m128i*)i);
+            auto match = _mm_cmpeq_epi8(data, patterns[0]);
+            for (unsigned c=1; c<charCount; ++c)
+                match = _mm_or_si128(match, _mm_cmpeq_epi8(data, patterns[c]));
+            auto mask = unsigned(_mm_movemask_epi8(match));
+            if (remaining < 16) {
+                mask &= (1u << unsigned(remaining)) - 1;
+                return mask ? (i + xl_ctz4(mask)) : end;
+            }
+            if (mask) return i + xl_ctz4(mask);
+            i += 16;
+        }
+        return FindAnyChar_Scalar(i, end, chars, charCount);
+    }
+
+    STRING_TARGET_AVX2 static const uint8* FindAnyChar_AVX2(const uint8* i, const uint8* end, const uint8 chars[], unsigned charCount)
+    {
+        __m256i patterns[MaxFindChars];
+        for (unsigned c=0; c<charCount; ++c)
+            patterns[c] = _mm256_set1_epi8(char(chars[c]));
+
+        while ((end - i) >= 32) {
+            auto data = _mm256_loadu_si256((const __m256i*)i);
+            auto match = _mm256_cmpeq_epi8(data, patterns[0]);
+            for (unsigned c=1; c<charCount; ++c)
+                match = _mm256_or_si256(match, _mm256_cmpeq_epi8(data, patterns[c]));
+            auto mask = unsigned(_mm256_movemask_epi8(match));
+            if (mask) { _mm256_zeroupper(); return i + xl_ctz4(mask); }
+            i += 32;
+        }
+        _mm256_zeroupper();
+        return FindAnyChar_SSE2(i, end, chars, charCount);
+    }
+
+        //  Within a block, new lines are the '\n' characters plus any '\r' that
+        //  isn't immediately followed by '\n'. "next" is the same block, shifted by
+        //  one byte.
+    static unsigned NewLineMask(unsigned crMask, unsigned lfMask, unsigned lfNextMask)
+    {
+        return lfMask | (crMask & ~lfNextMask);
+    }
+
+    static void CountLines(const uint8* blockStart, unsigned newLineMask, unsigned& lineCount, const uint8*& lineStart)
+    {
+        if (!newLineMask) return;
+        lineCount += popcount(newLineMask);
+        lineStart = blockStart + (31 - xl_clz4(newLineMask)) + 1;
+    }
+
+    static const uint8* FindCharCountLines_SSE2(
+        const uint8* i, const uint8* end, uint8 chr,
+        unsigned& lineCount, const uint8*& lineStart)
+    {
+        const auto target = _mm_set1_epi8(char(chr));
+        const auto cr = _mm_set1_epi8('\r');
+        const auto lf = _mm_set1_epi8('\n');
+        while ((end - i) >= 17) {
+            auto data = _mm_loadu_si128((const __m128i*)i);
+            auto next = _mm_loadu_si128((const __m128i*)(i+1));
+            auto found = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(data, target)));
+            auto newLines = NewLineMask(
+                unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(data, cr))),
+                unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(data, lf))),
+                unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(next, lf))));
+            if (found) {
+                auto index = xl_ctz4(found);
+                CountLines(i, newLines & ((1u << index) - 1), lineCount, lineStart);
+                return i + index;
+            }
+            CountLines(i, newLines, lineCount, lineStart);
+            i += 16;
+        }
+        return FindCharCountLines_Scalar(i, end, chr, lineCount, lineStart);
+    }
+
+    STRING_TARGET_AVX2 static const uint8* FindCharCountLines_AVX2(
+        const uint8* i, const uint8* end, uint8 chr,
+        unsigned& lineCount, const uint8*& lineStart)
+    {
+        const auto target = _mm256_set1_epi8(char(chr));
+        const auto cr = _mm256_set1_epi8('\r');
+        const auto lf = _mm256_set1_epi8('\n');
+        while ((end - i) >= 33) {
+            auto data = _mm256_loadu_si256((const __m256i*)i);
+            auto next = _mm256_loadu_si256((const __m256i*)(i+1));
+            auto found = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, target)));
+            auto newLines = NewLineMask(
+                unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, cr))),
+                unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, lf))),
+                unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(next, lf))));
+            if (found) {
+                auto index = xl_ctz4(found);
+                CountLines(i, newLines & ((1u << index) - 1), lineCount, lineStart);
+                _mm256_zeroupper();
+                return i + index;
+            }
+            CountLines(i, newLines, lineCount, lineStart);
+            i += 32;
+        }
+        _mm256_zeroupper();
+        return FindCharCountLines_SSE2(i, end, chr, lineCount, lineStart);
+    }
+
+#endif
+
+namespace Internal
+{
+    class StringSearchImplementation
+    {
+    public:
+        const uint8* (*_findAnyChar)(const uint8*, const uint8*, const uint8[], unsigned);
+        const uint8* (*_findCharCountLines)(const uint8*, const uint8*, uint8, unsigned&, const uint8*&);
+    };
+}
+
+static Internal::StringSearchImplementation SelectStringSearchImplementation()
+{
+    Internal::StringSearchImplementation result;
+    result._findAnyChar = &FindAnyChar_Scalar<uint8>;
+    result._findCharCountLines = &FindCharCountLines_Scalar<uint8>;
+    #if STRING_SSE2
+        const auto& features = XlGetCPUFeatures();
+        if (features._sse2) {
+            result._findAnyChar = &FindAnyChar_SSE2;
+            result._findCharCountLines = &FindCharCountLines_SSE2;
+        }
+        if (features._avx2) {
+            result._findAnyChar = &FindAnyChar_AVX2;
+            result._findCharCountLines = &FindCharCountLines_AVX2;
+        }
+    #endif
+    return result;
+}
+
+static const Internal::StringSearchImplementation& GetStringSearchImplementation()
+{
+    static Internal::StringSearchImplementation impl = SelectStringSearchImplementation();
+    return impl;
+}
+
+const utf8* XlFindAnyChar(const utf8* begin, const utf8* end, const utf8 chars[], unsigned charCount)
+{
+    assert(charCount > 0 && charCount <= MaxFindChars);
+    return GetStringSearchImplementation()._findAnyChar(begin, end, chars, charCount);
+}
+
+const char* XlFindAnyChar(const char* begin, const char* end, const char chars[], unsigned charCount)
+{
+    return (const char*)XlFindAnyChar((const utf8*)begin, (const utf8*)end, (const utf8*)chars, charCount);
+}
+
+const ucs2* XlFindAnyChar(const ucs2* begin, const ucs2* end, const ucs2 chars[], unsigned charCount)
+{
+    return FindAnyChar_Scalar(begin, end, chars, charCount);
+}
+
+const ucs4* XlFindAnyChar(const ucs4* begin, const ucs4* end, const ucs4 chars[], unsigned charCount)
+{
+    return FindAnyChar_Scalar(begin, end, chars, charCount);
+}
+
+const utf8* XlFindCharCountLines(const utf8* begin, const utf8* end, utf8 chr, unsigned& lineCount, const utf8*& lineStart)
+{
+    assert(chr != '\r' && chr != '\n');
+    return GetStringSearchImplementation()._findCharCountLines(begin, end, chr, lineCount, lineStart);
+}
+
+const ucs2* XlFindCharCountLines(const ucs2* begin, const ucs2* end, ucs2 chr, unsigned& lineCount, const ucs2*& lineStart)
+{
+    return FindCharCountLines_Scalar(begin, end, chr, lineCount, lineStart);
+}
+
+const ucs4* XlFindCharCountLines(const ucs4* begin, const ucs4* end, ucs4 chr, unsigned& lineCount, const ucs4*& lineStart)
+{
+    return FindCharCountLines_Scalar(begin, end, chr, lineCount, lineStart);
+}
+
 const char* XlFindCharReverse(const char* s, char ch)
 {
     return strrchr(s, ch);
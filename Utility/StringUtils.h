@@ -9,6 +9,7 @@
 #include "Detail/API.h"
 #include "../Core/Types.h"
 #include "UTFUtils.h"
+#include "PtrUtils.h"        // (for AsPointer)
 #include <string>
 #include <assert.h>
 
@@ -48,6 +49,10 @@ namespace Utility
     XL_UTILITY_API void     XlCopyString        (wchar_t* dst, size_t size, const wchar_t* src);
     XL_UTILITY_API void     XlCopyNString       (wchar_t* dst, size_t count, const wchar_t*src, size_t length);
 
+        // (declared again with the other UCS2/UCS4 overrides below; XlStringEnd needs them visible here)
+    XL_UTILITY_API size_t   XlStringSize        (const ucs2* str);
+    XL_UTILITY_API size_t   XlStringSize        (const ucs4* str);
+
     template <typename CharType>
         const CharType* XlStringEnd(const CharType nullTermStr[])
             { return &nullTermStr[XlStringSize(nullTermStr)]; }
@@ -139,6 +144,22 @@ namespace Utility
     XL_UTILITY_API char*        XlFindAnyChar       (char s[], const char delims[]);
     XL_UTILITY_API const char*  XlFindNot           (const char s[], const char ch[]);
     XL_UTILITY_API char*        XlFindNot           (char s[], const char delims[]);
+
+        //  Search [begin, end) for the first of up to MaxFindChars characters. Returns
+        //  "end" if none are found. Vectorized for 8 bit character types.
+    static const unsigned MaxFindChars = 8;
+    XL_UTILITY_API const char*  XlFindAnyChar       (const char* begin, const char* end, const char chars[], unsigned charCount);
+    XL_UTILITY_API const utf8*  XlFindAnyChar       (const utf8* begin, const utf8* end, const utf8 chars[], unsigned charCount);
+    XL_UTILITY_API const ucs2*  XlFindAnyChar       (const ucs2* begin, const ucs2* end, const ucs2 chars[], unsigned charCount);
+    XL_UTILITY_API const ucs4*  XlFindAnyChar       (const ucs4* begin, const ucs4* end, const ucs4 chars[], unsigned charCount);
+
+        //  Search [begin, end) for "chr", counting the new lines passed over on the way
+        //  ("\r\n", "\n" and "\r" are each one new line). "lineStart" is set to the
+        //  character after the last new line found. Returns "end" if "chr" isn't found.
+    XL_UTILITY_API const utf8*  XlFindCharCountLines(const utf8* begin, const utf8* end, utf8 chr, unsigned& lineCount, const utf8*& lineStart);
+    XL_UTILITY_API const ucs2*  XlFindCharCountLines(const ucs2* begin, const ucs2* end, ucs2 chr, unsigned& lineCount, const ucs2*& lineStart);
+    XL_UTILITY_API const ucs4*  XlFindCharCountLines(const ucs4* begin, const ucs4* end, ucs4 chr, unsigned& lineCount, const ucs4*& lineStart);
+
     XL_UTILITY_API const char*  XlFindCharReverse   (const char* s, char ch);
     XL_UTILITY_API const char*  XlFindString        (const char* s, const char* x);
     XL_UTILITY_API char*        XlFindString        (char* s, const char* x);
@@ -32,6 +32,15 @@ namespace Utility
 
     typedef size_t ModuleId;
     ModuleId GetCurrentModuleId();
+
+    class CPUFeatures
+    {
+    public:
+        bool _sse2, _sse41, _avx2, _fma;
+    };
+
+        //  Instruction sets that are supported by both the processor and the OS
+    const CPUFeatures& XlGetCPUFeatures();
 }
 
 
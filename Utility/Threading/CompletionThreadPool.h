@@ -8,8 +8,10 @@
 
 #include "Mutex.h"
 #include "LockFree.h"
+#include "../../Core/Exceptions.h"
 #include <vector>
 #include <thread>
+#include <functional>
 
 namespace Utility
 {
@@ -44,6 +46,36 @@ namespace Utility
         {
             EnqueueInternal(std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...));
         }
+
+        //  Run "fn(taskIndex)" for each task on the pool, and wait for them all to complete.
+        //  Returns false if any task threw an exception. Don't call this from a thread in 
+        //  the same pool (it would stall that thread while waiting).
+    template<typename Fn>
+        bool ParallelFor(CompletionThreadPool& pool, unsigned taskCount, Fn& fn)
+    {
+        if (!taskCount) return true;
+
+        Interlocked::Value completedTaskCount = 0;
+        Interlocked::Value failedTaskCount = 0;
+        auto completedEvent = XlCreateEvent(true);
+
+        for (unsigned t=0; t<taskCount; ++t)
+            pool.Enqueue(
+                [t, taskCount, &completedTaskCount, &failedTaskCount, completedEvent, &fn]()
+                {
+                    TRY { fn(t); }
+                    CATCH(...) { Interlocked::Increment(&failedTaskCount); }
+                    CATCH_END
+
+                    auto newCompletedCount = 1+Interlocked::Increment(&completedTaskCount);
+                    if (unsigned(newCompletedCount) == taskCount)
+                        XlSetEvent(completedEvent);
+                });
+
+        XlWaitForSyncObject(completedEvent, XL_INFINITE);
+        XlCloseSyncObject(completedEvent);
+        return failedTaskCount == 0;
+    }
 }
 
 using namespace Utility;
@@ -0,0 +1,106 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#include "FramePipeline.h"
+#include "CompletionThreadPool.h"
+#include "LockFree.h"
+#include "../TimeUtils.h"
+#include "../../Core/Exceptions.h"
+
+namespace Utility
+{
+    uint64 FramePipeline::Prepare(const PrepareFunction& prepareFunction, unsigned frameIndex, float elapsedTime)
+    {
+        auto startTime = GetPerformanceCounter();
+        _prepareStartTime[frameIndex&1] = startTime;
+        prepareFunction(frameIndex&1, frameIndex, elapsedTime);
+        return GetPerformanceCounter() - startTime;
+    }
+
+    unsigned FramePipeline::BeginFrame(const PrepareFunction& prepareFunction, float elapsedTime)
+    {
+        auto waitStart = GetPerformanceCounter();
+        Sync();
+        _lastWaitTime = GetPerformanceCounter() - waitStart;
+
+            //  If this frame wasn't prepared in the background (because this is the first
+            //  frame, or we're not pipelined) we must prepare it now, on this thread
+        if (_preparedCount == _frameIndex) {
+            _lastPrepareTime = Prepare(prepareFunction, _frameIndex, elapsedTime);
+            ++_preparedCount;
+        }
+
+        if (_pipelined) {
+                //  Begin preparing the next frame into the other buffer. The submission
+                //  of the previous frame (which read from that buffer) must be finished
+                //  by now, because the caller is beginning a new frame.
+            XlResetEvent(_completedEvent);
+            _pending = true;
+            _pendingException = nullptr;
+            auto nextFrame = _frameIndex+1;
+            _workerPool->Enqueue(
+                [this, prepareFunction, nextFrame, elapsedTime]()
+                {
+                        //  _pendingPrepareTime is only read by the calling thread after 
+                        //  waiting on _completedEvent (see Sync())
+                    TRY {
+                        this->_pendingPrepareTime = this->Prepare(prepareFunction, nextFrame, elapsedTime);
+                    } CATCH(...) {
+                        this->_pendingException = std::current_exception();
+                    } CATCH_END
+                    XlSetEvent(this->_completedEvent);
+                });
+            ++_preparedCount;
+        }
+
+        return (_frameIndex++)&1;
+    }
+
+    void FramePipeline::Sync()
+    {
+        if (!_pending) return;
+
+        XlWaitForSyncObject(_completedEvent, XL_INFINITE);
+        _pending = false;
+        _lastPrepareTime = _pendingPrepareTime;
+
+        if (_pendingException) {
+                //  The frame will be prepared again on the calling thread in
+                //  the next BeginFrame()
+            _preparedCount = _frameIndex;
+            auto e = std::move(_pendingException);
+            _pendingException = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    void FramePipeline::SetPipelined(bool pipelined)
+    {
+            //  If the next frame has already been prepared, we can still use it after
+            //  switching off pipelining. We just need to wait for it to complete.
+        Sync();
+        _pipelined = pipelined;
+    }
+
+    FramePipeline::FramePipeline(CompletionThreadPool& workerPool, bool pipelined)
+    : _workerPool(&workerPool)
+    , _pending(false), _pipelined(pipelined)
+    , _frameIndex(0), _preparedCount(0)
+    , _lastWaitTime(0), _lastPrepareTime(0), _pendingPrepareTime(0)
+    {
+        _completedEvent = XlCreateEvent(true);
+        _prepareStartTime[0] = _prepareStartTime[1] = 0;
+    }
+
+    FramePipeline::~FramePipeline()
+    {
+            //  We must wait for any preparation in flight, because it references this object
+        if (_pending)
+            XlWaitForSyncObject(_completedEvent, XL_INFINITE);
+        XlCloseSyncObject(_completedEvent);
+    }
+}
+
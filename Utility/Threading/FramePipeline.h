@@ -0,0 +1,92 @@
+// Copyright 2015 XLGAMES Inc.
+//
+// Distributed under the MIT License (See
+// accompanying file "LICENSE" or the website
+// http://www.opensource.org/licenses/mit-license.php)
+
+#pragma once
+
+#include "../../Core/Prefix.h"
+#include "../../Core/Types.h"
+#include <functional>
+#include <exception>
+
+namespace Utility
+{
+    class CompletionThreadPool;
+
+    /// <summary>Overlaps the preparation of a frame with the submission of the previous frame</summary>
+    /// Splits a frame into 2 stages:
+    ///     <list>
+    ///         <item>"prepare" -- simulation, culling, building draw lists, etc. Runs on a worker thread</item>
+    ///         <item>"submit" -- everything that happens on the calling thread after BeginFrame()</item>
+    ///     </list>
+    ///
+    /// Prepared state is double buffered. The client owns the 2 buffers, and the pipeline
+    /// tells it which one to use: the prepare function is given the buffer index to write
+    /// to, and BeginFrame() returns the buffer index to read from during submission.
+    ///
+    /// When pipelined, BeginFrame() for frame N waits for the preparation of frame N to
+    /// complete and then immediately starts preparing frame N+1 into the other buffer. So
+    /// the preparation of N+1 runs while frame N is submitted. Preparation of frames always
+    /// happens in order, and never more than one frame ahead.
+    ///
+    /// The output is identical to the non-pipelined mode, so long as:
+    ///     <list>
+    ///         <item>the submit stage only reads from the buffer returned from BeginFrame()</item>
+    ///         <item>the prepare stage only writes to the buffer it is given (plus any state
+    ///             that is only used by the prepare stage)</item>
+    ///         <item>the prepare stage depends only on the frame index and elapsed time given</item>
+    ///     </list>
+    /// Any other state shared between the stages must be modified only after Sync().
+    ///
+    /// In pipelined mode, the elapsed time for frame N+1 isn't known when its preparation
+    /// begins. So the elapsed time passed to BeginFrame() for frame N is also used to prepare
+    /// frame N+1 (ie, simulation lags one frame behind the measured frame time).
+    class FramePipeline
+    {
+    public:
+        typedef std::function<void(unsigned bufferIndex, unsigned frameIndex, float elapsedTime)> PrepareFunction;
+
+        unsigned    BeginFrame(const PrepareFunction& prepareFunction, float elapsedTime);
+        void        Sync();
+
+        void        SetPipelined(bool pipelined);
+        bool        IsPipelined() const { return _pipelined; }
+        unsigned    GetFrameIndex() const { return _frameIndex; }
+
+            //  Time the calling thread spent in the last BeginFrame() waiting for the
+            //  worker, and the time the last completed preparation took (in performance
+            //  counter units). Only call these from the thread that calls BeginFrame()
+        uint64      GetLastWaitTime() const { return _lastWaitTime; }
+        uint64      GetLastPrepareTime() const { return _lastPrepareTime; }
+
+            //  Performance counter time at which preparation of the frame in the given
+            //  buffer began (used to measure latency from preparation to present)
+        uint64      GetPrepareStartTime(unsigned bufferIndex) const { return _prepareStartTime[bufferIndex&1]; }
+
+        FramePipeline(CompletionThreadPool& workerPool, bool pipelined = true);
+        ~FramePipeline();
+
+        FramePipeline(const FramePipeline&) = delete;
+        FramePipeline& operator=(const FramePipeline&) = delete;
+
+    protected:
+        CompletionThreadPool*   _workerPool;
+        XlHandle                _completedEvent;
+        bool                    _pending;
+        bool                    _pipelined;
+        unsigned                _frameIndex;
+        unsigned                _preparedCount;     // frames whose preparation has completed or is in flight
+        uint64                  _lastWaitTime;
+        uint64                  _lastPrepareTime;
+        uint64                  _pendingPrepareTime;    // written by the worker, read in Sync()
+        uint64                  _prepareStartTime[2];
+        std::exception_ptr      _pendingException;
+
+        uint64  Prepare(const PrepareFunction& prepareFunction, unsigned frameIndex, float elapsedTime);
+    };
+}
+
+using namespace Utility;
+
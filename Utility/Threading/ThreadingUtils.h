@@ -63,7 +63,7 @@
 /// as well. See the MSVC documentation for _ReadWriteBarrier. The documentation is a little unclear
 /// about whether there is a runtime memory barrier (and on what platforms it takes effect).
 
-#if (THREAD_LIBRARY == THREAD_LIBRARY_TINYTHREAD) || (THREAD_LIBRARY == THREAD_LIBRARY_STDCPP)
+#if ((THREAD_LIBRARY == THREAD_LIBRARY_TINYTHREAD) || (THREAD_LIBRARY == THREAD_LIBRARY_STDCPP)) && (COMPILER_ACTIVE == COMPILER_TYPE_MSVC)
 
     #include <intrin.h>
 
@@ -128,6 +128,34 @@
 
 #endif
 
+#if ((THREAD_LIBRARY == THREAD_LIBRARY_TINYTHREAD) || (THREAD_LIBRARY == THREAD_LIBRARY_STDCPP)) && (COMPILER_ACTIVE == COMPILER_TYPE_GCC)
+
+        //  GCC __atomic builtins with sequentially consistent ordering (which matches
+        //  the full barrier of the MSVC _Interlocked intrinsics above)
+    namespace Utility { namespace Interlocked 
+    {
+        typedef long Value;
+        typedef int64 Value64;
+
+        force_inline Value Exchange(Value volatile* target, Value newValue)           { return __atomic_exchange_n(target, newValue, __ATOMIC_SEQ_CST); }
+        force_inline Value64 Exchange64(Value64 volatile* target, Value64 newValue)   { return __atomic_exchange_n(target, newValue, __ATOMIC_SEQ_CST); }
+        force_inline void* ExchangePointer(void* volatile* target, void* newValue)    { return __atomic_exchange_n(target, newValue, __ATOMIC_SEQ_CST); }
+
+        inline Value CompareExchange(Value volatile* target, Value newValue, Value comparisonValue)                     { return __sync_val_compare_and_swap(target, comparisonValue, newValue); }
+        force_inline Value64 CompareExchange64(Value64 volatile* target, Value64 newValue, Value64 comparisonValue)     { return __sync_val_compare_and_swap(target, comparisonValue, newValue); }
+        force_inline void* CompareExchangePointer(void* volatile* target, void* newValue, void* comparisonValue)        { return __sync_val_compare_and_swap(target, comparisonValue, newValue); }
+
+        force_inline Value Increment(Value volatile* target)              { return __atomic_fetch_add(target, 1, __ATOMIC_SEQ_CST); }
+        force_inline Value Decrement(Value volatile* target)              { return __atomic_fetch_sub(target, 1, __ATOMIC_SEQ_CST); }
+        force_inline Value Add(Value volatile* target, Value addition)    { return __atomic_fetch_add(target, addition, __ATOMIC_SEQ_CST); }
+
+        force_inline Value Load(Value volatile* target)                   { return *target; }
+        force_inline Value64 Load64(Value64 volatile const* target)       { return *target; }
+        force_inline void* LoadPointer(void* volatile const* target)      { return *target; }
+    }}
+
+#endif
+
 #if THREAD_LIBRARY == THREAD_LIBRARY_TBB
 
     #if PLATFORMOS_TARGET == PLATFORMOS_WINDOWS
@@ -250,6 +278,20 @@ using namespace Utility;
         inline unsigned CurrentThreadId()       { return ::GetCurrentThreadId(); }
     }}
 
+#elif PLATFORMOS_ACTIVE == PLATFORMOS_LINUX
+
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+    #include <xmmintrin.h>
+
+    namespace Utility { namespace Threading {
+        inline void YieldTimeSlice()            { sched_yield(); }
+        inline void Pause()                     { _mm_pause(); }
+        inline void Sleep(uint32 milliseconds)  { usleep(milliseconds * 1000); }
+        inline unsigned CurrentThreadId()       { return (unsigned)syscall(SYS_gettid); }
+    }}
+
 #else
 
             //// Other / unsupported ////
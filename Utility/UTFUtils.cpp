@@ -820,7 +820,13 @@ size_t utf8_vprintf(const char* fmt, va_list ap)
     sz = 2048; // remark_todo("fixme!")
     buf = (utf8*)alloca(sz);
  try_print:
-    cnt = (size_t)xl_vsnprintf((char*)buf, (int)sz, fmt, ap);
+    {
+            // (xl_vsnprintf takes the va_list by reference, and we may need to retry)
+        va_list apCopy;
+        va_copy(apCopy, ap);
+        cnt = (size_t)xl_vsnprintf((char*)buf, (int)sz, fmt, apCopy);
+        va_end(apCopy);
+    }
     if (cnt >= sz) {
         buf = (utf8*)alloca(cnt - sz + 1);
         sz = cnt + 1;
@@ -125,7 +125,12 @@ struct VSInput //////////////////////////////////////////////////////
     float4 VSIn_GetColour(VSInput input) { return 1.0.xxxx; }
 #endif //////////////////////////////////////////////////////////////
 
-#if GEO_HAS_TEXCOORD==1 /////////////////////////////////////////////
+#if (GEO_HAS_TEXCOORD==1) && (GEO_V_TEXCOORD_SCALEOFFSET==1) //////////
+        // quantized texture coordinates are relative to the range of values
+        // in the mesh (see vertex quantization in the model compiler)
+    #include "Transform.h"
+    float2 VSIn_GetTexCoord(VSInput input) { return input.texCoord * GeoTexCoordScaleOffset.xy + GeoTexCoordScaleOffset.zw; }
+#elif GEO_HAS_TEXCOORD==1 ///////////////////////////////////////////
     float2 VSIn_GetTexCoord(VSInput input) { return input.texCoord; }
 #else
     float2 VSIn_GetTexCoord(VSInput input) { return 0.0.xx; }
@@ -30,7 +30,10 @@ float3 VSIn_GetLocalPosition(VSInput input)
 
 float4 VSIn_GetLocalTangent(VSInput input)
 {
-    #if (GEO_HAS_TANGENT_FRAME==1)
+    #if (GEO_HAS_TANGENT_FRAME==1) && (GEO_V_TANGENT_OCTAHEDRAL==1)
+        float4 tangent = DecodeOctahedralTangent(input.tangent.xy);
+        return float4(TransformDirectionVectorThroughSkinning(input, tangent.xyz), tangent.w);
+    #elif (GEO_HAS_TANGENT_FRAME==1)
         return float4(TransformDirectionVectorThroughSkinning(input, input.tangent.xyz), input.tangent.w);
     #else
         return 0.0.xxxx;
@@ -42,6 +45,8 @@ float4 VSIn_GetLocalTangent(VSInput input)
 	{
 		#if GEO_V_NORMAL_UNSIGNED==1
             return TransformDirectionVectorThroughSkinning(input, input.normal * 2.0.xxx - 1.0.xxx);
+        #elif GEO_V_NORMAL_OCTAHEDRAL==1
+            return TransformDirectionVectorThroughSkinning(input, DecodeOctahedralNormal(input.normal.xy));
         #else
             return TransformDirectionVectorThroughSkinning(input, input.normal);
         #endif
@@ -50,7 +55,9 @@ float4 VSIn_GetLocalTangent(VSInput input)
 
 float3 VSIn_GetLocalBitangent(VSInput input)
 {
-	#if (GEO_HAS_BITANGENT==1)
+	#if (GEO_HAS_BITANGENT==1) && (GEO_V_BITANGENT_OCTAHEDRAL==1)
+		return TransformDirectionVectorThroughSkinning(input, DecodeOctahedralNormal(input.bitangent.xy));
+	#elif (GEO_HAS_BITANGENT==1)
 		return TransformDirectionVectorThroughSkinning(input, input.bitangent.xyz);
     #elif (GEO_HAS_TANGENT_FRAME==1) && (GEO_HAS_NORMAL==1)
 		float4 tangent = VSIn_GetLocalTangent(input);
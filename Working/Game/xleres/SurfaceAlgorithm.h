@@ -44,6 +44,25 @@ float3 NormalFromTangents(float3 tangent, float3 bitangent, float handiness)
 	return cross(bitangent, tangent) * handiness;
 }
 
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+		// Unfold the octahedral encoding generated by vertex quantization
+		// in the model compiler (must match "DecodeOctahedral" in MeshDatabase.cpp)
+	float3 result = float3(encoded.xy, 1.f - abs(encoded.x) - abs(encoded.y));
+	if (result.z < 0.f) {
+		float2 signNotZero = float2(encoded.x >= 0.f ? 1.f : -1.f, encoded.y >= 0.f ? 1.f : -1.f);
+		result.xy = (1.0.xx - abs(encoded.yx)) * signNotZero;
+	}
+	return normalize(result);
+}
+
+float4 DecodeOctahedralTangent(float2 encoded)
+{
+		// Tangents have the handiness packed into the sign of the y component
+	float handiness = (encoded.y < 0.f) ? -1.f : 1.f;
+	return float4(DecodeOctahedralNormal(float2(encoded.x, abs(encoded.y) * 2.f - 1.f)), handiness);
+}
+
 float3 SampleNormalMap(Texture2D normalMap, SamplerState samplerObject, bool dxtFormatNormalMap, float2 texCoord)
 {
 	if (dxtFormatNormalMap) {